@@ -16,12 +16,12 @@ toolchain = generator.toolchain
 extrasources = []
 
 foundation_sources = [
-  'android.c', 'array.c', 'assert.c', 'assetstream.c', 'atomic.c', 'base64.c', 'beacon.c', 'bitbuffer.c', 'blowfish.c',
-  'bufferstream.c', 'environment.c', 'error.c', 'event.c', 'exception.c', 'foundation.c', 'fs.c',
-  'hash.c', 'hashmap.c', 'hashtable.c', 'json.c', 'library.c', 'log.c', 'main.c', 'md5.c', 'memory.c', 'mutex.c',
+  'android.c', 'array.c', 'assert.c', 'assetstream.c', 'atomic.c', 'base64.c', 'beacon.c', 'bitbuffer.c', 'bitset.c', 'blowfish.c',
+  'btree.c', 'bufferstream.c', 'cache.c', 'environment.c', 'epoch.c', 'error.c', 'event.c', 'exception.c', 'filter.c', 'foundation.c', 'fs.c',
+  'hamt.c', 'hash.c', 'hashindex.c', 'hashmap.c', 'hashtable.c', 'heap.c', 'json.c', 'library.c', 'log.c', 'main.c', 'math.c', 'md5.c', 'memory.c', 'msgpack.c', 'mutex.c',
   'objectmap.c', 'path.c', 'pipe.c', 'pnacl.c', 'process.c', 'profile.c', 'radixsort.c', 'random.c', 'regex.c',
-  'ringbuffer.c', 'sha.c', 'semaphore.c', 'stacktrace.c', 'stream.c', 'string.c', 'system.c', 'thread.c', 'time.c',
-  'tizen.c', 'uuid.c', 'version.c', 'delegate.m', 'environment.m', 'fs.m', 'system.m' ]
+  'ringbuffer.c', 'sha.c', 'semaphore.c', 'sketch.c', 'skiplist.c', 'stacktrace.c', 'stream.c', 'string.c', 'stringmap.c', 'system.c', 'thread.c', 'time.c',
+  'tizen.c', 'uuid.c', 'vector.c', 'version.c', 'delegate.m', 'environment.m', 'fs.m', 'system.m', 'wal.c' ]
 
 foundation_lib = generator.lib(module = 'foundation', sources = foundation_sources + extrasources)
 #foundation_so = generator.sharedlib( module = 'foundation', sources = foundation_sources + extrasources )
@@ -37,10 +37,10 @@ includepaths = ['test']
 test_lib = generator.lib(module = 'test', basepath = 'test', sources = ['test.c', 'test.m'], includepaths = includepaths)
 
 test_cases = [
-  'app', 'array', 'atomic', 'base64', 'beacon', 'bitbuffer', 'blowfish', 'bufferstream', 'environment', 'error',
-  'event', 'exception', 'fs', 'hash', 'hashmap', 'hashtable', 'json', 'library', 'math', 'md5', 'mutex', 'objectmap',
-  'path', 'pipe', 'process', 'profile', 'radixsort', 'random', 'regex', 'ringbuffer', 'semaphore', 'sha', 'stacktrace',
-  'stream', 'string', 'system', 'time', 'uuid'
+  'app', 'array', 'atomic', 'base64', 'beacon', 'bitbuffer', 'bitset', 'blowfish', 'btree', 'bufferstream', 'cache', 'environment', 'error',
+  'event', 'exception', 'filter', 'fs', 'hamt', 'hash', 'hashindex', 'hashmap', 'hashtable', 'heap', 'json', 'library', 'math', 'md5', 'msgpack', 'mutex', 'objectmap',
+  'path', 'pipe', 'process', 'profile', 'radixsort', 'random', 'regex', 'ringbuffer', 'semaphore', 'sha', 'sketch', 'skiplist', 'stacktrace',
+  'stream', 'string', 'stringmap', 'system', 'time', 'uuid', 'vector', 'wal'
 ]
 if toolchain.is_monolithic() or target.is_ios() or target.is_android() or target.is_tizen() or target.is_pnacl():
   #Build one fat binary with all test cases
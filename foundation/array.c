@@ -64,3 +64,149 @@ _array_growfn(void** arr, size_t increment, size_t factor, size_t itemsize) {
 	}
 	return nullptr;
 }
+
+//'FARRFILE' in ascii
+#define ARRAY_FILE_MAGIC   0x454c494652524146ULL
+#define ARRAY_FILE_VERSION 1U
+#define ARRAY_FILE_MAX_ALIGN 4096U
+
+typedef struct array_file_header_t array_file_header_t;
+
+struct array_file_header_t {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t element_size;
+	uint64_t count;
+	//Offset of elements, preceded by an array header making mapped elements a valid array
+	uint64_t offset;
+	uint64_t schema;
+	uint64_t checksum;
+	uint32_t alignment;
+	uint32_t reserved;
+	uint64_t header_checksum;
+};
+
+static const array_file_header_t*
+_array_file_header(const fs_map_t* map) {
+	const array_file_header_t* header = map->data;
+	const uint32_t* raw;
+	if (map->size < sizeof(array_file_header_t))
+		return nullptr;
+	if ((header->magic != ARRAY_FILE_MAGIC) || (header->version != ARRAY_FILE_VERSION) ||
+	    (header->header_checksum != hash(header, offsetof(array_file_header_t, header_checksum))))
+		return nullptr;
+	if (!header->element_size || (header->count > 0xFFFFFFFFULL) ||
+	    (header->alignment < ARRAY_DEFAULT_ALIGN) || (header->alignment > ARRAY_FILE_MAX_ALIGN) ||
+	    (header->alignment & (header->alignment - 1)) || (header->offset % header->alignment) ||
+	    (header->offset < sizeof(array_file_header_t) + (4U * _array_header_size)) || (header->offset > map->size) ||
+	    (header->count > (map->size - header->offset) / header->element_size))
+		return nullptr;
+	raw = pointer_offset_const(map->data, header->offset - (4U * _array_header_size));
+	if ((raw[0] != header->count) || (raw[1] != header->count) || (raw[2] != ARRAY_WATERMARK) ||
+	    (raw[3] != header->element_size))
+		return nullptr;
+	return header;
+}
+
+bool
+_array_savefn(const void* arr, size_t count, size_t itemsize, const char* path, size_t length,
+              hash_t schema, size_t alignment) {
+	array_file_header_t header;
+	uint32_t raw[_array_header_size];
+	char padding[ARRAY_FILE_MAX_ALIGN];
+	size_t bytes = count * itemsize;
+	size_t offset;
+	stream_t* stream;
+	bool success;
+
+	if (!alignment)
+		alignment = ARRAY_DEFAULT_ALIGN;
+	if ((alignment < ARRAY_DEFAULT_ALIGN) || (alignment > ARRAY_FILE_MAX_ALIGN) || (alignment & (alignment - 1)) ||
+	    (count > 0xFFFFFFFFULL) || (itemsize > 0xFFFFFFFFULL)) {
+		log_errorf(0, ERROR_INVALID_VALUE, STRING_CONST("Invalid typed array file parameters: %.*s"),
+		           (int)length, path);
+		return false;
+	}
+
+	stream = fs_open_file(path, length, STREAM_OUT | STREAM_CREATE | STREAM_TRUNCATE | STREAM_BINARY);
+	if (!stream)
+		return false;
+
+	offset = sizeof(array_file_header_t) + (4U * _array_header_size);
+	offset = (offset + (alignment - 1)) & ~(alignment - 1);
+
+	memset(&header, 0, sizeof(header));
+	header.magic = ARRAY_FILE_MAGIC;
+	header.version = ARRAY_FILE_VERSION;
+	header.element_size = (uint32_t)itemsize;
+	header.count = count;
+	header.offset = offset;
+	header.schema = schema;
+	header.checksum = hash(arr, bytes);
+	header.alignment = (uint32_t)alignment;
+	header.header_checksum = hash(&header, offsetof(array_file_header_t, header_checksum));
+
+	raw[0] = (uint32_t)count;
+	raw[1] = (uint32_t)count;
+	raw[2] = ARRAY_WATERMARK;
+	raw[3] = (uint32_t)itemsize;
+
+	memset(padding, 0, sizeof(padding));
+	success = (stream_write(stream, &header, sizeof(header)) == sizeof(header));
+	offset -= sizeof(header) + sizeof(raw);
+	success = success && (stream_write(stream, padding, offset) == offset);
+	success = success && (stream_write(stream, raw, sizeof(raw)) == sizeof(raw));
+	success = success && (!bytes || (stream_write(stream, arr, bytes) == bytes));
+	stream_deallocate(stream);
+
+	if (!success)
+		log_errorf(0, ERROR_SYSTEM_CALL_FAIL, STRING_CONST("Unable to write typed array file: %.*s"),
+		           (int)length, path);
+	return success;
+}
+
+bool
+_array_mapfn(void** arr, size_t itemsize, fs_map_t* map, const char* path, size_t length,
+             hash_t schema, unsigned int flags) {
+	const array_file_header_t* header;
+	unsigned int advice = 0;
+
+	*arr = nullptr;
+	if (!fs_map_file(map, path, length, STREAM_IN | ((flags & ARRAY_MAP_PRIVATE) ? FS_MAP_PRIVATE : 0)))
+		return false;
+
+	header = _array_file_header(map);
+	if (!header || (header->element_size != itemsize) || (header->schema != schema)) {
+		log_errorf(0, ERROR_INVALID_VALUE, STRING_CONST("Invalid typed array file: %.*s"), (int)length, path);
+		fs_unmap_file(map);
+		return false;
+	}
+
+	if (flags & ARRAY_MAP_SEQUENTIAL)
+		advice |= FS_MAP_SEQUENTIAL;
+	if (flags & ARRAY_MAP_RANDOM)
+		advice |= FS_MAP_RANDOM;
+	if (flags & ARRAY_MAP_WILLNEED)
+		advice |= FS_MAP_WILLNEED;
+	if (advice)
+		fs_map_advise(map, (size_t)header->offset, (size_t)(header->count * header->element_size), advice);
+
+	if ((flags & ARRAY_MAP_VERIFY) && !array_map_verify(map)) {
+		log_errorf(0, ERROR_INVALID_VALUE, STRING_CONST("Typed array file checksum mismatch: %.*s"), (int)length,
+		           path);
+		fs_unmap_file(map);
+		return false;
+	}
+
+	*arr = pointer_offset(map->data, header->offset);
+	return true;
+}
+
+bool
+array_map_verify(const fs_map_t* map) {
+	const array_file_header_t* header = _array_file_header(map);
+	if (!header)
+		return false;
+	return hash(pointer_offset_const(map->data, header->offset), (size_t)(header->count * header->element_size)) ==
+	       header->checksum;
+}
@@ -278,6 +278,44 @@ in array. Position and number of elements ARE ranged checked
     array_erase_ordered_range(array, _clamped_start, _clamped_end - _clamped_start); \
 } while(0)
 
+/*! Save array elements to a typed array file, which can later be mapped into memory as a
+read only or copy-on-write array with #array_map. The file stores element size, count,
+alignment, a checksum of the elements and a caller provided schema hash identifying the
+element layout, and is in host byte order.
+\param array     Array pointer
+\param path      File path
+\param length    Length of path
+\param schema    Schema hash identifying element layout
+\param alignment Alignment of elements in file and mapped memory, a power of two from 16
+                 up to 4096. Zero for default alignment of 16 bytes
+\return          true if successful, false if file could not be written */
+#define array_save(array, path, length, schema, alignment) \
+  _array_savefn((array), array_size(array), _array_elementsize(array), path, length, schema, alignment)
+
+/*! Map a typed array file previously saved with #array_save into memory. Mapping does not
+read the elements, which are paged in on access. The array pointer is set to the mapped
+elements and can be used with all array functions not changing the array size, except
+array_deallocate. The file is read only unless ARRAY_MAP_PRIVATE is given, in which case
+elements can be modified without modifying the file. The array must be unmapped with
+#array_unmap
+\param array  Array pointer
+\param map    Map receiving the mapped file
+\param path   File path
+\param length Length of path
+\param schema Schema hash identifying element layout, must match schema of saved array
+\param flags  Combination of ARRAY_MAP_PRIVATE, ARRAY_MAP_VERIFY and the access hints
+              ARRAY_MAP_SEQUENTIAL, ARRAY_MAP_RANDOM and ARRAY_MAP_WILLNEED
+\return       true if file was mapped, false if file could not be opened, is not a typed
+              array file, or element size or schema does not match */
+#define array_map(array, map, path, length, schema, flags) \
+  _array_mapfn((void**)&(array), _array_elementsize(array), map, path, length, schema, flags)
+
+/*! Unmap an array previously mapped with #array_map and reset array pointer to zero
+\param array Array pointer
+\param map   Map of mapped file */
+#define array_unmap(array, map) ( \
+  fs_unmap_file(map), ((array) = 0))
+
 // **** Internal implementation details below, not for direct use ****
 
 /*! \internal Header size set to 16 bytes in order to align main array memory */
@@ -330,3 +368,36 @@ _array_resizefn(void** arr, size_t elements, size_t itemsize);
 \return         Array if valid, null if invalid */
 FOUNDATION_API const void*
 _array_verifyfn(const void* const* arr);
+
+/*! \internal Save array elements to typed array file
+\param arr       Array
+\param count     Number of elements
+\param itemsize  Size of a single item
+\param path      File path
+\param length    Length of path
+\param schema    Schema hash
+\param alignment Alignment of elements
+\return          true if successful, false if not */
+FOUNDATION_API bool
+_array_savefn(const void* arr, size_t count, size_t itemsize, const char* path, size_t length,
+              hash_t schema, size_t alignment);
+
+/*! \internal Map typed array file
+\param arr      Pointer to array
+\param itemsize Size of a single item
+\param map      Map receiving mapped file
+\param path     File path
+\param length   Length of path
+\param schema   Schema hash
+\param flags    Map flags
+\return         true if successful, false if not */
+FOUNDATION_API bool
+_array_mapfn(void** arr, size_t itemsize, fs_map_t* map, const char* path, size_t length,
+             hash_t schema, unsigned int flags);
+
+/*! Verify the checksum of the elements in a typed array file mapped with #array_map,
+reading the entire file
+\param map Map of mapped file
+\return    true if checksum matches, false if not */
+FOUNDATION_API bool
+array_map_verify(const fs_map_t* map);
@@ -100,6 +100,18 @@ byte order (no-op for little endian systems)
 static FOUNDATION_FORCEINLINE FOUNDATION_PURECALL void
 byteorder_littleendian(void* buffer, const size_t size);
 
+/*! Count trailing zero bits, 64 bit. Used for scanning bitmaps for set bits.
+\param arg Value
+\return    Number of trailing zero bits, 64 if value is zero */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL unsigned int
+bits_ctz64(uint64_t arg);
+
+/*! Count set bits, 64 bit.
+\param arg Value
+\return    Number of set bits */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL unsigned int
+bits_popcount64(uint64_t arg);
+
 // Implementations
 
 static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL uint16_t
@@ -264,3 +276,41 @@ byteorder_littleendian(void* buffer, const size_t size) {
 	FOUNDATION_UNUSED(size);
 #endif
 }
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL unsigned int
+bits_ctz64(uint64_t arg) {
+	if (!arg)
+		return 64;
+#if FOUNDATION_COMPILER_GCC || FOUNDATION_COMPILER_CLANG
+	return (unsigned int)__builtin_ctzll(arg);
+#elif FOUNDATION_COMPILER_MSVC && FOUNDATION_ARCH_X86_64
+	{
+		unsigned long index;
+		_BitScanForward64(&index, arg);
+		return (unsigned int)index;
+	}
+#else
+	{
+		unsigned int count = 0;
+		while (!(arg & 1)) {
+			arg >>= 1;
+			++count;
+		}
+		return count;
+	}
+#endif
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL unsigned int
+bits_popcount64(uint64_t arg) {
+#if FOUNDATION_COMPILER_GCC || FOUNDATION_COMPILER_CLANG
+	return (unsigned int)__builtin_popcountll(arg);
+#elif FOUNDATION_COMPILER_MSVC && FOUNDATION_ARCH_X86_64 && defined(__AVX__)
+	return (unsigned int)__popcnt64(arg);
+#else
+	arg = arg - ((arg >> 1) & 0x5555555555555555ULL);
+	arg = (arg & 0x3333333333333333ULL) + ((arg >> 2) & 0x3333333333333333ULL);
+	arg = (arg + (arg >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (unsigned int)((arg * 0x0101010101010101ULL) >> 56);
+#endif
+}
@@ -0,0 +1,344 @@
+/* bitset.c  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+
+//Words per rank block, one cache line
+#define BITSET_BLOCK_WORDS 8
+#define BITSET_BLOCK_BITS  (BITSET_BLOCK_WORDS * 64)
+//Set bits per select index sample
+#define BITSET_SELECT_SAMPLE 512
+
+#define BITSET_POPCOUNT_UNKNOWN 0
+#define BITSET_POPCOUNT_GENERIC 1
+#define BITSET_POPCOUNT_POPCNT  2
+#define BITSET_POPCOUNT_AVX2    3
+
+//Hardware popcount and AVX2 are selected at runtime, the build does not assume support
+#if (FOUNDATION_COMPILER_GCC || FOUNDATION_COMPILER_CLANG) && FOUNDATION_ARCH_X86_64 && !FOUNDATION_PLATFORM_WINDOWS
+#  define BITSET_POPCOUNT_DISPATCH 1
+#  include <immintrin.h>
+#else
+#  define BITSET_POPCOUNT_DISPATCH 0
+#endif
+
+static atomic32_t _bitset_popcount_impl;
+
+static size_t
+_bitset_storage_words(size_t num_bits) {
+	size_t num_blocks = (num_bits + (BITSET_BLOCK_BITS - 1)) / BITSET_BLOCK_BITS;
+	return num_blocks * BITSET_BLOCK_WORDS;
+}
+
+static size_t
+_bitset_popcount_generic(const uint64_t* word, size_t count) {
+	size_t iword = 0;
+	size_t total = 0;
+#if FOUNDATION_ARCH_NEON
+	uint64x2_t sum = vdupq_n_u64(0);
+	for (; iword + 2 <= count; iword += 2) {
+		uint8x16_t bytes = vcntq_u8(vreinterpretq_u8_u64(vld1q_u64(word + iword)));
+		sum = vaddq_u64(sum, vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(bytes))));
+	}
+	total = (size_t)(vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1));
+#endif
+	for (; iword < count; ++iword)
+		total += bits_popcount64(word[iword]);
+	return total;
+}
+
+#if BITSET_POPCOUNT_DISPATCH
+
+__attribute__((target("popcnt"))) static size_t
+_bitset_popcount_popcnt(const uint64_t* word, size_t count) {
+	size_t iword = 0;
+	uint64_t total[4] = {0, 0, 0, 0};
+	//Independent accumulators to hide the popcnt latency
+	for (; iword + 4 <= count; iword += 4) {
+		total[0] += (uint64_t)__builtin_popcountll(word[iword]);
+		total[1] += (uint64_t)__builtin_popcountll(word[iword + 1]);
+		total[2] += (uint64_t)__builtin_popcountll(word[iword + 2]);
+		total[3] += (uint64_t)__builtin_popcountll(word[iword + 3]);
+	}
+	for (; iword < count; ++iword)
+		total[0] += (uint64_t)__builtin_popcountll(word[iword]);
+	return (size_t)(total[0] + total[1] + total[2] + total[3]);
+}
+
+//Nibble lookup with byte shuffles, byte counts summed into 64-bit lanes with sad
+__attribute__((target("avx2,popcnt"))) static size_t
+_bitset_popcount_avx2(const uint64_t* word, size_t count) {
+	const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+	                                        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i low = _mm256_set1_epi8(0x0F);
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i total = zero;
+	size_t iword = 0;
+	uint64_t lane[4];
+	while (iword + 4 <= count) {
+		//Byte counters hold at most 8 per iteration, flush before overflow
+		__m256i bytes = zero;
+		size_t iend = iword + (16 * 4);
+		if (iend > count)
+			iend = count & ~(size_t)3;
+		for (; iword < iend; iword += 4) {
+			__m256i value = _mm256_loadu_si256((const __m256i*)(const void*)(word + iword));
+			__m256i lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(value, low));
+			__m256i hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(value, 4), low));
+			bytes = _mm256_add_epi8(bytes, _mm256_add_epi8(lo, hi));
+		}
+		total = _mm256_add_epi64(total, _mm256_sad_epu8(bytes, zero));
+	}
+	_mm256_storeu_si256((__m256i*)(void*)lane, total);
+	for (; iword < count; ++iword)
+		lane[0] += (uint64_t)__builtin_popcountll(word[iword]);
+	return (size_t)(lane[0] + lane[1] + lane[2] + lane[3]);
+}
+
+#endif
+
+static size_t
+_bitset_popcount(const uint64_t* word, size_t count) {
+	int32_t impl = atomic_load32(&_bitset_popcount_impl);
+	if (impl == BITSET_POPCOUNT_UNKNOWN) {
+		impl = BITSET_POPCOUNT_GENERIC;
+#if BITSET_POPCOUNT_DISPATCH
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			impl = BITSET_POPCOUNT_AVX2;
+		else if (__builtin_cpu_supports("popcnt"))
+			impl = BITSET_POPCOUNT_POPCNT;
+#endif
+		atomic_store32(&_bitset_popcount_impl, impl);
+	}
+#if BITSET_POPCOUNT_DISPATCH
+	//Shuffle lookup only pays off on longer runs
+	if ((impl == BITSET_POPCOUNT_AVX2) && (count >= 16))
+		return _bitset_popcount_avx2(word, count);
+	if (impl >= BITSET_POPCOUNT_POPCNT)
+		return _bitset_popcount_popcnt(word, count);
+#endif
+	return _bitset_popcount_generic(word, count);
+}
+
+//Position of the set bit with the given rank in a word, bytewise counts with prefix sums
+//locate the byte holding the bit
+static unsigned int
+_bitset_select_word(uint64_t word, unsigned int rank) {
+	uint64_t bytes = word - ((word >> 1) & 0x5555555555555555ULL);
+	uint64_t prefix;
+	unsigned int offset = 0;
+	bytes = (bytes & 0x3333333333333333ULL) + ((bytes >> 2) & 0x3333333333333333ULL);
+	bytes = (bytes + (bytes >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	prefix = bytes * 0x0101010101010101ULL;
+	while (((prefix >> offset) & 0xFF) <= rank)
+		offset += 8;
+	if (offset)
+		rank -= (unsigned int)((prefix >> (offset - 8)) & 0xFF);
+	word >>= offset;
+	while (rank--)
+		word &= word - 1;
+	return offset + bits_ctz64(word);
+}
+
+bitset_t*
+bitset_allocate(size_t num_bits) {
+	bitset_t* set = memory_allocate(0, sizeof(bitset_t), 0, MEMORY_PERSISTENT);
+	bitset_initialize(set, num_bits);
+	return set;
+}
+
+void
+bitset_deallocate(bitset_t* set) {
+	bitset_finalize(set);
+	memory_deallocate(set);
+}
+
+void
+bitset_initialize(bitset_t* set, size_t num_bits) {
+	size_t storage = _bitset_storage_words(num_bits);
+	set->num_bits = num_bits;
+	set->num_words = (num_bits + 63) / 64;
+	set->word = storage ? memory_allocate(0, storage * sizeof(uint64_t), 16,
+	                                      MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED) : 0;
+	set->num_rank = 0;
+	set->rank = 0;
+	set->num_select = 0;
+	set->select = 0;
+}
+
+void
+bitset_finalize(bitset_t* set) {
+	memory_deallocate(set->word);
+	memory_deallocate(set->rank);
+	memory_deallocate(set->select);
+	set->word = 0;
+	set->rank = 0;
+	set->num_rank = 0;
+	set->select = 0;
+	set->num_select = 0;
+}
+
+void
+bitset_set_all(bitset_t* set) {
+	if (!set->num_words)
+		return;
+	memset(set->word, 0xFF, set->num_words * sizeof(uint64_t));
+	if (set->num_bits & 63)
+		set->word[set->num_words - 1] = (1ULL << (set->num_bits & 63)) - 1;
+}
+
+void
+bitset_clear(bitset_t* set) {
+	if (set->num_words)
+		memset(set->word, 0, set->num_words * sizeof(uint64_t));
+}
+
+//Storage is padded to whole blocks and 16 byte aligned, so the vector loops need no tail
+#if FOUNDATION_ARCH_SSE2
+#  define BITSET_BINARY_OP(name, sse2op, neonop, scalarop) \
+void \
+name(bitset_t* set, const bitset_t* other) { \
+	size_t iword, num_words = _bitset_storage_words(set->num_bits); \
+	__m128i* dst = (__m128i*)(void*)set->word; \
+	const __m128i* src = (const __m128i*)(const void*)other->word; \
+	FOUNDATION_ASSERT(set->num_bits == other->num_bits); \
+	for (iword = 0; iword < num_words / 2; ++iword) \
+		_mm_store_si128(dst + iword, sse2op(_mm_load_si128(dst + iword), _mm_load_si128(src + iword))); \
+}
+#elif FOUNDATION_ARCH_NEON
+#  define BITSET_BINARY_OP(name, sse2op, neonop, scalarop) \
+void \
+name(bitset_t* set, const bitset_t* other) { \
+	size_t iword, num_words = _bitset_storage_words(set->num_bits); \
+	FOUNDATION_ASSERT(set->num_bits == other->num_bits); \
+	for (iword = 0; iword < num_words; iword += 2) \
+		vst1q_u64(set->word + iword, neonop(vld1q_u64(set->word + iword), vld1q_u64(other->word + iword))); \
+}
+#else
+#  define BITSET_BINARY_OP(name, sse2op, neonop, scalarop) \
+void \
+name(bitset_t* set, const bitset_t* other) { \
+	size_t iword, num_words = set->num_words; \
+	FOUNDATION_ASSERT(set->num_bits == other->num_bits); \
+	for (iword = 0; iword < num_words; ++iword) \
+		set->word[iword] = scalarop(set->word[iword], other->word[iword]); \
+}
+#endif
+
+#define BITSET_SCALAR_AND(lhs, rhs) ((lhs) & (rhs))
+#define BITSET_SCALAR_OR(lhs, rhs) ((lhs) | (rhs))
+#define BITSET_SCALAR_XOR(lhs, rhs) ((lhs) ^ (rhs))
+#define BITSET_SCALAR_ANDNOT(lhs, rhs) ((lhs) & ~(rhs))
+//SSE2 andnot complements the first operand, NEON bic the second
+#define BITSET_SSE2_ANDNOT(lhs, rhs) _mm_andnot_si128((rhs), (lhs))
+
+BITSET_BINARY_OP(bitset_and, _mm_and_si128, vandq_u64, BITSET_SCALAR_AND)
+BITSET_BINARY_OP(bitset_or, _mm_or_si128, vorrq_u64, BITSET_SCALAR_OR)
+BITSET_BINARY_OP(bitset_xor, _mm_xor_si128, veorq_u64, BITSET_SCALAR_XOR)
+BITSET_BINARY_OP(bitset_andnot, BITSET_SSE2_ANDNOT, vbicq_u64, BITSET_SCALAR_ANDNOT)
+
+size_t
+bitset_count(const bitset_t* set) {
+	return _bitset_popcount(set->word, set->num_words);
+}
+
+size_t
+bitset_find_first(const bitset_t* set) {
+	return bitset_find_next(set, 0);
+}
+
+size_t
+bitset_find_next(const bitset_t* set, size_t index) {
+	size_t iword;
+	uint64_t word;
+	if (index >= set->num_bits)
+		return BITSET_NPOS;
+	iword = index >> 6;
+	word = set->word[iword] & (~0ULL << (index & 63));
+	while (!word) {
+		if (++iword >= set->num_words)
+			return BITSET_NPOS;
+		word = set->word[iword];
+	}
+	return (iword << 6) + bits_ctz64(word);
+}
+
+void
+bitset_rank_build(bitset_t* set) {
+	size_t iblock, isample, num_blocks = _bitset_storage_words(set->num_bits) / BITSET_BLOCK_WORDS;
+	uint64_t total = 0;
+	if (set->num_rank != num_blocks + 1) {
+		memory_deallocate(set->rank);
+		set->num_rank = num_blocks + 1;
+		set->rank = memory_allocate(0, set->num_rank * sizeof(uint64_t), 0, MEMORY_PERSISTENT);
+	}
+	for (iblock = 0; iblock < num_blocks; ++iblock) {
+		set->rank[iblock] = total;
+		total += _bitset_popcount(set->word + (iblock * BITSET_BLOCK_WORDS), BITSET_BLOCK_WORDS);
+	}
+	set->rank[num_blocks] = total;
+
+	memory_deallocate(set->select);
+	set->num_select = (size_t)((total + (BITSET_SELECT_SAMPLE - 1)) / BITSET_SELECT_SAMPLE);
+	set->select = set->num_select ?
+	              memory_allocate(0, set->num_select * sizeof(uint64_t), 0, MEMORY_PERSISTENT) : 0;
+	for (iblock = 0, isample = 0; isample < set->num_select; ++isample) {
+		uint64_t rank = (uint64_t)isample * BITSET_SELECT_SAMPLE;
+		while (set->rank[iblock + 1] <= rank)
+			++iblock;
+		set->select[isample] = iblock;
+	}
+}
+
+size_t
+bitset_rank(const bitset_t* set, size_t index) {
+	size_t iblock, iword, rank;
+	FOUNDATION_ASSERT_MSG(set->num_rank, "Rank index not built");
+	FOUNDATION_ASSERT(index <= set->num_bits);
+	iblock = index / BITSET_BLOCK_BITS;
+	iword = iblock * BITSET_BLOCK_WORDS;
+	rank = (size_t)set->rank[iblock];
+	if (iword < (index >> 6))
+		rank += _bitset_popcount(set->word + iword, (index >> 6) - iword);
+	if (index & 63)
+		rank += bits_popcount64(set->word[index >> 6] & ((1ULL << (index & 63)) - 1));
+	return rank;
+}
+
+size_t
+bitset_select(const bitset_t* set, size_t rank) {
+	size_t low, high, iword, isample;
+	FOUNDATION_ASSERT_MSG(set->num_rank, "Rank index not built");
+	if (!set->num_rank || (rank >= set->rank[set->num_rank - 1]))
+		return BITSET_NPOS;
+	//Search the blocks between the samples bracketing the rank for the last block with at
+	//most the requested number of preceding set bits
+	isample = rank / BITSET_SELECT_SAMPLE;
+	low = (size_t)set->select[isample];
+	high = (isample + 1 < set->num_select) ? (size_t)set->select[isample + 1] + 1 : set->num_rank - 1;
+	while (high - low > 1) {
+		size_t mid = low + ((high - low) / 2);
+		if (set->rank[mid] <= rank)
+			low = mid;
+		else
+			high = mid;
+	}
+	rank -= (size_t)set->rank[low];
+	for (iword = low * BITSET_BLOCK_WORDS;; ++iword) {
+		size_t count = bits_popcount64(set->word[iword]);
+		if (rank < count)
+			break;
+		rank -= count;
+	}
+	return (iword << 6) + _bitset_select_word(set->word[iword], (unsigned int)rank);
+}
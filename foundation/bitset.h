@@ -0,0 +1,181 @@
+/* bitset.h  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#pragma once
+
+/*! \file bitset.h
+\brief Fixed size bitset
+
+Fixed size bitset stored in 64-bit words. Bulk operations process whole words using
+SIMD instructions where available, and population counts use the hardware popcount
+instruction when supported by the CPU. An optional rank index allows constant time
+rank queries and logarithmic time select queries for succinct data structures. The
+rank index is invalidated by any modification of the bitset and must be rebuilt with
+#bitset_rank_build. Access is not atomic and therefor not thread safe. */
+
+#include <foundation/platform.h>
+#include <foundation/types.h>
+#include <foundation/bits.h>
+#include <foundation/assert.h>
+
+/*! Bit index returned when no matching bit was found */
+#define BITSET_NPOS ((size_t)-1)
+
+/*! Allocate a bitset with all bits cleared. The bitset should be deallocated with a
+call to #bitset_deallocate
+\param num_bits Number of bits
+\return New bitset */
+FOUNDATION_API bitset_t*
+bitset_allocate(size_t num_bits);
+
+/*! Deallocate a bitset previously allocated with #bitset_allocate
+\param set Bitset */
+FOUNDATION_API void
+bitset_deallocate(bitset_t* set);
+
+/*! Initialize a bitset with all bits cleared. The bitset should be finalized with a
+call to #bitset_finalize
+\param set Bitset
+\param num_bits Number of bits */
+FOUNDATION_API void
+bitset_initialize(bitset_t* set, size_t num_bits);
+
+/*! Finalize a bitset previously initialized with #bitset_initialize
+\param set Bitset */
+FOUNDATION_API void
+bitset_finalize(bitset_t* set);
+
+/*! Set a bit
+\param set Bitset
+\param index Bit index, must be less than bitset size */
+static FOUNDATION_FORCEINLINE void
+bitset_set(bitset_t* set, size_t index);
+
+/*! Clear a bit
+\param set Bitset
+\param index Bit index, must be less than bitset size */
+static FOUNDATION_FORCEINLINE void
+bitset_unset(bitset_t* set, size_t index);
+
+/*! Toggle a bit
+\param set Bitset
+\param index Bit index, must be less than bitset size */
+static FOUNDATION_FORCEINLINE void
+bitset_flip(bitset_t* set, size_t index);
+
+/*! Query a bit
+\param set Bitset
+\param index Bit index, must be less than bitset size
+\return true if bit is set, false if not */
+static FOUNDATION_FORCEINLINE bool
+bitset_test(const bitset_t* set, size_t index);
+
+/*! Set all bits
+\param set Bitset */
+FOUNDATION_API void
+bitset_set_all(bitset_t* set);
+
+/*! Clear all bits
+\param set Bitset */
+FOUNDATION_API void
+bitset_clear(bitset_t* set);
+
+/*! Store the bitwise and of two bitsets in the first bitset
+\param set Bitset to modify
+\param other Bitset, must have the same size */
+FOUNDATION_API void
+bitset_and(bitset_t* set, const bitset_t* other);
+
+/*! Store the bitwise or of two bitsets in the first bitset
+\param set Bitset to modify
+\param other Bitset, must have the same size */
+FOUNDATION_API void
+bitset_or(bitset_t* set, const bitset_t* other);
+
+/*! Store the bitwise exclusive or of two bitsets in the first bitset
+\param set Bitset to modify
+\param other Bitset, must have the same size */
+FOUNDATION_API void
+bitset_xor(bitset_t* set, const bitset_t* other);
+
+/*! Clear all bits in the first bitset which are set in the second bitset
+\param set Bitset to modify
+\param other Bitset, must have the same size */
+FOUNDATION_API void
+bitset_andnot(bitset_t* set, const bitset_t* other);
+
+/*! Count the number of set bits
+\param set Bitset
+\return Number of set bits */
+FOUNDATION_API size_t
+bitset_count(const bitset_t* set);
+
+/*! Find the first set bit
+\param set Bitset
+\return Index of first set bit, #BITSET_NPOS if no bit is set */
+FOUNDATION_API size_t
+bitset_find_first(const bitset_t* set);
+
+/*! Find the first set bit at or after the given index
+\param set Bitset
+\param index Bit index to start search at
+\return Index of set bit, #BITSET_NPOS if no bit is set at or after the index */
+FOUNDATION_API size_t
+bitset_find_next(const bitset_t* set, size_t index);
+
+/*! Build the rank index, required by #bitset_rank and #bitset_select. Must be called
+again after the bitset is modified.
+\param set Bitset */
+FOUNDATION_API void
+bitset_rank_build(bitset_t* set);
+
+/*! Count the number of set bits preceding the given index. Requires the rank index
+built by #bitset_rank_build
+\param set Bitset
+\param index Bit index, in range [0,size]
+\return Number of set bits in range [0,index) */
+FOUNDATION_API size_t
+bitset_rank(const bitset_t* set, size_t index);
+
+/*! Find the n:th set bit, counting from zero. Requires the rank index built by
+#bitset_rank_build
+\param set Bitset
+\param rank Number of set bits preceding the bit to find
+\return Index of the set bit, #BITSET_NPOS if fewer bits are set */
+FOUNDATION_API size_t
+bitset_select(const bitset_t* set, size_t rank);
+
+// Implementation
+
+static FOUNDATION_FORCEINLINE void
+bitset_set(bitset_t* set, size_t index) {
+	FOUNDATION_ASSERT(index < set->num_bits);
+	set->word[index >> 6] |= (1ULL << (index & 63));
+}
+
+static FOUNDATION_FORCEINLINE void
+bitset_unset(bitset_t* set, size_t index) {
+	FOUNDATION_ASSERT(index < set->num_bits);
+	set->word[index >> 6] &= ~(1ULL << (index & 63));
+}
+
+static FOUNDATION_FORCEINLINE void
+bitset_flip(bitset_t* set, size_t index) {
+	FOUNDATION_ASSERT(index < set->num_bits);
+	set->word[index >> 6] ^= (1ULL << (index & 63));
+}
+
+static FOUNDATION_FORCEINLINE bool
+bitset_test(const bitset_t* set, size_t index) {
+	FOUNDATION_ASSERT(index < set->num_bits);
+	return (set->word[index >> 6] & (1ULL << (index & 63))) != 0;
+}
@@ -0,0 +1,540 @@
+/* btree.c  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+
+//Minimum number of keys in any node but the root
+#define BTREE_MIN_KEYS    (BTREE_NODE_KEYS / 2)
+//Minimum fanout is 16, so this allows for well beyond 2^64 keys
+#define BTREE_MAX_HEIGHT  16
+#define BTREE_SLAB_NODES  64
+#define BTREE_NODE_ALIGN  64
+//Keys per group searched with vector compares, must be even
+#define BTREE_NODE_GROUP  8U
+#define BTREE_NODE_STRIDE ((sizeof(btree_node_t) + (BTREE_NODE_ALIGN - 1)) & ~(size_t)(BTREE_NODE_ALIGN - 1))
+
+static btree_node_t*
+_btree_node_allocate(btree_t* tree, uint32_t level) {
+	btree_node_t* node = tree->free;
+	unsigned int ikey;
+	if (!node) {
+		size_t inode;
+		char* slab = memory_allocate(0, (BTREE_NODE_STRIDE * BTREE_SLAB_NODES) + BTREE_NODE_ALIGN, 0,
+		                             MEMORY_PERSISTENT);
+		char* first = (char*)(((uintptr_t)slab + (BTREE_NODE_ALIGN - 1)) & ~(uintptr_t)(BTREE_NODE_ALIGN - 1));
+		array_push(tree->slab, slab);
+		for (inode = BTREE_SLAB_NODES; inode > 0; --inode) {
+			node = (btree_node_t*)(void*)(first + ((inode - 1) * BTREE_NODE_STRIDE));
+			node->next = tree->free;
+			tree->free = node;
+		}
+	}
+	tree->free = node->next;
+	node->num_keys = 0;
+	node->level = level;
+	node->next = 0;
+	for (ikey = 0; ikey < BTREE_NODE_KEYS; ++ikey)
+		node->key[ikey] = UINT64_MAX;
+	return node;
+}
+
+static void
+_btree_node_deallocate(btree_t* tree, btree_node_t* node) {
+	node->next = tree->free;
+	tree->free = node;
+}
+
+//Number of keys less than or equal to the given key. Every eighth key selects a group of
+//keys which are compared in pairs without branching. Unused keys are UINT64_MAX and only
+//match when searching for UINT64_MAX, which is handled by clamping to the key count
+static unsigned int
+_btree_node_upper(const btree_node_t* node, uint64_t key) {
+	unsigned int base = 0;
+	unsigned int ikey, ipair, num_pairs, greater;
+	for (ikey = BTREE_NODE_GROUP; ikey < BTREE_NODE_KEYS; ikey += BTREE_NODE_GROUP)
+		base += (node->key[ikey] <= key) ? BTREE_NODE_GROUP : 0;
+	num_pairs = math_min(BTREE_NODE_GROUP, BTREE_NODE_KEYS - base) / 2;
+#if FOUNDATION_ARCH_SSE2
+	{
+		//No unsigned 64-bit compare in SSE2, flip sign bits and combine 32-bit compares
+		const __m128i flip = _mm_set1_epi32((int)0x80000000U);
+		const __m128i search = _mm_xor_si128(_mm_set_epi32((int)(uint32_t)(key >> 32), (int)(uint32_t)key,
+		                                                   (int)(uint32_t)(key >> 32), (int)(uint32_t)key), flip);
+		const __m128i* keys = (const __m128i*)(const void*)(node->key + base);
+		__m128i count = _mm_setzero_si128();
+		int64_t lane[2];
+		for (ipair = 0; ipair < num_pairs; ++ipair) {
+			__m128i value = _mm_xor_si128(_mm_loadu_si128(keys + ipair), flip);
+			__m128i gt = _mm_cmpgt_epi32(value, search);
+			__m128i eq = _mm_cmpeq_epi32(value, search);
+			__m128i gt_high = _mm_shuffle_epi32(gt, _MM_SHUFFLE(3, 3, 1, 1));
+			__m128i gt_low = _mm_shuffle_epi32(gt, _MM_SHUFFLE(2, 2, 0, 0));
+			__m128i eq_high = _mm_shuffle_epi32(eq, _MM_SHUFFLE(3, 3, 1, 1));
+			count = _mm_sub_epi64(count, _mm_or_si128(gt_high, _mm_and_si128(eq_high, gt_low)));
+		}
+		_mm_storeu_si128((__m128i*)(void*)lane, count);
+		greater = (unsigned int)(lane[0] + lane[1]);
+	}
+#elif FOUNDATION_ARCH_NEON && FOUNDATION_ARCH_ARM_64
+	{
+		const uint64x2_t search = vdupq_n_u64(key);
+		uint64x2_t count = vdupq_n_u64(0);
+		for (ipair = 0; ipair < num_pairs; ++ipair)
+			count = vsubq_u64(count, vcgtq_u64(vld1q_u64(node->key + base + (ipair * 2)), search));
+		greater = (unsigned int)(vgetq_lane_u64(count, 0) + vgetq_lane_u64(count, 1));
+	}
+#else
+	greater = 0;
+	for (ipair = 0; ipair < num_pairs * 2; ++ipair)
+		greater += (node->key[base + ipair] > key) ? 1 : 0;
+#endif
+	return math_min(base + (num_pairs * 2) - greater, node->num_keys);
+}
+
+//Number of keys less than the given key
+static unsigned int
+_btree_node_lower(const btree_node_t* node, uint64_t key) {
+	return key ? _btree_node_upper(node, key - 1) : 0;
+}
+
+static void
+_btree_leaf_insert(btree_node_t* node, unsigned int pos, uint64_t key, void* value) {
+	unsigned int count = node->num_keys - pos;
+	memmove(node->key + pos + 1, node->key + pos, sizeof(uint64_t) * count);
+	memmove(node->slot + pos + 1, node->slot + pos, sizeof(void*) * count);
+	node->key[pos] = key;
+	node->slot[pos] = value;
+	++node->num_keys;
+}
+
+static void
+_btree_leaf_remove(btree_node_t* node, unsigned int pos) {
+	unsigned int count = node->num_keys - pos - 1;
+	memmove(node->key + pos, node->key + pos + 1, sizeof(uint64_t) * count);
+	memmove(node->slot + pos, node->slot + pos + 1, sizeof(void*) * count);
+	--node->num_keys;
+	node->key[node->num_keys] = UINT64_MAX;
+}
+
+//Insert key at given position and the child following it
+static void
+_btree_inner_insert(btree_node_t* node, unsigned int pos, uint64_t key, btree_node_t* child) {
+	unsigned int count = node->num_keys - pos;
+	memmove(node->key + pos + 1, node->key + pos, sizeof(uint64_t) * count);
+	memmove(node->slot + pos + 2, node->slot + pos + 1, sizeof(void*) * count);
+	node->key[pos] = key;
+	node->slot[pos + 1] = child;
+	++node->num_keys;
+}
+
+//Remove key at given position and the child following it
+static void
+_btree_inner_remove(btree_node_t* node, unsigned int pos) {
+	unsigned int count = node->num_keys - pos - 1;
+	memmove(node->key + pos, node->key + pos + 1, sizeof(uint64_t) * count);
+	memmove(node->slot + pos + 1, node->slot + pos + 2, sizeof(void*) * count);
+	--node->num_keys;
+	node->key[node->num_keys] = UINT64_MAX;
+}
+
+static void
+_btree_node_truncate(btree_node_t* node, unsigned int num_keys) {
+	unsigned int ikey;
+	for (ikey = num_keys; ikey < node->num_keys; ++ikey)
+		node->key[ikey] = UINT64_MAX;
+	node->num_keys = num_keys;
+}
+
+static const btree_node_t*
+_btree_find_leaf(const btree_t* tree, uint64_t key) {
+	const btree_node_t* node = tree->root;
+	while (node && node->level)
+		node = node->slot[_btree_node_upper(node, key)];
+	return node;
+}
+
+btree_t*
+btree_allocate(void) {
+	btree_t* tree = memory_allocate(0, sizeof(btree_t), 0, MEMORY_PERSISTENT);
+	btree_initialize(tree);
+	return tree;
+}
+
+void
+btree_deallocate(btree_t* tree) {
+	btree_finalize(tree);
+	memory_deallocate(tree);
+}
+
+void
+btree_initialize(btree_t* tree) {
+	memset(tree, 0, sizeof(btree_t));
+}
+
+void
+btree_finalize(btree_t* tree) {
+	btree_clear(tree);
+	array_deallocate(tree->slab);
+}
+
+void*
+btree_insert(btree_t* tree, uint64_t key, void* value) {
+	btree_node_t* path[BTREE_MAX_HEIGHT];
+	unsigned int index[BTREE_MAX_HEIGHT];
+	unsigned int depth = 0;
+	unsigned int pos;
+	btree_node_t* node;
+	btree_node_t* right;
+	uint64_t separator;
+
+	if (!tree->root)
+		tree->root = _btree_node_allocate(tree, 0);
+
+	node = tree->root;
+	while (node->level) {
+		path[depth] = node;
+		index[depth] = _btree_node_upper(node, key);
+		node = node->slot[index[depth++]];
+	}
+
+	pos = _btree_node_lower(node, key);
+	if ((pos < node->num_keys) && (node->key[pos] == key)) {
+		void* previous = node->slot[pos];
+		node->slot[pos] = value;
+		return previous;
+	}
+
+	++tree->size;
+	if (node->num_keys < BTREE_NODE_KEYS) {
+		_btree_leaf_insert(node, pos, key, value);
+		return 0;
+	}
+
+	//Split full leaf in halves and insert in the half covering the key
+	right = _btree_node_allocate(tree, 0);
+	right->num_keys = node->num_keys - BTREE_MIN_KEYS;
+	memcpy(right->key, node->key + BTREE_MIN_KEYS, sizeof(uint64_t) * right->num_keys);
+	memcpy(right->slot, node->slot + BTREE_MIN_KEYS, sizeof(void*) * right->num_keys);
+	_btree_node_truncate(node, BTREE_MIN_KEYS);
+	right->next = node->next;
+	node->next = right;
+	if (pos <= BTREE_MIN_KEYS)
+		_btree_leaf_insert(node, pos, key, value);
+	else
+		_btree_leaf_insert(right, pos - BTREE_MIN_KEYS, key, value);
+	separator = right->key[0];
+
+	//Insert separator in parents, splitting full inner nodes on the way up
+	while (depth) {
+		uint64_t key_merged[BTREE_NODE_KEYS + 1];
+		void* slot_merged[BTREE_NODE_KEYS + 2];
+		btree_node_t* sibling;
+		unsigned int count;
+
+		node = path[--depth];
+		pos = index[depth];
+		if (node->num_keys < BTREE_NODE_KEYS) {
+			_btree_inner_insert(node, pos, separator, right);
+			return 0;
+		}
+
+		count = node->num_keys;
+		memcpy(key_merged, node->key, sizeof(uint64_t) * pos);
+		memcpy(key_merged + pos + 1, node->key + pos, sizeof(uint64_t) * (count - pos));
+		key_merged[pos] = separator;
+		memcpy(slot_merged, node->slot, sizeof(void*) * (pos + 1));
+		memcpy(slot_merged + pos + 2, node->slot + pos + 1, sizeof(void*) * (count - pos));
+		slot_merged[pos + 1] = right;
+
+		//Left keeps the lower half, middle key moves up, right takes the upper half
+		sibling = _btree_node_allocate(tree, node->level);
+		_btree_node_truncate(node, BTREE_MIN_KEYS);
+		memcpy(node->key, key_merged, sizeof(uint64_t) * BTREE_MIN_KEYS);
+		memcpy(node->slot, slot_merged, sizeof(void*) * (BTREE_MIN_KEYS + 1));
+		sibling->num_keys = count - BTREE_MIN_KEYS;
+		memcpy(sibling->key, key_merged + BTREE_MIN_KEYS + 1, sizeof(uint64_t) * sibling->num_keys);
+		memcpy(sibling->slot, slot_merged + BTREE_MIN_KEYS + 1, sizeof(void*) * (sibling->num_keys + 1));
+		separator = key_merged[BTREE_MIN_KEYS];
+		right = sibling;
+	}
+
+	node = _btree_node_allocate(tree, tree->root->level + 1);
+	node->num_keys = 1;
+	node->key[0] = separator;
+	node->slot[0] = tree->root;
+	node->slot[1] = right;
+	tree->root = node;
+	return 0;
+}
+
+//Refill an underflowing node from a sibling, or merge it with a sibling
+static void
+_btree_rebalance(btree_t* tree, btree_node_t* parent, unsigned int pos) {
+	btree_node_t* node = parent->slot[pos];
+	btree_node_t* left = pos ? parent->slot[pos - 1] : 0;
+	btree_node_t* right = (pos < parent->num_keys) ? parent->slot[pos + 1] : 0;
+
+	if (left && (left->num_keys > BTREE_MIN_KEYS)) {
+		unsigned int last = left->num_keys - 1;
+		memmove(node->key + 1, node->key, sizeof(uint64_t) * node->num_keys);
+		if (node->level) {
+			memmove(node->slot + 1, node->slot, sizeof(void*) * (node->num_keys + 1));
+			node->key[0] = parent->key[pos - 1];
+			node->slot[0] = left->slot[last + 1];
+			parent->key[pos - 1] = left->key[last];
+		}
+		else {
+			memmove(node->slot + 1, node->slot, sizeof(void*) * node->num_keys);
+			node->key[0] = left->key[last];
+			node->slot[0] = left->slot[last];
+			parent->key[pos - 1] = node->key[0];
+		}
+		++node->num_keys;
+		_btree_node_truncate(left, last);
+		return;
+	}
+
+	if (right && (right->num_keys > BTREE_MIN_KEYS)) {
+		if (node->level) {
+			node->key[node->num_keys] = parent->key[pos];
+			node->slot[node->num_keys + 1] = right->slot[0];
+			parent->key[pos] = right->key[0];
+			memmove(right->slot, right->slot + 1, sizeof(void*) * right->num_keys);
+		}
+		else {
+			node->key[node->num_keys] = right->key[0];
+			node->slot[node->num_keys] = right->slot[0];
+			parent->key[pos] = right->key[1];
+			memmove(right->slot, right->slot + 1, sizeof(void*) * (right->num_keys - 1));
+		}
+		++node->num_keys;
+		memmove(right->key, right->key + 1, sizeof(uint64_t) * (right->num_keys - 1));
+		--right->num_keys;
+		right->key[right->num_keys] = UINT64_MAX;
+		return;
+	}
+
+	//Merge into the left node of the pair, both are at minimum size so the result fits
+	if (left) {
+		right = node;
+		node = left;
+		--pos;
+	}
+	if (node->level) {
+		node->key[node->num_keys] = parent->key[pos];
+		memcpy(node->key + node->num_keys + 1, right->key, sizeof(uint64_t) * right->num_keys);
+		memcpy(node->slot + node->num_keys + 1, right->slot, sizeof(void*) * (right->num_keys + 1));
+		node->num_keys += right->num_keys + 1;
+	}
+	else {
+		memcpy(node->key + node->num_keys, right->key, sizeof(uint64_t) * right->num_keys);
+		memcpy(node->slot + node->num_keys, right->slot, sizeof(void*) * right->num_keys);
+		node->num_keys += right->num_keys;
+		node->next = right->next;
+	}
+	_btree_inner_remove(parent, pos);
+	_btree_node_deallocate(tree, right);
+}
+
+void*
+btree_erase(btree_t* tree, uint64_t key) {
+	btree_node_t* path[BTREE_MAX_HEIGHT];
+	unsigned int index[BTREE_MAX_HEIGHT];
+	unsigned int depth = 0;
+	unsigned int pos;
+	btree_node_t* node = tree->root;
+	void* value;
+
+	if (!node)
+		return 0;
+	while (node->level) {
+		path[depth] = node;
+		index[depth] = _btree_node_upper(node, key);
+		node = node->slot[index[depth++]];
+	}
+
+	pos = _btree_node_lower(node, key);
+	if ((pos >= node->num_keys) || (node->key[pos] != key))
+		return 0;
+
+	value = node->slot[pos];
+	_btree_leaf_remove(node, pos);
+	--tree->size;
+
+	while (depth && (node->num_keys < BTREE_MIN_KEYS)) {
+		node = path[--depth];
+		_btree_rebalance(tree, node, index[depth]);
+	}
+
+	//Collapse root with a single child
+	node = tree->root;
+	if (node->level && !node->num_keys) {
+		tree->root = node->slot[0];
+		_btree_node_deallocate(tree, node);
+	}
+
+	return value;
+}
+
+void*
+btree_lookup(const btree_t* tree, uint64_t key) {
+	const btree_node_t* node = _btree_find_leaf(tree, key);
+	unsigned int pos;
+	if (!node)
+		return 0;
+	pos = _btree_node_lower(node, key);
+	return ((pos < node->num_keys) && (node->key[pos] == key)) ? node->slot[pos] : 0;
+}
+
+bool
+btree_has_key(const btree_t* tree, uint64_t key) {
+	const btree_node_t* node = _btree_find_leaf(tree, key);
+	unsigned int pos;
+	if (!node)
+		return false;
+	pos = _btree_node_lower(node, key);
+	return (pos < node->num_keys) && (node->key[pos] == key);
+}
+
+size_t
+btree_size(const btree_t* tree) {
+	return tree->size;
+}
+
+void
+btree_clear(btree_t* tree) {
+	size_t islab, num_slabs = array_size(tree->slab);
+	for (islab = 0; islab < num_slabs; ++islab)
+		memory_deallocate(tree->slab[islab]);
+	array_clear(tree->slab);
+	tree->root = 0;
+	tree->free = 0;
+	tree->size = 0;
+}
+
+bool
+btree_load(btree_t* tree, const uint64_t* keys, void* const* values, size_t count) {
+	btree_node_t** level;
+	uint64_t* level_key;
+	size_t ikey, inode, num_nodes, num_parents;
+	uint32_t height;
+
+	btree_clear(tree);
+	for (ikey = 1; ikey < count; ++ikey) {
+		if (keys[ikey - 1] >= keys[ikey]) {
+			log_errorf(0, ERROR_INVALID_VALUE, STRING_CONST("B+tree load keys not in ascending order at index %" PRIsize),
+			           ikey);
+			return false;
+		}
+	}
+	if (!count)
+		return true;
+
+	//Spread keys evenly so every leaf holds at least the minimum number of keys
+	num_nodes = (count + (BTREE_NODE_KEYS - 1)) / BTREE_NODE_KEYS;
+	level = memory_allocate(0, sizeof(btree_node_t*) * num_nodes, 0, MEMORY_PERSISTENT);
+	level_key = memory_allocate(0, sizeof(uint64_t) * num_nodes, 0, MEMORY_PERSISTENT);
+	for (inode = 0, ikey = 0; inode < num_nodes; ++inode) {
+		btree_node_t* node = _btree_node_allocate(tree, 0);
+		size_t num_keys = (count / num_nodes) + ((inode < (count % num_nodes)) ? 1 : 0);
+		memcpy(node->key, keys + ikey, sizeof(uint64_t) * num_keys);
+		if (values)
+			memcpy(node->slot, values + ikey, sizeof(void*) * num_keys);
+		else
+			memset(node->slot, 0, sizeof(void*) * num_keys);
+		node->num_keys = (uint32_t)num_keys;
+		if (inode)
+			level[inode - 1]->next = node;
+		level[inode] = node;
+		level_key[inode] = keys[ikey];
+		ikey += num_keys;
+	}
+
+	//Build inner levels bottom up, separators are the smallest key of each child subtree
+	for (height = 1; num_nodes > 1; ++height) {
+		size_t ichild = 0;
+		num_parents = (num_nodes + BTREE_NODE_KEYS) / (BTREE_NODE_KEYS + 1);
+		for (inode = 0; inode < num_parents; ++inode) {
+			btree_node_t* node = _btree_node_allocate(tree, height);
+			size_t ientry, num_children = (num_nodes / num_parents) + ((inode < (num_nodes % num_parents)) ? 1 : 0);
+			uint64_t first_key = level_key[ichild];
+			for (ientry = 0; ientry < num_children; ++ientry, ++ichild) {
+				node->slot[ientry] = level[ichild];
+				if (ientry)
+					node->key[ientry - 1] = level_key[ichild];
+			}
+			node->num_keys = (uint32_t)(num_children - 1);
+			level[inode] = node;
+			level_key[inode] = first_key;
+		}
+		num_nodes = num_parents;
+	}
+
+	tree->root = level[0];
+	tree->size = count;
+	memory_deallocate(level);
+	memory_deallocate(level_key);
+	return true;
+}
+
+size_t
+btree_range(const btree_t* tree, uint64_t first, uint64_t last, uint64_t* keys, void** values,
+            size_t capacity) {
+	btree_iterator_t it = btree_lower_bound(tree, first);
+	size_t count = 0;
+	if (first > last)
+		return 0;
+	while (it.node && (count < capacity)) {
+		const btree_node_t* node = it.node;
+		unsigned int ikey = it.index;
+		unsigned int end = node->num_keys;
+		//Copy the part of the leaf within range in one go
+		if (node->key[end - 1] > last)
+			end = _btree_node_upper(node, last);
+		if (end - ikey > capacity - count)
+			end = ikey + (unsigned int)(capacity - count);
+		if (keys)
+			memcpy(keys + count, node->key + ikey, sizeof(uint64_t) * (end - ikey));
+		if (values)
+			memcpy(values + count, node->slot + ikey, sizeof(void*) * (end - ikey));
+		count += end - ikey;
+		if (end < node->num_keys)
+			break;
+		it.node = node->next;
+		it.index = 0;
+	}
+	return count;
+}
+
+btree_iterator_t
+btree_begin(const btree_t* tree) {
+	btree_iterator_t it;
+	const btree_node_t* node = tree->root;
+	while (node && node->level)
+		node = node->slot[0];
+	it.node = (node && node->num_keys) ? node : 0;
+	it.index = 0;
+	return it;
+}
+
+btree_iterator_t
+btree_lower_bound(const btree_t* tree, uint64_t key) {
+	btree_iterator_t it;
+	const btree_node_t* node = _btree_find_leaf(tree, key);
+	it.index = node ? _btree_node_lower(node, key) : 0;
+	if (node && (it.index >= node->num_keys)) {
+		node = node->next;
+		it.index = 0;
+	}
+	it.node = node;
+	return it;
+}
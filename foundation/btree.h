@@ -0,0 +1,173 @@
+/* btree.h  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#pragma once
+
+/*! \file btree.h
+\brief B+tree ordered map
+
+Ordered map from 64-bit integer keys (or hash_t) to data pointers, implemented as an
+in-memory B+tree. Nodes hold up to 30 keys in eight cache lines and are searched with
+vector compares where available. Leaves are linked in key order, allowing sorted
+iteration and range queries without copying or sorting. A tree can be bulk loaded from
+sorted input in linear time. Access is not atomic and therefor not thread safe. */
+
+#include <foundation/platform.h>
+#include <foundation/types.h>
+
+/*! Allocate an empty B+tree. The tree should be deallocated with a call to
+#btree_deallocate
+\return New tree */
+FOUNDATION_API btree_t*
+btree_allocate(void);
+
+/*! Deallocate a B+tree previously allocated with #btree_allocate
+\param tree Tree */
+FOUNDATION_API void
+btree_deallocate(btree_t* tree);
+
+/*! Initialize an empty B+tree. The tree should be finalized with a call to
+#btree_finalize
+\param tree Tree */
+FOUNDATION_API void
+btree_initialize(btree_t* tree);
+
+/*! Finalize a B+tree previously initialized with #btree_initialize
+\param tree Tree */
+FOUNDATION_API void
+btree_finalize(btree_t* tree);
+
+/*! Insert a key and value, replacing the value if the key already exists
+\param tree Tree
+\param key Key
+\param value Value
+\return Previous value for the key, null if key did not exist */
+FOUNDATION_API void*
+btree_insert(btree_t* tree, uint64_t key, void* value);
+
+/*! Erase a key
+\param tree Tree
+\param key Key
+\return Value for the erased key, null if key did not exist */
+FOUNDATION_API void*
+btree_erase(btree_t* tree, uint64_t key);
+
+/*! Lookup the value for a key
+\param tree Tree
+\param key Key
+\return Value for the key, null if key does not exist */
+FOUNDATION_API void*
+btree_lookup(const btree_t* tree, uint64_t key);
+
+/*! Query if a key exists
+\param tree Tree
+\param key Key
+\return true if key exists, false if not */
+FOUNDATION_API bool
+btree_has_key(const btree_t* tree, uint64_t key);
+
+/*! Get number of keys
+\param tree Tree
+\return Number of keys */
+FOUNDATION_API size_t
+btree_size(const btree_t* tree);
+
+/*! Erase all keys and release all nodes
+\param tree Tree */
+FOUNDATION_API void
+btree_clear(btree_t* tree);
+
+/*! Replace the content of the tree with the given keys and values. Leaves are filled
+completely, making bulk loading suited for read mostly trees.
+\param tree Tree
+\param keys Keys in strictly ascending order
+\param values Values, or null to store null values
+\param count Number of keys
+\return true if loaded, false if keys are not in strictly ascending order, in which
+        case the tree is left empty */
+FOUNDATION_API bool
+btree_load(btree_t* tree, const uint64_t* keys, void* const* values, size_t count);
+
+/*! Copy all entries with keys in the range [first,last] in ascending key order
+\param tree Tree
+\param first First key in range
+\param last Last key in range
+\param keys Buffer receiving keys, may be null
+\param values Buffer receiving values, may be null
+\param capacity Capacity of buffers
+\return Number of entries stored, at most capacity */
+FOUNDATION_API size_t
+btree_range(const btree_t* tree, uint64_t first, uint64_t last, uint64_t* keys, void** values,
+            size_t capacity);
+
+/*! Get an iterator at the entry with the smallest key
+\param tree Tree
+\return Iterator, done if tree is empty */
+FOUNDATION_API btree_iterator_t
+btree_begin(const btree_t* tree);
+
+/*! Get an iterator at the entry with the smallest key not less than the given key
+\param tree Tree
+\param key Key
+\return Iterator, done if all keys are less than the given key */
+FOUNDATION_API btree_iterator_t
+btree_lower_bound(const btree_t* tree, uint64_t key);
+
+/*! Query if the iterator has passed the last entry
+\param iterator Iterator
+\return true if done, false if iterator is at an entry */
+static FOUNDATION_FORCEINLINE bool
+btree_iterator_done(const btree_iterator_t* iterator);
+
+/*! Get the key of the current entry
+\param iterator Iterator, must not be done
+\return Key */
+static FOUNDATION_FORCEINLINE uint64_t
+btree_iterator_key(const btree_iterator_t* iterator);
+
+/*! Get the value of the current entry
+\param iterator Iterator, must not be done
+\return Value */
+static FOUNDATION_FORCEINLINE void*
+btree_iterator_value(const btree_iterator_t* iterator);
+
+/*! Advance the iterator to the next entry in key order. The iterator is invalidated by
+any modification of the tree
+\param iterator Iterator, must not be done */
+static FOUNDATION_FORCEINLINE void
+btree_iterator_next(btree_iterator_t* iterator);
+
+// Implementation
+
+static FOUNDATION_FORCEINLINE bool
+btree_iterator_done(const btree_iterator_t* iterator) {
+	return !iterator->node;
+}
+
+static FOUNDATION_FORCEINLINE uint64_t
+btree_iterator_key(const btree_iterator_t* iterator) {
+	return iterator->node->key[iterator->index];
+}
+
+static FOUNDATION_FORCEINLINE void*
+btree_iterator_value(const btree_iterator_t* iterator) {
+	return iterator->node->slot[iterator->index];
+}
+
+static FOUNDATION_FORCEINLINE void
+btree_iterator_next(btree_iterator_t* iterator) {
+	//Only the root leaf can be empty, all linked leaves hold at least one key
+	if (++iterator->index >= iterator->node->num_keys) {
+		iterator->node = iterator->node->next;
+		iterator->index = 0;
+	}
+}
@@ -0,0 +1,391 @@
+/* cache.c  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+
+#define CACHE_NIL          0xFFFFFFFFU
+#define CACHE_PROBATION    0
+#define CACHE_PROTECTED    1
+#define CACHE_MINSLOTS     16
+//Percentage of shard budget available to the protected segment
+#define CACHE_PROTECTED_PERCENT 80
+
+static FOUNDATION_FORCEINLINE hash_t
+_cache_mix(hash_t key) {
+	//Keys are usually hashes already, mix anyway to spread sequential keys
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ULL;
+	key ^= key >> 33;
+	return key;
+}
+
+static FOUNDATION_FORCEINLINE cache_shard_t*
+_cache_shard(cache_t* cache, hash_t mixed) {
+	//Shard is selected by high bits, index slot by low bits
+	return cache->shard + ((mixed >> 32) & (cache->num_shards - 1));
+}
+
+static void
+_cache_lock(cache_t* cache, cache_shard_t* shard) {
+	unsigned int spin = 0;
+	if (!cache->concurrent)
+		return;
+	while (!atomic_cas32(&shard->lock, 1, 0)) {
+		if (++spin > 64)
+			thread_yield();
+	}
+}
+
+static void
+_cache_unlock(cache_t* cache, cache_shard_t* shard) {
+	if (!cache->concurrent)
+		return;
+	atomic_thread_fence_release();
+	atomic_store32(&shard->lock, 0);
+}
+
+static size_t
+_cache_slot_find(const cache_shard_t* shard, hash_t key, hash_t mixed) {
+	size_t mask = shard->num_slots - 1;
+	size_t islot = mixed & mask;
+	while (shard->slot[islot].entry) {
+		if (shard->slot[islot].key == key)
+			return islot;
+		islot = (islot + 1) & mask;
+	}
+	return shard->num_slots;
+}
+
+static void
+_cache_slot_insert(cache_shard_t* shard, hash_t key, uint32_t entry) {
+	size_t mask = shard->num_slots - 1;
+	size_t islot = _cache_mix(key) & mask;
+	while (shard->slot[islot].entry)
+		islot = (islot + 1) & mask;
+	shard->slot[islot].key = key;
+	shard->slot[islot].entry = entry + 1;
+}
+
+static void
+_cache_slot_erase(cache_shard_t* shard, size_t islot) {
+	//Backward shift deletion, keeping probe sequences intact without tombstones
+	size_t mask = shard->num_slots - 1;
+	size_t inext = (islot + 1) & mask;
+	while (shard->slot[inext].entry) {
+		size_t home = _cache_mix(shard->slot[inext].key) & mask;
+		if (((inext - home) & mask) >= ((inext - islot) & mask)) {
+			shard->slot[islot] = shard->slot[inext];
+			islot = inext;
+		}
+		inext = (inext + 1) & mask;
+	}
+	shard->slot[islot].entry = 0;
+}
+
+static void
+_cache_slot_grow(cache_shard_t* shard) {
+	cache_slot_t* slot = shard->slot;
+	size_t num_slots = shard->num_slots;
+	size_t islot;
+	shard->num_slots = num_slots * 2;
+	shard->slot = memory_allocate(0, sizeof(cache_slot_t) * shard->num_slots, 0,
+	                              MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	for (islot = 0; islot < num_slots; ++islot) {
+		if (slot[islot].entry)
+			_cache_slot_insert(shard, slot[islot].key, slot[islot].entry - 1);
+	}
+	memory_deallocate(slot);
+}
+
+static void
+_cache_unlink(cache_shard_t* shard, uint32_t ientry) {
+	cache_entry_t* entry = shard->entry + ientry;
+	uint32_t segment = entry->segment;
+	if (entry->prev != CACHE_NIL)
+		shard->entry[entry->prev].next = entry->next;
+	else
+		shard->head[segment] = entry->next;
+	if (entry->next != CACHE_NIL)
+		shard->entry[entry->next].prev = entry->prev;
+	else
+		shard->tail[segment] = entry->prev;
+	shard->used[segment] -= entry->cost;
+}
+
+static void
+_cache_link(cache_shard_t* shard, uint32_t ientry, uint32_t segment) {
+	cache_entry_t* entry = shard->entry + ientry;
+	entry->segment = segment;
+	entry->prev = CACHE_NIL;
+	entry->next = shard->head[segment];
+	if (entry->next != CACHE_NIL)
+		shard->entry[entry->next].prev = ientry;
+	else
+		shard->tail[segment] = ientry;
+	shard->head[segment] = ientry;
+	shard->used[segment] += entry->cost;
+}
+
+static void
+_cache_remove(cache_t* cache, cache_shard_t* shard, uint32_t ientry, size_t islot) {
+	cache_entry_t* entry = shard->entry + ientry;
+	_cache_unlink(shard, ientry);
+	_cache_slot_erase(shard, islot);
+	if (cache->evict)
+		cache->evict(entry->key, entry->value, entry->cost);
+	entry->value = nullptr;
+	entry->next = shard->free;
+	shard->free = ientry;
+	--shard->count;
+}
+
+static void
+_cache_balance(cache_t* cache, cache_shard_t* shard, uint32_t keep) {
+	//Demote least recently used protected entries to probation
+	while (shard->used[CACHE_PROTECTED] > shard->protected_budget) {
+		uint32_t ientry = shard->tail[CACHE_PROTECTED];
+		if (ientry == keep)
+			break;
+		_cache_unlink(shard, ientry);
+		_cache_link(shard, ientry, CACHE_PROBATION);
+	}
+	//Evict from probation, falling back to protected when only the kept entry remains
+	while (shard->used[CACHE_PROBATION] + shard->used[CACHE_PROTECTED] > shard->budget) {
+		uint32_t ientry = shard->tail[CACHE_PROBATION];
+		cache_entry_t* entry;
+		if (ientry == keep)
+			ientry = shard->entry[keep].prev;
+		if (ientry == CACHE_NIL) {
+			ientry = shard->tail[CACHE_PROTECTED];
+			if (ientry == keep)
+				ientry = shard->entry[keep].prev;
+			if (ientry == CACHE_NIL)
+				break;
+		}
+		entry = shard->entry + ientry;
+		_cache_remove(cache, shard, ientry, _cache_slot_find(shard, entry->key, _cache_mix(entry->key)));
+		++shard->evictions;
+	}
+}
+
+cache_t*
+cache_allocate(size_t budget, size_t shards, cache_evict_fn evict) {
+	cache_t* cache = memory_allocate(0, sizeof(cache_t), 0, MEMORY_PERSISTENT);
+	cache_initialize(cache, budget, shards, evict);
+	return cache;
+}
+
+void
+cache_deallocate(cache_t* cache) {
+	if (!cache)
+		return;
+	cache_finalize(cache);
+	memory_deallocate(cache);
+}
+
+void
+cache_initialize(cache_t* cache, size_t budget, size_t shards, cache_evict_fn evict) {
+	size_t ishard;
+
+	cache->concurrent = (shards > 0);
+	cache->num_shards = 1;
+	while (cache->num_shards < shards)
+		cache->num_shards <<= 1;
+	cache->evict = evict;
+	cache->shard = memory_allocate(0, sizeof(cache_shard_t) * cache->num_shards, 64,
+	                               MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	for (ishard = 0; ishard < cache->num_shards; ++ishard) {
+		cache_shard_t* shard = cache->shard + ishard;
+		shard->budget = budget / cache->num_shards;
+		shard->protected_budget = (shard->budget / 100) * CACHE_PROTECTED_PERCENT +
+		                          ((shard->budget % 100) * CACHE_PROTECTED_PERCENT) / 100;
+		shard->head[CACHE_PROBATION] = shard->head[CACHE_PROTECTED] = CACHE_NIL;
+		shard->tail[CACHE_PROBATION] = shard->tail[CACHE_PROTECTED] = CACHE_NIL;
+		shard->free = CACHE_NIL;
+		shard->num_slots = CACHE_MINSLOTS;
+		shard->slot = memory_allocate(0, sizeof(cache_slot_t) * shard->num_slots, 0,
+		                              MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	}
+}
+
+void
+cache_finalize(cache_t* cache) {
+	size_t ishard;
+	if (!cache->shard)
+		return;
+	cache_clear(cache);
+	for (ishard = 0; ishard < cache->num_shards; ++ishard) {
+		array_deallocate(cache->shard[ishard].entry);
+		memory_deallocate(cache->shard[ishard].slot);
+	}
+	memory_deallocate(cache->shard);
+	cache->shard = nullptr;
+}
+
+bool
+cache_insert(cache_t* cache, hash_t key, void* value, size_t cost) {
+	hash_t mixed = _cache_mix(key);
+	cache_shard_t* shard = _cache_shard(cache, mixed);
+	uint32_t ientry;
+	size_t islot;
+
+	if (cost > shard->budget)
+		return false;
+
+	_cache_lock(cache, shard);
+
+	islot = _cache_slot_find(shard, key, mixed);
+	if (islot < shard->num_slots) {
+		cache_entry_t* entry;
+		void* previous;
+		ientry = shard->slot[islot].entry - 1;
+		entry = shard->entry + ientry;
+		previous = entry->value;
+		if (cache->evict && (previous != value))
+			cache->evict(key, previous, entry->cost);
+		_cache_unlink(shard, ientry);
+		entry->value = value;
+		entry->cost = cost;
+		_cache_link(shard, ientry, entry->segment);
+	}
+	else {
+		cache_entry_t created;
+		created.key = key;
+		created.value = value;
+		created.cost = cost;
+		if (shard->free != CACHE_NIL) {
+			ientry = shard->free;
+			shard->free = shard->entry[ientry].next;
+			shard->entry[ientry] = created;
+		}
+		else {
+			ientry = (uint32_t)array_size(shard->entry);
+			array_push(shard->entry, created);
+		}
+		_cache_link(shard, ientry, CACHE_PROBATION);
+		//Keep load factor at or below one half
+		if (++shard->count * 2 > shard->num_slots)
+			_cache_slot_grow(shard);
+		_cache_slot_insert(shard, key, ientry);
+		++shard->inserts;
+	}
+
+	_cache_balance(cache, shard, ientry);
+
+	_cache_unlock(cache, shard);
+	return true;
+}
+
+void*
+cache_lookup(cache_t* cache, hash_t key) {
+	return cache_lookup_retain(cache, key, nullptr);
+}
+
+void*
+cache_lookup_retain(cache_t* cache, hash_t key, cache_retain_fn retain) {
+	hash_t mixed = _cache_mix(key);
+	cache_shard_t* shard = _cache_shard(cache, mixed);
+	cache_entry_t* entry;
+	uint32_t ientry;
+	size_t islot;
+	void* value;
+
+	_cache_lock(cache, shard);
+
+	islot = _cache_slot_find(shard, key, mixed);
+	if (islot >= shard->num_slots) {
+		++shard->misses;
+		_cache_unlock(cache, shard);
+		return nullptr;
+	}
+
+	++shard->hits;
+	ientry = shard->slot[islot].entry - 1;
+	entry = shard->entry + ientry;
+	value = entry->value;
+	if (retain)
+		retain(key, value, entry->cost);
+	//Promote to most recently used protected entry, demoting protected entries as needed
+	if ((entry->segment != CACHE_PROTECTED) || (shard->head[CACHE_PROTECTED] != ientry)) {
+		_cache_unlink(shard, ientry);
+		_cache_link(shard, ientry, CACHE_PROTECTED);
+		if (shard->used[CACHE_PROTECTED] > shard->protected_budget)
+			_cache_balance(cache, shard, ientry);
+	}
+
+	_cache_unlock(cache, shard);
+	return value;
+}
+
+bool
+cache_erase(cache_t* cache, hash_t key) {
+	hash_t mixed = _cache_mix(key);
+	cache_shard_t* shard = _cache_shard(cache, mixed);
+	size_t islot;
+	bool erased = false;
+
+	_cache_lock(cache, shard);
+
+	islot = _cache_slot_find(shard, key, mixed);
+	if (islot < shard->num_slots) {
+		_cache_remove(cache, shard, shard->slot[islot].entry - 1, islot);
+		erased = true;
+	}
+
+	_cache_unlock(cache, shard);
+	return erased;
+}
+
+void
+cache_clear(cache_t* cache) {
+	size_t ishard, islot;
+	for (ishard = 0; ishard < cache->num_shards; ++ishard) {
+		cache_shard_t* shard = cache->shard + ishard;
+		_cache_lock(cache, shard);
+		for (islot = 0; islot < shard->num_slots; ++islot) {
+			if (shard->slot[islot].entry && cache->evict) {
+				cache_entry_t* entry = shard->entry + (shard->slot[islot].entry - 1);
+				cache->evict(entry->key, entry->value, entry->cost);
+			}
+		}
+		memset(shard->slot, 0, sizeof(cache_slot_t) * shard->num_slots);
+		array_clear(shard->entry);
+		shard->head[CACHE_PROBATION] = shard->head[CACHE_PROTECTED] = CACHE_NIL;
+		shard->tail[CACHE_PROBATION] = shard->tail[CACHE_PROTECTED] = CACHE_NIL;
+		shard->used[CACHE_PROBATION] = shard->used[CACHE_PROTECTED] = 0;
+		shard->free = CACHE_NIL;
+		shard->count = 0;
+		_cache_unlock(cache, shard);
+	}
+}
+
+cache_statistics_t
+cache_statistics(cache_t* cache) {
+	cache_statistics_t statistics;
+	size_t ishard;
+	memset(&statistics, 0, sizeof(statistics));
+	for (ishard = 0; ishard < cache->num_shards; ++ishard) {
+		cache_shard_t* shard = cache->shard + ishard;
+		_cache_lock(cache, shard);
+		statistics.hits += shard->hits;
+		statistics.misses += shard->misses;
+		statistics.inserts += shard->inserts;
+		statistics.evictions += shard->evictions;
+		statistics.count += shard->count;
+		statistics.used += shard->used[CACHE_PROBATION] + shard->used[CACHE_PROTECTED];
+		statistics.budget += shard->budget;
+		_cache_unlock(cache, shard);
+	}
+	return statistics;
+}
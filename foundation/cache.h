@@ -0,0 +1,110 @@
+/* cache.h  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#pragma once
+
+/*! \file cache.h
+\brief Memory budgeted cache
+
+Cache mapping hash keys to values, where each value has a cost (usually its size in
+bytes) counted against a total budget. Inserting past the budget evicts entries with
+segmented LRU: entries hit at least twice are protected from a scan of entries only seen
+once. The cache owns inserted values and passes them to the eviction function whenever
+they leave the cache, whether by eviction, replacement, erase, clear or finalization.
+
+A cache created with zero shards is not thread safe. A cache created with one or more
+shards locks a shard per operation and can be accessed concurrently, with the budget
+split evenly between shards. Note that in a concurrent cache a value returned by a
+lookup can be evicted by another thread at any time once the lookup returns. Values used
+after a lookup in a concurrent cache should be reference counted, with the reference
+taken by the retain function passed to #cache_lookup_retain (called before the shard is
+unlocked) and released by the eviction function, the value being freed by whichever
+releases the last reference. */
+
+#include <foundation/platform.h>
+#include <foundation/types.h>
+
+/*! Allocate a cache. The cache should be deallocated with a call to #cache_deallocate
+\param budget Budget for the total cost of all entries
+\param shards Number of shards for concurrent access, rounded up to a power of two.
+              Zero for a single shard that is not thread safe
+\param evict Eviction function, may be null
+\return New cache */
+FOUNDATION_API cache_t*
+cache_allocate(size_t budget, size_t shards, cache_evict_fn evict);
+
+/*! Deallocate a cache previously allocated with #cache_allocate, evicting all entries
+\param cache Cache */
+FOUNDATION_API void
+cache_deallocate(cache_t* cache);
+
+/*! Initialize a cache. The cache should be finalized with a call to #cache_finalize
+\param cache Cache
+\param budget Budget for the total cost of all entries
+\param shards Number of shards for concurrent access, rounded up to a power of two.
+              Zero for a single shard that is not thread safe
+\param evict Eviction function, may be null */
+FOUNDATION_API void
+cache_initialize(cache_t* cache, size_t budget, size_t shards, cache_evict_fn evict);
+
+/*! Finalize a cache previously initialized with #cache_initialize, evicting all entries
+\param cache Cache */
+FOUNDATION_API void
+cache_finalize(cache_t* cache);
+
+/*! Insert a value, replacing any existing value for the key, and evict entries as
+needed to stay within budget. The new entry is never evicted by its own insertion.
+\param cache Cache
+\param key Key
+\param value Value, owned by the cache if inserted
+\param cost Cost of value
+\return true if inserted, false if cost exceeds the budget of a shard in which case
+        the value is not inserted and remains owned by the caller */
+FOUNDATION_API bool
+cache_insert(cache_t* cache, hash_t key, void* value, size_t cost);
+
+/*! Lookup a value, marking it as recently used. In a concurrent cache the value can be
+evicted by another thread as soon as this function returns, use #cache_lookup_retain
+to use the value safely after the lookup.
+\param cache Cache
+\param key Key
+\return Value, null if key is not in cache */
+FOUNDATION_API void*
+cache_lookup(cache_t* cache, hash_t key);
+
+/*! Lookup a value, marking it as recently used, and call the retain function for the
+value before the cache shard is unlocked. Used in concurrent caches to take a reference
+to the value that keeps it alive if it is evicted by another thread.
+\param cache Cache
+\param key Key
+\param retain Retain function, may be null
+\return Value, null if key is not in cache */
+FOUNDATION_API void*
+cache_lookup_retain(cache_t* cache, hash_t key, cache_retain_fn retain);
+
+/*! Erase a key
+\param cache Cache
+\param key Key
+\return true if key was erased, false if key was not in cache */
+FOUNDATION_API bool
+cache_erase(cache_t* cache, hash_t key);
+
+/*! Erase all keys. Statistics are kept.
+\param cache Cache */
+FOUNDATION_API void
+cache_clear(cache_t* cache);
+
+/*! Get cache statistics
+\param cache Cache
+\return Statistics summed over all shards */
+FOUNDATION_API cache_statistics_t
+cache_statistics(cache_t* cache);
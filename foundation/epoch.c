@@ -0,0 +1,69 @@
+/* epoch.c  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+#include <foundation/internal.h>
+
+//Reader counters for epoch based reclamation, shared by structures retiring memory that
+//concurrent readers may still access. Readers announce themselves in the current epoch
+//in the counter stripe of the thread, a writer advancing the epoch can reclaim memory
+//retired before the advance once the counters of the previous epoch parity are drained
+
+FOUNDATION_DECLARE_THREAD_LOCAL(uint32_t, epoch_stripe, 0)
+
+static atomic32_t _epoch_stripe_next;
+
+void
+_epoch_initialize(epoch_reader_t* readers) {
+	unsigned int istripe;
+	for (istripe = 0; istripe < EPOCH_READER_STRIPES; ++istripe) {
+		atomic_store32(&readers[istripe].count[0], 0);
+		atomic_store32(&readers[istripe].count[1], 0);
+	}
+}
+
+epoch_reader_t*
+_epoch_reader(epoch_reader_t* readers) {
+	uint32_t stripe = get_thread_epoch_stripe();
+	if (!stripe) {
+		stripe = (uint32_t)atomic_incr32(&_epoch_stripe_next);
+		set_thread_epoch_stripe(stripe);
+	}
+	return readers + (stripe % EPOCH_READER_STRIPES);
+}
+
+int32_t
+_epoch_enter(atomic32_t* epoch, epoch_reader_t* reader) {
+	//Announce the epoch, retrying if it advanced before the announcement became visible
+	while (true) {
+		int32_t current = atomic_load32(epoch);
+		atomic_incr32(&reader->count[current & 1]);
+		if (atomic_load32(epoch) == current)
+			return current;
+		atomic_decr32(&reader->count[current & 1]);
+	}
+}
+
+void
+_epoch_leave(epoch_reader_t* reader, int32_t epoch) {
+	atomic_decr32(&reader->count[epoch & 1]);
+}
+
+bool
+_epoch_drained(epoch_reader_t* readers, int32_t epoch) {
+	unsigned int istripe;
+	for (istripe = 0; istripe < EPOCH_READER_STRIPES; ++istripe) {
+		if (atomic_load32(&readers[istripe].count[epoch & 1]))
+			return false;
+	}
+	return true;
+}
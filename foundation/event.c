@@ -18,7 +18,100 @@
 
 static atomic32_t _event_serial = {1};
 
+//Payload of events posted with a payload reference
+typedef struct event_reference_t {
+	void* data;
+	size_t size;
+	event_release_fn release;
+	void* context;
+} event_reference_t;
+
+static void
+_event_release_reference(const event_t* event) {
+	const event_reference_t* reference = (const event_reference_t*)event->payload;
+	if (reference->release)
+		reference->release(reference->data, reference->size, reference->context);
+}
+
+//Grow event block in chunks until the given size fits, or as far as the limit allows
+static bool
+_event_block_grow(event_block_t* block, size_t needed, size_t limit) {
+	size_t prev_capacity = block->capacity + 16;
+	size_t capacity = block->capacity;
+	bool fits = true;
+	//Large events can span multiple chunks
+	while (needed >= capacity) {
+		if (capacity + 16 >= limit) {
+			fits = false;
+			break;
+		}
+		if (capacity + 16 < foundation_config().event_block_chunk)
+			capacity = foundation_config().event_block_chunk;
+		else
+			capacity += foundation_config().event_block_chunk;
+		if (capacity > limit)
+			capacity = limit;
+		if (capacity % 16)
+			capacity += 16 - (capacity % 16);
+		capacity -= 16;
+	}
+	if (capacity > block->capacity) {
+		block->capacity = capacity;
+		block->events = block->events ? memory_reallocate(block->events, block->capacity + 16, 16,
+		                                                  prev_capacity) :
+		                memory_allocate(0, block->capacity + 16, 16, MEMORY_PERSISTENT);
+	}
+	return fits;
+}
+
+//Remove events in given range of a pending event block
 static void
+_event_block_remove(event_block_t* block, size_t offset, size_t size) {
+	memmove(pointer_offset(block->events, offset), pointer_offset(block->events, offset + size),
+	        block->used - (offset + size));
+	block->used -= size;
+	((event_t*)pointer_offset(block->events, block->used))->id = 0;
+}
+
+//Drop oldest events until the given size fits, returning number of dropped events
+static size_t
+_event_block_drop_oldest(event_block_t* block, size_t needed) {
+	size_t offset = 0;
+	size_t count = 0;
+	while ((offset < block->used) && ((block->used - offset) + needed >= block->capacity)) {
+		event_t* event = pointer_offset(block->events, offset);
+		if (event->flags & EVENTFLAG_REFERENCE) {
+			_event_release_reference(event);
+			--block->references;
+		}
+		offset += event->size;
+		++count;
+	}
+	if (count)
+		_event_block_remove(block, 0, offset);
+	return count;
+}
+
+//Drop pending event with given id and object, returning true if found
+static bool
+_event_block_coalesce(event_block_t* block, int id, object_t object) {
+	size_t offset = 0;
+	while (offset < block->used) {
+		event_t* event = pointer_offset(block->events, offset);
+		if ((event->id == (uint16_t)id) && (event->object == object)) {
+			if (event->flags & EVENTFLAG_REFERENCE) {
+				_event_release_reference(event);
+				--block->references;
+			}
+			_event_block_remove(block, offset, event->size);
+			return true;
+		}
+		offset += event->size;
+	}
+	return false;
+}
+
+static bool
 _event_post_delay_with_flags(event_stream_t* stream, int id, object_t object,
                              tick_t timestamp, uint16_t flags, const void* payload, size_t size, va_list list) {
 	event_block_t* block;
@@ -27,16 +120,18 @@ _event_post_delay_with_flags(event_stream_t* stream, int id, object_t object,
 	size_t basesize;
 	size_t allocsize;
 	int32_t last_write;
+	size_t limit;
 	char* part;
 	void* ptr;
 	size_t psize;
 	va_list clist;
+	bool posted = false;
 
 	//Events must have non-zero id
 	FOUNDATION_ASSERT_MSG(id, "Events must have non-zero id");
 	FOUNDATION_ASSERT_MSGFORMAT(size < 0xFFFF - 16, "Events size must be less than %d", 0xFFFF - 16);
 	if (!id)
-		return;
+		return false;
 
 	//Events must be aligned to an even 8 bytes
 	basesize = sizeof(event_t) + size;
@@ -56,6 +151,9 @@ _event_post_delay_with_flags(event_stream_t* stream, int id, object_t object,
 	if (timestamp)
 		allocsize += 8;
 
+	limit = stream->limit ? stream->limit : foundation_config().event_block_limit;
+
+retry:
 	//Lock the event block by atomic swapping the write block index
 	last_write = atomic_load32(&stream->write);
 	while ((last_write < 0) || !atomic_cas32(&stream->write, EVENT_BLOCK_POSTING, last_write)) {
@@ -66,28 +164,41 @@ _event_post_delay_with_flags(event_stream_t* stream, int id, object_t object,
 	//We now have exclusive access to the event block
 	block = stream->block + last_write;
 
-	if ((block->used + allocsize + 2) >= block->capacity) {
-		size_t prev_capacity = block->capacity + 16;
-		if (prev_capacity < foundation_config().event_block_chunk) {
-			block->capacity = foundation_config().event_block_chunk;
+	while (!_event_block_grow(block, block->used + allocsize + 2, limit)) {
+		//Delayed events re-posted during processing never block, since the processing
+		//thread would wait on itself
+		if ((stream->overflow == EVENT_OVERFLOW_BLOCK) && block->used && !(flags & EVENTFLAG_DELAY)) {
+			int32_t processed = atomic_load32(&stream->processed);
+			atomic_incr32(&stream->blocked);
+			restored_block = atomic_cas32(&stream->write, last_write, EVENT_BLOCK_POSTING);
+			FOUNDATION_ASSERT(restored_block);
+			while (atomic_load32(&stream->processed) == processed) {
+				if (mutex_try_wait(stream->signal, 10))
+					mutex_unlock(stream->signal);
+			}
+			atomic_decr32(&stream->blocked);
+			goto retry;
 		}
-		else {
-			if (prev_capacity >= foundation_config().event_block_limit) {
-				FOUNDATION_ASSERT_FAILFORMAT_LOG(0, "Event block size over limit of %u bytes",
-				                                 (unsigned int)foundation_config().event_block_limit);
-				error_report(ERRORLEVEL_ERROR, ERROR_OUT_OF_MEMORY);
-				goto unlock;
+		if (stream->overflow == EVENT_OVERFLOW_DROP_OLDEST) {
+			size_t dropped = _event_block_drop_oldest(block, allocsize + 2);
+			if (dropped) {
+				atomic_add64(&stream->dropped, (int64_t)dropped);
+				continue;
 			}
-			block->capacity += foundation_config().event_block_chunk;
-			if (block->capacity > foundation_config().event_block_limit)
-				block->capacity = foundation_config().event_block_limit;
 		}
-		if (block->capacity % 16)
-			block->capacity += 16 - (basesize % 16);
-		block->capacity -= 16;
-		block->events = block->events ? memory_reallocate(block->events, block->capacity + 16, 16,
-		                                                  prev_capacity) :
-		                memory_allocate(0, block->capacity + 16, 16, MEMORY_PERSISTENT);
+		else if (stream->overflow == EVENT_OVERFLOW_COALESCE) {
+			if (_event_block_coalesce(block, id, object)) {
+				atomic_incr64(&stream->coalesced);
+				continue;
+			}
+		}
+		else if (stream->overflow == EVENT_OVERFLOW_ERROR) {
+			FOUNDATION_ASSERT_FAILFORMAT_LOG(0, "Event block size over limit of %u bytes",
+			                                 (unsigned int)limit);
+			error_report(ERRORLEVEL_ERROR, ERROR_OUT_OF_MEMORY);
+		}
+		atomic_incr64(&stream->dropped);
+		goto unlock;
 	}
 
 	event = pointer_offset(block->events, block->used);
@@ -117,6 +228,8 @@ _event_post_delay_with_flags(event_stream_t* stream, int id, object_t object,
 		event->flags |= EVENTFLAG_DELAY;
 		*(tick_t*)pointer_offset(event, basesize) = timestamp;
 	}
+	if (flags & EVENTFLAG_REFERENCE)
+		++block->references;
 
 	//Terminate with null id on next event
 	block->used += allocsize;
@@ -127,16 +240,41 @@ _event_post_delay_with_flags(event_stream_t* stream, int id, object_t object,
 		beacon_fire(stream->beacon);
 		block->fired = true;
 	}
+	posted = true;
 
 unlock:
 	//Now unlock the event block
 	restored_block = atomic_cas32(&stream->write, last_write, EVENT_BLOCK_POSTING);
 	FOUNDATION_ASSERT(restored_block);
+	return posted;
+}
+
+//Release payload references of events in a processed block, only called from processing thread
+static void
+_event_block_release(event_block_t* block) {
+	event_t* event = block->used ? block->events : nullptr;
+	if (!block->references)
+		return;
+	while (event && event->id) {
+		if (event->flags & EVENTFLAG_REFERENCE)
+			_event_release_reference(event);
+		event = pointer_offset(event, event->size);
+	}
+	block->references = 0;
+}
+
+void*
+event_payload(const event_t* event) {
+	if (event->flags & EVENTFLAG_REFERENCE)
+		return ((const event_reference_t*)event->payload)->data;
+	return (void*)(uintptr_t)event->payload;
 }
 
 size_t
 event_payload_size(const event_t* event) {
 	size_t size = event->size;
+	if (event->flags & EVENTFLAG_REFERENCE)
+		return ((const event_reference_t*)event->payload)->size;
 	size -= sizeof(event_t);
 	if (event->flags & EVENTFLAG_DELAY)
 		size -= 8;
@@ -164,13 +302,24 @@ event_post_vlist(event_stream_t* stream, int id, object_t object, tick_t deliver
 	_event_post_delay_with_flags(stream, id, object, delivery, 0, payload, size, list);
 }
 
-static void
+static bool
 event_post_varg_flags(event_stream_t* stream, int id, object_t object,
                       tick_t delivery, uint16_t flags, const void* payload, size_t size, ...) {
+	bool posted;
 	va_list list;
 	va_start(list, size);
-	_event_post_delay_with_flags(stream, id, object, delivery, flags, payload, size, list);
+	posted = _event_post_delay_with_flags(stream, id, object, delivery, flags, payload, size, list);
 	va_end(list);
+	return posted;
+}
+
+void
+event_post_reference(event_stream_t* stream, int id, object_t object, tick_t delivery,
+                     void* data, size_t size, event_release_fn release, void* context) {
+	event_reference_t reference = {data, size, release, context};
+	if (!event_post_varg_flags(stream, id, object, delivery, EVENTFLAG_REFERENCE,
+	                           &reference, sizeof(reference), nullptr) && release)
+		release(data, size, context);
 }
 
 event_t* event_next(const event_block_t* block, event_t* event) {
@@ -193,9 +342,10 @@ event_t* event_next(const event_block_t* block, event_t* event) {
 		if (eventtime <= curtime)
 			return event;
 
-		//Re-post to next block
-		event_post_varg_flags(block->stream, event->id, event->object, eventtime, event->flags,
-		                      event->payload, event->size - (sizeof(event_t) + 8), nullptr);
+		//Re-post to next block, moving any payload reference along with the event
+		if (event_post_varg_flags(block->stream, event->id, event->object, eventtime, event->flags,
+		                          event->payload, event->size - (sizeof(event_t) + 8), nullptr))
+			event->flags &= (uint16_t)~EVENTFLAG_REFERENCE;
 	}
 	
 	return nullptr;
@@ -228,6 +378,17 @@ event_stream_initialize(event_stream_t* stream, size_t size) {
 	stream->block[0].capacity = size;
 	stream->block[1].capacity = size;
 
+	stream->block[0].references = 0;
+	stream->block[1].references = 0;
+
+	stream->limit = 0;
+	stream->overflow = EVENT_OVERFLOW_ERROR;
+	stream->signal = nullptr;
+	atomic_store32(&stream->processed, 0);
+	atomic_store32(&stream->blocked, 0);
+	atomic_store64(&stream->dropped, 0);
+	atomic_store64(&stream->coalesced, 0);
+
 	stream->block[0].stream = stream;
 	stream->block[1].stream = stream;
 
@@ -245,10 +406,15 @@ event_stream_deallocate(event_stream_t* stream) {
 
 void
 event_stream_finalize(event_stream_t* stream) {
+	_event_block_release(stream->block + 0);
+	_event_block_release(stream->block + 1);
 	if (stream->block[0].events)
 		memory_deallocate(stream->block[0].events);
 	if (stream->block[1].events)
 		memory_deallocate(stream->block[1].events);
+	if (stream->signal)
+		mutex_deallocate(stream->signal);
+	stream->signal = nullptr;
 }
 
 event_block_t*
@@ -260,6 +426,9 @@ event_stream_process(event_stream_t* stream) {
 	if (!stream)
 		return 0;
 
+	//Previous read block is done processing, and is not touched by posting threads
+	_event_block_release(stream->block + stream->read);
+
 	//Lock the write event block by atomic swapping the write block index
 	last_write = atomic_load32(&stream->write);
 	while ((last_write < 0) || !atomic_cas32(&stream->write, EVENT_BLOCK_SWAPPING, last_write)) {
@@ -281,12 +450,402 @@ event_stream_process(event_stream_t* stream) {
 	restored_block = atomic_cas32(&stream->write, new_write, EVENT_BLOCK_SWAPPING);
 	FOUNDATION_ASSERT(restored_block);
 
+	//Wake up posting threads blocked on a full event block
+	atomic_incr32(&stream->processed);
+	if (atomic_load32(&stream->blocked))
+		mutex_signal(stream->signal);
+
 	return block;
 }
 
+void
+event_stream_set_overflow(event_stream_t* stream, size_t limit, event_overflow_t policy) {
+	if ((policy == EVENT_OVERFLOW_BLOCK) && !stream->signal)
+		stream->signal = mutex_allocate(STRING_CONST("event_stream"));
+	stream->limit = limit;
+	stream->overflow = policy;
+}
+
+uint64_t
+event_stream_dropped(const event_stream_t* stream) {
+	return (uint64_t)atomic_load64(&stream->dropped);
+}
+
+uint64_t
+event_stream_coalesced(const event_stream_t* stream) {
+	return (uint64_t)atomic_load64(&stream->coalesced);
+}
+
 void
 event_stream_set_beacon(event_stream_t* stream, beacon_t* beacon) {
 	stream->beacon = beacon;
 	if (beacon && (atomic_load32(&stream->write) > 0))
 		beacon_fire(beacon);
 }
+
+//Event block in a broadcast stream. Holds records of a subscriber mask followed by the
+//event, and is released once all subscribers and the previous block have released it
+struct event_broadcast_block_t {
+	atomic32_t ref;
+	event_broadcast_block_t* next;
+	size_t used;
+	size_t capacity;
+	size_t references;
+	uint64_t data[FOUNDATION_FLEXIBLE_ARRAY];
+};
+
+#define EVENT_RECORD_MASK(block, offset) (*(uint64_t*)pointer_offset((block)->data, (offset)))
+#define EVENT_RECORD_EVENT(block, offset) ((event_t*)pointer_offset((block)->data, (offset) + 8))
+
+static event_broadcast_block_t*
+_event_broadcast_block_allocate(size_t capacity, int32_t ref) {
+	event_broadcast_block_t* block;
+	if (capacity < foundation_config().event_block_chunk)
+		capacity = foundation_config().event_block_chunk;
+	block = memory_allocate(0, sizeof(event_broadcast_block_t) + capacity, 16, MEMORY_PERSISTENT);
+	atomic_store32(&block->ref, ref);
+	block->next = nullptr;
+	block->used = 0;
+	block->capacity = capacity;
+	block->references = 0;
+	return block;
+}
+
+static void
+_event_broadcast_block_release(event_broadcast_block_t* block) {
+	while (block && (atomic_decr32(&block->ref) == 0)) {
+		event_broadcast_block_t* next = block->next;
+		size_t offset = 0;
+		while (block->references && (offset < block->used)) {
+			event_t* event = EVENT_RECORD_EVENT(block, offset);
+			if (event->flags & EVENTFLAG_REFERENCE) {
+				_event_release_reference(event);
+				--block->references;
+			}
+			offset += 8 + event->size;
+		}
+		memory_deallocate(block);
+		block = next;
+	}
+}
+
+static void
+_event_broadcast_lock(event_broadcast_t* broadcast) {
+	while (!atomic_cas32(&broadcast->lock, 1, 0))
+		thread_yield();
+}
+
+static void
+_event_broadcast_unlock(event_broadcast_t* broadcast) {
+	atomic_thread_fence_release();
+	atomic_store32(&broadcast->lock, 0);
+}
+
+//Close write block for posting and start a new block, must be called with lock held.
+//Returns the closed block, which must be released once the lock is released
+static event_broadcast_block_t*
+_event_broadcast_seal(event_broadcast_t* broadcast, size_t capacity) {
+	event_broadcast_block_t* block = broadcast->write;
+	//New block is referenced by the stream and the closed block
+	block->next = _event_broadcast_block_allocate(capacity, 2);
+	broadcast->write = block->next;
+	return block;
+}
+
+static size_t
+_event_broadcast_filter_find(const event_broadcast_t* broadcast, unsigned int id) {
+	size_t low = 0;
+	size_t high = array_size(broadcast->filter);
+	while (low < high) {
+		size_t mid = (low + high) / 2;
+		if (broadcast->filter[mid].id < id)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+static bool
+_event_broadcast_post(event_broadcast_t* broadcast, int id, object_t object, uint16_t flags,
+                      const void* payload, size_t size) {
+	event_broadcast_block_t* sealed = nullptr;
+	event_broadcast_block_t* block;
+	event_t* event;
+	size_t eventsize, recordsize, ifilter;
+	uint64_t mask, fire;
+
+	FOUNDATION_ASSERT_MSG(id, "Events must have non-zero id");
+	FOUNDATION_ASSERT_MSGFORMAT(size < 0xFFFF - 16, "Events size must be less than %d", 0xFFFF - 16);
+	if (!id || (size >= 0xFFFF - 16))
+		return false;
+
+	//Events must be aligned to an even 8 bytes, records have an extra 8 bytes subscriber mask
+	eventsize = sizeof(event_t) + size;
+	if (eventsize % 8)
+		eventsize += 8 - (eventsize % 8);
+	recordsize = 8 + eventsize;
+
+	_event_broadcast_lock(broadcast);
+
+	//Filters are evaluated once, events with no subscribers are not stored
+	mask = broadcast->all;
+	ifilter = _event_broadcast_filter_find(broadcast, (unsigned int)id);
+	if ((ifilter < array_size(broadcast->filter)) && (broadcast->filter[ifilter].id == (unsigned int)id))
+		mask |= broadcast->filter[ifilter].mask;
+	if (!mask) {
+		_event_broadcast_unlock(broadcast);
+		return false;
+	}
+
+	block = broadcast->write;
+	if (block->used + recordsize > block->capacity) {
+		//Subscribers may be reading the block, so start a new block instead of growing it
+		sealed = _event_broadcast_seal(broadcast, recordsize);
+		block = broadcast->write;
+	}
+
+	EVENT_RECORD_MASK(block, block->used) = mask;
+	event = EVENT_RECORD_EVENT(block, block->used);
+	event->id     = (uint16_t)id;
+	event->serial = (uint16_t)(atomic_exchange_and_add32(&_event_serial, 1) & 0xFFFF);
+	event->size   = (uint16_t)eventsize;
+	event->flags  = flags;
+	event->object = object;
+	if (size)
+		memcpy(event->payload, payload, size);
+	if (flags & EVENTFLAG_REFERENCE)
+		++block->references;
+	block->used += recordsize;
+
+	fire = mask & broadcast->beacons;
+	broadcast->beacons &= ~fire;
+	while (fire) {
+		unsigned int isub = bits_ctz64(fire);
+		beacon_fire(broadcast->subscriber[isub].beacon);
+		fire &= fire - 1;
+	}
+
+	_event_broadcast_unlock(broadcast);
+
+	_event_broadcast_block_release(sealed);
+	return true;
+}
+
+event_broadcast_t*
+event_broadcast_allocate(void) {
+	event_broadcast_t* broadcast = memory_allocate(0, sizeof(event_broadcast_t), 0, MEMORY_PERSISTENT);
+	event_broadcast_initialize(broadcast);
+	return broadcast;
+}
+
+void
+event_broadcast_deallocate(event_broadcast_t* broadcast) {
+	if (!broadcast)
+		return;
+	event_broadcast_finalize(broadcast);
+	memory_deallocate(broadcast);
+}
+
+void
+event_broadcast_initialize(event_broadcast_t* broadcast) {
+	memset(broadcast, 0, sizeof(event_broadcast_t));
+	broadcast->write = _event_broadcast_block_allocate(0, 1);
+}
+
+void
+event_broadcast_finalize(event_broadcast_t* broadcast) {
+	size_t isub;
+	for (isub = 0; isub < EVENT_BROADCAST_MAX_SUBSCRIBERS; ++isub) {
+		if (broadcast->subscriber[isub].broadcast)
+			event_broadcast_unsubscribe(broadcast->subscriber + isub);
+	}
+	_event_broadcast_block_release(broadcast->write);
+	broadcast->write = nullptr;
+	array_deallocate(broadcast->filter);
+}
+
+void
+event_broadcast_post(event_broadcast_t* broadcast, int id, object_t object,
+                     const void* payload, size_t size) {
+	_event_broadcast_post(broadcast, id, object, 0, payload, size);
+}
+
+void
+event_broadcast_post_reference(event_broadcast_t* broadcast, int id, object_t object,
+                               void* data, size_t size, event_release_fn release, void* context) {
+	event_reference_t reference = {data, size, release, context};
+	if (!_event_broadcast_post(broadcast, id, object, EVENTFLAG_REFERENCE,
+	                           &reference, sizeof(reference)) && release)
+		release(data, size, context);
+}
+
+event_subscriber_t*
+event_broadcast_subscribe(event_broadcast_t* broadcast, const int* ids, size_t count) {
+	event_broadcast_block_t* sealed = nullptr;
+	event_subscriber_t* subscriber;
+	size_t isub, iid, ifilter;
+	uint64_t mask;
+
+	_event_broadcast_lock(broadcast);
+
+	if (broadcast->active == (uint64_t)-1) {
+		_event_broadcast_unlock(broadcast);
+		log_errorf(0, ERROR_OUT_OF_MEMORY, STRING_CONST("Broadcast event stream subscriber limit of %d reached"),
+		           EVENT_BROADCAST_MAX_SUBSCRIBERS);
+		return nullptr;
+	}
+	isub = bits_ctz64(~broadcast->active);
+	mask = (uint64_t)1 << isub;
+
+	//Start at a new block so events posted before subscribing are never seen
+	if (broadcast->write->used)
+		sealed = _event_broadcast_seal(broadcast, 0);
+
+	subscriber = broadcast->subscriber + isub;
+	subscriber->broadcast = broadcast;
+	subscriber->mask = mask;
+	subscriber->cursor = broadcast->write;
+	subscriber->end = nullptr;
+	subscriber->current = nullptr;
+	subscriber->beacon = nullptr;
+	atomic_incr32(&subscriber->cursor->ref);
+
+	if (!ids) {
+		broadcast->all |= mask;
+	}
+	else {
+		for (iid = 0; iid < count; ++iid) {
+			event_filter_t filter = {(unsigned int)ids[iid], mask};
+			ifilter = _event_broadcast_filter_find(broadcast, filter.id);
+			if ((ifilter < array_size(broadcast->filter)) && (broadcast->filter[ifilter].id == filter.id))
+				broadcast->filter[ifilter].mask |= mask;
+			else
+				array_insert_memcpy_safe(broadcast->filter, ifilter, &filter);
+		}
+	}
+	broadcast->active |= mask;
+
+	_event_broadcast_unlock(broadcast);
+
+	_event_broadcast_block_release(sealed);
+	return subscriber;
+}
+
+void
+event_broadcast_unsubscribe(event_subscriber_t* subscriber) {
+	event_broadcast_t* broadcast = subscriber->broadcast;
+	event_broadcast_block_t* cursor;
+	size_t ifilter;
+
+	if (!broadcast)
+		return;
+
+	_event_broadcast_lock(broadcast);
+
+	broadcast->active &= ~subscriber->mask;
+	broadcast->all &= ~subscriber->mask;
+	broadcast->beacons &= ~subscriber->mask;
+	for (ifilter = 0; ifilter < array_size(broadcast->filter);) {
+		broadcast->filter[ifilter].mask &= ~subscriber->mask;
+		if (!broadcast->filter[ifilter].mask)
+			array_erase_ordered(broadcast->filter, ifilter);
+		else
+			++ifilter;
+	}
+	cursor = subscriber->cursor;
+	subscriber->broadcast = nullptr;
+	subscriber->cursor = nullptr;
+	subscriber->end = nullptr;
+	subscriber->current = nullptr;
+	subscriber->beacon = nullptr;
+
+	_event_broadcast_unlock(broadcast);
+
+	//Releasing the cursor releases all blocks not referenced by other subscribers
+	_event_broadcast_block_release(cursor);
+}
+
+void
+event_subscriber_process(event_subscriber_t* subscriber) {
+	event_broadcast_t* broadcast = subscriber->broadcast;
+	event_broadcast_block_t* sealed = nullptr;
+	event_broadcast_block_t* block;
+
+	if (!broadcast)
+		return;
+
+	//Release blocks processed in previous pass, the block following them is kept
+	//alive by the last processed block until a reference has been acquired
+	if (subscriber->end) {
+		block = subscriber->cursor;
+		subscriber->cursor = subscriber->end->next;
+		atomic_incr32(&subscriber->cursor->ref);
+		_event_broadcast_block_release(block);
+	}
+	subscriber->end = nullptr;
+	subscriber->current = nullptr;
+
+	_event_broadcast_lock(broadcast);
+
+	if (broadcast->write->used)
+		sealed = _event_broadcast_seal(broadcast, 0);
+	if (subscriber->cursor != broadcast->write) {
+		//All blocks from the cursor up to the write block are closed for posting
+		for (block = subscriber->cursor; block->next != broadcast->write; block = block->next);
+		subscriber->end = block;
+	}
+	if (subscriber->beacon)
+		broadcast->beacons |= subscriber->mask;
+
+	_event_broadcast_unlock(broadcast);
+
+	_event_broadcast_block_release(sealed);
+}
+
+event_t*
+event_subscriber_next(event_subscriber_t* subscriber, event_t* event) {
+	event_broadcast_block_t* block;
+	size_t offset;
+
+	if (!event) {
+		block = subscriber->end ? subscriber->cursor : nullptr;
+		offset = 0;
+	}
+	else {
+		block = subscriber->current;
+		offset = (size_t)pointer_diff(event, block->data) + event->size;
+	}
+
+	while (block) {
+		while (offset < block->used) {
+			event = EVENT_RECORD_EVENT(block, offset);
+			if (EVENT_RECORD_MASK(block, offset) & subscriber->mask) {
+				subscriber->current = block;
+				return event;
+			}
+			offset += 8 + event->size;
+		}
+		if (block == subscriber->end)
+			break;
+		block = block->next;
+		offset = 0;
+	}
+
+	subscriber->current = nullptr;
+	return nullptr;
+}
+
+void
+event_subscriber_set_beacon(event_subscriber_t* subscriber, beacon_t* beacon) {
+	event_broadcast_t* broadcast = subscriber->broadcast;
+	if (!broadcast)
+		return;
+	_event_broadcast_lock(broadcast);
+	subscriber->beacon = beacon;
+	if (beacon)
+		broadcast->beacons |= subscriber->mask;
+	else
+		broadcast->beacons &= ~subscriber->mask;
+	_event_broadcast_unlock(broadcast);
+}
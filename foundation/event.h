@@ -33,6 +33,25 @@ Delayed events will not be delivered for processing until the delivery timestamp
 Delivery is not guaranteed until next pass of <code>event_stream_process</code> and
 <code>event_next</code> iteration.
 
+Event payloads are copied into the event block when posted, and are limited in size.
+Large payloads can be posted as references to data which is not copied, together with a
+release function called once the event block holding the event has been processed, that is
+on the next call to <code>event_stream_process</code> or when the stream is finalized.
+
+Event streams have a single reader. Broadcast event streams deliver events to multiple
+subscribers, each subscriber receiving either all events or events with a given set of ids.
+Subscriptions are evaluated once when an event is posted, and each event is stored once in
+event blocks shared by all subscribers. Each subscriber has a read cursor over the shared
+blocks, and a block is released once all subscribers have processed it. Broadcast events
+are delivered immediately, delayed delivery is not supported.
+
+Pending event blocks grow up to a size limit. The overflow policy of the stream controls
+what happens when a posted event does not fit: report an error, block the posting thread
+until the stream is processed, drop the oldest or the newest events, or coalesce the event
+with a pending event with the same id and object. Delayed events re-posted during processing
+never block and are dropped instead. Release functions of dropped reference events are
+called from the posting thread.
+
 Event posting is thread safe. Event processing is not thread safe and must be contained
 to a single thread. */
 
@@ -80,6 +99,25 @@ FOUNDATION_API void
 event_post_vlist(event_stream_t* stream, int id, object_t object, tick_t delivery,
                  const void* payload, size_t size, va_list list);
 
+/*! Post event to stream with a reference to payload data, which is not copied. The data
+must stay valid until the release function is called, which happens on the processing
+thread once the event block holding the event has been processed (on the next call to
+#event_stream_process), or when the stream is finalized. If the event could not be posted
+the release function is called immediately. Delayed events keep the reference until
+delivered and processed. This operation is thread-safe and will spin loop until operation
+can be completed if in contention with another thread.
+\param stream    Event stream
+\param id        Event id
+\param object    Sender
+\param delivery  Delivery time, 0 for immediate delivery
+\param data      Event payload data
+\param size      Event payload size, not limited in size
+\param release   Release function, may be null
+\param context   Context passed to release function */
+FOUNDATION_API void
+event_post_reference(event_stream_t* stream, int id, object_t object, tick_t delivery,
+                     void* data, size_t size, event_release_fn release, void* context);
+
 /*! Get next event during procesing
 \param block Event block
 \param event Previous event, pass in 0 for getting first event
@@ -87,8 +125,16 @@ event_post_vlist(event_stream_t* stream, int id, object_t object, tick_t deliver
 FOUNDATION_API event_t*
 event_next(const event_block_t* block, event_t* event);
 
+/*! Get event payload data, either the payload stored in the event or the referenced
+data for events posted with #event_post_reference
+\param event Event
+\return      Payload data */
+FOUNDATION_API void*
+event_payload(const event_t* event);
+
 /*! Get event actual payload size (size field in event struct may be padded and extended
-for internal data)
+for internal data). For events posted with #event_post_reference this is the size of
+the referenced data
 \param event Event
 \return      Payload in bytes */
 FOUNDATION_API size_t
@@ -129,3 +175,114 @@ event_stream_process(event_stream_t* stream);
 \param beacon Beacon to fire */
 FOUNDATION_API void
 event_stream_set_beacon(event_stream_t* stream, beacon_t* beacon);
+
+/*! Set size limit of event blocks and policy when the limit is reached. Must be called
+before any events are posted to the stream. A blocking policy must not be used if events
+are posted from the thread processing the stream.
+\param stream Event stream
+\param limit  Size limit of event blocks in bytes, 0 for limit in foundation configuration
+\param policy Overflow policy */
+FOUNDATION_API void
+event_stream_set_overflow(event_stream_t* stream, size_t limit, event_overflow_t policy);
+
+/*! Get number of events dropped due to a full event block
+\param stream Event stream
+\return       Number of dropped events */
+FOUNDATION_API uint64_t
+event_stream_dropped(const event_stream_t* stream);
+
+/*! Get number of pending events replaced by a newer event with same id and object due to
+a full event block
+\param stream Event stream
+\return       Number of coalesced events */
+FOUNDATION_API uint64_t
+event_stream_coalesced(const event_stream_t* stream);
+
+/*! Allocate a broadcast event stream. Use #event_broadcast_deallocate to deallocate the
+returned stream.
+\return Broadcast event stream */
+FOUNDATION_API event_broadcast_t*
+event_broadcast_allocate(void);
+
+/*! Deallocate a broadcast event stream which was allocated by #event_broadcast_allocate,
+unsubscribing all remaining subscribers
+\param broadcast Broadcast event stream */
+FOUNDATION_API void
+event_broadcast_deallocate(event_broadcast_t* broadcast);
+
+/*! Initialize a broadcast event stream. Use #event_broadcast_finalize to finalize
+the stream.
+\param broadcast Broadcast event stream */
+FOUNDATION_API void
+event_broadcast_initialize(event_broadcast_t* broadcast);
+
+/*! Finalize a broadcast event stream which was initialized by #event_broadcast_initialize,
+unsubscribing all remaining subscribers and freeing resources.
+\param broadcast Broadcast event stream */
+FOUNDATION_API void
+event_broadcast_finalize(event_broadcast_t* broadcast);
+
+/*! Post event to all subscribers of a broadcast event stream receiving the event id.
+The event is stored once, and not stored at all if no subscriber receives the event id.
+This operation is thread-safe.
+\param broadcast Broadcast event stream
+\param id        Event id
+\param object    Sender
+\param payload   Event payload
+\param size      Event payload size */
+FOUNDATION_API void
+event_broadcast_post(event_broadcast_t* broadcast, int id, object_t object,
+                     const void* payload, size_t size);
+
+/*! Post event with a reference to payload data to all subscribers of a broadcast event
+stream receiving the event id, see #event_post_reference. The release function is called
+once all subscribers have processed the event, on the thread releasing the event block,
+or immediately if no subscriber receives the event id. This operation is thread-safe.
+\param broadcast Broadcast event stream
+\param id        Event id
+\param object    Sender
+\param data      Event payload data
+\param size      Event payload size
+\param release   Release function, may be null
+\param context   Context passed to release function */
+FOUNDATION_API void
+event_broadcast_post_reference(event_broadcast_t* broadcast, int id, object_t object,
+                               void* data, size_t size, event_release_fn release, void* context);
+
+/*! Subscribe to events in a broadcast event stream. The subscriber receives events posted
+after this call with any of the given event ids, or all events if the ids are null.
+At most #EVENT_BROADCAST_MAX_SUBSCRIBERS subscribers can be active at the same time.
+This operation is thread-safe.
+\param broadcast Broadcast event stream
+\param ids       Event ids to receive, null to receive all events
+\param count     Number of event ids
+\return          Subscriber, null if subscriber limit reached */
+FOUNDATION_API event_subscriber_t*
+event_broadcast_subscribe(event_broadcast_t* broadcast, const int* ids, size_t count);
+
+/*! Unsubscribe from a broadcast event stream, releasing all event blocks not yet
+processed by the subscriber. Must not be called concurrently with processing of the
+subscriber.
+\param subscriber Subscriber */
+FOUNDATION_API void
+event_broadcast_unsubscribe(event_subscriber_t* subscriber);
+
+/*! Release events processed in the previous pass and grab events posted since then for
+processing with #event_subscriber_next. Processing for a subscriber must only occur on one
+single thread at any given moment, but different subscribers can be processed concurrently.
+\param subscriber Subscriber */
+FOUNDATION_API void
+event_subscriber_process(event_subscriber_t* subscriber);
+
+/*! Get next event for subscriber during processing
+\param subscriber Subscriber
+\param event      Previous event, pass in 0 for getting first event
+\return           Next event */
+FOUNDATION_API event_t*
+event_subscriber_next(event_subscriber_t* subscriber, event_t* event);
+
+/*! Set beacon to fire when an event received by the subscriber is posted
+\param subscriber Subscriber
+\param beacon     Beacon to fire */
+FOUNDATION_API void
+event_subscriber_set_beacon(event_subscriber_t* subscriber, beacon_t* beacon);
@@ -0,0 +1,544 @@
+/* filter.c  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+
+#define BLOOMFILTER_MAGIC      0x424c4f4dU
+#define BLOOMFILTER_WORDS      8
+#define BLOOMFILTER_BLOCKSIZE  (BLOOMFILTER_WORDS * sizeof(uint32_t))
+
+#define CUCKOOFILTER_MAGIC     0x43554b4fU
+#define CUCKOOFILTER_SLOTS     4
+#define CUCKOOFILTER_LOAD      0.95
+#define CUCKOOFILTER_MAXKICKS  500
+#define CUCKOOFILTER_LANES     0x0001000100010001ULL
+#define CUCKOOFILTER_HIGHBITS  0x8000800080008000ULL
+
+//Number of keys ahead of the probing key that have their block prefetched in batch queries
+#define FILTER_BATCH_DISTANCE  8
+
+#if FOUNDATION_COMPILER_GCC || FOUNDATION_COMPILER_CLANG
+#  define FILTER_PREFETCH(addr) __builtin_prefetch((addr), 0, 3)
+#elif FOUNDATION_ARCH_SSE2
+#  define FILTER_PREFETCH(addr) _mm_prefetch((const char*)(addr), _MM_HINT_T0)
+#else
+#  define FILTER_PREFETCH(addr) do { FOUNDATION_UNUSED(addr); } while (0)
+#endif
+
+//Odd multipliers selecting one bit in each word of a block from the low 32 bits of the hash
+FOUNDATION_ALIGN(16) static const uint32_t _bloomfilter_salt[BLOOMFILTER_WORDS] = {
+	0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+	0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+};
+
+static FOUNDATION_FORCEINLINE size_t
+_bloomfilter_block(const bloomfilter_t* filter, hash_t key) {
+	//Map the high 32 bits of the hash to the block range without a division
+	return (size_t)(((key >> 32) * (uint64_t)filter->num_blocks) >> 32);
+}
+
+#if FOUNDATION_ARCH_SSE2
+
+static FOUNDATION_FORCEINLINE __m128i
+_bloomfilter_mullo(__m128i a, __m128i b) {
+	//SSE2 has no 32-bit low multiply, combine even and odd lane products
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+	                          _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static FOUNDATION_FORCEINLINE __m128i
+_bloomfilter_mask(__m128i key, const uint32_t* salt) {
+	//Bit index in top five bits, turned into 1 << index by building the float 2^index
+	//and truncating it. The out of range result for 2^31 is 0x80000000 as required
+	__m128i index = _mm_srli_epi32(_bloomfilter_mullo(key, _mm_load_si128((const __m128i*)salt)), 27);
+	__m128i exponent = _mm_add_epi32(_mm_slli_epi32(index, 23), _mm_set1_epi32(0x3F800000));
+	return _mm_cvttps_epi32(_mm_castsi128_ps(exponent));
+}
+
+static FOUNDATION_FORCEINLINE void
+_bloomfilter_set(uint32_t* block, hash_t key) {
+	__m128i key32 = _mm_set1_epi32((int)(uint32_t)key);
+	__m128i* words = (__m128i*)block;
+	_mm_store_si128(words, _mm_or_si128(_mm_load_si128(words), _bloomfilter_mask(key32, _bloomfilter_salt)));
+	_mm_store_si128(words + 1, _mm_or_si128(_mm_load_si128(words + 1),
+	                                        _bloomfilter_mask(key32, _bloomfilter_salt + 4)));
+}
+
+static FOUNDATION_FORCEINLINE bool
+_bloomfilter_test(const uint32_t* block, hash_t key) {
+	__m128i key32 = _mm_set1_epi32((int)(uint32_t)key);
+	const __m128i* words = (const __m128i*)block;
+	__m128i missing = _mm_or_si128(
+	    _mm_andnot_si128(_mm_load_si128(words), _bloomfilter_mask(key32, _bloomfilter_salt)),
+	    _mm_andnot_si128(_mm_load_si128(words + 1), _bloomfilter_mask(key32, _bloomfilter_salt + 4)));
+	return _mm_movemask_epi8(_mm_cmpeq_epi32(missing, _mm_setzero_si128())) == 0xFFFF;
+}
+
+#elif FOUNDATION_ARCH_NEON
+
+static FOUNDATION_FORCEINLINE uint32x4_t
+_bloomfilter_mask(uint32x4_t key, const uint32_t* salt) {
+	uint32x4_t index = vshrq_n_u32(vmulq_u32(key, vld1q_u32(salt)), 27);
+	return vshlq_u32(vdupq_n_u32(1), vreinterpretq_s32_u32(index));
+}
+
+static FOUNDATION_FORCEINLINE void
+_bloomfilter_set(uint32_t* block, hash_t key) {
+	uint32x4_t key32 = vdupq_n_u32((uint32_t)key);
+	vst1q_u32(block, vorrq_u32(vld1q_u32(block), _bloomfilter_mask(key32, _bloomfilter_salt)));
+	vst1q_u32(block + 4, vorrq_u32(vld1q_u32(block + 4), _bloomfilter_mask(key32, _bloomfilter_salt + 4)));
+}
+
+static FOUNDATION_FORCEINLINE bool
+_bloomfilter_test(const uint32_t* block, hash_t key) {
+	uint32x4_t key32 = vdupq_n_u32((uint32_t)key);
+	uint64x2_t missing = vreinterpretq_u64_u32(vorrq_u32(
+	    vbicq_u32(_bloomfilter_mask(key32, _bloomfilter_salt), vld1q_u32(block)),
+	    vbicq_u32(_bloomfilter_mask(key32, _bloomfilter_salt + 4), vld1q_u32(block + 4))));
+	return !(vgetq_lane_u64(missing, 0) | vgetq_lane_u64(missing, 1));
+}
+
+#else
+
+static FOUNDATION_FORCEINLINE void
+_bloomfilter_set(uint32_t* block, hash_t key) {
+	unsigned int iword;
+	for (iword = 0; iword < BLOOMFILTER_WORDS; ++iword)
+		block[iword] |= 1U << (((uint32_t)key * _bloomfilter_salt[iword]) >> 27);
+}
+
+static FOUNDATION_FORCEINLINE bool
+_bloomfilter_test(const uint32_t* block, hash_t key) {
+	uint32_t missing = 0;
+	unsigned int iword;
+	for (iword = 0; iword < BLOOMFILTER_WORDS; ++iword)
+		missing |= ~block[iword] & (1U << (((uint32_t)key * _bloomfilter_salt[iword]) >> 27));
+	return !missing;
+}
+
+#endif
+
+static void
+_filter_write_words32(stream_t* stream, const uint32_t* words, size_t count) {
+	size_t iword;
+	if (stream_is_binary(stream) && !stream_is_swapped(stream)) {
+		stream_write(stream, words, count * sizeof(uint32_t));
+		return;
+	}
+	for (iword = 0; iword < count; ++iword) {
+		stream_write_uint32(stream, words[iword]);
+		stream_write_separator(stream);
+	}
+}
+
+static bool
+_filter_read_words32(stream_t* stream, uint32_t* words, size_t count) {
+	size_t iword;
+	if (stream_is_binary(stream) && !stream_is_swapped(stream))
+		return stream_read(stream, words, count * sizeof(uint32_t)) == count * sizeof(uint32_t);
+	for (iword = 0; (iword < count) && !stream_eos(stream); ++iword)
+		words[iword] = stream_read_uint32(stream);
+	return iword == count;
+}
+
+static void
+_filter_write_words64(stream_t* stream, const uint64_t* words, size_t count) {
+	size_t iword;
+	if (stream_is_binary(stream) && !stream_is_swapped(stream)) {
+		stream_write(stream, words, count * sizeof(uint64_t));
+		return;
+	}
+	for (iword = 0; iword < count; ++iword) {
+		stream_write_uint64(stream, words[iword]);
+		stream_write_separator(stream);
+	}
+}
+
+static bool
+_filter_read_words64(stream_t* stream, uint64_t* words, size_t count) {
+	size_t iword;
+	if (stream_is_binary(stream) && !stream_is_swapped(stream))
+		return stream_read(stream, words, count * sizeof(uint64_t)) == count * sizeof(uint64_t);
+	for (iword = 0; (iword < count) && !stream_eos(stream); ++iword)
+		words[iword] = stream_read_uint64(stream);
+	return iword == count;
+}
+
+static void
+_bloomfilter_allocate_blocks(bloomfilter_t* filter, size_t num_blocks) {
+	FOUNDATION_ASSERT_MSG(num_blocks <= 0xFFFFFFFFULL, "Bloom filter too large");
+	filter->num_blocks = num_blocks;
+	//Cache line aligned so no block straddles two lines
+	filter->block = memory_allocate(0, num_blocks * BLOOMFILTER_BLOCKSIZE, 64,
+	                                MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+}
+
+bloomfilter_t*
+bloomfilter_allocate(size_t capacity, size_t bits_per_key) {
+	bloomfilter_t* filter = memory_allocate(0, sizeof(bloomfilter_t), 0, MEMORY_PERSISTENT);
+	bloomfilter_initialize(filter, capacity, bits_per_key);
+	return filter;
+}
+
+void
+bloomfilter_deallocate(bloomfilter_t* filter) {
+	bloomfilter_finalize(filter);
+	memory_deallocate(filter);
+}
+
+void
+bloomfilter_initialize(bloomfilter_t* filter, size_t capacity, size_t bits_per_key) {
+	size_t bits = capacity * bits_per_key;
+	size_t num_blocks = (bits + (BLOOMFILTER_BLOCKSIZE * 8) - 1) / (BLOOMFILTER_BLOCKSIZE * 8);
+	_bloomfilter_allocate_blocks(filter, num_blocks ? num_blocks : 1);
+}
+
+void
+bloomfilter_finalize(bloomfilter_t* filter) {
+	memory_deallocate(filter->block);
+	filter->block = 0;
+	filter->num_blocks = 0;
+}
+
+void
+bloomfilter_insert(bloomfilter_t* filter, const void* key, size_t length) {
+	bloomfilter_insert_hash(filter, hash(key, length));
+}
+
+void
+bloomfilter_insert_hash(bloomfilter_t* filter, hash_t key) {
+	_bloomfilter_set(filter->block + (_bloomfilter_block(filter, key) * BLOOMFILTER_WORDS), key);
+}
+
+bool
+bloomfilter_query(const bloomfilter_t* filter, const void* key, size_t length) {
+	return bloomfilter_query_hash(filter, hash(key, length));
+}
+
+bool
+bloomfilter_query_hash(const bloomfilter_t* filter, hash_t key) {
+	return _bloomfilter_test(filter->block + (_bloomfilter_block(filter, key) * BLOOMFILTER_WORDS), key);
+}
+
+size_t
+bloomfilter_query_batch(const bloomfilter_t* filter, const hash_t* keys, bool* result,
+                        size_t count) {
+	size_t found = 0;
+	size_t ikey;
+	for (ikey = 0; ikey < count; ++ikey) {
+		if (ikey + FILTER_BATCH_DISTANCE < count)
+			FILTER_PREFETCH(filter->block + (_bloomfilter_block(filter, keys[ikey + FILTER_BATCH_DISTANCE]) *
+			                                 BLOOMFILTER_WORDS));
+		result[ikey] = bloomfilter_query_hash(filter, keys[ikey]);
+		found += result[ikey] ? 1 : 0;
+	}
+	return found;
+}
+
+void
+bloomfilter_clear(bloomfilter_t* filter) {
+	memset(filter->block, 0, filter->num_blocks * BLOOMFILTER_BLOCKSIZE);
+}
+
+void
+bloomfilter_write(const bloomfilter_t* filter, stream_t* stream) {
+	stream_write_uint32(stream, BLOOMFILTER_MAGIC);
+	stream_write_separator(stream);
+	stream_write_uint64(stream, filter->num_blocks);
+	stream_write_separator(stream);
+	_filter_write_words32(stream, filter->block, filter->num_blocks * BLOOMFILTER_WORDS);
+}
+
+bool
+bloomfilter_read(bloomfilter_t* filter, stream_t* stream) {
+	uint64_t num_blocks;
+
+	memset(filter, 0, sizeof(bloomfilter_t));
+	if (stream_read_uint32(stream) != BLOOMFILTER_MAGIC) {
+		log_error(0, ERROR_INVALID_VALUE, STRING_CONST("Invalid Bloom filter data in stream"));
+		return false;
+	}
+	num_blocks = stream_read_uint64(stream);
+	if (!num_blocks || (num_blocks > 0xFFFFFFFFULL)) {
+		log_errorf(0, ERROR_INVALID_VALUE, STRING_CONST("Invalid Bloom filter size in stream: %" PRIu64),
+		           num_blocks);
+		return false;
+	}
+
+	_bloomfilter_allocate_blocks(filter, (size_t)num_blocks);
+	if (!_filter_read_words32(stream, filter->block, filter->num_blocks * BLOOMFILTER_WORDS)) {
+		log_error(0, ERROR_INVALID_VALUE, STRING_CONST("Truncated Bloom filter data in stream"));
+		bloomfilter_finalize(filter);
+		return false;
+	}
+	return true;
+}
+
+static FOUNDATION_FORCEINLINE uint16_t
+_cuckoofilter_fingerprint(hash_t key) {
+	//Fingerprint zero marks an empty slot
+	uint16_t fingerprint = (uint16_t)(key >> 48);
+	return fingerprint ? fingerprint : 1;
+}
+
+static FOUNDATION_FORCEINLINE size_t
+_cuckoofilter_alternate(const cuckoofilter_t* filter, size_t index, uint16_t fingerprint) {
+	//Symmetric, the alternate of the alternate index is the original index
+	return (index ^ (size_t)((uint32_t)fingerprint * 0x5bd1e995U)) & (filter->num_buckets - 1);
+}
+
+//Set the high bit of each 16-bit lane in the bucket holding the fingerprint. Only the
+//lowest set bit is exact, which is the only one used
+static FOUNDATION_FORCEINLINE uint64_t
+_cuckoofilter_match(uint64_t bucket, uint16_t fingerprint) {
+	uint64_t diff = bucket ^ (CUCKOOFILTER_LANES * fingerprint);
+	return (diff - CUCKOOFILTER_LANES) & ~diff & CUCKOOFILTER_HIGHBITS;
+}
+
+static FOUNDATION_FORCEINLINE unsigned int
+_cuckoofilter_lane(uint64_t match) {
+	return bits_ctz64(match) & ~15U;
+}
+
+static bool
+_cuckoofilter_put(cuckoofilter_t* filter, size_t index, uint16_t fingerprint) {
+	uint64_t* bucket = filter->bucket + index;
+	uint64_t empty = _cuckoofilter_match(*bucket, 0);
+	if (!empty)
+		return false;
+	*bucket |= (uint64_t)fingerprint << _cuckoofilter_lane(empty);
+	return true;
+}
+
+static bool
+_cuckoofilter_remove(cuckoofilter_t* filter, size_t index, uint16_t fingerprint) {
+	uint64_t* bucket = filter->bucket + index;
+	uint64_t match = _cuckoofilter_match(*bucket, fingerprint);
+	if (!match)
+		return false;
+	*bucket &= ~(0xFFFFULL << _cuckoofilter_lane(match));
+	return true;
+}
+
+static void
+_cuckoofilter_store(cuckoofilter_t* filter, size_t index, uint16_t fingerprint) {
+	unsigned int ikick;
+
+	if (_cuckoofilter_put(filter, index, fingerprint) ||
+	        _cuckoofilter_put(filter, _cuckoofilter_alternate(filter, index, fingerprint), fingerprint))
+		return;
+
+	//Evict a random fingerprint and move it to its alternate bucket
+	if (random32() & 1)
+		index = _cuckoofilter_alternate(filter, index, fingerprint);
+	for (ikick = 0; ikick < CUCKOOFILTER_MAXKICKS; ++ikick) {
+		unsigned int shift = (random32() % CUCKOOFILTER_SLOTS) * 16;
+		uint64_t* bucket = filter->bucket + index;
+		uint16_t evicted = (uint16_t)(*bucket >> shift);
+		*bucket = (*bucket & ~(0xFFFFULL << shift)) | ((uint64_t)fingerprint << shift);
+		fingerprint = evicted;
+		index = _cuckoofilter_alternate(filter, index, fingerprint);
+		if (_cuckoofilter_put(filter, index, fingerprint))
+			return;
+	}
+
+	//Keep the homeless fingerprint as victim, further insertions fail until an erase
+	//frees a slot for it
+	filter->victim = fingerprint;
+	filter->victim_index = index;
+}
+
+static size_t
+_cuckoofilter_num_buckets(size_t capacity) {
+	size_t num_buckets = 2;
+	while ((real)(num_buckets * CUCKOOFILTER_SLOTS) * REAL_C(CUCKOOFILTER_LOAD) < (real)capacity)
+		num_buckets *= 2;
+	return num_buckets;
+}
+
+static void
+_cuckoofilter_allocate_buckets(cuckoofilter_t* filter, size_t num_buckets) {
+	memset(filter, 0, sizeof(cuckoofilter_t));
+	filter->num_buckets = num_buckets;
+	filter->bucket = memory_allocate(0, num_buckets * sizeof(uint64_t), 64,
+	                                 MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+}
+
+cuckoofilter_t*
+cuckoofilter_allocate(size_t capacity) {
+	cuckoofilter_t* filter = memory_allocate(0, sizeof(cuckoofilter_t), 0, MEMORY_PERSISTENT);
+	cuckoofilter_initialize(filter, capacity);
+	return filter;
+}
+
+void
+cuckoofilter_deallocate(cuckoofilter_t* filter) {
+	cuckoofilter_finalize(filter);
+	memory_deallocate(filter);
+}
+
+void
+cuckoofilter_initialize(cuckoofilter_t* filter, size_t capacity) {
+	_cuckoofilter_allocate_buckets(filter, _cuckoofilter_num_buckets(capacity));
+}
+
+void
+cuckoofilter_finalize(cuckoofilter_t* filter) {
+	memory_deallocate(filter->bucket);
+	memset(filter, 0, sizeof(cuckoofilter_t));
+}
+
+bool
+cuckoofilter_insert(cuckoofilter_t* filter, const void* key, size_t length) {
+	return cuckoofilter_insert_hash(filter, hash(key, length));
+}
+
+bool
+cuckoofilter_insert_hash(cuckoofilter_t* filter, hash_t key) {
+	if (filter->victim)
+		return false;
+	_cuckoofilter_store(filter, (size_t)key & (filter->num_buckets - 1), _cuckoofilter_fingerprint(key));
+	++filter->count;
+	return true;
+}
+
+bool
+cuckoofilter_erase(cuckoofilter_t* filter, const void* key, size_t length) {
+	return cuckoofilter_erase_hash(filter, hash(key, length));
+}
+
+bool
+cuckoofilter_erase_hash(cuckoofilter_t* filter, hash_t key) {
+	uint16_t fingerprint = _cuckoofilter_fingerprint(key);
+	size_t index = (size_t)key & (filter->num_buckets - 1);
+	size_t alternate = _cuckoofilter_alternate(filter, index, fingerprint);
+
+	if ((filter->victim == fingerprint) &&
+	        ((filter->victim_index == index) || (filter->victim_index == alternate))) {
+		filter->victim = 0;
+		--filter->count;
+		return true;
+	}
+
+	if (!_cuckoofilter_remove(filter, index, fingerprint) &&
+	        !_cuckoofilter_remove(filter, alternate, fingerprint))
+		return false;
+
+	--filter->count;
+	if (filter->victim) {
+		fingerprint = filter->victim;
+		filter->victim = 0;
+		_cuckoofilter_store(filter, filter->victim_index, fingerprint);
+	}
+	return true;
+}
+
+bool
+cuckoofilter_query(const cuckoofilter_t* filter, const void* key, size_t length) {
+	return cuckoofilter_query_hash(filter, hash(key, length));
+}
+
+bool
+cuckoofilter_query_hash(const cuckoofilter_t* filter, hash_t key) {
+	uint16_t fingerprint = _cuckoofilter_fingerprint(key);
+	size_t index = (size_t)key & (filter->num_buckets - 1);
+	size_t alternate = _cuckoofilter_alternate(filter, index, fingerprint);
+
+	if (_cuckoofilter_match(filter->bucket[index], fingerprint) ||
+	        _cuckoofilter_match(filter->bucket[alternate], fingerprint))
+		return true;
+
+	return (filter->victim == fingerprint) &&
+	       ((filter->victim_index == index) || (filter->victim_index == alternate));
+}
+
+size_t
+cuckoofilter_query_batch(const cuckoofilter_t* filter, const hash_t* keys, bool* result,
+                         size_t count) {
+	size_t found = 0;
+	size_t ikey;
+	for (ikey = 0; ikey < count; ++ikey) {
+		if (ikey + FILTER_BATCH_DISTANCE < count) {
+			hash_t ahead = keys[ikey + FILTER_BATCH_DISTANCE];
+			size_t index = (size_t)ahead & (filter->num_buckets - 1);
+			FILTER_PREFETCH(filter->bucket + index);
+			FILTER_PREFETCH(filter->bucket + _cuckoofilter_alternate(filter, index,
+			                                                         _cuckoofilter_fingerprint(ahead)));
+		}
+		result[ikey] = cuckoofilter_query_hash(filter, keys[ikey]);
+		found += result[ikey] ? 1 : 0;
+	}
+	return found;
+}
+
+size_t
+cuckoofilter_size(const cuckoofilter_t* filter) {
+	return filter->count;
+}
+
+void
+cuckoofilter_clear(cuckoofilter_t* filter) {
+	memset(filter->bucket, 0, filter->num_buckets * sizeof(uint64_t));
+	filter->count = 0;
+	filter->victim = 0;
+	filter->victim_index = 0;
+}
+
+void
+cuckoofilter_write(const cuckoofilter_t* filter, stream_t* stream) {
+	stream_write_uint32(stream, CUCKOOFILTER_MAGIC);
+	stream_write_separator(stream);
+	stream_write_uint64(stream, filter->num_buckets);
+	stream_write_separator(stream);
+	stream_write_uint64(stream, filter->count);
+	stream_write_separator(stream);
+	stream_write_uint64(stream, filter->victim_index);
+	stream_write_separator(stream);
+	stream_write_uint16(stream, filter->victim);
+	stream_write_separator(stream);
+	_filter_write_words64(stream, filter->bucket, filter->num_buckets);
+}
+
+bool
+cuckoofilter_read(cuckoofilter_t* filter, stream_t* stream) {
+	uint64_t num_buckets, count, victim_index;
+	uint16_t victim;
+
+	memset(filter, 0, sizeof(cuckoofilter_t));
+	if (stream_read_uint32(stream) != CUCKOOFILTER_MAGIC) {
+		log_error(0, ERROR_INVALID_VALUE, STRING_CONST("Invalid cuckoo filter data in stream"));
+		return false;
+	}
+	num_buckets = stream_read_uint64(stream);
+	count = stream_read_uint64(stream);
+	victim_index = stream_read_uint64(stream);
+	victim = stream_read_uint16(stream);
+	if ((num_buckets < 2) || (num_buckets & (num_buckets - 1)) || (num_buckets > ((uint64_t)((size_t)-1) / sizeof(uint64_t))) ||
+	        (victim_index >= num_buckets)) {
+		log_errorf(0, ERROR_INVALID_VALUE, STRING_CONST("Invalid cuckoo filter size in stream: %" PRIu64),
+		           num_buckets);
+		return false;
+	}
+
+	_cuckoofilter_allocate_buckets(filter, (size_t)num_buckets);
+	if (!_filter_read_words64(stream, filter->bucket, filter->num_buckets)) {
+		log_error(0, ERROR_INVALID_VALUE, STRING_CONST("Truncated cuckoo filter data in stream"));
+		cuckoofilter_finalize(filter);
+		return false;
+	}
+	filter->count = (size_t)count;
+	filter->victim_index = (size_t)victim_index;
+	filter->victim = victim;
+	return true;
+}
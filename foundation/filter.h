@@ -0,0 +1,216 @@
+/* filter.h  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#pragma once
+
+/*! \file filter.h
+\brief Approximate set membership filters
+
+Approximate set membership filters answering if a key is possibly in a set or definitely
+not in the set, using keys hashed with #hash. The blocked Bloom filter maps each key to a
+single cache line and probes all bits with one vector compare. The cuckoo filter stores
+short fingerprints and supports erasing keys. Filters can be written to and read from
+streams. Access is not atomic and therefor not thread safe. */
+
+#include <foundation/platform.h>
+#include <foundation/types.h>
+
+/*! Allocate a Bloom filter sized for the given number of keys. The filter should be
+deallocated with a call to #bloomfilter_deallocate
+\param capacity Expected number of keys
+\param bits_per_key Number of bits per key, 10 gives a false positive rate around 1%
+\return New Bloom filter */
+FOUNDATION_API bloomfilter_t*
+bloomfilter_allocate(size_t capacity, size_t bits_per_key);
+
+/*! Deallocate a Bloom filter previously allocated with #bloomfilter_allocate
+\param filter Bloom filter */
+FOUNDATION_API void
+bloomfilter_deallocate(bloomfilter_t* filter);
+
+/*! Initialize a Bloom filter sized for the given number of keys. The filter should be
+finalized with a call to #bloomfilter_finalize
+\param filter Bloom filter
+\param capacity Expected number of keys
+\param bits_per_key Number of bits per key */
+FOUNDATION_API void
+bloomfilter_initialize(bloomfilter_t* filter, size_t capacity, size_t bits_per_key);
+
+/*! Finalize a Bloom filter previously initialized with #bloomfilter_initialize
+\param filter Bloom filter */
+FOUNDATION_API void
+bloomfilter_finalize(bloomfilter_t* filter);
+
+/*! Insert a key in the Bloom filter
+\param filter Bloom filter
+\param key Key
+\param length Length of key */
+FOUNDATION_API void
+bloomfilter_insert(bloomfilter_t* filter, const void* key, size_t length);
+
+/*! Insert a key hash in the Bloom filter
+\param filter Bloom filter
+\param key Hash of key as given by #hash */
+FOUNDATION_API void
+bloomfilter_insert_hash(bloomfilter_t* filter, hash_t key);
+
+/*! Query if a key is possibly in the Bloom filter
+\param filter Bloom filter
+\param key Key
+\param length Length of key
+\return true if key possibly in set, false if key definitely not in set */
+FOUNDATION_API bool
+bloomfilter_query(const bloomfilter_t* filter, const void* key, size_t length);
+
+/*! Query if a key hash is possibly in the Bloom filter
+\param filter Bloom filter
+\param key Hash of key as given by #hash
+\return true if key possibly in set, false if key definitely not in set */
+FOUNDATION_API bool
+bloomfilter_query_hash(const bloomfilter_t* filter, hash_t key);
+
+/*! Query an array of key hashes, prefetching blocks of upcoming keys while probing
+\param filter Bloom filter
+\param keys Hashes of keys as given by #hash
+\param result Array receiving query results
+\param count Number of keys
+\return Number of keys possibly in set */
+FOUNDATION_API size_t
+bloomfilter_query_batch(const bloomfilter_t* filter, const hash_t* keys, bool* result,
+                        size_t count);
+
+/*! Clear the Bloom filter
+\param filter Bloom filter */
+FOUNDATION_API void
+bloomfilter_clear(bloomfilter_t* filter);
+
+/*! Write the Bloom filter to a stream
+\param filter Bloom filter
+\param stream Stream */
+FOUNDATION_API void
+bloomfilter_write(const bloomfilter_t* filter, stream_t* stream);
+
+/*! Initialize a Bloom filter from data previously written to a stream with
+#bloomfilter_write. On success the filter should be finalized with a call to
+#bloomfilter_finalize
+\param filter Bloom filter
+\param stream Stream
+\return true if filter was read, false if stream data was invalid */
+FOUNDATION_API bool
+bloomfilter_read(bloomfilter_t* filter, stream_t* stream);
+
+/*! Allocate a cuckoo filter sized for the given number of keys. The filter should be
+deallocated with a call to #cuckoofilter_deallocate
+\param capacity Expected number of keys
+\return New cuckoo filter */
+FOUNDATION_API cuckoofilter_t*
+cuckoofilter_allocate(size_t capacity);
+
+/*! Deallocate a cuckoo filter previously allocated with #cuckoofilter_allocate
+\param filter Cuckoo filter */
+FOUNDATION_API void
+cuckoofilter_deallocate(cuckoofilter_t* filter);
+
+/*! Initialize a cuckoo filter sized for the given number of keys. The filter should be
+finalized with a call to #cuckoofilter_finalize
+\param filter Cuckoo filter
+\param capacity Expected number of keys */
+FOUNDATION_API void
+cuckoofilter_initialize(cuckoofilter_t* filter, size_t capacity);
+
+/*! Finalize a cuckoo filter previously initialized with #cuckoofilter_initialize
+\param filter Cuckoo filter */
+FOUNDATION_API void
+cuckoofilter_finalize(cuckoofilter_t* filter);
+
+/*! Insert a key in the cuckoo filter. Inserting the same key more than once stores
+multiple fingerprints which must each be erased.
+\param filter Cuckoo filter
+\param key Key
+\param length Length of key
+\return true if inserted, false if filter full */
+FOUNDATION_API bool
+cuckoofilter_insert(cuckoofilter_t* filter, const void* key, size_t length);
+
+/*! Insert a key hash in the cuckoo filter
+\param filter Cuckoo filter
+\param key Hash of key as given by #hash
+\return true if inserted, false if filter full */
+FOUNDATION_API bool
+cuckoofilter_insert_hash(cuckoofilter_t* filter, hash_t key);
+
+/*! Erase a key from the cuckoo filter. Only keys previously inserted should be erased,
+erasing other keys might erase a colliding fingerprint.
+\param filter Cuckoo filter
+\param key Key
+\param length Length of key
+\return true if a fingerprint was erased, false if not found */
+FOUNDATION_API bool
+cuckoofilter_erase(cuckoofilter_t* filter, const void* key, size_t length);
+
+/*! Erase a key hash from the cuckoo filter
+\param filter Cuckoo filter
+\param key Hash of key as given by #hash
+\return true if a fingerprint was erased, false if not found */
+FOUNDATION_API bool
+cuckoofilter_erase_hash(cuckoofilter_t* filter, hash_t key);
+
+/*! Query if a key is possibly in the cuckoo filter
+\param filter Cuckoo filter
+\param key Key
+\param length Length of key
+\return true if key possibly in set, false if key definitely not in set */
+FOUNDATION_API bool
+cuckoofilter_query(const cuckoofilter_t* filter, const void* key, size_t length);
+
+/*! Query if a key hash is possibly in the cuckoo filter
+\param filter Cuckoo filter
+\param key Hash of key as given by #hash
+\return true if key possibly in set, false if key definitely not in set */
+FOUNDATION_API bool
+cuckoofilter_query_hash(const cuckoofilter_t* filter, hash_t key);
+
+/*! Query an array of key hashes, prefetching buckets of upcoming keys while probing
+\param filter Cuckoo filter
+\param keys Hashes of keys as given by #hash
+\param result Array receiving query results
+\param count Number of keys
+\return Number of keys possibly in set */
+FOUNDATION_API size_t
+cuckoofilter_query_batch(const cuckoofilter_t* filter, const hash_t* keys, bool* result,
+                         size_t count);
+
+/*! Get number of fingerprints stored in the cuckoo filter
+\param filter Cuckoo filter
+\return Number of stored fingerprints */
+FOUNDATION_API size_t
+cuckoofilter_size(const cuckoofilter_t* filter);
+
+/*! Clear the cuckoo filter
+\param filter Cuckoo filter */
+FOUNDATION_API void
+cuckoofilter_clear(cuckoofilter_t* filter);
+
+/*! Write the cuckoo filter to a stream
+\param filter Cuckoo filter
+\param stream Stream */
+FOUNDATION_API void
+cuckoofilter_write(const cuckoofilter_t* filter, stream_t* stream);
+
+/*! Initialize a cuckoo filter from data previously written to a stream with
+#cuckoofilter_write. On success the filter should be finalized with a call to
+#cuckoofilter_finalize
+\param filter Cuckoo filter
+\param stream Stream
+\return true if filter was read, false if stream data was invalid */
+FOUNDATION_API bool
+cuckoofilter_read(cuckoofilter_t* filter, stream_t* stream);
@@ -54,7 +54,13 @@ foundation_initialize_config(const foundation_config_t config) {
 	_config.stacktrace_depth      = (config.stacktrace_depth ? config.stacktrace_depth : 32);
 	_config.event_block_chunk     = (config.event_block_chunk ? config.event_block_chunk : (8 * 1024));
 	_config.event_block_limit     = (config.event_block_limit ? config.event_block_limit : (512 * 1024));
+#if FOUNDATION_PLATFORM_WINDOWS
 	_config.thread_stack_size     = (config.thread_stack_size ? config.thread_stack_size : 0x8000);
+#else
+	//Zero keeps the operating system default stack size
+	_config.thread_stack_size     = config.thread_stack_size;
+#endif
+	_config.thread_pool_size      = (config.thread_pool_size ? config.thread_pool_size : 16);
 	
 	_config.temporary_memory      = config.temporary_memory;
 	_config.hash_store_size       = config.hash_store_size;
@@ -147,7 +153,9 @@ foundation_finalize(void) {
 	_library_finalize();
 	_environment_finalize();
 	_random_finalize();
+	_thread_pool_finalize();
 	_thread_finalize();
+	_objectmap_finalize();
 	_time_finalize();
 	_log_finalize();
 	_exception_finalize();
@@ -43,14 +43,25 @@ Wrapper for foundation library headers and main entry/exit points */
 #include <foundation/md5.h>
 #include <foundation/array.h>
 #include <foundation/bitbuffer.h>
+#include <foundation/bitset.h>
+#include <foundation/btree.h>
+#include <foundation/cache.h>
+#include <foundation/hamt.h>
+#include <foundation/hashindex.h>
 #include <foundation/hashmap.h>
 #include <foundation/hashtable.h>
+#include <foundation/heap.h>
+#include <foundation/stringmap.h>
+#include <foundation/filter.h>
+#include <foundation/sketch.h>
+#include <foundation/skiplist.h>
 #include <foundation/ringbuffer.h>
 #include <foundation/string.h>
 #include <foundation/path.h>
 #include <foundation/locale.h>
 
 #include <foundation/math.h>
+#include <foundation/vector.h>
 #include <foundation/random.h>
 #include <foundation/radixsort.h>
 
@@ -64,8 +75,10 @@ Wrapper for foundation library headers and main entry/exit points */
 #include <foundation/fs.h>
 #include <foundation/bufferstream.h>
 #include <foundation/assetstream.h>
+#include <foundation/wal.h>
 #include <foundation/pipe.h>
 #include <foundation/json.h>
+#include <foundation/msgpack.h>
 
 #include <foundation/exception.h>
 #include <foundation/stacktrace.h>
@@ -25,6 +25,7 @@
 #  include <utime.h>
 #  include <fcntl.h>
 #  include <dirent.h>
+#  include <sys/mman.h>
 #endif
 
 #if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
@@ -656,6 +657,29 @@ fs_remove_file(const char* path, size_t length) {
 	return result;
 }
 
+bool
+fs_sync_directory(const char* path, size_t length) {
+	string_const_t fspath = _fs_strip_protocol(path, length);
+	if (!fspath.length)
+		return false;
+#if FOUNDATION_PLATFORM_POSIX
+	{
+		char buffer[BUILD_MAX_PATHLEN];
+		string_t finalpath = string_copy(buffer, sizeof(buffer), STRING_ARGS(fspath));
+		bool result;
+		int fd = open(finalpath.str, O_RDONLY | O_DIRECTORY);
+		if (fd < 0)
+			return false;
+		result = (fsync(fd) == 0);
+		close(fd);
+		return result;
+	}
+#else
+	//Directory entries are persisted with file metadata
+	return true;
+#endif
+}
+
 bool
 fs_remove_directory(const char* path, size_t length) {
 	/*lint --e{438,613,838} Lint gets seriously confused about the arrays here */
@@ -1022,6 +1046,231 @@ fs_temporary_file(void) {
 	                    STREAM_IN | STREAM_OUT | STREAM_BINARY | STREAM_CREATE | STREAM_TRUNCATE);
 }
 
+static bool
+_fs_map_view(fs_map_t* map, size_t size) {
+	bool writable = ((map->mode & STREAM_OUT) != 0);
+	bool copy = ((map->mode & FS_MAP_PRIVATE) != 0);
+	map->data = nullptr;
+	map->size = size;
+	if (!size)
+		return true;
+
+#if FOUNDATION_PLATFORM_WINDOWS
+
+	map->mapping = CreateFileMappingW((HANDLE)map->file, 0,
+	                                  copy ? PAGE_WRITECOPY : (writable ? PAGE_READWRITE : PAGE_READONLY),
+	                                  (DWORD)((uint64_t)size >> 32), (DWORD)size, 0);
+	if (map->mapping) {
+		map->data = MapViewOfFile(map->mapping, copy ? FILE_MAP_COPY : (writable ? FILE_MAP_WRITE : FILE_MAP_READ),
+		                          0, 0, size);
+		if (!map->data) {
+			CloseHandle(map->mapping);
+			map->mapping = nullptr;
+		}
+	}
+
+#elif FOUNDATION_PLATFORM_POSIX
+
+	map->data = mmap(0, size, PROT_READ | ((writable || copy) ? PROT_WRITE : 0), copy ? MAP_PRIVATE : MAP_SHARED,
+	                 (int)map->file, 0);
+	if (map->data == MAP_FAILED)
+		map->data = nullptr;
+
+#endif
+
+	if (!map->data) {
+		string_const_t errstr = system_error_message(0);
+		log_warnf(0, WARNING_SYSTEM_CALL_FAIL, STRING_CONST("Unable to map file (%" PRIsize " bytes): %.*s"),
+		          size, STRING_FORMAT(errstr));
+		map->size = 0;
+		return false;
+	}
+	return true;
+}
+
+static void
+_fs_unmap_view(fs_map_t* map) {
+	if (!map->data)
+		return;
+#if FOUNDATION_PLATFORM_WINDOWS
+	UnmapViewOfFile(map->data);
+	CloseHandle(map->mapping);
+	map->mapping = nullptr;
+#elif FOUNDATION_PLATFORM_POSIX
+	munmap(map->data, map->size);
+#endif
+	map->data = nullptr;
+}
+
+bool
+fs_map_file(fs_map_t* map, const char* path, size_t length, unsigned int mode) {
+	string_const_t fspath = _fs_strip_protocol(path, length);
+	size_t size = 0;
+
+	memset(map, 0, sizeof(fs_map_t));
+	//Private mappings never modify the file
+	if (mode & FS_MAP_PRIVATE)
+		mode = (mode & ~(STREAM_OUT | STREAM_TRUNCATE | STREAM_CREATE)) | STREAM_IN;
+	map->mode = mode;
+	map->file = -1;
+	if (!fspath.length || !(mode & (STREAM_IN | STREAM_OUT)))
+		return false;
+
+#if FOUNDATION_PLATFORM_WINDOWS
+
+	DWORD access = GENERIC_READ | ((mode & STREAM_OUT) ? GENERIC_WRITE : 0);
+	DWORD disposition;
+	LARGE_INTEGER filesize;
+	wchar_t* wpath;
+	HANDLE file;
+
+	if (mode & STREAM_CREATE)
+		disposition = ((mode & STREAM_OUT) && (mode & STREAM_TRUNCATE)) ? CREATE_ALWAYS : OPEN_ALWAYS;
+	else
+		disposition = ((mode & STREAM_OUT) && (mode & STREAM_TRUNCATE)) ? TRUNCATE_EXISTING : OPEN_EXISTING;
+
+	wpath = wstring_allocate_from_string(STRING_ARGS(fspath));
+	file = CreateFileW(wpath, access, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, 0,
+	                   disposition, FILE_ATTRIBUTE_NORMAL, 0);
+	wstring_deallocate(wpath);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	if (!GetFileSizeEx(file, &filesize)) {
+		CloseHandle(file);
+		return false;
+	}
+	map->file = (intptr_t)file;
+	size = (size_t)filesize.QuadPart;
+
+#elif FOUNDATION_PLATFORM_POSIX
+
+	char buffer[BUILD_MAX_PATHLEN];
+	string_t finalpath = string_copy(buffer, sizeof(buffer), STRING_ARGS(fspath));
+	int flags = (mode & STREAM_OUT) ? O_RDWR : O_RDONLY;
+	struct stat st;
+	int fd;
+
+	if (mode & STREAM_CREATE)
+		flags |= O_CREAT;
+	if ((mode & STREAM_OUT) && (mode & STREAM_TRUNCATE))
+		flags |= O_TRUNC;
+
+	fd = open(finalpath.str, flags, 0644);
+	if (fd < 0)
+		return false;
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+		return false;
+	}
+	map->file = fd;
+	size = (size_t)st.st_size;
+
+#else
+
+	log_error(0, ERROR_NOT_IMPLEMENTED, STRING_CONST("File mapping not supported on this platform"));
+	return false;
+
+#endif
+
+	if (!_fs_map_view(map, size)) {
+		fs_unmap_file(map);
+		return false;
+	}
+	return true;
+}
+
+void
+fs_unmap_file(fs_map_t* map) {
+	_fs_unmap_view(map);
+	if (map->file != -1) {
+#if FOUNDATION_PLATFORM_WINDOWS
+		CloseHandle((HANDLE)map->file);
+#elif FOUNDATION_PLATFORM_POSIX
+		close((int)map->file);
+#endif
+	}
+	map->file = -1;
+	map->size = 0;
+}
+
+bool
+fs_map_resize(fs_map_t* map, size_t size) {
+	bool success = false;
+	if (!(map->mode & STREAM_OUT) || (map->file == -1))
+		return false;
+
+	_fs_unmap_view(map);
+
+#if FOUNDATION_PLATFORM_WINDOWS
+	LARGE_INTEGER position;
+	position.QuadPart = (LONGLONG)size;
+	success = SetFilePointerEx((HANDLE)map->file, position, 0, FILE_BEGIN) &&
+	          SetEndOfFile((HANDLE)map->file);
+#elif FOUNDATION_PLATFORM_POSIX
+	success = (ftruncate((int)map->file, (off_t)size) == 0);
+#endif
+
+	if (!success) {
+		string_const_t errstr = system_error_message(0);
+		log_warnf(0, WARNING_SYSTEM_CALL_FAIL, STRING_CONST("Unable to resize mapped file (%" PRIsize " bytes): %.*s"),
+		          size, STRING_FORMAT(errstr));
+		//Restore the previous mapping, file size is unchanged
+		_fs_map_view(map, map->size);
+		return false;
+	}
+	return _fs_map_view(map, size);
+}
+
+bool
+fs_map_flush(fs_map_t* map, size_t offset, size_t size) {
+	if (!map->data || (offset >= map->size))
+		return true;
+	if (size > map->size - offset)
+		size = map->size - offset;
+#if FOUNDATION_PLATFORM_WINDOWS
+	return FlushViewOfFile(pointer_offset(map->data, offset), size) &&
+	       FlushFileBuffers((HANDLE)map->file);
+#elif FOUNDATION_PLATFORM_POSIX
+	{
+		//Range must start on a page boundary
+		size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+		size_t start = offset - (offset % page_size);
+		return msync(pointer_offset(map->data, start), size + (offset - start), MS_SYNC) == 0;
+	}
+#else
+	return false;
+#endif
+}
+
+bool
+fs_map_advise(fs_map_t* map, size_t offset, size_t size, unsigned int advice) {
+	if (!map->data || (offset >= map->size))
+		return true;
+	if (size > map->size - offset)
+		size = map->size - offset;
+#if FOUNDATION_PLATFORM_POSIX
+	{
+		//Range must start on a page boundary
+		size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+		size_t start = offset - (offset % page_size);
+		void* address = pointer_offset(map->data, start);
+		bool success = true;
+		size += offset - start;
+		if (advice & FS_MAP_SEQUENTIAL)
+			success = (madvise(address, size, MADV_SEQUENTIAL) == 0) && success;
+		if (advice & FS_MAP_RANDOM)
+			success = (madvise(address, size, MADV_RANDOM) == 0) && success;
+		if (advice & FS_MAP_WILLNEED)
+			success = (madvise(address, size, MADV_WILLNEED) == 0) && success;
+		return success;
+	}
+#else
+	//Access hints are not supported, pages are read on demand
+	FOUNDATION_UNUSED(advice);
+	return true;
+#endif
+}
+
 string_t*
 fs_matching_files_regex(const char* path, size_t length, regex_t* pattern, bool recurse) {
 	string_t* names = 0;
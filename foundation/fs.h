@@ -52,6 +52,15 @@ fs_copy_file(const char* source, size_t srclen, const char* dest, size_t destlen
 FOUNDATION_API bool
 fs_remove_file(const char* path, size_t length);
 
+/*! Flush directory entries of a directory to storage, making file creation, removal and
+renaming in the directory durable. Only needed on platforms where flushing file data
+does not persist the directory entry of the file
+\param path   Directory path
+\param length Length of directory path
+\return       true if successful, false if directory entries could not be flushed */
+FOUNDATION_API bool
+fs_sync_directory(const char* path, size_t length);
+
 /*! Check if the given file exists in the file system
 \param path   Path
 \param length Length of path
@@ -168,6 +177,55 @@ of the same program.
 FOUNDATION_API stream_t*
 fs_temporary_file(void);
 
+/*! Map a file in the file system into memory. Writes to the mapped memory of a file opened
+with STREAM_OUT are written back to the file. The mapping should be closed with a call to
+#fs_unmap_file. Not supported on PNaCl.
+\param map    Map to initialize
+\param path   File path
+\param length Length of path
+\param mode   Open mode, STREAM_IN for read access and STREAM_OUT for read and write access.
+              STREAM_CREATE creates the file if it does not exist, STREAM_TRUNCATE truncates
+              a file opened for writing. FS_MAP_PRIVATE maps a private copy-on-write view,
+              the mapped memory is writable but the file is opened read only and never
+              modified
+\return       true if file was opened and mapped, false if not */
+FOUNDATION_API bool
+fs_map_file(fs_map_t* map, const char* path, size_t length, unsigned int mode);
+
+/*! Unmap a file previously mapped with #fs_map_file and close the file. Modified pages
+are written back by the operating system but not flushed to storage.
+\param map    Map */
+FOUNDATION_API void
+fs_unmap_file(fs_map_t* map);
+
+/*! Resize a file mapped for writing, growing or truncating the file. The file may be
+mapped at a new address, any pointers into the mapped memory must be refreshed.
+\param map    Map
+\param size   New size of file in bytes
+\return       true if successful, false if file could not be resized or mapped */
+FOUNDATION_API bool
+fs_map_resize(fs_map_t* map, size_t size);
+
+/*! Flush modified pages in a range of a mapped file to storage, blocking until the
+pages have been written.
+\param map    Map
+\param offset Offset of range in bytes
+\param size   Size of range in bytes
+\return       true if successful, false if pages could not be flushed */
+FOUNDATION_API bool
+fs_map_flush(fs_map_t* map, size_t offset, size_t size);
+
+/*! Give a hint on how a range of a mapped file will be accessed. Hints are ignored on
+platforms not supporting them.
+\param map    Map
+\param offset Offset of range in bytes
+\param size   Size of range in bytes
+\param advice Access hint flags, combination of FS_MAP_SEQUENTIAL, FS_MAP_RANDOM and
+              FS_MAP_WILLNEED
+\return       true if successful, false if hint could not be given */
+FOUNDATION_API bool
+fs_map_advise(fs_map_t* map, size_t offset, size_t size, unsigned int advice);
+
 /*! Post a file event
 \param id     Event id
 \param path   Path
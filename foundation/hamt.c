@@ -0,0 +1,466 @@
+/* hamt.c  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+#include <foundation/internal.h>
+
+#define HAMT_BITS          5
+#define HAMT_MASK          31
+#define HAMT_SLAB_SIZE     (64 * 1024)
+//Versions are allocated from the node pool as well
+#define HAMT_VERSION_CLASS ((unsigned int)((sizeof(hamt_t) + 15) / 16) - 1)
+
+static FOUNDATION_FORCEINLINE uint32_t
+_hamt_bit(hash_t key, unsigned int shift) {
+	return 1U << ((key >> shift) & HAMT_MASK);
+}
+
+static FOUNDATION_FORCEINLINE unsigned int
+_hamt_index(uint32_t map, uint32_t bit) {
+	return bits_popcount64(map & (bit - 1));
+}
+
+static FOUNDATION_FORCEINLINE hamt_node_t**
+_hamt_child(const hamt_node_t* node) {
+	return (hamt_node_t**)(uintptr_t)(node->entry + bits_popcount64(node->datamap));
+}
+
+static FOUNDATION_FORCEINLINE unsigned int
+_hamt_node_class(uint32_t datamap, uint32_t nodemap) {
+	size_t size = sizeof(hamt_node_t) + (sizeof(hamt_entry_t) * bits_popcount64(datamap)) +
+	              (sizeof(hamt_node_t*) * bits_popcount64(nodemap));
+	return (unsigned int)((size + 15) / 16) - 1;
+}
+
+static void
+_hamt_pool_lock(hamt_pool_t* pool) {
+	unsigned int spin = 0;
+	while (!atomic_cas32(&pool->lock, 1, 0)) {
+		if (++spin > 64)
+			thread_yield();
+	}
+}
+
+static void
+_hamt_pool_unlock(hamt_pool_t* pool) {
+	atomic_thread_fence_release();
+	atomic_store32(&pool->lock, 0);
+}
+
+static void
+_hamt_pool_release(hamt_pool_t* pool) {
+	void* slab;
+	if (atomic_decr32(&pool->ref))
+		return;
+	slab = pool->slab;
+	while (slab) {
+		void* next = *(void**)slab;
+		memory_deallocate(slab);
+		slab = next;
+	}
+	memory_deallocate(pool);
+}
+
+static void*
+_hamt_pool_allocate(hamt_pool_t* pool, unsigned int iclass) {
+	size_t size = (size_t)(iclass + 1) * 16;
+	void* block;
+
+	_hamt_pool_lock(pool);
+	block = pool->free[iclass];
+	if (block) {
+		pool->free[iclass] = *(void**)block;
+	}
+	else {
+		if (pool->remain < size) {
+			char* slab = memory_allocate(0, HAMT_SLAB_SIZE, 16, MEMORY_PERSISTENT);
+			*(void**)slab = pool->slab;
+			pool->slab = slab;
+			pool->cursor = slab + 16;
+			pool->remain = HAMT_SLAB_SIZE - 16;
+		}
+		block = pool->cursor;
+		pool->cursor += size;
+		pool->remain -= size;
+	}
+	_hamt_pool_unlock(pool);
+	return block;
+}
+
+static void
+_hamt_pool_free(hamt_pool_t* pool, void* block, unsigned int iclass) {
+	_hamt_pool_lock(pool);
+	*(void**)block = pool->free[iclass];
+	pool->free[iclass] = block;
+	_hamt_pool_unlock(pool);
+}
+
+static hamt_node_t*
+_hamt_node_allocate(hamt_pool_t* pool, uint32_t datamap, uint32_t nodemap) {
+	hamt_node_t* node = _hamt_pool_allocate(pool, _hamt_node_class(datamap, nodemap));
+	atomic_store32(&node->ref, 1);
+	node->datamap = datamap;
+	node->nodemap = nodemap;
+	return node;
+}
+
+static void
+_hamt_node_release(hamt_pool_t* pool, hamt_node_t* node) {
+	hamt_node_t** child;
+	unsigned int ichild, num_children;
+	if (atomic_decr32(&node->ref))
+		return;
+	child = _hamt_child(node);
+	num_children = bits_popcount64(node->nodemap);
+	for (ichild = 0; ichild < num_children; ++ichild)
+		_hamt_node_release(pool, child[ichild]);
+	_hamt_pool_free(pool, node, _hamt_node_class(node->datamap, node->nodemap));
+}
+
+static hamt_node_t*
+_hamt_node_copy(hamt_pool_t* pool, const hamt_node_t* node, uint32_t datamap, uint32_t nodemap,
+                uint32_t bit, const hamt_entry_t* entry, hamt_node_t* child) {
+	//Copy a node with new bitmaps, taking the entry or child for the given bit from the
+	//arguments and everything else from the node. Children taken from the node are shared
+	hamt_node_t* copy = _hamt_node_allocate(pool, datamap, nodemap);
+	hamt_node_t** source = _hamt_child(node);
+	hamt_node_t** dest = _hamt_child(copy);
+	unsigned int idest = 0;
+	uint32_t bits;
+	for (bits = datamap; bits; bits &= bits - 1) {
+		uint32_t current = bits & (~bits + 1);
+		copy->entry[idest++] = (current == bit) ? *entry : node->entry[_hamt_index(node->datamap, current)];
+	}
+	idest = 0;
+	for (bits = nodemap; bits; bits &= bits - 1) {
+		uint32_t current = bits & (~bits + 1);
+		if (current != bit) {
+			hamt_node_t* shared = source[_hamt_index(node->nodemap, current)];
+			atomic_incr32(&shared->ref);
+			dest[idest++] = shared;
+		}
+		else {
+			dest[idest++] = child;
+		}
+	}
+	return copy;
+}
+
+static hamt_node_t*
+_hamt_node_merge(hamt_pool_t* pool, const hamt_entry_t* first, const hamt_entry_t* second,
+                 unsigned int shift) {
+	//Distinct keys differ in some bit, so recursion ends before running out of key bits
+	uint32_t firstbit = _hamt_bit(first->key, shift);
+	uint32_t secondbit = _hamt_bit(second->key, shift);
+	hamt_node_t* node;
+	FOUNDATION_ASSERT(shift < 64);
+	if (firstbit == secondbit) {
+		node = _hamt_node_allocate(pool, 0, firstbit);
+		_hamt_child(node)[0] = _hamt_node_merge(pool, first, second, shift + HAMT_BITS);
+	}
+	else {
+		node = _hamt_node_allocate(pool, firstbit | secondbit, 0);
+		node->entry[0] = (firstbit < secondbit) ? *first : *second;
+		node->entry[1] = (firstbit < secondbit) ? *second : *first;
+	}
+	return node;
+}
+
+static hamt_node_t*
+_hamt_node_set(hamt_pool_t* pool, hamt_node_t* node, hash_t key, void* value, unsigned int shift,
+               bool* added) {
+	//Returns the given node if unchanged, otherwise a copy with one reference
+	uint32_t bit = _hamt_bit(key, shift);
+	hamt_entry_t entry;
+	entry.key = key;
+	entry.value = value;
+	if (node->datamap & bit) {
+		const hamt_entry_t* existing = node->entry + _hamt_index(node->datamap, bit);
+		hamt_node_t* child;
+		if (existing->key == key) {
+			if (existing->value == value)
+				return node;
+			return _hamt_node_copy(pool, node, node->datamap, node->nodemap, bit, &entry, nullptr);
+		}
+		*added = true;
+		child = _hamt_node_merge(pool, existing, &entry, shift + HAMT_BITS);
+		return _hamt_node_copy(pool, node, node->datamap & ~bit, node->nodemap | bit, bit, nullptr, child);
+	}
+	if (node->nodemap & bit) {
+		hamt_node_t* child = _hamt_child(node)[_hamt_index(node->nodemap, bit)];
+		hamt_node_t* updated = _hamt_node_set(pool, child, key, value, shift + HAMT_BITS, added);
+		if (updated == child)
+			return node;
+		return _hamt_node_copy(pool, node, node->datamap, node->nodemap, bit, nullptr, updated);
+	}
+	*added = true;
+	return _hamt_node_copy(pool, node, node->datamap | bit, node->nodemap, bit, &entry, nullptr);
+}
+
+static hamt_node_t*
+_hamt_node_erase(hamt_pool_t* pool, hamt_node_t* node, hash_t key, unsigned int shift) {
+	//Returns the given node if key was not found, null if the node would be empty,
+	//otherwise a copy with one reference
+	uint32_t bit = _hamt_bit(key, shift);
+	if (node->datamap & bit) {
+		if (node->entry[_hamt_index(node->datamap, bit)].key != key)
+			return node;
+		if ((node->datamap == bit) && !node->nodemap)
+			return nullptr;
+		return _hamt_node_copy(pool, node, node->datamap & ~bit, node->nodemap, bit, nullptr, nullptr);
+	}
+	if (node->nodemap & bit) {
+		hamt_node_t* child = _hamt_child(node)[_hamt_index(node->nodemap, bit)];
+		hamt_node_t* updated = _hamt_node_erase(pool, child, key, shift + HAMT_BITS);
+		hamt_node_t* copy;
+		if (updated == child)
+			return node;
+		//Child nodes hold at least two keys, so the updated child is never empty. A child
+		//left with a single entry is inlined to keep the trie canonical
+		if (!updated->nodemap && (bits_popcount64(updated->datamap) == 1)) {
+			copy = _hamt_node_copy(pool, node, node->datamap | bit, node->nodemap & ~bit, bit, updated->entry,
+			                       nullptr);
+			_hamt_node_release(pool, updated);
+			return copy;
+		}
+		return _hamt_node_copy(pool, node, node->datamap, node->nodemap, bit, nullptr, updated);
+	}
+	return node;
+}
+
+static int
+_hamt_node_foreach(const hamt_node_t* node, hamt_foreach_fn fn, void* data) {
+	hamt_node_t** child = _hamt_child(node);
+	unsigned int ientry, num_entries = bits_popcount64(node->datamap);
+	unsigned int ichild, num_children = bits_popcount64(node->nodemap);
+	int ret;
+	for (ientry = 0; ientry < num_entries; ++ientry) {
+		ret = fn(node->entry[ientry].key, node->entry[ientry].value, data);
+		if (ret)
+			return ret;
+	}
+	for (ichild = 0; ichild < num_children; ++ichild) {
+		ret = _hamt_node_foreach(child[ichild], fn, data);
+		if (ret)
+			return ret;
+	}
+	return 0;
+}
+
+static const hamt_entry_t*
+_hamt_find(const hamt_t* map, hash_t key) {
+	const hamt_node_t* node = map->root;
+	unsigned int shift = 0;
+	while (node) {
+		uint32_t bit = _hamt_bit(key, shift);
+		if (node->datamap & bit) {
+			const hamt_entry_t* entry = node->entry + _hamt_index(node->datamap, bit);
+			return (entry->key == key) ? entry : nullptr;
+		}
+		if (!(node->nodemap & bit))
+			return nullptr;
+		node = _hamt_child(node)[_hamt_index(node->nodemap, bit)];
+		shift += HAMT_BITS;
+	}
+	return nullptr;
+}
+
+static hamt_t*
+_hamt_version(hamt_pool_t* pool, hamt_node_t* root, size_t size) {
+	hamt_t* map = _hamt_pool_allocate(pool, HAMT_VERSION_CLASS);
+	atomic_store32(&map->ref, 1);
+	atomic_incr32(&pool->ref);
+	map->size = size;
+	map->root = root;
+	map->pool = pool;
+	return map;
+}
+
+hamt_t*
+hamt_allocate(void) {
+	hamt_pool_t* pool = memory_allocate(0, sizeof(hamt_pool_t), 0,
+	                                    MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	return _hamt_version(pool, nullptr, 0);
+}
+
+hamt_t*
+hamt_acquire(hamt_t* map) {
+	atomic_incr32(&map->ref);
+	return map;
+}
+
+void
+hamt_release(hamt_t* map) {
+	hamt_pool_t* pool;
+	if (!map || atomic_decr32(&map->ref))
+		return;
+	if (map->root)
+		_hamt_node_release(map->pool, map->root);
+	pool = map->pool;
+	_hamt_pool_free(pool, map, HAMT_VERSION_CLASS);
+	_hamt_pool_release(pool);
+}
+
+hamt_t*
+hamt_set(hamt_t* map, hash_t key, void* value) {
+	hamt_node_t* root;
+	bool added = false;
+	if (!map->root) {
+		root = _hamt_node_allocate(map->pool, _hamt_bit(key, 0), 0);
+		root->entry[0].key = key;
+		root->entry[0].value = value;
+		return _hamt_version(map->pool, root, 1);
+	}
+	root = _hamt_node_set(map->pool, map->root, key, value, 0, &added);
+	if (root == map->root)
+		return hamt_acquire(map);
+	return _hamt_version(map->pool, root, map->size + (added ? 1 : 0));
+}
+
+hamt_t*
+hamt_erase(hamt_t* map, hash_t key) {
+	hamt_node_t* root;
+	if (!map->root)
+		return hamt_acquire(map);
+	root = _hamt_node_erase(map->pool, map->root, key, 0);
+	if (root == map->root)
+		return hamt_acquire(map);
+	return _hamt_version(map->pool, root, map->size - 1);
+}
+
+void*
+hamt_lookup(const hamt_t* map, hash_t key) {
+	const hamt_entry_t* entry = _hamt_find(map, key);
+	return entry ? entry->value : nullptr;
+}
+
+bool
+hamt_has_key(const hamt_t* map, hash_t key) {
+	return _hamt_find(map, key) != nullptr;
+}
+
+size_t
+hamt_size(const hamt_t* map) {
+	return map->size;
+}
+
+int
+hamt_foreach(const hamt_t* map, hamt_foreach_fn fn, void* data) {
+	return map->root ? _hamt_node_foreach(map->root, fn, data) : 0;
+}
+
+hamt_root_t*
+hamt_root_allocate(hamt_t* map) {
+	hamt_root_t* root = memory_allocate(0, sizeof(hamt_root_t), 64, MEMORY_PERSISTENT);
+	hamt_root_initialize(root, map);
+	return root;
+}
+
+void
+hamt_root_deallocate(hamt_root_t* root) {
+	if (!root)
+		return;
+	hamt_root_finalize(root);
+	memory_deallocate(root);
+}
+
+void
+hamt_root_initialize(hamt_root_t* root, hamt_t* map) {
+	atomic_store_ptr(&root->map, map ? map : hamt_allocate());
+	atomic_store32(&root->epoch, 0);
+	atomic_store32(&root->lock, 0);
+	_epoch_initialize(root->reader);
+}
+
+void
+hamt_root_finalize(hamt_root_t* root) {
+	hamt_release(atomic_load_ptr(&root->map));
+	atomic_store_ptr(&root->map, nullptr);
+}
+
+void*
+hamt_root_lookup(hamt_root_t* root, hash_t key) {
+	epoch_reader_t* reader = _epoch_reader(root->reader);
+	int32_t epoch = _epoch_enter(&root->epoch, reader);
+	void* value = hamt_lookup(atomic_load_ptr(&root->map), key);
+	_epoch_leave(reader, epoch);
+	return value;
+}
+
+hamt_t*
+hamt_root_acquire(hamt_root_t* root) {
+	epoch_reader_t* reader = _epoch_reader(root->reader);
+	int32_t epoch = _epoch_enter(&root->epoch, reader);
+	hamt_t* map = hamt_acquire(atomic_load_ptr(&root->map));
+	_epoch_leave(reader, epoch);
+	return map;
+}
+
+bool
+hamt_root_publish(hamt_root_t* root, const hamt_t* expected, hamt_t* map) {
+	hamt_t* previous;
+	int32_t epoch;
+	unsigned int spin = 0;
+
+	while (!atomic_cas32(&root->lock, 1, 0)) {
+		if (++spin > 64)
+			thread_yield();
+	}
+
+	previous = atomic_load_ptr(&root->map);
+	if (previous != expected) {
+		atomic_store32(&root->lock, 0);
+		return false;
+	}
+
+	//Readers announced in the previous epoch may have loaded the previous trie, readers
+	//announced in the new epoch are guaranteed to load the new trie
+	atomic_cas_ptr(&root->map, map, previous);
+	epoch = atomic_incr32(&root->epoch) - 1;
+	while (!_epoch_drained(root->reader, epoch))
+		thread_yield();
+
+	atomic_thread_fence_release();
+	atomic_store32(&root->lock, 0);
+
+	hamt_release(previous);
+	return true;
+}
+
+void
+hamt_root_set(hamt_root_t* root, hash_t key, void* value) {
+	while (true) {
+		hamt_t* current = hamt_root_acquire(root);
+		hamt_t* map = hamt_set(current, key, value);
+		bool done = (map == current) || hamt_root_publish(root, current, map);
+		if (!done || (map == current))
+			hamt_release(map);
+		hamt_release(current);
+		if (done)
+			return;
+	}
+}
+
+bool
+hamt_root_erase(hamt_root_t* root, hash_t key) {
+	while (true) {
+		hamt_t* current = hamt_root_acquire(root);
+		hamt_t* map = hamt_erase(current, key);
+		bool erased = (map != current);
+		bool done = !erased || hamt_root_publish(root, current, map);
+		if (!done || !erased)
+			hamt_release(map);
+		hamt_release(current);
+		if (done)
+			return erased;
+	}
+}
@@ -0,0 +1,163 @@
+/* hamt.h  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#pragma once
+
+/*! \file hamt.h
+\brief Persistent hash array mapped trie
+
+Immutable map from hash value keys to pointer values. A trie version never changes once
+created, an update returns a new version sharing all nodes not on the path to the updated
+key, which costs one node allocation per trie level. Versions are reference counted and
+can be read by any number of threads without locking. Values are not owned by the trie.
+All versions derived from the same empty trie share a pool of node memory, which is
+released together with the last version.
+
+A root publishes the current version for read-mostly data shared between threads.
+Lookups through the root never block, and a version acquired from the root stays valid
+until released. Publishing a new version swaps the root pointer and releases the previous
+version once no reader can still be accessing it through the root. Writers are serialized
+and wait for readers in progress, so updates should be rare compared to reads. */
+
+#include <foundation/platform.h>
+#include <foundation/types.h>
+
+/*! Allocate an empty trie version with one reference, to be released with a call to
+#hamt_release
+\return New empty trie */
+FOUNDATION_API hamt_t*
+hamt_allocate(void);
+
+/*! Add a reference to a trie version
+\param map Trie
+\return Trie */
+FOUNDATION_API hamt_t*
+hamt_acquire(hamt_t* map);
+
+/*! Release a reference to a trie version, freeing the version and all nodes no longer
+shared with other versions when the last reference is released
+\param map Trie, may be null */
+FOUNDATION_API void
+hamt_release(hamt_t* map);
+
+/*! Create a new trie version with the key set to the given value, leaving the given
+version unchanged. If the key already has the value the given version is returned with
+an added reference
+\param map Trie
+\param key Key
+\param value Value
+\return New trie with one reference, to be released with a call to #hamt_release */
+FOUNDATION_API hamt_t*
+hamt_set(hamt_t* map, hash_t key, void* value);
+
+/*! Create a new trie version without the given key, leaving the given version unchanged.
+If the key does not exist the given version is returned with an added reference
+\param map Trie
+\param key Key
+\return New trie with one reference, to be released with a call to #hamt_release */
+FOUNDATION_API hamt_t*
+hamt_erase(hamt_t* map, hash_t key);
+
+/*! Lookup the value for a key
+\param map Trie
+\param key Key
+\return Value, null if key does not exist */
+FOUNDATION_API void*
+hamt_lookup(const hamt_t* map, hash_t key);
+
+/*! Query if a key exists
+\param map Trie
+\param key Key
+\return true if key exists, false if not */
+FOUNDATION_API bool
+hamt_has_key(const hamt_t* map, hash_t key);
+
+/*! Get number of keys
+\param map Trie
+\return Number of keys */
+FOUNDATION_API size_t
+hamt_size(const hamt_t* map);
+
+/*! Call a function for each key and value. The order of iteration depends only on
+the keys in the trie
+\param map Trie
+\param fn Iteration function
+\param data Data passed to the iteration function
+\return 0 if all entries were iterated, otherwise the non-zero value returned by the
+        iteration function that stopped iteration */
+FOUNDATION_API int
+hamt_foreach(const hamt_t* map, hamt_foreach_fn fn, void* data);
+
+/*! Allocate a root publishing a trie. The root should be deallocated with a call to
+#hamt_root_deallocate
+\param map Initial trie, the reference is transferred to the root. Null for an empty trie
+\return New root */
+FOUNDATION_API hamt_root_t*
+hamt_root_allocate(hamt_t* map);
+
+/*! Deallocate a root previously allocated with #hamt_root_allocate, releasing the
+published trie. The root must not be accessed by any thread while being deallocated
+\param root Root */
+FOUNDATION_API void
+hamt_root_deallocate(hamt_root_t* root);
+
+/*! Initialize a root publishing a trie. The root should be finalized with a call to
+#hamt_root_finalize
+\param root Root
+\param map Initial trie, the reference is transferred to the root. Null for an empty trie */
+FOUNDATION_API void
+hamt_root_initialize(hamt_root_t* root, hamt_t* map);
+
+/*! Finalize a root previously initialized with #hamt_root_initialize, releasing the
+published trie. The root must not be accessed by any thread while being finalized
+\param root Root */
+FOUNDATION_API void
+hamt_root_finalize(hamt_root_t* root);
+
+/*! Lookup the value for a key in the currently published trie, without blocking
+\param root Root
+\param key Key
+\return Value, null if key does not exist */
+FOUNDATION_API void*
+hamt_root_lookup(hamt_root_t* root, hash_t key);
+
+/*! Acquire a reference to the currently published trie, without blocking. Use to read
+a consistent snapshot of several keys
+\param root Root
+\return Trie, to be released with a call to #hamt_release */
+FOUNDATION_API hamt_t*
+hamt_root_acquire(hamt_root_t* root);
+
+/*! Publish a new trie if the currently published trie is the expected one. Waits for
+readers of the previous trie through the root to finish before releasing the root
+reference to the previous trie
+\param root Root
+\param expected Expected current trie, usually acquired with #hamt_root_acquire
+\param map New trie. The reference is transferred to the root if published
+\return true if published, false if the current trie was not the expected one in which
+        case the caller keeps the reference to the new trie */
+FOUNDATION_API bool
+hamt_root_publish(hamt_root_t* root, const hamt_t* expected, hamt_t* map);
+
+/*! Set a key to a value and publish the resulting trie, retrying on concurrent updates
+\param root Root
+\param key Key
+\param value Value */
+FOUNDATION_API void
+hamt_root_set(hamt_root_t* root, hash_t key, void* value);
+
+/*! Erase a key and publish the resulting trie, retrying on concurrent updates
+\param root Root
+\param key Key
+\return true if key was erased, false if key did not exist */
+FOUNDATION_API bool
+hamt_root_erase(hamt_root_t* root, hash_t key);
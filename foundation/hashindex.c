@@ -0,0 +1,525 @@
+/* hashindex.c  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+
+#define HASHINDEX_MAGIC        0x5844494853414846ULL
+#define HASHINDEX_VERSION      1
+#define HASHINDEX_PAGE_SIZE    4096
+#define HASHINDEX_PAGE_SLOTS   255
+//Two header copies in first page, written alternately
+#define HASHINDEX_HEADER_SLOT  2048
+#define HASHINDEX_BASE_BUCKETS 16
+#define HASHINDEX_TOMBSTONE    0xFFFFFFFFFFFFFFFFULL
+//Maximum load factor in percent before splitting a bucket
+#define HASHINDEX_MAX_LOAD     75
+
+typedef struct hashindex_header_t hashindex_header_t;
+typedef struct hashindex_slot_t hashindex_slot_t;
+typedef struct hashindex_page_t hashindex_page_t;
+
+struct hashindex_header_t {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t page_size;
+	uint64_t sequence;
+	uint64_t count;
+	uint64_t num_pages;
+	uint64_t base;
+	uint64_t split;
+	uint32_t level;
+	uint32_t dirty;
+	uint64_t segment[HASHINDEX_MAX_SEGMENTS];
+	uint64_t checksum;
+};
+
+struct hashindex_slot_t {
+	uint64_t key;
+	uint64_t value;
+};
+
+struct hashindex_page_t {
+	//Next page in bucket chain, zero for last page
+	uint64_t overflow;
+	//Bucket index + 1 for overflow pages, zero for primary bucket pages
+	uint64_t owner;
+	hashindex_slot_t slot[HASHINDEX_PAGE_SLOTS];
+};
+
+FOUNDATION_STATIC_ASSERT(sizeof(hashindex_page_t) == HASHINDEX_PAGE_SIZE, "Invalid hash index page size");
+FOUNDATION_STATIC_ASSERT(sizeof(hashindex_header_t) <= HASHINDEX_HEADER_SLOT, "Invalid hash index header size");
+
+static FOUNDATION_FORCEINLINE uint64_t
+_hashindex_mix(uint64_t key) {
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ULL;
+	key ^= key >> 33;
+	return key;
+}
+
+static FOUNDATION_FORCEINLINE bool
+_hashindex_valid_key(uint64_t key) {
+	return key && (key != HASHINDEX_TOMBSTONE);
+}
+
+static FOUNDATION_FORCEINLINE uint64_t
+_hashindex_bucket(uint64_t mixed, uint64_t base, unsigned int level, uint64_t split) {
+	uint64_t bucket = mixed & ((base << level) - 1);
+	if (bucket < split)
+		bucket = mixed & ((base << (level + 1)) - 1);
+	return bucket;
+}
+
+static FOUNDATION_FORCEINLINE uint64_t
+_hashindex_current_bucket(const hashindex_t* index, uint64_t mixed) {
+	return _hashindex_bucket(mixed, index->base, index->level, index->split);
+}
+
+static FOUNDATION_FORCEINLINE unsigned int
+_hashindex_slot_start(uint64_t mixed) {
+	return (unsigned int)(((mixed >> 32) * HASHINDEX_PAGE_SLOTS) >> 32);
+}
+
+static FOUNDATION_FORCEINLINE hashindex_page_t*
+_hashindex_page(const hashindex_t* index, uint64_t page) {
+	return pointer_offset(index->map.data, (size_t)page * HASHINDEX_PAGE_SIZE);
+}
+
+static uint64_t
+_hashindex_bucket_page(const hashindex_t* index, uint64_t bucket) {
+	unsigned int isegment = 0;
+	uint64_t first = 0;
+	if (bucket >= index->base) {
+		first = index->base;
+		isegment = 1;
+		while (bucket >= (first << 1)) {
+			first <<= 1;
+			++isegment;
+		}
+	}
+	return index->segment[isegment] + (bucket - first);
+}
+
+static FOUNDATION_FORCEINLINE uint64_t
+_hashindex_overflow(const hashindex_t* index, const hashindex_page_t* page, uint64_t bucket) {
+	//Links written after the last commit may point to pages discarded after a crash or
+	//since reused, only follow links to pages owned by the same bucket
+	uint64_t next = page->overflow;
+	if (next && (next < index->num_pages) && (_hashindex_page(index, next)->owner == bucket + 1))
+		return next;
+	return 0;
+}
+
+static const hashindex_header_t*
+_hashindex_header(const hashindex_t* index) {
+	const hashindex_header_t* valid = nullptr;
+	unsigned int icopy;
+	if (index->map.size < HASHINDEX_PAGE_SIZE)
+		return nullptr;
+	for (icopy = 0; icopy < 2; ++icopy) {
+		const hashindex_header_t* header = pointer_offset_const(index->map.data, icopy * HASHINDEX_HEADER_SLOT);
+		if ((header->magic != HASHINDEX_MAGIC) || (header->version != HASHINDEX_VERSION) ||
+		    (header->page_size != HASHINDEX_PAGE_SIZE))
+			continue;
+		if (header->checksum != hash(header, offsetof(hashindex_header_t, checksum)))
+			continue;
+		if ((header->level + 1 >= HASHINDEX_MAX_SEGMENTS) || !header->base ||
+		    (header->num_pages > index->map.size / HASHINDEX_PAGE_SIZE))
+			continue;
+		if (!valid || (header->sequence > valid->sequence))
+			valid = header;
+	}
+	return valid;
+}
+
+static bool
+_hashindex_write_header(hashindex_t* index) {
+	hashindex_header_t header;
+	memset(&header, 0, sizeof(header));
+	header.magic = HASHINDEX_MAGIC;
+	header.version = HASHINDEX_VERSION;
+	header.page_size = HASHINDEX_PAGE_SIZE;
+	header.sequence = ++index->sequence;
+	header.count = index->count;
+	header.num_pages = index->num_pages;
+	header.base = index->base;
+	header.split = index->split;
+	header.level = index->level;
+	header.dirty = index->dirty ? 1 : 0;
+	memcpy(header.segment, index->segment, sizeof(header.segment));
+	header.checksum = hash(&header, offsetof(hashindex_header_t, checksum));
+
+	//Overwrite the older copy, the newer copy stays valid if the write is torn
+	memcpy(pointer_offset(index->map.data, (header.sequence & 1) * HASHINDEX_HEADER_SLOT), &header,
+	       sizeof(header));
+	return fs_map_flush(&index->map, 0, HASHINDEX_PAGE_SIZE);
+}
+
+static void
+_hashindex_modify(hashindex_t* index) {
+	//Mark the file dirty before the first modification since the last commit, the key
+	//count is recalculated when opening an index not closed cleanly
+	if (index->dirty)
+		return;
+	index->dirty = true;
+	_hashindex_write_header(index);
+}
+
+static uint64_t
+_hashindex_allocate(hashindex_t* index, uint64_t count) {
+	uint64_t first = index->num_pages;
+	uint64_t needed = (first + count) * HASHINDEX_PAGE_SIZE;
+	if (needed > index->map.size) {
+		//Grow the file geometrically to amortize remapping, new pages are zero filled
+		uint64_t size = (uint64_t)index->map.size + (index->map.size / 2);
+		size -= size % HASHINDEX_PAGE_SIZE;
+		if (size < needed)
+			size = needed;
+		if ((size != (size_t)size) || !fs_map_resize(&index->map, (size_t)size))
+			return 0;
+	}
+	index->num_pages += count;
+	return first;
+}
+
+static unsigned int
+_hashindex_find_free(const hashindex_t* index, const hashindex_page_t* page, unsigned int start,
+                     uint64_t bucket) {
+	unsigned int islot = start;
+	unsigned int iprobe;
+	for (iprobe = 0; iprobe < HASHINDEX_PAGE_SLOTS; ++iprobe) {
+		uint64_t key = page->slot[islot].key;
+		if (!_hashindex_valid_key(key))
+			return islot;
+		//Keys left behind by a split are reusable once the split is committed, when the
+		//key belongs to another bucket in both the current and committed layout
+		{
+			uint64_t mixed = _hashindex_mix(key);
+			if ((_hashindex_current_bucket(index, mixed) != bucket) &&
+			    (_hashindex_bucket(mixed, index->base, index->committed_level, index->committed_split) != bucket))
+				return islot;
+		}
+		if (++islot == HASHINDEX_PAGE_SLOTS)
+			islot = 0;
+	}
+	return HASHINDEX_PAGE_SLOTS;
+}
+
+static hashindex_slot_t*
+_hashindex_find(const hashindex_t* index, uint64_t key, uint64_t mixed) {
+	uint64_t bucket = _hashindex_current_bucket(index, mixed);
+	uint64_t ipage = _hashindex_bucket_page(index, bucket);
+	unsigned int start = _hashindex_slot_start(mixed);
+	while (ipage) {
+		hashindex_page_t* page = _hashindex_page(index, ipage);
+		unsigned int islot = start;
+		unsigned int iprobe;
+		for (iprobe = 0; iprobe < HASHINDEX_PAGE_SLOTS; ++iprobe) {
+			uint64_t slotkey = page->slot[islot].key;
+			if (slotkey == key)
+				return page->slot + islot;
+			if (!slotkey)
+				return nullptr;
+			if (++islot == HASHINDEX_PAGE_SLOTS)
+				islot = 0;
+		}
+		ipage = _hashindex_overflow(index, page, bucket);
+	}
+	return nullptr;
+}
+
+static bool
+_hashindex_insert(hashindex_t* index, uint64_t key, uint64_t value, uint64_t mixed, uint64_t bucket) {
+	uint64_t ipage = _hashindex_bucket_page(index, bucket);
+	unsigned int start = _hashindex_slot_start(mixed);
+	unsigned int islot = HASHINDEX_PAGE_SLOTS;
+	hashindex_page_t* page;
+	while (true) {
+		uint64_t next;
+		page = _hashindex_page(index, ipage);
+		islot = _hashindex_find_free(index, page, start, bucket);
+		if (islot < HASHINDEX_PAGE_SLOTS)
+			break;
+		next = _hashindex_overflow(index, page, bucket);
+		if (!next)
+			break;
+		ipage = next;
+	}
+
+	if (islot == HASHINDEX_PAGE_SLOTS) {
+		//Bucket chain is full, append an overflow page. Allocation may remap the file
+		uint64_t inew = _hashindex_allocate(index, 1);
+		if (!inew)
+			return false;
+		page = _hashindex_page(index, inew);
+		page->owner = bucket + 1;
+		_hashindex_page(index, ipage)->overflow = inew;
+		islot = start;
+	}
+
+	page->slot[islot].value = value;
+	page->slot[islot].key = key;
+	return true;
+}
+
+static void
+_hashindex_rollback(hashindex_t* index, uint64_t num_pages, uint64_t split, unsigned int level) {
+	//Restore the previous layout and release pages allocated since, clearing them since
+	//allocated pages are expected to be zero filled
+	if (index->num_pages > num_pages)
+		memset(_hashindex_page(index, num_pages), 0,
+		       (size_t)(index->num_pages - num_pages) * HASHINDEX_PAGE_SIZE);
+	index->num_pages = num_pages;
+	index->split = split;
+	index->level = level;
+}
+
+static bool
+_hashindex_split(hashindex_t* index) {
+	uint64_t bucket = index->split;
+	uint64_t buckets = index->base << index->level;
+	uint64_t target = buckets + bucket;
+	uint64_t num_pages = index->num_pages;
+	unsigned int level = index->level;
+	uint64_t ipage;
+
+	if (!bucket) {
+		uint64_t first;
+		//Bucket chains keep growing once the maximum number of segments is reached
+		if (index->level + 2 >= HASHINDEX_MAX_SEGMENTS)
+			return true;
+		first = _hashindex_allocate(index, buckets);
+		if (!first)
+			return false;
+		index->segment[index->level + 1] = first;
+	}
+
+	//Clear the new bucket page, it may hold data from an uncommitted split before a crash
+	memset(_hashindex_page(index, _hashindex_bucket_page(index, target)), 0, HASHINDEX_PAGE_SIZE);
+
+	//Advance the split pointer for the copy so keys in the new bucket are not treated as
+	//reusable slots, and roll back if the copy fails to keep the old bucket reachable
+	if (++index->split == buckets) {
+		++index->level;
+		index->split = 0;
+	}
+
+	//Copy keys belonging to the new bucket, leaving the old bucket untouched until the
+	//split is committed. Page pointers are refreshed since inserting may remap the file
+	ipage = _hashindex_bucket_page(index, bucket);
+	while (ipage) {
+		unsigned int islot;
+		for (islot = 0; islot < HASHINDEX_PAGE_SLOTS; ++islot) {
+			const hashindex_slot_t* slot = _hashindex_page(index, ipage)->slot + islot;
+			uint64_t key = slot->key;
+			uint64_t mixed;
+			if (!_hashindex_valid_key(key))
+				continue;
+			mixed = _hashindex_mix(key);
+			if (_hashindex_current_bucket(index, mixed) != target)
+				continue;
+			if (!_hashindex_insert(index, key, slot->value, mixed, target)) {
+				_hashindex_rollback(index, num_pages, bucket, level);
+				return false;
+			}
+		}
+		ipage = _hashindex_overflow(index, _hashindex_page(index, ipage), bucket);
+	}
+	return true;
+}
+
+static void
+_hashindex_recount(hashindex_t* index) {
+	uint64_t buckets = (index->base << index->level) + index->split;
+	uint64_t bucket;
+	index->count = 0;
+	for (bucket = 0; bucket < buckets; ++bucket) {
+		uint64_t ipage = _hashindex_bucket_page(index, bucket);
+		while (ipage) {
+			const hashindex_page_t* page = _hashindex_page(index, ipage);
+			unsigned int islot;
+			for (islot = 0; islot < HASHINDEX_PAGE_SLOTS; ++islot) {
+				uint64_t key = page->slot[islot].key;
+				if (_hashindex_valid_key(key) &&
+				    (_hashindex_current_bucket(index, _hashindex_mix(key)) == bucket))
+					++index->count;
+			}
+			ipage = _hashindex_overflow(index, page, bucket);
+		}
+	}
+}
+
+static bool
+_hashindex_create(hashindex_t* index) {
+	index->base = HASHINDEX_BASE_BUCKETS;
+	index->num_pages = 1;
+	index->segment[0] = _hashindex_allocate(index, index->base);
+	if (!index->segment[0])
+		return false;
+	index->dirty = true;
+	return hashindex_commit(index);
+}
+
+static bool
+_hashindex_load(hashindex_t* index) {
+	const hashindex_header_t* header = _hashindex_header(index);
+	bool dirty;
+	if (!header)
+		return false;
+
+	index->sequence = header->sequence;
+	index->count = header->count;
+	index->num_pages = header->num_pages;
+	index->base = header->base;
+	index->split = header->split;
+	index->level = header->level;
+	index->committed_split = index->split;
+	index->committed_level = index->level;
+	memcpy(index->segment, header->segment, sizeof(index->segment));
+	dirty = (header->dirty != 0);
+
+	if (dirty)
+		_hashindex_recount(index);
+
+	if (index->map.mode & STREAM_OUT) {
+		//Discard pages appended after the last commit
+		if (index->map.size != index->num_pages * HASHINDEX_PAGE_SIZE) {
+			if (!fs_map_resize(&index->map, (size_t)(index->num_pages * HASHINDEX_PAGE_SIZE)))
+				return false;
+		}
+		//Write a clean header on next commit
+		index->dirty = dirty;
+	}
+	return true;
+}
+
+hashindex_t*
+hashindex_open(const char* path, size_t length, unsigned int mode) {
+	hashindex_t* index = memory_allocate(0, sizeof(hashindex_t), 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	bool success;
+	if (!fs_map_file(&index->map, path, length, mode)) {
+		memory_deallocate(index);
+		return nullptr;
+	}
+
+	if (!index->map.size)
+		success = (mode & STREAM_OUT) && _hashindex_create(index);
+	else
+		success = _hashindex_load(index);
+
+	if (!success) {
+		log_errorf(0, ERROR_INVALID_VALUE, STRING_CONST("Unable to open hash index: %.*s"), (int)length, path);
+		fs_unmap_file(&index->map);
+		memory_deallocate(index);
+		return nullptr;
+	}
+	return index;
+}
+
+void
+hashindex_close(hashindex_t* index) {
+	if (!index)
+		return;
+	if (index->map.mode & STREAM_OUT) {
+		size_t size = (size_t)(index->num_pages * HASHINDEX_PAGE_SIZE);
+		hashindex_commit(index);
+		if (index->map.size > size)
+			fs_map_resize(&index->map, size);
+	}
+	fs_unmap_file(&index->map);
+	memory_deallocate(index);
+}
+
+bool
+hashindex_set(hashindex_t* index, uint64_t key, uint64_t value) {
+	hashindex_slot_t* slot;
+	uint64_t mixed;
+	uint64_t buckets;
+	if (!(index->map.mode & STREAM_OUT)) {
+		log_error(0, ERROR_ACCESS_DENIED, STRING_CONST("Unable to modify read only hash index"));
+		return false;
+	}
+	if (!_hashindex_valid_key(key)) {
+		log_errorf(0, ERROR_INVALID_VALUE, STRING_CONST("Invalid hash index key: %" PRIx64), key);
+		return false;
+	}
+
+	mixed = _hashindex_mix(key);
+	_hashindex_modify(index);
+	slot = _hashindex_find(index, key, mixed);
+	if (slot) {
+		slot->value = value;
+		return true;
+	}
+
+	//Split before inserting, so the key is not stored if the index fails to grow
+	buckets = (index->base << index->level) + index->split;
+	if ((index->count + 1) * 100 > buckets * HASHINDEX_PAGE_SLOTS * HASHINDEX_MAX_LOAD) {
+		if (!_hashindex_split(index))
+			return false;
+	}
+
+	if (!_hashindex_insert(index, key, value, mixed, _hashindex_current_bucket(index, mixed)))
+		return false;
+	++index->count;
+	return true;
+}
+
+bool
+hashindex_lookup(const hashindex_t* index, uint64_t key, uint64_t* value) {
+	const hashindex_slot_t* slot;
+	if (!_hashindex_valid_key(key))
+		return false;
+	slot = _hashindex_find(index, key, _hashindex_mix(key));
+	if (!slot)
+		return false;
+	if (value)
+		*value = slot->value;
+	return true;
+}
+
+bool
+hashindex_erase(hashindex_t* index, uint64_t key) {
+	hashindex_slot_t* slot;
+	if (!(index->map.mode & STREAM_OUT) || !_hashindex_valid_key(key))
+		return false;
+	slot = _hashindex_find(index, key, _hashindex_mix(key));
+	if (!slot)
+		return false;
+	_hashindex_modify(index);
+	slot->key = HASHINDEX_TOMBSTONE;
+	--index->count;
+	return true;
+}
+
+size_t
+hashindex_size(const hashindex_t* index) {
+	return (size_t)index->count;
+}
+
+bool
+hashindex_commit(hashindex_t* index) {
+	if (!(index->map.mode & STREAM_OUT) || !index->dirty)
+		return true;
+	if (!fs_map_flush(&index->map, HASHINDEX_PAGE_SIZE, index->map.size))
+		return false;
+	index->dirty = false;
+	if (!_hashindex_write_header(index)) {
+		index->dirty = true;
+		return false;
+	}
+	index->committed_split = index->split;
+	index->committed_level = index->level;
+	return true;
+}
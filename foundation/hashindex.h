@@ -0,0 +1,88 @@
+/* hashindex.h  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#pragma once
+
+/*! \file hashindex.h
+\brief Persistent hash index in a memory mapped file
+
+On-disk hash index mapping 64-bit keys to 64-bit values, typically file offsets. The index
+file is mapped into memory, opening an existing index only reads the header and a lookup
+only touches the pages of the bucket holding the key. Buckets are one page of open
+addressed slots, and the index grows one bucket at a time with linear hashing, appending
+pages to the end of the file.
+
+Modifications are written in place and made durable with #hashindex_commit, which flushes
+modified pages and then writes a new header. The header is double buffered and
+checksummed, so after a crash the index is opened with the last committed layout. Buckets
+are split without removing keys from the old bucket until the split is committed, so a
+crash never loses committed keys. Modifications made after the last commit may or may not
+be present after a crash. Keys must be non-zero and not all bits set. The file is in host
+byte order.
+
+Access is not atomic and therefor not thread safe. Concurrent lookups are safe as long
+as the index is not modified. */
+
+#include <foundation/platform.h>
+#include <foundation/types.h>
+
+/*! Open a hash index file, creating an empty index if the file is empty. The index should
+be closed with a call to #hashindex_close
+\param path Path of index file
+\param length Length of path
+\param mode Open mode, STREAM_IN for read only access and STREAM_OUT for read and write
+            access. STREAM_CREATE creates the file if it does not exist, STREAM_TRUNCATE
+            discards any existing index
+\return Index, null if file could not be opened or is not a valid index */
+FOUNDATION_API hashindex_t*
+hashindex_open(const char* path, size_t length, unsigned int mode);
+
+/*! Close an index, committing any modifications
+\param index Index */
+FOUNDATION_API void
+hashindex_close(hashindex_t* index);
+
+/*! Set value for a key, inserting the key if it does not exist
+\param index Index opened for writing
+\param key Key, must be non-zero and not all bits set
+\param value Value
+\return true if successful, false if index is read only, key is invalid or the file could
+        not be grown */
+FOUNDATION_API bool
+hashindex_set(hashindex_t* index, uint64_t key, uint64_t value);
+
+/*! Lookup the value for a key
+\param index Index
+\param key Key
+\param value Receives value if key exists, may be null
+\return true if key exists, false if not */
+FOUNDATION_API bool
+hashindex_lookup(const hashindex_t* index, uint64_t key, uint64_t* value);
+
+/*! Erase a key
+\param index Index opened for writing
+\param key Key
+\return true if key was erased, false if key did not exist or index is read only */
+FOUNDATION_API bool
+hashindex_erase(hashindex_t* index, uint64_t key);
+
+/*! Get number of keys
+\param index Index
+\return Number of keys */
+FOUNDATION_API size_t
+hashindex_size(const hashindex_t* index);
+
+/*! Make all modifications durable, flushing modified pages before writing a new header
+\param index Index
+\return true if successful, false if pages or header could not be flushed */
+FOUNDATION_API bool
+hashindex_commit(hashindex_t* index);
@@ -139,3 +139,285 @@ hashmap_clear(hashmap_t* map) {
 		array_clear(map->bucket[ibucket]);
 	map->num_nodes = 0;
 }
+
+#define HASHMAP_CONCURRENT_DEFAULTSHARDS 16
+#define HASHMAP_CONCURRENT_MINCAPACITY   16
+
+static FOUNDATION_FORCEINLINE hash_t
+_hashmap_concurrent_mix(hash_t key) {
+	//Keys are usually hashes already, mix anyway to spread sequential keys across shards
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ULL;
+	key ^= key >> 33;
+	return key;
+}
+
+static FOUNDATION_FORCEINLINE hashmap_concurrent_shard_t*
+_hashmap_concurrent_shard(hashmap_concurrent_t* map, hash_t mixed) {
+	//Shard is selected by high bits, table slot by low bits
+	return map->shard + ((mixed >> 32) & (map->num_shards - 1));
+}
+
+static size_t
+_hashmap_concurrent_round_pow2(size_t value) {
+	size_t pow2 = 1;
+	while (pow2 < value)
+		pow2 <<= 1;
+	return pow2;
+}
+
+static hashmap_concurrent_table_t*
+_hashmap_concurrent_table_allocate(size_t capacity) {
+	hashmap_concurrent_table_t* table = memory_allocate(0, sizeof(hashmap_concurrent_table_t) +
+	                                                    sizeof(hashmap_concurrent_entry_t) * capacity, 0,
+	                                                    MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	table->capacity = capacity;
+	return table;
+}
+
+static void
+_hashmap_concurrent_lock(hashmap_concurrent_shard_t* shard) {
+	unsigned int spin = 0;
+	while (!atomic_cas32(&shard->lock, 1, 0)) {
+		if (++spin > 64)
+			thread_yield();
+	}
+}
+
+static void
+_hashmap_concurrent_unlock(hashmap_concurrent_shard_t* shard) {
+	atomic_thread_fence_release();
+	atomic_store32(&shard->lock, 0);
+}
+
+static void
+_hashmap_concurrent_write_begin(hashmap_concurrent_shard_t* shard) {
+	atomic_incr32(&shard->sequence);
+	atomic_thread_fence_release();
+}
+
+static void
+_hashmap_concurrent_write_end(hashmap_concurrent_shard_t* shard) {
+	atomic_thread_fence_release();
+	atomic_incr32(&shard->sequence);
+}
+
+//Find slot holding key, or empty slot terminating the probe sequence. Called with the
+//shard lock held, or by readers validating the result with the sequence counter
+static size_t
+_hashmap_concurrent_probe(hashmap_concurrent_table_t* table, hash_t key, hash_t mixed) {
+	size_t mask = table->capacity - 1;
+	size_t islot = (size_t)mixed & mask;
+	size_t iprobe;
+	for (iprobe = 0; iprobe < table->capacity; ++iprobe, islot = (islot + 1) & mask) {
+		hashmap_concurrent_entry_t* entry = table->entries + islot;
+		if (!atomic_load_ptr(&entry->value) || ((hash_t)atomic_load64(&entry->key) == key))
+			return islot;
+	}
+	return table->capacity;
+}
+
+static void
+_hashmap_concurrent_grow(hashmap_concurrent_shard_t* shard, hashmap_concurrent_table_t* table) {
+	hashmap_concurrent_table_t* grown = _hashmap_concurrent_table_allocate(table->capacity * 2);
+	size_t islot;
+	for (islot = 0; islot < table->capacity; ++islot) {
+		void* value = atomic_load_ptr(&table->entries[islot].value);
+		if (value) {
+			hash_t key = (hash_t)atomic_load64(&table->entries[islot].key);
+			size_t idst = _hashmap_concurrent_probe(grown, key, _hashmap_concurrent_mix(key));
+			atomic_store64(&grown->entries[idst].key, (int64_t)key);
+			atomic_store_ptr(&grown->entries[idst].value, value);
+		}
+	}
+	grown->retired = table;
+	//Readers holding the old table will fail sequence validation and retry on the new table
+	atomic_store_ptr(&shard->table, grown);
+}
+
+hashmap_concurrent_t*
+hashmap_concurrent_allocate(size_t shards, size_t capacity) {
+	hashmap_concurrent_t* map = memory_allocate(0, sizeof(hashmap_concurrent_t), 0,
+	                                            MEMORY_PERSISTENT);
+	hashmap_concurrent_initialize(map, shards, capacity);
+	return map;
+}
+
+void
+hashmap_concurrent_deallocate(hashmap_concurrent_t* map) {
+	hashmap_concurrent_finalize(map);
+	memory_deallocate(map);
+}
+
+void
+hashmap_concurrent_initialize(hashmap_concurrent_t* map, size_t shards, size_t capacity) {
+	size_t ishard;
+
+	shards = _hashmap_concurrent_round_pow2(shards ? shards : HASHMAP_CONCURRENT_DEFAULTSHARDS);
+	capacity = _hashmap_concurrent_round_pow2((capacity * 4) / (shards * 3) + 1);
+	if (capacity < HASHMAP_CONCURRENT_MINCAPACITY)
+		capacity = HASHMAP_CONCURRENT_MINCAPACITY;
+
+	map->num_shards = shards;
+	map->shard = memory_allocate(0, sizeof(hashmap_concurrent_shard_t) * shards, 64,
+	                             MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	for (ishard = 0; ishard < shards; ++ishard)
+		atomic_store_ptr(&map->shard[ishard].table, _hashmap_concurrent_table_allocate(capacity));
+}
+
+void
+hashmap_concurrent_finalize(hashmap_concurrent_t* map) {
+	size_t ishard;
+	for (ishard = 0; ishard < map->num_shards; ++ishard) {
+		hashmap_concurrent_table_t* table = atomic_load_ptr(&map->shard[ishard].table);
+		while (table) {
+			hashmap_concurrent_table_t* retired = table->retired;
+			memory_deallocate(table);
+			table = retired;
+		}
+	}
+	memory_deallocate(map->shard);
+	map->shard = 0;
+	map->num_shards = 0;
+}
+
+void*
+hashmap_concurrent_insert(hashmap_concurrent_t* map, hash_t key, void* value) {
+	hash_t mixed = _hashmap_concurrent_mix(key);
+	hashmap_concurrent_shard_t* shard = _hashmap_concurrent_shard(map, mixed);
+	hashmap_concurrent_table_t* table;
+	hashmap_concurrent_entry_t* entry;
+	void* prev;
+
+	if (!value)
+		return hashmap_concurrent_erase(map, key);
+
+	_hashmap_concurrent_lock(shard);
+
+	table = atomic_load_ptr(&shard->table);
+	entry = table->entries + _hashmap_concurrent_probe(table, key, mixed);
+	prev = atomic_load_ptr(&entry->value);
+	if (prev) {
+		//Replacing the value of an existing key is a single atomic store
+		atomic_store_ptr(&entry->value, value);
+	}
+	else {
+		_hashmap_concurrent_write_begin(shard);
+		if ((shard->count + 1) * 4 > table->capacity * 3) {
+			_hashmap_concurrent_grow(shard, table);
+			table = atomic_load_ptr(&shard->table);
+			entry = table->entries + _hashmap_concurrent_probe(table, key, mixed);
+		}
+		atomic_store64(&entry->key, (int64_t)key);
+		atomic_store_ptr(&entry->value, value);
+		++shard->count;
+		_hashmap_concurrent_write_end(shard);
+	}
+
+	_hashmap_concurrent_unlock(shard);
+
+	return prev;
+}
+
+void*
+hashmap_concurrent_erase(hashmap_concurrent_t* map, hash_t key) {
+	hash_t mixed = _hashmap_concurrent_mix(key);
+	hashmap_concurrent_shard_t* shard = _hashmap_concurrent_shard(map, mixed);
+	hashmap_concurrent_table_t* table;
+	size_t islot, inext, mask;
+	void* prev;
+
+	_hashmap_concurrent_lock(shard);
+
+	table = atomic_load_ptr(&shard->table);
+	islot = _hashmap_concurrent_probe(table, key, mixed);
+	prev = atomic_load_ptr(&table->entries[islot].value);
+	if (prev) {
+		//Backward shift deletion keeps probe sequences intact without tombstones
+		_hashmap_concurrent_write_begin(shard);
+		mask = table->capacity - 1;
+		for (inext = (islot + 1) & mask; atomic_load_ptr(&table->entries[inext].value);
+		        inext = (inext + 1) & mask) {
+			hash_t next_key = (hash_t)atomic_load64(&table->entries[inext].key);
+			size_t ihome = (size_t)_hashmap_concurrent_mix(next_key) & mask;
+			//Move entry into the hole if its home slot is not cyclically in (hole, next]
+			if (((inext - ihome) & mask) >= ((inext - islot) & mask)) {
+				atomic_store64(&table->entries[islot].key, (int64_t)next_key);
+				atomic_store_ptr(&table->entries[islot].value,
+				                 atomic_load_ptr(&table->entries[inext].value));
+				islot = inext;
+			}
+		}
+		atomic_store_ptr(&table->entries[islot].value, 0);
+		atomic_store64(&table->entries[islot].key, 0);
+		--shard->count;
+		_hashmap_concurrent_write_end(shard);
+	}
+
+	_hashmap_concurrent_unlock(shard);
+
+	return prev;
+}
+
+void*
+hashmap_concurrent_lookup(hashmap_concurrent_t* map, hash_t key) {
+	hash_t mixed = _hashmap_concurrent_mix(key);
+	hashmap_concurrent_shard_t* shard = _hashmap_concurrent_shard(map, mixed);
+	int32_t sequence;
+	void* value;
+	do {
+		hashmap_concurrent_table_t* table;
+		size_t islot;
+
+		sequence = atomic_load32(&shard->sequence);
+		atomic_thread_fence_acquire();
+		if (sequence & 1) {
+			thread_yield();
+			continue;
+		}
+
+		table = atomic_load_ptr(&shard->table);
+		islot = _hashmap_concurrent_probe(table, key, mixed);
+		value = (islot < table->capacity) ? atomic_load_ptr(&table->entries[islot].value) : 0;
+
+		atomic_thread_fence_acquire();
+	}
+	while ((sequence & 1) || (atomic_load32(&shard->sequence) != sequence));
+	return value;
+}
+
+bool
+hashmap_concurrent_has_key(hashmap_concurrent_t* map, hash_t key) {
+	return hashmap_concurrent_lookup(map, key) != 0;
+}
+
+size_t
+hashmap_concurrent_size(hashmap_concurrent_t* map) {
+	size_t ishard, count = 0;
+	for (ishard = 0; ishard < map->num_shards; ++ishard)
+		count += map->shard[ishard].count;
+	return count;
+}
+
+void
+hashmap_concurrent_clear(hashmap_concurrent_t* map) {
+	size_t ishard;
+	for (ishard = 0; ishard < map->num_shards; ++ishard) {
+		hashmap_concurrent_shard_t* shard = map->shard + ishard;
+		hashmap_concurrent_table_t* table;
+		size_t islot;
+
+		_hashmap_concurrent_lock(shard);
+		_hashmap_concurrent_write_begin(shard);
+		table = atomic_load_ptr(&shard->table);
+		for (islot = 0; islot < table->capacity; ++islot) {
+			atomic_store_ptr(&table->entries[islot].value, 0);
+			atomic_store64(&table->entries[islot].key, 0);
+		}
+		shard->count = 0;
+		_hashmap_concurrent_write_end(shard);
+		_hashmap_concurrent_unlock(shard);
+	}
+}
@@ -16,8 +16,13 @@
 \brief Simple container mapping hash values to pointers
 
 Simple container mapping hash values to pointers. Access is not atomic
-and therefor not thread safe. For a thread safe alternative look at hashtable.h
-instead, or provide external synchronization in caller. */
+and therefor not thread safe. For a thread safe alternative use the concurrent
+hash map (hashmap_concurrent_* functions) or look at hashtable.h instead, or provide
+external synchronization in caller.
+
+The concurrent hash map splits the key space into shards selected by key bits. Each
+shard is an open addressing table guarded by a writer lock, while lookups are lock
+free and validated by a per-shard sequence counter. Shards grow individually. */
 
 #include <foundation/platform.h>
 #include <foundation/types.h>
@@ -90,3 +95,76 @@ hashmap_size(hashmap_t* map);
 \param map Hash map */
 FOUNDATION_API void
 hashmap_clear(hashmap_t* map);
+
+/*! Allocate new concurrent hash map with the given number of shards and initial total
+capacity. Shard count is rounded up to a power of two, 0 for default (16). Shards grow
+as needed. Hash map should be deallocated with a call to #hashmap_concurrent_deallocate
+\param shards Shard count
+\param capacity Initial number of key-value mappings that can be stored without growing
+\return New concurrent hash map */
+FOUNDATION_API hashmap_concurrent_t*
+hashmap_concurrent_allocate(size_t shards, size_t capacity);
+
+/*! Deallocate a concurrent hash map previously allocated with #hashmap_concurrent_allocate
+\param map Hash map */
+FOUNDATION_API void
+hashmap_concurrent_deallocate(hashmap_concurrent_t* map);
+
+/*! Initialize new concurrent hash map with the given number of shards and initial total
+capacity, see #hashmap_concurrent_allocate. Hash map should be finalized with a call to
+#hashmap_concurrent_finalize
+\param map Hash map to initialize
+\param shards Shard count
+\param capacity Initial number of key-value mappings that can be stored without growing */
+FOUNDATION_API void
+hashmap_concurrent_initialize(hashmap_concurrent_t* map, size_t shards, size_t capacity);
+
+/*! Finalize a concurrent hash map previously initialized with #hashmap_concurrent_initialize
+and free resources. Must not be called concurrently with any other access to the map.
+\param map Hash map */
+FOUNDATION_API void
+hashmap_concurrent_finalize(hashmap_concurrent_t* map);
+
+/*! Insert a new key-value mapping. Will replace any previously stored mapping for the
+given key. Inserting a null value erases the mapping. Thread safe.
+\param map Hash map
+\param key Key
+\param value Value
+\return Previously stored value, 0 if no value previously stored for key */
+FOUNDATION_API void*
+hashmap_concurrent_insert(hashmap_concurrent_t* map, hash_t key, void* value);
+
+/*! Erase any value mapping for the given key. Thread safe.
+\param map Hash map
+\param key Key
+\return Previously stored value, 0 if no value previously stored for key */
+FOUNDATION_API void*
+hashmap_concurrent_erase(hashmap_concurrent_t* map, hash_t key);
+
+/*! Lookup the stored value mapping for the given key. Thread safe and lock free, retries
+if the shard is modified concurrently.
+\param map Hash map
+\param key Key
+\return Stored value, 0 if no value stored for key */
+FOUNDATION_API void*
+hashmap_concurrent_lookup(hashmap_concurrent_t* map, hash_t key);
+
+/*! Query if there is any value mapping stored for the given key. Thread safe.
+\param map Hash map
+\param key Key
+\return true if there is a value mapping stored for the key, false if not */
+FOUNDATION_API bool
+hashmap_concurrent_has_key(hashmap_concurrent_t* map, hash_t key);
+
+/*! Get the number of key-value mappings stored in the hash map. Only approximate if
+the map is modified concurrently.
+\param map Hash map
+\return Number of keys stored */
+FOUNDATION_API size_t
+hashmap_concurrent_size(hashmap_concurrent_t* map);
+
+/*! Clear map and erase all key-value mappings. Thread safe, but mappings inserted
+concurrently may or may not be erased.
+\param map Hash map */
+FOUNDATION_API void
+hashmap_concurrent_clear(hashmap_concurrent_t* map);
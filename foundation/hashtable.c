@@ -177,75 +177,113 @@ hashtable64_finalize(hashtable64_t* table) {
 	FOUNDATION_UNUSED(table);
 }
 
-bool
-hashtable64_set(hashtable64_t* table, uint64_t key, uint64_t value) {
+static hashtable64_entry_t*
+_hashtable64_find(hashtable64_t* table, uint64_t key) {
 	size_t ie, eend;
+	uint64_t current_key;
 
 	FOUNDATION_ASSERT(key);
 
 	ie = eend = _hashtable64_hash(key) % table->capacity;
 	do {
-		uint64_t current_key = (uint64_t)atomic_load64(&table->entries[ie].key);
+		current_key = (uint64_t)atomic_load64(&table->entries[ie].key);
 
-		if ((current_key == key) || (!current_key && atomic_cas64(&table->entries[ie].key, (int64_t)key, 0))) {
-			table->entries[ie].value = value;
-			return true;
-		}
+		if (current_key == key)
+			return table->entries + ie;
 
 		ie = (ie + 1) % table->capacity;
 	}
-	while (ie != eend);
+	while (current_key && (ie != eend));
 
-	return false;
+	return 0;
 }
 
-void
-hashtable64_erase(hashtable64_t* table, uint64_t key) {
+//Find the slot holding the key, claiming a free slot for it if not present. A failed
+//claim is re-checked since the competing thread might have claimed it for the same key
+static hashtable64_entry_t*
+_hashtable64_claim(hashtable64_t* table, uint64_t key) {
 	size_t ie, eend;
-	uint64_t current_key;
 
 	FOUNDATION_ASSERT(key);
 
 	ie = eend = _hashtable64_hash(key) % table->capacity;
 	do {
-		current_key = (uint64_t)atomic_load64(&table->entries[ie].key);
+		hashtable64_entry_t* entry = table->entries + ie;
+		uint64_t current_key = (uint64_t)atomic_load64(&entry->key);
 
-		if (current_key == key) {
-			table->entries[ie].value = 0;
-			return;
-		}
+		if (!current_key && !atomic_cas64(&entry->key, (int64_t)key, 0))
+			current_key = (uint64_t)atomic_load64(&entry->key);
+		else if (!current_key)
+			current_key = key;
+
+		if (current_key == key)
+			return entry;
 
 		ie = (ie + 1) % table->capacity;
 	}
-	while (current_key && (ie != eend));
+	while (ie != eend);
+
+	return 0;
+}
+
+bool
+hashtable64_set(hashtable64_t* table, uint64_t key, uint64_t value) {
+	hashtable64_entry_t* entry = _hashtable64_claim(table, key);
+	if (!entry)
+		return false;
+	atomic_store64(&entry->value, (int64_t)value);
+	return true;
 }
 
 uint64_t
-hashtable64_get(hashtable64_t* table, uint64_t key) {
-	size_t ie, eend;
-	uint64_t current_key;
+hashtable64_add(hashtable64_t* table, uint64_t key, int64_t add) {
+	hashtable64_entry_t* entry = _hashtable64_claim(table, key);
+	if (!entry)
+		return 0;
+	return (uint64_t)atomic_add64(&entry->value, add);
+}
 
-	FOUNDATION_ASSERT(key);
+bool
+hashtable64_cas(hashtable64_t* table, uint64_t key, uint64_t value, uint64_t ref) {
+	hashtable64_entry_t* entry = ref ? _hashtable64_find(table, key) : _hashtable64_claim(table, key);
+	if (!entry)
+		return false;
+	return atomic_cas64(&entry->value, (int64_t)value, (int64_t)ref);
+}
 
-	ie = eend = _hashtable64_hash(key) % table->capacity;
+uint64_t
+hashtable64_max(hashtable64_t* table, uint64_t key, uint64_t value) {
+	hashtable64_entry_t* entry = _hashtable64_claim(table, key);
+	uint64_t current;
+	if (!entry)
+		return 0;
 	do {
-		current_key = (uint64_t)atomic_load64(&table->entries[ie].key);
-
-		if (current_key == key)
-			return table->entries[ie].value;
-
-		ie = (ie + 1) % table->capacity;
+		current = (uint64_t)atomic_load64(&entry->value);
+		if (current >= value)
+			return current;
 	}
-	while (current_key && (ie != eend));
+	while (!atomic_cas64(&entry->value, (int64_t)value, (int64_t)current));
+	return value;
+}
 
-	return 0;
+void
+hashtable64_erase(hashtable64_t* table, uint64_t key) {
+	hashtable64_entry_t* entry = _hashtable64_find(table, key);
+	if (entry)
+		atomic_store64(&entry->value, 0);
+}
+
+uint64_t
+hashtable64_get(hashtable64_t* table, uint64_t key) {
+	hashtable64_entry_t* entry = _hashtable64_find(table, key);
+	return entry ? (uint64_t)atomic_load64(&entry->value) : 0;
 }
 
 uint64_t
 hashtable64_raw(hashtable64_t* table, size_t slot) {
 	if (!atomic_load64(&table->entries[slot].key))
 		return 0;
-	return table->entries[slot].value;
+	return (uint64_t)atomic_load64(&table->entries[slot].value);
 }
 
 size_t
@@ -253,7 +291,7 @@ hashtable64_size(hashtable64_t* table) {
 	size_t count = 0;
 	size_t ie;
 	for (ie = 0; ie < table->capacity; ++ie) {
-		if (atomic_load64(&table->entries[ie].key) && table->entries[ie].value)
+		if (atomic_load64(&table->entries[ie].key) && atomic_load64(&table->entries[ie].value))
 			++count;
 	}
 	return count;
@@ -263,3 +301,360 @@ void
 hashtable64_clear(hashtable64_t* table) {
 	memset(table->entries, 0, sizeof(hashtable64_entry_t) * table->capacity);
 }
+
+hashtable64_topk_t*
+hashtable64_topk_allocate(size_t buckets, size_t k) {
+	hashtable64_topk_t* topk = memory_allocate(0, sizeof(hashtable64_topk_t), 8, MEMORY_PERSISTENT);
+
+	hashtable64_topk_initialize(topk, buckets, k);
+
+	return topk;
+}
+
+void
+hashtable64_topk_deallocate(hashtable64_topk_t* topk) {
+	hashtable64_topk_finalize(topk);
+	memory_deallocate(topk);
+}
+
+void
+hashtable64_topk_initialize(hashtable64_topk_t* topk, size_t buckets, size_t k) {
+	topk->counts = hashtable64_allocate(buckets);
+	atomic_store64(&topk->threshold, 0);
+	topk->k = k;
+	topk->keys = memory_allocate(0, sizeof(atomic64_t) * k, 8,
+	                             MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+}
+
+void
+hashtable64_topk_finalize(hashtable64_topk_t* topk) {
+	hashtable64_deallocate(topk->counts);
+	memory_deallocate(topk->keys);
+	topk->counts = 0;
+	topk->keys = 0;
+}
+
+uint64_t
+hashtable64_topk_add(hashtable64_topk_t* topk, uint64_t key, uint64_t add) {
+	uint64_t count = hashtable64_add(topk->counts, key, (int64_t)add);
+	uint64_t min_count, next_count;
+	uint64_t min_key = 0;
+	size_t islot, min_slot = 0;
+
+	if (!count || (count <= (uint64_t)atomic_load64(&topk->threshold)))
+		return count;
+
+	for (islot = 0; islot < topk->k; ++islot) {
+		if ((uint64_t)atomic_load64(&topk->keys[islot]) == key)
+			return count;
+	}
+
+	//Replace the tracked key with the lowest count, and raise the threshold to the
+	//lowest count remaining in the set
+	min_count = next_count = (uint64_t)-1;
+	for (islot = 0; islot < topk->k; ++islot) {
+		uint64_t slot_key = (uint64_t)atomic_load64(&topk->keys[islot]);
+		uint64_t slot_count = slot_key ? hashtable64_get(topk->counts, slot_key) : 0;
+		if (slot_count < min_count) {
+			next_count = min_count;
+			min_count = slot_count;
+			min_slot = islot;
+			min_key = slot_key;
+		}
+		else if (slot_count < next_count) {
+			next_count = slot_count;
+		}
+	}
+
+	if ((count > min_count) &&
+	        atomic_cas64(&topk->keys[min_slot], (int64_t)key, (int64_t)min_key))
+		atomic_store64(&topk->threshold, (int64_t)((count < next_count) ? count : next_count));
+
+	return count;
+}
+
+uint64_t
+hashtable64_topk_count(hashtable64_topk_t* topk, uint64_t key) {
+	return hashtable64_get(topk->counts, key);
+}
+
+size_t
+hashtable64_topk_get(hashtable64_topk_t* topk, uint64_t* keys, uint64_t* counts, size_t capacity) {
+	size_t num_keys = 0;
+	size_t islot, ikey;
+
+	//Insertion sort by descending count, concurrent replacement might leave a key in two slots
+	for (islot = 0; islot < topk->k; ++islot) {
+		uint64_t key = (uint64_t)atomic_load64(&topk->keys[islot]);
+		uint64_t count;
+		if (!key)
+			continue;
+		for (ikey = 0; (ikey < num_keys) && (keys[ikey] != key); ++ikey)
+			;
+		if (ikey < num_keys)
+			continue;
+		count = hashtable64_get(topk->counts, key);
+		for (ikey = num_keys; (ikey > 0) && (counts[ikey - 1] < count); --ikey) {
+			if (ikey < capacity) {
+				keys[ikey] = keys[ikey - 1];
+				counts[ikey] = counts[ikey - 1];
+			}
+		}
+		if (ikey < capacity) {
+			keys[ikey] = key;
+			counts[ikey] = count;
+			if (num_keys < capacity)
+				++num_keys;
+		}
+	}
+
+	return num_keys;
+}
+
+void
+hashtable64_topk_clear(hashtable64_topk_t* topk) {
+	hashtable64_clear(topk->counts);
+	memset(topk->keys, 0, sizeof(atomic64_t) * topk->k);
+	atomic_store64(&topk->threshold, 0);
+}
+
+#if FOUNDATION_ARCH_X86_64 && (FOUNDATION_COMPILER_GCC || FOUNDATION_COMPILER_CLANG || FOUNDATION_COMPILER_MSVC)
+#  define HASHTABLE128_CAS16 1
+#else
+#  define HASHTABLE128_CAS16 0
+#endif
+
+#if FOUNDATION_COMPILER_GCC || FOUNDATION_COMPILER_CLANG
+#  define HASHTABLE128_PREFETCH(addr) __builtin_prefetch((addr), 0, 3)
+#elif FOUNDATION_ARCH_SSE2
+#  define HASHTABLE128_PREFETCH(addr) _mm_prefetch((const char*)(addr), _MM_HINT_T0)
+#else
+#  define HASHTABLE128_PREFETCH(addr) do { FOUNDATION_UNUSED(addr); } while (0)
+#endif
+
+//Number of keys ahead of the probing key that have their home slot prefetched
+#define HASHTABLE128_BATCH_DISTANCE 8
+
+static FOUNDATION_FORCEINLINE size_t
+_hashtable128_slot(const hashtable128_t* table, uint128_t key) {
+	return (size_t)(_hashtable64_hash(key.word[0] ^ (key.word[1] * 0x9e3779b97f4a7c15ULL)) %
+	                table->capacity);
+}
+
+#if HASHTABLE128_CAS16
+
+static FOUNDATION_FORCEINLINE bool
+_hashtable128_claim(hashtable128_t* table, hashtable128_entry_t* entry, uint128_t key) {
+	FOUNDATION_UNUSED(table);
+#  if FOUNDATION_COMPILER_MSVC
+	__int64 compare[2] = {0, 0};
+	return _InterlockedCompareExchange128((volatile __int64*)entry->key, (__int64)key.word[1],
+	                                      (__int64)key.word[0], compare) != 0;
+#  else
+	uint64_t expect_lo = 0, expect_hi = 0;
+	unsigned char swapped;
+	__asm__ __volatile__("lock; cmpxchg16b %1\n\tsetz %0"
+	                     : "=q"(swapped), "+m"(entry->key), "+a"(expect_lo), "+d"(expect_hi)
+	                     : "b"(key.word[0]), "c"(key.word[1])
+	                     : "cc", "memory");
+	return swapped != 0;
+#  endif
+}
+
+//A slot key only ever moves from null to a final value in a single 16-byte store. Reading
+//the low word again after the high word rules out observing a half published key
+static FOUNDATION_FORCEINLINE uint128_t
+_hashtable128_load(const hashtable128_t* table, const hashtable128_entry_t* entry) {
+	uint128_t key;
+	FOUNDATION_UNUSED(table);
+	do {
+		key.word[0] = (uint64_t)atomic_load64(&entry->key[0]);
+		atomic_thread_fence_acquire();
+		key.word[1] = (uint64_t)atomic_load64(&entry->key[1]);
+		atomic_thread_fence_acquire();
+	}
+	while (key.word[0] != (uint64_t)atomic_load64(&entry->key[0]));
+	return key;
+}
+
+#else
+
+static FOUNDATION_FORCEINLINE bool
+_hashtable128_claim(hashtable128_t* table, hashtable128_entry_t* entry, uint128_t key) {
+	bool claimed = false;
+	while (!atomic_cas32(&table->lock, 1, 0))
+		thread_yield();
+	if (!atomic_load64(&entry->key[0]) && !atomic_load64(&entry->key[1])) {
+		atomic_incr32(&table->sequence);
+		atomic_store64(&entry->key[0], (int64_t)key.word[0]);
+		atomic_store64(&entry->key[1], (int64_t)key.word[1]);
+		atomic_incr32(&table->sequence);
+		claimed = true;
+	}
+	atomic_store32(&table->lock, 0);
+	return claimed;
+}
+
+static FOUNDATION_FORCEINLINE uint128_t
+_hashtable128_load(const hashtable128_t* table, const hashtable128_entry_t* entry) {
+	uint128_t key;
+	int32_t sequence;
+	do {
+		while ((sequence = atomic_load32(&table->sequence)) & 1)
+			thread_yield();
+		atomic_thread_fence_acquire();
+		key.word[0] = (uint64_t)atomic_load64(&entry->key[0]);
+		key.word[1] = (uint64_t)atomic_load64(&entry->key[1]);
+		atomic_thread_fence_acquire();
+	}
+	while (sequence != atomic_load32(&table->sequence));
+	return key;
+}
+
+#endif
+
+static uint64_t
+_hashtable128_get(hashtable128_t* table, uint128_t key, size_t ie) {
+	size_t eend = ie;
+	uint128_t current_key;
+
+	do {
+		current_key = _hashtable128_load(table, table->entries + ie);
+
+		if (uint128_equal(current_key, key))
+			return table->entries[ie].value;
+
+		ie = (ie + 1) % table->capacity;
+	}
+	while (!uint128_is_null(current_key) && (ie != eend));
+
+	return 0;
+}
+
+hashtable128_t*
+hashtable128_allocate(size_t buckets) {
+	size_t size = sizeof(hashtable128_t) + sizeof(hashtable128_entry_t) * buckets;
+	hashtable128_t* table = memory_allocate(0, size, 16, MEMORY_PERSISTENT);
+
+	hashtable128_initialize(table, buckets);
+
+	return table;
+}
+
+void
+hashtable128_initialize(hashtable128_t* table, size_t buckets) {
+	memset(table, 0, sizeof(hashtable128_t) + sizeof(hashtable128_entry_t) * buckets);
+	table->capacity = buckets;
+}
+
+void
+hashtable128_deallocate(hashtable128_t* table) {
+	hashtable128_finalize(table);
+	memory_deallocate(table);
+}
+
+void
+hashtable128_finalize(hashtable128_t* table) {
+	FOUNDATION_UNUSED(table);
+}
+
+bool
+hashtable128_set(hashtable128_t* table, uint128_t key, uint64_t value) {
+	size_t ie, eend;
+
+	FOUNDATION_ASSERT(!uint128_is_null(key));
+
+	ie = eend = _hashtable128_slot(table, key);
+	do {
+		hashtable128_entry_t* entry = table->entries + ie;
+		uint128_t current_key = _hashtable128_load(table, entry);
+
+		if (uint128_is_null(current_key) && _hashtable128_claim(table, entry, key))
+			current_key = key;
+		else if (uint128_is_null(current_key))
+			current_key = _hashtable128_load(table, entry);
+
+		if (uint128_equal(current_key, key)) {
+			entry->value = value;
+			return true;
+		}
+
+		ie = (ie + 1) % table->capacity;
+	}
+	while (ie != eend);
+
+	return false;
+}
+
+void
+hashtable128_erase(hashtable128_t* table, uint128_t key) {
+	size_t ie, eend;
+	uint128_t current_key;
+
+	FOUNDATION_ASSERT(!uint128_is_null(key));
+
+	ie = eend = _hashtable128_slot(table, key);
+	do {
+		current_key = _hashtable128_load(table, table->entries + ie);
+
+		if (uint128_equal(current_key, key)) {
+			table->entries[ie].value = 0;
+			return;
+		}
+
+		ie = (ie + 1) % table->capacity;
+	}
+	while (!uint128_is_null(current_key) && (ie != eend));
+}
+
+uint64_t
+hashtable128_get(hashtable128_t* table, uint128_t key) {
+	FOUNDATION_ASSERT(!uint128_is_null(key));
+	return _hashtable128_get(table, key, _hashtable128_slot(table, key));
+}
+
+void
+hashtable128_get_batch(hashtable128_t* table, const uint128_t* keys, uint64_t* values,
+                       size_t count) {
+	size_t slot[HASHTABLE128_BATCH_DISTANCE];
+	size_t ikey, iahead;
+
+	//Keep a window of home slots in flight, prefetching the slot for key N + distance
+	//while probing key N
+	for (iahead = 0; (iahead < HASHTABLE128_BATCH_DISTANCE) && (iahead < count); ++iahead) {
+		slot[iahead] = _hashtable128_slot(table, keys[iahead]);
+		HASHTABLE128_PREFETCH(table->entries + slot[iahead]);
+	}
+
+	for (ikey = 0; ikey < count; ++ikey) {
+		size_t iwindow = ikey % HASHTABLE128_BATCH_DISTANCE;
+		size_t ie = slot[iwindow];
+
+		FOUNDATION_ASSERT(!uint128_is_null(keys[ikey]));
+
+		if (iahead < count) {
+			slot[iwindow] = _hashtable128_slot(table, keys[iahead]);
+			HASHTABLE128_PREFETCH(table->entries + slot[iwindow]);
+			++iahead;
+		}
+
+		values[ikey] = _hashtable128_get(table, keys[ikey], ie);
+	}
+}
+
+size_t
+hashtable128_size(hashtable128_t* table) {
+	size_t count = 0;
+	size_t ie;
+	for (ie = 0; ie < table->capacity; ++ie) {
+		if (!uint128_is_null(_hashtable128_load(table, table->entries + ie)) &&
+		        table->entries[ie].value)
+			++count;
+	}
+	return count;
+}
+
+void
+hashtable128_clear(hashtable128_t* table) {
+	memset(table->entries, 0, sizeof(hashtable128_entry_t) * table->capacity);
+}
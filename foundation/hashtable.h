@@ -16,14 +16,23 @@
 \brief Lock-free key-value mapping container
 
 Simple lock-free container mapping 32/64-bit keys to values. Fixed size, thread-safe.
-Limitation are:
+A 128-bit key variant maps uuid_t and other 128-bit keys to 64-bit values without
+folding the key. Limitation are:
 <ul>
-<li>Only maps 32/64 bit integers to 32/64 bit integers
+<li>Only maps 32/64/128 bit integers to 32/64 bit integers
 <li>All keys must be non-zero
 <li>Fixed maximum number of entries
-<li>Only operations are get/set
+<li>Only operations are get/set, and for 64-bit tables add/cas/max
 <li>No true erase operation, only set to zero
 </ul>
+The 64-bit table also provides atomic read-modify-write operations. #hashtable64_add adds
+to the stored value, #hashtable64_cas sets the value if it matches a reference value and
+#hashtable64_max raises the stored value to a given value. All of them insert the key if
+not present, treating the missing value as zero, so a cas with a zero reference value is
+an insert-if-absent operation. Note that #hashtable64_add and #hashtable64_max return zero
+if the table is full, which cannot be told apart from a legitimate zero result.
+#hashtable64_topk_allocate provides a tracker of the keys with the highest counts built on
+a 64-bit table and #hashtable64_add.
 \todo Look into a lock-free implementation of hopscotch hashing (http://en.wikipedia.org/wiki/Hopscotch_hashing) */
 
 #include <foundation/platform.h>
@@ -126,6 +135,37 @@ hashtable64_finalize(hashtable64_t* table);
 FOUNDATION_API bool
 hashtable64_set(hashtable64_t* table, uint64_t key, uint64_t value);
 
+/*! Atomically add to the stored value for the given key, inserting the key with
+an initial value of zero if not present
+\param table Hash table
+\param key Key
+\param add Value to add
+\return New value after addition, zero if table full (indistinguishable from a new value
+        of zero) */
+FOUNDATION_API uint64_t
+hashtable64_add(hashtable64_t* table, uint64_t key, int64_t add);
+
+/*! Atomically set the stored value for the given key if the current value matches the
+reference value. A reference value of zero matches a key not present in the table, making
+this an insert-if-absent operation
+\param table Hash table
+\param key Key
+\param value New value
+\param ref Reference value
+\return true if value set, false if current value did not match or table full */
+FOUNDATION_API bool
+hashtable64_cas(hashtable64_t* table, uint64_t key, uint64_t value, uint64_t ref);
+
+/*! Atomically raise the stored value for the given key to the given value, inserting
+the key if not present
+\param table Hash table
+\param key Key
+\param value Value
+\return Stored value after operation, the maximum of the previous and given value,
+        zero if table full */
+FOUNDATION_API uint64_t
+hashtable64_max(hashtable64_t* table, uint64_t key, uint64_t value);
+
 /*! Erase the value for a key by setting the value to zero. Erasing is limited by
 the key still holding a slot in the table.
 \param table Hash table
@@ -153,6 +193,138 @@ initial allocation.
 FOUNDATION_API void
 hashtable64_clear(hashtable64_t* table);
 
+/*! Allocate a tracker of the keys with the highest counts. The counts of all keys are
+stored in a 64-bit hash table of the given size. The tracker should be deallocated with
+a call to #hashtable64_topk_deallocate.
+\param buckets Number of buckets in count table
+\param k Number of keys to track
+\return New tracker */
+FOUNDATION_API hashtable64_topk_t*
+hashtable64_topk_allocate(size_t buckets, size_t k);
+
+/*! Deallocate a tracker previously allocated by a call to #hashtable64_topk_allocate
+\param topk Tracker */
+FOUNDATION_API void
+hashtable64_topk_deallocate(hashtable64_topk_t* topk);
+
+/*! Initialize a tracker of the keys with the highest counts. The tracker should be
+finalized with a call to #hashtable64_topk_finalize.
+\param topk Tracker
+\param buckets Number of buckets in count table
+\param k Number of keys to track */
+FOUNDATION_API void
+hashtable64_topk_initialize(hashtable64_topk_t* topk, size_t buckets, size_t k);
+
+/*! Finalize a tracker previously initialized by a call to #hashtable64_topk_initialize
+\param topk Tracker */
+FOUNDATION_API void
+hashtable64_topk_finalize(hashtable64_topk_t* topk);
+
+/*! Atomically add to the count for the given key and update the tracked set of keys.
+Lock-free and safe to call concurrently from any number of threads. Only keys with a
+count above the lowest tracked count touch the tracked set.
+\param topk Tracker
+\param key Key
+\param add Value to add to count
+\return New count for key, zero if count table full */
+FOUNDATION_API uint64_t
+hashtable64_topk_add(hashtable64_topk_t* topk, uint64_t key, uint64_t add);
+
+/*! Get the count for the given key
+\param topk Tracker
+\param key Key
+\return Count for key */
+FOUNDATION_API uint64_t
+hashtable64_topk_count(hashtable64_topk_t* topk, uint64_t key);
+
+/*! Get the tracked keys and their counts, sorted by descending count
+\param topk Tracker
+\param keys Array receiving keys
+\param counts Array receiving counts
+\param capacity Capacity of key and count arrays
+\return Number of keys stored in arrays */
+FOUNDATION_API size_t
+hashtable64_topk_get(hashtable64_topk_t* topk, uint64_t* keys, uint64_t* counts,
+                     size_t capacity);
+
+/*! Clear all counts and tracked keys
+\param topk Tracker */
+FOUNDATION_API void
+hashtable64_topk_clear(hashtable64_topk_t* topk);
+
+/*! Allocate storage for a 128-bit key hash table of given size. The returned hash table
+should be deallocated with a call to #hashtable128_deallocate.
+\param buckets Number of buckets
+\return New hash table */
+FOUNDATION_API hashtable128_t*
+hashtable128_allocate(size_t buckets);
+
+/*! Deallocate hash table previously allocated by a call to #hashtable128_allocate and free
+resources and storage used by hash table
+\param table Hash table object to deallocate */
+FOUNDATION_API void
+hashtable128_deallocate(hashtable128_t* table);
+
+/*! Initialize a 128-bit key hash table of given size. The table must have storage for
+the given number of buckets. The hash table should be finalized with a call to
+#hashtable128_finalize.
+\param table Hash table
+\param buckets Number of buckets */
+FOUNDATION_API void
+hashtable128_initialize(hashtable128_t* table, size_t buckets);
+
+/*! Finalize hash table previously initialized by a call to #hashtable128_initialize
+\param table Hash table object to finalize */
+FOUNDATION_API void
+hashtable128_finalize(hashtable128_t* table);
+
+/*! Set stored value for the given key. Keys are published with a 16-byte
+compare-and-swap where available, otherwise under a sequence lock.
+\param table Hash table
+\param key Key, must not be null
+\param value New value
+\return true if value set, false if table full */
+FOUNDATION_API bool
+hashtable128_set(hashtable128_t* table, uint128_t key, uint64_t value);
+
+/*! Erase the value for a key by setting the value to zero. Erasing is limited by
+the key still holding a slot in the table.
+\param table Hash table
+\param key Key, must not be null */
+FOUNDATION_API void
+hashtable128_erase(hashtable128_t* table, uint128_t key);
+
+/*! Get the value stored for the given key, or zero if no value stored
+\param table Hash table
+\param key Key, must not be null
+\return Value stored for key, zero if not found */
+FOUNDATION_API uint64_t
+hashtable128_get(hashtable128_t* table, uint128_t key);
+
+/*! Get the values stored for an array of keys, or zero for keys with no value
+stored. Home slots for upcoming keys are prefetched while earlier keys are probed,
+overlapping the cache misses of independent lookups.
+\param table Hash table
+\param keys Keys, must not be null
+\param values Array receiving the values
+\param count Number of keys */
+FOUNDATION_API void
+hashtable128_get_batch(hashtable128_t* table, const uint128_t* keys, uint64_t* values,
+                       size_t count);
+
+/*! Get number of stored keys with non-zero values. Walks the table
+so potentially slow.
+\param table Hash table
+\return Number of keys with non-zero values */
+FOUNDATION_API size_t
+hashtable128_size(hashtable128_t* table);
+
+/*! Clear the entire table, resetting the stat to the state after
+initial allocation.
+\param table Hash table */
+FOUNDATION_API void
+hashtable128_clear(hashtable128_t* table);
+
 /*!
 \def hashtable_t
 Defined alias for a hash table storing values the size of a pointer,
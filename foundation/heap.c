@@ -0,0 +1,276 @@
+/* heap.c  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+
+#define HEAP_MAX_ARITY 64
+
+//Sift functions are forced inline with a constant indexed flag, so heaps without index
+//map pay nothing for index maintenance
+
+static FOUNDATION_FORCEINLINE void
+_heap_sift_up(heap_entry_t* entry, uint32_t* index, size_t pos, heap_entry_t item, unsigned int shift,
+              bool indexed) {
+	while (pos) {
+		size_t parent = (pos - 1) >> shift;
+		if (!(item.key < entry[parent].key))
+			break;
+		entry[pos] = entry[parent];
+		if (indexed)
+			index[entry[pos].id] = (uint32_t)pos + 1;
+		pos = parent;
+	}
+	entry[pos] = item;
+	if (indexed)
+		index[item.id] = (uint32_t)pos + 1;
+}
+
+static FOUNDATION_FORCEINLINE void
+_heap_sift_down(heap_entry_t* entry, uint32_t* index, size_t size, size_t pos, heap_entry_t item,
+                unsigned int shift, bool indexed) {
+	while (true) {
+		size_t first = (pos << shift) + 1;
+		size_t last, best, child;
+		if (first >= size)
+			break;
+		last = first + ((size_t)1 << shift);
+		if (last > size)
+			last = size;
+		best = first;
+		for (child = first + 1; child < last; ++child) {
+			if (entry[child].key < entry[best].key)
+				best = child;
+		}
+		if (!(entry[best].key < item.key))
+			break;
+		entry[pos] = entry[best];
+		if (indexed)
+			index[entry[pos].id] = (uint32_t)pos + 1;
+		pos = best;
+	}
+	entry[pos] = item;
+	if (indexed)
+		index[item.id] = (uint32_t)pos + 1;
+}
+
+static void
+_heap_place(heap_t* heap, size_t pos, heap_entry_t item) {
+	//Move an item into a hole at the given position, in whichever direction it belongs
+	size_t size = array_size(heap->entry);
+	if (pos && (item.key < heap->entry[(pos - 1) >> heap->shift].key)) {
+		if (heap->indexed)
+			_heap_sift_up(heap->entry, heap->index, pos, item, heap->shift, true);
+		else
+			_heap_sift_up(heap->entry, heap->index, pos, item, heap->shift, false);
+	}
+	else {
+		if (heap->indexed)
+			_heap_sift_down(heap->entry, heap->index, size, pos, item, heap->shift, true);
+		else
+			_heap_sift_down(heap->entry, heap->index, size, pos, item, heap->shift, false);
+	}
+}
+
+static bool
+_heap_index_reserve(heap_t* heap, uint32_t id) {
+	size_t size = array_size(heap->index);
+	if (id < size)
+		return heap->index[id] == 0;
+	if (array_capacity(heap->index) <= id)
+		array_reserve(heap->index, math_max((size_t)id + 1, size * 2));
+	array_resize(heap->index, (size_t)id + 1);
+	memset(heap->index + size, 0, sizeof(uint32_t) * (((size_t)id + 1) - size));
+	return true;
+}
+
+heap_t*
+heap_allocate(unsigned int arity, bool indexed) {
+	heap_t* heap = memory_allocate(0, sizeof(heap_t), 0, MEMORY_PERSISTENT);
+	heap_initialize(heap, arity, indexed);
+	return heap;
+}
+
+void
+heap_deallocate(heap_t* heap) {
+	if (!heap)
+		return;
+	heap_finalize(heap);
+	memory_deallocate(heap);
+}
+
+void
+heap_initialize(heap_t* heap, unsigned int arity, bool indexed) {
+	if (!arity)
+		arity = HEAP_DEFAULT_ARITY;
+	if ((arity < 2) || (arity > HEAP_MAX_ARITY) || (arity & (arity - 1))) {
+		log_errorf(0, ERROR_INVALID_VALUE, STRING_CONST("Invalid heap arity %u, using %u"), arity,
+		           (unsigned int)HEAP_DEFAULT_ARITY);
+		arity = HEAP_DEFAULT_ARITY;
+	}
+	heap->shift = bits_ctz64(arity);
+	heap->entry = nullptr;
+	heap->index = nullptr;
+	heap->indexed = indexed;
+}
+
+void
+heap_finalize(heap_t* heap) {
+	array_deallocate(heap->entry);
+	array_deallocate(heap->index);
+}
+
+bool
+heap_push(heap_t* heap, uint64_t key, uint32_t id) {
+	heap_entry_t item;
+	size_t pos = array_size(heap->entry);
+
+	if (heap->indexed && !_heap_index_reserve(heap, id))
+		return false;
+
+	item.key = key;
+	item.id = id;
+	array_push(heap->entry, item);
+	if (heap->indexed)
+		_heap_sift_up(heap->entry, heap->index, pos, item, heap->shift, true);
+	else
+		_heap_sift_up(heap->entry, heap->index, pos, item, heap->shift, false);
+	return true;
+}
+
+bool
+heap_pop(heap_t* heap, heap_entry_t* entry) {
+	size_t size = array_size(heap->entry);
+	heap_entry_t last;
+
+	if (!size)
+		return false;
+
+	if (entry)
+		*entry = heap->entry[0];
+	if (heap->indexed)
+		heap->index[heap->entry[0].id] = 0;
+
+	last = heap->entry[--size];
+	array_pop(heap->entry);
+	if (size) {
+		if (heap->indexed)
+			_heap_sift_down(heap->entry, heap->index, size, 0, last, heap->shift, true);
+		else
+			_heap_sift_down(heap->entry, heap->index, size, 0, last, heap->shift, false);
+	}
+	return true;
+}
+
+void
+heap_replace_top(heap_t* heap, uint64_t key, uint32_t id) {
+	size_t size = array_size(heap->entry);
+	heap_entry_t item;
+
+	FOUNDATION_ASSERT(size > 0);
+	item.key = key;
+	item.id = id;
+	if (heap->indexed) {
+		bool reserved;
+		heap->index[heap->entry[0].id] = 0;
+		reserved = _heap_index_reserve(heap, id);
+		FOUNDATION_ASSERT_MSG(reserved, "Identifier already in heap");
+		FOUNDATION_UNUSED(reserved);
+		_heap_sift_down(heap->entry, heap->index, size, 0, item, heap->shift, true);
+	}
+	else {
+		_heap_sift_down(heap->entry, heap->index, size, 0, item, heap->shift, false);
+	}
+}
+
+bool
+heap_update(heap_t* heap, uint32_t id, uint64_t key) {
+	heap_entry_t item;
+	size_t pos;
+
+	if (!heap_contains(heap, id))
+		return false;
+
+	pos = heap->index[id] - 1;
+	item.key = key;
+	item.id = id;
+	_heap_place(heap, pos, item);
+	return true;
+}
+
+bool
+heap_erase(heap_t* heap, uint32_t id) {
+	size_t pos, size;
+	heap_entry_t last;
+
+	if (!heap_contains(heap, id))
+		return false;
+
+	pos = heap->index[id] - 1;
+	heap->index[id] = 0;
+	size = array_size(heap->entry) - 1;
+	last = heap->entry[size];
+	array_pop(heap->entry);
+	if (pos < size)
+		_heap_place(heap, pos, last);
+	return true;
+}
+
+bool
+heap_contains(const heap_t* heap, uint32_t id) {
+	return heap->indexed && (id < array_size(heap->index)) && heap->index[id];
+}
+
+bool
+heap_load(heap_t* heap, const heap_entry_t* entries, size_t count) {
+	size_t ientry, pos;
+
+	heap_clear(heap);
+	if (!count)
+		return true;
+
+	if (heap->indexed) {
+		for (ientry = 0; ientry < count; ++ientry) {
+			uint32_t id = entries[ientry].id;
+			if (!_heap_index_reserve(heap, id)) {
+				while (ientry--)
+					heap->index[entries[ientry].id] = 0;
+				log_errorf(0, ERROR_INVALID_VALUE, STRING_CONST("Duplicate identifier %u in heap load"), id);
+				return false;
+			}
+			heap->index[id] = 1;
+		}
+	}
+
+	array_resize(heap->entry, count);
+	memcpy(heap->entry, entries, sizeof(heap_entry_t) * count);
+
+	//Sift down every entry with children, starting with the last one
+	for (pos = (count > 1) ? ((count - 2) >> heap->shift) + 1 : 0; pos > 0; --pos)
+		_heap_sift_down(heap->entry, heap->index, count, pos - 1, heap->entry[pos - 1], heap->shift, false);
+
+	if (heap->indexed) {
+		for (pos = 0; pos < count; ++pos)
+			heap->index[heap->entry[pos].id] = (uint32_t)pos + 1;
+	}
+	return true;
+}
+
+void
+heap_clear(heap_t* heap) {
+	size_t size = array_size(heap->entry);
+	size_t pos;
+	if (heap->indexed) {
+		for (pos = 0; pos < size; ++pos)
+			heap->index[heap->entry[pos].id] = 0;
+	}
+	array_clear(heap->entry);
+}
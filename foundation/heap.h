@@ -0,0 +1,141 @@
+/* heap.h  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#pragma once
+
+/*! \file heap.h
+\brief D-ary heap priority queue
+
+Min-heap priority queue of entries with 64-bit keys and 32-bit identifiers, stored in an
+array. The arity is a power of two, where the default 4-ary heap halves the depth of a
+binary heap while the children of an entry still span only 64 bytes. Keys are compared
+inline as unsigned integers, for a max-heap store the complement of the key. An indexed
+heap maps identifiers to heap positions, allowing the key of an entry to be changed or
+an entry to be erased. Identifiers in indexed heaps should be dense, as the index map
+is sized by the largest identifier. A heap can be built from unordered entries in linear
+time. Access is not atomic and therefor not thread safe. */
+
+#include <foundation/platform.h>
+#include <foundation/types.h>
+#include <foundation/array.h>
+
+/*! Default heap arity */
+#define HEAP_DEFAULT_ARITY 4
+
+/*! Allocate an empty heap. The heap should be deallocated with a call to #heap_deallocate
+\param arity Number of children per entry, power of two in [2,64], zero for default
+\param indexed Flag to maintain an identifier to position map
+\return New heap */
+FOUNDATION_API heap_t*
+heap_allocate(unsigned int arity, bool indexed);
+
+/*! Deallocate a heap previously allocated with #heap_allocate
+\param heap Heap */
+FOUNDATION_API void
+heap_deallocate(heap_t* heap);
+
+/*! Initialize an empty heap. The heap should be finalized with a call to #heap_finalize
+\param heap Heap
+\param arity Number of children per entry, power of two in [2,64], zero for default
+\param indexed Flag to maintain an identifier to position map */
+FOUNDATION_API void
+heap_initialize(heap_t* heap, unsigned int arity, bool indexed);
+
+/*! Finalize a heap previously initialized with #heap_initialize
+\param heap Heap */
+FOUNDATION_API void
+heap_finalize(heap_t* heap);
+
+/*! Push an entry
+\param heap Heap
+\param key Key
+\param id Identifier
+\return true if pushed, false if heap is indexed and identifier is already in heap */
+FOUNDATION_API bool
+heap_push(heap_t* heap, uint64_t key, uint32_t id);
+
+/*! Pop the entry with the smallest key
+\param heap Heap
+\param entry Receives the popped entry, may be null
+\return true if an entry was popped, false if heap is empty */
+FOUNDATION_API bool
+heap_pop(heap_t* heap, heap_entry_t* entry);
+
+/*! Replace the entry with the smallest key, which is cheaper than a pop followed by a
+push. Useful for keeping the largest keys seen in a heap of fixed size.
+\param heap Heap, must not be empty
+\param key Key
+\param id Identifier, must not be in an indexed heap unless equal to the replaced
+          identifier */
+FOUNDATION_API void
+heap_replace_top(heap_t* heap, uint64_t key, uint32_t id);
+
+/*! Change the key of an entry in an indexed heap, decreasing or increasing it
+\param heap Heap
+\param id Identifier
+\param key New key
+\return true if key was changed, false if identifier is not in heap or heap is not indexed */
+FOUNDATION_API bool
+heap_update(heap_t* heap, uint32_t id, uint64_t key);
+
+/*! Erase an entry from an indexed heap
+\param heap Heap
+\param id Identifier
+\return true if erased, false if identifier is not in heap or heap is not indexed */
+FOUNDATION_API bool
+heap_erase(heap_t* heap, uint32_t id);
+
+/*! Query if an identifier is in an indexed heap
+\param heap Heap
+\param id Identifier
+\return true if identifier is in heap, false if not or if heap is not indexed */
+FOUNDATION_API bool
+heap_contains(const heap_t* heap, uint32_t id);
+
+/*! Replace the content of the heap with the given entries, building the heap bottom up
+in linear time
+\param heap Heap
+\param entries Entries in any order
+\param count Number of entries
+\return true if loaded, false if heap is indexed and an identifier occurs more than once,
+        in which case the heap is left empty */
+FOUNDATION_API bool
+heap_load(heap_t* heap, const heap_entry_t* entries, size_t count);
+
+/*! Remove all entries
+\param heap Heap */
+FOUNDATION_API void
+heap_clear(heap_t* heap);
+
+/*! Get number of entries
+\param heap Heap
+\return Number of entries */
+static FOUNDATION_FORCEINLINE size_t
+heap_size(const heap_t* heap);
+
+/*! Get the entry with the smallest key without removing it
+\param heap Heap
+\return Entry, null if heap is empty */
+static FOUNDATION_FORCEINLINE const heap_entry_t*
+heap_top(const heap_t* heap);
+
+// Implementation
+
+static FOUNDATION_FORCEINLINE size_t
+heap_size(const heap_t* heap) {
+	return array_size(heap->entry);
+}
+
+static FOUNDATION_FORCEINLINE const heap_entry_t*
+heap_top(const heap_t* heap) {
+	return array_size(heap->entry) ? heap->entry : nullptr;
+}
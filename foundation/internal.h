@@ -67,6 +67,12 @@ _thread_initialize(void);
 FOUNDATION_API void
 _thread_finalize(void);
 
+FOUNDATION_API void
+_thread_pool_finalize(void);
+
+FOUNDATION_API void
+_objectmap_finalize(void);
+
 FOUNDATION_API int
 _environment_initialize(const application_t application);
 
@@ -138,3 +144,17 @@ _object_initialize(object_base_t* obj, object_t id);
 FOUNDATION_API void
 _environment_main_args(int argc, const char* const* argv);
 
+FOUNDATION_API void
+_epoch_initialize(epoch_reader_t* readers);
+
+FOUNDATION_API epoch_reader_t*
+_epoch_reader(epoch_reader_t* readers);
+
+FOUNDATION_API int32_t
+_epoch_enter(atomic32_t* epoch, epoch_reader_t* reader);
+
+FOUNDATION_API void
+_epoch_leave(epoch_reader_t* reader, int32_t epoch);
+
+FOUNDATION_API bool
+_epoch_drained(epoch_reader_t* readers, int32_t epoch);
@@ -25,6 +25,11 @@
 
 #if FOUNDATION_SUPPORT_LIBRARY_LOAD
 
+//Number of slots in the per-library symbol cache, lookups of symbols not fitting the cache go to the OS
+#define LIBRARY_SYMBOL_CACHE_SIZE 1024
+//Maximum number of cached symbols, keeping free slots so probing for uncached symbols stays short
+#define LIBRARY_SYMBOL_CACHE_LIMIT ((LIBRARY_SYMBOL_CACHE_SIZE * 3) / 4)
+
 struct library_t {
 	/*lint -e754 */
 	FOUNDATION_DECLARE_OBJECT;
@@ -38,31 +43,58 @@ struct library_t {
 #elif FOUNDATION_PLATFORM_POSIX
 	void*   lib;
 #endif
+
+	//Symbol name hash to address, allocated on first symbol lookup
+	atomicptr_t symbols;
+	atomic32_t  num_symbols;
 };
 
 typedef FOUNDATION_ALIGN(8) struct library_t library_t;
 
 static objectmap_t* _library_map;
+//Library name hash to object id of loaded libraries
+static hashtable64_t* _library_index;
 
 int
 _library_initialize(void) {
 	_library_map = objectmap_allocate(foundation_config().library_max);
 	if (!_library_map)
 		return -1;
+	_library_index = hashtable64_allocate(foundation_config().library_max * 2);
 	return 0;
 }
 
 void
 _library_finalize(void) {
+	hashtable64_deallocate(_library_index);
 	objectmap_deallocate(_library_map);
+	_library_index = 0;
 	_library_map = 0;
 }
 
+static void
+_library_index_set(library_t* library) {
+	size_t index = 0;
+	library_t* loaded;
+
+	if (hashtable64_set(_library_index, library->name_hash, library->id))
+		return;
+
+	//Index filled up with keys of unloaded libraries, rebuild from the loaded libraries
+	hashtable64_clear(_library_index);
+	while ((loaded = objectmap_iterate(_library_map, &index)))
+		hashtable64_set(_library_index, loaded->name_hash, loaded->id);
+	hashtable64_set(_library_index, library->name_hash, library->id);
+}
+
 static void
 _library_destroy(object_t id, void* obj) {
 	library_t* library = obj;
 
+	if (hashtable64_get(_library_index, library->name_hash) == id)
+		hashtable64_erase(_library_index, library->name_hash);
 	objectmap_free(_library_map, id);
+	hashtable64_deallocate(atomic_load_ptr(&library->symbols));
 
 #if FOUNDATION_PLATFORM_WINDOWS
 	FreeLibrary(library->dll);
@@ -77,7 +109,6 @@ object_t
 library_load(const char* name, size_t length) {
 	library_t* library;
 	hash_t name_hash;
-	size_t i, size;
 	object_t id;
 	const char* basename;
 	size_t last_slash;
@@ -111,15 +142,12 @@ library_load(const char* name, size_t length) {
 	}
 
 	//Locate already loaded library
-	library = 0;
 	name_hash = string_hash(basename, base_length);
-	for (i = 0, size = objectmap_size(_library_map); i < size; ++i) {
-		library = objectmap_raw_lookup(_library_map, i);
-		if (library && (library->name_hash == name_hash)) {
-			FOUNDATION_ASSERT(string_equal(library->name, library->name_length, basename, base_length));
-			atomic_incr32(&library->ref);
-			return library->id;
-		}
+	id = (object_t)hashtable64_get(_library_index, name_hash);
+	library = id ? objectmap_lookup_ref(_library_map, id) : 0;
+	if (library) {
+		FOUNDATION_ASSERT(string_equal(library->name, library->name_length, basename, base_length));
+		return library->id;
 	}
 
 	error_context_push(STRING_CONST("loading library"), name, length);
@@ -209,6 +237,7 @@ library_load(const char* name, size_t length) {
 	library->lib = lib;
 #endif
 	objectmap_set(_library_map, id, library);
+	_library_index_set(library);
 
 	error_context_pop();
 
@@ -225,24 +254,69 @@ library_unload(object_t id) {
 	objectmap_lookup_unref(_library_map, id, _library_destroy);
 }
 
-void*
-library_symbol(object_t id, const char* name, size_t length) {
-	library_t* library = objectmap_lookup(_library_map, id);
-	FOUNDATION_UNUSED(length);
-	if (library) {
+static hashtable64_t*
+_library_symbol_cache(library_t* library) {
+	hashtable64_t* symbols = atomic_load_ptr(&library->symbols);
+	if (!symbols) {
+		hashtable64_t* cache = hashtable64_allocate(LIBRARY_SYMBOL_CACHE_SIZE);
+		if (atomic_cas_ptr(&library->symbols, cache, 0))
+			symbols = cache;
+		else {
+			hashtable64_deallocate(cache);
+			symbols = atomic_load_ptr(&library->symbols);
+		}
+	}
+	return symbols;
+}
+
+static void*
+_library_symbol(library_t* library, hashtable64_t* symbols, const char* name, size_t length) {
+	hash_t symbol_hash = string_hash(name, length);
+	void* symbol = (void*)(uintptr_t)hashtable64_get(symbols, symbol_hash);
+	if (symbol)
+		return symbol;
+
 #if FOUNDATION_PLATFORM_WINDOWS
-		return (void*)GetProcAddress(library->dll, name);
+	symbol = (void*)GetProcAddress(library->dll, name);
 #elif FOUNDATION_PLATFORM_POSIX
-		return dlsym(library->lib, name);
-#else
-		FOUNDATION_UNUSED(name);
-		log_errorf(0, ERROR_NOT_IMPLEMENTED,
-		           STRING_CONST("Dynamic library symbol lookup implemented for this platform"));
+	symbol = dlsym(library->lib, name);
 #endif
-	}
+
+	//Failed lookups are not cached, symbols beyond the cache limit fall back to the OS lookup
+	if (symbol && (atomic_load32(&library->num_symbols) < LIBRARY_SYMBOL_CACHE_LIMIT) &&
+	    (atomic_incr32(&library->num_symbols) <= LIBRARY_SYMBOL_CACHE_LIMIT))
+		hashtable64_set(symbols, symbol_hash, (uint64_t)(uintptr_t)symbol);
+	return symbol;
+}
+
+void*
+library_symbol(object_t id, const char* name, size_t length) {
+	library_t* library = objectmap_lookup(_library_map, id);
+	if (library)
+		return _library_symbol(library, _library_symbol_cache(library), name, length);
 	return 0;
 }
 
+size_t
+library_symbols(object_t id, const string_const_t* names, void** symbols, size_t count) {
+	library_t* library = objectmap_lookup(_library_map, id);
+	hashtable64_t* cache;
+	size_t isym, found = 0;
+
+	if (!library) {
+		memset(symbols, 0, sizeof(void*) * count);
+		return 0;
+	}
+
+	cache = _library_symbol_cache(library);
+	for (isym = 0; isym < count; ++isym) {
+		symbols[isym] = _library_symbol(library, cache, STRING_ARGS(names[isym]));
+		if (symbols[isym])
+			++found;
+	}
+	return found;
+}
+
 string_const_t
 library_name(object_t id) {
 	library_t* library = objectmap_lookup(_library_map, id);
@@ -295,6 +369,14 @@ library_symbol(object_t id, const char* name, size_t length) {
 	return 0;
 }
 
+size_t
+library_symbols(object_t id, const string_const_t* names, void** symbols, size_t count) {
+	FOUNDATION_UNUSED(id);
+	FOUNDATION_UNUSED(names);
+	memset(symbols, 0, sizeof(void*) * count);
+	return 0;
+}
+
 string_const_t
 library_name(object_t id) {
 	FOUNDATION_UNUSED(id);
@@ -54,7 +54,8 @@ associated will be released.
 FOUNDATION_API void
 library_unload(object_t library);
 
-/*! Lookup a symbol by name in the library.
+/*! Lookup a symbol by name in the library. Resolved symbols are cached in the
+library object, making repeated lookups of the same symbol name a hash table lookup.
 \param library Library object
 \param name Symbol name
 \param length Length of symbol name
@@ -62,6 +63,17 @@ library_unload(object_t library);
 FOUNDATION_API void*
 library_symbol(object_t library, const char* name, size_t length);
 
+/*! Lookup a table of symbols by name in the library in one call. Resolved symbols
+are cached in the library object, making repeated lookups of the same symbol name
+a hash table lookup. Symbols not found are stored as null pointers.
+\param library Library object
+\param names Array of zero terminated symbol names
+\param symbols Array receiving symbol addresses, must hold at least count pointers
+\param count Number of symbols to lookup
+\return Number of symbols found */
+FOUNDATION_API size_t
+library_symbols(object_t library, const string_const_t* names, void** symbols, size_t count);
+
 /*! Get library name
 \param library Library object
 \return Library name, empty string if not a valid library */
@@ -0,0 +1,718 @@
+/* math.c  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+
+#if FOUNDATION_ARCH_SSE2
+#  include <emmintrin.h>
+#  define MATH_SIMD32 4
+#  define MATH_SIMD64 2
+#elif FOUNDATION_ARCH_NEON
+#  include <arm_neon.h>
+#  define MATH_SIMD32 4
+#  define MATH_SIMD64 0
+#else
+#  define MATH_SIMD32 0
+#  define MATH_SIMD64 0
+#endif
+
+/* Polynomial approximations are derived from the Cephes math library by Stephen L. Moshier
+   (http://www.netlib.org/cephes/). Trigonometric arguments are reduced to [-pi/4, pi/4]
+   using a three-part Cody-Waite split of pi/2, exponentials to [-ln2/2, ln2/2] and
+   logarithm mantissas to [sqrt(1/2), sqrt(2)). */
+
+/* The Cody-Waite reduction steps must be evaluated in order. Fast math flags allow the
+   compiler to fold the split constants back together, which loses the low bits of the
+   reduced argument, so the intermediate is hidden from the optimizer. */
+#if (FOUNDATION_COMPILER_GCC || FOUNDATION_COMPILER_CLANG) && (FOUNDATION_ARCH_X86 || FOUNDATION_ARCH_X86_64)
+#  define MATH_OPAQUE(var) __asm__("" : "+x"(var))
+#elif (FOUNDATION_COMPILER_GCC || FOUNDATION_COMPILER_CLANG) && (FOUNDATION_ARCH_ARM || FOUNDATION_ARCH_ARM_64)
+#  define MATH_OPAQUE(var) __asm__("" : "+w"(var))
+#else
+#  define MATH_OPAQUE(var) do { (void)sizeof(var); } while (0)
+#endif
+
+#define MATH_FRAC_2_PI32  0.63661977236758134308f
+#define MATH_PIO2_1_32    1.5703125f
+#define MATH_PIO2_2_32    4.837512969970703125e-4f
+#define MATH_PIO2_3_32    7.54978995489188216e-8f
+#define MATH_SIN32_P0    -1.9515295891e-4f
+#define MATH_SIN32_P1     8.3321608736e-3f
+#define MATH_SIN32_P2    -1.6666654611e-1f
+#define MATH_COS32_P0     2.443315711809948e-5f
+#define MATH_COS32_P1    -1.388731625493765e-3f
+#define MATH_COS32_P2     4.166664568298827e-2f
+
+#define MATH_EXP32_HI     88.0f
+#define MATH_EXP32_LO    -87.0f
+#define MATH_LOG2E32      1.44269504088896341f
+#define MATH_LN2_HI32     0.693359375f
+#define MATH_LN2_LO32    -2.12194440e-4f
+#define MATH_EXP32_P0     1.9875691500e-4f
+#define MATH_EXP32_P1     1.3981999507e-3f
+#define MATH_EXP32_P2     8.3334519073e-3f
+#define MATH_EXP32_P3     4.1665795894e-2f
+#define MATH_EXP32_P4     1.6666665459e-1f
+#define MATH_EXP32_P5     5.0000001201e-1f
+
+#define MATH_SQRTHF32     0.707106781186547524f
+#define MATH_LOG32_P0     7.0376836292e-2f
+#define MATH_LOG32_P1    -1.1514610310e-1f
+#define MATH_LOG32_P2     1.1676998740e-1f
+#define MATH_LOG32_P3    -1.2420140846e-1f
+#define MATH_LOG32_P4     1.4249322787e-1f
+#define MATH_LOG32_P5    -1.6668057665e-1f
+#define MATH_LOG32_P6     2.0000714765e-1f
+#define MATH_LOG32_P7    -2.4999993993e-1f
+#define MATH_LOG32_P8     3.3333331174e-1f
+
+#define MATH_FRAC_2_PI64  0.63661977236758134308
+#define MATH_PIO2_1_64    1.57079625129699707031e+0
+#define MATH_PIO2_2_64    7.54978941586159635336e-8
+#define MATH_PIO2_3_64    5.39030285815811905290e-15
+#define MATH_SIN64_P0     1.58962301576546568060e-10
+#define MATH_SIN64_P1    -2.50507477628578072866e-8
+#define MATH_SIN64_P2     2.75573136213857245213e-6
+#define MATH_SIN64_P3    -1.98412698295895385996e-4
+#define MATH_SIN64_P4     8.33333333332211858878e-3
+#define MATH_SIN64_P5    -1.66666666666666307295e-1
+#define MATH_COS64_P0    -1.13585365213876817300e-11
+#define MATH_COS64_P1     2.08757008419747316778e-9
+#define MATH_COS64_P2    -2.75573141792967388112e-7
+#define MATH_COS64_P3     2.48015872888517045348e-5
+#define MATH_COS64_P4    -1.38888888888730564116e-3
+#define MATH_COS64_P5     4.16666666666665929218e-2
+
+#define MATH_EXP64_HI     708.0
+#define MATH_EXP64_LO    -708.0
+#define MATH_LOG2E64      1.44269504088896340736
+#define MATH_LN2_HI64     6.93145751953125e-1
+#define MATH_LN2_LO64     1.42860682030941723212e-6
+
+#define MATH_SQRT2_64     1.41421356237309504880
+
+static FOUNDATION_FORCEINLINE int32_t
+_math_round32(float32_t x) {
+	return (int32_t)(x + ((x < 0.0f) ? -0.5f : 0.5f));
+}
+
+static FOUNDATION_FORCEINLINE int32_t
+_math_round64(float64_t x) {
+	return (int32_t)(x + ((x < 0.0) ? -0.5 : 0.5));
+}
+
+static FOUNDATION_FORCEINLINE float32_t
+_math_sincos32(float32_t x, int32_t offset) {
+	int32_t j = _math_round32(x * MATH_FRAC_2_PI32);
+	float32_t fj = (float32_t)j;
+	float32_t r = x - fj * MATH_PIO2_1_32;
+	float32_t z, y;
+	MATH_OPAQUE(r);
+	r -= fj * MATH_PIO2_2_32;
+	MATH_OPAQUE(r);
+	r -= fj * MATH_PIO2_3_32;
+	z = r * r;
+	j += offset;
+	if (j & 1)
+		y = ((MATH_COS32_P0 * z + MATH_COS32_P1) * z + MATH_COS32_P2) * z * z - 0.5f * z + 1.0f;
+	else
+		y = ((MATH_SIN32_P0 * z + MATH_SIN32_P1) * z + MATH_SIN32_P2) * z * r + r;
+	return (j & 2) ? -y : y;
+}
+
+static FOUNDATION_FORCEINLINE float32_t
+_math_exp32(float32_t x) {
+	float32_cast_t scale;
+	int32_t n;
+	float32_t fn, r, y;
+	x = (x > MATH_EXP32_HI) ? MATH_EXP32_HI : ((x < MATH_EXP32_LO) ? MATH_EXP32_LO : x);
+	n = _math_round32(x * MATH_LOG2E32);
+	fn = (float32_t)n;
+	r = x - fn * MATH_LN2_HI32;
+	MATH_OPAQUE(r);
+	r -= fn * MATH_LN2_LO32;
+	y = (((((MATH_EXP32_P0 * r + MATH_EXP32_P1) * r + MATH_EXP32_P2) * r + MATH_EXP32_P3) * r +
+	      MATH_EXP32_P4) * r + MATH_EXP32_P5) * r * r + r + 1.0f;
+	scale.ival = (n + 127) << 23;
+	return y * scale.fval;
+}
+
+static FOUNDATION_FORCEINLINE float32_t
+_math_logn32(float32_t x) {
+	float32_cast_t mant;
+	float32_t e, z, y;
+	mant.fval = x;
+	e = (float32_t)(((mant.ival >> 23) & 0xFF) - 126);
+	mant.ival = (mant.ival & 0x007FFFFF) | 0x3F000000;
+	x = mant.fval;
+	if (x < MATH_SQRTHF32) {
+		e -= 1.0f;
+		x = x + x - 1.0f;
+	}
+	else {
+		x = x - 1.0f;
+	}
+	z = x * x;
+	y = ((((((((MATH_LOG32_P0 * x + MATH_LOG32_P1) * x + MATH_LOG32_P2) * x + MATH_LOG32_P3) * x +
+	          MATH_LOG32_P4) * x + MATH_LOG32_P5) * x + MATH_LOG32_P6) * x + MATH_LOG32_P7) * x +
+	     MATH_LOG32_P8) * x * z;
+	y += e * MATH_LN2_LO32;
+	y -= 0.5f * z;
+	MATH_OPAQUE(y);
+	x += y;
+	MATH_OPAQUE(x);
+	return x + e * MATH_LN2_HI32;
+}
+
+static FOUNDATION_FORCEINLINE float64_t
+_math_sincos64(float64_t x, int32_t offset) {
+	int32_t j = _math_round64(x * MATH_FRAC_2_PI64);
+	float64_t fj = (float64_t)j;
+	float64_t r = x - fj * MATH_PIO2_1_64;
+	MATH_OPAQUE(r);
+	r -= fj * MATH_PIO2_2_64;
+	MATH_OPAQUE(r);
+	r -= fj * MATH_PIO2_3_64;
+	float64_t z = r * r;
+	float64_t y;
+	j += offset;
+	if (j & 1)
+		y = (((((MATH_COS64_P0 * z + MATH_COS64_P1) * z + MATH_COS64_P2) * z + MATH_COS64_P3) * z +
+		      MATH_COS64_P4) * z + MATH_COS64_P5) * z * z - 0.5 * z + 1.0;
+	else
+		y = (((((MATH_SIN64_P0 * z + MATH_SIN64_P1) * z + MATH_SIN64_P2) * z + MATH_SIN64_P3) * z +
+		      MATH_SIN64_P4) * z + MATH_SIN64_P5) * z * r + r;
+	return (j & 2) ? -y : y;
+}
+
+static FOUNDATION_FORCEINLINE float64_t
+_math_exp_poly64(float64_t r) {
+	//Taylor series to r^13, truncation error below 2^-53 for |r| <= ln2/2
+	return ((((((((((((r * (1.0 / 6227020800.0) + (1.0 / 479001600.0)) * r + (1.0 / 39916800.0)) * r +
+	                 (1.0 / 3628800.0)) * r + (1.0 / 362880.0)) * r + (1.0 / 40320.0)) * r +
+	              (1.0 / 5040.0)) * r + (1.0 / 720.0)) * r + (1.0 / 120.0)) * r + (1.0 / 24.0)) * r +
+	          (1.0 / 6.0)) * r + 0.5) * r * r + r) + 1.0;
+}
+
+static FOUNDATION_FORCEINLINE float64_t
+_math_exp64(float64_t x) {
+	float64_cast_t scale;
+	int32_t n;
+	float64_t fn, r;
+	x = (x > MATH_EXP64_HI) ? MATH_EXP64_HI : ((x < MATH_EXP64_LO) ? MATH_EXP64_LO : x);
+	n = _math_round64(x * MATH_LOG2E64);
+	fn = (float64_t)n;
+	r = x - fn * MATH_LN2_HI64;
+	MATH_OPAQUE(r);
+	r -= fn * MATH_LN2_LO64;
+	scale.ival = (int64_t)(n + 1023) << 52;
+	return _math_exp_poly64(r) * scale.fval;
+}
+
+static FOUNDATION_FORCEINLINE float64_t
+_math_log_poly64(float64_t m) {
+	//log(m) = 2 atanh(s), s = (m-1)/(m+1), |s| < 0.1716 for m in [sqrt(1/2), sqrt(2))
+	float64_t s = (m - 1.0) / (m + 1.0);
+	float64_t z = s * s;
+	float64_t p = ((((((((z * (2.0 / 19.0) + (2.0 / 17.0)) * z + (2.0 / 15.0)) * z + (2.0 / 13.0)) * z +
+	                  (2.0 / 11.0)) * z + (2.0 / 9.0)) * z + (2.0 / 7.0)) * z + (2.0 / 5.0)) * z +
+	               (2.0 / 3.0));
+	return (2.0 * s) + s * z * p;
+}
+
+static FOUNDATION_FORCEINLINE float64_t
+_math_logn64(float64_t x) {
+	float64_cast_t mant;
+	float64_t e, y;
+	mant.fval = x;
+	e = (float64_t)(int64_t)(((mant.uival >> 52) & 0x7FF) - 1023);
+	mant.uival = (mant.uival & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL;
+	if (mant.fval > MATH_SQRT2_64) {
+		mant.fval *= 0.5;
+		e += 1.0;
+	}
+	y = _math_log_poly64(mant.fval);
+	y += e * MATH_LN2_LO64;
+	MATH_OPAQUE(y);
+	return y + e * MATH_LN2_HI64;
+}
+
+#if FOUNDATION_ARCH_SSE2
+
+typedef __m128  math_v32_t;
+typedef __m128d math_v64_t;
+
+#define _math_load32  _mm_loadu_ps
+#define _math_store32 _mm_storeu_ps
+#define _math_load64  _mm_loadu_pd
+#define _math_store64 _mm_storeu_pd
+
+static FOUNDATION_FORCEINLINE __m128
+_math_select_ps(__m128 mask, __m128 a, __m128 b) {
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static FOUNDATION_FORCEINLINE __m128d
+_math_select_pd(__m128d mask, __m128d a, __m128d b) {
+	return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+}
+
+static FOUNDATION_FORCEINLINE __m128
+_math_sincos_v32(__m128 x, int32_t offset) {
+	__m128i j = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(MATH_FRAC_2_PI32)));
+	__m128 fj = _mm_cvtepi32_ps(j);
+	__m128 r, z, ys, yc, usecos, sign;
+	r = _mm_sub_ps(x, _mm_mul_ps(fj, _mm_set1_ps(MATH_PIO2_1_32)));
+	MATH_OPAQUE(r);
+	r = _mm_sub_ps(r, _mm_mul_ps(fj, _mm_set1_ps(MATH_PIO2_2_32)));
+	MATH_OPAQUE(r);
+	r = _mm_sub_ps(r, _mm_mul_ps(fj, _mm_set1_ps(MATH_PIO2_3_32)));
+	j = _mm_add_epi32(j, _mm_set1_epi32(offset));
+	z = _mm_mul_ps(r, r);
+
+	ys = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(MATH_SIN32_P0), z), _mm_set1_ps(MATH_SIN32_P1));
+	ys = _mm_add_ps(_mm_mul_ps(ys, z), _mm_set1_ps(MATH_SIN32_P2));
+	ys = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ys, z), r), r);
+
+	yc = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(MATH_COS32_P0), z), _mm_set1_ps(MATH_COS32_P1));
+	yc = _mm_add_ps(_mm_mul_ps(yc, z), _mm_set1_ps(MATH_COS32_P2));
+	yc = _mm_mul_ps(_mm_mul_ps(yc, z), z);
+	yc = _mm_add_ps(_mm_sub_ps(yc, _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_set1_ps(1.0f));
+
+	usecos = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+	sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), 30));
+	return _mm_xor_ps(_math_select_ps(usecos, yc, ys), sign);
+}
+
+static FOUNDATION_FORCEINLINE __m128
+_math_exp_v32(__m128 x) {
+	__m128i n;
+	__m128 fn, r, y;
+	x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(MATH_EXP32_LO)), _mm_set1_ps(MATH_EXP32_HI));
+	n = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(MATH_LOG2E32)));
+	fn = _mm_cvtepi32_ps(n);
+	r = _mm_sub_ps(x, _mm_mul_ps(fn, _mm_set1_ps(MATH_LN2_HI32)));
+	MATH_OPAQUE(r);
+	r = _mm_sub_ps(r, _mm_mul_ps(fn, _mm_set1_ps(MATH_LN2_LO32)));
+
+	y = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(MATH_EXP32_P0), r), _mm_set1_ps(MATH_EXP32_P1));
+	y = _mm_add_ps(_mm_mul_ps(y, r), _mm_set1_ps(MATH_EXP32_P2));
+	y = _mm_add_ps(_mm_mul_ps(y, r), _mm_set1_ps(MATH_EXP32_P3));
+	y = _mm_add_ps(_mm_mul_ps(y, r), _mm_set1_ps(MATH_EXP32_P4));
+	y = _mm_add_ps(_mm_mul_ps(y, r), _mm_set1_ps(MATH_EXP32_P5));
+	y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(y, r), r), r), _mm_set1_ps(1.0f));
+
+	n = _mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23);
+	return _mm_mul_ps(y, _mm_castsi128_ps(n));
+}
+
+static FOUNDATION_FORCEINLINE __m128
+_math_logn_v32(__m128 x) {
+	__m128i bits = _mm_castps_si128(x);
+	__m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(bits, 23), _mm_set1_epi32(0xFF)),
+	                                         _mm_set1_epi32(126)));
+	__m128 mask, z, y;
+	x = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)),
+	                                  _mm_set1_epi32(0x3F000000)));
+	mask = _mm_cmplt_ps(x, _mm_set1_ps(MATH_SQRTHF32));
+	e = _mm_sub_ps(e, _mm_and_ps(mask, _mm_set1_ps(1.0f)));
+	x = _mm_add_ps(_mm_sub_ps(x, _mm_set1_ps(1.0f)), _mm_and_ps(mask, x));
+	z = _mm_mul_ps(x, x);
+
+	y = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(MATH_LOG32_P0), x), _mm_set1_ps(MATH_LOG32_P1));
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(MATH_LOG32_P2));
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(MATH_LOG32_P3));
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(MATH_LOG32_P4));
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(MATH_LOG32_P5));
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(MATH_LOG32_P6));
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(MATH_LOG32_P7));
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(MATH_LOG32_P8));
+	y = _mm_mul_ps(_mm_mul_ps(y, x), z);
+
+	y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(MATH_LN2_LO32)));
+	y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+	MATH_OPAQUE(y);
+	x = _mm_add_ps(x, y);
+	MATH_OPAQUE(x);
+	return _mm_add_ps(x, _mm_mul_ps(e, _mm_set1_ps(MATH_LN2_HI32)));
+}
+
+static FOUNDATION_FORCEINLINE __m128
+_math_sqrt_v32(__m128 x) {
+	return _mm_sqrt_ps(x);
+}
+
+static FOUNDATION_FORCEINLINE __m128
+_math_rsqrt_v32(__m128 x) {
+	//Estimate has 12 bits of precision, one Newton-Raphson step brings it to ~22 bits
+	__m128 y = _mm_rsqrt_ps(x);
+	__m128 hx = _mm_mul_ps(x, _mm_set1_ps(0.5f));
+	return _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(hx, _mm_mul_ps(y, y))));
+}
+
+static FOUNDATION_FORCEINLINE __m128d
+_math_sincos_v64(__m128d x, int32_t offset) {
+	__m128i j = _mm_cvtpd_epi32(_mm_mul_pd(x, _mm_set1_pd(MATH_FRAC_2_PI64)));
+	__m128d fj = _mm_cvtepi32_pd(j);
+	__m128d r, z, ys, yc, usecos, sign;
+	r = _mm_sub_pd(x, _mm_mul_pd(fj, _mm_set1_pd(MATH_PIO2_1_64)));
+	MATH_OPAQUE(r);
+	r = _mm_sub_pd(r, _mm_mul_pd(fj, _mm_set1_pd(MATH_PIO2_2_64)));
+	MATH_OPAQUE(r);
+	r = _mm_sub_pd(r, _mm_mul_pd(fj, _mm_set1_pd(MATH_PIO2_3_64)));
+	//Spread the two 32-bit quadrant indices to both halves of each 64-bit lane
+	j = _mm_shuffle_epi32(_mm_add_epi32(j, _mm_set1_epi32(offset)), _MM_SHUFFLE(1, 1, 0, 0));
+	z = _mm_mul_pd(r, r);
+
+	ys = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(MATH_SIN64_P0), z), _mm_set1_pd(MATH_SIN64_P1));
+	ys = _mm_add_pd(_mm_mul_pd(ys, z), _mm_set1_pd(MATH_SIN64_P2));
+	ys = _mm_add_pd(_mm_mul_pd(ys, z), _mm_set1_pd(MATH_SIN64_P3));
+	ys = _mm_add_pd(_mm_mul_pd(ys, z), _mm_set1_pd(MATH_SIN64_P4));
+	ys = _mm_add_pd(_mm_mul_pd(ys, z), _mm_set1_pd(MATH_SIN64_P5));
+	ys = _mm_add_pd(_mm_mul_pd(_mm_mul_pd(ys, z), r), r);
+
+	yc = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(MATH_COS64_P0), z), _mm_set1_pd(MATH_COS64_P1));
+	yc = _mm_add_pd(_mm_mul_pd(yc, z), _mm_set1_pd(MATH_COS64_P2));
+	yc = _mm_add_pd(_mm_mul_pd(yc, z), _mm_set1_pd(MATH_COS64_P3));
+	yc = _mm_add_pd(_mm_mul_pd(yc, z), _mm_set1_pd(MATH_COS64_P4));
+	yc = _mm_add_pd(_mm_mul_pd(yc, z), _mm_set1_pd(MATH_COS64_P5));
+	yc = _mm_mul_pd(_mm_mul_pd(yc, z), z);
+	yc = _mm_add_pd(_mm_sub_pd(yc, _mm_mul_pd(_mm_set1_pd(0.5), z)), _mm_set1_pd(1.0));
+
+	usecos = _mm_castsi128_pd(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+	sign = _mm_castsi128_pd(_mm_slli_epi32(_mm_and_si128(j, _mm_set_epi32(2, 0, 2, 0)), 30));
+	return _mm_xor_pd(_math_select_pd(usecos, yc, ys), sign);
+}
+
+static FOUNDATION_FORCEINLINE __m128d
+_math_exp_v64(__m128d x) {
+	__m128i n;
+	__m128d fn, r, y;
+	x = _mm_min_pd(_mm_max_pd(x, _mm_set1_pd(MATH_EXP64_LO)), _mm_set1_pd(MATH_EXP64_HI));
+	n = _mm_cvtpd_epi32(_mm_mul_pd(x, _mm_set1_pd(MATH_LOG2E64)));
+	fn = _mm_cvtepi32_pd(n);
+	r = _mm_sub_pd(x, _mm_mul_pd(fn, _mm_set1_pd(MATH_LN2_HI64)));
+	MATH_OPAQUE(r);
+	r = _mm_sub_pd(r, _mm_mul_pd(fn, _mm_set1_pd(MATH_LN2_LO64)));
+
+	y = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(1.0 / 6227020800.0), r), _mm_set1_pd(1.0 / 479001600.0));
+	y = _mm_add_pd(_mm_mul_pd(y, r), _mm_set1_pd(1.0 / 39916800.0));
+	y = _mm_add_pd(_mm_mul_pd(y, r), _mm_set1_pd(1.0 / 3628800.0));
+	y = _mm_add_pd(_mm_mul_pd(y, r), _mm_set1_pd(1.0 / 362880.0));
+	y = _mm_add_pd(_mm_mul_pd(y, r), _mm_set1_pd(1.0 / 40320.0));
+	y = _mm_add_pd(_mm_mul_pd(y, r), _mm_set1_pd(1.0 / 5040.0));
+	y = _mm_add_pd(_mm_mul_pd(y, r), _mm_set1_pd(1.0 / 720.0));
+	y = _mm_add_pd(_mm_mul_pd(y, r), _mm_set1_pd(1.0 / 120.0));
+	y = _mm_add_pd(_mm_mul_pd(y, r), _mm_set1_pd(1.0 / 24.0));
+	y = _mm_add_pd(_mm_mul_pd(y, r), _mm_set1_pd(1.0 / 6.0));
+	y = _mm_add_pd(_mm_mul_pd(y, r), _mm_set1_pd(0.5));
+	y = _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_mul_pd(y, r), r), r), _mm_set1_pd(1.0));
+
+	//Widen the biased exponents to 64-bit lanes and shift into place
+	n = _mm_add_epi32(n, _mm_set1_epi32(1023));
+	n = _mm_slli_epi64(_mm_unpacklo_epi32(n, _mm_setzero_si128()), 52);
+	return _mm_mul_pd(y, _mm_castsi128_pd(n));
+}
+
+static FOUNDATION_FORCEINLINE __m128d
+_math_logn_v64(__m128d x) {
+	__m128i bits = _mm_castpd_si128(x);
+	__m128i biased = _mm_srli_epi64(_mm_and_si128(bits, _mm_set1_epi64x(0x7FF0000000000000LL)), 52);
+	__m128d e = _mm_cvtepi32_pd(_mm_sub_epi32(_mm_shuffle_epi32(biased, _MM_SHUFFLE(3, 1, 2, 0)),
+	                                          _mm_set1_epi32(1023)));
+	__m128d m = _mm_castsi128_pd(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi64x(0x000FFFFFFFFFFFFFLL)),
+	                                          _mm_set1_epi64x(0x3FF0000000000000LL)));
+	__m128d mask = _mm_cmpgt_pd(m, _mm_set1_pd(MATH_SQRT2_64));
+	__m128d s, z, p;
+	m = _math_select_pd(mask, _mm_mul_pd(m, _mm_set1_pd(0.5)), m);
+	e = _mm_add_pd(e, _mm_and_pd(mask, _mm_set1_pd(1.0)));
+
+	s = _mm_div_pd(_mm_sub_pd(m, _mm_set1_pd(1.0)), _mm_add_pd(m, _mm_set1_pd(1.0)));
+	z = _mm_mul_pd(s, s);
+	p = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(2.0 / 19.0), z), _mm_set1_pd(2.0 / 17.0));
+	p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(2.0 / 15.0));
+	p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(2.0 / 13.0));
+	p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(2.0 / 11.0));
+	p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(2.0 / 9.0));
+	p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(2.0 / 7.0));
+	p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(2.0 / 5.0));
+	p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(2.0 / 3.0));
+	p = _mm_add_pd(_mm_add_pd(s, s), _mm_mul_pd(_mm_mul_pd(s, z), p));
+
+	p = _mm_add_pd(_mm_mul_pd(e, _mm_set1_pd(MATH_LN2_LO64)), p);
+	MATH_OPAQUE(p);
+	return _mm_add_pd(p, _mm_mul_pd(e, _mm_set1_pd(MATH_LN2_HI64)));
+}
+
+static FOUNDATION_FORCEINLINE __m128d
+_math_sqrt_v64(__m128d x) {
+	return _mm_sqrt_pd(x);
+}
+
+static FOUNDATION_FORCEINLINE __m128d
+_math_rsqrt_v64(__m128d x) {
+	return _mm_div_pd(_mm_set1_pd(1.0), _mm_sqrt_pd(x));
+}
+
+#define _math_splat32 _mm_set1_ps
+#define _math_mul_v32 _mm_mul_ps
+#define _math_splat64 _mm_set1_pd
+#define _math_mul_v64 _mm_mul_pd
+
+#elif FOUNDATION_ARCH_NEON
+
+typedef float32x4_t math_v32_t;
+
+#define _math_load32  vld1q_f32
+#define _math_store32 vst1q_f32
+
+static FOUNDATION_FORCEINLINE int32x4_t
+_math_round_v32(float32x4_t x) {
+	//Round half away from zero, matching the scalar path
+	uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(x), vdupq_n_u32(0x80000000));
+	float32x4_t half = vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(vdupq_n_f32(0.5f)), sign));
+	return vcvtq_s32_f32(vaddq_f32(x, half));
+}
+
+static FOUNDATION_FORCEINLINE float32x4_t
+_math_sincos_v32(float32x4_t x, int32_t offset) {
+	int32x4_t j = _math_round_v32(vmulq_n_f32(x, MATH_FRAC_2_PI32));
+	float32x4_t fj = vcvtq_f32_s32(j);
+	float32x4_t r, z, ys, yc;
+	uint32x4_t usecos, sign;
+	r = vmlsq_f32(x, fj, vdupq_n_f32(MATH_PIO2_1_32));
+	MATH_OPAQUE(r);
+	r = vmlsq_f32(r, fj, vdupq_n_f32(MATH_PIO2_2_32));
+	MATH_OPAQUE(r);
+	r = vmlsq_f32(r, fj, vdupq_n_f32(MATH_PIO2_3_32));
+	j = vaddq_s32(j, vdupq_n_s32(offset));
+	z = vmulq_f32(r, r);
+
+	ys = vmlaq_f32(vdupq_n_f32(MATH_SIN32_P1), z, vdupq_n_f32(MATH_SIN32_P0));
+	ys = vmlaq_f32(vdupq_n_f32(MATH_SIN32_P2), ys, z);
+	ys = vmlaq_f32(r, vmulq_f32(ys, z), r);
+
+	yc = vmlaq_f32(vdupq_n_f32(MATH_COS32_P1), z, vdupq_n_f32(MATH_COS32_P0));
+	yc = vmlaq_f32(vdupq_n_f32(MATH_COS32_P2), yc, z);
+	yc = vmulq_f32(vmulq_f32(yc, z), z);
+	yc = vaddq_f32(vmlsq_f32(yc, z, vdupq_n_f32(0.5f)), vdupq_n_f32(1.0f));
+
+	usecos = vtstq_s32(j, vdupq_n_s32(1));
+	sign = vshlq_n_u32(vandq_u32(vreinterpretq_u32_s32(j), vdupq_n_u32(2)), 30);
+	return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(vbslq_f32(usecos, yc, ys)), sign));
+}
+
+static FOUNDATION_FORCEINLINE float32x4_t
+_math_exp_v32(float32x4_t x) {
+	int32x4_t n;
+	float32x4_t fn, r, y;
+	x = vminq_f32(vmaxq_f32(x, vdupq_n_f32(MATH_EXP32_LO)), vdupq_n_f32(MATH_EXP32_HI));
+	n = _math_round_v32(vmulq_n_f32(x, MATH_LOG2E32));
+	fn = vcvtq_f32_s32(n);
+	r = vmlsq_f32(x, fn, vdupq_n_f32(MATH_LN2_HI32));
+	MATH_OPAQUE(r);
+	r = vmlsq_f32(r, fn, vdupq_n_f32(MATH_LN2_LO32));
+
+	y = vmlaq_f32(vdupq_n_f32(MATH_EXP32_P1), r, vdupq_n_f32(MATH_EXP32_P0));
+	y = vmlaq_f32(vdupq_n_f32(MATH_EXP32_P2), y, r);
+	y = vmlaq_f32(vdupq_n_f32(MATH_EXP32_P3), y, r);
+	y = vmlaq_f32(vdupq_n_f32(MATH_EXP32_P4), y, r);
+	y = vmlaq_f32(vdupq_n_f32(MATH_EXP32_P5), y, r);
+	y = vaddq_f32(vmlaq_f32(r, vmulq_f32(y, r), r), vdupq_n_f32(1.0f));
+
+	n = vshlq_n_s32(vaddq_s32(n, vdupq_n_s32(127)), 23);
+	return vmulq_f32(y, vreinterpretq_f32_s32(n));
+}
+
+static FOUNDATION_FORCEINLINE float32x4_t
+_math_logn_v32(float32x4_t x) {
+	uint32x4_t bits = vreinterpretq_u32_f32(x);
+	int32x4_t biased = vreinterpretq_s32_u32(vandq_u32(vshrq_n_u32(bits, 23), vdupq_n_u32(0xFF)));
+	float32x4_t e = vcvtq_f32_s32(vsubq_s32(biased, vdupq_n_s32(126)));
+	float32x4_t z, y;
+	uint32x4_t mask;
+	x = vreinterpretq_f32_u32(vorrq_u32(vandq_u32(bits, vdupq_n_u32(0x007FFFFF)), vdupq_n_u32(0x3F000000)));
+	mask = vcltq_f32(x, vdupq_n_f32(MATH_SQRTHF32));
+	e = vsubq_f32(e, vreinterpretq_f32_u32(vandq_u32(mask, vreinterpretq_u32_f32(vdupq_n_f32(1.0f)))));
+	x = vaddq_f32(vsubq_f32(x, vdupq_n_f32(1.0f)),
+	              vreinterpretq_f32_u32(vandq_u32(mask, vreinterpretq_u32_f32(x))));
+	z = vmulq_f32(x, x);
+
+	y = vmlaq_f32(vdupq_n_f32(MATH_LOG32_P1), x, vdupq_n_f32(MATH_LOG32_P0));
+	y = vmlaq_f32(vdupq_n_f32(MATH_LOG32_P2), y, x);
+	y = vmlaq_f32(vdupq_n_f32(MATH_LOG32_P3), y, x);
+	y = vmlaq_f32(vdupq_n_f32(MATH_LOG32_P4), y, x);
+	y = vmlaq_f32(vdupq_n_f32(MATH_LOG32_P5), y, x);
+	y = vmlaq_f32(vdupq_n_f32(MATH_LOG32_P6), y, x);
+	y = vmlaq_f32(vdupq_n_f32(MATH_LOG32_P7), y, x);
+	y = vmlaq_f32(vdupq_n_f32(MATH_LOG32_P8), y, x);
+	y = vmulq_f32(vmulq_f32(y, x), z);
+
+	y = vmlaq_f32(y, e, vdupq_n_f32(MATH_LN2_LO32));
+	y = vmlsq_f32(y, z, vdupq_n_f32(0.5f));
+	MATH_OPAQUE(y);
+	x = vaddq_f32(x, y);
+	MATH_OPAQUE(x);
+	return vmlaq_f32(x, e, vdupq_n_f32(MATH_LN2_HI32));
+}
+
+static FOUNDATION_FORCEINLINE float32x4_t
+_math_rsqrt_v32(float32x4_t x) {
+	//Estimate has 8 bits of precision, two Newton-Raphson steps bring it to ~22 bits
+	float32x4_t y = vrsqrteq_f32(x);
+	y = vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(x, y), y));
+	return vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(x, y), y));
+}
+
+static FOUNDATION_FORCEINLINE float32x4_t
+_math_sqrt_v32(float32x4_t x) {
+	//sqrt(x) = x * rsqrt(x), masking out zero input which would produce NaN
+	uint32x4_t nonzero = vmvnq_u32(vceqq_f32(x, vdupq_n_f32(0.0f)));
+	float32x4_t y = vmulq_f32(x, _math_rsqrt_v32(x));
+	return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(y), nonzero));
+}
+
+#define _math_splat32 vdupq_n_f32
+#define _math_mul_v32 vmulq_f32
+
+#endif
+
+/* Define an array kernel processing full vectors with the SIMD implementation and the
+   remaining tail through a zero padded vector, or every element with the scalar
+   implementation if no SIMD instruction set is available */
+
+#if MATH_SIMD32
+#  define MATH_ARRAY32_KERNEL(dst, src, count, vector_expr, scalar_expr) \
+	do { \
+		size_t i = 0; \
+		math_v32_t v; \
+		for (; i + MATH_SIMD32 <= count; i += MATH_SIMD32) { \
+			v = _math_load32(src + i); \
+			_math_store32(dst + i, vector_expr); \
+		} \
+		if (i < count) { \
+			float32_t tail[MATH_SIMD32] = {1.0f, 1.0f, 1.0f, 1.0f}; \
+			memcpy(tail, src + i, sizeof(float32_t) * (count - i)); \
+			v = _math_load32(tail); \
+			_math_store32(tail, vector_expr); \
+			memcpy(dst + i, tail, sizeof(float32_t) * (count - i)); \
+		} \
+	} while (0)
+#else
+#  define MATH_ARRAY32_KERNEL(dst, src, count, vector_expr, scalar_expr) \
+	do { \
+		size_t i; \
+		for (i = 0; i < count; ++i) { \
+			float32_t s = src[i]; \
+			dst[i] = scalar_expr; \
+		} \
+	} while (0)
+#endif
+
+#if MATH_SIMD64
+#  define MATH_ARRAY64_KERNEL(dst, src, count, vector_expr, scalar_expr) \
+	do { \
+		size_t i = 0; \
+		math_v64_t v; \
+		for (; i + MATH_SIMD64 <= count; i += MATH_SIMD64) { \
+			v = _math_load64(src + i); \
+			_math_store64(dst + i, vector_expr); \
+		} \
+		for (; i < count; ++i) { \
+			float64_t s = src[i]; \
+			dst[i] = scalar_expr; \
+		} \
+	} while (0)
+#else
+#  define MATH_ARRAY64_KERNEL(dst, src, count, vector_expr, scalar_expr) \
+	do { \
+		size_t i; \
+		for (i = 0; i < count; ++i) { \
+			float64_t s = src[i]; \
+			dst[i] = scalar_expr; \
+		} \
+	} while (0)
+#endif
+
+void
+math_sin_array32(float32_t* dst, const float32_t* src, size_t count) {
+	MATH_ARRAY32_KERNEL(dst, src, count, _math_sincos_v32(v, 0), _math_sincos32(s, 0));
+}
+
+void
+math_cos_array32(float32_t* dst, const float32_t* src, size_t count) {
+	MATH_ARRAY32_KERNEL(dst, src, count, _math_sincos_v32(v, 1), _math_sincos32(s, 1));
+}
+
+void
+math_exp_array32(float32_t* dst, const float32_t* src, size_t count) {
+	MATH_ARRAY32_KERNEL(dst, src, count, _math_exp_v32(v), _math_exp32(s));
+}
+
+void
+math_logn_array32(float32_t* dst, const float32_t* src, size_t count) {
+	MATH_ARRAY32_KERNEL(dst, src, count, _math_logn_v32(v), _math_logn32(s));
+}
+
+void
+math_pow_array32(float32_t* dst, const float32_t* src, float32_t exponent, size_t count) {
+	MATH_ARRAY32_KERNEL(dst, src, count,
+	                    _math_exp_v32(_math_mul_v32(_math_logn_v32(v), _math_splat32(exponent))),
+	                    _math_exp32(_math_logn32(s) * exponent));
+}
+
+void
+math_sqrt_array32(float32_t* dst, const float32_t* src, size_t count) {
+	MATH_ARRAY32_KERNEL(dst, src, count, _math_sqrt_v32(v), (float32_t)math_sqrt((real)s));
+}
+
+void
+math_rsqrt_array32(float32_t* dst, const float32_t* src, size_t count) {
+	MATH_ARRAY32_KERNEL(dst, src, count, _math_rsqrt_v32(v), 1.0f / (float32_t)math_sqrt((real)s));
+}
+
+void
+math_sin_array64(float64_t* dst, const float64_t* src, size_t count) {
+	MATH_ARRAY64_KERNEL(dst, src, count, _math_sincos_v64(v, 0), _math_sincos64(s, 0));
+}
+
+void
+math_cos_array64(float64_t* dst, const float64_t* src, size_t count) {
+	MATH_ARRAY64_KERNEL(dst, src, count, _math_sincos_v64(v, 1), _math_sincos64(s, 1));
+}
+
+void
+math_exp_array64(float64_t* dst, const float64_t* src, size_t count) {
+	MATH_ARRAY64_KERNEL(dst, src, count, _math_exp_v64(v), _math_exp64(s));
+}
+
+void
+math_logn_array64(float64_t* dst, const float64_t* src, size_t count) {
+	MATH_ARRAY64_KERNEL(dst, src, count, _math_logn_v64(v), _math_logn64(s));
+}
+
+void
+math_pow_array64(float64_t* dst, const float64_t* src, float64_t exponent, size_t count) {
+	MATH_ARRAY64_KERNEL(dst, src, count,
+	                    _math_exp_v64(_math_mul_v64(_math_logn_v64(v), _math_splat64(exponent))),
+	                    _math_exp64(_math_logn64(s) * exponent));
+}
+
+void
+math_sqrt_array64(float64_t* dst, const float64_t* src, size_t count) {
+	MATH_ARRAY64_KERNEL(dst, src, count, _math_sqrt_v64(v), sqrt(s));
+}
+
+void
+math_rsqrt_array64(float64_t* dst, const float64_t* src, size_t count) {
+	MATH_ARRAY64_KERNEL(dst, src, count, _math_rsqrt_v64(v), 1.0 / sqrt(s));
+}
@@ -410,6 +410,141 @@ math_real_is_denormalized(real val);
 static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL real
 math_real_undenormalize(real val);
 
+/*! Sine function over an array of 32-bit floating point values. Uses a polynomial
+approximation evaluated with SIMD instructions where available. Maximum error is
+2 ulp for arguments in [-8192, 8192], and absolute error is below 2^-23
+close to zero crossings. Destination and source may be the same array.
+\param dst Destination array
+\param src Source array of arguments
+\param count Number of elements */
+FOUNDATION_API void
+math_sin_array32(float32_t* dst, const float32_t* src, size_t count);
+
+/*! Cosine function over an array of 32-bit floating point values. Uses a polynomial
+approximation evaluated with SIMD instructions where available. Maximum error is
+2 ulp for arguments in [-8192, 8192], and absolute error is below 2^-23
+close to zero crossings. Destination and source may be the same array.
+\param dst Destination array
+\param src Source array of arguments
+\param count Number of elements */
+FOUNDATION_API void
+math_cos_array32(float32_t* dst, const float32_t* src, size_t count);
+
+/*! Exponential function over an array of 32-bit floating point values. Uses a polynomial
+approximation evaluated with SIMD instructions where available. Maximum error is 2 ulp.
+Arguments are clamped to [-87, 88]. Destination and source may be the same array.
+\param dst Destination array
+\param src Source array of arguments
+\param count Number of elements */
+FOUNDATION_API void
+math_exp_array32(float32_t* dst, const float32_t* src, size_t count);
+
+/*! Natural logarithm function over an array of 32-bit floating point values. Uses a
+polynomial approximation evaluated with SIMD instructions where available. Maximum error is
+1 ulp. Arguments must be positive normalized values. Destination and source may
+be the same array.
+\param dst Destination array
+\param src Source array of arguments
+\param count Number of elements */
+FOUNDATION_API void
+math_logn_array32(float32_t* dst, const float32_t* src, size_t count);
+
+/*! Power function over an array of 32-bit floating point values, raising each element
+to the given exponent. Computed as exp(exponent * log(x)), so arguments must be positive
+and the error grows with the magnitude of the result exponent. Maximum error is 32 ulp
+while |exponent * log(x)| is less than 16. Destination and source may be the same array.
+\param dst Destination array
+\param src Source array of base values
+\param exponent Exponent
+\param count Number of elements */
+FOUNDATION_API void
+math_pow_array32(float32_t* dst, const float32_t* src, float32_t exponent, size_t count);
+
+/*! Square root function over an array of 32-bit floating point values. Correctly
+rounded on SSE2, maximum error is 2 ulp on NEON. Destination and source may be
+the same array.
+\param dst Destination array
+\param src Source array of arguments
+\param count Number of elements */
+FOUNDATION_API void
+math_sqrt_array32(float32_t* dst, const float32_t* src, size_t count);
+
+/*! Reciprocal square root function over an array of 32-bit floating point values. Uses the
+hardware estimate refined with Newton-Raphson iteration where available, maximum error is
+3 ulp. Arguments must be positive. Destination and source may be the same array.
+\param dst Destination array
+\param src Source array of arguments
+\param count Number of elements */
+FOUNDATION_API void
+math_rsqrt_array32(float32_t* dst, const float32_t* src, size_t count);
+
+/*! Sine function over an array of 64-bit floating point values. Uses a polynomial
+approximation evaluated with SIMD instructions where available. Maximum error is
+2 ulp for arguments in [-1e7, 1e7], and absolute error is below 2^-52
+close to zero crossings. Destination and source may be the same array.
+\param dst Destination array
+\param src Source array of arguments
+\param count Number of elements */
+FOUNDATION_API void
+math_sin_array64(float64_t* dst, const float64_t* src, size_t count);
+
+/*! Cosine function over an array of 64-bit floating point values. Uses a polynomial
+approximation evaluated with SIMD instructions where available. Maximum error is
+2 ulp for arguments in [-1e7, 1e7], and absolute error is below 2^-52
+close to zero crossings. Destination and source may be the same array.
+\param dst Destination array
+\param src Source array of arguments
+\param count Number of elements */
+FOUNDATION_API void
+math_cos_array64(float64_t* dst, const float64_t* src, size_t count);
+
+/*! Exponential function over an array of 64-bit floating point values. Uses a polynomial
+approximation evaluated with SIMD instructions where available. Maximum error is 1 ulp.
+Arguments are clamped to [-708, 708]. Destination and source may be the same array.
+\param dst Destination array
+\param src Source array of arguments
+\param count Number of elements */
+FOUNDATION_API void
+math_exp_array64(float64_t* dst, const float64_t* src, size_t count);
+
+/*! Natural logarithm function over an array of 64-bit floating point values. Uses a
+polynomial approximation evaluated with SIMD instructions where available. Maximum error is
+1 ulp. Arguments must be positive normalized values. Destination and source may
+be the same array.
+\param dst Destination array
+\param src Source array of arguments
+\param count Number of elements */
+FOUNDATION_API void
+math_logn_array64(float64_t* dst, const float64_t* src, size_t count);
+
+/*! Power function over an array of 64-bit floating point values, raising each element
+to the given exponent. Computed as exp(exponent * log(x)), so arguments must be positive
+and the error grows with the magnitude of the result exponent. Maximum error is 32 ulp
+while |exponent * log(x)| is less than 16. Destination and source may be the same array.
+\param dst Destination array
+\param src Source array of base values
+\param exponent Exponent
+\param count Number of elements */
+FOUNDATION_API void
+math_pow_array64(float64_t* dst, const float64_t* src, float64_t exponent, size_t count);
+
+/*! Square root function over an array of 64-bit floating point values. Correctly rounded.
+Destination and source may be the same array.
+\param dst Destination array
+\param src Source array of arguments
+\param count Number of elements */
+FOUNDATION_API void
+math_sqrt_array64(float64_t* dst, const float64_t* src, size_t count);
+
+/*! Reciprocal square root function over an array of 64-bit floating point values.
+Maximum error is 2 ulp. Arguments must be positive. Destination and source may be the
+same array.
+\param dst Destination array
+\param src Source array of arguments
+\param count Number of elements */
+FOUNDATION_API void
+math_rsqrt_array64(float64_t* dst, const float64_t* src, size_t count);
+
 #if BUILD_ENABLE_ASSERT
 /*! Assert that a value is finite. Like all assert macros it will evaluate to a void
 expression if asserts are disabled.
@@ -423,6 +558,55 @@ expression if asserts are disabled.
 	/*lint -save -e717 */ do { (void)sizeof( value ); } while(0) /*lint -restore */
 #endif
 
+/*!
+\def math_sin_array
+Sine function over an array of real values, see #math_sin_array32 and #math_sin_array64
+
+\def math_cos_array
+Cosine function over an array of real values, see #math_cos_array32 and #math_cos_array64
+
+\def math_exp_array
+Exponential function over an array of real values, see #math_exp_array32 and
+#math_exp_array64
+
+\def math_logn_array
+Natural logarithm function over an array of real values, see #math_logn_array32 and
+#math_logn_array64
+
+\def math_pow_array
+Power function over an array of real values, see #math_pow_array32 and #math_pow_array64
+
+\def math_sqrt_array
+Square root function over an array of real values, see #math_sqrt_array32 and
+#math_sqrt_array64
+
+\def math_rsqrt_array
+Reciprocal square root function over an array of real values, see #math_rsqrt_array32
+and #math_rsqrt_array64
+*/
+
+#if FOUNDATION_SIZE_REAL == 8
+
+#define math_sin_array    math_sin_array64
+#define math_cos_array    math_cos_array64
+#define math_exp_array    math_exp_array64
+#define math_logn_array   math_logn_array64
+#define math_pow_array    math_pow_array64
+#define math_sqrt_array   math_sqrt_array64
+#define math_rsqrt_array  math_rsqrt_array64
+
+#else
+
+#define math_sin_array    math_sin_array32
+#define math_cos_array    math_cos_array32
+#define math_exp_array    math_exp_array32
+#define math_logn_array   math_logn_array32
+#define math_pow_array    math_pow_array32
+#define math_sqrt_array   math_sqrt_array32
+#define math_rsqrt_array  math_rsqrt_array32
+
+#endif
+
 /*!
 \fn math_inc_wrap_uint8
 \brief Increment and wrap
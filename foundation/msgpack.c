@@ -0,0 +1,382 @@
+/* msgpack.c  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+
+//Limit nesting to keep recursion bounded on malicious input
+#define MSGPACK_MAX_DEPTH 512
+
+static void
+msgpack_write_tag(stream_t* stream, uint8_t tag, uint64_t value, size_t bytes) {
+	uint8_t data[9];
+	size_t ibyte;
+	data[0] = tag;
+	for (ibyte = 0; ibyte < bytes; ++ibyte)
+		data[bytes - ibyte] = (uint8_t)(value >> (ibyte * 8));
+	stream_write(stream, data, bytes + 1);
+}
+
+static void
+msgpack_write_length(stream_t* stream, uint8_t tag, size_t length) {
+	//Tag is the 8 bit variant, 16 and 32 bit variants follow
+	if (length <= 0xFF)
+		msgpack_write_tag(stream, tag, length, 1);
+	else if (length <= 0xFFFF)
+		msgpack_write_tag(stream, tag + 1, length, 2);
+	else
+		msgpack_write_tag(stream, tag + 2, length, 4);
+}
+
+void
+msgpack_write_nil(stream_t* stream) {
+	msgpack_write_tag(stream, 0xC0, 0, 0);
+}
+
+void
+msgpack_write_bool(stream_t* stream, bool value) {
+	msgpack_write_tag(stream, value ? 0xC3 : 0xC2, 0, 0);
+}
+
+void
+msgpack_write_int(stream_t* stream, int64_t value) {
+	if (value >= 0)
+		msgpack_write_uint(stream, (uint64_t)value);
+	else if (value >= -32)
+		msgpack_write_tag(stream, (uint8_t)value, 0, 0);
+	else if (value >= INT8_MIN)
+		msgpack_write_tag(stream, 0xD0, (uint64_t)value, 1);
+	else if (value >= INT16_MIN)
+		msgpack_write_tag(stream, 0xD1, (uint64_t)value, 2);
+	else if (value >= INT32_MIN)
+		msgpack_write_tag(stream, 0xD2, (uint64_t)value, 4);
+	else
+		msgpack_write_tag(stream, 0xD3, (uint64_t)value, 8);
+}
+
+void
+msgpack_write_uint(stream_t* stream, uint64_t value) {
+	if (value < 0x80)
+		msgpack_write_tag(stream, (uint8_t)value, 0, 0);
+	else if (value <= UINT8_MAX)
+		msgpack_write_tag(stream, 0xCC, value, 1);
+	else if (value <= UINT16_MAX)
+		msgpack_write_tag(stream, 0xCD, value, 2);
+	else if (value <= UINT32_MAX)
+		msgpack_write_tag(stream, 0xCE, value, 4);
+	else
+		msgpack_write_tag(stream, 0xCF, value, 8);
+}
+
+void
+msgpack_write_float32(stream_t* stream, float32_t value) {
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	msgpack_write_tag(stream, 0xCA, bits, 4);
+}
+
+void
+msgpack_write_float64(stream_t* stream, float64_t value) {
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	msgpack_write_tag(stream, 0xCB, bits, 8);
+}
+
+void
+msgpack_write_string(stream_t* stream, const char* str, size_t length) {
+	if (length < 32)
+		msgpack_write_tag(stream, (uint8_t)(0xA0 | length), 0, 0);
+	else
+		msgpack_write_length(stream, 0xD9, length);
+	stream_write(stream, str, length);
+}
+
+void
+msgpack_write_binary(stream_t* stream, const void* data, size_t size) {
+	msgpack_write_length(stream, 0xC4, size);
+	stream_write(stream, data, size);
+}
+
+void
+msgpack_write_array(stream_t* stream, size_t count) {
+	if (count < 16)
+		msgpack_write_tag(stream, (uint8_t)(0x90 | count), 0, 0);
+	else if (count <= 0xFFFF)
+		msgpack_write_tag(stream, 0xDC, count, 2);
+	else
+		msgpack_write_tag(stream, 0xDD, count, 4);
+}
+
+void
+msgpack_write_map(stream_t* stream, size_t count) {
+	if (count < 16)
+		msgpack_write_tag(stream, (uint8_t)(0x80 | count), 0, 0);
+	else if (count <= 0xFFFF)
+		msgpack_write_tag(stream, 0xDE, count, 2);
+	else
+		msgpack_write_tag(stream, 0xDF, count, 4);
+}
+
+static uint64_t
+msgpack_read(const char* buffer, size_t bytes) {
+	const uint8_t* data = (const uint8_t*)buffer;
+	uint64_t value = 0;
+	size_t ibyte;
+	for (ibyte = 0; ibyte < bytes; ++ibyte)
+		value = (value << 8) | data[ibyte];
+	return value;
+}
+
+static json_token_t*
+get_token(json_token_t* tokens, size_t capacity, unsigned int index) {
+	return index < capacity ? tokens + index : nullptr;
+}
+
+static void
+set_token(json_token_t* tokens, size_t capacity, unsigned int current, json_type_t type,
+          size_t value, size_t value_length, unsigned int child) {
+	json_token_t* token = get_token(tokens, capacity, current);
+	if (token) {
+		token->type = type;
+		token->child = child;
+		token->sibling = 0;
+		token->value = (unsigned int)value;
+		token->value_length = (unsigned int)value_length;
+	}
+}
+
+static void
+set_token_id(json_token_t* tokens, size_t capacity, unsigned int current,
+             size_t id, size_t id_length) {
+	json_token_t* token = get_token(tokens, capacity, current);
+	if (token) {
+		token->id = (unsigned int)id;
+		token->id_length = (unsigned int)id_length;
+	}
+}
+
+//Parse a string or binary header at the given position, returning position of data
+static size_t
+parse_string(const char* buffer, size_t size, size_t pos, size_t* length) {
+	uint8_t tag = (uint8_t)buffer[pos++];
+	size_t bytes;
+	if ((tag & 0xE0) == 0xA0) {
+		*length = tag & 0x1F;
+		bytes = 0;
+	}
+	else if ((tag == 0xD9) || (tag == 0xC4))
+		bytes = 1;
+	else if ((tag == 0xDA) || (tag == 0xC5))
+		bytes = 2;
+	else if ((tag == 0xDB) || (tag == 0xC6))
+		bytes = 4;
+	else
+		return STRING_NPOS;
+	if (bytes) {
+		if (size - pos < bytes)
+			return STRING_NPOS;
+		*length = (size_t)msgpack_read(buffer + pos, bytes);
+		pos += bytes;
+	}
+	if (size - pos < *length)
+		return STRING_NPOS;
+	return pos;
+}
+
+static size_t
+parse_value(const char* buffer, size_t size, size_t pos,
+            json_token_t* tokens, size_t capacity, unsigned int* current, unsigned int depth);
+
+static size_t
+parse_container(const char* buffer, size_t size, size_t pos, size_t count, bool map,
+                json_token_t* tokens, size_t capacity, unsigned int* current, unsigned int depth) {
+	json_token_t* token;
+	unsigned int now;
+	unsigned int last = 0;
+	size_t ielem, key, length;
+
+	if (depth >= MSGPACK_MAX_DEPTH)
+		return STRING_NPOS;
+
+	set_token(tokens, capacity, *current, map ? JSON_OBJECT : JSON_ARRAY, 0, 0,
+	          count ? *current + 1 : 0);
+	++(*current);
+
+	for (ielem = 0; ielem < count; ++ielem) {
+		now = *current;
+		if (map) {
+			if (pos >= size)
+				return STRING_NPOS;
+			key = parse_string(buffer, size, pos, &length);
+			if ((key == STRING_NPOS) || ((uint8_t)buffer[pos] == 0xC4) ||
+			        ((uint8_t)buffer[pos] == 0xC5) || ((uint8_t)buffer[pos] == 0xC6))
+				return STRING_NPOS;
+			set_token_id(tokens, capacity, now, key, length);
+			pos = key + length;
+		}
+		else {
+			set_token_id(tokens, capacity, now, 0, 0);
+		}
+		pos = parse_value(buffer, size, pos, tokens, capacity, current, depth + 1);
+		if (pos == STRING_NPOS)
+			return STRING_NPOS;
+		if (last && (token = get_token(tokens, capacity, last)))
+			token->sibling = now;
+		last = now;
+	}
+
+	return pos;
+}
+
+static size_t
+parse_value(const char* buffer, size_t size, size_t pos,
+            json_token_t* tokens, size_t capacity, unsigned int* current, unsigned int depth) {
+	size_t length = 0;
+	size_t data;
+	uint8_t tag;
+
+	if (pos >= size)
+		return STRING_NPOS;
+
+	tag = (uint8_t)buffer[pos];
+	if ((tag < 0x80) || (tag >= 0xE0) || (tag == 0xC0) || (tag == 0xC2) || (tag == 0xC3))
+		length = 1;
+	else if ((tag & 0xF0) == 0x80)
+		return parse_container(buffer, size, pos + 1, tag & 0x0F, true,
+		                       tokens, capacity, current, depth);
+	else if ((tag & 0xF0) == 0x90)
+		return parse_container(buffer, size, pos + 1, tag & 0x0F, false,
+		                       tokens, capacity, current, depth);
+	else if ((tag == 0xDC) || (tag == 0xDE) || (tag == 0xDD) || (tag == 0xDF)) {
+		size_t bytes = ((tag == 0xDC) || (tag == 0xDE)) ? 2 : 4;
+		if (size - pos - 1 < bytes)
+			return STRING_NPOS;
+		return parse_container(buffer, size, pos + 1 + bytes,
+		                       (size_t)msgpack_read(buffer + pos + 1, bytes),
+		                       (tag == 0xDE) || (tag == 0xDF), tokens, capacity, current, depth);
+	}
+	else if (((tag & 0xE0) == 0xA0) || ((tag >= 0xD9) && (tag <= 0xDB)) ||
+	         ((tag >= 0xC4) && (tag <= 0xC6))) {
+		data = parse_string(buffer, size, pos, &length);
+		if (data == STRING_NPOS)
+			return STRING_NPOS;
+		set_token(tokens, capacity, *current, JSON_STRING, data, length, 0);
+		++(*current);
+		return data + length;
+	}
+	else if ((tag == 0xCC) || (tag == 0xD0))
+		length = 2;
+	else if ((tag == 0xCD) || (tag == 0xD1))
+		length = 3;
+	else if ((tag == 0xCA) || (tag == 0xCE) || (tag == 0xD2))
+		length = 5;
+	else if ((tag == 0xCB) || (tag == 0xCF) || (tag == 0xD3))
+		length = 9;
+	else
+		return STRING_NPOS; //Unused tag or extension type
+
+	if (size - pos < length)
+		return STRING_NPOS;
+	set_token(tokens, capacity, *current, JSON_PRIMITIVE, pos, length, 0);
+	++(*current);
+	return pos + length;
+}
+
+size_t
+msgpack_parse(const char* buffer, size_t size, json_token_t* tokens, size_t capacity) {
+	unsigned int current = 0;
+	set_token_id(tokens, capacity, current, 0, 0);
+	set_token(tokens, capacity, current, JSON_UNDEFINED, 0, 0, 0);
+	if (parse_value(buffer, size, 0, tokens, capacity, &current, 0) == STRING_NPOS)
+		return 0;
+	return current;
+}
+
+bool
+msgpack_token_is_nil(const char* buffer, const json_token_t* token) {
+	return (token->type == JSON_PRIMITIVE) && ((uint8_t)buffer[token->value] == 0xC0);
+}
+
+bool
+msgpack_token_bool(const char* buffer, const json_token_t* token) {
+	return (token->type == JSON_PRIMITIVE) && ((uint8_t)buffer[token->value] == 0xC3);
+}
+
+int64_t
+msgpack_token_int(const char* buffer, const json_token_t* token) {
+	const char* data;
+	uint8_t tag;
+	if (token->type != JSON_PRIMITIVE)
+		return 0;
+	data = buffer + token->value;
+	tag = (uint8_t)data[0];
+	if (tag < 0x80)
+		return tag;
+	if (tag >= 0xE0)
+		return (int8_t)tag;
+	switch (tag) {
+	case 0xD0: return (int8_t)msgpack_read(data + 1, 1);
+	case 0xD1: return (int16_t)msgpack_read(data + 1, 2);
+	case 0xD2: return (int32_t)msgpack_read(data + 1, 4);
+	case 0xD3: return (int64_t)msgpack_read(data + 1, 8);
+	case 0xCA: case 0xCB: return (int64_t)msgpack_token_float(buffer, token);
+	default: break;
+	}
+	return (int64_t)msgpack_token_uint(buffer, token);
+}
+
+uint64_t
+msgpack_token_uint(const char* buffer, const json_token_t* token) {
+	const char* data;
+	uint8_t tag;
+	if (token->type != JSON_PRIMITIVE)
+		return 0;
+	data = buffer + token->value;
+	tag = (uint8_t)data[0];
+	if (tag < 0x80)
+		return tag;
+	switch (tag) {
+	case 0xCC: return msgpack_read(data + 1, 1);
+	case 0xCD: return msgpack_read(data + 1, 2);
+	case 0xCE: return msgpack_read(data + 1, 4);
+	case 0xCF: return msgpack_read(data + 1, 8);
+	case 0xCA: case 0xCB: return (uint64_t)msgpack_token_float(buffer, token);
+	default: break;
+	}
+	if ((tag >= 0xE0) || ((tag >= 0xD0) && (tag <= 0xD3)))
+		return (uint64_t)msgpack_token_int(buffer, token);
+	return 0;
+}
+
+float64_t
+msgpack_token_float(const char* buffer, const json_token_t* token) {
+	const char* data;
+	uint8_t tag;
+	if (token->type != JSON_PRIMITIVE)
+		return 0;
+	data = buffer + token->value;
+	tag = (uint8_t)data[0];
+	if (tag == 0xCA) {
+		uint32_t bits = (uint32_t)msgpack_read(data + 1, 4);
+		float32_t value;
+		memcpy(&value, &bits, sizeof(value));
+		return (float64_t)value;
+	}
+	if (tag == 0xCB) {
+		uint64_t bits = msgpack_read(data + 1, 8);
+		float64_t value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+	if ((tag == 0xCF) || ((tag >= 0xCC) && (tag <= 0xCE)) || (tag < 0x80))
+		return (float64_t)msgpack_token_uint(buffer, token);
+	return (float64_t)msgpack_token_int(buffer, token);
+}
@@ -0,0 +1,166 @@
+/* msgpack.h  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#pragma once
+
+/*! \file msgpack.h
+\brief MessagePack binary serialization
+
+Schema-less binary serialization in MessagePack format. The encoder writes values
+directly to a stream, containers are written as a header with the number of elements
+(or key-value pairs for maps) followed by the elements.
+
+The parser works in-place on a memory buffer without any allocation and produces
+the same token tree as #json_parse, allowing code consuming JSON tokens to switch
+format. Maps become JSON_OBJECT tokens and require string keys, arrays become
+JSON_ARRAY tokens, strings and binary data become JSON_STRING tokens and all other
+values become JSON_PRIMITIVE tokens. Identifiers and string values point directly
+to the raw (unescaped) data in the buffer. The value of a primitive token is the
+binary encoded value, use the msgpack_token_* functions to decode it. Extension
+types are not supported. */
+
+#include <foundation/platform.h>
+#include <foundation/types.h>
+#include <foundation/string.h>
+
+/*! Write a nil value
+\param stream Stream */
+FOUNDATION_API void
+msgpack_write_nil(stream_t* stream);
+
+/*! Write a boolean value
+\param stream Stream
+\param value Value */
+FOUNDATION_API void
+msgpack_write_bool(stream_t* stream, bool value);
+
+/*! Write a signed integer value using the smallest encoding
+\param stream Stream
+\param value Value */
+FOUNDATION_API void
+msgpack_write_int(stream_t* stream, int64_t value);
+
+/*! Write an unsigned integer value using the smallest encoding
+\param stream Stream
+\param value Value */
+FOUNDATION_API void
+msgpack_write_uint(stream_t* stream, uint64_t value);
+
+/*! Write a single precision floating point value
+\param stream Stream
+\param value Value */
+FOUNDATION_API void
+msgpack_write_float32(stream_t* stream, float32_t value);
+
+/*! Write a double precision floating point value
+\param stream Stream
+\param value Value */
+FOUNDATION_API void
+msgpack_write_float64(stream_t* stream, float64_t value);
+
+/*! Write a string value, also used for map keys
+\param stream Stream
+\param str String
+\param length Length of string */
+FOUNDATION_API void
+msgpack_write_string(stream_t* stream, const char* str, size_t length);
+
+/*! Write a binary data value
+\param stream Stream
+\param data Data
+\param size Size of data */
+FOUNDATION_API void
+msgpack_write_binary(stream_t* stream, const void* data, size_t size);
+
+/*! Write an array header, must be followed by the given number of values
+\param stream Stream
+\param count Number of values in array */
+FOUNDATION_API void
+msgpack_write_array(stream_t* stream, size_t count);
+
+/*! Write a map header, must be followed by the given number of key-value pairs,
+each written as a string key followed by a value
+\param stream Stream
+\param count Number of key-value pairs in map */
+FOUNDATION_API void
+msgpack_write_map(stream_t* stream, size_t count);
+
+/*! Parse a MessagePack blob holding a single value. Number of parsed tokens can be greater
+than the supplied capacity to indicate the need for additional capacity for a full parse.
+\param buffer Data buffer
+\param size Size of data buffer
+\param tokens Token array
+\param capacity Capacity of token array (number of tokens)
+\return Number of parsed tokens, 0 if error */
+FOUNDATION_API size_t
+msgpack_parse(const char* buffer, size_t size, json_token_t* tokens, size_t capacity);
+
+/*! Query if a primitive token is a nil value
+\param buffer Data buffer
+\param token Token
+\return true if nil, false if not */
+FOUNDATION_API bool
+msgpack_token_is_nil(const char* buffer, const json_token_t* token);
+
+/*! Get boolean value of a primitive token
+\param buffer Data buffer
+\param token Token
+\return Boolean value, false if not a boolean */
+FOUNDATION_API bool
+msgpack_token_bool(const char* buffer, const json_token_t* token);
+
+/*! Get signed integer value of a primitive token. Floating point values are truncated
+\param buffer Data buffer
+\param token Token
+\return Integer value, 0 if not a number */
+FOUNDATION_API int64_t
+msgpack_token_int(const char* buffer, const json_token_t* token);
+
+/*! Get unsigned integer value of a primitive token. Floating point values are truncated
+\param buffer Data buffer
+\param token Token
+\return Integer value, 0 if not a number */
+FOUNDATION_API uint64_t
+msgpack_token_uint(const char* buffer, const json_token_t* token);
+
+/*! Get floating point value of a primitive token. Integer values are converted
+\param buffer Data buffer
+\param token Token
+\return Floating point value, 0 if not a number */
+FOUNDATION_API float64_t
+msgpack_token_float(const char* buffer, const json_token_t* token);
+
+/*! Convenience function to get identifier string. Same as #json_token_identifier
+\param buffer Data buffer
+\param token Token
+\return Identifier string */
+static FOUNDATION_FORCEINLINE string_const_t
+msgpack_token_identifier(const char* buffer, const json_token_t* token);
+
+/*! Convenience function to get string or binary data value of a string token
+\param buffer Data buffer
+\param token Token
+\return Value string */
+static FOUNDATION_FORCEINLINE string_const_t
+msgpack_token_string(const char* buffer, const json_token_t* token);
+
+// Implementations
+
+static FOUNDATION_FORCEINLINE string_const_t
+msgpack_token_identifier(const char* buffer, const json_token_t* token) {
+	return string_const(buffer + token->id, token->id_length);
+}
+
+static FOUNDATION_FORCEINLINE string_const_t
+msgpack_token_string(const char* buffer, const json_token_t* token) {
+	return string_const(buffer + token->value, token->value_length);
+}
@@ -16,6 +16,25 @@
 FOUNDATION_STATIC_ASSERT(FOUNDATION_ALIGNOF(object_base_t) >= 8, "object_base_t alignment");
 FOUNDATION_STATIC_ASSERT(FOUNDATION_ALIGNOF(objectmap_t) >= 8, "objectmap_t alignment");
 
+#define OBJECTMAP_DEFERRED_BATCH_SIZE 64
+
+typedef struct objectmap_deferred_t objectmap_deferred_t;
+
+//Batch of objects with deferred destruction, filled by a single thread and then
+//handed over to the collecting thread in one operation
+struct objectmap_deferred_t {
+	objectmap_deferred_t* next;
+	size_t count;
+	struct {
+		object_t id;
+		void* object;
+		object_deallocate_fn deallocate;
+	} entry[OBJECTMAP_DEFERRED_BATCH_SIZE];
+};
+
+FOUNDATION_DECLARE_THREAD_LOCAL(objectmap_deferred_t*, objectmap_deferred, 0)
+static atomicptr_t _objectmap_deferred;
+
 void
 _object_initialize(object_base_t* obj, object_t id) {
 	obj->id = id;
@@ -62,6 +81,9 @@ objectmap_initialize(objectmap_t* map, size_t size) {
 	for (ip = 0, next_indexshift = 3; ip < (size - 1); ++ip, next_indexshift += 2, ++slot)
 		*slot = (void*)next_indexshift;
 	*slot = (void*)((uintptr_t)-1);
+
+	map->occupied = memory_allocate(0, sizeof(atomic64_t) * ((size + 63) / 64), 16,
+	                                MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
 }
 
 void
@@ -85,6 +107,31 @@ objectmap_finalize(objectmap_t* map) {
 			break;
 		}
 	}
+
+	memory_deallocate(map->occupied);
+	map->occupied = 0;
+}
+
+static void
+_objectmap_occupy(objectmap_t* map, size_t idx) {
+	atomic64_t* word = map->occupied + (idx >> 6);
+	int64_t bit = (int64_t)(1ULL << (idx & 63));
+	int64_t bits;
+	do {
+		bits = atomic_load64(word);
+	}
+	while (!atomic_cas64(word, bits | bit, bits));
+}
+
+static void
+_objectmap_vacate(objectmap_t* map, size_t idx) {
+	atomic64_t* word = map->occupied + (idx >> 6);
+	int64_t bit = (int64_t)(1ULL << (idx & 63));
+	int64_t bits;
+	do {
+		bits = atomic_load64(word);
+	}
+	while (!atomic_cas64(word, bits & ~bit, bits));
 }
 
 size_t
@@ -148,6 +195,9 @@ objectmap_free(objectmap_t* map, object_t id) {
 	if (!FOUNDATION_VALIDATE((((object_base_t*)object)->id & map->mask_id) == (id & map->mask_id)))
 		return false;
 
+	//Clear occupancy before slot is made available to reserve
+	_objectmap_vacate(map, (size_t)idx);
+
 	free = idx | (((uint64_t)atomic_incr64(&map->id) << map->size_bits) & map->mask_id);
 	do {
 		raw = (uint64_t)atomic_load64(&map->free);
@@ -170,11 +220,46 @@ objectmap_set(objectmap_t* map, object_t id, void* object) {
 	FOUNDATION_ASSERT(!(((uintptr_t)map->map[idx]) & 1));
 	if (FOUNDATION_VALIDATE(!map->map[idx])) {
 		map->map[idx] = object;
+		_objectmap_occupy(map, idx);
 		return true;
 	}
 	return false;
 }
 
+void*
+objectmap_iterate(const objectmap_t* map, size_t* index) {
+	size_t idx = *index;
+	while (idx < map->size) {
+		size_t iword = idx >> 6;
+		uint64_t bits = (uint64_t)atomic_load64(map->occupied + iword) & (~0ULL << (idx & 63));
+		while (bits) {
+			size_t islot = (iword << 6) + bits_ctz64(bits);
+			//Slot might have been freed since the bitmap was read
+			void* object = objectmap_raw_lookup(map, islot);
+			if (object) {
+				*index = islot + 1;
+				return object;
+			}
+			bits &= bits - 1;
+		}
+		idx = (iword + 1) << 6;
+	}
+	*index = map->size;
+	return 0;
+}
+
+int
+objectmap_foreach(const objectmap_t* map, objectmap_foreach_fn fn, void* data) {
+	size_t index = 0;
+	void* object;
+	while ((object = objectmap_iterate(map, &index))) {
+		int ret = fn(object, data);
+		if (ret)
+			return ret;
+	}
+	return 0;
+}
+
 void*
 objectmap_lookup_ref(const objectmap_t* map, object_t id) {
 	void* object;
@@ -218,3 +303,110 @@ objectmap_lookup_unref(const objectmap_t* map, object_t id, object_deallocate_fn
 	return false;
 }
 
+static void
+_objectmap_deferred_push(objectmap_deferred_t* batch) {
+	void* head;
+	do {
+		head = atomic_load_ptr(&_objectmap_deferred);
+		batch->next = head;
+	}
+	while (!atomic_cas_ptr(&_objectmap_deferred, batch, head));
+}
+
+static objectmap_deferred_t*
+_objectmap_deferred_take(void) {
+	void* head;
+	do {
+		head = atomic_load_ptr(&_objectmap_deferred);
+	}
+	while (head && !atomic_cas_ptr(&_objectmap_deferred, 0, head));
+	return head;
+}
+
+bool
+objectmap_lookup_unref_deferred(const objectmap_t* map, object_t id,
+                                object_deallocate_fn deallocate) {
+	void* object;
+	int32_t ref;
+	do {
+		ref = 0;
+		object = map->map[ id & map->mask_index ];
+		if (object && !((uintptr_t)object & 1) &&
+		        ((((object_base_t*)object)->id & map->mask_id) == (id & map->mask_id))) {
+			object_base_t* base_obj = object;
+			ref = atomic_load32(&base_obj->ref);
+			if (ref && atomic_cas32(&base_obj->ref, ref - 1, ref)) {
+				if (ref == 1) {
+					objectmap_deferred_t* batch = get_thread_objectmap_deferred();
+					if (!batch) {
+						batch = memory_allocate(0, sizeof(objectmap_deferred_t), 0, MEMORY_PERSISTENT);
+						batch->count = 0;
+						set_thread_objectmap_deferred(batch);
+					}
+					batch->entry[batch->count].id = id;
+					batch->entry[batch->count].object = object;
+					batch->entry[batch->count].deallocate = deallocate;
+					if (++batch->count == OBJECTMAP_DEFERRED_BATCH_SIZE) {
+						_objectmap_deferred_push(batch);
+						set_thread_objectmap_deferred(0);
+					}
+					return false;
+				}
+				return true;
+			}
+		}
+	}
+	while (ref);
+	return false;
+}
+
+void
+objectmap_deferred_flush(void) {
+	objectmap_deferred_t* batch = get_thread_objectmap_deferred();
+	if (batch) {
+		_objectmap_deferred_push(batch);
+		set_thread_objectmap_deferred(0);
+	}
+}
+
+size_t
+objectmap_deferred_collect(void) {
+	objectmap_deferred_t* batch;
+	size_t count = 0;
+
+	objectmap_deferred_flush();
+
+	batch = _objectmap_deferred_take();
+	while (batch) {
+		objectmap_deferred_t* next = batch->next;
+		size_t ientry;
+		for (ientry = 0; ientry < batch->count; ++ientry)
+			batch->entry[ientry].deallocate(batch->entry[ientry].id, batch->entry[ientry].object);
+		count += batch->count;
+		memory_deallocate(batch);
+		batch = next;
+	}
+
+	return count;
+}
+
+void
+_objectmap_finalize(void) {
+	objectmap_deferred_t* batch;
+	size_t count = 0;
+
+	objectmap_deferred_flush();
+
+	//Maps and deallocation functions may already be gone, only release the queue storage
+	batch = _objectmap_deferred_take();
+	while (batch) {
+		objectmap_deferred_t* next = batch->next;
+		count += batch->count;
+		memory_deallocate(batch);
+		batch = next;
+	}
+
+	if (count)
+		log_errorf(0, ERROR_MEMORY_LEAK,
+		           STRING_CONST("%" PRIsize " objects with deferred destruction never collected"), count);
+}
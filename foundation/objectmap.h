@@ -81,6 +81,28 @@ objectmap_set(objectmap_t* map, object_t id, void* object);
 FOUNDATION_API void*
 objectmap_raw_lookup(const objectmap_t* map, size_t index);
 
+/*! Get the next object stored in the map at or after the given map index. Only slots
+marked in the occupancy bitmap are visited, making iteration of a sparsely populated map
+proportional to the number of stored objects rather than the map size. Iteration is lock
+free and can run concurrently with reserve, set and free, but objects stored or freed
+during iteration may or may not be visited. Like #objectmap_lookup the object lifetime
+is not guaranteed, use #objectmap_lookup_ref with the object id if needed.
+\param map Object map
+\param index Map index to start at, updated to the index after the returned object.
+              Start iteration with index 0
+\return Object pointer, 0 if no more objects */
+FOUNDATION_API void*
+objectmap_iterate(const objectmap_t* map, size_t* index);
+
+/*! Call the function for each object stored in the map, see #objectmap_iterate for
+concurrency and lifetime considerations.
+\param map Object map
+\param fn Function to call for each object, return non-zero to stop iteration
+\param data Data passed to the function
+\return Return value of the function stopping iteration, 0 if all objects visited */
+FOUNDATION_API int
+objectmap_foreach(const objectmap_t* map, objectmap_foreach_fn fn, void* data);
+
 /*! Map object handle to object pointer. This function is unsafe in the sense that it
 might return an object pointer which points to an invalid (deallocated) object if
 the object reference count was decreased in another thread while this function is
@@ -116,6 +138,34 @@ is safe in the sense that it will work correctly across threads also using the
 FOUNDATION_API bool
 objectmap_lookup_unref(const objectmap_t* map, object_t id, object_deallocate_fn deallocate);
 
+/*! Map object handle to object pointer and decrease ref count, deferring destruction.
+Behaves like #objectmap_lookup_unref, except that if the reference count reaches zero the
+object is queued in a batch owned by the calling thread instead of being deallocated
+immediately. Full batches are handed over to a shared lock free queue, and the queued
+objects are deallocated on the next call to #objectmap_deferred_collect. Until then the
+object keeps its map slot, but it can no longer be referenced.
+\param map Object map
+\param id Object handle
+\param deallocate Deallocation function
+\return true if object is still valid, false if it was queued for deallocation */
+FOUNDATION_API bool
+objectmap_lookup_unref_deferred(const objectmap_t* map, object_t id,
+                                object_deallocate_fn deallocate);
+
+/*! Hand over the partially filled batch of objects queued for deferred destruction by the
+calling thread to the shared queue. Called automatically on thread exit, call this at safe
+points in threads releasing objects infrequently to have the objects collected.
+See #objectmap_lookup_unref_deferred */
+FOUNDATION_API void
+objectmap_deferred_flush(void);
+
+/*! Deallocate all objects queued for deferred destruction, including the objects queued
+by the calling thread. Should be called periodically by a designated thread or at a safe
+point. See #objectmap_lookup_unref_deferred
+\return Number of objects deallocated */
+FOUNDATION_API size_t
+objectmap_deferred_collect(void);
+
 // Implementation
 
 static FOUNDATION_FORCEINLINE FOUNDATION_PURECALL void*
@@ -0,0 +1,528 @@
+/* sketch.c  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+
+#include <stdlib.h>
+
+#define HYPERLOGLOG_MAGIC         0x484c4c53U
+#define HYPERLOGLOG_MIN_PRECISION 4
+#define HYPERLOGLOG_MAX_PRECISION 18
+#define HYPERLOGLOG_MIN_SPARSE    64
+
+#define COUNTMIN_MAGIC            0x434d534bU
+
+#define HYPERLOGLOG_REGISTERS(sketch) ((size_t)1 << (sketch)->precision)
+#define HYPERLOGLOG_ENTRY(index, rank) (((uint32_t)(index) << 8) | (uint32_t)(rank))
+
+//Sparse list is limited to an eighth of the dense register count, half the dense size
+static size_t
+_hyperloglog_max_sparse(const hyperloglog_t* sketch) {
+	return HYPERLOGLOG_REGISTERS(sketch) / 8;
+}
+
+static int
+_hyperloglog_entry_compare(const void* lhs, const void* rhs) {
+	uint32_t left = *(const uint32_t*)lhs;
+	uint32_t right = *(const uint32_t*)rhs;
+	return (left < right) ? -1 : ((left > right) ? 1 : 0);
+}
+
+//Sort sparse list and keep the maximum value for each register, which sorts last
+static void
+_hyperloglog_compact(hyperloglog_t* sketch) {
+	size_t isrc, idst = 0;
+	if (sketch->num_sparse < 2)
+		return;
+	qsort(sketch->sparse, sketch->num_sparse, sizeof(uint32_t), _hyperloglog_entry_compare);
+	for (isrc = 0; isrc < sketch->num_sparse; ++isrc) {
+		if ((isrc + 1 < sketch->num_sparse) &&
+		        ((sketch->sparse[isrc] >> 8) == (sketch->sparse[isrc + 1] >> 8)))
+			continue;
+		sketch->sparse[idst++] = sketch->sparse[isrc];
+	}
+	sketch->num_sparse = idst;
+}
+
+static void
+_hyperloglog_densify(hyperloglog_t* sketch) {
+	size_t ientry;
+	sketch->dense = memory_allocate(0, HYPERLOGLOG_REGISTERS(sketch), 16,
+	                                MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	for (ientry = 0; ientry < sketch->num_sparse; ++ientry) {
+		uint32_t entry = sketch->sparse[ientry];
+		uint8_t rank = (uint8_t)(entry & 0xFF);
+		uint8_t* reg = sketch->dense + (entry >> 8);
+		if (*reg < rank)
+			*reg = rank;
+	}
+	memory_deallocate(sketch->sparse);
+	sketch->sparse = 0;
+	sketch->num_sparse = 0;
+	sketch->sparse_capacity = 0;
+}
+
+static void
+_hyperloglog_set(hyperloglog_t* sketch, size_t index, uint8_t rank) {
+	if (sketch->dense) {
+		if (sketch->dense[index] < rank)
+			sketch->dense[index] = rank;
+		return;
+	}
+
+	if (sketch->num_sparse == sketch->sparse_capacity) {
+		_hyperloglog_compact(sketch);
+		//Grow while the list is mostly distinct registers, switch to dense at the limit
+		if (sketch->num_sparse >= sketch->sparse_capacity / 2) {
+			if (sketch->sparse_capacity * 2 > _hyperloglog_max_sparse(sketch)) {
+				_hyperloglog_densify(sketch);
+				_hyperloglog_set(sketch, index, rank);
+				return;
+			}
+			sketch->sparse = memory_reallocate(sketch->sparse, sizeof(uint32_t) * sketch->sparse_capacity * 2,
+			                                   0, sizeof(uint32_t) * sketch->sparse_capacity);
+			sketch->sparse_capacity *= 2;
+		}
+	}
+	sketch->sparse[sketch->num_sparse++] = HYPERLOGLOG_ENTRY(index, rank);
+}
+
+static void
+_hyperloglog_merge_dense(uint8_t* FOUNDATION_RESTRICT dst, const uint8_t* FOUNDATION_RESTRICT src,
+                         size_t count) {
+	size_t ireg = 0;
+#if FOUNDATION_ARCH_SSE2
+	for (; ireg < count; ireg += 16) {
+		__m128i reg = _mm_max_epu8(_mm_load_si128((const __m128i*)(dst + ireg)),
+		                           _mm_load_si128((const __m128i*)(src + ireg)));
+		_mm_store_si128((__m128i*)(dst + ireg), reg);
+	}
+#elif FOUNDATION_ARCH_NEON
+	for (; ireg < count; ireg += 16)
+		vst1q_u8(dst + ireg, vmaxq_u8(vld1q_u8(dst + ireg), vld1q_u8(src + ireg)));
+#endif
+	for (; ireg < count; ++ireg) {
+		if (dst[ireg] < src[ireg])
+			dst[ireg] = src[ireg];
+	}
+}
+
+hyperloglog_t*
+hyperloglog_allocate(unsigned int precision) {
+	hyperloglog_t* sketch = memory_allocate(0, sizeof(hyperloglog_t), 0, MEMORY_PERSISTENT);
+	hyperloglog_initialize(sketch, precision);
+	return sketch;
+}
+
+void
+hyperloglog_deallocate(hyperloglog_t* sketch) {
+	hyperloglog_finalize(sketch);
+	memory_deallocate(sketch);
+}
+
+void
+hyperloglog_initialize(hyperloglog_t* sketch, unsigned int precision) {
+	memset(sketch, 0, sizeof(hyperloglog_t));
+	if (precision < HYPERLOGLOG_MIN_PRECISION)
+		precision = HYPERLOGLOG_MIN_PRECISION;
+	else if (precision > HYPERLOGLOG_MAX_PRECISION)
+		precision = HYPERLOGLOG_MAX_PRECISION;
+	sketch->precision = precision;
+	hyperloglog_clear(sketch);
+}
+
+void
+hyperloglog_finalize(hyperloglog_t* sketch) {
+	memory_deallocate(sketch->sparse);
+	memory_deallocate(sketch->dense);
+	memset(sketch, 0, sizeof(hyperloglog_t));
+}
+
+void
+hyperloglog_add(hyperloglog_t* sketch, const void* key, size_t length) {
+	hyperloglog_add_hash(sketch, hash(key, length));
+}
+
+void
+hyperloglog_add_hash(hyperloglog_t* sketch, hash_t key) {
+	//Register index from the high bits, value is the position of the lowest set bit
+	//in the remaining bits, bounded by a sentinel bit
+	size_t index = (size_t)(key >> (64 - sketch->precision));
+	uint8_t rank = (uint8_t)(bits_ctz64(key | (1ULL << (64 - sketch->precision))) + 1);
+	_hyperloglog_set(sketch, index, rank);
+}
+
+uint64_t
+hyperloglog_estimate(hyperloglog_t* sketch) {
+	size_t histogram[66];
+	size_t num_registers = HYPERLOGLOG_REGISTERS(sketch);
+	real m = (real)num_registers;
+	real alpha, sum = 0, scale = 1, estimate;
+	size_t ireg;
+
+	memset(histogram, 0, sizeof(histogram));
+	if (sketch->dense) {
+		for (ireg = 0; ireg < num_registers; ++ireg)
+			++histogram[sketch->dense[ireg]];
+	}
+	else {
+		_hyperloglog_compact(sketch);
+		histogram[0] = num_registers - sketch->num_sparse;
+		for (ireg = 0; ireg < sketch->num_sparse; ++ireg)
+			++histogram[sketch->sparse[ireg] & 0xFF];
+	}
+
+	for (ireg = 0; ireg < 66; ++ireg, scale *= REAL_C(0.5))
+		sum += (real)histogram[ireg] * scale;
+
+	if (num_registers == 16)
+		alpha = REAL_C(0.673);
+	else if (num_registers == 32)
+		alpha = REAL_C(0.697);
+	else if (num_registers == 64)
+		alpha = REAL_C(0.709);
+	else
+		alpha = REAL_C(0.7213) / (REAL_C(1.0) + (REAL_C(1.079) / m));
+
+	estimate = (alpha * m * m) / sum;
+	//Linear counting is more accurate while there are empty registers in the low range
+	if ((estimate <= REAL_C(2.5) * m) && histogram[0])
+		estimate = m * math_logn(m / (real)histogram[0]);
+
+	return (uint64_t)(estimate + REAL_C(0.5));
+}
+
+bool
+hyperloglog_merge(hyperloglog_t* sketch, const hyperloglog_t* other) {
+	size_t ientry;
+
+	if (sketch->precision != other->precision)
+		return false;
+
+	if (other->dense) {
+		if (!sketch->dense)
+			_hyperloglog_densify(sketch);
+		_hyperloglog_merge_dense(sketch->dense, other->dense, HYPERLOGLOG_REGISTERS(sketch));
+		return true;
+	}
+
+	for (ientry = 0; ientry < other->num_sparse; ++ientry) {
+		uint32_t entry = other->sparse[ientry];
+		_hyperloglog_set(sketch, entry >> 8, (uint8_t)(entry & 0xFF));
+	}
+	return true;
+}
+
+bool
+hyperloglog_is_dense(const hyperloglog_t* sketch) {
+	return sketch->dense != 0;
+}
+
+void
+hyperloglog_clear(hyperloglog_t* sketch) {
+	memory_deallocate(sketch->sparse);
+	memory_deallocate(sketch->dense);
+	sketch->sparse = 0;
+	sketch->dense = 0;
+	sketch->num_sparse = 0;
+	sketch->sparse_capacity = 0;
+
+	if (_hyperloglog_max_sparse(sketch) < HYPERLOGLOG_MIN_SPARSE) {
+		sketch->dense = memory_allocate(0, HYPERLOGLOG_REGISTERS(sketch), 16,
+		                                MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	}
+	else {
+		sketch->sparse_capacity = HYPERLOGLOG_MIN_SPARSE;
+		sketch->sparse = memory_allocate(0, sizeof(uint32_t) * sketch->sparse_capacity, 0,
+		                                 MEMORY_PERSISTENT);
+	}
+}
+
+void
+hyperloglog_write(hyperloglog_t* sketch, stream_t* stream) {
+	size_t ientry;
+
+	if (!sketch->dense)
+		_hyperloglog_compact(sketch);
+
+	stream_write_uint32(stream, HYPERLOGLOG_MAGIC);
+	stream_write_separator(stream);
+	stream_write_uint8(stream, (uint8_t)sketch->precision);
+	stream_write_separator(stream);
+	stream_write_bool(stream, sketch->dense != 0);
+	stream_write_separator(stream);
+
+	if (sketch->dense) {
+		size_t num_registers = HYPERLOGLOG_REGISTERS(sketch);
+		if (stream_is_binary(stream)) {
+			stream_write(stream, sketch->dense, num_registers);
+		}
+		else {
+			for (ientry = 0; ientry < num_registers; ++ientry) {
+				stream_write_uint8(stream, sketch->dense[ientry]);
+				stream_write_separator(stream);
+			}
+		}
+	}
+	else {
+		stream_write_uint64(stream, sketch->num_sparse);
+		stream_write_separator(stream);
+		for (ientry = 0; ientry < sketch->num_sparse; ++ientry) {
+			stream_write_uint32(stream, sketch->sparse[ientry]);
+			stream_write_separator(stream);
+		}
+	}
+}
+
+bool
+hyperloglog_read(hyperloglog_t* sketch, stream_t* stream) {
+	unsigned int precision;
+	size_t ientry;
+	uint8_t max_rank;
+	bool dense;
+
+	memset(sketch, 0, sizeof(hyperloglog_t));
+	if (stream_read_uint32(stream) != HYPERLOGLOG_MAGIC) {
+		log_error(0, ERROR_INVALID_VALUE, STRING_CONST("Invalid HyperLogLog data in stream"));
+		return false;
+	}
+	precision = stream_read_uint8(stream);
+	if ((precision < HYPERLOGLOG_MIN_PRECISION) || (precision > HYPERLOGLOG_MAX_PRECISION)) {
+		log_errorf(0, ERROR_INVALID_VALUE, STRING_CONST("Invalid HyperLogLog precision in stream: %u"),
+		           precision);
+		return false;
+	}
+	dense = stream_read_bool(stream);
+	//Rank is bounded by the sentinel bit set in hyperloglog_add_hash
+	max_rank = (uint8_t)(64 - precision + 1);
+
+	hyperloglog_initialize(sketch, precision);
+	if (dense) {
+		size_t num_registers = HYPERLOGLOG_REGISTERS(sketch);
+		if (!sketch->dense)
+			_hyperloglog_densify(sketch);
+		if (stream_is_binary(stream)) {
+			if (stream_read(stream, sketch->dense, num_registers) != num_registers)
+				goto truncated;
+		}
+		else {
+			for (ientry = 0; ientry < num_registers; ++ientry) {
+				if (stream_eos(stream))
+					goto truncated;
+				sketch->dense[ientry] = stream_read_uint8(stream);
+			}
+		}
+		for (ientry = 0; ientry < num_registers; ++ientry) {
+			if (sketch->dense[ientry] > max_rank)
+				goto invalid;
+		}
+	}
+	else {
+		uint64_t num_sparse = stream_read_uint64(stream);
+		if (num_sparse > _hyperloglog_max_sparse(sketch)) {
+			log_error(0, ERROR_INVALID_VALUE, STRING_CONST("Invalid HyperLogLog sparse size in stream"));
+			hyperloglog_finalize(sketch);
+			return false;
+		}
+		for (ientry = 0; ientry < num_sparse; ++ientry) {
+			uint32_t entry;
+			if (stream_eos(stream))
+				goto truncated;
+			entry = stream_read_uint32(stream);
+			if ((entry >> 8) >= HYPERLOGLOG_REGISTERS(sketch))
+				goto truncated;
+			if ((entry & 0xFF) > max_rank)
+				goto invalid;
+			_hyperloglog_set(sketch, entry >> 8, (uint8_t)(entry & 0xFF));
+		}
+	}
+	return true;
+
+truncated:
+	log_error(0, ERROR_INVALID_VALUE, STRING_CONST("Truncated HyperLogLog data in stream"));
+	hyperloglog_finalize(sketch);
+	return false;
+
+invalid:
+	log_error(0, ERROR_INVALID_VALUE, STRING_CONST("Invalid HyperLogLog register in stream"));
+	hyperloglog_finalize(sketch);
+	return false;
+}
+
+static FOUNDATION_FORCEINLINE size_t
+_countmin_column(const countmin_t* sketch, hash_t key, size_t row) {
+	//Row hashes derived from two halves of the key hash, mapped to the row width
+	//with a multiply instead of a division
+	uint32_t h = (uint32_t)key + ((uint32_t)row * ((uint32_t)(key >> 32) | 1));
+	return (size_t)(((uint64_t)h * (uint64_t)sketch->width) >> 32);
+}
+
+countmin_t*
+countmin_allocate(size_t width, size_t depth) {
+	countmin_t* sketch = memory_allocate(0, sizeof(countmin_t), 0, MEMORY_PERSISTENT);
+	countmin_initialize(sketch, width, depth);
+	return sketch;
+}
+
+void
+countmin_deallocate(countmin_t* sketch) {
+	countmin_finalize(sketch);
+	memory_deallocate(sketch);
+}
+
+void
+countmin_initialize(countmin_t* sketch, size_t width, size_t depth) {
+	FOUNDATION_ASSERT_MSG(width <= 0xFFFFFFFFULL, "Count-min sketch too wide");
+	sketch->width = width ? width : 1;
+	sketch->depth = depth ? depth : 1;
+	sketch->total = 0;
+	sketch->counter = memory_allocate(0, sizeof(uint64_t) * sketch->width * sketch->depth, 16,
+	                                  MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+}
+
+void
+countmin_finalize(countmin_t* sketch) {
+	memory_deallocate(sketch->counter);
+	memset(sketch, 0, sizeof(countmin_t));
+}
+
+void
+countmin_add(countmin_t* sketch, const void* key, size_t length, uint64_t count) {
+	countmin_add_hash(sketch, hash(key, length), count);
+}
+
+void
+countmin_add_hash(countmin_t* sketch, hash_t key, uint64_t count) {
+	uint64_t* row = sketch->counter;
+	size_t irow;
+	for (irow = 0; irow < sketch->depth; ++irow, row += sketch->width)
+		row[_countmin_column(sketch, key, irow)] += count;
+	sketch->total += count;
+}
+
+uint64_t
+countmin_estimate(const countmin_t* sketch, const void* key, size_t length) {
+	return countmin_estimate_hash(sketch, hash(key, length));
+}
+
+uint64_t
+countmin_estimate_hash(const countmin_t* sketch, hash_t key) {
+	const uint64_t* row = sketch->counter;
+	uint64_t estimate = (uint64_t)-1;
+	size_t irow;
+	for (irow = 0; irow < sketch->depth; ++irow, row += sketch->width) {
+		uint64_t count = row[_countmin_column(sketch, key, irow)];
+		if (count < estimate)
+			estimate = count;
+	}
+	return estimate;
+}
+
+uint64_t
+countmin_total(const countmin_t* sketch) {
+	return sketch->total;
+}
+
+bool
+countmin_merge(countmin_t* sketch, const countmin_t* other) {
+	size_t icounter = 0;
+	size_t num_counters = sketch->width * sketch->depth;
+	uint64_t* FOUNDATION_RESTRICT dst = sketch->counter;
+	const uint64_t* FOUNDATION_RESTRICT src = other->counter;
+
+	if ((sketch->width != other->width) || (sketch->depth != other->depth))
+		return false;
+
+#if FOUNDATION_ARCH_SSE2
+	for (; icounter + 2 <= num_counters; icounter += 2) {
+		__m128i sum = _mm_add_epi64(_mm_load_si128((const __m128i*)(dst + icounter)),
+		                            _mm_load_si128((const __m128i*)(src + icounter)));
+		_mm_store_si128((__m128i*)(dst + icounter), sum);
+	}
+#elif FOUNDATION_ARCH_NEON
+	for (; icounter + 2 <= num_counters; icounter += 2)
+		vst1q_u64(dst + icounter, vaddq_u64(vld1q_u64(dst + icounter), vld1q_u64(src + icounter)));
+#endif
+	for (; icounter < num_counters; ++icounter)
+		dst[icounter] += src[icounter];
+
+	sketch->total += other->total;
+	return true;
+}
+
+void
+countmin_clear(countmin_t* sketch) {
+	memset(sketch->counter, 0, sizeof(uint64_t) * sketch->width * sketch->depth);
+	sketch->total = 0;
+}
+
+void
+countmin_write(const countmin_t* sketch, stream_t* stream) {
+	size_t icounter;
+	size_t num_counters = sketch->width * sketch->depth;
+
+	stream_write_uint32(stream, COUNTMIN_MAGIC);
+	stream_write_separator(stream);
+	stream_write_uint64(stream, sketch->width);
+	stream_write_separator(stream);
+	stream_write_uint64(stream, sketch->depth);
+	stream_write_separator(stream);
+	stream_write_uint64(stream, sketch->total);
+	stream_write_separator(stream);
+
+	if (stream_is_binary(stream) && !stream_is_swapped(stream)) {
+		stream_write(stream, sketch->counter, sizeof(uint64_t) * num_counters);
+		return;
+	}
+	for (icounter = 0; icounter < num_counters; ++icounter) {
+		stream_write_uint64(stream, sketch->counter[icounter]);
+		stream_write_separator(stream);
+	}
+}
+
+bool
+countmin_read(countmin_t* sketch, stream_t* stream) {
+	uint64_t width, depth, total;
+	size_t icounter, num_counters;
+
+	memset(sketch, 0, sizeof(countmin_t));
+	if (stream_read_uint32(stream) != COUNTMIN_MAGIC) {
+		log_error(0, ERROR_INVALID_VALUE, STRING_CONST("Invalid count-min sketch data in stream"));
+		return false;
+	}
+	width = stream_read_uint64(stream);
+	depth = stream_read_uint64(stream);
+	total = stream_read_uint64(stream);
+	if (!width || !depth || (width > 0xFFFFFFFFULL) || (depth > 0xFFFF)) {
+		log_errorf(0, ERROR_INVALID_VALUE,
+		           STRING_CONST("Invalid count-min sketch size in stream: %" PRIu64 "x%" PRIu64), width, depth);
+		return false;
+	}
+
+	countmin_initialize(sketch, (size_t)width, (size_t)depth);
+	sketch->total = total;
+	num_counters = sketch->width * sketch->depth;
+	if (stream_is_binary(stream) && !stream_is_swapped(stream)) {
+		if (stream_read(stream, sketch->counter, sizeof(uint64_t) * num_counters) == sizeof(uint64_t) * num_counters)
+			return true;
+	}
+	else {
+		for (icounter = 0; (icounter < num_counters) && !stream_eos(stream); ++icounter)
+			sketch->counter[icounter] = stream_read_uint64(stream);
+		if (icounter == num_counters)
+			return true;
+	}
+
+	log_error(0, ERROR_INVALID_VALUE, STRING_CONST("Truncated count-min sketch data in stream"));
+	countmin_finalize(sketch);
+	return false;
+}
@@ -0,0 +1,194 @@
+/* sketch.h  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#pragma once
+
+/*! \file sketch.h
+\brief Streaming statistics sketches
+
+Fixed size sketches estimating statistics of unbounded key streams, using keys hashed
+with #hash. HyperLogLog estimates the number of distinct keys and count-min estimates
+the frequency of individual keys. Sketches of the same dimensions can be merged, so
+each thread can update a local sketch which are combined when the statistics are
+needed. Sketches can be written to and read from streams. Access is not atomic and
+therefor not thread safe. */
+
+#include <foundation/platform.h>
+#include <foundation/types.h>
+
+/*! Allocate a HyperLogLog sketch. The sketch should be deallocated with a call to
+#hyperloglog_deallocate
+\param precision Number of hash bits used as register index, in range [4,18]. The
+                 standard error is 1.04/sqrt(2^precision) and the dense size 2^precision bytes
+\return New sketch */
+FOUNDATION_API hyperloglog_t*
+hyperloglog_allocate(unsigned int precision);
+
+/*! Deallocate a HyperLogLog sketch previously allocated with #hyperloglog_allocate
+\param sketch Sketch */
+FOUNDATION_API void
+hyperloglog_deallocate(hyperloglog_t* sketch);
+
+/*! Initialize a HyperLogLog sketch. The sketch should be finalized with a call to
+#hyperloglog_finalize
+\param sketch Sketch
+\param precision Number of hash bits used as register index, in range [4,18] */
+FOUNDATION_API void
+hyperloglog_initialize(hyperloglog_t* sketch, unsigned int precision);
+
+/*! Finalize a HyperLogLog sketch previously initialized with #hyperloglog_initialize
+\param sketch Sketch */
+FOUNDATION_API void
+hyperloglog_finalize(hyperloglog_t* sketch);
+
+/*! Add a key to the HyperLogLog sketch
+\param sketch Sketch
+\param key Key
+\param length Length of key */
+FOUNDATION_API void
+hyperloglog_add(hyperloglog_t* sketch, const void* key, size_t length);
+
+/*! Add a key hash to the HyperLogLog sketch
+\param sketch Sketch
+\param key Hash of key as given by #hash */
+FOUNDATION_API void
+hyperloglog_add_hash(hyperloglog_t* sketch, hash_t key);
+
+/*! Estimate the number of distinct keys added to the HyperLogLog sketch
+\param sketch Sketch
+\return Estimated number of distinct keys */
+FOUNDATION_API uint64_t
+hyperloglog_estimate(hyperloglog_t* sketch);
+
+/*! Merge a HyperLogLog sketch into another, the result estimating the number of distinct
+keys added to either sketch
+\param sketch Sketch to merge into
+\param other Sketch to merge from, must have the same precision
+\return true if merged, false if precision differs */
+FOUNDATION_API bool
+hyperloglog_merge(hyperloglog_t* sketch, const hyperloglog_t* other);
+
+/*! Query if the HyperLogLog sketch is in the dense representation
+\param sketch Sketch
+\return true if dense, false if sparse */
+FOUNDATION_API bool
+hyperloglog_is_dense(const hyperloglog_t* sketch);
+
+/*! Clear the HyperLogLog sketch, resetting it to the sparse representation
+\param sketch Sketch */
+FOUNDATION_API void
+hyperloglog_clear(hyperloglog_t* sketch);
+
+/*! Write the HyperLogLog sketch to a stream
+\param sketch Sketch
+\param stream Stream */
+FOUNDATION_API void
+hyperloglog_write(hyperloglog_t* sketch, stream_t* stream);
+
+/*! Initialize a HyperLogLog sketch from data previously written to a stream with
+#hyperloglog_write. On success the sketch should be finalized with a call to
+#hyperloglog_finalize
+\param sketch Sketch
+\param stream Stream
+\return true if sketch was read, false if stream data was invalid */
+FOUNDATION_API bool
+hyperloglog_read(hyperloglog_t* sketch, stream_t* stream);
+
+/*! Allocate a count-min sketch. Estimates exceed the true count by at most
+2.72/width of the total count with probability 1-exp(-depth). The sketch should be
+deallocated with a call to #countmin_deallocate
+\param width Number of counters per row
+\param depth Number of rows
+\return New sketch */
+FOUNDATION_API countmin_t*
+countmin_allocate(size_t width, size_t depth);
+
+/*! Deallocate a count-min sketch previously allocated with #countmin_allocate
+\param sketch Sketch */
+FOUNDATION_API void
+countmin_deallocate(countmin_t* sketch);
+
+/*! Initialize a count-min sketch. The sketch should be finalized with a call to
+#countmin_finalize
+\param sketch Sketch
+\param width Number of counters per row
+\param depth Number of rows */
+FOUNDATION_API void
+countmin_initialize(countmin_t* sketch, size_t width, size_t depth);
+
+/*! Finalize a count-min sketch previously initialized with #countmin_initialize
+\param sketch Sketch */
+FOUNDATION_API void
+countmin_finalize(countmin_t* sketch);
+
+/*! Add a count for a key to the count-min sketch
+\param sketch Sketch
+\param key Key
+\param length Length of key
+\param count Count to add */
+FOUNDATION_API void
+countmin_add(countmin_t* sketch, const void* key, size_t length, uint64_t count);
+
+/*! Add a count for a key hash to the count-min sketch
+\param sketch Sketch
+\param key Hash of key as given by #hash
+\param count Count to add */
+FOUNDATION_API void
+countmin_add_hash(countmin_t* sketch, hash_t key, uint64_t count);
+
+/*! Estimate the count for a key. The estimate is never lower than the true count.
+\param sketch Sketch
+\param key Key
+\param length Length of key
+\return Estimated count */
+FOUNDATION_API uint64_t
+countmin_estimate(const countmin_t* sketch, const void* key, size_t length);
+
+/*! Estimate the count for a key hash. The estimate is never lower than the true count.
+\param sketch Sketch
+\param key Hash of key as given by #hash
+\return Estimated count */
+FOUNDATION_API uint64_t
+countmin_estimate_hash(const countmin_t* sketch, hash_t key);
+
+/*! Get the sum of all counts added to the count-min sketch
+\param sketch Sketch
+\return Total count */
+FOUNDATION_API uint64_t
+countmin_total(const countmin_t* sketch);
+
+/*! Merge a count-min sketch into another, adding all counters
+\param sketch Sketch to merge into
+\param other Sketch to merge from, must have the same width and depth
+\return true if merged, false if dimensions differ */
+FOUNDATION_API bool
+countmin_merge(countmin_t* sketch, const countmin_t* other);
+
+/*! Clear all counters in the count-min sketch
+\param sketch Sketch */
+FOUNDATION_API void
+countmin_clear(countmin_t* sketch);
+
+/*! Write the count-min sketch to a stream
+\param sketch Sketch
+\param stream Stream */
+FOUNDATION_API void
+countmin_write(const countmin_t* sketch, stream_t* stream);
+
+/*! Initialize a count-min sketch from data previously written to a stream with
+#countmin_write. On success the sketch should be finalized with a call to
+#countmin_finalize
+\param sketch Sketch
+\param stream Stream
+\return true if sketch was read, false if stream data was invalid */
+FOUNDATION_API bool
+countmin_read(countmin_t* sketch, stream_t* stream);
@@ -0,0 +1,441 @@
+/* skiplist.c  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+#include <foundation/internal.h>
+
+//Number of retired nodes triggering a reclamation attempt when leaving an operation
+#define SKIPLIST_RECLAIM_THRESHOLD 64
+#define SKIPLIST_SLAB_NODES        64
+
+#define SKIPLIST_MARK(ptr)         ((void*)((uintptr_t)(ptr) | (uintptr_t)1))
+#define SKIPLIST_IS_MARKED(ptr)    (((uintptr_t)(ptr) & (uintptr_t)1) != 0)
+#define SKIPLIST_POINTER(ptr)      ((skiplist_node_t*)((uintptr_t)(ptr) & ~(uintptr_t)1))
+
+static void
+_skiplist_node_initialize(skiplist_node_t* node, uint64_t key, uint64_t value, uint32_t height) {
+	uint32_t ilevel;
+	node->key = key;
+	atomic_store64(&node->value, (int64_t)value);
+	atomic_store32(&node->ref, 2);
+	node->height = height;
+	node->retired = nullptr;
+	for (ilevel = 0; ilevel < height; ++ilevel)
+		atomic_store_ptr(&node->next[ilevel], nullptr);
+}
+
+static void
+_skiplist_node_free(skiplist_t* list, skiplist_node_t* first, skiplist_node_t* last) {
+	atomicptr_t* free = &list->free[first->height - 1];
+	void* head;
+	do {
+		head = atomic_load_ptr(free);
+		last->retired = head;
+	} while (!atomic_cas_ptr(free, first, head));
+}
+
+static skiplist_node_t*
+_skiplist_node_allocate(skiplist_t* list, uint64_t key, uint64_t value, uint32_t height) {
+	//Popping is safe from ABA since the caller is inside an epoch, so a node popped by
+	//another thread cannot be erased, reclaimed and pushed back before this pop completes
+	atomicptr_t* free = &list->free[height - 1];
+	skiplist_node_t* node;
+	do {
+		node = atomic_load_ptr(free);
+	} while (node && !atomic_cas_ptr(free, node->retired, node));
+
+	if (!node) {
+		size_t stride = (sizeof(skiplist_node_t) + (sizeof(atomicptr_t) * height) + 15) & ~(size_t)15;
+		char* slab = memory_allocate(0, 16 + (stride * SKIPLIST_SLAB_NODES), 16, MEMORY_PERSISTENT);
+		skiplist_node_t* first = (skiplist_node_t*)(void*)(slab + 16 + stride);
+		skiplist_node_t* last = first;
+		size_t inode;
+		void* head;
+		do {
+			head = atomic_load_ptr(&list->slab);
+			*(void**)slab = head;
+		} while (!atomic_cas_ptr(&list->slab, slab, head));
+		//First node is used, the rest are linked and pushed to the free list
+		first->height = height;
+		for (inode = 2; inode < SKIPLIST_SLAB_NODES; ++inode) {
+			last->retired = (skiplist_node_t*)(void*)(slab + 16 + (stride * inode));
+			last = last->retired;
+			last->height = height;
+		}
+		_skiplist_node_free(list, first, last);
+		node = (skiplist_node_t*)(void*)(slab + 16);
+	}
+
+	_skiplist_node_initialize(node, key, value, height);
+	return node;
+}
+
+static uint32_t
+_skiplist_random_height(void) {
+	//Each level is kept with probability 1/4, two random bits per level
+	return 1 + (bits_ctz64(random32() | (1U << ((SKIPLIST_MAX_HEIGHT - 1) * 2))) / 2);
+}
+
+static bool
+_skiplist_reclaim_epoch(skiplist_t* list) {
+	skiplist_node_t* node;
+	int32_t epoch, previous;
+	bool advanced = false;
+
+	if (!atomic_cas32(&list->reclaim, 1, 0))
+		return false;
+
+	//Nodes retired in the previous epoch are unreachable once no operation started in
+	//that epoch is still running, since operations in the current epoch started after
+	//the nodes were unlinked. They are then returned to the free lists
+	epoch = atomic_load32(&list->epoch);
+	previous = (epoch + 1) & 1;
+	if (_epoch_drained(list->reader, previous)) {
+		do {
+			node = atomic_load_ptr(&list->retired[previous]);
+		} while (!atomic_cas_ptr(&list->retired[previous], nullptr, node));
+		atomic_incr32(&list->epoch);
+		advanced = true;
+		while (node) {
+			skiplist_node_t* next = node->retired;
+			_skiplist_node_free(list, node, node);
+			atomic_decr32(&list->num_retired);
+			node = next;
+		}
+	}
+
+	atomic_store32(&list->reclaim, 0);
+	return advanced;
+}
+
+static void
+_skiplist_leave(skiplist_t* list, epoch_reader_t* reader, int32_t epoch) {
+	_epoch_leave(reader, epoch);
+	if (atomic_load32(&list->num_retired) >= SKIPLIST_RECLAIM_THRESHOLD)
+		_skiplist_reclaim_epoch(list);
+}
+
+static void
+_skiplist_retire(skiplist_t* list, skiplist_node_t* node) {
+	atomicptr_t* retired = &list->retired[atomic_load32(&list->epoch) & 1];
+	void* head;
+	do {
+		head = atomic_load_ptr(retired);
+		node->retired = head;
+	} while (!atomic_cas_ptr(retired, node, head));
+	atomic_incr32(&list->num_retired);
+}
+
+static void
+_skiplist_release(skiplist_t* list, skiplist_node_t* node) {
+	//Last of the list and the inserting thread to release the node retires it, at which
+	//point it has been marked and unlinked from all levels
+	if (!atomic_decr32(&node->ref))
+		_skiplist_retire(list, node);
+}
+
+static bool
+_skiplist_find(skiplist_t* list, uint64_t key, skiplist_node_t** pred, skiplist_node_t** succ) {
+	skiplist_node_t* prev;
+	skiplist_node_t* curr;
+	void* next;
+	int ilevel;
+
+retry:
+	prev = list->head;
+	for (ilevel = SKIPLIST_MAX_HEIGHT - 1; ilevel >= 0; --ilevel) {
+		curr = SKIPLIST_POINTER(atomic_load_ptr(&prev->next[ilevel]));
+		while (curr) {
+			next = atomic_load_ptr(&curr->next[ilevel]);
+			if (SKIPLIST_IS_MARKED(next)) {
+				//Snip erased node, restarting if the predecessor changed or was erased
+				if (!atomic_cas_ptr(&prev->next[ilevel], SKIPLIST_POINTER(next), curr))
+					goto retry;
+				curr = SKIPLIST_POINTER(next);
+				continue;
+			}
+			if (curr->key >= key)
+				break;
+			prev = curr;
+			curr = next;
+		}
+		pred[ilevel] = prev;
+		succ[ilevel] = curr;
+	}
+	return succ[0] && (succ[0]->key == key);
+}
+
+static void
+_skiplist_unlink(skiplist_t* list, uint64_t key) {
+	//Snip all marked nodes with the given key on every level. Unlike find this walks past
+	//a live node with equal key, since an erased node with the same key may still be
+	//linked behind it on upper levels
+	skiplist_node_t* prev;
+	skiplist_node_t* curr;
+	void* next;
+	int ilevel;
+
+retry:
+	prev = list->head;
+	for (ilevel = SKIPLIST_MAX_HEIGHT - 1; ilevel >= 0; --ilevel) {
+		skiplist_node_t* level_prev = prev;
+		curr = SKIPLIST_POINTER(atomic_load_ptr(&prev->next[ilevel]));
+		while (curr) {
+			next = atomic_load_ptr(&curr->next[ilevel]);
+			if (SKIPLIST_IS_MARKED(next)) {
+				if (!atomic_cas_ptr(&prev->next[ilevel], SKIPLIST_POINTER(next), curr))
+					goto retry;
+				curr = SKIPLIST_POINTER(next);
+				continue;
+			}
+			if (curr->key > key)
+				break;
+			if (curr->key < key)
+				level_prev = curr;
+			prev = curr;
+			curr = next;
+		}
+		//Descend from the last node before the key
+		prev = level_prev;
+	}
+}
+
+static skiplist_node_t*
+_skiplist_lower_bound(skiplist_t* list, uint64_t key) {
+	//Read only search, erased nodes are stepped over through their frozen next pointer
+	//instead of being snipped, so a lookup never writes and never restarts
+	skiplist_node_t* prev = list->head;
+	skiplist_node_t* curr = nullptr;
+	void* next;
+	int ilevel;
+
+	for (ilevel = SKIPLIST_MAX_HEIGHT - 1; ilevel >= 0; --ilevel) {
+		curr = SKIPLIST_POINTER(atomic_load_ptr(&prev->next[ilevel]));
+		while (curr) {
+			next = atomic_load_ptr(&curr->next[ilevel]);
+			if (!SKIPLIST_IS_MARKED(next)) {
+				if (curr->key >= key)
+					break;
+				prev = curr;
+			}
+			curr = SKIPLIST_POINTER(next);
+		}
+	}
+	return curr;
+}
+
+skiplist_t*
+skiplist_allocate(void) {
+	skiplist_t* list = memory_allocate(0, sizeof(skiplist_t), 0, MEMORY_PERSISTENT);
+	skiplist_initialize(list);
+	return list;
+}
+
+void
+skiplist_deallocate(skiplist_t* list) {
+	if (!list)
+		return;
+	skiplist_finalize(list);
+	memory_deallocate(list);
+}
+
+void
+skiplist_initialize(skiplist_t* list) {
+	unsigned int ilevel;
+	list->head = memory_allocate(0, sizeof(skiplist_node_t) + (sizeof(atomicptr_t) * SKIPLIST_MAX_HEIGHT), 0,
+	                             MEMORY_PERSISTENT);
+	_skiplist_node_initialize(list->head, 0, 0, SKIPLIST_MAX_HEIGHT);
+	atomic_store64(&list->size, 0);
+	atomic_store32(&list->epoch, 0);
+	atomic_store32(&list->reclaim, 0);
+	atomic_store32(&list->num_retired, 0);
+	atomic_store_ptr(&list->retired[0], nullptr);
+	atomic_store_ptr(&list->retired[1], nullptr);
+	for (ilevel = 0; ilevel < SKIPLIST_MAX_HEIGHT; ++ilevel)
+		atomic_store_ptr(&list->free[ilevel], nullptr);
+	atomic_store_ptr(&list->slab, nullptr);
+	_epoch_initialize(list->reader);
+}
+
+void
+skiplist_finalize(skiplist_t* list) {
+	unsigned int ilevel;
+	void* slab;
+
+	if (!list->head)
+		return;
+
+	//All nodes, linked, retired or free, are owned by the slabs
+	slab = atomic_load_ptr(&list->slab);
+	while (slab) {
+		void* next = *(void**)slab;
+		memory_deallocate(slab);
+		slab = next;
+	}
+	atomic_store_ptr(&list->slab, nullptr);
+	atomic_store_ptr(&list->retired[0], nullptr);
+	atomic_store_ptr(&list->retired[1], nullptr);
+	for (ilevel = 0; ilevel < SKIPLIST_MAX_HEIGHT; ++ilevel)
+		atomic_store_ptr(&list->free[ilevel], nullptr);
+	memory_deallocate(list->head);
+	list->head = nullptr;
+	atomic_store64(&list->size, 0);
+	atomic_store32(&list->num_retired, 0);
+}
+
+bool
+skiplist_insert(skiplist_t* list, uint64_t key, uint64_t value) {
+	skiplist_node_t* pred[SKIPLIST_MAX_HEIGHT];
+	skiplist_node_t* succ[SKIPLIST_MAX_HEIGHT];
+	epoch_reader_t* reader = _epoch_reader(list->reader);
+	int32_t epoch = _epoch_enter(&list->epoch, reader);
+	skiplist_node_t* node = nullptr;
+	uint32_t height = 0;
+	uint32_t ilevel;
+
+	while (true) {
+		if (_skiplist_find(list, key, pred, succ)) {
+			atomic_store64(&succ[0]->value, (int64_t)value);
+			//Unused node may have been popped from the free list, so must pass an epoch
+			if (node)
+				_skiplist_retire(list, node);
+			_skiplist_leave(list, reader, epoch);
+			return false;
+		}
+		if (!node) {
+			height = _skiplist_random_height();
+			node = _skiplist_node_allocate(list, key, value, height);
+		}
+		for (ilevel = 0; ilevel < height; ++ilevel)
+			atomic_store_ptr(&node->next[ilevel], succ[ilevel]);
+		if (atomic_cas_ptr(&pred[0]->next[0], node, succ[0]))
+			break;
+	}
+	atomic_add64(&list->size, 1);
+
+	for (ilevel = 1; ilevel < height; ++ilevel) {
+		while (true) {
+			void* next = atomic_load_ptr(&node->next[ilevel]);
+			//Stop linking if the node was erased, the successor is then frozen
+			if (SKIPLIST_IS_MARKED(next))
+				goto linked;
+			if ((next != succ[ilevel]) && !atomic_cas_ptr(&node->next[ilevel], succ[ilevel], next))
+				goto linked;
+			if (atomic_cas_ptr(&pred[ilevel]->next[ilevel], node, succ[ilevel]))
+				break;
+			if (!_skiplist_find(list, key, pred, succ) || (succ[0] != node))
+				goto linked;
+		}
+	}
+
+linked:
+	//An erase racing with linking of the upper levels may have missed a level linked
+	//after it snipped the node
+	if (SKIPLIST_IS_MARKED(atomic_load_ptr(&node->next[0])))
+		_skiplist_unlink(list, key);
+	_skiplist_release(list, node);
+	_skiplist_leave(list, reader, epoch);
+	return true;
+}
+
+bool
+skiplist_erase(skiplist_t* list, uint64_t key) {
+	skiplist_node_t* pred[SKIPLIST_MAX_HEIGHT];
+	skiplist_node_t* succ[SKIPLIST_MAX_HEIGHT];
+	epoch_reader_t* reader = _epoch_reader(list->reader);
+	int32_t epoch = _epoch_enter(&list->epoch, reader);
+	skiplist_node_t* node;
+	void* next;
+	int ilevel;
+
+	if (!_skiplist_find(list, key, pred, succ)) {
+		_skiplist_leave(list, reader, epoch);
+		return false;
+	}
+
+	//Mark upper levels top down, then level zero which decides the erasing thread
+	node = succ[0];
+	for (ilevel = (int)node->height - 1; ilevel > 0; --ilevel) {
+		do {
+			next = atomic_load_ptr(&node->next[ilevel]);
+		} while (!SKIPLIST_IS_MARKED(next) && !atomic_cas_ptr(&node->next[ilevel], SKIPLIST_MARK(next), next));
+	}
+	while (true) {
+		next = atomic_load_ptr(&node->next[0]);
+		if (SKIPLIST_IS_MARKED(next)) {
+			_skiplist_leave(list, reader, epoch);
+			return false;
+		}
+		if (atomic_cas_ptr(&node->next[0], SKIPLIST_MARK(next), next))
+			break;
+	}
+	atomic_add64(&list->size, -1);
+
+	_skiplist_unlink(list, key);
+	_skiplist_release(list, node);
+	_skiplist_leave(list, reader, epoch);
+	return true;
+}
+
+bool
+skiplist_lookup(skiplist_t* list, uint64_t key, uint64_t* value) {
+	epoch_reader_t* reader = _epoch_reader(list->reader);
+	int32_t epoch = _epoch_enter(&list->epoch, reader);
+	skiplist_node_t* node = _skiplist_lower_bound(list, key);
+	bool found = node && (node->key == key);
+	if (found && value)
+		*value = (uint64_t)atomic_load64(&node->value);
+	_skiplist_leave(list, reader, epoch);
+	return found;
+}
+
+size_t
+skiplist_size(const skiplist_t* list) {
+	return (size_t)atomic_load64(&list->size);
+}
+
+size_t
+skiplist_range(skiplist_t* list, uint64_t first, uint64_t last, uint64_t* keys, uint64_t* values,
+               size_t capacity) {
+	epoch_reader_t* reader;
+	skiplist_node_t* node;
+	int32_t epoch;
+	size_t count = 0;
+
+	if (!capacity || (first > last))
+		return 0;
+
+	reader = _epoch_reader(list->reader);
+	epoch = _epoch_enter(&list->epoch, reader);
+	node = _skiplist_lower_bound(list, first);
+	while (node && (node->key <= last)) {
+		void* next = atomic_load_ptr(&node->next[0]);
+		if (!SKIPLIST_IS_MARKED(next)) {
+			if (keys)
+				keys[count] = node->key;
+			if (values)
+				values[count] = (uint64_t)atomic_load64(&node->value);
+			if (++count == capacity)
+				break;
+		}
+		node = SKIPLIST_POINTER(next);
+	}
+	_skiplist_leave(list, reader, epoch);
+	return count;
+}
+
+void
+skiplist_reclaim(skiplist_t* list) {
+	//Two epoch advances retire both parities when no operation is running
+	if (_skiplist_reclaim_epoch(list))
+		_skiplist_reclaim_epoch(list);
+}
@@ -0,0 +1,96 @@
+/* skiplist.h  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#pragma once
+
+/*! \file skiplist.h
+\brief Lock free skiplist
+
+Ordered map from 64-bit keys to 64-bit values which can be accessed concurrently by any
+number of threads without locks. Lookups never write to the list and never retry on
+concurrent modification, insert and erase are lock free. Nodes are pooled in slabs owned
+by the list, erased nodes are reclaimed with epochs once no thread can still be accessing
+them and reused by later inserts. Memory is released when the list is finalized. Range
+queries return a weakly consistent view in ascending key order. The list must not be
+accessed by any thread while it is being finalized. */
+
+#include <foundation/platform.h>
+#include <foundation/types.h>
+
+/*! Allocate an empty skiplist. The list should be deallocated with a call to
+#skiplist_deallocate
+\return New list */
+FOUNDATION_API skiplist_t*
+skiplist_allocate(void);
+
+/*! Deallocate a skiplist previously allocated with #skiplist_allocate
+\param list List */
+FOUNDATION_API void
+skiplist_deallocate(skiplist_t* list);
+
+/*! Initialize an empty skiplist. The list should be finalized with a call to
+#skiplist_finalize
+\param list List */
+FOUNDATION_API void
+skiplist_initialize(skiplist_t* list);
+
+/*! Finalize a skiplist previously initialized with #skiplist_initialize
+\param list List */
+FOUNDATION_API void
+skiplist_finalize(skiplist_t* list);
+
+/*! Insert a key and value, replacing the value if the key already exists
+\param list List
+\param key Key
+\param value Value
+\return true if key was inserted, false if key existed and the value was replaced */
+FOUNDATION_API bool
+skiplist_insert(skiplist_t* list, uint64_t key, uint64_t value);
+
+/*! Erase a key
+\param list List
+\param key Key
+\return true if key was erased by this call, false if key did not exist */
+FOUNDATION_API bool
+skiplist_erase(skiplist_t* list, uint64_t key);
+
+/*! Lookup the value for a key
+\param list List
+\param key Key
+\param value Receives value if key exists, may be null
+\return true if key exists, false if not */
+FOUNDATION_API bool
+skiplist_lookup(skiplist_t* list, uint64_t key, uint64_t* value);
+
+/*! Get number of keys
+\param list List
+\return Number of keys */
+FOUNDATION_API size_t
+skiplist_size(const skiplist_t* list);
+
+/*! Copy entries with keys in the range [first,last] in ascending key order
+\param list List
+\param first First key in range
+\param last Last key in range
+\param keys Buffer receiving keys, may be null
+\param values Buffer receiving values, may be null
+\param capacity Capacity of buffers
+\return Number of entries stored, at most capacity */
+FOUNDATION_API size_t
+skiplist_range(skiplist_t* list, uint64_t first, uint64_t last, uint64_t* keys, uint64_t* values,
+               size_t capacity);
+
+/*! Return erased nodes no longer accessible by any thread to the node pool for reuse.
+Reclamation also runs automatically as erased nodes accumulate.
+\param list List */
+FOUNDATION_API void
+skiplist_reclaim(skiplist_t* list);
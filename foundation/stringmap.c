@@ -0,0 +1,313 @@
+/* stringmap.c  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+
+#define STRINGMAP_GROUPSIZE  16
+#define STRINGMAP_EMPTY      0x80
+#define STRINGMAP_DELETED    0xFE
+#define STRINGMAP_NOTFOUND   ((size_t)-1)
+#define STRINGMAP_ARENA_MIN  4096
+
+#define STRINGMAP_TAG(hash)   ((uint8_t)((hash) & 0x7F))
+#define STRINGMAP_GROUP(hash) ((size_t)((hash) >> 7))
+
+//Match masks hold one set bit per matching slot, at bit (slot * STRINGMAP_MATCH_STRIDE)
+#if FOUNDATION_ARCH_NEON
+#  define STRINGMAP_MATCH_STRIDE 4
+#else
+#  define STRINGMAP_MATCH_STRIDE 1
+#endif
+
+#if FOUNDATION_ARCH_NEON
+
+static FOUNDATION_FORCEINLINE uint64_t
+_stringmap_neon_mask(uint8x16_t match) {
+	//Narrow each 8-bit lane to a nibble, keep one bit per lane
+	uint8x8_t narrow = vshrn_n_u16(vreinterpretq_u16_u8(match), 4);
+	return vget_lane_u64(vreinterpret_u64_u8(narrow), 0) & 0x8888888888888888ULL;
+}
+
+#endif
+
+static FOUNDATION_FORCEINLINE uint64_t
+_stringmap_match(const uint8_t* control, uint8_t byte) {
+#if FOUNDATION_ARCH_SSE2
+	__m128i group = _mm_load_si128((const __m128i*)control);
+	return (uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)byte)));
+#elif FOUNDATION_ARCH_NEON
+	return _stringmap_neon_mask(vceqq_u8(vld1q_u8(control), vdupq_n_u8(byte)));
+#else
+	uint64_t mask = 0;
+	unsigned int islot;
+	for (islot = 0; islot < STRINGMAP_GROUPSIZE; ++islot) {
+		if (control[islot] == byte)
+			mask |= (1ULL << islot);
+	}
+	return mask;
+#endif
+}
+
+//Match empty and deleted slots, both have the high bit set
+static FOUNDATION_FORCEINLINE uint64_t
+_stringmap_match_free(const uint8_t* control) {
+#if FOUNDATION_ARCH_SSE2
+	return (uint64_t)_mm_movemask_epi8(_mm_load_si128((const __m128i*)control));
+#elif FOUNDATION_ARCH_NEON
+	return _stringmap_neon_mask(vtstq_u8(vld1q_u8(control), vdupq_n_u8(0x80)));
+#else
+	uint64_t mask = 0;
+	unsigned int islot;
+	for (islot = 0; islot < STRINGMAP_GROUPSIZE; ++islot) {
+		if (control[islot] & 0x80)
+			mask |= (1ULL << islot);
+	}
+	return mask;
+#endif
+}
+
+static FOUNDATION_FORCEINLINE size_t
+_stringmap_match_slot(uint64_t mask) {
+	return bits_ctz64(mask) / STRINGMAP_MATCH_STRIDE;
+}
+
+static size_t
+_stringmap_capacity(size_t num_groups) {
+	//Maximum load factor 7/8
+	return ((num_groups * STRINGMAP_GROUPSIZE) * 7) / 8;
+}
+
+static void
+_stringmap_allocate_slots(stringmap_t* map, size_t num_groups) {
+	size_t num_slots = num_groups * STRINGMAP_GROUPSIZE;
+	map->num_groups = num_groups;
+	map->control = memory_allocate(0, num_slots, 16, MEMORY_PERSISTENT);
+	map->slot = memory_allocate(0, sizeof(stringmap_slot_t) * num_slots, 0, MEMORY_PERSISTENT);
+	memset(map->control, STRINGMAP_EMPTY, num_slots);
+}
+
+static size_t
+_stringmap_find(const stringmap_t* map, const char* key, size_t length, hash_t hash) {
+	size_t group_mask = map->num_groups - 1;
+	size_t igroup = STRINGMAP_GROUP(hash) & group_mask;
+	uint8_t tag = STRINGMAP_TAG(hash);
+	size_t iprobe;
+
+	//Triangular probing visits every group once when group count is a power of two
+	for (iprobe = 1; iprobe <= map->num_groups; ++iprobe) {
+		const uint8_t* control = map->control + (igroup * STRINGMAP_GROUPSIZE);
+		uint64_t mask = _stringmap_match(control, tag);
+		while (mask) {
+			size_t islot = (igroup * STRINGMAP_GROUPSIZE) + _stringmap_match_slot(mask);
+			const stringmap_slot_t* slot = map->slot + islot;
+			if ((slot->hash == hash) && (slot->length == length) &&
+			        !memcmp(map->arena + slot->offset, key, length))
+				return islot;
+			mask &= mask - 1;
+		}
+		if (_stringmap_match(control, STRINGMAP_EMPTY))
+			break;
+		igroup = (igroup + iprobe) & group_mask;
+	}
+	return STRINGMAP_NOTFOUND;
+}
+
+static size_t
+_stringmap_find_free(const stringmap_t* map, hash_t hash) {
+	size_t group_mask = map->num_groups - 1;
+	size_t igroup = STRINGMAP_GROUP(hash) & group_mask;
+	size_t iprobe;
+	for (iprobe = 1; iprobe <= map->num_groups; ++iprobe) {
+		uint64_t mask = _stringmap_match_free(map->control + (igroup * STRINGMAP_GROUPSIZE));
+		if (mask)
+			return (igroup * STRINGMAP_GROUPSIZE) + _stringmap_match_slot(mask);
+		igroup = (igroup + iprobe) & group_mask;
+	}
+	return STRINGMAP_NOTFOUND;
+}
+
+static uint32_t
+_stringmap_store_key(stringmap_t* map, const char* key, size_t length) {
+	size_t offset = map->arena_used;
+	if (!length)
+		return (uint32_t)offset;
+	if (offset + length > map->arena_capacity) {
+		size_t capacity = map->arena_capacity ? map->arena_capacity : STRINGMAP_ARENA_MIN;
+		while (capacity < offset + length)
+			capacity *= 2;
+		map->arena = memory_reallocate(map->arena, capacity, 0, map->arena_capacity);
+		map->arena_capacity = capacity;
+	}
+	FOUNDATION_ASSERT_MSG(offset + length <= 0xFFFFFFFFULL, "String map key arena overflow");
+	memcpy(map->arena + offset, key, length);
+	map->arena_used = offset + length;
+	return (uint32_t)offset;
+}
+
+static void
+_stringmap_rehash(stringmap_t* map, size_t num_groups) {
+	uint8_t* control = map->control;
+	stringmap_slot_t* slot = map->slot;
+	char* arena = map->arena;
+	size_t num_slots = map->num_groups * STRINGMAP_GROUPSIZE;
+	size_t islot;
+
+	_stringmap_allocate_slots(map, num_groups);
+
+	//Compact the key arena, dropping keys of erased slots
+	map->arena = 0;
+	map->arena_used = 0;
+	map->arena_dead = 0;
+	map->arena_capacity = 0;
+	map->deleted = 0;
+
+	for (islot = 0; islot < num_slots; ++islot) {
+		if (!(control[islot] & 0x80)) {
+			size_t idst = _stringmap_find_free(map, slot[islot].hash);
+			map->control[idst] = control[islot];
+			map->slot[idst] = slot[islot];
+			map->slot[idst].offset = _stringmap_store_key(map, arena + slot[islot].offset,
+			                                              slot[islot].length);
+		}
+	}
+
+	memory_deallocate(control);
+	memory_deallocate(slot);
+	memory_deallocate(arena);
+}
+
+stringmap_t*
+stringmap_allocate(size_t capacity) {
+	stringmap_t* map = memory_allocate(0, sizeof(stringmap_t), 0, MEMORY_PERSISTENT);
+	stringmap_initialize(map, capacity);
+	return map;
+}
+
+void
+stringmap_deallocate(stringmap_t* map) {
+	stringmap_finalize(map);
+	memory_deallocate(map);
+}
+
+void
+stringmap_initialize(stringmap_t* map, size_t capacity) {
+	size_t num_groups = 1;
+	while (_stringmap_capacity(num_groups) < capacity)
+		num_groups *= 2;
+
+	memset(map, 0, sizeof(stringmap_t));
+	_stringmap_allocate_slots(map, num_groups);
+}
+
+void
+stringmap_finalize(stringmap_t* map) {
+	memory_deallocate(map->control);
+	memory_deallocate(map->slot);
+	memory_deallocate(map->arena);
+	memset(map, 0, sizeof(stringmap_t));
+}
+
+void*
+stringmap_insert(stringmap_t* map, const char* key, size_t length, void* value) {
+	hash_t hash = string_hash(key, length);
+	size_t islot = _stringmap_find(map, key, length, hash);
+	stringmap_slot_t* slot;
+
+	if (islot != STRINGMAP_NOTFOUND) {
+		void* prev = map->slot[islot].value;
+		map->slot[islot].value = value;
+		return prev;
+	}
+
+	if (map->count + map->deleted + 1 > _stringmap_capacity(map->num_groups)) {
+		//Grow if mostly live keys, otherwise rehash in place to reclaim erased slots
+		size_t num_groups = map->num_groups;
+		if ((map->count + 1) * 2 > _stringmap_capacity(num_groups))
+			num_groups *= 2;
+		_stringmap_rehash(map, num_groups);
+	}
+
+	islot = _stringmap_find_free(map, hash);
+	if (map->control[islot] == STRINGMAP_DELETED)
+		--map->deleted;
+	map->control[islot] = STRINGMAP_TAG(hash);
+	slot = map->slot + islot;
+	slot->hash = hash;
+	slot->length = (uint32_t)length;
+	slot->offset = _stringmap_store_key(map, key, length);
+	slot->value = value;
+	++map->count;
+
+	return 0;
+}
+
+void*
+stringmap_erase(stringmap_t* map, const char* key, size_t length) {
+	hash_t hash = string_hash(key, length);
+	size_t islot = _stringmap_find(map, key, length, hash);
+	stringmap_slot_t* slot;
+	size_t igroup;
+	void* prev;
+
+	if (islot == STRINGMAP_NOTFOUND)
+		return 0;
+
+	slot = map->slot + islot;
+	prev = slot->value;
+	--map->count;
+	++map->deleted;
+
+	//Slot can be marked empty if the group never filled up, since no probe
+	//sequence can then have continued past this group
+	igroup = islot / STRINGMAP_GROUPSIZE;
+	if (_stringmap_match(map->control + (igroup * STRINGMAP_GROUPSIZE), STRINGMAP_EMPTY))
+		map->control[islot] = STRINGMAP_EMPTY;
+	else
+		map->control[islot] = STRINGMAP_DELETED;
+
+	//Reclaim key directly if last in arena, otherwise compact the arena once
+	//erased keys use more space than live keys
+	if (slot->offset + slot->length == map->arena_used)
+		map->arena_used -= slot->length;
+	else
+		map->arena_dead += slot->length;
+	if ((map->arena_dead >= STRINGMAP_ARENA_MIN) &&
+	        (map->arena_dead > map->arena_used - map->arena_dead))
+		_stringmap_rehash(map, map->num_groups);
+
+	return prev;
+}
+
+void*
+stringmap_lookup(stringmap_t* map, const char* key, size_t length) {
+	size_t islot = _stringmap_find(map, key, length, string_hash(key, length));
+	return (islot != STRINGMAP_NOTFOUND) ? map->slot[islot].value : 0;
+}
+
+bool
+stringmap_has_key(stringmap_t* map, const char* key, size_t length) {
+	return _stringmap_find(map, key, length, string_hash(key, length)) != STRINGMAP_NOTFOUND;
+}
+
+size_t
+stringmap_size(stringmap_t* map) {
+	return map->count;
+}
+
+void
+stringmap_clear(stringmap_t* map) {
+	memset(map->control, STRINGMAP_EMPTY, map->num_groups * STRINGMAP_GROUPSIZE);
+	map->count = 0;
+	map->deleted = 0;
+	map->arena_used = 0;
+	map->arena_dead = 0;
+}
@@ -0,0 +1,95 @@
+/* stringmap.h  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#pragma once
+
+/*! \file stringmap.h
+\brief Container mapping string keys to pointers
+
+Container mapping string keys to pointers. Unlike hashmap_t the keys are stored in the
+map and compared in full, so hash collisions are handled correctly. Each slot has a
+control byte holding a 7-bit tag from the key hash, and slots are probed in groups of 16
+where all tags in a group are matched with a single vector compare. Full keys are only
+compared for slots with a matching tag. Access is not atomic and therefor not thread safe. */
+
+#include <foundation/platform.h>
+#include <foundation/types.h>
+
+/*! Allocate new string map able to store the given number of keys without growing.
+String map should be deallocated with a call to #stringmap_deallocate
+\param capacity Initial capacity
+\return New string map */
+FOUNDATION_API stringmap_t*
+stringmap_allocate(size_t capacity);
+
+/*! Deallocate a string map previously allocated with #stringmap_allocate
+\param map String map */
+FOUNDATION_API void
+stringmap_deallocate(stringmap_t* map);
+
+/*! Initialize new string map able to store the given number of keys without growing.
+String map should be finalized with a call to #stringmap_finalize
+\param map String map to initialize
+\param capacity Initial capacity */
+FOUNDATION_API void
+stringmap_initialize(stringmap_t* map, size_t capacity);
+
+/*! Finalize a string map previously initialized with #stringmap_initialize and free resources
+\param map String map */
+FOUNDATION_API void
+stringmap_finalize(stringmap_t* map);
+
+/*! Insert a new key-value mapping. Will replace any previously stored mapping for the
+given key. The key is copied to the map.
+\param map String map
+\param key Key
+\param length Length of key
+\param value Value
+\return Previously stored value, 0 if no value previously stored for key */
+FOUNDATION_API void*
+stringmap_insert(stringmap_t* map, const char* key, size_t length, void* value);
+
+/*! Erase any value mapping for the given key. Key storage is reclaimed by compacting
+the key arena once erased keys use more memory than stored keys.
+\param map String map
+\param key Key
+\param length Length of key
+\return Previously stored value, 0 if no value previously stored for key */
+FOUNDATION_API void*
+stringmap_erase(stringmap_t* map, const char* key, size_t length);
+
+/*! Lookup the stored value mapping for the given key
+\param map String map
+\param key Key
+\param length Length of key
+\return Stored value, 0 if no value stored for key */
+FOUNDATION_API void*
+stringmap_lookup(stringmap_t* map, const char* key, size_t length);
+
+/*! Query if there is any value mapping stored for the given key.
+\param map String map
+\param key Key
+\param length Length of key
+\return true if there is a value mapping stored for the key, false if not */
+FOUNDATION_API bool
+stringmap_has_key(stringmap_t* map, const char* key, size_t length);
+
+/*! Get the number of key-value mappings stored in the string map.
+\param map String map
+\return Number of keys stored */
+FOUNDATION_API size_t
+stringmap_size(stringmap_t* map);
+
+/*! Clear map and erase all key-value mappings.
+\param map String map */
+FOUNDATION_API void
+stringmap_clear(stringmap_t* map);
@@ -33,6 +33,7 @@ static GetCurrentProcessorNumberFn _fnGetCurrentProcessorNumber = GetCurrentProc
 #    include <sys/prctl.h>
 #  endif
 #  include <foundation/posix.h>
+#  include <limits.h>
 #endif
 
 #if FOUNDATION_PLATFORM_PNACL
@@ -51,6 +52,32 @@ static GetCurrentProcessorNumberFn _fnGetCurrentProcessorNumber = GetCurrentProc
 FOUNDATION_DECLARE_THREAD_LOCAL(thread_t*, self, 0)
 static uint64_t _thread_main_id;
 
+typedef struct thread_worker_t thread_worker_t;
+
+/*! OS thread running thread bodies. Workers are parked in a pool when the thread they
+run is joined and handed the next started thread with a matching stack size */
+struct thread_worker_t {
+	/*! OS handle */
+	uintptr_t handle;
+	/*! Stack size the OS thread was created with */
+	unsigned int stacksize;
+	/*! Assigned thread, null to terminate the worker */
+	thread_t* thread;
+	/*! Posted when a thread is assigned */
+	semaphore_t run;
+	/*! Posted when the assigned thread has finished */
+	semaphore_t done;
+	/*! Next idle worker in pool */
+	thread_worker_t* next;
+};
+
+static mutex_t* _thread_pool_lock;
+static thread_worker_t* _thread_pool_idle;
+static size_t _thread_pool_count;
+
+static void
+_thread_worker_destroy(thread_worker_t* worker);
+
 int
 _thread_initialize(void) {
 #if FOUNDATION_PLATFORM_WINDOWS
@@ -64,9 +91,31 @@ _thread_initialize(void) {
 
 	_thread_main_id = thread_id();
 
+	_thread_pool_lock = mutex_allocate(STRING_CONST("thread_pool"));
+
 	return 0;
 }
 
+void
+_thread_pool_finalize(void) {
+	thread_worker_t* worker;
+
+	mutex_lock(_thread_pool_lock);
+	worker = _thread_pool_idle;
+	_thread_pool_idle = 0;
+	_thread_pool_count = 0;
+	mutex_unlock(_thread_pool_lock);
+
+	while (worker) {
+		thread_worker_t* next = worker->next;
+		_thread_worker_destroy(worker);
+		worker = next;
+	}
+
+	mutex_deallocate(_thread_pool_lock);
+	_thread_pool_lock = 0;
+}
+
 void
 _thread_finalize(void) {
 	_profile_thread_finalize();
@@ -78,6 +127,8 @@ _thread_finalize(void) {
 	thread_detach_jvm();
 #endif
 
+	objectmap_deferred_flush();
+
 	error_context_thread_finalize();
 	memory_context_thread_finalize();
 }
@@ -173,9 +224,8 @@ typedef void* thread_arg_t;
 #  error Not implemented
 #endif
 
-static thread_return_t FOUNDATION_THREADCALL
-_thread_entry(thread_arg_t data) {
-	thread_t* thread = GET_THREAD_PTR(data);
+static void
+_thread_run(thread_t* thread) {
 	exception_handler_fn handler = exception_handler();
 
 	thread->osid = thread_id();
@@ -184,11 +234,10 @@ _thread_entry(thread_arg_t data) {
 	if (thread->name.length)
 		_set_thread_name(thread->name.str);
 #elif ( FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID ) && !BUILD_DEPLOY
-	if (thread->name.length)
-		prctl(PR_SET_NAME, thread->name.str, 0, 0, 0);
+	//Always set, a pooled OS thread would otherwise keep the name of the previous thread
+	prctl(PR_SET_NAME, thread->name.str, 0, 0, 0);
 #elif FOUNDATION_PLATFORM_BSD && !BUILD_DEPLOY
-	if (thread->name.length)
-		pthread_set_name_np(pthread_self(), thread->name.str);
+	pthread_set_name_np(pthread_self(), thread->name.str);
 #endif
 
 	//log_debugf(0, STRING_CONST("Starting thread '%.*s' (%" PRIx64 ") %s"),
@@ -226,10 +275,159 @@ _thread_entry(thread_arg_t data) {
 
 	set_thread_self(0);
 	thread_exit();
+}
+
+static thread_return_t FOUNDATION_THREADCALL
+_thread_worker_entry(thread_arg_t data) {
+	thread_worker_t* worker = data;
+	while (semaphore_wait(&worker->run)) {
+		thread_t* thread = worker->thread;
+		if (!thread)
+			break;
+		_thread_run(thread);
+		semaphore_post(&worker->done);
+	}
+	return 0;
+}
+
+#if FOUNDATION_PLATFORM_POSIX
+
+static size_t
+_thread_stack_size(unsigned int stacksize) {
+	size_t size = stacksize;
+	size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+#ifdef PTHREAD_STACK_MIN
+	if (size < (size_t)PTHREAD_STACK_MIN)
+		size = (size_t)PTHREAD_STACK_MIN;
+#endif
+	if (page_size)
+		size = ((size + page_size - 1) / page_size) * page_size;
+	return size;
+}
+
+#endif
+
+static thread_worker_t*
+_thread_worker_create(unsigned int stacksize) {
+	thread_worker_t* worker = memory_allocate(0, sizeof(thread_worker_t), 0,
+	                                          MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	worker->stacksize = stacksize;
+	semaphore_initialize(&worker->run, 0);
+	semaphore_initialize(&worker->done, 0);
 
+#if FOUNDATION_PLATFORM_WINDOWS
+	worker->handle = _beginthreadex(nullptr, stacksize, _thread_worker_entry, worker, 0, nullptr);
+	if (!worker->handle) {
+		int err = system_error();
+		string_const_t errmsg = system_error_message(err);
+		log_errorf(0, ERROR_OUT_OF_MEMORY,
+		           STRING_CONST("Unable to create thread: CreateThread failed: %.*s (%d)"),
+		           STRING_FORMAT(errmsg), err);
+		goto failed;
+	}
+#elif FOUNDATION_PLATFORM_POSIX || FOUNDATION_PLATFORM_PNACL
+	{
+		pthread_t id = 0;
+		pthread_attr_t attr;
+		int err;
+
+		pthread_attr_init(&attr);
+#  if FOUNDATION_PLATFORM_POSIX
+		if (stacksize) {
+			err = pthread_attr_setstacksize(&attr, _thread_stack_size(stacksize));
+			if (err) {
+				string_const_t errmsg = system_error_message(err);
+				log_warnf(0, WARNING_SYSTEM_CALL_FAIL,
+				          STRING_CONST("Unable to set thread stack size %u: %.*s (%d)"),
+				          stacksize, STRING_FORMAT(errmsg), err);
+			}
+		}
+#  endif
+		err = pthread_create(&id, &attr, _thread_worker_entry, worker);
+		pthread_attr_destroy(&attr);
+		if (err) {
+			string_const_t errmsg = system_error_message(err);
+			log_errorf(0, ERROR_OUT_OF_MEMORY,
+			           STRING_CONST("Unable to create thread: pthread_create failed: %.*s (%d)"),
+			           STRING_FORMAT(errmsg), err);
+			goto failed;
+		}
+		worker->handle = (uintptr_t)id;
+	}
+#else
+#  error Not implemented
+#endif
+
+	return worker;
+
+failed:
+	semaphore_finalize(&worker->run);
+	semaphore_finalize(&worker->done);
+	memory_deallocate(worker);
 	return 0;
 }
 
+static void
+_thread_worker_destroy(thread_worker_t* worker) {
+	worker->thread = 0;
+	semaphore_post(&worker->run);
+
+#if FOUNDATION_PLATFORM_WINDOWS
+	WaitForSingleObject((HANDLE)worker->handle, INFINITE);
+	CloseHandle((HANDLE)worker->handle);
+#elif FOUNDATION_PLATFORM_POSIX || FOUNDATION_PLATFORM_PNACL
+	pthread_join((pthread_t)worker->handle, 0);
+#else
+#  error Not implemented
+#endif
+
+	semaphore_finalize(&worker->run);
+	semaphore_finalize(&worker->done);
+	memory_deallocate(worker);
+}
+
+static thread_worker_t*
+_thread_worker_acquire(unsigned int stacksize) {
+	thread_worker_t* worker = 0;
+	thread_worker_t** link;
+
+	if (_thread_pool_lock) {
+		mutex_lock(_thread_pool_lock);
+		for (link = &_thread_pool_idle; *link; link = &(*link)->next) {
+			if ((*link)->stacksize == stacksize) {
+				worker = *link;
+				*link = worker->next;
+				--_thread_pool_count;
+				break;
+			}
+		}
+		mutex_unlock(_thread_pool_lock);
+	}
+
+	if (worker) {
+		worker->next = 0;
+		return worker;
+	}
+	return _thread_worker_create(stacksize);
+}
+
+static void
+_thread_worker_release(thread_worker_t* worker) {
+	worker->thread = 0;
+	if (_thread_pool_lock) {
+		mutex_lock(_thread_pool_lock);
+		if (_thread_pool_count < foundation_config().thread_pool_size) {
+			worker->next = _thread_pool_idle;
+			_thread_pool_idle = worker;
+			++_thread_pool_count;
+			worker = 0;
+		}
+		mutex_unlock(_thread_pool_lock);
+	}
+	if (worker)
+		_thread_worker_destroy(worker);
+}
+
 thread_t*
 thread_allocate(thread_fn fn, void* data, const char* name, size_t length,
                 thread_priority_t priority, unsigned int stacksize) {
@@ -270,57 +468,32 @@ thread_finalize(thread_t* thread) {
 
 bool
 thread_start(thread_t* thread) {
+	thread_worker_t* worker;
+
 	//Reset beacon
 	beacon_try_wait(&thread->beacon, 0);
-#if FOUNDATION_PLATFORM_WINDOWS
-	FOUNDATION_ASSERT(!thread->handle);
-	thread->handle = _beginthreadex(nullptr, thread->stacksize, _thread_entry, thread, 0, nullptr);
-	if (!thread->handle) {
-		int err = system_error();
-		string_const_t errmsg = system_error_message(err);
-		log_errorf(0, ERROR_OUT_OF_MEMORY,
-		           STRING_CONST("Unable to create thread: CreateThread failed: %.*s (%d)"),
-		           STRING_FORMAT(errmsg), err);
-		return false;
-	}
-#elif FOUNDATION_PLATFORM_POSIX || FOUNDATION_PLATFORM_PNACL
+
 	FOUNDATION_ASSERT(!thread->handle);
-	pthread_t id = 0;
-	int err = pthread_create(&id, 0, _thread_entry, thread);
-	if (err) {
-		string_const_t errmsg = system_error_message(err);
-		log_errorf(0, ERROR_OUT_OF_MEMORY,
-		           STRING_CONST("Unable to create thread: pthread_create failed: %.*s (%d)"),
-		           STRING_FORMAT(errmsg), err);
+	worker = _thread_worker_acquire(thread->stacksize);
+	if (!worker)
 		return false;
-	}
-	thread->handle = (uintptr_t)id;
-#else
-#  error Not implemented
-#endif
+
+	worker->thread = thread;
+	thread->handle = (uintptr_t)worker;
+	semaphore_post(&worker->run);
 
 	return true;
 }
 
 void*
 thread_join(thread_t* thread) {
-#if FOUNDATION_PLATFORM_WINDOWS
 	if (thread->handle) {
-		WaitForSingleObject((HANDLE)thread->handle, INFINITE);
-		CloseHandle((HANDLE)thread->handle);
+		thread_worker_t* worker = (thread_worker_t*)thread->handle;
+		semaphore_wait(&worker->done);
 		atomic_store32(&thread->state, 3);
+		_thread_worker_release(worker);
 	}
 	thread->handle = 0;
-#elif FOUNDATION_PLATFORM_POSIX || FOUNDATION_PLATFORM_PNACL
-	void* result = 0;
-	if (thread->handle) {
-		pthread_join((pthread_t)thread->handle, &result);
-		atomic_store32(&thread->state, 3);
-	}
-	thread->handle = 0;
-#else
-#  error Not implemented
-#endif
 	atomic_thread_fence_release();
 	return thread->result;
 }
@@ -335,6 +335,21 @@ typedef enum {
 	JSON_PRIMITIVE
 } json_type_t;
 
+/*! Policy when posting an event to an event stream with a full event block */
+typedef enum {
+	/*! Report an error and drop the new event */
+	EVENT_OVERFLOW_ERROR = 0,
+	/*! Block posting thread until event stream is processed */
+	EVENT_OVERFLOW_BLOCK,
+	/*! Drop oldest pending events to make room for the new event */
+	EVENT_OVERFLOW_DROP_OLDEST,
+	/*! Drop the new event */
+	EVENT_OVERFLOW_DROP_NEWEST,
+	/*! Replace pending event with same id and object with the new event, drop the
+	new event if no such event is pending */
+	EVENT_OVERFLOW_COALESCE
+} event_overflow_t;
+
 /*! Memory hint, memory allocationis persistent (retained when function returns) */
 #define MEMORY_PERSISTENT       0
 /*! Memory hint, memory is temporary (extremely short lived and generally freed
@@ -349,6 +364,11 @@ before function returns or scope ends) */
 
 /*! Event flag, event is delayed and will be delivered at a later timestamp */
 #define EVENTFLAG_DELAY 1U
+/*! Event flag, event payload is a reference to data released after processing */
+#define EVENTFLAG_REFERENCE (1U<<1)
+
+/*! Maximum number of subscribers to a broadcast event stream */
+#define EVENT_BROADCAST_MAX_SUBSCRIBERS 64
 
 /*! Application flag, application is a command line utility and should not have
 a normal windowing system interaction loop */
@@ -371,6 +391,27 @@ a normal windowing system interaction loop */
 /*! Stream flag, stream is synchronized on each write */
 #define STREAM_SYNC     (1U<<6)
 
+/*! File map flag, map a private copy-on-write view of the file */
+#define FS_MAP_PRIVATE    (1U<<8)
+/*! File map hint, pages will be accessed sequentially */
+#define FS_MAP_SEQUENTIAL 1U
+/*! File map hint, pages will be accessed in random order */
+#define FS_MAP_RANDOM     (1U<<1)
+/*! File map hint, pages will be needed soon and should be read ahead */
+#define FS_MAP_WILLNEED   (1U<<2)
+
+/*! Array map flag, map a private copy-on-write view where elements can be modified
+without modifying the file */
+#define ARRAY_MAP_PRIVATE    1U
+/*! Array map flag, elements will be accessed sequentially */
+#define ARRAY_MAP_SEQUENTIAL (1U<<1)
+/*! Array map flag, elements will be accessed in random order */
+#define ARRAY_MAP_RANDOM     (1U<<2)
+/*! Array map flag, elements will be needed soon and should be read ahead */
+#define ARRAY_MAP_WILLNEED   (1U<<3)
+/*! Array map flag, verify checksum of elements when mapping, reading the entire file */
+#define ARRAY_MAP_VERIFY     (1U<<4)
+
 /*! Process flag, spawn method will block until process ends and then return
 process exit code */
 #define PROCESS_ATTACHED                   0
@@ -468,6 +509,21 @@ typedef union {
 
 #endif
 
+#if FOUNDATION_ARCH_SSE2
+#  include <emmintrin.h>
+/*! Four component 32-bit floating point vector, stored in a SIMD register */
+typedef __m128                        vector4_t;
+#elif FOUNDATION_ARCH_NEON
+#  include <arm_neon.h>
+typedef float32x4_t                   vector4_t;
+#else
+typedef struct vector4_t              vector4_t;
+#endif
+/*! Rotation quaternion, vector part in x, y and z components and scalar part in w */
+typedef vector4_t                     quaternion_t;
+/*! 4x4 matrix of 32-bit floating point values, stored as four row vectors */
+typedef struct matrix4_t              matrix4_t;
+
 /*! String */
 typedef struct string_t               string_t;
 /*! Constant immutable string */
@@ -478,8 +534,32 @@ typedef struct application_t          application_t;
 typedef struct beacon_t               beacon_t;
 /*! Bit buffer instance */
 typedef struct bitbuffer_t            bitbuffer_t;
+/*! Fixed size bitset with rank and select */
+typedef struct bitset_t               bitset_t;
+/*! Blocked Bloom filter for approximate set membership */
+typedef struct bloomfilter_t          bloomfilter_t;
 /*! Blowfish cipher instance */
 typedef struct blowfish_t             blowfish_t;
+/*! B+tree ordered map */
+typedef struct btree_t                btree_t;
+/*! B+tree iterator */
+typedef struct btree_iterator_t       btree_iterator_t;
+/*! B+tree node */
+typedef struct btree_node_t           btree_node_t;
+/*! Memory budgeted cache */
+typedef struct cache_t                cache_t;
+/*! Entry in a cache */
+typedef struct cache_entry_t          cache_entry_t;
+/*! Shard in a cache */
+typedef struct cache_shard_t          cache_shard_t;
+/*! Slot in the key index of a cache shard */
+typedef struct cache_slot_t           cache_slot_t;
+/*! Cache statistics */
+typedef struct cache_statistics_t     cache_statistics_t;
+/*! Count-min sketch for approximate key frequencies */
+typedef struct countmin_t             countmin_t;
+/*! Cuckoo filter for approximate set membership with deletion */
+typedef struct cuckoofilter_t         cuckoofilter_t;
 /*! Error frame holding debug data for an entry in the frame stack in the error context */
 typedef struct error_frame_t          error_frame_t;
 /*! Error context holding error frame stack for a thread */
@@ -490,22 +570,66 @@ typedef struct event_t                event_t;
 typedef struct event_block_t          event_block_t;
 /*! Event stream instance producing event blocks of events */
 typedef struct event_stream_t         event_stream_t;
+/*! Broadcast event stream delivering events to multiple subscribers */
+typedef struct event_broadcast_t      event_broadcast_t;
+/*! Block of events in a broadcast event stream, shared by subscribers */
+typedef struct event_broadcast_block_t event_broadcast_block_t;
+/*! Event id filter in a broadcast event stream */
+typedef struct event_filter_t         event_filter_t;
+/*! Subscriber reading events from a broadcast event stream */
+typedef struct event_subscriber_t     event_subscriber_t;
+/*! Reader counters of one stripe in epoch based memory reclamation */
+typedef struct epoch_reader_t         epoch_reader_t;
 /*! Payload for a file system event */
 typedef struct fs_event_payload_t     fs_event_payload_t;
+/*! File mapped into memory */
+typedef struct fs_map_t               fs_map_t;
+/*! Persistent hash array mapped trie mapping hash value keys to pointer values */
+typedef struct hamt_t                 hamt_t;
+/*! Key and value stored in a hash array mapped trie node */
+typedef struct hamt_entry_t           hamt_entry_t;
+/*! Node in a hash array mapped trie */
+typedef struct hamt_node_t            hamt_node_t;
+/*! Node memory pool shared by versions of a hash array mapped trie */
+typedef struct hamt_pool_t            hamt_pool_t;
+/*! Published hash array mapped trie, safe for concurrent readers and writers */
+typedef struct hamt_root_t            hamt_root_t;
+/*! Persistent hash index in a memory mapped file */
+typedef struct hashindex_t            hashindex_t;
 /*! Node in a hash map */
 typedef struct hashmap_node_t         hashmap_node_t;
 /*! Hash map mapping hash value keys to pointer values */
 typedef struct hashmap_t              hashmap_t;
 /*! Hash map of fixed size */
 typedef struct hashmap_fixed_t        hashmap_fixed_t;
+/*! Entry in a concurrent hash map table */
+typedef struct hashmap_concurrent_entry_t hashmap_concurrent_entry_t;
+/*! Open addressing table in a concurrent hash map shard */
+typedef struct hashmap_concurrent_table_t hashmap_concurrent_table_t;
+/*! Shard in a concurrent hash map */
+typedef struct hashmap_concurrent_shard_t hashmap_concurrent_shard_t;
+/*! Sharded hash map mapping hash value keys to pointer values, safe for concurrent access */
+typedef struct hashmap_concurrent_t   hashmap_concurrent_t;
 /*! Entry in a 32-bit hash table */
 typedef struct hashtable32_entry_t    hashtable32_entry_t;
 /*! Entry in a 64-bit hash table */
 typedef struct hashtable64_entry_t    hashtable64_entry_t;
+/*! HyperLogLog sketch for approximate distinct counts */
+typedef struct hyperloglog_t          hyperloglog_t;
 /*! Hash table mapping 32-bit keys to 32-bit values */
 typedef struct hashtable32_t          hashtable32_t;
 /*! Hash table mapping 64-bit keys to 64-bit values */
 typedef struct hashtable64_t          hashtable64_t;
+/*! Tracker of the keys with the highest counts in a 64-bit hash table */
+typedef struct hashtable64_topk_t     hashtable64_topk_t;
+/*! Entry in a 128-bit key hash table */
+typedef struct hashtable128_entry_t   hashtable128_entry_t;
+/*! Hash table mapping 128-bit keys to 64-bit values */
+typedef struct hashtable128_t         hashtable128_t;
+/*! Entry in a d-ary heap */
+typedef struct heap_entry_t           heap_entry_t;
+/*! D-ary min-heap priority queue */
+typedef struct heap_t                 heap_t;
 /*! MD5 control block */
 typedef struct md5_t                  md5_t;
 /*! Memory context holding the allocation context stack */
@@ -532,10 +656,18 @@ typedef struct regex_t                regex_t;
 typedef struct ringbuffer_t           ringbuffer_t;
 /*! SHA-256 control block */
 typedef struct sha256_t               sha256_t;
+/*! Lock free skiplist ordered map */
+typedef struct skiplist_t             skiplist_t;
+/*! Node in a lock free skiplist */
+typedef struct skiplist_node_t        skiplist_node_t;
 /*! SHA-512 control block */
 typedef struct sha512_t               sha512_t;
 /*! Base stream type all stream types are based on */
 typedef struct stream_t               stream_t;
+/*! Slot in a string keyed hash map */
+typedef struct stringmap_slot_t       stringmap_slot_t;
+/*! Hash map mapping string keys to pointer values */
+typedef struct stringmap_t            stringmap_t;
 /*! Memory buffer stream */
 typedef struct stream_buffer_t        stream_buffer_t;
 /*! Pipe stream */
@@ -551,6 +683,12 @@ typedef struct thread_t               thread_t;
 typedef struct json_token_t           json_token_t;
 /*! Version declaration */
 typedef union  version_t              version_t;
+/*! Write-ahead log with group commit */
+typedef struct wal_t                  wal_t;
+/*! Segment file in a write-ahead log */
+typedef struct wal_segment_t          wal_segment_t;
+/*! Waiter for durability of a write-ahead log record */
+typedef struct wal_waiter_t           wal_waiter_t;
 /*! Library configuration block controlling limits, functionality and memory
 usage of the library */
 typedef struct foundation_config_t    foundation_config_t;
@@ -614,6 +752,14 @@ typedef void (* json_handler_fn)(const char* path, size_t path_size,
                                  const char* buffer, size_t size,
                                  const json_token_t* tokens, size_t numtokens);
 
+/*! Event payload release function. Called for events posted with a payload reference
+once the event block holding the event has been processed, or if the event could not
+be posted
+\param data Payload data
+\param size Payload size
+\param context Context passed when posting event */
+typedef void (* event_release_fn)(void* data, size_t size, void* context);
+
 /*! Subsystem initialization function prototype. Return value should be the success
 state of initialization
 \return 0 on success, <0 if failure (errors should be reported through log_error
@@ -701,6 +847,44 @@ typedef void (* exception_handler_fn)(const char* file, size_t length);
 \param object Object pointer */
 typedef void (* object_deallocate_fn)(object_t id, void* object);
 
+/*! Cache eviction function prototype, called when a value leaves a cache by eviction,
+replacement, erase or clear. Called with the cache shard locked, so it must not access
+the cache
+\param key Key
+\param value Value
+\param cost Cost of value */
+typedef void (* cache_evict_fn)(hash_t key, void* value, size_t cost);
+
+/*! Cache retain function prototype, called for a value found by a lookup before the
+cache shard is unlocked, allowing the caller to take a reference to the value before it
+can be evicted by another thread. Called with the cache shard locked, so it must not
+access the cache
+\param key Key
+\param value Value
+\param cost Cost of value */
+typedef void (* cache_retain_fn)(hash_t key, void* value, size_t cost);
+
+/*! Object map iteration function prototype, called for each object stored in an object map
+\param object Object pointer
+\param data Data passed to the iteration function
+\return 0 to continue iteration, non-zero to stop */
+typedef int (* objectmap_foreach_fn)(void* object, void* data);
+
+/*! Iteration function for hash array mapped tries
+\param key Key
+\param value Value
+\param data Data passed to the iteration function
+\return 0 to continue iteration, non-zero to stop */
+typedef int (* hamt_foreach_fn)(hash_t key, void* value, void* data);
+
+/*! Record function for write-ahead log recovery, called for each valid record
+\param sequence Record sequence number
+\param data Record data
+\param size Size of record data
+\param context Context passed to the recovery function
+\return 0 to continue recovery, non-zero to stop */
+typedef int (* wal_record_fn)(uint64_t sequence, const void* data, size_t size, void* context);
+
 /*! Generic function to open a stream with the given path and mode
 \param path Path, optionally including protocol
 \param length Length of path
@@ -824,8 +1008,10 @@ struct foundation_config_t {
 	size_t event_block_chunk;
 	/*! Maximum size of an event block. Zero for default (512KiB) */
 	size_t event_block_limit;
-	/*! Default thread stack size. Zero for default (32KiB) */
+	/*! Default thread stack size. Zero for default (32KiB on Windows, OS default on other platforms) */
 	size_t thread_stack_size;
+	/*! Maximum number of idle OS threads kept for reuse by thread_start. Zero for default (16) */
+	size_t thread_pool_size;
 	/*! Number of random state blocks to preallocate on thread startup. Zero for default (0) */
 	size_t random_state_prealloc;
 };
@@ -957,6 +1143,31 @@ union version_t {
 	} sub;
 };
 
+#if !FOUNDATION_ARCH_SSE2 && !FOUNDATION_ARCH_NEON
+
+/*! Four component 32-bit floating point vector, scalar fallback when no SIMD
+instruction set is available */
+FOUNDATION_ALIGNED_STRUCT(vector4_t, 16) {
+	/*! X component */
+	float32_t x;
+	/*! Y component */
+	float32_t y;
+	/*! Z component */
+	float32_t z;
+	/*! W component */
+	float32_t w;
+};
+
+#endif
+
+/*! 4x4 matrix of 32-bit floating point values. Vectors are treated as row vectors
+and transformed by multiplication on the left side, v' = v * M, which places the
+translation in the last row */
+FOUNDATION_ALIGNED_STRUCT(matrix4_t, 16) {
+	/*! Matrix rows */
+	vector4_t row[4];
+};
+
 /*! Application declaration. String pointers passed in this struct must be
 constant and valid for the entire lifetime and execution of the application. */
 struct application_t {
@@ -1013,6 +1224,356 @@ struct bitbuffer_t {
 	uint64_t count_write;
 };
 
+/*! Fixed size bitset. Bits are stored in 64-bit words padded to a multiple of 512-bit
+blocks, bits beyond the bitset size are always zero. The optional rank index stores the number of set bits
+preceding each 512-bit block, and the select index samples the blocks holding every
+512th set bit to narrow the rank index search. Both are built by #bitset_rank_build. */
+struct bitset_t {
+	/*! Number of bits */
+	size_t num_bits;
+	/*! Number of 64-bit words */
+	size_t num_words;
+	/*! Bit storage */
+	uint64_t* word;
+	/*! Number of entries in rank index, zero if no index is built */
+	size_t num_rank;
+	/*! Rank index, set bits preceding each block plus the total count */
+	uint64_t* rank;
+	/*! Number of entries in select index */
+	size_t num_select;
+	/*! Select index, block holding every 512th set bit */
+	uint64_t* select;
+};
+
+/*! Blocked Bloom filter. Each key maps to a single 256-bit block and sets one bit in each
+of the eight 32-bit words of the block, so a query touches a single cache line. */
+struct bloomfilter_t {
+	/*! Number of blocks */
+	size_t num_blocks;
+	/*! Block storage, eight 32-bit words per block */
+	uint32_t* block;
+};
+
+#define BTREE_NODE_KEYS             30U
+
+/*! B+tree node, padded to eight cache lines. Keys are sorted and unused keys are set to
+UINT64_MAX so searches can compare whole vectors of keys. */
+struct btree_node_t {
+	/*! Number of keys */
+	uint32_t num_keys;
+	/*! Height above the leaf level, zero for leaf nodes */
+	uint32_t level;
+	/*! Next leaf node in key order, null for the last leaf and inner nodes */
+	btree_node_t* next;
+	/*! Keys. In inner nodes key i is the smallest key in the subtree of child i+1 */
+	uint64_t key[BTREE_NODE_KEYS];
+	/*! Child nodes in inner nodes, values in leaf nodes */
+	void* slot[BTREE_NODE_KEYS + 1];
+};
+
+/*! B+tree mapping 64-bit keys to data pointers. Nodes are allocated in cache line
+aligned slabs and recycled through a free list. */
+struct btree_t {
+	/*! Root node, null if tree has never held a key */
+	btree_node_t* root;
+	/*! Number of keys */
+	size_t size;
+	/*! Free list of nodes, linked through the next pointer */
+	btree_node_t* free;
+	/*! Array of allocated slabs */
+	void** slab;
+};
+
+/*! Iterator over B+tree entries in ascending key order */
+struct btree_iterator_t {
+	/*! Current leaf node, null when iteration is done */
+	const btree_node_t* node;
+	/*! Index of current entry in leaf node */
+	unsigned int index;
+};
+
+/*! Entry in a cache, linked in recency order in one of the two cache segments */
+struct cache_entry_t {
+	/*! Key */
+	hash_t key;
+	/*! Value */
+	void* value;
+	/*! Cost counted against the cache budget */
+	size_t cost;
+	/*! Previous entry towards the most recently used end of the segment */
+	uint32_t prev;
+	/*! Next entry towards the least recently used end of the segment, or next free entry */
+	uint32_t next;
+	/*! Segment holding the entry, probation or protected */
+	uint32_t segment;
+};
+
+/*! Slot in the linear probing key index of a cache shard */
+struct cache_slot_t {
+	/*! Key */
+	hash_t key;
+	/*! Entry index plus one, zero if slot is empty */
+	uint32_t entry;
+};
+
+/*! Cache shard with segmented LRU eviction. New entries enter the probation segment and
+are promoted to the protected segment when hit again, entries are evicted from the least
+recently used end of the probation segment */
+FOUNDATION_ALIGNED_STRUCT(cache_shard_t, 64) {
+	/*! Lock, only used by concurrent caches */
+	atomic32_t lock;
+	/*! Budget for the total cost of entries */
+	size_t budget;
+	/*! Budget for the total cost of entries in the protected segment */
+	size_t protected_budget;
+	/*! Total cost of entries in probation and protected segments */
+	size_t used[2];
+	/*! Most recently used entry in probation and protected segments */
+	uint32_t head[2];
+	/*! Least recently used entry in probation and protected segments */
+	uint32_t tail[2];
+	/*! First free entry */
+	uint32_t free;
+	/*! Number of entries */
+	uint32_t count;
+	/*! Array of entries */
+	cache_entry_t* entry;
+	/*! Number of index slots, power of two */
+	size_t num_slots;
+	/*! Index slots */
+	cache_slot_t* slot;
+	/*! Number of lookup hits */
+	uint64_t hits;
+	/*! Number of lookup misses */
+	uint64_t misses;
+	/*! Number of inserted entries */
+	uint64_t inserts;
+	/*! Number of entries evicted to stay within budget */
+	uint64_t evictions;
+};
+
+/*! Cache mapping hash keys to values with a total cost budget, split in shards */
+struct cache_t {
+	/*! Number of shards, power of two */
+	size_t num_shards;
+	/*! Flag if shards are locked for concurrent access */
+	bool concurrent;
+	/*! Eviction function, may be null */
+	cache_evict_fn evict;
+	/*! Shards */
+	cache_shard_t* shard;
+};
+
+/*! Cache statistics, summed over all shards */
+struct cache_statistics_t {
+	/*! Number of lookup hits */
+	uint64_t hits;
+	/*! Number of lookup misses */
+	uint64_t misses;
+	/*! Number of inserted entries */
+	uint64_t inserts;
+	/*! Number of entries evicted to stay within budget */
+	uint64_t evictions;
+	/*! Number of entries */
+	size_t count;
+	/*! Total cost of entries */
+	size_t used;
+	/*! Budget for the total cost of entries */
+	size_t budget;
+};
+
+/*! Cuckoo filter storing 16-bit fingerprints in buckets of four, with a single
+victim slot holding the entry evicted by the last failed insertion. */
+struct cuckoofilter_t {
+	/*! Number of buckets, a power of two */
+	size_t num_buckets;
+	/*! Number of stored fingerprints */
+	size_t count;
+	/*! Bucket storage, four 16-bit fingerprints packed per 64-bit bucket */
+	uint64_t* bucket;
+	/*! Bucket index of victim fingerprint */
+	size_t victim_index;
+	/*! Victim fingerprint, zero if no victim */
+	uint16_t victim;
+};
+
+/*! HyperLogLog sketch. Starts out with a sparse list of register index and value pairs
+and switches to one byte per register once the list would grow past a fraction of the
+dense size. */
+struct hyperloglog_t {
+	/*! Number of hash bits used for register index */
+	unsigned int precision;
+	/*! Number of entries in sparse list */
+	size_t num_sparse;
+	/*! Capacity of sparse list */
+	size_t sparse_capacity;
+	/*! Sparse list, register index in the high bits and register value in the low
+	    eight bits. Null when dense */
+	uint32_t* sparse;
+	/*! Dense registers, null while sparse */
+	uint8_t* dense;
+};
+
+/*! Count-min sketch, a matrix of counters with one row per hash function */
+struct countmin_t {
+	/*! Number of counters per row */
+	size_t width;
+	/*! Number of rows */
+	size_t depth;
+	/*! Sum of all added counts */
+	uint64_t total;
+	/*! Counters, depth rows of width counters */
+	uint64_t* counter;
+};
+
+/*! Entry in a d-ary heap, ordered by key */
+struct heap_entry_t {
+	/*! Key, smallest key is at the top of the heap */
+	uint64_t key;
+	/*! Identifier of entry */
+	uint32_t id;
+};
+
+/*! D-ary min-heap stored in an array, children of entry i are entries (i * arity) + 1
+through (i * arity) + arity. Indexed heaps additionally map entry identifiers to heap
+positions, allowing keys of entries in the heap to be changed. */
+struct heap_t {
+	/*! Base two logarithm of arity */
+	unsigned int shift;
+	/*! Array of entries */
+	heap_entry_t* entry;
+	/*! Array mapping identifier to heap position plus one, zero if not in heap. Null for
+	    heaps that are not indexed */
+	uint32_t* index;
+	/*! Flag if heap is indexed */
+	bool indexed;
+};
+
+#define EPOCH_READER_STRIPES 16U
+
+/*! Number of threads inside an epoch for each epoch parity, one stripe per cache line
+to keep readers from contending. Used by structures reclaiming memory once no reader
+announced in the previous epoch remains */
+FOUNDATION_ALIGNED_STRUCT(epoch_reader_t, 64) {
+	/*! Active reader count for even and odd epochs */
+	atomic32_t count[2];
+};
+
+#define HAMT_POOL_CLASSES   33U
+
+/*! Key and value in a hash array mapped trie node */
+struct hamt_entry_t {
+	/*! Key */
+	hash_t key;
+	/*! Value */
+	void* value;
+};
+
+/*! Node in a hash array mapped trie, indexed by five bits of the key per level. Entries
+stored inline in the node are followed by pointers to child nodes, both ordered by key
+bits. Nodes are immutable once created and shared between tries by reference count */
+struct hamt_node_t {
+	/*! References held by parent nodes and tries */
+	atomic32_t ref;
+	/*! Bitmap of key bits with an entry stored inline */
+	uint32_t datamap;
+	/*! Bitmap of key bits with a child node */
+	uint32_t nodemap;
+	/*! Entries, followed by child node pointers */
+	hamt_entry_t entry[FOUNDATION_FLEXIBLE_ARRAY];
+};
+
+/*! Node memory pool shared by all versions derived from the same empty trie. Nodes are
+carved from slabs and recycled through free lists by size in units of 16 bytes. Slabs
+are released with the last version */
+struct hamt_pool_t {
+	/*! References held by versions */
+	atomic32_t ref;
+	/*! Lock for free lists and slabs */
+	atomic32_t lock;
+	/*! Free nodes for each size class, linked through the first pointer */
+	void* free[HAMT_POOL_CLASSES];
+	/*! Allocated slabs, linked through the first pointer in each slab */
+	void* slab;
+	/*! Next unused memory in current slab */
+	char* cursor;
+	/*! Number of unused bytes in current slab */
+	size_t remain;
+};
+
+/*! Immutable version of a persistent hash array mapped trie */
+struct hamt_t {
+	/*! References held by owners of this version */
+	atomic32_t ref;
+	/*! Number of keys */
+	size_t size;
+	/*! Root node, null if empty */
+	hamt_node_t* root;
+	/*! Node pool */
+	hamt_pool_t* pool;
+};
+
+/*! Root publishing the current version of a persistent hash array mapped trie. Readers
+announce themselves in the current epoch, a writer replacing the version advances the
+epoch and releases the previous version once no reader announced in the previous epoch
+remains */
+struct hamt_root_t {
+	/*! Current version */
+	atomicptr_t map;
+	/*! Current epoch */
+	atomic32_t epoch;
+	/*! Writer lock */
+	atomic32_t lock;
+	/*! Reader counters */
+	epoch_reader_t reader[EPOCH_READER_STRIPES];
+};
+
+/*! File mapped into memory */
+struct fs_map_t {
+	/*! Mapped memory, null if file is empty */
+	void* data;
+	/*! Size of file and mapped memory in bytes */
+	size_t size;
+	/*! Open mode */
+	unsigned int mode;
+	/*! File descriptor, or file handle on Windows. -1 if not open */
+	intptr_t file;
+	/*! File mapping handle, only used on Windows */
+	void* mapping;
+};
+
+#define HASHINDEX_MAX_SEGMENTS 48U
+
+/*! Persistent hash index mapping 64-bit keys to 64-bit values in a memory mapped file,
+using linear hashing over buckets of one page each. Bucket pages are allocated in
+segments doubling in size, segment k holding buckets base * 2^(k-1) up to
+base * 2^k. Layout fields reflect the current in-memory state, the file header is only
+updated on commit */
+struct hashindex_t {
+	/*! Mapped file */
+	fs_map_t map;
+	/*! Number of keys */
+	uint64_t count;
+	/*! Number of pages in use */
+	uint64_t num_pages;
+	/*! Number of buckets at level zero, a power of two */
+	uint64_t base;
+	/*! Next bucket to split */
+	uint64_t split;
+	/*! Split pointer of last committed layout */
+	uint64_t committed_split;
+	/*! Sequence number of last written header */
+	uint64_t sequence;
+	/*! Number of times the bucket count has doubled */
+	unsigned int level;
+	/*! Level of last committed layout */
+	unsigned int committed_level;
+	/*! Flag if modified since last commit */
+	bool dirty;
+	/*! First page of each bucket segment */
+	uint64_t segment[HASHINDEX_MAX_SEGMENTS];
+};
+
 /*! Data for a frame in the error context stack */
 struct error_frame_t {
 	/*! Frame description */
@@ -1080,6 +1641,8 @@ struct event_block_t {
 	event_stream_t* stream;
 	/*! Memory buffer holding event data */
 	event_t* events;
+	/*! Number of events with payload references to release */
+	size_t references;
 	/*! Fired state */
 	bool fired;
 };
@@ -1094,6 +1657,65 @@ FOUNDATION_ALIGNED_STRUCT(event_stream_t, 16) {
 	event_block_t block[2];
 	/*! Optional beacon */
 	beacon_t* beacon;
+	/*! Size limit of event blocks, 0 for limit in foundation configuration */
+	size_t limit;
+	/*! Policy when event block limit is reached */
+	event_overflow_t overflow;
+	/*! Number of times stream has been processed */
+	atomic32_t processed;
+	/*! Number of posting threads blocked waiting for stream to be processed */
+	atomic32_t blocked;
+	/*! Mutex signalled when stream is processed, used with blocking overflow policy */
+	mutex_t* signal;
+	/*! Number of dropped events */
+	atomic64_t dropped;
+	/*! Number of coalesced events */
+	atomic64_t coalesced;
+};
+
+/*! Event id filter in a broadcast event stream, mapping an event id to the
+subscribers receiving events with the id */
+struct event_filter_t {
+	/*! Event id */
+	unsigned int id;
+	/*! Mask of subscribers receiving events with the id */
+	uint64_t mask;
+};
+
+/*! Subscriber reading events from a broadcast event stream, with a read cursor
+over the event blocks shared with other subscribers */
+struct event_subscriber_t {
+	/*! Broadcast event stream, null if subscriber is not in use */
+	event_broadcast_t* broadcast;
+	/*! Subscriber mask bit */
+	uint64_t mask;
+	/*! First event block not yet released by subscriber */
+	event_broadcast_block_t* cursor;
+	/*! Last event block to process, null if no event blocks to process */
+	event_broadcast_block_t* end;
+	/*! Event block holding current event during processing */
+	event_broadcast_block_t* current;
+	/*! Optional beacon */
+	beacon_t* beacon;
+};
+
+/*! Broadcast event stream storing each event once, in event blocks shared by all
+subscribers and released when all subscribers have processed them */
+struct event_broadcast_t {
+	/*! Lock for posting events and changing subscriptions */
+	atomic32_t lock;
+	/*! Event block receiving posted events */
+	event_broadcast_block_t* write;
+	/*! Mask of active subscribers */
+	uint64_t active;
+	/*! Mask of subscribers receiving all events */
+	uint64_t all;
+	/*! Mask of subscribers with a beacon to fire on next matching event */
+	uint64_t beacons;
+	/*! Event id filters, sorted by id */
+	event_filter_t* filter;
+	/*! Subscribers */
+	event_subscriber_t subscriber[EVENT_BROADCAST_MAX_SUBSCRIBERS];
 };
 
 /*! Payload layout for a file system event */
@@ -1141,6 +1763,127 @@ struct hashmap_fixed_t {
 	FOUNDATION_DECLARE_HASHMAP(13);
 };
 
+/*! Single entry in a concurrent hash map table, a null value marks an empty entry */
+struct hashmap_concurrent_entry_t {
+	/*! Key */
+	atomic64_t key;
+	/*! Value */
+	atomicptr_t value;
+};
+
+/*! Open addressing table in a concurrent hash map shard. Tables replaced by growth are
+kept until the map is finalized since lock free readers might still access them */
+struct hashmap_concurrent_table_t {
+	/*! Previous table replaced by this table */
+	hashmap_concurrent_table_t* retired;
+	/*! Number of entries, power of two */
+	size_t capacity;
+	/*! Entries */
+	hashmap_concurrent_entry_t entries[FOUNDATION_FLEXIBLE_ARRAY];
+};
+
+/*! Shard in a concurrent hash map, with a writer lock and a sequence counter letting
+readers detect concurrent modification and retry */
+FOUNDATION_ALIGNED_STRUCT(hashmap_concurrent_shard_t, 64) {
+	/*! Sequence counter, odd while the shard is being modified */
+	atomic32_t sequence;
+	/*! Writer lock */
+	atomic32_t lock;
+	/*! Current table */
+	atomicptr_t table;
+	/*! Number of stored entries */
+	size_t count;
+};
+
+#define SKIPLIST_MAX_HEIGHT     16U
+
+/*! Node in a lock free skiplist. The low bit of a next pointer marks the node as erased
+on that level, which freezes the pointer */
+struct skiplist_node_t {
+	/*! Key */
+	uint64_t key;
+	/*! Value */
+	atomic64_t value;
+	/*! References held by the list and by the inserting thread until all levels are linked */
+	atomic32_t ref;
+	/*! Number of levels */
+	uint32_t height;
+	/*! Next node in retired or free list */
+	skiplist_node_t* retired;
+	/*! Next node on each level */
+	atomicptr_t next[FOUNDATION_FLEXIBLE_ARRAY];
+};
+
+/*! Lock free skiplist mapping 64-bit keys to 64-bit values. Nodes are carved from slabs
+with one free list per node height. Erased nodes are reclaimed with epochs, a node
+retired in one epoch is returned to the free list once no operation started in that
+epoch or earlier is still running */
+struct skiplist_t {
+	/*! Head node with maximum height */
+	skiplist_node_t* head;
+	/*! Number of keys */
+	atomic64_t size;
+	/*! Current epoch */
+	atomic32_t epoch;
+	/*! Reclamation lock */
+	atomic32_t reclaim;
+	/*! Number of retired nodes not yet reclaimed */
+	atomic32_t num_retired;
+	/*! Retired nodes for even and odd epochs */
+	atomicptr_t retired[2];
+	/*! Free nodes for each node height */
+	atomicptr_t free[SKIPLIST_MAX_HEIGHT];
+	/*! Allocated slabs, linked through the first pointer in each slab */
+	atomicptr_t slab;
+	/*! Reader counters */
+	epoch_reader_t reader[EPOCH_READER_STRIPES];
+};
+
+/*! Slot in a string keyed hash map, referencing the key stored in the key arena */
+struct stringmap_slot_t {
+	/*! Full hash of key */
+	hash_t hash;
+	/*! Offset of key in key arena */
+	uint32_t offset;
+	/*! Length of key */
+	uint32_t length;
+	/*! Value */
+	void* value;
+};
+
+/*! String keyed hash map. Slots are arranged in groups of 16 with one control byte per
+slot holding a 7-bit tag of the key hash, allowing all slots in a group to be matched
+in one vector compare. Keys are copied to an arena and compared in full on tag match */
+struct stringmap_t {
+	/*! Number of slot groups, power of two */
+	size_t num_groups;
+	/*! Number of stored keys */
+	size_t count;
+	/*! Number of erased slots not yet reclaimed, including slots marked empty */
+	size_t deleted;
+	/*! Control bytes, one per slot */
+	uint8_t* control;
+	/*! Slots */
+	stringmap_slot_t* slot;
+	/*! Key arena */
+	char* arena;
+	/*! Used bytes in key arena */
+	size_t arena_used;
+	/*! Bytes of erased keys in key arena not yet reclaimed */
+	size_t arena_dead;
+	/*! Capacity of key arena */
+	size_t arena_capacity;
+};
+
+/*! Concurrent hash map, mapping hash values to data pointers. The key space is split
+into shards, each guarded by a writer lock while readers are lock free */
+struct hashmap_concurrent_t {
+	/*! Number of shards, power of two */
+	size_t num_shards;
+	/*! Shards */
+	hashmap_concurrent_shard_t* shard;
+};
+
 /*! Node in 32-bit hash table holding key and value for a single node. */
 FOUNDATION_ALIGNED_STRUCT(hashtable32_entry_t, 8) {
 	/*! Hash key for node in hash table */
@@ -1154,6 +1897,30 @@ FOUNDATION_ALIGNED_STRUCT(hashtable32_entry_t, 8) {
 FOUNDATION_ALIGNED_STRUCT(hashtable64_entry_t, 8) {
 	/*! Hash key for node in hash table. */
 	atomic64_t key;
+	/*! Value for the corresponding hash key. If the value is zero the node is
+	    considered unused/erased. */
+	atomic64_t value;
+};
+
+/*! Tracker of the keys with the highest counts. Counts for all keys are kept in a hash
+table and are authoritative, the tracked set only holds keys and is updated with a compare
+and swap when a key count passes the lowest tracked count. */
+FOUNDATION_ALIGNED_STRUCT(hashtable64_topk_t, 8) {
+	/*! Hash table holding the count of every key */
+	hashtable64_t* counts;
+	/*! Lowest count in the tracked set, keys with lower or equal counts skip the set */
+	atomic64_t threshold;
+	/*! Number of keys tracked */
+	size_t k;
+	/*! Tracked keys, zero for unused slots */
+	atomic64_t* keys;
+};
+
+/*! Node in 128-bit key hash table holding key and value for a single node. Aligned
+to 16 bytes to allow the key to be published with a single 16-byte compare-and-swap. */
+FOUNDATION_ALIGNED_STRUCT(hashtable128_entry_t, 16) {
+	/*! Hash key for node in hash table, as low and high 64-bit words. */
+	atomic64_t key[2];
 	/*! Value for the corresponding hash key. If the value is zero the node is
 	    considered unused/erased. */
 	uint64_t value;
@@ -1193,6 +1960,21 @@ FOUNDATION_ALIGNED_STRUCT(hashtable64_t, 8) {
 	FOUNDATION_DECLARE_HASHTABLE64(FOUNDATION_FLEXIBLE_ARRAY);
 };
 
+/*! Hash table, a lock free mapping of 128-bit values to 64-bit integer data. */
+FOUNDATION_ALIGNED_STRUCT(hashtable128_t, 16) {
+	/*! Number of nodes in the table, i.e maximum number of key-value pairs that
+	    can be stored. */
+	size_t capacity;
+	/*! Sequence counter guarding key publication on platforms without a 16-byte
+	    compare-and-swap, odd while a key is being written */
+	atomic32_t sequence;
+	/*! Lock serializing key publication on platforms without a 16-byte
+	    compare-and-swap */
+	atomic32_t lock;
+	/*! Hash table storage as array of nodes where each node is a key-value pair. */
+	hashtable128_entry_t entries[FOUNDATION_FLEXIBLE_ARRAY];
+};
+
 /*! Memory context stack */
 struct memory_context_t {
 	/*! Current depth of memory context stack */
@@ -1241,6 +2023,7 @@ FOUNDATION_ALIGNED_STRUCT(object_base_t, 8) {
 	uint64_t id_max; \
 	uint64_t mask_index; \
 	uint64_t mask_id; \
+	atomic64_t* occupied; \
 	void* map[mapsize]
 
 /*! Object map which maps object handles to object pointers. As object lifetime is managed
@@ -1269,6 +2052,9 @@ FOUNDATION_ALIGNED_STRUCT(objectmap_t, 8) {
 	\var mask_id
 	Bitmask for ID
 
+	\var occupied
+	Bitmap of slots holding an object, one bit per slot
+
 	\var map
 	Slot array
 	*/
@@ -1496,6 +2282,55 @@ struct thread_t {
 	char namebuffer[32];
 };
 
+/*! Segment file in a write-ahead log, mapped into memory */
+struct wal_segment_t {
+	/*! Mapped segment file */
+	fs_map_t map;
+	/*! Sequence number of first record in segment */
+	uint64_t first;
+	/*! Number of bytes written */
+	size_t written;
+	/*! Number of bytes flushed to storage */
+	size_t synced;
+};
+
+/*! Waiter for durability of a write-ahead log record */
+struct wal_waiter_t {
+	/*! Sequence number waited for */
+	uint64_t sequence;
+	/*! Beacon to fire when record is durable */
+	beacon_t* beacon;
+};
+
+/*! Write-ahead log appending records to segment files, with a commit thread
+flushing records to storage in batches */
+struct wal_t {
+	/*! Directory of segment files */
+	string_t path;
+	/*! Size of segment files */
+	size_t segment_size;
+	/*! Lock protecting segments, sequence and waiters */
+	mutex_t* lock;
+	/*! Commit thread */
+	thread_t thread;
+	/*! Flag to stop commit thread */
+	atomic32_t stop;
+	/*! Flag if a commit has been requested */
+	atomic32_t requested;
+	/*! Sequence number of last durable record */
+	atomic64_t durable;
+	/*! Sequence number of last appended record */
+	uint64_t sequence;
+	/*! Number of flushes to storage */
+	uint64_t flushes;
+	/*! Flag if flushing to storage failed */
+	bool failed;
+	/*! Open segments, last segment is current and others are waiting to be flushed */
+	wal_segment_t* segment;
+	/*! Waiters for durability */
+	wal_waiter_t* waiter;
+};
+
 /*! Declares the base stream data layout. Stream structures should be 8-byte align for
 platform compatibility. Use the macro as first declaration in a stream struct:
 <code>typedef FOUNDATION_ALIGNED_STRUCT(my_stream_t, 8)
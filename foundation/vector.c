@@ -0,0 +1,109 @@
+/* vector.c  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+
+void
+matrix4_transform_array(const matrix4_t* m, vector4_t* dst, const vector4_t* src, size_t count) {
+	//Local copy lets the rows stay in registers, stores to dst could otherwise alias the matrix
+	const matrix4_t mat = *m;
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		vector4_t v0 = vector4_transform(src[i], &mat);
+		vector4_t v1 = vector4_transform(src[i + 1], &mat);
+		vector4_t v2 = vector4_transform(src[i + 2], &mat);
+		vector4_t v3 = vector4_transform(src[i + 3], &mat);
+		dst[i] = v0;
+		dst[i + 1] = v1;
+		dst[i + 2] = v2;
+		dst[i + 3] = v3;
+	}
+	for (; i < count; ++i)
+		dst[i] = vector4_transform(src[i], &mat);
+}
+
+static void
+_matrix4_transform_points_scalar(const float32_t* mat, float32_t* dst, const float32_t* src,
+                                 size_t count) {
+	size_t i;
+	for (i = 0; i < count; ++i, src += 3, dst += 3) {
+		float32_t x = src[0], y = src[1], z = src[2];
+		dst[0] = x * mat[0] + y * mat[4] + z * mat[8] + mat[12];
+		dst[1] = x * mat[1] + y * mat[5] + z * mat[9] + mat[13];
+		dst[2] = x * mat[2] + y * mat[6] + z * mat[10] + mat[14];
+	}
+}
+
+void
+matrix4_transform_points(const matrix4_t* m, float32_t* dst, const float32_t* src, size_t count) {
+	FOUNDATION_ALIGN(16) float32_t mat[16];
+	size_t i = 0;
+
+	matrix4_store(mat, m);
+
+#if FOUNDATION_ARCH_SSE2
+	{
+		//Four points are loaded as three vectors, deinterleaved into x, y and z
+		//vectors, transformed and interleaved back
+		const __m128 m00 = _mm_set1_ps(mat[0]), m01 = _mm_set1_ps(mat[1]), m02 = _mm_set1_ps(mat[2]);
+		const __m128 m10 = _mm_set1_ps(mat[4]), m11 = _mm_set1_ps(mat[5]), m12 = _mm_set1_ps(mat[6]);
+		const __m128 m20 = _mm_set1_ps(mat[8]), m21 = _mm_set1_ps(mat[9]), m22 = _mm_set1_ps(mat[10]);
+		const __m128 m30 = _mm_set1_ps(mat[12]), m31 = _mm_set1_ps(mat[13]), m32 = _mm_set1_ps(mat[14]);
+		for (; i + 4 <= count; i += 4, src += 12, dst += 12) {
+			__m128 a = _mm_loadu_ps(src);
+			__m128 b = _mm_loadu_ps(src + 4);
+			__m128 c = _mm_loadu_ps(src + 8);
+			__m128 x, y, z, ox, oy, oz, t, u;
+
+			t = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+			x = _mm_shuffle_ps(a, t, _MM_SHUFFLE(2, 0, 3, 0));
+			t = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+			u = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+			y = _mm_shuffle_ps(t, u, _MM_SHUFFLE(2, 0, 2, 0));
+			t = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+			u = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0));
+			z = _mm_shuffle_ps(t, u, _MM_SHUFFLE(2, 0, 2, 0));
+
+			ox = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m00), _mm_mul_ps(y, m10)), _mm_add_ps(_mm_mul_ps(z, m20), m30));
+			oy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m01), _mm_mul_ps(y, m11)), _mm_add_ps(_mm_mul_ps(z, m21), m31));
+			oz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m02), _mm_mul_ps(y, m12)), _mm_add_ps(_mm_mul_ps(z, m22), m32));
+
+			t = _mm_shuffle_ps(ox, oy, _MM_SHUFFLE(0, 0, 0, 0));
+			u = _mm_shuffle_ps(oz, ox, _MM_SHUFFLE(1, 1, 0, 0));
+			_mm_storeu_ps(dst, _mm_shuffle_ps(t, u, _MM_SHUFFLE(2, 0, 2, 0)));
+			t = _mm_shuffle_ps(oy, oz, _MM_SHUFFLE(1, 1, 1, 1));
+			u = _mm_shuffle_ps(ox, oy, _MM_SHUFFLE(2, 2, 2, 2));
+			_mm_storeu_ps(dst + 4, _mm_shuffle_ps(t, u, _MM_SHUFFLE(2, 0, 2, 0)));
+			t = _mm_shuffle_ps(oz, ox, _MM_SHUFFLE(3, 3, 2, 2));
+			u = _mm_shuffle_ps(oy, oz, _MM_SHUFFLE(3, 3, 3, 3));
+			_mm_storeu_ps(dst + 8, _mm_shuffle_ps(t, u, _MM_SHUFFLE(2, 0, 2, 0)));
+		}
+	}
+#elif FOUNDATION_ARCH_NEON
+	{
+		const float32x4_t m00 = vdupq_n_f32(mat[0]), m01 = vdupq_n_f32(mat[1]), m02 = vdupq_n_f32(mat[2]);
+		const float32x4_t m10 = vdupq_n_f32(mat[4]), m11 = vdupq_n_f32(mat[5]), m12 = vdupq_n_f32(mat[6]);
+		const float32x4_t m20 = vdupq_n_f32(mat[8]), m21 = vdupq_n_f32(mat[9]), m22 = vdupq_n_f32(mat[10]);
+		const float32x4_t m30 = vdupq_n_f32(mat[12]), m31 = vdupq_n_f32(mat[13]), m32 = vdupq_n_f32(mat[14]);
+		for (; i + 4 <= count; i += 4, src += 12, dst += 12) {
+			float32x4x3_t p = vld3q_f32(src);
+			float32x4x3_t o;
+			o.val[0] = vmlaq_f32(vmlaq_f32(vmlaq_f32(m30, p.val[0], m00), p.val[1], m10), p.val[2], m20);
+			o.val[1] = vmlaq_f32(vmlaq_f32(vmlaq_f32(m31, p.val[0], m01), p.val[1], m11), p.val[2], m21);
+			o.val[2] = vmlaq_f32(vmlaq_f32(vmlaq_f32(m32, p.val[0], m02), p.val[1], m12), p.val[2], m22);
+			vst3q_f32(dst, o);
+		}
+	}
+#endif
+
+	_matrix4_transform_points_scalar(mat, dst, src, count - i);
+}
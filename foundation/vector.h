@@ -0,0 +1,926 @@
+/* vector.h  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#pragma once
+
+/*! \file vector.h
+\brief Vector, quaternion and matrix math
+
+Four component vector, rotation quaternion and 4x4 matrix types backed by SSE2 or NEON
+registers, with a scalar fallback on other architectures. Vectors are passed by value,
+matrices by pointer.
+
+Vectors are row vectors and are transformed by multiplying on the left side of a
+matrix, v' = v * M. Concatenating transforms with #matrix4_mul(a, b) gives a matrix
+applying a first and then b. Quaternions store the vector part in the x, y and z
+components and the scalar part in the w component. */
+
+#include <foundation/platform.h>
+#include <foundation/types.h>
+#include <foundation/math.h>
+
+/*! Construct vector from components
+\param x X component
+\param y Y component
+\param z Z component
+\param w W component
+\return Vector */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4(float32_t x, float32_t y, float32_t z, float32_t w);
+
+/*! Vector with all components zero
+\return Zero vector */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_zero(void);
+
+/*! Vector with all components set to the same value
+\param val Component value
+\return Vector */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_splat(float32_t val);
+
+/*! Load vector from 16 byte aligned memory
+\param data Pointer to four 16 byte aligned values
+\return Vector */
+static FOUNDATION_FORCEINLINE FOUNDATION_PURECALL vector4_t
+vector4_load(const float32_t* data);
+
+/*! Load vector from unaligned memory
+\param data Pointer to four values
+\return Vector */
+static FOUNDATION_FORCEINLINE FOUNDATION_PURECALL vector4_t
+vector4_loadu(const float32_t* data);
+
+/*! Store vector to 16 byte aligned memory
+\param data Pointer to storage for four 16 byte aligned values
+\param v Vector */
+static FOUNDATION_FORCEINLINE void
+vector4_store(float32_t* data, vector4_t v);
+
+/*! Store vector to unaligned memory
+\param data Pointer to storage for four values
+\param v Vector */
+static FOUNDATION_FORCEINLINE void
+vector4_storeu(float32_t* data, vector4_t v);
+
+/*! Get x component
+\param v Vector
+\return X component */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_x(vector4_t v);
+
+/*! Get y component
+\param v Vector
+\return Y component */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_y(vector4_t v);
+
+/*! Get z component
+\param v Vector
+\return Z component */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_z(vector4_t v);
+
+/*! Get w component
+\param v Vector
+\return W component */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_w(vector4_t v);
+
+/*! Component-wise addition
+\param a First vector
+\param b Second vector
+\return a + b */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_add(vector4_t a, vector4_t b);
+
+/*! Component-wise subtraction
+\param a First vector
+\param b Second vector
+\return a - b */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_sub(vector4_t a, vector4_t b);
+
+/*! Component-wise multiplication
+\param a First vector
+\param b Second vector
+\return a * b */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_mul(vector4_t a, vector4_t b);
+
+/*! Component-wise division
+\param a First vector
+\param b Second vector
+\return a / b */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_div(vector4_t a, vector4_t b);
+
+/*! Multiply all components with a scalar
+\param v Vector
+\param s Scalar
+\return v * s */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_scale(vector4_t v, float32_t s);
+
+/*! Component-wise multiply and add
+\param a First vector
+\param b Second vector
+\param c Third vector
+\return a * b + c */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_madd(vector4_t a, vector4_t b, vector4_t c);
+
+/*! Negate all components
+\param v Vector
+\return -v */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_neg(vector4_t v);
+
+/*! Component-wise minimum
+\param a First vector
+\param b Second vector
+\return Vector of smallest components */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_min(vector4_t a, vector4_t b);
+
+/*! Component-wise maximum
+\param a First vector
+\param b Second vector
+\return Vector of largest components */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_max(vector4_t a, vector4_t b);
+
+/*! Four component dot product
+\param a First vector
+\param b Second vector
+\return Dot product */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_dot(vector4_t a, vector4_t b);
+
+/*! Three component dot product, ignoring the w components
+\param a First vector
+\param b Second vector
+\return Dot product of x, y and z components */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_dot3(vector4_t a, vector4_t b);
+
+/*! Three component cross product of the x, y and z components. The w component
+of the result is zero.
+\param a First vector
+\param b Second vector
+\return Cross product a x b */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_cross3(vector4_t a, vector4_t b);
+
+/*! Four component length
+\param v Vector
+\return Length of vector */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_length(vector4_t v);
+
+/*! Squared four component length
+\param v Vector
+\return Squared length of vector */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_length_sqr(vector4_t v);
+
+/*! Normalize using all four components. Uses the reciprocal square root estimate
+refined with a Newton-Raphson step, giving a relative length error below 1e-6.
+The vector must not be zero.
+\param v Vector
+\return Unit length vector */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_normalize(vector4_t v);
+
+/*! Normalize the x, y and z components and set w to zero. Uses the reciprocal
+square root estimate refined with a Newton-Raphson step, giving a relative length
+error below 1e-6. The vector part must not be zero.
+\param v Vector
+\return Unit length direction vector */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_normalize3(vector4_t v);
+
+/*! Transform vector by matrix, v' = v * m
+\param v Vector
+\param m Matrix
+\return Transformed vector */
+static FOUNDATION_FORCEINLINE FOUNDATION_PURECALL vector4_t
+vector4_transform(vector4_t v, const matrix4_t* m);
+
+/*! Identity quaternion, representing no rotation
+\return Identity quaternion */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL quaternion_t
+quaternion_identity(void);
+
+/*! Construct rotation quaternion from axis and angle
+\param axis Unit length rotation axis in the x, y and z components
+\param angle Rotation angle in radians
+\return Unit quaternion */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL quaternion_t
+quaternion_from_axis_angle(vector4_t axis, float32_t angle);
+
+/*! Quaternion product. The resulting rotation applies b first and then a.
+\param a First quaternion
+\param b Second quaternion
+\return Product a * b */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL quaternion_t
+quaternion_mul(quaternion_t a, quaternion_t b);
+
+/*! Quaternion conjugate, the inverse rotation of a unit quaternion
+\param q Quaternion
+\return Conjugate quaternion */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL quaternion_t
+quaternion_conjugate(quaternion_t q);
+
+/*! Quaternion inverse
+\param q Non-zero quaternion
+\return Inverse quaternion */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL quaternion_t
+quaternion_inverse(quaternion_t q);
+
+/*! Normalize quaternion to unit length
+\param q Non-zero quaternion
+\return Unit quaternion */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL quaternion_t
+quaternion_normalize(quaternion_t q);
+
+/*! Rotate the x, y and z components of a vector by a unit quaternion. The w
+component is preserved.
+\param q Unit quaternion
+\param v Vector
+\return Rotated vector */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+quaternion_rotate(quaternion_t q, vector4_t v);
+
+/*! Identity matrix
+\return Identity matrix */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL matrix4_t
+matrix4_identity(void);
+
+/*! Load matrix from 16 byte aligned memory in row order
+\param data Pointer to sixteen 16 byte aligned values
+\return Matrix */
+static FOUNDATION_FORCEINLINE FOUNDATION_PURECALL matrix4_t
+matrix4_load(const float32_t* data);
+
+/*! Store matrix to 16 byte aligned memory in row order
+\param data Pointer to storage for sixteen 16 byte aligned values
+\param m Matrix */
+static FOUNDATION_FORCEINLINE void
+matrix4_store(float32_t* data, const matrix4_t* m);
+
+/*! Translation matrix
+\param translation Translation in the x, y and z components
+\return Matrix */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL matrix4_t
+matrix4_translation(vector4_t translation);
+
+/*! Rotation matrix from unit quaternion
+\param q Unit quaternion
+\return Matrix */
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL matrix4_t
+matrix4_from_quaternion(quaternion_t q);
+
+/*! Matrix product. Transforming by the result is equal to transforming by a
+and then by b.
+\param a First matrix
+\param b Second matrix
+\return Product a * b */
+static FOUNDATION_FORCEINLINE FOUNDATION_PURECALL matrix4_t
+matrix4_mul(const matrix4_t* a, const matrix4_t* b);
+
+/*! Matrix transpose
+\param m Matrix
+\return Transposed matrix */
+static FOUNDATION_FORCEINLINE FOUNDATION_PURECALL matrix4_t
+matrix4_transpose(const matrix4_t* m);
+
+/*! Transform an array of vectors by a matrix, dst[i] = src[i] * m. Source and
+destination may be the same array.
+\param m Matrix
+\param dst Destination vector array
+\param src Source vector array
+\param count Number of vectors */
+FOUNDATION_API void
+matrix4_transform_array(const matrix4_t* m, vector4_t* dst, const vector4_t* src, size_t count);
+
+/*! Transform an array of tightly packed three component points by a matrix. The
+points are treated as having w equal to one and the resulting w is discarded, so
+no perspective division is made. Source and destination may be the same array.
+\param m Matrix
+\param dst Destination array of 3 * count values
+\param src Source array of 3 * count values
+\param count Number of points */
+FOUNDATION_API void
+matrix4_transform_points(const matrix4_t* m, float32_t* dst, const float32_t* src, size_t count);
+
+// Implementation
+
+#if FOUNDATION_ARCH_SSE2
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4(float32_t x, float32_t y, float32_t z, float32_t w) {
+	return _mm_setr_ps(x, y, z, w);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_zero(void) {
+	return _mm_setzero_ps();
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_splat(float32_t val) {
+	return _mm_set1_ps(val);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_PURECALL vector4_t
+vector4_load(const float32_t* data) {
+	return _mm_load_ps(data);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_PURECALL vector4_t
+vector4_loadu(const float32_t* data) {
+	return _mm_loadu_ps(data);
+}
+
+static FOUNDATION_FORCEINLINE void
+vector4_store(float32_t* data, vector4_t v) {
+	_mm_store_ps(data, v);
+}
+
+static FOUNDATION_FORCEINLINE void
+vector4_storeu(float32_t* data, vector4_t v) {
+	_mm_storeu_ps(data, v);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_x(vector4_t v) {
+	return _mm_cvtss_f32(v);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_y(vector4_t v) {
+	return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_z(vector4_t v) {
+	return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)));
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_w(vector4_t v) {
+	return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)));
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_add(vector4_t a, vector4_t b) {
+	return _mm_add_ps(a, b);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_sub(vector4_t a, vector4_t b) {
+	return _mm_sub_ps(a, b);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_mul(vector4_t a, vector4_t b) {
+	return _mm_mul_ps(a, b);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_div(vector4_t a, vector4_t b) {
+	return _mm_div_ps(a, b);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_neg(vector4_t v) {
+	return _mm_xor_ps(v, _mm_set1_ps(-0.0f));
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_min(vector4_t a, vector4_t b) {
+	return _mm_min_ps(a, b);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_max(vector4_t a, vector4_t b) {
+	return _mm_max_ps(a, b);
+}
+
+#define _vector4_splat_x(v) _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0))
+#define _vector4_splat_y(v) _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))
+#define _vector4_splat_z(v) _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))
+#define _vector4_splat_w(v) _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+_vector4_hsum(vector4_t v) {
+	v = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+_vector4_mask3(vector4_t v) {
+	return _mm_and_ps(v, _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0)));
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+_vector4_rsqrt(vector4_t v) {
+	//Estimate has 12 bits of precision, one Newton-Raphson step brings it to ~22 bits
+	vector4_t est = _mm_rsqrt_ps(v);
+	vector4_t half = _mm_mul_ps(v, _mm_set1_ps(0.5f));
+	return _mm_mul_ps(est, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(half, _mm_mul_ps(est, est))));
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_cross3(vector4_t a, vector4_t b) {
+	vector4_t a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+	vector4_t b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+	vector4_t c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+	return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL quaternion_t
+quaternion_mul(quaternion_t a, quaternion_t b) {
+	const vector4_t sign_x = _mm_setr_ps(1.0f, -1.0f, 1.0f, -1.0f);
+	const vector4_t sign_y = _mm_setr_ps(1.0f, 1.0f, -1.0f, -1.0f);
+	const vector4_t sign_z = _mm_setr_ps(-1.0f, 1.0f, 1.0f, -1.0f);
+	vector4_t r = _mm_mul_ps(_vector4_splat_w(a), b);
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(_vector4_splat_x(a),
+	                                        _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 1, 2, 3))), sign_x));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(_vector4_splat_y(a),
+	                                        _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2))), sign_y));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(_vector4_splat_z(a),
+	                                        _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1))), sign_z));
+	return r;
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL quaternion_t
+quaternion_conjugate(quaternion_t q) {
+	return _mm_xor_ps(q, _mm_setr_ps(-0.0f, -0.0f, -0.0f, 0.0f));
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_PURECALL matrix4_t
+matrix4_transpose(const matrix4_t* m) {
+	matrix4_t t = *m;
+	_MM_TRANSPOSE4_PS(t.row[0], t.row[1], t.row[2], t.row[3]);
+	return t;
+}
+
+#elif FOUNDATION_ARCH_NEON
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4(float32_t x, float32_t y, float32_t z, float32_t w) {
+	FOUNDATION_ALIGN(16) float32_t data[4] = {x, y, z, w};
+	return vld1q_f32(data);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_zero(void) {
+	return vdupq_n_f32(0.0f);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_splat(float32_t val) {
+	return vdupq_n_f32(val);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_PURECALL vector4_t
+vector4_load(const float32_t* data) {
+	return vld1q_f32(data);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_PURECALL vector4_t
+vector4_loadu(const float32_t* data) {
+	return vld1q_f32(data);
+}
+
+static FOUNDATION_FORCEINLINE void
+vector4_store(float32_t* data, vector4_t v) {
+	vst1q_f32(data, v);
+}
+
+static FOUNDATION_FORCEINLINE void
+vector4_storeu(float32_t* data, vector4_t v) {
+	vst1q_f32(data, v);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_x(vector4_t v) {
+	return vgetq_lane_f32(v, 0);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_y(vector4_t v) {
+	return vgetq_lane_f32(v, 1);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_z(vector4_t v) {
+	return vgetq_lane_f32(v, 2);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_w(vector4_t v) {
+	return vgetq_lane_f32(v, 3);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_add(vector4_t a, vector4_t b) {
+	return vaddq_f32(a, b);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_sub(vector4_t a, vector4_t b) {
+	return vsubq_f32(a, b);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_mul(vector4_t a, vector4_t b) {
+	return vmulq_f32(a, b);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_div(vector4_t a, vector4_t b) {
+	//Reciprocal estimate refined with two Newton-Raphson steps
+	vector4_t rcp = vrecpeq_f32(b);
+	rcp = vmulq_f32(vrecpsq_f32(b, rcp), rcp);
+	rcp = vmulq_f32(vrecpsq_f32(b, rcp), rcp);
+	return vmulq_f32(a, rcp);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_neg(vector4_t v) {
+	return vnegq_f32(v);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_min(vector4_t a, vector4_t b) {
+	return vminq_f32(a, b);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_max(vector4_t a, vector4_t b) {
+	return vmaxq_f32(a, b);
+}
+
+#define _vector4_splat_x(v) vdupq_lane_f32(vget_low_f32(v), 0)
+#define _vector4_splat_y(v) vdupq_lane_f32(vget_low_f32(v), 1)
+#define _vector4_splat_z(v) vdupq_lane_f32(vget_high_f32(v), 0)
+#define _vector4_splat_w(v) vdupq_lane_f32(vget_high_f32(v), 1)
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+_vector4_hsum(vector4_t v) {
+	float32x2_t sum = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+	sum = vpadd_f32(sum, sum);
+	return vcombine_f32(sum, sum);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+_vector4_mask3(vector4_t v) {
+	return vsetq_lane_f32(0.0f, v, 3);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+_vector4_rsqrt(vector4_t v) {
+	//Estimate has 8 bits of precision, two Newton-Raphson steps bring it to ~22 bits
+	vector4_t est = vrsqrteq_f32(v);
+	est = vmulq_f32(est, vrsqrtsq_f32(vmulq_f32(v, est), est));
+	return vmulq_f32(est, vrsqrtsq_f32(vmulq_f32(v, est), est));
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_cross3(vector4_t a, vector4_t b) {
+	float32_t ax = vgetq_lane_f32(a, 0), ay = vgetq_lane_f32(a, 1), az = vgetq_lane_f32(a, 2);
+	float32_t bx = vgetq_lane_f32(b, 0), by = vgetq_lane_f32(b, 1), bz = vgetq_lane_f32(b, 2);
+	return vector4(ay * bz - az * by, az * bx - ax * bz, ax * by - ay * bx, 0.0f);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL quaternion_t
+quaternion_mul(quaternion_t a, quaternion_t b) {
+	float32_t ax = vgetq_lane_f32(a, 0), ay = vgetq_lane_f32(a, 1);
+	float32_t az = vgetq_lane_f32(a, 2), aw = vgetq_lane_f32(a, 3);
+	float32_t bx = vgetq_lane_f32(b, 0), by = vgetq_lane_f32(b, 1);
+	float32_t bz = vgetq_lane_f32(b, 2), bw = vgetq_lane_f32(b, 3);
+	return vector4(aw * bx + ax * bw + ay * bz - az * by,
+	               aw * by - ax * bz + ay * bw + az * bx,
+	               aw * bz + ax * by - ay * bx + az * bw,
+	               aw * bw - ax * bx - ay * by - az * bz);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL quaternion_t
+quaternion_conjugate(quaternion_t q) {
+	return vsetq_lane_f32(vgetq_lane_f32(q, 3), vnegq_f32(q), 3);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_PURECALL matrix4_t
+matrix4_transpose(const matrix4_t* m) {
+	matrix4_t t;
+	float32x4x2_t r01 = vtrnq_f32(m->row[0], m->row[1]);
+	float32x4x2_t r23 = vtrnq_f32(m->row[2], m->row[3]);
+	t.row[0] = vcombine_f32(vget_low_f32(r01.val[0]), vget_low_f32(r23.val[0]));
+	t.row[1] = vcombine_f32(vget_low_f32(r01.val[1]), vget_low_f32(r23.val[1]));
+	t.row[2] = vcombine_f32(vget_high_f32(r01.val[0]), vget_high_f32(r23.val[0]));
+	t.row[3] = vcombine_f32(vget_high_f32(r01.val[1]), vget_high_f32(r23.val[1]));
+	return t;
+}
+
+#else
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4(float32_t x, float32_t y, float32_t z, float32_t w) {
+	vector4_t v;
+	v.x = x;
+	v.y = y;
+	v.z = z;
+	v.w = w;
+	return v;
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_zero(void) {
+	return vector4(0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_splat(float32_t val) {
+	return vector4(val, val, val, val);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_PURECALL vector4_t
+vector4_load(const float32_t* data) {
+	return vector4(data[0], data[1], data[2], data[3]);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_PURECALL vector4_t
+vector4_loadu(const float32_t* data) {
+	return vector4(data[0], data[1], data[2], data[3]);
+}
+
+static FOUNDATION_FORCEINLINE void
+vector4_store(float32_t* data, vector4_t v) {
+	data[0] = v.x;
+	data[1] = v.y;
+	data[2] = v.z;
+	data[3] = v.w;
+}
+
+static FOUNDATION_FORCEINLINE void
+vector4_storeu(float32_t* data, vector4_t v) {
+	vector4_store(data, v);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_x(vector4_t v) {
+	return v.x;
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_y(vector4_t v) {
+	return v.y;
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_z(vector4_t v) {
+	return v.z;
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_w(vector4_t v) {
+	return v.w;
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_add(vector4_t a, vector4_t b) {
+	return vector4(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_sub(vector4_t a, vector4_t b) {
+	return vector4(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_mul(vector4_t a, vector4_t b) {
+	return vector4(a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_div(vector4_t a, vector4_t b) {
+	return vector4(a.x / b.x, a.y / b.y, a.z / b.z, a.w / b.w);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_neg(vector4_t v) {
+	return vector4(-v.x, -v.y, -v.z, -v.w);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_min(vector4_t a, vector4_t b) {
+	return vector4(math_min(a.x, b.x), math_min(a.y, b.y), math_min(a.z, b.z), math_min(a.w, b.w));
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_max(vector4_t a, vector4_t b) {
+	return vector4(math_max(a.x, b.x), math_max(a.y, b.y), math_max(a.z, b.z), math_max(a.w, b.w));
+}
+
+#define _vector4_splat_x(v) vector4_splat((v).x)
+#define _vector4_splat_y(v) vector4_splat((v).y)
+#define _vector4_splat_z(v) vector4_splat((v).z)
+#define _vector4_splat_w(v) vector4_splat((v).w)
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+_vector4_hsum(vector4_t v) {
+	return vector4_splat((v.x + v.y) + (v.z + v.w));
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+_vector4_mask3(vector4_t v) {
+	v.w = 0.0f;
+	return v;
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+_vector4_rsqrt(vector4_t v) {
+	return vector4(1.0f / math_sqrt(v.x), 1.0f / math_sqrt(v.y),
+	               1.0f / math_sqrt(v.z), 1.0f / math_sqrt(v.w));
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_cross3(vector4_t a, vector4_t b) {
+	return vector4(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x, 0.0f);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL quaternion_t
+quaternion_mul(quaternion_t a, quaternion_t b) {
+	return vector4(a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+	               a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+	               a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+	               a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL quaternion_t
+quaternion_conjugate(quaternion_t q) {
+	return vector4(-q.x, -q.y, -q.z, q.w);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_PURECALL matrix4_t
+matrix4_transpose(const matrix4_t* m) {
+	matrix4_t t;
+	t.row[0] = vector4(m->row[0].x, m->row[1].x, m->row[2].x, m->row[3].x);
+	t.row[1] = vector4(m->row[0].y, m->row[1].y, m->row[2].y, m->row[3].y);
+	t.row[2] = vector4(m->row[0].z, m->row[1].z, m->row[2].z, m->row[3].z);
+	t.row[3] = vector4(m->row[0].w, m->row[1].w, m->row[2].w, m->row[3].w);
+	return t;
+}
+
+#endif
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_scale(vector4_t v, float32_t s) {
+	return vector4_mul(v, vector4_splat(s));
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_madd(vector4_t a, vector4_t b, vector4_t c) {
+	return vector4_add(vector4_mul(a, b), c);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_dot(vector4_t a, vector4_t b) {
+	return vector4_x(_vector4_hsum(vector4_mul(a, b)));
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_dot3(vector4_t a, vector4_t b) {
+	return vector4_x(_vector4_hsum(_vector4_mask3(vector4_mul(a, b))));
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_length_sqr(vector4_t v) {
+	return vector4_dot(v, v);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL float32_t
+vector4_length(vector4_t v) {
+	return math_sqrt(vector4_dot(v, v));
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_normalize(vector4_t v) {
+	return vector4_mul(v, _vector4_rsqrt(_vector4_hsum(vector4_mul(v, v))));
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+vector4_normalize3(vector4_t v) {
+	v = _vector4_mask3(v);
+	return vector4_mul(v, _vector4_rsqrt(_vector4_hsum(vector4_mul(v, v))));
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_PURECALL vector4_t
+vector4_transform(vector4_t v, const matrix4_t* m) {
+	vector4_t r = vector4_mul(_vector4_splat_x(v), m->row[0]);
+	r = vector4_madd(_vector4_splat_y(v), m->row[1], r);
+	r = vector4_madd(_vector4_splat_z(v), m->row[2], r);
+	return vector4_madd(_vector4_splat_w(v), m->row[3], r);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL quaternion_t
+quaternion_identity(void) {
+	return vector4(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL quaternion_t
+quaternion_from_axis_angle(vector4_t axis, float32_t angle) {
+	float32_t half = angle * 0.5f;
+	float32_t s = (float32_t)math_sin(half);
+	return vector4(vector4_x(axis) * s, vector4_y(axis) * s, vector4_z(axis) * s,
+	               (float32_t)math_cos(half));
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL quaternion_t
+quaternion_inverse(quaternion_t q) {
+	return vector4_div(quaternion_conjugate(q), _vector4_hsum(vector4_mul(q, q)));
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL quaternion_t
+quaternion_normalize(quaternion_t q) {
+	return vector4_normalize(q);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL vector4_t
+quaternion_rotate(quaternion_t q, vector4_t v) {
+	//v' = v + w * t + u x t, where u is the vector part of q and t = 2 (u x v)
+	vector4_t t = vector4_cross3(q, v);
+	t = vector4_add(t, t);
+	return vector4_add(vector4_madd(_vector4_splat_w(q), t, v), vector4_cross3(q, t));
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL matrix4_t
+matrix4_identity(void) {
+	matrix4_t m;
+	m.row[0] = vector4(1.0f, 0.0f, 0.0f, 0.0f);
+	m.row[1] = vector4(0.0f, 1.0f, 0.0f, 0.0f);
+	m.row[2] = vector4(0.0f, 0.0f, 1.0f, 0.0f);
+	m.row[3] = vector4(0.0f, 0.0f, 0.0f, 1.0f);
+	return m;
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_PURECALL matrix4_t
+matrix4_load(const float32_t* data) {
+	matrix4_t m;
+	m.row[0] = vector4_load(data);
+	m.row[1] = vector4_load(data + 4);
+	m.row[2] = vector4_load(data + 8);
+	m.row[3] = vector4_load(data + 12);
+	return m;
+}
+
+static FOUNDATION_FORCEINLINE void
+matrix4_store(float32_t* data, const matrix4_t* m) {
+	vector4_store(data, m->row[0]);
+	vector4_store(data + 4, m->row[1]);
+	vector4_store(data + 8, m->row[2]);
+	vector4_store(data + 12, m->row[3]);
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL matrix4_t
+matrix4_translation(vector4_t translation) {
+	matrix4_t m = matrix4_identity();
+	m.row[3] = vector4(vector4_x(translation), vector4_y(translation), vector4_z(translation), 1.0f);
+	return m;
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_CONSTCALL matrix4_t
+matrix4_from_quaternion(quaternion_t q) {
+	float32_t x = vector4_x(q), y = vector4_y(q), z = vector4_z(q), w = vector4_w(q);
+	float32_t xx = x * x, yy = y * y, zz = z * z;
+	float32_t xy = x * y, xz = x * z, yz = y * z;
+	float32_t wx = w * x, wy = w * y, wz = w * z;
+	matrix4_t m;
+	m.row[0] = vector4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f);
+	m.row[1] = vector4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f);
+	m.row[2] = vector4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f);
+	m.row[3] = vector4(0.0f, 0.0f, 0.0f, 1.0f);
+	return m;
+}
+
+static FOUNDATION_FORCEINLINE FOUNDATION_PURECALL matrix4_t
+matrix4_mul(const matrix4_t* a, const matrix4_t* b) {
+	matrix4_t m;
+	m.row[0] = vector4_transform(a->row[0], b);
+	m.row[1] = vector4_transform(a->row[1], b);
+	m.row[2] = vector4_transform(a->row[2], b);
+	m.row[3] = vector4_transform(a->row[3], b);
+	return m;
+}
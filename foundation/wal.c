@@ -0,0 +1,536 @@
+/* wal.c  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+
+#define WAL_MAGIC            0x474f4c5244414557ULL
+#define WAL_SEGMENT_SIZE     (64 * 1024 * 1024)
+#define WAL_MIN_SEGMENT_SIZE 4096
+//Maximum time in milliseconds appended records wait for a flush without a sync request
+#define WAL_COMMIT_INTERVAL  10
+
+typedef struct wal_header_t wal_header_t;
+typedef struct wal_record_t wal_record_t;
+
+struct wal_header_t {
+	uint64_t magic;
+	//Sequence number of first record
+	uint64_t first;
+	//Sequence number of last record once all records are durable and a following segment
+	//has been started, zero while segment is current
+	uint64_t last;
+};
+
+//Record data follows the header, padded to eight bytes. The checksum covers the sequence
+//number and record data
+struct wal_record_t {
+	uint32_t size;
+	uint32_t checksum;
+	uint64_t sequence;
+};
+
+static FOUNDATION_FORCEINLINE size_t
+_wal_record_size(size_t size) {
+	return (sizeof(wal_record_t) + size + 7) & ~(size_t)7;
+}
+
+static FOUNDATION_FORCEINLINE uint32_t
+_wal_checksum(const wal_record_t* record) {
+	return (uint32_t)hash(&record->sequence, sizeof(uint64_t) + record->size);
+}
+
+static string_t
+_wal_segment_path(char* buffer, size_t capacity, const char* path, size_t length, uint64_t first) {
+	char namebuffer[32];
+	string_t name = string_format(namebuffer, sizeof(namebuffer), STRING_CONST("%016" PRIx64 ".wal"), first);
+	return path_concat(buffer, capacity, path, length, STRING_ARGS(name));
+}
+
+static uint64_t*
+_wal_segments(const char* path, size_t length) {
+	uint64_t* first = nullptr;
+	string_t* files = fs_files(path, length);
+	size_t ifile, isegment, count;
+	for (ifile = 0, count = array_size(files); ifile < count; ++ifile) {
+		uint64_t value;
+		if ((files[ifile].length != 20) || !string_ends_with(STRING_ARGS(files[ifile]), STRING_CONST(".wal")))
+			continue;
+		value = string_to_uint64(files[ifile].str, 16, true);
+		if (value)
+			array_push(first, value);
+	}
+	string_array_deallocate(files);
+
+	//Few segments, order by first sequence number with insertion sort
+	for (isegment = 1, count = array_size(first); isegment < count; ++isegment) {
+		uint64_t value = first[isegment];
+		size_t islot = isegment;
+		while (islot && (first[islot - 1] > value)) {
+			first[islot] = first[islot - 1];
+			--islot;
+		}
+		first[islot] = value;
+	}
+	return first;
+}
+
+static const wal_header_t*
+_wal_header(const fs_map_t* map, uint64_t first) {
+	const wal_header_t* header = map->data;
+	if ((map->size < sizeof(wal_header_t)) || (header->magic != WAL_MAGIC) || (header->first != first))
+		return nullptr;
+	return header;
+}
+
+//Scan records in a segment, returning offset past the last valid record or zero if the
+//segment header is not valid. Stops at first invalid record or if record function
+//returns non-zero
+static size_t
+_wal_scan(const fs_map_t* map, uint64_t first, uint64_t from, wal_record_fn fn, void* context,
+          uint64_t* last, bool* stop) {
+	size_t offset = sizeof(wal_header_t);
+	uint64_t sequence = first;
+	if (!_wal_header(map, first))
+		return 0;
+	while (offset + sizeof(wal_record_t) <= map->size) {
+		const wal_record_t* record = pointer_offset_const(map->data, offset);
+		if ((record->sequence != sequence) || (record->size > map->size - offset - sizeof(wal_record_t)) ||
+		    (record->checksum != _wal_checksum(record)))
+			break;
+		*last = sequence;
+		offset += _wal_record_size(record->size);
+		if (fn && (sequence >= from) && fn(sequence, record + 1, record->size, context)) {
+			*stop = true;
+			break;
+		}
+		++sequence;
+	}
+	return offset;
+}
+
+//Check if a segment was sealed with the given segment as its successor
+static bool
+_wal_sealed(const char* path, size_t length, uint64_t first, uint64_t next) {
+	char buffer[BUILD_MAX_PATHLEN];
+	string_t segpath = _wal_segment_path(buffer, sizeof(buffer), path, length, first);
+	const wal_header_t* header;
+	fs_map_t map;
+	bool sealed;
+	if (!fs_map_file(&map, STRING_ARGS(segpath), STREAM_IN))
+		return false;
+	header = _wal_header(&map, first);
+	sealed = (header && (header->last + 1 == next));
+	fs_unmap_file(&map);
+	return sealed;
+}
+
+static bool
+_wal_create_segment(wal_t* wal, uint64_t first) {
+	char buffer[BUILD_MAX_PATHLEN];
+	string_t path = _wal_segment_path(buffer, sizeof(buffer), STRING_ARGS(wal->path), first);
+	wal_segment_t segment;
+	wal_header_t* header;
+
+	memset(&segment, 0, sizeof(segment));
+	if (!fs_map_file(&segment.map, STRING_ARGS(path), STREAM_IN | STREAM_OUT | STREAM_CREATE | STREAM_TRUNCATE) ||
+	    !fs_map_resize(&segment.map, wal->segment_size)) {
+		log_errorf(0, ERROR_SYSTEM_CALL_FAIL, STRING_CONST("Unable to create write-ahead log segment: %.*s"),
+		           STRING_FORMAT(path));
+		fs_unmap_file(&segment.map);
+		return false;
+	}
+
+	//Persist the directory entry before any record in the segment can be reported durable
+	if (!fs_sync_directory(STRING_ARGS(wal->path))) {
+		log_errorf(0, ERROR_SYSTEM_CALL_FAIL, STRING_CONST("Unable to sync write-ahead log directory: %.*s"),
+		           STRING_FORMAT(wal->path));
+		fs_unmap_file(&segment.map);
+		fs_remove_file(STRING_ARGS(path));
+		return false;
+	}
+
+	header = segment.map.data;
+	header->magic = WAL_MAGIC;
+	header->first = first;
+	header->last = 0;
+	segment.first = first;
+	segment.written = sizeof(wal_header_t);
+	array_push_memcpy(wal->segment, &segment);
+	return true;
+}
+
+static bool
+_wal_open_segment(wal_t* wal, const uint64_t* first, size_t count) {
+	char buffer[BUILD_MAX_PATHLEN];
+	wal_segment_t segment;
+	bool removed = false;
+	memset(&segment, 0, sizeof(segment));
+
+	//Find the last segment holding valid records. A segment is only valid if the previous
+	//segment was sealed, otherwise it was started before all previous records were durable
+	while (count) {
+		string_t path = _wal_segment_path(buffer, sizeof(buffer), STRING_ARGS(wal->path), first[count - 1]);
+		bool valid = false;
+		if (!fs_map_file(&segment.map, STRING_ARGS(path), STREAM_IN | STREAM_OUT)) {
+			log_errorf(0, ERROR_SYSTEM_CALL_FAIL, STRING_CONST("Unable to open write-ahead log segment: %.*s"),
+			           STRING_FORMAT(path));
+			return false;
+		}
+		if (_wal_header(&segment.map, first[count - 1]))
+			valid = (count == 1) || _wal_sealed(STRING_ARGS(wal->path), first[count - 2], first[count - 1]);
+		if (valid)
+			break;
+		fs_unmap_file(&segment.map);
+		if (fs_remove_file(STRING_ARGS(path)))
+			removed = true;
+		--count;
+	}
+
+	//Persist removal of invalid segments, so they cannot reappear after a crash
+	//once new segments with the same names have been created
+	if (removed && !fs_sync_directory(STRING_ARGS(wal->path)))
+		return false;
+
+	if (!count)
+		return _wal_create_segment(wal, 1);
+
+	segment.first = first[count - 1];
+	wal->sequence = segment.first - 1;
+	segment.written = _wal_scan(&segment.map, segment.first, 0, nullptr, nullptr, &wal->sequence, nullptr);
+	segment.synced = segment.written;
+
+	//Drop anything after the last valid record and preallocate the remaining segment
+	if (!fs_map_resize(&segment.map, segment.written) ||
+	    !fs_map_resize(&segment.map, (segment.written > wal->segment_size) ? segment.written : wal->segment_size)) {
+		fs_unmap_file(&segment.map);
+		return false;
+	}
+	((wal_header_t*)segment.map.data)->last = 0;
+	array_push_memcpy(wal->segment, &segment);
+	return true;
+}
+
+static void
+_wal_fire_waiters(wal_t* wal) {
+	uint64_t durable = (uint64_t)atomic_load64(&wal->durable);
+	size_t iwaiter = 0;
+	while (iwaiter < array_size(wal->waiter)) {
+		if (wal->failed || (wal->waiter[iwaiter].sequence <= durable)) {
+			beacon_fire(wal->waiter[iwaiter].beacon);
+			array_erase_memcpy(wal->waiter, iwaiter);
+		} else {
+			++iwaiter;
+		}
+	}
+}
+
+static void
+_wal_commit(wal_t* wal) {
+	uint64_t sequence;
+	size_t count, isegment;
+	size_t written = 0;
+	bool success = true;
+
+	mutex_lock(wal->lock);
+	sequence = wal->sequence;
+	count = array_size(wal->segment);
+	mutex_unlock(wal->lock);
+
+	if (sequence == (uint64_t)atomic_load64(&wal->durable))
+		return;
+
+	//Segments are only unmapped by the commit thread, so mapped memory stays valid
+	//while flushing outside the lock
+	for (isegment = 0; success && (isegment < count); ++isegment) {
+		fs_map_t map;
+		size_t synced;
+		uint64_t last = 0;
+		mutex_lock(wal->lock);
+		map = wal->segment[isegment].map;
+		synced = wal->segment[isegment].synced;
+		written = wal->segment[isegment].written;
+		if (isegment + 1 < count)
+			last = wal->segment[isegment + 1].first - 1;
+		mutex_unlock(wal->lock);
+
+		success = fs_map_flush(&map, synced, written - synced);
+		if (success && last) {
+			//Seal segment, records in the following segment are only valid once sealed
+			((wal_header_t*)map.data)->last = last;
+			success = fs_map_flush(&map, 0, sizeof(wal_header_t));
+		}
+	}
+
+	mutex_lock(wal->lock);
+	++wal->flushes;
+	if (success) {
+		for (isegment = 0; isegment + 1 < count; ++isegment) {
+			wal_segment_t* segment = wal->segment + isegment;
+			fs_map_resize(&segment->map, segment->written);
+			fs_unmap_file(&segment->map);
+		}
+		array_erase_ordered_range(wal->segment, 0, count - 1);
+		wal->segment[0].synced = written;
+		atomic_store64(&wal->durable, (int64_t)sequence);
+	} else if (!wal->failed) {
+		log_error(0, ERROR_SYSTEM_CALL_FAIL, STRING_CONST("Unable to flush write-ahead log segment"));
+		wal->failed = true;
+	}
+	_wal_fire_waiters(wal);
+	mutex_unlock(wal->lock);
+}
+
+static void*
+_wal_thread(void* arg) {
+	wal_t* wal = arg;
+	while (!atomic_load32(&wal->stop)) {
+		thread_try_wait(WAL_COMMIT_INTERVAL);
+		atomic_store32(&wal->requested, 0);
+		_wal_commit(wal);
+	}
+	_wal_commit(wal);
+	return 0;
+}
+
+static void
+_wal_request(wal_t* wal) {
+	if (atomic_cas32(&wal->requested, 1, 0))
+		thread_signal(&wal->thread);
+}
+
+wal_t*
+wal_allocate(const char* path, size_t length, size_t segment_size) {
+	wal_t* wal;
+	uint64_t* first;
+	bool success;
+
+	if (!fs_is_directory(path, length) && !fs_make_directory(path, length)) {
+		log_errorf(0, ERROR_SYSTEM_CALL_FAIL, STRING_CONST("Unable to create write-ahead log directory: %.*s"),
+		           (int)length, path);
+		return nullptr;
+	}
+
+	wal = memory_allocate(0, sizeof(wal_t), 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	wal->path = string_clone(path, length);
+	wal->segment_size = segment_size ? segment_size : WAL_SEGMENT_SIZE;
+	if (wal->segment_size < WAL_MIN_SEGMENT_SIZE)
+		wal->segment_size = WAL_MIN_SEGMENT_SIZE;
+
+	first = _wal_segments(path, length);
+	success = _wal_open_segment(wal, first, array_size(first));
+	array_deallocate(first);
+	if (!success) {
+		string_deallocate(wal->path.str);
+		memory_deallocate(wal);
+		return nullptr;
+	}
+
+	atomic_store64(&wal->durable, (int64_t)wal->sequence);
+	wal->lock = mutex_allocate(STRING_CONST("wal"));
+	thread_initialize(&wal->thread, _wal_thread, wal, STRING_CONST("wal_commit"), THREAD_PRIORITY_ABOVENORMAL, 0);
+	thread_start(&wal->thread);
+	return wal;
+}
+
+void
+wal_deallocate(wal_t* wal) {
+	size_t isegment;
+	if (!wal)
+		return;
+
+	atomic_store32(&wal->stop, 1);
+	thread_signal(&wal->thread);
+	thread_finalize(&wal->thread);
+
+	for (isegment = 0; isegment < array_size(wal->segment); ++isegment) {
+		wal_segment_t* segment = wal->segment + isegment;
+		fs_map_resize(&segment->map, segment->written);
+		fs_unmap_file(&segment->map);
+	}
+	wal->failed = true;
+	_wal_fire_waiters(wal);
+
+	array_deallocate(wal->segment);
+	array_deallocate(wal->waiter);
+	mutex_deallocate(wal->lock);
+	string_deallocate(wal->path.str);
+	memory_deallocate(wal);
+}
+
+uint64_t
+wal_append(wal_t* wal, const void* data, size_t size) {
+	size_t record_size = _wal_record_size(size);
+	wal_segment_t* segment;
+	wal_record_t* record;
+	uint64_t sequence;
+
+	if ((size > 0xFFFFFFFFU) || (record_size > wal->segment_size - sizeof(wal_header_t))) {
+		log_errorf(0, ERROR_INVALID_VALUE, STRING_CONST("Write-ahead log record too large: %" PRIsize " bytes"),
+		           size);
+		return 0;
+	}
+
+	mutex_lock(wal->lock);
+	segment = wal->segment + (array_size(wal->segment) - 1);
+	if (segment->written + record_size > segment->map.size) {
+		if (!_wal_create_segment(wal, wal->sequence + 1)) {
+			mutex_unlock(wal->lock);
+			return 0;
+		}
+		segment = wal->segment + (array_size(wal->segment) - 1);
+	}
+
+	sequence = ++wal->sequence;
+	record = pointer_offset(segment->map.data, segment->written);
+	record->size = (uint32_t)size;
+	record->sequence = sequence;
+	memcpy(record + 1, data, size);
+	record->checksum = _wal_checksum(record);
+	segment->written += record_size;
+	mutex_unlock(wal->lock);
+
+	return sequence;
+}
+
+bool
+wal_sync(wal_t* wal, uint64_t sequence) {
+	beacon_t beacon;
+	bool success;
+
+	if ((uint64_t)atomic_load64(&wal->durable) >= sequence)
+		return true;
+
+	beacon_initialize(&beacon);
+	wal_notify(wal, sequence, &beacon);
+	while (true) {
+		//Waiter is removed by the commit thread before firing the beacon
+		bool waiting = false;
+		size_t iwaiter;
+		beacon_wait(&beacon);
+		mutex_lock(wal->lock);
+		for (iwaiter = 0; !waiting && (iwaiter < array_size(wal->waiter)); ++iwaiter)
+			waiting = (wal->waiter[iwaiter].beacon == &beacon);
+		success = !wal->failed;
+		mutex_unlock(wal->lock);
+		if (!waiting)
+			break;
+	}
+	beacon_finalize(&beacon);
+
+	return success;
+}
+
+void
+wal_notify(wal_t* wal, uint64_t sequence, beacon_t* beacon) {
+	wal_waiter_t waiter;
+	mutex_lock(wal->lock);
+	if (sequence > wal->sequence)
+		sequence = wal->sequence;
+	if (wal->failed || ((uint64_t)atomic_load64(&wal->durable) >= sequence)) {
+		mutex_unlock(wal->lock);
+		beacon_fire(beacon);
+		return;
+	}
+	waiter.sequence = sequence;
+	waiter.beacon = beacon;
+	array_push_memcpy(wal->waiter, &waiter);
+	mutex_unlock(wal->lock);
+
+	_wal_request(wal);
+}
+
+uint64_t
+wal_durable(wal_t* wal) {
+	return (uint64_t)atomic_load64(&wal->durable);
+}
+
+uint64_t
+wal_sequence(wal_t* wal) {
+	uint64_t sequence;
+	mutex_lock(wal->lock);
+	sequence = wal->sequence;
+	mutex_unlock(wal->lock);
+	return sequence;
+}
+
+size_t
+wal_truncate(wal_t* wal, uint64_t sequence) {
+	char buffer[BUILD_MAX_PATHLEN];
+	uint64_t durable = (uint64_t)atomic_load64(&wal->durable);
+	uint64_t* first;
+	uint64_t limit;
+	size_t isegment, count;
+	size_t removed = 0;
+
+	//Keep segments still open and records not yet durable
+	mutex_lock(wal->lock);
+	limit = wal->segment[0].first;
+	mutex_unlock(wal->lock);
+	if (sequence > durable + 1)
+		sequence = durable + 1;
+
+	first = _wal_segments(STRING_ARGS(wal->path));
+	for (isegment = 0, count = array_size(first); isegment + 1 < count; ++isegment) {
+		string_t path;
+		if ((first[isegment + 1] > sequence) || (first[isegment + 1] > limit))
+			break;
+		path = _wal_segment_path(buffer, sizeof(buffer), STRING_ARGS(wal->path), first[isegment]);
+		if (fs_remove_file(STRING_ARGS(path)))
+			++removed;
+	}
+	array_deallocate(first);
+
+	if (removed)
+		fs_sync_directory(STRING_ARGS(wal->path));
+
+	return removed;
+}
+
+uint64_t
+wal_recover(const char* path, size_t length, uint64_t sequence, wal_record_fn fn, void* context) {
+	char buffer[BUILD_MAX_PATHLEN];
+	uint64_t* first = _wal_segments(path, length);
+	uint64_t last = 0;
+	uint64_t expected = 0;
+	size_t isegment, count;
+	bool stop = false;
+
+	for (isegment = 0, count = array_size(first); !stop && (isegment < count); ++isegment) {
+		const wal_header_t* header;
+		string_t segpath;
+		fs_map_t map;
+		//Skip segments only holding records before the requested sequence number
+		if (!expected && (isegment + 1 < count) && (first[isegment + 1] <= sequence))
+			continue;
+		//Following segments are only valid if previous segment was sealed, also when
+		//starting after skipped segments
+		if (expected && (first[isegment] != expected))
+			break;
+		if (!expected && isegment && !_wal_sealed(path, length, first[isegment - 1], first[isegment]))
+			break;
+		segpath = _wal_segment_path(buffer, sizeof(buffer), path, length, first[isegment]);
+		if (!fs_map_file(&map, STRING_ARGS(segpath), STREAM_IN))
+			break;
+		last = first[isegment] - 1;
+		header = _wal_header(&map, first[isegment]);
+		if (header && _wal_scan(&map, first[isegment], sequence, fn, context, &last, &stop))
+			expected = (header->last && (header->last == last)) ? last + 1 : 0;
+		else
+			stop = true;
+		fs_unmap_file(&map);
+		if (!expected)
+			break;
+	}
+	array_deallocate(first);
+
+	return last;
+}
@@ -0,0 +1,109 @@
+/* wal.h  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#pragma once
+
+/*! \file wal.h
+\brief Write-ahead log with group commit
+
+Append-only log of length-prefixed and checksummed records, identified by sequence
+numbers increasing by one for each record. Records are stored in segment files in a
+directory, each segment file named by the sequence number of its first record in
+hexadecimal. A new segment file is started when a record does not fit in the current one.
+The directory is flushed to storage whenever segment files are created or deleted, so
+segment files holding durable records are not lost in a crash.
+
+Any number of threads can append records. Appending only copies the record to the
+memory mapped segment file, a commit thread flushes appended records to storage in
+batches. Threads waiting for records to become durable share the cost of a single flush,
+and are notified through beacons when the flush completes. Records not yet durable may
+or may not be present after a crash, recovery stops at the first torn or missing record.
+
+Segment files are in host byte order. */
+
+#include <foundation/platform.h>
+#include <foundation/types.h>
+
+/*! Open a write-ahead log in the given directory, creating the directory if it does not
+exist. Records after the last valid record in the log are discarded, and new records are
+appended after the last valid record. Use #wal_recover to read existing records before
+opening the log. The log should be deallocated with a call to #wal_deallocate
+\param path Path of directory
+\param length Length of path
+\param segment_size Size of segment files in bytes, 0 for default size
+\return New log, null if directory or segment file could not be opened */
+FOUNDATION_API wal_t*
+wal_allocate(const char* path, size_t length, size_t segment_size);
+
+/*! Deallocate a log, flushing all records to storage and stopping the commit thread
+\param wal Log */
+FOUNDATION_API void
+wal_deallocate(wal_t* wal);
+
+/*! Append a record to the log. The record is not durable until flushed by the commit
+thread, use #wal_sync or #wal_notify to wait for the record to become durable
+\param wal Log
+\param data Record data
+\param size Size of record data
+\return Sequence number of record, 0 if record is too large for a segment or the
+        segment file could not be created */
+FOUNDATION_API uint64_t
+wal_append(wal_t* wal, const void* data, size_t size);
+
+/*! Block until all records up to the given sequence number are durable
+\param wal Log
+\param sequence Sequence number
+\return true if records are durable, false if flushing to storage failed */
+FOUNDATION_API bool
+wal_sync(wal_t* wal, uint64_t sequence);
+
+/*! Fire a beacon once all records up to the given sequence number are durable, or if
+flushing to storage failed. The beacon is fired immediately if records are already
+durable. The beacon must stay valid until fired
+\param wal Log
+\param sequence Sequence number
+\param beacon Beacon to fire */
+FOUNDATION_API void
+wal_notify(wal_t* wal, uint64_t sequence, beacon_t* beacon);
+
+/*! Get sequence number of last durable record
+\param wal Log
+\return Sequence number of last durable record, 0 if no record */
+FOUNDATION_API uint64_t
+wal_durable(wal_t* wal);
+
+/*! Get sequence number of last appended record
+\param wal Log
+\return Sequence number of last appended record, 0 if no record */
+FOUNDATION_API uint64_t
+wal_sequence(wal_t* wal);
+
+/*! Delete segment files only holding durable records before the given sequence number,
+usually after the state they describe has been checkpointed
+\param wal Log
+\param sequence Sequence number of first record to keep
+\return Number of segment files deleted */
+FOUNDATION_API size_t
+wal_truncate(wal_t* wal, uint64_t sequence);
+
+/*! Read records from a log directory, calling the record function for each valid record
+in sequence order starting at the given sequence number. Segment files are mapped into
+memory and record data is passed without copying. Recovery stops at the first torn,
+missing or corrupt record. Should not be called on a directory with an open log
+\param path Path of directory
+\param length Length of path
+\param sequence Sequence number of first record to read
+\param fn Record function, may be null to only find the last valid record
+\param context Context passed to record function
+\return Sequence number of last valid record, 0 if no valid record */
+FOUNDATION_API uint64_t
+wal_recover(const char* path, size_t length, uint64_t sequence, wal_record_fn fn, void* context);
@@ -219,20 +219,28 @@ extern int test_atomic_run(void);
 extern int test_base64_run(void);
 extern int test_beacon_run(void);
 extern int test_bitbuffer_run(void);
+extern int test_bitset_run(void);
 extern int test_blowfish_run(void);
+extern int test_btree_run(void);
 extern int test_bufferstream_run(void);
 extern int test_exception_run(void);
+extern int test_cache_run(void);
 extern int test_environment_run(void);
 extern int test_error_run(void);
 extern int test_event_run(void);
+extern int test_filter_run(void);
 extern int test_fs_run(void);
+extern int test_hamt_run(void);
 extern int test_hash_run(void);
+extern int test_hashindex_run(void);
 extern int test_hashmap_run(void);
 extern int test_hashtable_run(void);
+extern int test_heap_run(void);
 extern int test_json_run(void);
 extern int test_library_run(void);
 extern int test_math_run(void);
 extern int test_md5_run(void);
+extern int test_msgpack_run(void);
 extern int test_mutex_run(void);
 extern int test_objectmap_run(void);
 extern int test_path_run(void);
@@ -245,12 +253,17 @@ extern int test_regex_run(void);
 extern int test_ringbuffer_run(void);
 extern int test_semaphore_run(void);
 extern int test_sha_run(void);
+extern int test_sketch_run(void);
+extern int test_skiplist_run(void);
 extern int test_stacktrace_run(void);
 extern int test_stream_run(void);
 extern int test_string_run(void);
+extern int test_stringmap_run(void);
 extern int test_system_run(void);
 extern int test_time_run(void);
 extern int test_uuid_run(void);
+extern int test_vector_run(void);
+extern int test_wal_run(void);
 typedef int (*test_run_fn)(void);
 
 static void*
@@ -369,20 +382,28 @@ main_run(void* main_arg) {
 		test_base64_run,
 		test_beacon_run,
 		test_bitbuffer_run,
+		test_bitset_run,
 		test_blowfish_run,
+		test_btree_run,
 		test_bufferstream_run,
 		test_exception_run,
+		test_cache_run,
 		test_environment_run,
 		test_error_run,
 		test_event_run,
+		test_filter_run,
 		test_fs_run,
+		test_hamt_run,
 		test_hash_run,
+		test_hashindex_run,
 		test_hashmap_run,
 		test_hashtable_run,
+		test_heap_run,
 		test_json_run,
 		test_library_run,
 		test_math_run,
 		test_md5_run,
+		test_msgpack_run,
 		test_mutex_run,
 		test_objectmap_run,
 		test_path_run,
@@ -395,12 +416,17 @@ main_run(void* main_arg) {
 		test_ringbuffer_run,
 		test_semaphore_run,
 		test_sha_run,
+		test_sketch_run,
+		test_skiplist_run,
 		test_stacktrace_run,
 		test_stream_run, //stream test closes stdin
 		test_string_run,
+		test_stringmap_run,
 		test_system_run,
 		test_time_run,
 		test_uuid_run,
+		test_vector_run,
+		test_wal_run,
 		0
 	};
 
@@ -13,6 +13,10 @@
 #include <foundation/foundation.h>
 #include <test/test.h>
 
+#if FOUNDATION_PLATFORM_LINUX
+#include <foundation/posix.h>
+#endif
+
 #define TEMPORARY_MEMORY_SIZE 256 * 1024
 
 static application_t _global_app;
@@ -101,6 +105,11 @@ memory_thread(void* arg) {
 	return 0;
 }
 
+static void*
+noop_thread(void* arg) {
+	return arg;
+}
+
 DECLARE_TEST(app, memory) {
 	thread_t thread[16];
 	size_t ith;
@@ -109,6 +118,15 @@ DECLARE_TEST(app, memory) {
 #if BUILD_ENABLE_MEMORY_STATISTICS
 	memory_statistics_t oldstats, newstats;
 
+	//Run a first batch so OS threads parked in the thread pool are not counted as leaks
+	for (ith = 0; ith < num_threads; ++ith)
+		thread_initialize(&thread[ith], noop_thread, 0, STRING_CONST("memory_thread"),
+		                  THREAD_PRIORITY_NORMAL, 0);
+	for (ith = 0; ith < num_threads; ++ith)
+		thread_start(&thread[ith]);
+	for (ith = 0; ith < num_threads; ++ith)
+		thread_finalize(&thread[ith]);
+
 	oldstats = memory_statistics();
 #endif
 
@@ -239,11 +257,106 @@ DECLARE_TEST(app, thread) {
 	return 0;
 }
 
+static void*
+counter_thread(void* arg) {
+	atomic_incr32(arg);
+	return arg;
+}
+
+static void*
+stack_thread(void* arg) {
+	FOUNDATION_UNUSED(arg);
+#if FOUNDATION_PLATFORM_LINUX
+	{
+		pthread_attr_t attr;
+		size_t stacksize = 0;
+		if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+			pthread_attr_getstacksize(&attr, &stacksize);
+			pthread_attr_destroy(&attr);
+		}
+		return (void*)(uintptr_t)stacksize;
+	}
+#else
+	return 0;
+#endif
+}
+
+DECLARE_TEST(app, thread_pool) {
+	thread_t thread[8];
+	size_t ithread, iloop;
+	size_t num_loops = 256;
+	atomic32_t counter;
+	tick_t start, elapsed;
+
+	//Churn start/join to exercise reuse of pooled OS threads
+	atomic_store32(&counter, 0);
+	start = time_current();
+	for (iloop = 0; iloop < num_loops; ++iloop) {
+		for (ithread = 0; ithread < 8; ++ithread)
+			thread_initialize(&thread[ithread], counter_thread, &counter, STRING_CONST("pool_thread"),
+			                  THREAD_PRIORITY_NORMAL, 0);
+		for (ithread = 0; ithread < 8; ++ithread)
+			EXPECT_TRUE(thread_start(&thread[ithread]));
+		for (ithread = 0; ithread < 8; ++ithread) {
+			EXPECT_EQ(thread_join(&thread[ithread]), &counter);
+			EXPECT_FALSE(thread_is_running(&thread[ithread]));
+			thread_finalize(&thread[ithread]);
+		}
+	}
+	elapsed = time_diff(start, time_current());
+	EXPECT_INTEQ(atomic_load32(&counter), (int32_t)(num_loops * 8));
+
+	log_infof(HASH_TEST, STRING_CONST("Thread start/join: %" PRIsize " threads in %.3f ms (%.2f us/thread)"),
+	          num_loops * 8, time_ticks_to_seconds(elapsed) * 1000.0,
+	          time_ticks_to_seconds(elapsed) * 1000000.0 / (double)(num_loops * 8));
+
+#if FOUNDATION_PLATFORM_LINUX
+	//Unset stack size keeps the OS default stack size for new threads
+	{
+		pthread_attr_t attr;
+		size_t defaultsize = 0;
+		size_t stacksize;
+		pthread_attr_init(&attr);
+		pthread_attr_getstacksize(&attr, &defaultsize);
+		pthread_attr_destroy(&attr);
+
+		thread_initialize(&thread[0], stack_thread, 0, STRING_CONST("stack_thread"),
+		                  THREAD_PRIORITY_NORMAL, 0);
+		EXPECT_TRUE(thread_start(&thread[0]));
+		stacksize = (size_t)(uintptr_t)thread_join(&thread[0]);
+		thread_finalize(&thread[0]);
+		EXPECT_SIZEGE(stacksize, defaultsize);
+	}
+#endif
+
+	//Requested stack size must be honoured, also when the OS thread is reused
+	for (iloop = 0; iloop < 2; ++iloop) {
+		unsigned int stacksizes[] = { 1024 * 1024, 4 * 1024 * 1024 };
+		size_t isize;
+		for (isize = 0; isize < sizeof(stacksizes) / sizeof(stacksizes[0]); ++isize) {
+			size_t stacksize;
+			thread_initialize(&thread[0], stack_thread, 0, STRING_CONST("stack_thread"),
+			                  THREAD_PRIORITY_NORMAL, stacksizes[isize]);
+			EXPECT_TRUE(thread_start(&thread[0]));
+			stacksize = (size_t)(uintptr_t)thread_join(&thread[0]);
+			thread_finalize(&thread[0]);
+#if FOUNDATION_PLATFORM_LINUX
+			EXPECT_SIZEGE(stacksize, stacksizes[isize]);
+#else
+			FOUNDATION_UNUSED(stacksize);
+#endif
+		}
+	}
+
+	return 0;
+}
+
 static void
 test_app_declare(void) {
 	ADD_TEST(app, environment);
 	ADD_TEST(app, memory);
 	ADD_TEST(app, thread);
+	ADD_TEST(app, thread_pool);
 }
 
 static test_suite_t test_app_suite = {
@@ -2003,6 +2003,118 @@ DECLARE_TEST(array, resize) {
 	return 0;
 }
 
+DECLARE_TEST(array, file) {
+	char buffer[BUILD_MAX_PATHLEN];
+	string_t path = path_make_temporary(buffer, sizeof(buffer));
+	string_const_t directory = path_directory_name(STRING_ARGS(path));
+	hash_t schema = hash(STRING_CONST("int"));
+	size_t num_elements = 1000000;
+	int* intarr = 0;
+	int* maparr = 0;
+	basic_t* basicarr = 0;
+	fs_map_t map;
+	tick_t start, map_time, load_time;
+	size_t ielement;
+	stream_t* stream;
+
+	fs_make_directory(STRING_ARGS(directory));
+	array_resize(intarr, num_elements);
+	for (ielement = 0; ielement < num_elements; ++ielement)
+		intarr[ielement] = (int)(ielement * 7);
+
+	EXPECT_TRUE(array_save(intarr, path.str, path.length, schema, 0));
+	EXPECT_FALSE(array_save(intarr, path.str, path.length, schema, 24));
+
+	start = time_current();
+	EXPECT_TRUE(array_map(maparr, &map, path.str, path.length, schema, ARRAY_MAP_SEQUENTIAL));
+	map_time = time_diff(start, time_current());
+	EXPECT_NE(maparr, 0);
+	EXPECT_EQ((uintptr_t)maparr % 16, 0);
+	EXPECT_EQ(array_size(maparr), num_elements);
+	EXPECT_EQ(array_capacity(maparr), num_elements);
+	for (ielement = 0; ielement < num_elements; ++ielement)
+		EXPECT_EQ(maparr[ielement], (int)(ielement * 7));
+	EXPECT_TRUE(array_map_verify(&map));
+	array_unmap(maparr, &map);
+	EXPECT_EQ(maparr, 0);
+
+	//Compare with reading elements through a stream
+	start = time_current();
+	stream = stream_open(STRING_ARGS(path), STREAM_IN | STREAM_BINARY);
+	EXPECT_NE(stream, 0);
+	stream_seek(stream, (ssize_t)(stream_size(stream) - (num_elements * sizeof(int))), STREAM_SEEK_BEGIN);
+	array_resize(maparr, num_elements);
+	EXPECT_EQ(stream_read(stream, maparr, num_elements * sizeof(int)), num_elements * sizeof(int));
+	stream_deallocate(stream);
+	load_time = time_diff(start, time_current());
+	EXPECT_EQ(maparr[num_elements - 1], intarr[num_elements - 1]);
+	array_deallocate(maparr);
+	log_infof(HASH_TEST, STRING_CONST("Typed array file of %" PRIsize " elements, map: %.3f ms, stream read: %.3f ms"),
+	          num_elements, time_ticks_to_seconds(map_time) * 1000.0, time_ticks_to_seconds(load_time) * 1000.0);
+
+	//Schema and element size must match
+	EXPECT_FALSE(array_map(maparr, &map, path.str, path.length, hash(STRING_CONST("uint")), 0));
+	EXPECT_EQ(maparr, 0);
+	EXPECT_FALSE(array_map(basicarr, &map, path.str, path.length, schema, 0));
+	EXPECT_EQ(basicarr, 0);
+
+	//Private view is writable without modifying the file
+	EXPECT_TRUE(array_map(maparr, &map, path.str, path.length, schema, ARRAY_MAP_PRIVATE | ARRAY_MAP_RANDOM));
+	maparr[10] = -1;
+	array_pop(maparr);
+	EXPECT_EQ(maparr[10], -1);
+	EXPECT_EQ(array_size(maparr), num_elements - 1);
+	array_unmap(maparr, &map);
+	EXPECT_TRUE(array_map(maparr, &map, path.str, path.length, schema, ARRAY_MAP_VERIFY | ARRAY_MAP_WILLNEED));
+	EXPECT_EQ(maparr[10], 70);
+	EXPECT_EQ(array_size(maparr), num_elements);
+	array_unmap(maparr, &map);
+
+	//Corrupt element data
+	EXPECT_TRUE(fs_map_file(&map, STRING_ARGS(path), STREAM_IN | STREAM_OUT));
+	((char*)map.data)[map.size - 5] ^= 0x55;
+	fs_unmap_file(&map);
+	EXPECT_TRUE(array_map(maparr, &map, path.str, path.length, schema, 0));
+	EXPECT_FALSE(array_map_verify(&map));
+	array_unmap(maparr, &map);
+	EXPECT_FALSE(array_map(maparr, &map, path.str, path.length, schema, ARRAY_MAP_VERIFY));
+	EXPECT_EQ(maparr, 0);
+
+	//Custom alignment and struct elements
+	array_resize(basicarr, 100);
+	for (ielement = 0; ielement < 100; ++ielement) {
+		basicarr[ielement].intval = (int)ielement;
+		basicarr[ielement].floatval = (float32_t)ielement;
+		basicarr[ielement].objval = ielement;
+	}
+	EXPECT_TRUE(array_save(basicarr, path.str, path.length, schema, 4096));
+	array_deallocate(basicarr);
+	EXPECT_TRUE(array_map(basicarr, &map, path.str, path.length, schema, ARRAY_MAP_VERIFY));
+	EXPECT_EQ((uintptr_t)basicarr % 4096, 0);
+	EXPECT_EQ(array_size(basicarr), 100);
+	EXPECT_EQ(basicarr[99].intval, 99);
+	EXPECT_EQ(basicarr[99].objval, 99);
+	array_unmap(basicarr, &map);
+
+	//Empty array
+	array_deallocate(intarr);
+	EXPECT_TRUE(array_save(intarr, path.str, path.length, schema, 0));
+	EXPECT_TRUE(array_map(maparr, &map, path.str, path.length, schema, ARRAY_MAP_VERIFY));
+	EXPECT_NE(maparr, 0);
+	EXPECT_EQ(array_size(maparr), 0);
+	array_unmap(maparr, &map);
+
+	//Not a typed array file
+	stream = stream_open(STRING_ARGS(path), STREAM_OUT | STREAM_TRUNCATE);
+	stream_write_string(stream, STRING_CONST("not an array"));
+	stream_deallocate(stream);
+	EXPECT_FALSE(array_map(maparr, &map, path.str, path.length, schema, 0));
+
+	fs_remove_file(STRING_ARGS(path));
+
+	return 0;
+}
+
 static void
 test_array_declare(void) {
 	ADD_TEST(array, allocation);
@@ -2010,6 +2122,7 @@ test_array_declare(void) {
 	ADD_TEST(array, pushpop);
 	ADD_TEST(array, inserterase);
 	ADD_TEST(array, resize);
+	ADD_TEST(array, file);
 }
 
 static test_suite_t test_array_suite = {
@@ -0,0 +1,362 @@
+/* main.c  -  Foundation bitset test  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+#include <test/test.h>
+
+static application_t
+test_bitset_application(void) {
+	application_t app;
+	memset(&app, 0, sizeof(app));
+	app.name = string_const(STRING_CONST("Foundation bitset tests"));
+	app.short_name = string_const(STRING_CONST("test_bitset"));
+	app.company = string_const(STRING_CONST("Rampant Pixels"));
+	app.flags = APPLICATION_UTILITY;
+	app.exception_handler = test_exception_handler;
+	return app;
+}
+
+static memory_system_t
+test_bitset_memory_system(void) {
+	return memory_system_malloc();
+}
+
+static foundation_config_t
+test_bitset_config(void) {
+	foundation_config_t config;
+	memset(&config, 0, sizeof(config));
+	return config;
+}
+
+static int
+test_bitset_initialize(void) {
+	return 0;
+}
+
+static void
+test_bitset_finalize(void) {
+}
+
+static size_t
+bitset_naive_count(const bitset_t* set) {
+	size_t iword, count = 0;
+	for (iword = 0; iword < set->num_words; ++iword) {
+		uint64_t word = set->word[iword];
+		while (word) {
+			word &= word - 1;
+			++count;
+		}
+	}
+	return count;
+}
+
+static void
+bitset_fill_random(bitset_t* set, unsigned int density) {
+	size_t iword;
+	//Density is the number of random words anded together, each halving the set bits
+	for (iword = 0; iword < set->num_words; ++iword) {
+		uint64_t word = random64();
+		unsigned int iand;
+		for (iand = 1; iand < density; ++iand)
+			word &= random64();
+		set->word[iword] = word;
+	}
+	if (set->num_bits & 63)
+		set->word[set->num_words - 1] &= (1ULL << (set->num_bits & 63)) - 1;
+}
+
+DECLARE_TEST(bitset, basic) {
+	size_t sizes[] = {0, 1, 63, 64, 65, 511, 512, 513, 1000, 4096};
+	size_t isize, ibit;
+
+	for (isize = 0; isize < sizeof(sizes) / sizeof(sizes[0]); ++isize) {
+		size_t num_bits = sizes[isize];
+		bitset_t* set = bitset_allocate(num_bits);
+
+		EXPECT_SIZEEQ(set->num_bits, num_bits);
+		EXPECT_SIZEEQ(bitset_count(set), 0);
+		EXPECT_SIZEEQ(bitset_find_first(set), BITSET_NPOS);
+
+		bitset_set_all(set);
+		EXPECT_SIZEEQ(bitset_count(set), num_bits);
+		EXPECT_SIZEEQ(bitset_find_first(set), num_bits ? 0 : BITSET_NPOS);
+		EXPECT_SIZEEQ(bitset_find_next(set, num_bits), BITSET_NPOS);
+		for (ibit = 0; ibit < num_bits; ++ibit)
+			EXPECT_TRUE(bitset_test(set, ibit));
+		bitset_clear(set);
+		EXPECT_SIZEEQ(bitset_count(set), 0);
+
+		//Every third bit
+		for (ibit = 0; ibit < num_bits; ibit += 3)
+			bitset_set(set, ibit);
+		EXPECT_SIZEEQ(bitset_count(set), (num_bits + 2) / 3);
+		for (ibit = 0; ibit < num_bits; ++ibit) {
+			EXPECT_EQ(bitset_test(set, ibit), (ibit % 3) == 0);
+			EXPECT_SIZEEQ(bitset_find_next(set, ibit), ((ibit + 2) / 3) * 3 < num_bits ? ((ibit + 2) / 3) * 3 : BITSET_NPOS);
+		}
+
+		for (ibit = 0; ibit < num_bits; ++ibit)
+			bitset_flip(set, ibit);
+		EXPECT_SIZEEQ(bitset_count(set), num_bits - ((num_bits + 2) / 3));
+		EXPECT_SIZEEQ(bitset_find_first(set), (num_bits > 1) ? 1 : BITSET_NPOS);
+		for (ibit = 0; ibit < num_bits; ++ibit)
+			bitset_unset(set, ibit);
+		EXPECT_SIZEEQ(bitset_count(set), 0);
+
+		if (num_bits) {
+			bitset_set(set, num_bits - 1);
+			EXPECT_SIZEEQ(bitset_find_first(set), num_bits - 1);
+			EXPECT_SIZEEQ(bitset_find_next(set, num_bits - 1), num_bits - 1);
+			EXPECT_SIZEEQ(bitset_count(set), 1);
+		}
+
+		bitset_deallocate(set);
+	}
+
+	return 0;
+}
+
+DECLARE_TEST(bitset, bulk) {
+	bitset_t set, other, copy;
+	size_t num_bits = 100000 + 37;
+	size_t iword;
+
+	bitset_initialize(&set, num_bits);
+	bitset_initialize(&other, num_bits);
+	bitset_initialize(&copy, num_bits);
+	bitset_fill_random(&set, 1);
+	bitset_fill_random(&other, 2);
+
+	memcpy(copy.word, set.word, set.num_words * sizeof(uint64_t));
+	bitset_and(&copy, &other);
+	for (iword = 0; iword < set.num_words; ++iword)
+		EXPECT_EQ(copy.word[iword], set.word[iword] & other.word[iword]);
+
+	memcpy(copy.word, set.word, set.num_words * sizeof(uint64_t));
+	bitset_or(&copy, &other);
+	for (iword = 0; iword < set.num_words; ++iword)
+		EXPECT_EQ(copy.word[iword], set.word[iword] | other.word[iword]);
+
+	memcpy(copy.word, set.word, set.num_words * sizeof(uint64_t));
+	bitset_xor(&copy, &other);
+	for (iword = 0; iword < set.num_words; ++iword)
+		EXPECT_EQ(copy.word[iword], set.word[iword] ^ other.word[iword]);
+
+	memcpy(copy.word, set.word, set.num_words * sizeof(uint64_t));
+	bitset_andnot(&copy, &other);
+	for (iword = 0; iword < set.num_words; ++iword)
+		EXPECT_EQ(copy.word[iword], set.word[iword] & ~other.word[iword]);
+
+	//Bits beyond size stay clear
+	bitset_set_all(&copy);
+	bitset_xor(&copy, &set);
+	EXPECT_SIZEEQ(bitset_count(&copy), num_bits - bitset_naive_count(&set));
+	EXPECT_SIZEEQ(bitset_count(&set), bitset_naive_count(&set));
+	EXPECT_SIZEEQ(bitset_count(&other), bitset_naive_count(&other));
+
+	bitset_finalize(&set);
+	bitset_finalize(&other);
+	bitset_finalize(&copy);
+
+	return 0;
+}
+
+DECLARE_TEST(bitset, rank) {
+	unsigned int density;
+	size_t ibit;
+
+	for (density = 1; density <= 8; density *= 2) {
+		bitset_t set;
+		size_t rank = 0, select;
+		size_t num_bits = 200000 + density;
+
+		bitset_initialize(&set, num_bits);
+		bitset_fill_random(&set, density);
+		bitset_rank_build(&set);
+
+		for (ibit = 0; ibit < num_bits; ++ibit) {
+			EXPECT_SIZEEQ(bitset_rank(&set, ibit), rank);
+			if (bitset_test(&set, ibit)) {
+				EXPECT_SIZEEQ(bitset_select(&set, rank), ibit);
+				++rank;
+			}
+		}
+		EXPECT_SIZEEQ(bitset_rank(&set, num_bits), rank);
+		EXPECT_SIZEEQ(rank, bitset_count(&set));
+		EXPECT_SIZEEQ(bitset_select(&set, rank), BITSET_NPOS);
+
+		//Rebuilding after modification
+		select = bitset_select(&set, rank / 2);
+		bitset_unset(&set, select);
+		bitset_rank_build(&set);
+		EXPECT_SIZEEQ(bitset_rank(&set, num_bits), rank - 1);
+		EXPECT_SIZEEQ(bitset_rank(&set, select + 1), rank / 2);
+
+		bitset_finalize(&set);
+	}
+
+	//Empty and single bit sets
+	{
+		bitset_t set;
+		bitset_initialize(&set, 0);
+		bitset_rank_build(&set);
+		EXPECT_SIZEEQ(bitset_rank(&set, 0), 0);
+		EXPECT_SIZEEQ(bitset_select(&set, 0), BITSET_NPOS);
+		bitset_finalize(&set);
+
+		bitset_initialize(&set, 1024);
+		bitset_set(&set, 1023);
+		bitset_rank_build(&set);
+		EXPECT_SIZEEQ(bitset_rank(&set, 1023), 0);
+		EXPECT_SIZEEQ(bitset_rank(&set, 1024), 1);
+		EXPECT_SIZEEQ(bitset_select(&set, 0), 1023);
+		EXPECT_SIZEEQ(bitset_select(&set, 1), BITSET_NPOS);
+		bitset_finalize(&set);
+	}
+
+	return 0;
+}
+
+DECLARE_TEST(bitset, performance) {
+	bitset_t set, other, naive;
+	size_t num_bits = (size_t)1 << 30;
+	size_t iword, ibit, count, naive_count, iquery;
+	size_t num_queries = 1000000;
+	size_t checksum = 0;
+	tick_t start, time_naive, time_bitset;
+
+	bitset_initialize(&set, num_bits);
+	bitset_initialize(&other, num_bits);
+	bitset_initialize(&naive, num_bits);
+	bitset_fill_random(&set, 1);
+	bitset_fill_random(&other, 1);
+
+	start = time_current();
+	naive_count = bitset_naive_count(&set);
+	time_naive = time_diff(start, time_current());
+	start = time_current();
+	count = bitset_count(&set);
+	time_bitset = time_diff(start, time_current());
+	EXPECT_SIZEEQ(count, naive_count);
+	log_infof(HASH_TEST, STRING_CONST("Popcount %" PRIsize " bits: naive %.2f ms, bitset %.2f ms"),
+	          num_bits, time_ticks_to_seconds(time_naive) * 1000.0,
+	          time_ticks_to_seconds(time_bitset) * 1000.0);
+
+	start = time_current();
+	for (iword = 0; iword < naive.num_words; ++iword)
+		naive.word[iword] = set.word[iword] & ~other.word[iword];
+	time_naive = time_diff(start, time_current());
+	start = time_current();
+	bitset_andnot(&set, &other);
+	time_bitset = time_diff(start, time_current());
+	EXPECT_EQ(memcmp(set.word, naive.word, set.num_words * sizeof(uint64_t)), 0);
+	log_infof(HASH_TEST, STRING_CONST("Andnot %" PRIsize " bits: naive %.2f ms, bitset %.2f ms"),
+	          num_bits, time_ticks_to_seconds(time_naive) * 1000.0,
+	          time_ticks_to_seconds(time_bitset) * 1000.0);
+
+	//Iterate set bits of a sparse set
+	bitset_clear(&set);
+	for (ibit = 0; ibit < (num_bits >> 10); ++ibit)
+		bitset_set(&set, (size_t)random64_range(0, num_bits));
+	start = time_current();
+	naive_count = 0;
+	for (ibit = 0; ibit < num_bits; ++ibit) {
+		if (bitset_test(&set, ibit))
+			naive_count += ibit;
+	}
+	time_naive = time_diff(start, time_current());
+	start = time_current();
+	count = 0;
+	for (ibit = bitset_find_first(&set); ibit != BITSET_NPOS; ibit = bitset_find_next(&set, ibit + 1))
+		count += ibit;
+	time_bitset = time_diff(start, time_current());
+	EXPECT_SIZEEQ(count, naive_count);
+	log_infof(HASH_TEST, STRING_CONST("Iterate %" PRIsize " bits: naive %.2f ms, bitset %.2f ms"),
+	          num_bits, time_ticks_to_seconds(time_naive) * 1000.0,
+	          time_ticks_to_seconds(time_bitset) * 1000.0);
+
+	start = time_current();
+	bitset_rank_build(&set);
+	time_bitset = time_diff(start, time_current());
+	count = bitset_count(&set);
+	log_infof(HASH_TEST, STRING_CONST("Rank index build %" PRIsize " bits: %.2f ms"),
+	          num_bits, time_ticks_to_seconds(time_bitset) * 1000.0);
+
+	start = time_current();
+	for (iquery = 0; iquery < num_queries; ++iquery)
+		checksum += bitset_rank(&set, (size_t)random64_range(0, num_bits));
+	time_bitset = time_diff(start, time_current());
+	log_infof(HASH_TEST, STRING_CONST("Rank %" PRIsize " queries: %.2f ms"),
+	          num_queries, time_ticks_to_seconds(time_bitset) * 1000.0);
+
+	start = time_current();
+	for (iquery = 0; iquery < num_queries; ++iquery) {
+		size_t rank = (size_t)random64_range(0, count);
+		size_t select = bitset_select(&set, rank);
+		if ((iquery & 0xFFF) == 0) {
+			EXPECT_TRUE(bitset_test(&set, select));
+			EXPECT_SIZEEQ(bitset_rank(&set, select), rank);
+		}
+		checksum += select;
+	}
+	time_bitset = time_diff(start, time_current());
+	log_infof(HASH_TEST, STRING_CONST("Select %" PRIsize " queries: %.2f ms"),
+	          num_queries, time_ticks_to_seconds(time_bitset) * 1000.0);
+	EXPECT_SIZENE(checksum, 0);
+
+	bitset_finalize(&set);
+	bitset_finalize(&other);
+	bitset_finalize(&naive);
+
+	return 0;
+}
+
+static void
+test_bitset_declare(void) {
+	ADD_TEST(bitset, basic);
+	ADD_TEST(bitset, bulk);
+	ADD_TEST(bitset, rank);
+	ADD_TEST(bitset, performance);
+}
+
+static test_suite_t test_bitset_suite = {
+	test_bitset_application,
+	test_bitset_memory_system,
+	test_bitset_config,
+	test_bitset_declare,
+	test_bitset_initialize,
+	test_bitset_finalize,
+	0
+};
+
+#if BUILD_MONOLITHIC
+
+int
+test_bitset_run(void);
+
+int
+test_bitset_run(void) {
+	test_suite = test_bitset_suite;
+	return test_run_all();
+}
+
+#else
+
+test_suite_t
+test_suite_define(void);
+
+test_suite_t
+test_suite_define(void) {
+	return test_bitset_suite;
+}
+
+#endif
@@ -0,0 +1,459 @@
+/* main.c  -  Foundation btree test  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+#include <test/test.h>
+
+#include <stdlib.h>
+
+static application_t
+test_btree_application(void) {
+	application_t app;
+	memset(&app, 0, sizeof(app));
+	app.name = string_const(STRING_CONST("Foundation btree tests"));
+	app.short_name = string_const(STRING_CONST("test_btree"));
+	app.company = string_const(STRING_CONST("Rampant Pixels"));
+	app.flags = APPLICATION_UTILITY;
+	app.exception_handler = test_exception_handler;
+	return app;
+}
+
+static memory_system_t
+test_btree_memory_system(void) {
+	return memory_system_malloc();
+}
+
+static foundation_config_t
+test_btree_config(void) {
+	foundation_config_t config;
+	memset(&config, 0, sizeof(config));
+	return config;
+}
+
+static int
+test_btree_initialize(void) {
+	return 0;
+}
+
+static void
+test_btree_finalize(void) {
+}
+
+//Verify key order, node fill and separators, returns number of keys in subtree
+static size_t
+btree_verify_node(const btree_node_t* node, uint64_t low, uint64_t high, bool root, bool* valid) {
+	unsigned int ikey;
+	size_t count = 0;
+
+	if (!root && (node->num_keys < BTREE_NODE_KEYS / 2))
+		*valid = false;
+	for (ikey = 0; ikey < BTREE_NODE_KEYS; ++ikey) {
+		if (ikey >= node->num_keys) {
+			if (node->key[ikey] != UINT64_MAX)
+				*valid = false;
+			continue;
+		}
+		if ((node->key[ikey] < low) || (node->key[ikey] > high))
+			*valid = false;
+		if (ikey && (node->key[ikey - 1] >= node->key[ikey]))
+			*valid = false;
+	}
+	if (!node->level)
+		return node->num_keys;
+
+	for (ikey = 0; ikey <= node->num_keys; ++ikey) {
+		const btree_node_t* child = node->slot[ikey];
+		uint64_t child_low = ikey ? node->key[ikey - 1] : low;
+		uint64_t child_high = (ikey < node->num_keys) ? node->key[ikey] - 1 : high;
+		if (child->level + 1 != node->level)
+			*valid = false;
+		count += btree_verify_node(child, child_low, child_high, false, valid);
+	}
+	return count;
+}
+
+static bool
+btree_verify(const btree_t* tree) {
+	bool valid = true;
+	size_t count = tree->root ? btree_verify_node(tree->root, 0, UINT64_MAX, true, &valid) : 0;
+	return valid && (count == btree_size(tree));
+}
+
+static int
+btree_key_compare(const void* lhs, const void* rhs) {
+	uint64_t left = *(const uint64_t*)lhs;
+	uint64_t right = *(const uint64_t*)rhs;
+	return (left < right) ? -1 : ((left > right) ? 1 : 0);
+}
+
+DECLARE_TEST(btree, basic) {
+	btree_t* tree = btree_allocate();
+	btree_iterator_t it;
+	uint64_t ikey;
+
+	EXPECT_SIZEEQ(btree_size(tree), 0);
+	EXPECT_EQ(btree_lookup(tree, 0), 0);
+	EXPECT_FALSE(btree_has_key(tree, 0));
+	EXPECT_EQ(btree_erase(tree, 0), 0);
+	it = btree_begin(tree);
+	EXPECT_TRUE(btree_iterator_done(&it));
+
+	EXPECT_EQ(btree_insert(tree, 42, (void*)(uintptr_t)1), 0);
+	EXPECT_EQ(btree_insert(tree, 42, (void*)(uintptr_t)2), (void*)(uintptr_t)1);
+	EXPECT_EQ(btree_lookup(tree, 42), (void*)(uintptr_t)2);
+	EXPECT_SIZEEQ(btree_size(tree), 1);
+
+	//Null values and extreme keys
+	EXPECT_EQ(btree_insert(tree, 0, 0), 0);
+	EXPECT_EQ(btree_insert(tree, UINT64_MAX, (void*)(uintptr_t)3), 0);
+	EXPECT_TRUE(btree_has_key(tree, 0));
+	EXPECT_EQ(btree_lookup(tree, UINT64_MAX), (void*)(uintptr_t)3);
+	EXPECT_SIZEEQ(btree_size(tree), 3);
+
+	EXPECT_EQ(btree_erase(tree, 42), (void*)(uintptr_t)2);
+	EXPECT_EQ(btree_erase(tree, 42), 0);
+	EXPECT_FALSE(btree_has_key(tree, 42));
+	EXPECT_SIZEEQ(btree_size(tree), 2);
+
+	//Ascending inserts split the rightmost nodes
+	for (ikey = 1; ikey <= 10000; ++ikey)
+		btree_insert(tree, ikey * 2, (void*)(uintptr_t)ikey);
+	EXPECT_SIZEEQ(btree_size(tree), 10002);
+	EXPECT_TRUE(btree_verify(tree));
+	EXPECT_GT(tree->root->level, 1);
+	for (ikey = 1; ikey <= 10000; ++ikey) {
+		EXPECT_EQ(btree_lookup(tree, ikey * 2), (void*)(uintptr_t)ikey);
+		EXPECT_FALSE(btree_has_key(tree, (ikey * 2) + 1));
+	}
+
+	it = btree_begin(tree);
+	EXPECT_EQ(btree_iterator_key(&it), 0);
+	btree_iterator_next(&it);
+	for (ikey = 1; ikey <= 10000; ++ikey, btree_iterator_next(&it)) {
+		EXPECT_FALSE(btree_iterator_done(&it));
+		EXPECT_EQ(btree_iterator_key(&it), ikey * 2);
+		EXPECT_EQ(btree_iterator_value(&it), (void*)(uintptr_t)ikey);
+	}
+	EXPECT_EQ(btree_iterator_key(&it), UINT64_MAX);
+	btree_iterator_next(&it);
+	EXPECT_TRUE(btree_iterator_done(&it));
+
+	//Erase down to empty collapses the tree
+	for (ikey = 1; ikey <= 10000; ++ikey)
+		EXPECT_EQ(btree_erase(tree, ikey * 2), (void*)(uintptr_t)ikey);
+	EXPECT_TRUE(btree_verify(tree));
+	EXPECT_EQ(tree->root->level, 0);
+	EXPECT_EQ(btree_erase(tree, 0), 0);
+	EXPECT_EQ(btree_erase(tree, UINT64_MAX), (void*)(uintptr_t)3);
+	EXPECT_SIZEEQ(btree_size(tree), 0);
+	it = btree_begin(tree);
+	EXPECT_TRUE(btree_iterator_done(&it));
+
+	btree_clear(tree);
+	EXPECT_EQ(btree_insert(tree, 1, (void*)(uintptr_t)1), 0);
+	EXPECT_EQ(btree_lookup(tree, 1), (void*)(uintptr_t)1);
+	btree_deallocate(tree);
+
+	return 0;
+}
+
+DECLARE_TEST(btree, random) {
+	btree_t tree;
+	size_t num_keys = 50000;
+	uint64_t* keys = memory_allocate(0, sizeof(uint64_t) * num_keys, 0, MEMORY_PERSISTENT);
+	size_t ikey, iround;
+
+	btree_initialize(&tree);
+	for (iround = 0; iround < 3; ++iround) {
+		btree_iterator_t it;
+		size_t num_unique = 0;
+
+		//Random keys in a narrow range to get duplicates, odd keys are erased below
+		for (ikey = 0; ikey < num_keys; ++ikey) {
+			keys[ikey] = random64_range(0, num_keys * 4);
+			btree_insert(&tree, keys[ikey], (void*)(uintptr_t)(keys[ikey] + 1));
+		}
+		qsort(keys, num_keys, sizeof(uint64_t), btree_key_compare);
+		for (ikey = 0; ikey < num_keys; ++ikey) {
+			if (!ikey || (keys[ikey] != keys[num_unique - 1]))
+				keys[num_unique++] = keys[ikey];
+		}
+		EXPECT_SIZEEQ(btree_size(&tree), num_unique);
+		EXPECT_TRUE(btree_verify(&tree));
+
+		it = btree_begin(&tree);
+		for (ikey = 0; ikey < num_unique; ++ikey, btree_iterator_next(&it)) {
+			EXPECT_EQ(btree_iterator_key(&it), keys[ikey]);
+			EXPECT_EQ(btree_iterator_value(&it), (void*)(uintptr_t)(keys[ikey] + 1));
+		}
+		EXPECT_TRUE(btree_iterator_done(&it));
+
+		for (ikey = 0; ikey < num_unique; ++ikey) {
+			if (keys[ikey] & 1)
+				EXPECT_EQ(btree_erase(&tree, keys[ikey]), (void*)(uintptr_t)(keys[ikey] + 1));
+		}
+		EXPECT_TRUE(btree_verify(&tree));
+		for (ikey = 0; ikey < num_unique; ++ikey)
+			EXPECT_EQ(btree_has_key(&tree, keys[ikey]), !(keys[ikey] & 1));
+
+		//Erase remaining keys in random order
+		for (ikey = 0; ikey < num_unique; ++ikey) {
+			size_t iswap = (size_t)random64_range(ikey, num_unique);
+			uint64_t key = keys[iswap];
+			keys[iswap] = keys[ikey];
+			keys[ikey] = key;
+			EXPECT_EQ(btree_erase(&tree, key), (key & 1) ? 0 : (void*)(uintptr_t)(key + 1));
+			if ((ikey % 5000) == 0)
+				EXPECT_TRUE(btree_verify(&tree));
+		}
+		EXPECT_SIZEEQ(btree_size(&tree), 0);
+		EXPECT_TRUE(btree_verify(&tree));
+	}
+	btree_finalize(&tree);
+	memory_deallocate(keys);
+
+	return 0;
+}
+
+DECLARE_TEST(btree, range) {
+	btree_t tree;
+	size_t num_keys = 100000;
+	uint64_t* keys = memory_allocate(0, sizeof(uint64_t) * num_keys, 0, MEMORY_PERSISTENT);
+	void** values = memory_allocate(0, sizeof(void*) * num_keys, 0, MEMORY_PERSISTENT);
+	uint64_t range_key[200];
+	void* range_value[200];
+	size_t ikey, count, iquery;
+	btree_iterator_t it;
+
+	btree_initialize(&tree);
+	for (ikey = 0; ikey < num_keys; ++ikey) {
+		keys[ikey] = (ikey * 10) + 5;
+		values[ikey] = (void*)(uintptr_t)ikey;
+	}
+
+	//Load sizes around node boundaries
+	for (count = 0; count < 2000; count += 1 + (count / 16)) {
+		EXPECT_TRUE(btree_load(&tree, keys, values, count));
+		EXPECT_SIZEEQ(btree_size(&tree), count);
+		EXPECT_TRUE(btree_verify(&tree));
+		it = btree_begin(&tree);
+		for (ikey = 0; ikey < count; ++ikey, btree_iterator_next(&it))
+			EXPECT_EQ(btree_iterator_key(&it), keys[ikey]);
+		EXPECT_TRUE(btree_iterator_done(&it));
+	}
+
+	EXPECT_TRUE(btree_load(&tree, keys, values, num_keys));
+	EXPECT_TRUE(btree_verify(&tree));
+	for (iquery = 0; iquery < 1000; ++iquery) {
+		uint64_t first = random64_range(0, num_keys * 10);
+		uint64_t last = first + random64_range(0, 2000);
+		size_t ifirst = (first < 5) ? 0 : ((first - 5 + 9) / 10);
+		size_t iend = (last < 5) ? 0 : math_min((last - 5) / 10 + 1, num_keys);
+		size_t expect = (iend > ifirst) ? math_min(iend - ifirst, 200) : 0;
+
+		it = btree_lower_bound(&tree, first);
+		if (ifirst < num_keys)
+			EXPECT_EQ(btree_iterator_key(&it), keys[ifirst]);
+		else
+			EXPECT_TRUE(btree_iterator_done(&it));
+
+		count = btree_range(&tree, first, last, range_key, range_value, 200);
+		EXPECT_SIZEEQ(count, expect);
+		for (ikey = 0; ikey < count; ++ikey) {
+			EXPECT_EQ(range_key[ikey], keys[ifirst + ikey]);
+			EXPECT_EQ(range_value[ikey], values[ifirst + ikey]);
+		}
+		//Capacity limits the result
+		EXPECT_SIZEEQ(btree_range(&tree, first, last, range_key, 0, 7), math_min(expect, 7));
+	}
+	EXPECT_SIZEEQ(btree_range(&tree, 100, 10, range_key, 0, 200), 0);
+
+	//Modify loaded tree, then reject unsorted input
+	for (ikey = 0; ikey < num_keys; ikey += 3)
+		btree_erase(&tree, keys[ikey]);
+	for (ikey = 0; ikey < num_keys; ikey += 2)
+		btree_insert(&tree, keys[ikey] + 1, 0);
+	EXPECT_TRUE(btree_verify(&tree));
+
+	keys[500] = keys[400];
+	log_enable_stdout(false);
+	EXPECT_FALSE(btree_load(&tree, keys, 0, num_keys));
+	log_enable_stdout(true);
+	EXPECT_SIZEEQ(btree_size(&tree), 0);
+	it = btree_begin(&tree);
+	EXPECT_TRUE(btree_iterator_done(&it));
+
+	btree_finalize(&tree);
+	memory_deallocate(keys);
+	memory_deallocate(values);
+
+	return 0;
+}
+
+DECLARE_TEST(btree, performance) {
+	//Radix sort indices are 16 bit
+	size_t num_keys = 65535;
+	size_t num_lookups = 1000000;
+	size_t num_ranges = 1000;
+	btree_t tree;
+	hashmap_t* map;
+	radixsort_t* sort;
+	uint64_t* keys = memory_allocate(0, sizeof(uint64_t) * num_keys, 0, MEMORY_PERSISTENT);
+	uint64_t* found = memory_allocate(0, sizeof(uint64_t) * num_keys, 0, MEMORY_PERSISTENT);
+	uint64_t* sorted = memory_allocate(0, sizeof(uint64_t) * num_keys, 0, MEMORY_PERSISTENT);
+	size_t ikey, ilookup, irange, ibucket, inode;
+	size_t checksum_tree = 0, checksum_map = 0;
+	tick_t start, time_tree, time_map;
+
+	btree_initialize(&tree);
+	map = hashmap_allocate(16381, 8);
+	sort = radixsort_allocate(RADIXSORT_UINT64, (radixsort_index_t)num_keys);
+	for (ikey = 0; ikey < num_keys; ++ikey) {
+		keys[ikey] = random64();
+		btree_insert(&tree, keys[ikey], (void*)(uintptr_t)(ikey + 1));
+		hashmap_insert(map, keys[ikey], (void*)(uintptr_t)(ikey + 1));
+	}
+
+	start = time_current();
+	for (ilookup = 0; ilookup < num_lookups; ++ilookup)
+		checksum_tree += (uintptr_t)btree_lookup(&tree, keys[(ilookup * 7919) % num_keys]);
+	time_tree = time_diff(start, time_current());
+	start = time_current();
+	for (ilookup = 0; ilookup < num_lookups; ++ilookup)
+		checksum_map += (uintptr_t)hashmap_lookup(map, keys[(ilookup * 7919) % num_keys]);
+	time_map = time_diff(start, time_current());
+	EXPECT_SIZEEQ(checksum_tree, checksum_map);
+	log_infof(HASH_TEST, STRING_CONST("Point lookups %" PRIsize ": btree %.2f ms, hashmap %.2f ms"),
+	          num_lookups, time_ticks_to_seconds(time_tree) * 1000.0,
+	          time_ticks_to_seconds(time_map) * 1000.0);
+
+	//Range queries covering about 100 keys each, hashmap must scan and sort
+	checksum_tree = checksum_map = 0;
+	start = time_current();
+	for (irange = 0; irange < num_ranges; ++irange) {
+		uint64_t first = keys[irange];
+		uint64_t last = first + ((UINT64_MAX / num_keys) * 100);
+		size_t count = btree_range(&tree, first, (last > first) ? last : UINT64_MAX, found, 0, num_keys);
+		checksum_tree += count + (count ? (size_t)found[count / 2] : 0);
+	}
+	time_tree = time_diff(start, time_current());
+	start = time_current();
+	for (irange = 0; irange < num_ranges; ++irange) {
+		uint64_t first = keys[irange];
+		uint64_t last = first + ((UINT64_MAX / num_keys) * 100);
+		const radixsort_index_t* order;
+		size_t count = 0;
+		if (last < first)
+			last = UINT64_MAX;
+		for (ibucket = 0; ibucket < map->num_buckets; ++ibucket) {
+			hashmap_node_t* bucket = map->bucket[ibucket];
+			for (inode = 0; inode < array_size(bucket); ++inode) {
+				if ((bucket[inode].key >= first) && (bucket[inode].key <= last))
+					found[count++] = bucket[inode].key;
+			}
+		}
+		order = radixsort_sort(sort, found, (radixsort_index_t)count);
+		for (ikey = 0; ikey < count; ++ikey)
+			sorted[ikey] = found[order[ikey]];
+		checksum_map += count + (count ? (size_t)sorted[count / 2] : 0);
+	}
+	time_map = time_diff(start, time_current());
+	EXPECT_SIZEEQ(checksum_tree, checksum_map);
+	log_infof(HASH_TEST, STRING_CONST("Range queries %" PRIsize ": btree %.2f ms, hashmap and sort %.2f ms"),
+	          num_ranges, time_ticks_to_seconds(time_tree) * 1000.0,
+	          time_ticks_to_seconds(time_map) * 1000.0);
+
+	//Full sorted iteration
+	checksum_tree = checksum_map = 0;
+	start = time_current();
+	{
+		btree_iterator_t it;
+		for (it = btree_begin(&tree); !btree_iterator_done(&it); btree_iterator_next(&it))
+			checksum_tree = (checksum_tree * 31) + (size_t)btree_iterator_key(&it);
+	}
+	time_tree = time_diff(start, time_current());
+	start = time_current();
+	{
+		const radixsort_index_t* order;
+		size_t count = 0;
+		for (ibucket = 0; ibucket < map->num_buckets; ++ibucket) {
+			hashmap_node_t* bucket = map->bucket[ibucket];
+			for (inode = 0; inode < array_size(bucket); ++inode)
+				found[count++] = bucket[inode].key;
+		}
+		order = radixsort_sort(sort, found, (radixsort_index_t)count);
+		for (ikey = 0; ikey < count; ++ikey)
+			checksum_map = (checksum_map * 31) + (size_t)found[order[ikey]];
+	}
+	time_map = time_diff(start, time_current());
+	EXPECT_SIZEEQ(checksum_tree, checksum_map);
+	log_infof(HASH_TEST, STRING_CONST("Sorted iteration %" PRIsize " keys: btree %.2f ms, hashmap and sort %.2f ms"),
+	          num_keys, time_ticks_to_seconds(time_tree) * 1000.0,
+	          time_ticks_to_seconds(time_map) * 1000.0);
+
+	qsort(keys, num_keys, sizeof(uint64_t), btree_key_compare);
+	start = time_current();
+	EXPECT_TRUE(btree_load(&tree, keys, 0, num_keys));
+	time_tree = time_diff(start, time_current());
+	log_infof(HASH_TEST, STRING_CONST("Bulk load %" PRIsize " keys: %.2f ms"),
+	          num_keys, time_ticks_to_seconds(time_tree) * 1000.0);
+
+	radixsort_deallocate(sort);
+	hashmap_deallocate(map);
+	btree_finalize(&tree);
+	memory_deallocate(keys);
+	memory_deallocate(found);
+	memory_deallocate(sorted);
+
+	return 0;
+}
+
+static void
+test_btree_declare(void) {
+	ADD_TEST(btree, basic);
+	ADD_TEST(btree, random);
+	ADD_TEST(btree, range);
+	ADD_TEST(btree, performance);
+}
+
+static test_suite_t test_btree_suite = {
+	test_btree_application,
+	test_btree_memory_system,
+	test_btree_config,
+	test_btree_declare,
+	test_btree_initialize,
+	test_btree_finalize,
+	0
+};
+
+#if BUILD_MONOLITHIC
+
+int
+test_btree_run(void);
+
+int
+test_btree_run(void) {
+	test_suite = test_btree_suite;
+	return test_run_all();
+}
+
+#else
+
+test_suite_t
+test_suite_define(void);
+
+test_suite_t
+test_suite_define(void) {
+	return test_btree_suite;
+}
+
+#endif
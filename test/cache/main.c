@@ -0,0 +1,519 @@
+/* main.c  -  Foundation cache test  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+#include <test/test.h>
+
+static application_t
+test_cache_application(void) {
+	application_t app;
+	memset(&app, 0, sizeof(app));
+	app.name = string_const(STRING_CONST("Foundation cache tests"));
+	app.short_name = string_const(STRING_CONST("test_cache"));
+	app.company = string_const(STRING_CONST("Rampant Pixels"));
+	app.flags = APPLICATION_UTILITY;
+	app.exception_handler = test_exception_handler;
+	return app;
+}
+
+static memory_system_t
+test_cache_memory_system(void) {
+	return memory_system_malloc();
+}
+
+static foundation_config_t
+test_cache_config(void) {
+	foundation_config_t config;
+	memset(&config, 0, sizeof(config));
+	return config;
+}
+
+static int
+test_cache_initialize(void) {
+	return 0;
+}
+
+static void
+test_cache_finalize(void) {
+}
+
+static atomic64_t cache_evicted_count;
+static atomic64_t cache_evicted_cost;
+
+static void
+cache_evict_count(hash_t key, void* value, size_t cost) {
+	FOUNDATION_UNUSED(key);
+	FOUNDATION_UNUSED(value);
+	atomic_incr64(&cache_evicted_count);
+	atomic_add64(&cache_evicted_cost, (int64_t)cost);
+}
+
+static void
+cache_reset_evicted(void) {
+	atomic_store64(&cache_evicted_count, 0);
+	atomic_store64(&cache_evicted_cost, 0);
+}
+
+typedef struct {
+	cache_t* cache;
+	const uint32_t* trace;
+	size_t trace_length;
+	size_t trace_offset;
+	uint64_t id;
+	size_t num_ops;
+	size_t num_keys;
+	size_t inserted;
+	size_t failed;
+} cache_arg_t;
+
+static uint32_t*
+cache_zipf_trace(size_t num_keys, size_t length, real skew) {
+	//Inverse transform sampling over the cumulative distribution of key ranks
+	uint32_t* trace = memory_allocate(0, sizeof(uint32_t) * length, 0, MEMORY_PERSISTENT);
+	real* cdf = memory_allocate(0, sizeof(real) * num_keys, 0, MEMORY_PERSISTENT);
+	real sum = 0;
+	size_t ikey, itrace;
+	for (ikey = 0; ikey < num_keys; ++ikey) {
+		sum += REAL_C(1.0) / math_pow((real)(ikey + 1), skew);
+		cdf[ikey] = sum;
+	}
+	for (itrace = 0; itrace < length; ++itrace) {
+		real value = random_normalized() * sum;
+		size_t low = 0, high = num_keys - 1;
+		while (low < high) {
+			size_t mid = (low + high) / 2;
+			if (cdf[mid] < value)
+				low = mid + 1;
+			else
+				high = mid;
+		}
+		trace[itrace] = (uint32_t)low;
+	}
+	memory_deallocate(cdf);
+	return trace;
+}
+
+static hash_t
+cache_key(uint32_t rank) {
+	return hash(&rank, sizeof(rank));
+}
+
+static void*
+cache_thread(void* arg) {
+	cache_arg_t* parg = arg;
+	size_t iop;
+	for (iop = 0; iop < parg->num_ops; ++iop) {
+		uint32_t rank = random32_range(0, (uint32_t)parg->num_keys);
+		hash_t key = cache_key(rank);
+		if (!cache_lookup(parg->cache, key)) {
+			//Unique values, so every insert results in exactly one eviction callback
+			void* value = (void*)(uintptr_t)((parg->id << 32) | (iop + 1));
+			if (cache_insert(parg->cache, key, value, 1 + (rank % 16)))
+				++parg->inserted;
+			else
+				++parg->failed;
+		}
+	}
+	return 0;
+}
+
+static void*
+cache_trace_thread(void* arg) {
+	cache_arg_t* parg = arg;
+	size_t iop;
+	for (iop = 0; iop < parg->num_ops; ++iop) {
+		uint32_t rank = parg->trace[(parg->trace_offset + iop) % parg->trace_length];
+		hash_t key = cache_key(rank);
+		if (!cache_lookup(parg->cache, key))
+			cache_insert(parg->cache, key, (void*)(uintptr_t)(rank + 1), 1);
+	}
+	return 0;
+}
+
+typedef struct {
+	atomic32_t ref;
+	uint32_t rank;
+} cache_value_t;
+
+static atomic64_t cache_values_freed;
+
+static void
+cache_value_release(cache_value_t* value) {
+	if (atomic_decr32(&value->ref) == 0) {
+		value->rank = 0xFFFFFFFFU;
+		memory_deallocate(value);
+		atomic_incr64(&cache_values_freed);
+	}
+}
+
+static void
+cache_value_retain(hash_t key, void* value, size_t cost) {
+	FOUNDATION_UNUSED(key);
+	FOUNDATION_UNUSED(cost);
+	atomic_incr32(&((cache_value_t*)value)->ref);
+}
+
+static void
+cache_value_evict(hash_t key, void* value, size_t cost) {
+	FOUNDATION_UNUSED(key);
+	FOUNDATION_UNUSED(cost);
+	cache_value_release(value);
+}
+
+static void*
+cache_retain_thread(void* arg) {
+	cache_arg_t* parg = arg;
+	size_t iop;
+	for (iop = 0; iop < parg->num_ops; ++iop) {
+		uint32_t rank = random32_range(0, (uint32_t)parg->num_keys);
+		hash_t key = cache_key(rank);
+		cache_value_t* value = cache_lookup_retain(parg->cache, key, cache_value_retain);
+		if (value) {
+			//Value stays alive while referenced even if evicted by another thread
+			if (value->rank != rank)
+				++parg->failed;
+			thread_yield();
+			if (value->rank != rank)
+				++parg->failed;
+			cache_value_release(value);
+		}
+		else {
+			value = memory_allocate(0, sizeof(cache_value_t), 0, MEMORY_PERSISTENT);
+			atomic_store32(&value->ref, 1);
+			value->rank = rank;
+			if (cache_insert(parg->cache, key, value, 1))
+				++parg->inserted;
+			else
+				cache_value_release(value);
+		}
+	}
+	return 0;
+}
+
+DECLARE_TEST(cache, basic) {
+	cache_t* cache;
+	cache_statistics_t statistics;
+	hash_t key;
+
+	cache_reset_evicted();
+	cache = cache_allocate(1000, 0, cache_evict_count);
+
+	EXPECT_EQ(cache_lookup(cache, 1), nullptr);
+	EXPECT_FALSE(cache_erase(cache, 1));
+
+	EXPECT_TRUE(cache_insert(cache, 1, (void*)(uintptr_t)1, 100));
+	EXPECT_TRUE(cache_insert(cache, 2, (void*)(uintptr_t)2, 200));
+	EXPECT_EQ(cache_lookup(cache, 1), (void*)(uintptr_t)1);
+	EXPECT_EQ(cache_lookup(cache, 2), (void*)(uintptr_t)2);
+
+	//Replacing with a new value evicts the old one, same value does not
+	EXPECT_TRUE(cache_insert(cache, 1, (void*)(uintptr_t)3, 150));
+	EXPECT_EQ(atomic_load64(&cache_evicted_count), 1);
+	EXPECT_EQ(atomic_load64(&cache_evicted_cost), 100);
+	EXPECT_TRUE(cache_insert(cache, 1, (void*)(uintptr_t)3, 150));
+	EXPECT_EQ(atomic_load64(&cache_evicted_count), 1);
+	EXPECT_EQ(cache_lookup(cache, 1), (void*)(uintptr_t)3);
+
+	statistics = cache_statistics(cache);
+	EXPECT_EQ(statistics.count, 2);
+	EXPECT_EQ(statistics.used, 350);
+	EXPECT_EQ(statistics.budget, 1000);
+	EXPECT_EQ(statistics.inserts, 2);
+	EXPECT_EQ(statistics.hits, 3);
+	EXPECT_EQ(statistics.misses, 1);
+	EXPECT_EQ(statistics.evictions, 0);
+
+	EXPECT_TRUE(cache_erase(cache, 2));
+	EXPECT_FALSE(cache_erase(cache, 2));
+	EXPECT_EQ(cache_lookup(cache, 2), nullptr);
+	EXPECT_EQ(atomic_load64(&cache_evicted_count), 2);
+	EXPECT_EQ(atomic_load64(&cache_evicted_cost), 300);
+
+	//Cost above budget is rejected and ownership stays with the caller
+	EXPECT_FALSE(cache_insert(cache, 4, (void*)(uintptr_t)4, 1001));
+	EXPECT_EQ(cache_lookup(cache, 4), nullptr);
+	EXPECT_TRUE(cache_insert(cache, 4, (void*)(uintptr_t)4, 1000));
+	statistics = cache_statistics(cache);
+	EXPECT_EQ(statistics.count, 1);
+	EXPECT_EQ(statistics.used, 1000);
+	EXPECT_EQ(statistics.evictions, 1);
+	EXPECT_EQ(cache_lookup(cache, 1), nullptr);
+
+	//Many keys, growing the index and recycling entries
+	for (key = 100; key < 10100; ++key)
+		EXPECT_TRUE(cache_insert(cache, key, (void*)(uintptr_t)key, 1));
+	statistics = cache_statistics(cache);
+	EXPECT_EQ(statistics.count, 1000);
+	EXPECT_EQ(statistics.used, 1000);
+	for (key = 9100; key < 10100; ++key)
+		EXPECT_EQ(cache_lookup(cache, key), (void*)(uintptr_t)key);
+	for (key = 100; key < 9100; ++key)
+		EXPECT_EQ(cache_lookup(cache, key), nullptr);
+	for (key = 9100; key < 10100; key += 2)
+		EXPECT_TRUE(cache_erase(cache, key));
+	for (key = 9100; key < 10100; ++key)
+		EXPECT_EQ(cache_lookup(cache, key), (key & 1) ? (void*)(uintptr_t)key : nullptr);
+
+	cache_clear(cache);
+	statistics = cache_statistics(cache);
+	EXPECT_EQ(statistics.count, 0);
+	EXPECT_EQ(statistics.used, 0);
+	EXPECT_EQ(cache_lookup(cache, 9101), nullptr);
+	EXPECT_TRUE(cache_insert(cache, 5, (void*)(uintptr_t)5, 10));
+
+	cache_deallocate(cache);
+	//Every value inserted has been passed to the eviction function exactly once
+	EXPECT_EQ(atomic_load64(&cache_evicted_count), 2 + 1 + 1 + 10000 + 1);
+
+	return 0;
+}
+
+DECLARE_TEST(cache, eviction) {
+	cache_t cache;
+	hash_t key;
+
+	cache_reset_evicted();
+	cache_initialize(&cache, 100, 0, cache_evict_count);
+
+	//Hot keys hit twice are protected from a scan of keys seen once
+	for (key = 1; key <= 50; ++key)
+		cache_insert(&cache, key, (void*)(uintptr_t)key, 1);
+	for (key = 1; key <= 50; ++key)
+		EXPECT_EQ(cache_lookup(&cache, key), (void*)(uintptr_t)key);
+	for (key = 1000; key < 2000; ++key)
+		cache_insert(&cache, key, (void*)(uintptr_t)key, 1);
+	for (key = 1; key <= 50; ++key)
+		EXPECT_EQ(cache_lookup(&cache, key), (void*)(uintptr_t)key);
+	EXPECT_EQ(cache_lookup(&cache, 1000), nullptr);
+	EXPECT_EQ(cache_lookup(&cache, 1999), (void*)(uintptr_t)1999);
+
+	//Protected segment is bounded, older protected keys are demoted and then evicted
+	for (key = 2000; key < 2100; ++key) {
+		cache_insert(&cache, key, (void*)(uintptr_t)key, 1);
+		cache_lookup(&cache, key);
+	}
+	EXPECT_EQ(cache_lookup(&cache, 1), nullptr);
+	EXPECT_EQ(cache_lookup(&cache, 2099), (void*)(uintptr_t)2099);
+	EXPECT_EQ(cache_statistics(&cache).used, 100);
+
+	//Large entry evicts as many entries as needed, but never itself
+	EXPECT_TRUE(cache_insert(&cache, 3000, (void*)(uintptr_t)3000, 95));
+	EXPECT_EQ(cache_lookup(&cache, 3000), (void*)(uintptr_t)3000);
+	EXPECT_LE(cache_statistics(&cache).used, 100);
+	EXPECT_LE(cache_statistics(&cache).count, 6);
+	EXPECT_TRUE(cache_insert(&cache, 3001, (void*)(uintptr_t)3001, 100));
+	EXPECT_EQ(cache_statistics(&cache).count, 1);
+	EXPECT_EQ(cache_lookup(&cache, 3001), (void*)(uintptr_t)3001);
+
+	cache_finalize(&cache);
+	EXPECT_EQ(atomic_load64(&cache_evicted_count), 50 + 1000 + 100 + 2);
+
+	return 0;
+}
+
+DECLARE_TEST(cache, concurrent) {
+	thread_t thread[32];
+	cache_arg_t args[32];
+	cache_t* cache;
+	cache_statistics_t statistics;
+	size_t i, num_threads, inserted = 0;
+
+	cache_reset_evicted();
+	cache = cache_allocate(20000, 8, cache_evict_count);
+
+	num_threads = math_clamp(system_hardware_threads() * 2U, 4U, 32U);
+	for (i = 0; i < num_threads; ++i) {
+		memset(args + i, 0, sizeof(cache_arg_t));
+		args[i].cache = cache;
+		args[i].id = i + 1;
+		args[i].num_ops = 100000;
+		args[i].num_keys = 10000;
+		thread_initialize(&thread[i], cache_thread, args + i, STRING_CONST("cache_thread"),
+		                  THREAD_PRIORITY_NORMAL, 0);
+	}
+	for (i = 0; i < num_threads; ++i)
+		thread_start(&thread[i]);
+
+	test_wait_for_threads_startup(thread, num_threads);
+	test_wait_for_threads_finish(thread, num_threads);
+
+	for (i = 0; i < num_threads; ++i) {
+		thread_finalize(&thread[i]);
+		EXPECT_SIZEEQ(args[i].failed, 0);
+		inserted += args[i].inserted;
+	}
+
+	statistics = cache_statistics(cache);
+	EXPECT_LE(statistics.used, statistics.budget);
+	EXPECT_EQ(statistics.hits + statistics.misses, num_threads * 100000);
+	EXPECT_EQ(statistics.misses, inserted);
+	//Racing misses on the same key end up as replacements, not new entries
+	EXPECT_LE(statistics.inserts, inserted);
+	EXPECT_EQ((uint64_t)atomic_load64(&cache_evicted_count) + statistics.count, inserted);
+
+	cache_deallocate(cache);
+	EXPECT_EQ(atomic_load64(&cache_evicted_count), (int64_t)inserted);
+
+	return 0;
+}
+
+DECLARE_TEST(cache, retain) {
+	thread_t thread[32];
+	cache_arg_t args[32];
+	cache_t* cache;
+	size_t i, num_threads, inserted = 0;
+
+	atomic_store64(&cache_values_freed, 0);
+	//Small budget to evict values while other threads are using them
+	cache = cache_allocate(256, 4, cache_value_evict);
+
+	num_threads = math_clamp(system_hardware_threads() * 2U, 4U, 32U);
+	for (i = 0; i < num_threads; ++i) {
+		memset(args + i, 0, sizeof(cache_arg_t));
+		args[i].cache = cache;
+		args[i].id = i + 1;
+		args[i].num_ops = 50000;
+		args[i].num_keys = 1024;
+		thread_initialize(&thread[i], cache_retain_thread, args + i, STRING_CONST("cache_thread"),
+		                  THREAD_PRIORITY_NORMAL, 0);
+	}
+	for (i = 0; i < num_threads; ++i)
+		thread_start(&thread[i]);
+
+	test_wait_for_threads_startup(thread, num_threads);
+	test_wait_for_threads_finish(thread, num_threads);
+
+	for (i = 0; i < num_threads; ++i) {
+		thread_finalize(&thread[i]);
+		EXPECT_SIZEEQ(args[i].failed, 0);
+		inserted += args[i].inserted;
+	}
+	EXPECT_SIZEGT(cache_statistics(cache).evictions, 0);
+
+	cache_deallocate(cache);
+	EXPECT_EQ(atomic_load64(&cache_values_freed), (int64_t)inserted);
+
+	return 0;
+}
+
+DECLARE_TEST(cache, performance) {
+	size_t num_keys = 100000;
+	size_t trace_length = 1000000;
+	uint32_t* trace = cache_zipf_trace(num_keys, trace_length, REAL_C(0.99));
+	size_t budgets[] = {1000, 10000, 30000};
+	size_t ibudget, num_threads, i;
+	thread_t thread[16];
+	cache_arg_t args[16];
+	tick_t start, elapsed;
+
+	for (ibudget = 0; ibudget < sizeof(budgets) / sizeof(budgets[0]); ++ibudget) {
+		cache_t cache;
+		cache_statistics_t statistics;
+		cache_arg_t arg;
+
+		cache_initialize(&cache, budgets[ibudget], 0, nullptr);
+		memset(&arg, 0, sizeof(arg));
+		arg.cache = &cache;
+		arg.trace = trace;
+		arg.trace_length = trace_length;
+		arg.num_ops = trace_length;
+		start = time_current();
+		cache_trace_thread(&arg);
+		elapsed = time_diff(start, time_current());
+		statistics = cache_statistics(&cache);
+		EXPECT_LE(statistics.used, budgets[ibudget]);
+		log_infof(HASH_TEST, STRING_CONST("Zipf trace %" PRIsize " accesses, %" PRIsize " keys, budget %" PRIsize ": hit ratio %.1f%%, %" PRIu64 " evictions, %.2f ms"),
+		          trace_length, num_keys, budgets[ibudget],
+		          (double)statistics.hits * 100.0 / (double)(statistics.hits + statistics.misses),
+		          statistics.evictions, time_ticks_to_seconds(elapsed) * 1000.0);
+		cache_finalize(&cache);
+	}
+
+	for (num_threads = 1; num_threads <= math_clamp(system_hardware_threads(), 4U, 16U); num_threads *= 2) {
+		cache_t cache;
+		cache_statistics_t statistics;
+
+		cache_initialize(&cache, 10000, 16, nullptr);
+		for (i = 0; i < num_threads; ++i) {
+			memset(args + i, 0, sizeof(cache_arg_t));
+			args[i].cache = &cache;
+			args[i].trace = trace;
+			args[i].trace_length = trace_length;
+			args[i].trace_offset = (trace_length / num_threads) * i;
+			args[i].num_ops = trace_length / num_threads;
+			thread_initialize(&thread[i], cache_trace_thread, args + i, STRING_CONST("cache_trace"),
+			                  THREAD_PRIORITY_NORMAL, 0);
+		}
+		start = time_current();
+		for (i = 0; i < num_threads; ++i)
+			thread_start(&thread[i]);
+		test_wait_for_threads_startup(thread, num_threads);
+		test_wait_for_threads_finish(thread, num_threads);
+		elapsed = time_diff(start, time_current());
+		for (i = 0; i < num_threads; ++i)
+			thread_finalize(&thread[i]);
+
+		statistics = cache_statistics(&cache);
+		EXPECT_LE(statistics.used, statistics.budget);
+		log_infof(HASH_TEST, STRING_CONST("Zipf trace %" PRIsize " accesses, 16 shards, %" PRIsize " threads: hit ratio %.1f%%, %.2f ms"),
+		          trace_length, num_threads,
+		          (double)statistics.hits * 100.0 / (double)(statistics.hits + statistics.misses),
+		          time_ticks_to_seconds(elapsed) * 1000.0);
+		cache_finalize(&cache);
+	}
+
+	memory_deallocate(trace);
+
+	return 0;
+}
+
+static void
+test_cache_declare(void) {
+	ADD_TEST(cache, basic);
+	ADD_TEST(cache, eviction);
+	ADD_TEST(cache, concurrent);
+	ADD_TEST(cache, retain);
+	ADD_TEST(cache, performance);
+}
+
+static test_suite_t test_cache_suite = {
+	test_cache_application,
+	test_cache_memory_system,
+	test_cache_config,
+	test_cache_declare,
+	test_cache_initialize,
+	test_cache_finalize,
+	0
+};
+
+#if BUILD_MONOLITHIC
+
+int
+test_cache_run(void);
+
+int
+test_cache_run(void) {
+	test_suite = test_cache_suite;
+	return test_run_all();
+}
+
+#else
+
+test_suite_t
+test_suite_define(void);
+
+test_suite_t
+test_suite_define(void) {
+	return test_cache_suite;
+}
+
+#endif
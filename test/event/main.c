@@ -571,6 +571,552 @@ DECLARE_TEST(event, delay_threaded) {
 	return 0;
 }
 
+static atomic32_t test_event_released;
+
+static void
+test_event_release(void* data, size_t size, void* context) {
+	FOUNDATION_UNUSED(size);
+	FOUNDATION_UNUSED(context);
+	atomic_incr32(&test_event_released);
+	memset(data, 0, 16);
+}
+
+DECLARE_TEST(event, reference) {
+	event_stream_t* stream;
+	event_block_t* block;
+	event_t* event;
+	size_t size = 1024 * 1024;
+	size_t iloop, loops = 1000;
+	char* data = memory_allocate(0, size, 0, MEMORY_PERSISTENT);
+	char* small = memory_allocate(0, 32 * 1024, 0, MEMORY_PERSISTENT);
+	tick_t start, copytime, reftime;
+	uint64_t sum = 0;
+
+	memset(data, 0x5A, size);
+	memset(small, 0x3C, 32 * 1024);
+	atomic_store32(&test_event_released, 0);
+
+	stream = event_stream_allocate(0);
+
+	//Payload larger than event size limit is passed without copy
+	event_post(stream, 1, 0, 0, "before", 6);
+	event_post_reference(stream, 2, 42, 0, data, size, test_event_release, nullptr);
+	event_post(stream, 3, 0, 0, "after", 5);
+
+	block = event_stream_process(stream);
+	event = event_next(block, 0);
+	EXPECT_NE(event, 0);
+	EXPECT_EQ(event->id, 1);
+	EXPECT_EQ(event_payload(event), event->payload);
+	EXPECT_EQ(event_payload_size(event), 8);
+	event = event_next(block, event);
+	EXPECT_NE(event, 0);
+	EXPECT_EQ(event->id, 2);
+	EXPECT_EQ(event->object, 42);
+	EXPECT_EQ(event->flags, EVENTFLAG_REFERENCE);
+	EXPECT_EQ(event_payload(event), data);
+	EXPECT_SIZEEQ(event_payload_size(event), size);
+	event = event_next(block, event);
+	EXPECT_NE(event, 0);
+	EXPECT_EQ(event->id, 3);
+	EXPECT_EQ(event_payload_size(event), 8);
+	EXPECT_EQ(event_next(block, event), 0);
+
+	//Released once block is processed
+	EXPECT_INTEQ(atomic_load32(&test_event_released), 0);
+	EXPECT_INTEQ(data[0], 0x5A);
+	block = event_stream_process(stream);
+	EXPECT_INTEQ(atomic_load32(&test_event_released), 1);
+	EXPECT_INTEQ(data[0], 0);
+	EXPECT_INTEQ(data[16], 0x5A);
+	EXPECT_EQ(event_next(block, 0), 0);
+	block = event_stream_process(stream);
+	EXPECT_INTEQ(atomic_load32(&test_event_released), 1);
+
+	//Released even if not iterated
+	event_post_reference(stream, 4, 0, 0, data, size, test_event_release, nullptr);
+	block = event_stream_process(stream);
+	block = event_stream_process(stream);
+	EXPECT_INTEQ(atomic_load32(&test_event_released), 2);
+
+	//Delayed events keep the reference across re-posts
+	event_post_reference(stream, 5, 0, time_current() + (time_ticks_per_second() / 10),
+	                     data, size, test_event_release, nullptr);
+	do {
+		block = event_stream_process(stream);
+		event = event_next(block, 0);
+		if (!event) {
+			EXPECT_INTEQ(atomic_load32(&test_event_released), 2);
+			thread_sleep(5);
+		}
+	}
+	while (!event);
+	EXPECT_EQ(event->id, 5);
+	EXPECT_EQ(event->flags, EVENTFLAG_REFERENCE | EVENTFLAG_DELAY);
+	EXPECT_EQ(event_payload(event), data);
+	EXPECT_SIZEEQ(event_payload_size(event), size);
+	EXPECT_EQ(event_next(block, event), 0);
+	block = event_stream_process(stream);
+	EXPECT_INTEQ(atomic_load32(&test_event_released), 3);
+
+	//Pending references are released when stream is finalized
+	event_post_reference(stream, 6, 0, 0, data, size, test_event_release, nullptr);
+	block = event_stream_process(stream);
+	event_post_reference(stream, 7, 0, 0, data, size, test_event_release, nullptr);
+	event_post_reference(stream, 8, 0, time_current() + time_ticks_per_second(),
+	                     data, size, test_event_release, nullptr);
+	event_post_reference(stream, 9, 0, 0, data, size, nullptr, nullptr);
+	event_stream_deallocate(stream);
+	EXPECT_INTEQ(atomic_load32(&test_event_released), 6);
+
+	//Compare posting a 32KiB payload by copy and by reference
+	stream = event_stream_allocate(0);
+	start = time_current();
+	for (iloop = 0; iloop < loops; ++iloop) {
+		event_post(stream, 1, 0, 0, small, 32 * 1024 - 32);
+		block = event_stream_process(stream);
+		event = event_next(block, 0);
+		sum += (uint8_t)((char*)event_payload(event))[iloop % 1024];
+	}
+	copytime = time_diff(start, time_current());
+	start = time_current();
+	for (iloop = 0; iloop < loops; ++iloop) {
+		event_post_reference(stream, 1, 0, 0, small, 32 * 1024, nullptr, nullptr);
+		block = event_stream_process(stream);
+		event = event_next(block, 0);
+		sum += (uint8_t)((char*)event_payload(event))[iloop % 1024];
+	}
+	reftime = time_diff(start, time_current());
+	event_stream_deallocate(stream);
+	EXPECT_TRUE(sum == (uint64_t)0x3C * 2 * loops);
+
+	log_infof(HASH_TEST, STRING_CONST("Event 32KiB payload post and process: copy %.3f us, reference %.3f us"),
+	          (double)time_ticks_to_seconds(copytime) * 1000000.0 / (double)loops,
+	          (double)time_ticks_to_seconds(reftime) * 1000000.0 / (double)loops);
+
+	memory_deallocate(small);
+	memory_deallocate(data);
+
+	return 0;
+}
+
+DECLARE_TEST(event, broadcast) {
+	event_broadcast_t* broadcast;
+	event_subscriber_t* all;
+	event_subscriber_t* odd;
+	event_subscriber_t* even;
+	event_subscriber_t* late;
+	event_subscriber_t* subscriber[EVENT_BROADCAST_MAX_SUBSCRIBERS];
+	event_t* event;
+	event_t* first;
+	beacon_t beacon;
+	int odd_ids[] = {1, 3};
+	int even_ids[] = {2};
+	int ival;
+	size_t isub;
+	char data[64];
+
+	atomic_store32(&test_event_released, 0);
+	broadcast = event_broadcast_allocate();
+
+	all = event_broadcast_subscribe(broadcast, nullptr, 0);
+	odd = event_broadcast_subscribe(broadcast, odd_ids, 2);
+	even = event_broadcast_subscribe(broadcast, even_ids, 1);
+	EXPECT_NE(all, 0);
+	EXPECT_NE(odd, 0);
+	EXPECT_NE(even, 0);
+
+	event_subscriber_process(all);
+	EXPECT_EQ(event_subscriber_next(all, 0), 0);
+
+	//Each subscriber receives events matching its filter, in posting order
+	for (ival = 1; ival <= 4; ++ival)
+		event_broadcast_post(broadcast, ival, (object_t)ival, &ival, sizeof(ival));
+
+	event_subscriber_process(all);
+	event_subscriber_process(odd);
+	event_subscriber_process(even);
+
+	first = event = event_subscriber_next(all, 0);
+	for (ival = 1; ival <= 4; ++ival) {
+		EXPECT_NE(event, 0);
+		EXPECT_INTEQ(event->id, ival);
+		EXPECT_EQ(event->object, (object_t)ival);
+		EXPECT_INTEQ(*(int*)event_payload(event), ival);
+		event = event_subscriber_next(all, event);
+	}
+	EXPECT_EQ(event, 0);
+
+	//Events are stored once and shared
+	event = event_subscriber_next(odd, 0);
+	EXPECT_EQ(event, first);
+	event = event_subscriber_next(odd, event);
+	EXPECT_NE(event, 0);
+	EXPECT_INTEQ(event->id, 3);
+	EXPECT_EQ(event_subscriber_next(odd, event), 0);
+
+	event = event_subscriber_next(even, 0);
+	EXPECT_NE(event, 0);
+	EXPECT_INTEQ(event->id, 2);
+	EXPECT_EQ(event_subscriber_next(even, event), 0);
+
+	//Subscriber starts receiving events posted after subscribing
+	late = event_broadcast_subscribe(broadcast, nullptr, 0);
+	event_subscriber_process(late);
+	EXPECT_EQ(event_subscriber_next(late, 0), 0);
+
+	//Referenced payload is released once all subscribers processed the block
+	event_broadcast_post_reference(broadcast, 2, 0, data, sizeof(data), test_event_release, nullptr);
+	event_broadcast_post(broadcast, 4, 0, nullptr, 0);
+	event_subscriber_process(all);
+	event = event_subscriber_next(all, 0);
+	EXPECT_NE(event, 0);
+	EXPECT_EQ(event->flags, EVENTFLAG_REFERENCE);
+	EXPECT_EQ(event_payload(event), data);
+	EXPECT_SIZEEQ(event_payload_size(event), sizeof(data));
+	event = event_subscriber_next(all, event);
+	EXPECT_NE(event, 0);
+	EXPECT_INTEQ(event->id, 4);
+	EXPECT_EQ(event_subscriber_next(all, event), 0);
+	event_subscriber_process(late);
+	event = event_subscriber_next(late, 0);
+	EXPECT_EQ(event_payload(event), data);
+	event_subscriber_process(even);
+	event = event_subscriber_next(even, 0);
+	EXPECT_EQ(event_payload(event), data);
+	EXPECT_EQ(event_subscriber_next(even, event), 0);
+
+	event_subscriber_process(all);
+	event_subscriber_process(late);
+	event_subscriber_process(even);
+	EXPECT_INTEQ(atomic_load32(&test_event_released), 0);
+	event_subscriber_process(odd);
+	EXPECT_EQ(event_subscriber_next(odd, 0), 0);
+	EXPECT_INTEQ(atomic_load32(&test_event_released), 0);
+	event_subscriber_process(odd);
+	EXPECT_INTEQ(atomic_load32(&test_event_released), 1);
+
+	//Events without subscribers are not stored
+	event_broadcast_unsubscribe(late);
+	event_broadcast_unsubscribe(all);
+	event_broadcast_post_reference(broadcast, 4, 0, data, sizeof(data), test_event_release, nullptr);
+	EXPECT_INTEQ(atomic_load32(&test_event_released), 2);
+	event_subscriber_process(odd);
+	event_subscriber_process(even);
+	EXPECT_EQ(event_subscriber_next(odd, 0), 0);
+	EXPECT_EQ(event_subscriber_next(even, 0), 0);
+
+	//Beacon fires for matching events only
+	beacon_initialize(&beacon);
+	event_subscriber_set_beacon(even, &beacon);
+	event_broadcast_post(broadcast, 1, 0, nullptr, 0);
+	EXPECT_INTLT(beacon_try_wait(&beacon, 0), 0);
+	event_broadcast_post(broadcast, 2, 0, nullptr, 0);
+	EXPECT_INTEQ(beacon_try_wait(&beacon, 0), 0);
+	event_broadcast_post(broadcast, 2, 0, nullptr, 0);
+	EXPECT_INTLT(beacon_try_wait(&beacon, 0), 0);
+	event_subscriber_process(even);
+	event_broadcast_post(broadcast, 2, 0, nullptr, 0);
+	EXPECT_INTEQ(beacon_try_wait(&beacon, 0), 0);
+	event_subscriber_set_beacon(even, nullptr);
+
+	//Large number of events spanning many blocks
+	for (ival = 0; ival < 10000; ++ival)
+		event_broadcast_post(broadcast, 1 + (ival % 3), 0, &ival, sizeof(ival));
+	event_subscriber_process(odd);
+	event = event_subscriber_next(odd, 0);
+	EXPECT_INTEQ(event->id, 1);
+	event = event_subscriber_next(odd, event);
+	for (ival = 0; ival < 10000; ival += 3) {
+		EXPECT_NE(event, 0);
+		EXPECT_INTEQ(event->id, 1);
+		EXPECT_INTEQ(*(int*)event_payload(event), ival);
+		event = event_subscriber_next(odd, event);
+		if (ival + 2 < 10000) {
+			EXPECT_NE(event, 0);
+			EXPECT_INTEQ(event->id, 3);
+			EXPECT_INTEQ(*(int*)event_payload(event), ival + 2);
+			event = event_subscriber_next(odd, event);
+		}
+	}
+	EXPECT_EQ(event, 0);
+
+	//Pending referenced payloads are released on finalize
+	event_broadcast_post_reference(broadcast, 1, 0, data, sizeof(data), test_event_release, nullptr);
+	event_broadcast_post_reference(broadcast, 3, 0, data, sizeof(data), test_event_release, nullptr);
+	event_subscriber_process(odd);
+	event_subscriber_process(even);
+	event_subscriber_process(even);
+	EXPECT_INTEQ(atomic_load32(&test_event_released), 2);
+	event_broadcast_unsubscribe(odd);
+	EXPECT_INTEQ(atomic_load32(&test_event_released), 4);
+	event_broadcast_post_reference(broadcast, 2, 0, data, sizeof(data), test_event_release, nullptr);
+	event_broadcast_deallocate(broadcast);
+	EXPECT_INTEQ(atomic_load32(&test_event_released), 5);
+	beacon_finalize(&beacon);
+
+	//Subscriber limit
+	broadcast = event_broadcast_allocate();
+	for (isub = 0; isub < EVENT_BROADCAST_MAX_SUBSCRIBERS; ++isub) {
+		subscriber[isub] = event_broadcast_subscribe(broadcast, even_ids, 1);
+		EXPECT_NE(subscriber[isub], 0);
+	}
+	log_enable_stdout(false);
+	EXPECT_EQ(event_broadcast_subscribe(broadcast, nullptr, 0), 0);
+	log_enable_stdout(true);
+	event_broadcast_unsubscribe(subscriber[10]);
+	EXPECT_EQ(event_broadcast_subscribe(broadcast, nullptr, 0), subscriber[10]);
+	event_broadcast_deallocate(broadcast);
+
+	return 0;
+}
+
+typedef struct {
+	event_broadcast_t* broadcast;
+	event_subscriber_t* subscriber;
+	unsigned int id;
+	unsigned int count;
+	unsigned int received;
+	unsigned int producers;
+	bool ordered;
+} broadcast_thread_arg_t;
+
+static void*
+broadcast_producer_thread(void* arg) {
+	broadcast_thread_arg_t* args = arg;
+	unsigned int ievent;
+	for (ievent = 0; ievent < args->count; ++ievent) {
+		event_broadcast_post(args->broadcast, (int)(1 + (ievent % 4)), args->id, &ievent, sizeof(ievent));
+		if (!(ievent % 128))
+			thread_yield();
+	}
+	return 0;
+}
+
+static void*
+broadcast_consumer_thread(void* arg) {
+	broadcast_thread_arg_t* args = arg;
+	unsigned int last[32];
+	unsigned int expected = args->count;
+	event_t* event;
+
+	memset(last, 0, sizeof(last));
+	args->ordered = true;
+	while (args->received < expected) {
+		event_subscriber_process(args->subscriber);
+		event = event_subscriber_next(args->subscriber, 0);
+		while (event) {
+			unsigned int sequence = *(unsigned int*)event_payload(event);
+			if (args->id && (event->id != args->id))
+				args->ordered = false;
+			if (last[event->object] && (sequence <= last[event->object] - 1))
+				args->ordered = false;
+			last[event->object] = sequence + 1;
+			++args->received;
+			event = event_subscriber_next(args->subscriber, event);
+		}
+		thread_yield();
+		if (thread_try_wait(0))
+			break;
+	}
+	return 0;
+}
+
+DECLARE_TEST(event, broadcast_threaded) {
+	thread_t producer[8];
+	thread_t consumer[5];
+	broadcast_thread_arg_t producer_args[8];
+	broadcast_thread_arg_t consumer_args[5];
+	event_broadcast_t* broadcast;
+	size_t iprod, icons;
+	size_t num_producers = math_clamp(system_hardware_threads(), 2, 8);
+	unsigned int count = 100000;
+	int ids[4];
+
+	broadcast = event_broadcast_allocate();
+
+	//Four subscribers receiving one event id each and one receiving all events
+	for (icons = 0; icons < 5; ++icons) {
+		ids[0] = (int)(icons + 1);
+		consumer_args[icons].broadcast = broadcast;
+		consumer_args[icons].subscriber = event_broadcast_subscribe(broadcast, (icons < 4) ? ids : nullptr, 1);
+		consumer_args[icons].id = (icons < 4) ? (unsigned int)(icons + 1) : 0;
+		consumer_args[icons].count = (unsigned int)num_producers * count / ((icons < 4) ? 4 : 1);
+		consumer_args[icons].received = 0;
+		thread_initialize(&consumer[icons], broadcast_consumer_thread, consumer_args + icons,
+		                  STRING_CONST("event_consumer"), THREAD_PRIORITY_NORMAL, 0);
+	}
+	for (iprod = 0; iprod < num_producers; ++iprod) {
+		producer_args[iprod].broadcast = broadcast;
+		producer_args[iprod].id = (unsigned int)iprod;
+		producer_args[iprod].count = count;
+		thread_initialize(&producer[iprod], broadcast_producer_thread, producer_args + iprod,
+		                  STRING_CONST("event_producer"), THREAD_PRIORITY_NORMAL, 0);
+	}
+	for (icons = 0; icons < 5; ++icons)
+		thread_start(&consumer[icons]);
+	for (iprod = 0; iprod < num_producers; ++iprod)
+		thread_start(&producer[iprod]);
+
+	for (iprod = 0; iprod < num_producers; ++iprod)
+		thread_finalize(&producer[iprod]);
+	for (icons = 0; icons < 5; ++icons) {
+		tick_t limit = time_current() + time_ticks_per_second() * 30;
+		while (thread_is_running(&consumer[icons]) && (time_current() < limit))
+			thread_sleep(10);
+		thread_signal(&consumer[icons]);
+		thread_finalize(&consumer[icons]);
+	}
+
+	for (icons = 0; icons < 5; ++icons) {
+		EXPECT_UINTEQ(consumer_args[icons].received, consumer_args[icons].count);
+		EXPECT_TRUE(consumer_args[icons].ordered);
+	}
+
+	event_broadcast_deallocate(broadcast);
+
+	return 0;
+}
+
+typedef struct {
+	event_stream_t* stream;
+	unsigned int count;
+} overflow_thread_arg_t;
+
+static void*
+overflow_producer_thread(void* arg) {
+	overflow_thread_arg_t* args = arg;
+	unsigned int ievent;
+	for (ievent = 0; ievent < args->count; ++ievent)
+		event_post(args->stream, 1, 0, 0, &ievent, sizeof(ievent));
+	return 0;
+}
+
+DECLARE_TEST(event, overflow) {
+	event_stream_t* stream;
+	event_block_t* block;
+	event_t* event;
+	thread_t thread;
+	overflow_thread_arg_t args;
+	unsigned int values[1000 * 4];
+	unsigned int last[8];
+	unsigned int ievent;
+	unsigned int received;
+	unsigned int expected;
+	bool ordered;
+	tick_t timeout;
+	size_t limit = 4096;
+
+	//Release function clears 16 bytes of referenced data
+	for (ievent = 0; ievent < 1000; ++ievent)
+		values[ievent * 4] = ievent;
+
+	//Drop newest keeps the first events
+	stream = event_stream_allocate(0);
+	event_stream_set_overflow(stream, limit, EVENT_OVERFLOW_DROP_NEWEST);
+	for (ievent = 0; ievent < 1000; ++ievent)
+		event_post(stream, 1, 0, 0, &ievent, sizeof(ievent));
+	EXPECT_UINTGT(event_stream_dropped(stream), 0);
+	EXPECT_SIZELE(stream->block[0].capacity, limit);
+
+	received = 0;
+	block = event_stream_process(stream);
+	event = event_next(block, 0);
+	while (event) {
+		EXPECT_UINTEQ(*(unsigned int*)event_payload(event), received);
+		++received;
+		event = event_next(block, event);
+	}
+	EXPECT_UINTGT(received, 0);
+	EXPECT_UINTEQ(received + event_stream_dropped(stream), 1000);
+	EXPECT_UINTEQ(event_stream_coalesced(stream), 0);
+	event_stream_deallocate(stream);
+
+	//Drop oldest keeps the last events and releases dropped references
+	atomic_store32(&test_event_released, 0);
+	stream = event_stream_allocate(0);
+	event_stream_set_overflow(stream, limit, EVENT_OVERFLOW_DROP_OLDEST);
+	for (ievent = 0; ievent < 1000; ++ievent)
+		event_post_reference(stream, 1, 0, 0, values + (ievent * 4), 16, test_event_release, nullptr);
+	EXPECT_UINTGT(event_stream_dropped(stream), 0);
+	EXPECT_UINTEQ(atomic_load32(&test_event_released), event_stream_dropped(stream));
+
+	received = 0;
+	expected = (unsigned int)event_stream_dropped(stream);
+	block = event_stream_process(stream);
+	event = event_next(block, 0);
+	while (event) {
+		EXPECT_UINTEQ(*(unsigned int*)event_payload(event), expected);
+		++expected;
+		++received;
+		event = event_next(block, event);
+	}
+	EXPECT_UINTEQ(expected, 1000);
+	EXPECT_UINTEQ(received + event_stream_dropped(stream), 1000);
+	event_stream_process(stream);
+	EXPECT_INTEQ(atomic_load32(&test_event_released), 1000);
+	event_stream_deallocate(stream);
+
+	//Coalesce replaces pending events with same id and object
+	stream = event_stream_allocate(0);
+	event_stream_set_overflow(stream, limit, EVENT_OVERFLOW_COALESCE);
+	for (ievent = 0; ievent < 1000; ++ievent)
+		event_post(stream, 1, ievent % 8, 0, &ievent, sizeof(ievent));
+	EXPECT_UINTGT(event_stream_coalesced(stream), 0);
+	EXPECT_UINTEQ(event_stream_dropped(stream), 0);
+
+	received = 0;
+	memset(last, 0, sizeof(last));
+	block = event_stream_process(stream);
+	event = event_next(block, 0);
+	while (event) {
+		unsigned int value = *(unsigned int*)event_payload(event);
+		EXPECT_UINTEQ(value % 8, event->object);
+		if (value > last[event->object])
+			last[event->object] = value;
+		++received;
+		event = event_next(block, event);
+	}
+	EXPECT_UINTEQ(received + event_stream_coalesced(stream), 1000);
+	for (ievent = 0; ievent < 8; ++ievent)
+		EXPECT_UINTEQ(last[ievent], 992 + ievent);
+	event_stream_deallocate(stream);
+
+	//Blocking slows down the producer until the consumer catches up
+	stream = event_stream_allocate(0);
+	event_stream_set_overflow(stream, limit, EVENT_OVERFLOW_BLOCK);
+	args.stream = stream;
+	args.count = 20000;
+	thread_initialize(&thread, overflow_producer_thread, &args, STRING_CONST("event_producer"),
+	                  THREAD_PRIORITY_NORMAL, 0);
+	thread_start(&thread);
+
+	received = 0;
+	ordered = true;
+	timeout = time_current() + time_ticks_per_second() * 30;
+	while ((received < args.count) && (time_current() < timeout)) {
+		thread_sleep(1);
+		block = event_stream_process(stream);
+		event = event_next(block, 0);
+		while (event) {
+			if (*(unsigned int*)event_payload(event) != received)
+				ordered = false;
+			++received;
+			event = event_next(block, event);
+		}
+	}
+	thread_finalize(&thread);
+
+	EXPECT_UINTEQ(received, args.count);
+	EXPECT_TRUE(ordered);
+	EXPECT_UINTEQ(event_stream_dropped(stream), 0);
+	EXPECT_SIZELE(stream->block[0].capacity, limit);
+	EXPECT_SIZELE(stream->block[1].capacity, limit);
+	event_stream_deallocate(stream);
+
+	return 0;
+}
+
 static void
 test_event_declare(void) {
 	ADD_TEST(event, empty);
@@ -578,6 +1124,10 @@ test_event_declare(void) {
 	ADD_TEST(event, delay);
 	ADD_TEST(event, immediate_threaded);
 	ADD_TEST(event, delay_threaded);
+	ADD_TEST(event, reference);
+	ADD_TEST(event, broadcast);
+	ADD_TEST(event, broadcast_threaded);
+	ADD_TEST(event, overflow);
 }
 
 static test_suite_t test_event_suite = {
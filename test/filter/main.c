@@ -0,0 +1,319 @@
+/* main.c  -  Foundation filter test  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+#include <test/test.h>
+
+static application_t
+test_filter_application(void) {
+	application_t app;
+	memset(&app, 0, sizeof(app));
+	app.name = string_const(STRING_CONST("Foundation filter tests"));
+	app.short_name = string_const(STRING_CONST("test_filter"));
+	app.company = string_const(STRING_CONST("Rampant Pixels"));
+	app.flags = APPLICATION_UTILITY;
+	app.exception_handler = test_exception_handler;
+	return app;
+}
+
+static memory_system_t
+test_filter_memory_system(void) {
+	return memory_system_malloc();
+}
+
+static foundation_config_t
+test_filter_config(void) {
+	foundation_config_t config;
+	memset(&config, 0, sizeof(config));
+	return config;
+}
+
+static int
+test_filter_initialize(void) {
+	return 0;
+}
+
+static void
+test_filter_finalize(void) {
+}
+
+static hash_t
+filter_key(uint64_t value) {
+	return hash(&value, sizeof(value));
+}
+
+DECLARE_TEST(filter, bloom) {
+	bloomfilter_t* filter = bloomfilter_allocate(10000, 10);
+	hash_t keys[64];
+	bool result[64];
+	size_t positives = 0;
+	uint64_t ikey;
+
+	EXPECT_FALSE(bloomfilter_query(filter, STRING_CONST("key")));
+	bloomfilter_insert(filter, STRING_CONST("key"));
+	EXPECT_TRUE(bloomfilter_query(filter, STRING_CONST("key")));
+	EXPECT_TRUE(bloomfilter_query_hash(filter, hash(STRING_CONST("key"))));
+
+	for (ikey = 0; ikey < 10000; ++ikey)
+		bloomfilter_insert_hash(filter, filter_key(ikey));
+	for (ikey = 0; ikey < 10000; ++ikey)
+		EXPECT_TRUE(bloomfilter_query_hash(filter, filter_key(ikey)));
+	for (ikey = 10000; ikey < 110000; ++ikey)
+		positives += bloomfilter_query_hash(filter, filter_key(ikey)) ? 1 : 0;
+	//Around 1% at 10 bits per key
+	EXPECT_SIZELT(positives, 2000);
+
+	for (ikey = 0; ikey < 64; ++ikey)
+		keys[ikey] = filter_key(ikey * 313);
+	positives = bloomfilter_query_batch(filter, keys, result, 64);
+	for (ikey = 0; ikey < 64; ++ikey) {
+		EXPECT_EQ(result[ikey], bloomfilter_query_hash(filter, keys[ikey]));
+		if (ikey * 313 < 10000)
+			EXPECT_TRUE(result[ikey]);
+	}
+	EXPECT_SIZEGE(positives, 32);
+
+	bloomfilter_clear(filter);
+	EXPECT_FALSE(bloomfilter_query(filter, STRING_CONST("key")));
+
+	bloomfilter_deallocate(filter);
+
+	return 0;
+}
+
+DECLARE_TEST(filter, cuckoo) {
+	cuckoofilter_t* filter = cuckoofilter_allocate(10000);
+	hash_t keys[64];
+	bool result[64];
+	size_t positives = 0;
+	size_t inserted;
+	uint64_t ikey;
+
+	EXPECT_SIZEEQ(cuckoofilter_size(filter), 0);
+	EXPECT_FALSE(cuckoofilter_query(filter, STRING_CONST("key")));
+	EXPECT_TRUE(cuckoofilter_insert(filter, STRING_CONST("key")));
+	EXPECT_TRUE(cuckoofilter_query(filter, STRING_CONST("key")));
+	EXPECT_TRUE(cuckoofilter_erase(filter, STRING_CONST("key")));
+	EXPECT_FALSE(cuckoofilter_query(filter, STRING_CONST("key")));
+	EXPECT_FALSE(cuckoofilter_erase(filter, STRING_CONST("key")));
+
+	//Duplicates are counted and must be erased individually
+	EXPECT_TRUE(cuckoofilter_insert(filter, STRING_CONST("key")));
+	EXPECT_TRUE(cuckoofilter_insert(filter, STRING_CONST("key")));
+	EXPECT_SIZEEQ(cuckoofilter_size(filter), 2);
+	EXPECT_TRUE(cuckoofilter_erase(filter, STRING_CONST("key")));
+	EXPECT_TRUE(cuckoofilter_query(filter, STRING_CONST("key")));
+	EXPECT_TRUE(cuckoofilter_erase(filter, STRING_CONST("key")));
+	EXPECT_SIZEEQ(cuckoofilter_size(filter), 0);
+
+	for (ikey = 0; ikey < 10000; ++ikey)
+		EXPECT_TRUE(cuckoofilter_insert_hash(filter, filter_key(ikey)));
+	EXPECT_SIZEEQ(cuckoofilter_size(filter), 10000);
+	for (ikey = 0; ikey < 10000; ++ikey)
+		EXPECT_TRUE(cuckoofilter_query_hash(filter, filter_key(ikey)));
+	for (ikey = 10000; ikey < 110000; ++ikey)
+		positives += cuckoofilter_query_hash(filter, filter_key(ikey)) ? 1 : 0;
+	//Around 0.01% with 16-bit fingerprints
+	EXPECT_SIZELT(positives, 100);
+
+	for (ikey = 0; ikey < 64; ++ikey)
+		keys[ikey] = filter_key(ikey * 313);
+	positives = cuckoofilter_query_batch(filter, keys, result, 64);
+	for (ikey = 0; ikey < 64; ++ikey)
+		EXPECT_EQ(result[ikey], cuckoofilter_query_hash(filter, keys[ikey]));
+	EXPECT_SIZEGE(positives, 32);
+
+	for (ikey = 0; ikey < 10000; ikey += 2)
+		EXPECT_TRUE(cuckoofilter_erase_hash(filter, filter_key(ikey)));
+	EXPECT_SIZEEQ(cuckoofilter_size(filter), 5000);
+	for (ikey = 1; ikey < 10000; ikey += 2)
+		EXPECT_TRUE(cuckoofilter_query_hash(filter, filter_key(ikey)));
+
+	//Fill until insertion fails, all stored keys must still be found
+	for (inserted = 0, ikey = 10000; cuckoofilter_insert_hash(filter, filter_key(ikey)); ++ikey)
+		++inserted;
+	EXPECT_SIZEGE(cuckoofilter_size(filter), (filter->num_buckets * 4 * 9) / 10);
+	EXPECT_SIZEEQ(cuckoofilter_size(filter), 5000 + inserted);
+	for (ikey = 1; ikey < 10000; ikey += 2)
+		EXPECT_TRUE(cuckoofilter_query_hash(filter, filter_key(ikey)));
+	for (ikey = 10000; ikey < 10000 + inserted; ++ikey)
+		EXPECT_TRUE(cuckoofilter_query_hash(filter, filter_key(ikey)));
+
+	//Erasing frees a slot for the victim held by the last successful insertion
+	EXPECT_TRUE(cuckoofilter_erase_hash(filter, filter_key(1)));
+	EXPECT_TRUE(cuckoofilter_query_hash(filter, filter_key(10000 + inserted - 1)));
+	EXPECT_TRUE(cuckoofilter_insert_hash(filter, filter_key(10000 + inserted)));
+
+	cuckoofilter_clear(filter);
+	EXPECT_SIZEEQ(cuckoofilter_size(filter), 0);
+	EXPECT_FALSE(cuckoofilter_query_hash(filter, filter_key(3)));
+
+	cuckoofilter_deallocate(filter);
+
+	return 0;
+}
+
+DECLARE_TEST(filter, stream) {
+	bloomfilter_t bloom, bloom_read;
+	cuckoofilter_t cuckoo, cuckoo_read;
+	stream_t* stream;
+	unsigned int imode;
+	uint64_t ikey;
+
+	bloomfilter_initialize(&bloom, 1000, 10);
+	cuckoofilter_initialize(&cuckoo, 1000);
+	for (ikey = 0; ikey < 1000; ++ikey) {
+		bloomfilter_insert_hash(&bloom, filter_key(ikey));
+		cuckoofilter_insert_hash(&cuckoo, filter_key(ikey));
+	}
+
+	//Text, native binary and byte swapped binary
+	for (imode = 0; imode < 3; ++imode) {
+		stream = buffer_stream_allocate(0, STREAM_IN | STREAM_OUT | (imode ? STREAM_BINARY : 0),
+		                                0, 0, true, true);
+		if (imode == 2)
+			stream_set_byteorder(stream, (system_byteorder() == BYTEORDER_LITTLEENDIAN) ?
+			                     BYTEORDER_BIGENDIAN : BYTEORDER_LITTLEENDIAN);
+		bloomfilter_write(&bloom, stream);
+		cuckoofilter_write(&cuckoo, stream);
+		stream_seek(stream, 0, STREAM_SEEK_BEGIN);
+
+		EXPECT_TRUE(bloomfilter_read(&bloom_read, stream));
+		EXPECT_TRUE(cuckoofilter_read(&cuckoo_read, stream));
+		EXPECT_SIZEEQ(bloom_read.num_blocks, bloom.num_blocks);
+		EXPECT_EQ(memcmp(bloom_read.block, bloom.block, bloom.num_blocks * 32), 0);
+		EXPECT_SIZEEQ(cuckoo_read.num_buckets, cuckoo.num_buckets);
+		EXPECT_SIZEEQ(cuckoofilter_size(&cuckoo_read), 1000);
+		EXPECT_EQ(memcmp(cuckoo_read.bucket, cuckoo.bucket, cuckoo.num_buckets * 8), 0);
+		for (ikey = 0; ikey < 1000; ++ikey) {
+			EXPECT_TRUE(bloomfilter_query_hash(&bloom_read, filter_key(ikey)));
+			EXPECT_TRUE(cuckoofilter_query_hash(&cuckoo_read, filter_key(ikey)));
+		}
+		bloomfilter_finalize(&bloom_read);
+		cuckoofilter_finalize(&cuckoo_read);
+
+		//Invalid and truncated data
+		log_enable_stdout(false);
+		stream_seek(stream, 0, STREAM_SEEK_BEGIN);
+		EXPECT_FALSE(cuckoofilter_read(&cuckoo_read, stream));
+		stream_seek(stream, 0, STREAM_SEEK_BEGIN);
+		stream_truncate(stream, 64);
+		EXPECT_FALSE(bloomfilter_read(&bloom_read, stream));
+		log_enable_stdout(true);
+
+		stream_deallocate(stream);
+	}
+
+	bloomfilter_finalize(&bloom);
+	cuckoofilter_finalize(&cuckoo);
+
+	return 0;
+}
+
+DECLARE_TEST(filter, performance) {
+	const size_t num_keys = 1000000;
+	bloomfilter_t* bloom = bloomfilter_allocate(num_keys, 10);
+	cuckoofilter_t* cuckoo = cuckoofilter_allocate(num_keys);
+	hash_t* keys = memory_allocate(0, sizeof(hash_t) * num_keys, 0, MEMORY_PERSISTENT);
+	bool* result = memory_allocate(0, sizeof(bool) * num_keys, 0, MEMORY_PERSISTENT);
+	size_t bloom_positives = 0, cuckoo_positives = 0, batch_positives;
+	tick_t start, time_bloom, time_bloom_batch, time_cuckoo, time_cuckoo_batch;
+	size_t ikey;
+
+	for (ikey = 0; ikey < num_keys; ++ikey) {
+		bloomfilter_insert_hash(bloom, filter_key(ikey));
+		cuckoofilter_insert_hash(cuckoo, filter_key(ikey));
+		keys[ikey] = filter_key(ikey + num_keys);
+	}
+
+	start = time_current();
+	for (ikey = 0; ikey < num_keys; ++ikey)
+		bloom_positives += bloomfilter_query_hash(bloom, keys[ikey]) ? 1 : 0;
+	time_bloom = time_diff(start, time_current());
+
+	start = time_current();
+	batch_positives = bloomfilter_query_batch(bloom, keys, result, num_keys);
+	time_bloom_batch = time_diff(start, time_current());
+	EXPECT_SIZEEQ(batch_positives, bloom_positives);
+
+	start = time_current();
+	for (ikey = 0; ikey < num_keys; ++ikey)
+		cuckoo_positives += cuckoofilter_query_hash(cuckoo, keys[ikey]) ? 1 : 0;
+	time_cuckoo = time_diff(start, time_current());
+
+	start = time_current();
+	batch_positives = cuckoofilter_query_batch(cuckoo, keys, result, num_keys);
+	time_cuckoo_batch = time_diff(start, time_current());
+	EXPECT_SIZEEQ(batch_positives, cuckoo_positives);
+
+	EXPECT_SIZELT(bloom_positives, num_keys / 50);
+	EXPECT_SIZELT(cuckoo_positives, num_keys / 1000);
+
+	log_infof(HASH_TEST, STRING_CONST("Bloom filter, %" PRIsize " keys at 10 bits per key: false positive rate %.3f%%, "
+	                                  "%.1fM queries/s, %.1fM queries/s batched"), num_keys,
+	          100.0 * (double)bloom_positives / (double)num_keys,
+	          (double)num_keys / (time_ticks_to_seconds(time_bloom) * 1000000.0),
+	          (double)num_keys / (time_ticks_to_seconds(time_bloom_batch) * 1000000.0));
+	log_infof(HASH_TEST, STRING_CONST("Cuckoo filter, %" PRIsize " keys in %" PRIsize " buckets: false positive rate %.3f%%, "
+	                                  "%.1fM queries/s, %.1fM queries/s batched"), num_keys, cuckoo->num_buckets,
+	          100.0 * (double)cuckoo_positives / (double)num_keys,
+	          (double)num_keys / (time_ticks_to_seconds(time_cuckoo) * 1000000.0),
+	          (double)num_keys / (time_ticks_to_seconds(time_cuckoo_batch) * 1000000.0));
+
+	memory_deallocate(result);
+	memory_deallocate(keys);
+	cuckoofilter_deallocate(cuckoo);
+	bloomfilter_deallocate(bloom);
+
+	return 0;
+}
+
+static void
+test_filter_declare(void) {
+	ADD_TEST(filter, bloom);
+	ADD_TEST(filter, cuckoo);
+	ADD_TEST(filter, stream);
+	ADD_TEST(filter, performance);
+}
+
+static test_suite_t test_filter_suite = {
+	test_filter_application,
+	test_filter_memory_system,
+	test_filter_config,
+	test_filter_declare,
+	test_filter_initialize,
+	test_filter_finalize,
+	0
+};
+
+#if BUILD_MONOLITHIC
+
+int
+test_filter_run(void);
+
+int
+test_filter_run(void) {
+	test_suite = test_filter_suite;
+	return test_run_all();
+}
+
+#else
+
+test_suite_t
+test_suite_define(void);
+
+test_suite_t
+test_suite_define(void) {
+	return test_filter_suite;
+}
+
+#endif
@@ -77,9 +77,13 @@ DECLARE_TEST(fs, directory) {
 	EXPECT_FALSE(fs_is_directory(STRING_CONST("")));
 
 	EXPECT_TRUE(fs_is_directory(STRING_ARGS(testpath)));
+	EXPECT_TRUE(fs_sync_directory(STRING_ARGS(testpath)));
 
 	EXPECT_TRUE(fs_remove_directory(STRING_ARGS(testpath)));
 	EXPECT_FALSE(fs_is_directory(STRING_ARGS(testpath)));
+#if FOUNDATION_PLATFORM_POSIX
+	EXPECT_FALSE(fs_sync_directory(STRING_ARGS(testpath)));
+#endif
 
 	EXPECT_FALSE(fs_remove_directory(STRING_ARGS(testpath)));
 
@@ -338,6 +342,75 @@ DECLARE_TEST(fs, file) {
 	return 0;
 }
 
+DECLARE_TEST(fs, map) {
+#if !FOUNDATION_PLATFORM_PNACL
+	char buf[BUILD_MAX_PATHLEN];
+	string_t testpath;
+	string_const_t fname;
+	fs_map_t map;
+	size_t i;
+
+	fname = string_from_uint_static(random64(), true, 0, 0);
+	testpath = path_concat(buf, BUILD_MAX_PATHLEN, STRING_ARGS(environment_temporary_directory()),
+	                       STRING_ARGS(fname));
+	if (!fs_is_directory(STRING_ARGS(environment_temporary_directory())))
+		fs_make_directory(STRING_ARGS(environment_temporary_directory()));
+	fs_remove_file(STRING_ARGS(testpath));
+
+	EXPECT_FALSE(fs_map_file(&map, STRING_ARGS(testpath), STREAM_IN));
+	EXPECT_EQ(map.data, nullptr);
+	EXPECT_FALSE(fs_is_file(STRING_ARGS(testpath)));
+
+	EXPECT_TRUE(fs_map_file(&map, STRING_ARGS(testpath), STREAM_IN | STREAM_OUT | STREAM_CREATE));
+	EXPECT_TRUE(fs_is_file(STRING_ARGS(testpath)));
+	EXPECT_EQ(map.data, nullptr);
+	EXPECT_SIZEEQ(map.size, 0);
+
+	EXPECT_TRUE(fs_map_resize(&map, 10000));
+	EXPECT_NE(map.data, nullptr);
+	EXPECT_SIZEEQ(map.size, 10000);
+	for (i = 0; i < map.size; ++i)
+		EXPECT_INTEQ(((char*)map.data)[i], 0);
+	for (i = 0; i < map.size; ++i)
+		((char*)map.data)[i] = (char)i;
+	EXPECT_TRUE(fs_map_flush(&map, 5000, 100));
+	EXPECT_TRUE(fs_map_flush(&map, 0, map.size));
+
+	EXPECT_TRUE(fs_map_resize(&map, 20000));
+	EXPECT_SIZEEQ(map.size, 20000);
+	EXPECT_INTEQ(((char*)map.data)[9999], (char)9999);
+	EXPECT_INTEQ(((char*)map.data)[10000], 0);
+	EXPECT_TRUE(fs_map_resize(&map, 8000));
+	fs_unmap_file(&map);
+	EXPECT_EQ(map.data, nullptr);
+	EXPECT_SIZEEQ(fs_size(STRING_ARGS(testpath)), 8000);
+
+	EXPECT_TRUE(fs_map_file(&map, STRING_ARGS(testpath), STREAM_IN));
+	EXPECT_SIZEEQ(map.size, 8000);
+	for (i = 0; i < map.size; ++i)
+		EXPECT_INTEQ(((char*)map.data)[i], (char)i);
+	EXPECT_FALSE(fs_map_resize(&map, 10000));
+	EXPECT_TRUE(fs_map_advise(&map, 100, 1000, FS_MAP_SEQUENTIAL | FS_MAP_WILLNEED));
+	fs_unmap_file(&map);
+
+	//Private mapping is writable without modifying the file
+	EXPECT_TRUE(fs_map_file(&map, STRING_ARGS(testpath), STREAM_IN | STREAM_OUT | FS_MAP_PRIVATE));
+	((char*)map.data)[100] = 0;
+	EXPECT_FALSE(fs_map_resize(&map, 10000));
+	fs_unmap_file(&map);
+	EXPECT_TRUE(fs_map_file(&map, STRING_ARGS(testpath), STREAM_IN));
+	EXPECT_INTEQ(((char*)map.data)[100], (char)100);
+	fs_unmap_file(&map);
+
+	EXPECT_TRUE(fs_map_file(&map, STRING_ARGS(testpath), STREAM_IN | STREAM_OUT | STREAM_TRUNCATE));
+	EXPECT_SIZEEQ(map.size, 0);
+	fs_unmap_file(&map);
+
+	fs_remove_file(STRING_ARGS(testpath));
+#endif
+	return 0;
+}
+
 DECLARE_TEST(fs, util) {
 	char buf[BUILD_MAX_PATHLEN];
 	tick_t systime = time_system();
@@ -898,6 +971,7 @@ static void
 test_fs_declare(void) {
 	ADD_TEST(fs, directory);
 	ADD_TEST(fs, file);
+	ADD_TEST(fs, map);
 	ADD_TEST(fs, util);
 	ADD_TEST(fs, query);
 	ADD_TEST(fs, event);
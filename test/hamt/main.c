@@ -0,0 +1,488 @@
+/* main.c  -  Foundation hamt test  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+#include <test/test.h>
+
+static application_t
+test_hamt_application(void) {
+	application_t app;
+	memset(&app, 0, sizeof(app));
+	app.name = string_const(STRING_CONST("Foundation hamt tests"));
+	app.short_name = string_const(STRING_CONST("test_hamt"));
+	app.company = string_const(STRING_CONST("Rampant Pixels"));
+	app.flags = APPLICATION_UTILITY;
+	app.exception_handler = test_exception_handler;
+	return app;
+}
+
+static memory_system_t
+test_hamt_memory_system(void) {
+	return memory_system_malloc();
+}
+
+static foundation_config_t
+test_hamt_config(void) {
+	foundation_config_t config;
+	memset(&config, 0, sizeof(config));
+	return config;
+}
+
+static int
+test_hamt_initialize(void) {
+	return 0;
+}
+
+static void
+test_hamt_finalize(void) {
+}
+
+static int
+hamt_sum(hash_t key, void* value, void* data) {
+	uint64_t* sum = data;
+	sum[0] += 1;
+	sum[1] += key;
+	sum[2] += (uint64_t)(uintptr_t)value;
+	return 0;
+}
+
+static int
+hamt_stop(hash_t key, void* value, void* data) {
+	FOUNDATION_UNUSED(key);
+	FOUNDATION_UNUSED(value);
+	return ++(*(int*)data) == 3 ? 42 : 0;
+}
+
+DECLARE_TEST(hamt, basic) {
+	hamt_t* empty = hamt_allocate();
+	hamt_t* one;
+	hamt_t* two;
+	hamt_t* three;
+	hamt_t* map;
+	uint64_t sum[3] = {0, 0, 0};
+	int count = 0;
+
+	EXPECT_SIZEEQ(hamt_size(empty), 0);
+	EXPECT_EQ(hamt_lookup(empty, 1), nullptr);
+	EXPECT_FALSE(hamt_has_key(empty, 1));
+	EXPECT_INTEQ(hamt_foreach(empty, hamt_sum, sum), 0);
+
+	one = hamt_set(empty, 1, (void*)(uintptr_t)10);
+	two = hamt_set(one, 2, (void*)(uintptr_t)20);
+	three = hamt_set(two, 3, nullptr);
+
+	//Older versions are unchanged
+	EXPECT_SIZEEQ(hamt_size(empty), 0);
+	EXPECT_SIZEEQ(hamt_size(one), 1);
+	EXPECT_SIZEEQ(hamt_size(two), 2);
+	EXPECT_SIZEEQ(hamt_size(three), 3);
+	EXPECT_EQ(hamt_lookup(one, 1), (void*)(uintptr_t)10);
+	EXPECT_EQ(hamt_lookup(one, 2), nullptr);
+	EXPECT_EQ(hamt_lookup(two, 2), (void*)(uintptr_t)20);
+	EXPECT_FALSE(hamt_has_key(two, 3));
+	EXPECT_TRUE(hamt_has_key(three, 3));
+	EXPECT_EQ(hamt_lookup(three, 3), nullptr);
+
+	//Unchanged updates return the same version
+	map = hamt_set(three, 2, (void*)(uintptr_t)20);
+	EXPECT_EQ(map, three);
+	hamt_release(map);
+	map = hamt_erase(three, 4);
+	EXPECT_EQ(map, three);
+	hamt_release(map);
+
+	map = hamt_set(three, 2, (void*)(uintptr_t)21);
+	EXPECT_NE(map, three);
+	EXPECT_SIZEEQ(hamt_size(map), 3);
+	EXPECT_EQ(hamt_lookup(map, 2), (void*)(uintptr_t)21);
+	EXPECT_EQ(hamt_lookup(three, 2), (void*)(uintptr_t)20);
+
+	EXPECT_INTEQ(hamt_foreach(map, hamt_sum, sum), 0);
+	EXPECT_UINTEQ(sum[0], 3);
+	EXPECT_UINTEQ(sum[1], 6);
+	EXPECT_UINTEQ(sum[2], 31);
+	EXPECT_INTEQ(hamt_foreach(map, hamt_stop, &count), 42);
+	EXPECT_INTEQ(count, 3);
+	hamt_release(map);
+
+	map = hamt_erase(three, 1);
+	EXPECT_SIZEEQ(hamt_size(map), 2);
+	EXPECT_FALSE(hamt_has_key(map, 1));
+	EXPECT_TRUE(hamt_has_key(three, 1));
+	hamt_release(three);
+	three = map;
+	map = hamt_erase(three, 2);
+	hamt_release(three);
+	three = map;
+	map = hamt_erase(three, 3);
+	hamt_release(three);
+	EXPECT_SIZEEQ(hamt_size(map), 0);
+	EXPECT_EQ(map->root, nullptr);
+	hamt_release(map);
+
+	//Versions can be released in any order
+	hamt_release(one);
+	hamt_release(empty);
+	EXPECT_EQ(hamt_lookup(two, 1), (void*)(uintptr_t)10);
+	hamt_release(two);
+
+	return 0;
+}
+
+static hamt_t*
+hamt_replace(hamt_t* map, hamt_t* next) {
+	hamt_release(map);
+	return next;
+}
+
+DECLARE_TEST(hamt, structure) {
+	hamt_t* map = hamt_allocate();
+	hamt_t* snapshot;
+	hash_t* keys;
+	size_t num_keys = 20000;
+	size_t ikey, icheck;
+	hash_t key;
+
+	//Keys with equal low bits need deep nodes, keys differing only in the top bits end
+	//up on the last level
+	for (key = 0; key < 16; ++key)
+		map = hamt_replace(map, hamt_set(map, key << 60, (void*)(uintptr_t)(key + 1)));
+	for (key = 1; key < 64; ++key)
+		map = hamt_replace(map, hamt_set(map, key << 40, (void*)(uintptr_t)(key + 1)));
+	EXPECT_SIZEEQ(hamt_size(map), 16 + 63);
+	for (key = 0; key < 16; ++key)
+		EXPECT_EQ(hamt_lookup(map, key << 60), (void*)(uintptr_t)(key + 1));
+	for (key = 1; key < 64; ++key)
+		EXPECT_EQ(hamt_lookup(map, key << 40), (void*)(uintptr_t)(key + 1));
+	EXPECT_EQ(hamt_lookup(map, (hash_t)1 << 59), nullptr);
+	for (key = 1; key < 64; ++key)
+		map = hamt_replace(map, hamt_erase(map, key << 40));
+	for (key = 15; key > 0; --key)
+		map = hamt_replace(map, hamt_erase(map, key << 60));
+	//Erasing collapses nodes back to a single inline entry
+	EXPECT_SIZEEQ(hamt_size(map), 1);
+	EXPECT_EQ(map->root->nodemap, 0);
+	EXPECT_EQ(hamt_lookup(map, 0), (void*)(uintptr_t)1);
+	map = hamt_replace(map, hamt_erase(map, 0));
+	EXPECT_EQ(map->root, nullptr);
+
+	keys = memory_allocate(0, sizeof(hash_t) * num_keys, 0, MEMORY_PERSISTENT);
+	for (ikey = 0; ikey < num_keys; ++ikey) {
+		keys[ikey] = random64();
+		map = hamt_replace(map, hamt_set(map, keys[ikey], (void*)(uintptr_t)(ikey + 1)));
+	}
+	EXPECT_SIZEEQ(hamt_size(map), num_keys);
+	for (ikey = 0; ikey < num_keys; ++ikey)
+		EXPECT_EQ(hamt_lookup(map, keys[ikey]), (void*)(uintptr_t)(ikey + 1));
+
+	//Snapshot keeps all keys while the map is erased
+	snapshot = hamt_acquire(map);
+	for (ikey = 0; ikey < num_keys; ikey += 2)
+		map = hamt_replace(map, hamt_erase(map, keys[ikey]));
+	EXPECT_SIZEEQ(hamt_size(map), num_keys / 2);
+	for (icheck = 0; icheck < num_keys; ++icheck) {
+		EXPECT_EQ(hamt_lookup(map, keys[icheck]), (icheck & 1) ? (void*)(uintptr_t)(icheck + 1) : nullptr);
+		EXPECT_EQ(hamt_lookup(snapshot, keys[icheck]), (void*)(uintptr_t)(icheck + 1));
+	}
+	for (ikey = 1; ikey < num_keys; ikey += 2)
+		map = hamt_replace(map, hamt_erase(map, keys[ikey]));
+	EXPECT_SIZEEQ(hamt_size(map), 0);
+	EXPECT_EQ(map->root, nullptr);
+	EXPECT_SIZEEQ(hamt_size(snapshot), num_keys);
+
+	hamt_release(snapshot);
+	hamt_release(map);
+	memory_deallocate(keys);
+
+	return 0;
+}
+
+#define HAMT_VERSION_KEYS 64
+
+typedef struct {
+	hamt_root_t* root;
+	size_t num_versions;
+	atomic32_t* done;
+	size_t reads;
+	size_t key_offset;
+	bool consistent;
+} hamt_arg_t;
+
+static void*
+hamt_version_writer(void* arg) {
+	hamt_arg_t* parg = arg;
+	size_t iversion;
+	hash_t key;
+	for (iversion = 1; iversion <= parg->num_versions; ++iversion) {
+		//Every version maps all keys to the version number
+		hamt_t* current = hamt_root_acquire(parg->root);
+		hamt_t* map = hamt_acquire(current);
+		for (key = 0; key < HAMT_VERSION_KEYS; ++key)
+			map = hamt_replace(map, hamt_set(map, key, (void*)(uintptr_t)iversion));
+		if (!hamt_root_publish(parg->root, current, map)) {
+			parg->consistent = false;
+			hamt_release(map);
+		}
+		hamt_release(current);
+	}
+	atomic_store32(parg->done, 1);
+	return 0;
+}
+
+static void*
+hamt_version_reader(void* arg) {
+	hamt_arg_t* parg = arg;
+	uintptr_t last = 0;
+	hash_t key;
+	while (!atomic_load32(parg->done)) {
+		hamt_t* map = hamt_root_acquire(parg->root);
+		uintptr_t version = (uintptr_t)hamt_lookup(map, 0);
+		for (key = 1; key < HAMT_VERSION_KEYS; ++key) {
+			if ((uintptr_t)hamt_lookup(map, key) != version)
+				parg->consistent = false;
+		}
+		hamt_release(map);
+		if (version < last)
+			parg->consistent = false;
+		last = version;
+		version = (uintptr_t)hamt_root_lookup(parg->root, random32_range(0, HAMT_VERSION_KEYS));
+		if (version < last)
+			parg->consistent = false;
+		last = version;
+		++parg->reads;
+		if (!(parg->reads % 32))
+			thread_yield();
+	}
+	return 0;
+}
+
+static void*
+hamt_set_writer(void* arg) {
+	hamt_arg_t* parg = arg;
+	size_t iversion;
+	for (iversion = 0; iversion < parg->num_versions; ++iversion)
+		hamt_root_set(parg->root, parg->key_offset + iversion, (void*)(uintptr_t)(iversion + 1));
+	for (iversion = 0; iversion < parg->num_versions; iversion += 2) {
+		if (!hamt_root_erase(parg->root, parg->key_offset + iversion))
+			parg->consistent = false;
+	}
+	return 0;
+}
+
+DECLARE_TEST(hamt, concurrent) {
+	thread_t thread[17];
+	hamt_arg_t args[17];
+	hamt_root_t* root = hamt_root_allocate(nullptr);
+	atomic32_t done;
+	hamt_t* map;
+	size_t i, num_threads, ikey;
+
+	atomic_store32(&done, 0);
+	num_threads = math_clamp(system_hardware_threads(), 2U, 16U);
+	for (i = 0; i <= num_threads; ++i) {
+		memset(args + i, 0, sizeof(hamt_arg_t));
+		args[i].root = root;
+		args[i].done = &done;
+		args[i].num_versions = 2000;
+		args[i].consistent = true;
+		thread_initialize(&thread[i], i ? hamt_version_reader : hamt_version_writer, args + i,
+		                  STRING_CONST("hamt_thread"), THREAD_PRIORITY_NORMAL, 0);
+	}
+	for (i = 0; i <= num_threads; ++i)
+		thread_start(&thread[i]);
+	test_wait_for_threads_startup(thread, num_threads + 1);
+	test_wait_for_threads_finish(thread, num_threads + 1);
+	for (i = 0; i <= num_threads; ++i) {
+		thread_finalize(&thread[i]);
+		EXPECT_TRUE(args[i].consistent);
+	}
+
+	map = hamt_root_acquire(root);
+	EXPECT_SIZEEQ(hamt_size(map), HAMT_VERSION_KEYS);
+	EXPECT_EQ(hamt_lookup(map, HAMT_VERSION_KEYS - 1), (void*)(uintptr_t)2000);
+	hamt_release(map);
+
+	//Concurrent writers retry on conflicting publication
+	for (i = 0; i < num_threads; ++i) {
+		memset(args + i, 0, sizeof(hamt_arg_t));
+		args[i].root = root;
+		args[i].num_versions = 500;
+		args[i].key_offset = 1000 + (i * 1000);
+		args[i].consistent = true;
+		thread_initialize(&thread[i], hamt_set_writer, args + i, STRING_CONST("hamt_writer"),
+		                  THREAD_PRIORITY_NORMAL, 0);
+	}
+	for (i = 0; i < num_threads; ++i)
+		thread_start(&thread[i]);
+	test_wait_for_threads_startup(thread, num_threads);
+	test_wait_for_threads_finish(thread, num_threads);
+	for (i = 0; i < num_threads; ++i) {
+		thread_finalize(&thread[i]);
+		EXPECT_TRUE(args[i].consistent);
+	}
+
+	map = hamt_root_acquire(root);
+	EXPECT_SIZEEQ(hamt_size(map), HAMT_VERSION_KEYS + (num_threads * 250));
+	for (i = 0; i < num_threads; ++i) {
+		for (ikey = 0; ikey < 500; ++ikey)
+			EXPECT_EQ(hamt_lookup(map, 1000 + (i * 1000) + ikey), (ikey & 1) ? (void*)(uintptr_t)(ikey + 1) : nullptr);
+	}
+	hamt_release(map);
+
+	EXPECT_FALSE(hamt_root_erase(root, 999));
+	hamt_root_set(root, 999, nullptr);
+	EXPECT_TRUE(hamt_root_erase(root, 999));
+
+	hamt_root_deallocate(root);
+
+	return 0;
+}
+
+typedef struct {
+	hamt_root_t* root;
+	const hash_t* keys;
+	size_t num_keys;
+	size_t num_lookups;
+	size_t found;
+} hamt_bench_t;
+
+static void*
+hamt_bench_reader(void* arg) {
+	hamt_bench_t* parg = arg;
+	size_t ilookup;
+	for (ilookup = 0; ilookup < parg->num_lookups; ++ilookup) {
+		if (hamt_root_lookup(parg->root, parg->keys[(ilookup * 7919) % parg->num_keys]))
+			++parg->found;
+	}
+	return 0;
+}
+
+DECLARE_TEST(hamt, performance) {
+	size_t num_keys = 100000;
+	size_t num_updates = 20000;
+	size_t num_lookups = 1000000;
+	hash_t* keys = memory_allocate(0, sizeof(hash_t) * num_keys, 0, MEMORY_PERSISTENT);
+	hamt_t* map = hamt_allocate();
+	hamt_root_t root;
+	thread_t thread[16];
+	hamt_bench_t args[16];
+	size_t ikey, iupdate, i, num_threads, found = 0;
+	tick_t start, elapsed;
+
+	for (ikey = 0; ikey < num_keys; ++ikey)
+		keys[ikey] = random64();
+
+	start = time_current();
+	for (ikey = 0; ikey < num_keys; ++ikey)
+		map = hamt_replace(map, hamt_set(map, keys[ikey], (void*)(uintptr_t)(ikey + 1)));
+	elapsed = time_diff(start, time_current());
+	log_infof(HASH_TEST, STRING_CONST("HAMT build %" PRIsize " keys: %.2f ms"), num_keys,
+	          time_ticks_to_seconds(elapsed) * 1000.0);
+
+	//Update cost with the previous version kept alive, as when readers hold snapshots
+	start = time_current();
+	for (iupdate = 0; iupdate < num_updates; ++iupdate) {
+		hamt_t* next = hamt_set(map, keys[random32_range(0, (uint32_t)num_keys)], (void*)(uintptr_t)(iupdate + 1));
+		hamt_release(map);
+		map = next;
+	}
+	elapsed = time_diff(start, time_current());
+	log_infof(HASH_TEST, STRING_CONST("HAMT %" PRIsize " updates of %" PRIsize " keys: %.0f ns per update"),
+	          num_updates, num_keys, time_ticks_to_seconds(elapsed) * 1.0e9 / (double)num_updates);
+
+	start = time_current();
+	for (ikey = 0; ikey < num_lookups; ++ikey) {
+		if (hamt_lookup(map, keys[(ikey * 7919) % num_keys]))
+			++found;
+	}
+	elapsed = time_diff(start, time_current());
+	EXPECT_SIZEEQ(found, num_lookups);
+	log_infof(HASH_TEST, STRING_CONST("HAMT %" PRIsize " lookups: %.0f ns per lookup"),
+	          num_lookups, time_ticks_to_seconds(elapsed) * 1.0e9 / (double)num_lookups);
+
+	hamt_root_initialize(&root, map);
+	for (num_threads = 1; num_threads <= math_clamp(system_hardware_threads(), 4U, 16U); num_threads *= 2) {
+		for (i = 0; i < num_threads; ++i) {
+			args[i].root = &root;
+			args[i].keys = keys;
+			args[i].num_keys = num_keys;
+			args[i].num_lookups = num_lookups / num_threads;
+			args[i].found = 0;
+			thread_initialize(&thread[i], hamt_bench_reader, args + i, STRING_CONST("hamt_reader"),
+			                  THREAD_PRIORITY_NORMAL, 0);
+		}
+		start = time_current();
+		for (i = 0; i < num_threads; ++i)
+			thread_start(&thread[i]);
+		//Publish updates while readers run
+		for (iupdate = 0; iupdate < 100; ++iupdate) {
+			hamt_root_set(&root, keys[iupdate], (void*)(uintptr_t)(iupdate + 1));
+			thread_yield();
+		}
+		test_wait_for_threads_startup(thread, num_threads);
+		test_wait_for_threads_finish(thread, num_threads);
+		elapsed = time_diff(start, time_current());
+		for (i = 0; i < num_threads; ++i) {
+			thread_finalize(&thread[i]);
+			EXPECT_SIZEEQ(args[i].found, num_lookups / num_threads);
+		}
+		log_infof(HASH_TEST, STRING_CONST("HAMT root %" PRIsize " lookups, %" PRIsize " threads: %.2f ms, %.1f Mlookups/s"),
+		          num_lookups, num_threads, time_ticks_to_seconds(elapsed) * 1000.0,
+		          ((double)num_lookups / 1.0e6) / time_ticks_to_seconds(elapsed));
+	}
+	hamt_root_finalize(&root);
+
+	memory_deallocate(keys);
+
+	return 0;
+}
+
+static void
+test_hamt_declare(void) {
+	ADD_TEST(hamt, basic);
+	ADD_TEST(hamt, structure);
+	ADD_TEST(hamt, concurrent);
+	ADD_TEST(hamt, performance);
+}
+
+static test_suite_t test_hamt_suite = {
+	test_hamt_application,
+	test_hamt_memory_system,
+	test_hamt_config,
+	test_hamt_declare,
+	test_hamt_initialize,
+	test_hamt_finalize,
+	0
+};
+
+#if BUILD_MONOLITHIC
+
+int
+test_hamt_run(void);
+
+int
+test_hamt_run(void) {
+	test_suite = test_hamt_suite;
+	return test_run_all();
+}
+
+#else
+
+test_suite_t
+test_suite_define(void);
+
+test_suite_t
+test_suite_define(void) {
+	return test_hamt_suite;
+}
+
+#endif
@@ -0,0 +1,456 @@
+/* main.c  -  Foundation hashindex test  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+#include <test/test.h>
+
+#if FOUNDATION_PLATFORM_POSIX
+#include <foundation/posix.h>
+#include <sys/resource.h>
+#endif
+
+static application_t
+test_hashindex_application(void) {
+	application_t app;
+	memset(&app, 0, sizeof(app));
+	app.name = string_const(STRING_CONST("Foundation hashindex tests"));
+	app.short_name = string_const(STRING_CONST("test_hashindex"));
+	app.company = string_const(STRING_CONST("Rampant Pixels"));
+	app.flags = APPLICATION_UTILITY;
+	app.exception_handler = test_exception_handler;
+	return app;
+}
+
+static memory_system_t
+test_hashindex_memory_system(void) {
+	return memory_system_malloc();
+}
+
+static foundation_config_t
+test_hashindex_config(void) {
+	foundation_config_t config;
+	memset(&config, 0, sizeof(config));
+	return config;
+}
+
+static int
+test_hashindex_initialize(void) {
+	return 0;
+}
+
+static void
+test_hashindex_finalize(void) {
+}
+
+static string_t
+hashindex_test_path(char* buffer, size_t capacity) {
+	string_t path = path_make_temporary(buffer, capacity);
+	string_const_t directory = path_directory_name(STRING_ARGS(path));
+	fs_make_directory(STRING_ARGS(directory));
+	return path;
+}
+
+static uint64_t
+hashindex_test_key(size_t i) {
+	return (uint64_t)i * 0x9E3779B97F4A7C15ULL + 1;
+}
+
+static void
+hashindex_test_crash(hashindex_t* index) {
+	//Close without committing, as if the process was terminated
+	fs_unmap_file(&index->map);
+	memory_deallocate(index);
+}
+
+DECLARE_TEST(hashindex, basic) {
+	char buffer[BUILD_MAX_PATHLEN];
+	string_t path = hashindex_test_path(buffer, sizeof(buffer));
+	hashindex_t* index;
+	uint64_t value = 0;
+
+	EXPECT_EQ(hashindex_open(STRING_ARGS(path), STREAM_IN), nullptr);
+	EXPECT_EQ(hashindex_open(STRING_ARGS(path), STREAM_IN | STREAM_OUT), nullptr);
+
+	index = hashindex_open(STRING_ARGS(path), STREAM_IN | STREAM_OUT | STREAM_CREATE);
+	EXPECT_NE(index, nullptr);
+	EXPECT_SIZEEQ(hashindex_size(index), 0);
+	EXPECT_FALSE(hashindex_lookup(index, 1, &value));
+
+	EXPECT_FALSE(hashindex_set(index, 0, 1));
+	EXPECT_FALSE(hashindex_set(index, 0xFFFFFFFFFFFFFFFFULL, 1));
+	EXPECT_TRUE(hashindex_set(index, 1, 10));
+	EXPECT_TRUE(hashindex_set(index, 2, 20));
+	EXPECT_TRUE(hashindex_set(index, 3, 0));
+	EXPECT_SIZEEQ(hashindex_size(index), 3);
+	EXPECT_TRUE(hashindex_lookup(index, 1, &value));
+	EXPECT_UINTEQ(value, 10);
+	EXPECT_TRUE(hashindex_lookup(index, 3, &value));
+	EXPECT_UINTEQ(value, 0);
+	EXPECT_TRUE(hashindex_lookup(index, 2, nullptr));
+	EXPECT_FALSE(hashindex_lookup(index, 4, &value));
+
+	EXPECT_TRUE(hashindex_set(index, 2, 21));
+	EXPECT_SIZEEQ(hashindex_size(index), 3);
+	EXPECT_TRUE(hashindex_lookup(index, 2, &value));
+	EXPECT_UINTEQ(value, 21);
+
+	EXPECT_TRUE(hashindex_erase(index, 1));
+	EXPECT_FALSE(hashindex_erase(index, 1));
+	EXPECT_FALSE(hashindex_erase(index, 4));
+	EXPECT_SIZEEQ(hashindex_size(index), 2);
+	EXPECT_FALSE(hashindex_lookup(index, 1, &value));
+	EXPECT_TRUE(hashindex_set(index, 1, 11));
+	EXPECT_SIZEEQ(hashindex_size(index), 3);
+	hashindex_close(index);
+
+	index = hashindex_open(STRING_ARGS(path), STREAM_IN);
+	EXPECT_NE(index, nullptr);
+	EXPECT_SIZEEQ(hashindex_size(index), 3);
+	EXPECT_TRUE(hashindex_lookup(index, 1, &value));
+	EXPECT_UINTEQ(value, 11);
+	EXPECT_TRUE(hashindex_lookup(index, 2, &value));
+	EXPECT_UINTEQ(value, 21);
+	EXPECT_TRUE(hashindex_lookup(index, 3, &value));
+	EXPECT_UINTEQ(value, 0);
+	EXPECT_FALSE(hashindex_set(index, 4, 40));
+	EXPECT_FALSE(hashindex_erase(index, 1));
+	EXPECT_TRUE(hashindex_commit(index));
+	hashindex_close(index);
+
+	index = hashindex_open(STRING_ARGS(path), STREAM_IN | STREAM_OUT | STREAM_TRUNCATE);
+	EXPECT_NE(index, nullptr);
+	EXPECT_SIZEEQ(hashindex_size(index), 0);
+	EXPECT_FALSE(hashindex_lookup(index, 1, &value));
+	hashindex_close(index);
+
+	fs_remove_file(STRING_ARGS(path));
+
+	//Not an index file
+	{
+		stream_t* stream = stream_open(STRING_ARGS(path), STREAM_OUT | STREAM_CREATE);
+		EXPECT_NE(stream, nullptr);
+		stream_write_string(stream, STRING_CONST("not a hash index"));
+		stream_deallocate(stream);
+	}
+	EXPECT_EQ(hashindex_open(STRING_ARGS(path), STREAM_IN | STREAM_OUT), nullptr);
+	fs_remove_file(STRING_ARGS(path));
+
+	return 0;
+}
+
+DECLARE_TEST(hashindex, growth) {
+	char buffer[BUILD_MAX_PATHLEN];
+	string_t path = hashindex_test_path(buffer, sizeof(buffer));
+	size_t num_keys = 100000;
+	hashindex_t* index;
+	uint64_t value = 0;
+	size_t ikey;
+
+	index = hashindex_open(STRING_ARGS(path), STREAM_IN | STREAM_OUT | STREAM_CREATE);
+	EXPECT_NE(index, nullptr);
+	for (ikey = 0; ikey < num_keys; ++ikey) {
+		EXPECT_TRUE(hashindex_set(index, hashindex_test_key(ikey), ikey));
+		//Commit now and then to let split buckets reuse slots
+		if (!(ikey % 10000))
+			EXPECT_TRUE(hashindex_commit(index));
+	}
+	EXPECT_SIZEEQ(hashindex_size(index), num_keys);
+	EXPECT_GT(index->level, 0);
+
+	for (ikey = 0; ikey < num_keys; ++ikey) {
+		EXPECT_TRUE(hashindex_lookup(index, hashindex_test_key(ikey), &value));
+		EXPECT_UINTEQ(value, ikey);
+	}
+	EXPECT_FALSE(hashindex_lookup(index, hashindex_test_key(num_keys), &value));
+
+	//Erase every other key and overwrite the rest
+	for (ikey = 0; ikey < num_keys; ikey += 2)
+		EXPECT_TRUE(hashindex_erase(index, hashindex_test_key(ikey)));
+	for (ikey = 1; ikey < num_keys; ikey += 2)
+		EXPECT_TRUE(hashindex_set(index, hashindex_test_key(ikey), ikey * 2));
+	EXPECT_SIZEEQ(hashindex_size(index), num_keys / 2);
+	hashindex_close(index);
+
+	EXPECT_SIZEEQ((size_t)fs_size(STRING_ARGS(path)) % 4096, 0);
+
+	index = hashindex_open(STRING_ARGS(path), STREAM_IN);
+	EXPECT_NE(index, nullptr);
+	EXPECT_SIZEEQ(hashindex_size(index), num_keys / 2);
+	for (ikey = 0; ikey < num_keys; ++ikey) {
+		bool found = hashindex_lookup(index, hashindex_test_key(ikey), &value);
+		EXPECT_EQ(found, (ikey & 1) != 0);
+		if (found)
+			EXPECT_UINTEQ(value, ikey * 2);
+	}
+	hashindex_close(index);
+
+	fs_remove_file(STRING_ARGS(path));
+	return 0;
+}
+
+DECLARE_TEST(hashindex, crash) {
+	char buffer[BUILD_MAX_PATHLEN];
+	string_t path = hashindex_test_path(buffer, sizeof(buffer));
+	size_t num_committed = 20000;
+	size_t num_keys = 60000;
+	size_t num_found;
+	hashindex_t* index;
+	uint64_t value = 0;
+	uint64_t sequence;
+	size_t ikey;
+
+	//Crash with uncommitted inserts, growing the file and splitting buckets
+	index = hashindex_open(STRING_ARGS(path), STREAM_IN | STREAM_OUT | STREAM_CREATE);
+	EXPECT_NE(index, nullptr);
+	for (ikey = 0; ikey < num_committed; ++ikey)
+		EXPECT_TRUE(hashindex_set(index, hashindex_test_key(ikey), ikey));
+	EXPECT_TRUE(hashindex_commit(index));
+	for (; ikey < num_keys; ++ikey)
+		EXPECT_TRUE(hashindex_set(index, hashindex_test_key(ikey), ikey));
+	hashindex_test_crash(index);
+
+	//Committed keys are present, uncommitted keys may or may not be present
+	index = hashindex_open(STRING_ARGS(path), STREAM_IN | STREAM_OUT);
+	EXPECT_NE(index, nullptr);
+	num_found = 0;
+	for (ikey = 0; ikey < num_keys; ++ikey) {
+		bool found = hashindex_lookup(index, hashindex_test_key(ikey), &value);
+		if (ikey < num_committed)
+			EXPECT_TRUE(found);
+		if (found) {
+			EXPECT_UINTEQ(value, ikey);
+			++num_found;
+		}
+	}
+	EXPECT_SIZEEQ(hashindex_size(index), num_found);
+
+	//Index is usable after recovery
+	for (ikey = 0; ikey < num_keys; ++ikey)
+		EXPECT_TRUE(hashindex_set(index, hashindex_test_key(ikey), ikey + 1));
+	EXPECT_SIZEEQ(hashindex_size(index), num_keys);
+	EXPECT_TRUE(hashindex_commit(index));
+
+	//Crash with uncommitted erasures and updates
+	for (ikey = 0; ikey < num_keys; ikey += 3)
+		EXPECT_TRUE(hashindex_erase(index, hashindex_test_key(ikey)));
+	for (ikey = 1; ikey < num_keys; ikey += 3)
+		EXPECT_TRUE(hashindex_set(index, hashindex_test_key(ikey), 0));
+	hashindex_test_crash(index);
+
+	index = hashindex_open(STRING_ARGS(path), STREAM_IN);
+	EXPECT_NE(index, nullptr);
+	num_found = 0;
+	for (ikey = 0; ikey < num_keys; ++ikey) {
+		bool found = hashindex_lookup(index, hashindex_test_key(ikey), &value);
+		if ((ikey % 3) != 0)
+			EXPECT_TRUE(found);
+		if (found) {
+			if ((ikey % 3) == 1)
+				EXPECT_TRUE((value == 0) || (value == ikey + 1));
+			else
+				EXPECT_UINTEQ(value, ikey + 1);
+			++num_found;
+		}
+	}
+	EXPECT_SIZEEQ(hashindex_size(index), num_found);
+	hashindex_close(index);
+
+	//Torn write of the newest header falls back to the previous header
+	index = hashindex_open(STRING_ARGS(path), STREAM_IN | STREAM_OUT | STREAM_TRUNCATE);
+	EXPECT_NE(index, nullptr);
+	for (ikey = 0; ikey < num_committed; ++ikey)
+		EXPECT_TRUE(hashindex_set(index, hashindex_test_key(ikey), ikey));
+	EXPECT_TRUE(hashindex_commit(index));
+	for (; ikey < num_keys; ++ikey)
+		EXPECT_TRUE(hashindex_set(index, hashindex_test_key(ikey), ikey));
+	EXPECT_TRUE(hashindex_commit(index));
+	sequence = index->sequence;
+	hashindex_test_crash(index);
+	{
+		fs_map_t map;
+		EXPECT_TRUE(fs_map_file(&map, STRING_ARGS(path), STREAM_IN | STREAM_OUT));
+		((char*)map.data)[(sequence & 1) * 2048 + 32] ^= 0x55;
+		EXPECT_TRUE(fs_map_flush(&map, 0, map.size));
+		fs_unmap_file(&map);
+	}
+
+	index = hashindex_open(STRING_ARGS(path), STREAM_IN | STREAM_OUT);
+	EXPECT_NE(index, nullptr);
+	EXPECT_UINTEQ(index->sequence, sequence - 1);
+	num_found = 0;
+	for (ikey = 0; ikey < num_keys; ++ikey) {
+		bool found = hashindex_lookup(index, hashindex_test_key(ikey), &value);
+		if (ikey < num_committed)
+			EXPECT_TRUE(found);
+		if (found) {
+			EXPECT_UINTEQ(value, ikey);
+			++num_found;
+		}
+	}
+	EXPECT_SIZEEQ(hashindex_size(index), num_found);
+	hashindex_close(index);
+
+	fs_remove_file(STRING_ARGS(path));
+	return 0;
+}
+
+DECLARE_TEST(hashindex, full) {
+#if FOUNDATION_PLATFORM_POSIX
+	char buffer[BUILD_MAX_PATHLEN];
+	string_t path = hashindex_test_path(buffer, sizeof(buffer));
+	size_t num_committed = 20000;
+	size_t num_keys = 0;
+	struct rlimit limit, prev_limit;
+	hashindex_t* index;
+	uint64_t value = 0;
+	bool failed = false;
+	size_t ikey;
+
+	index = hashindex_open(STRING_ARGS(path), STREAM_IN | STREAM_OUT | STREAM_CREATE);
+	EXPECT_NE(index, nullptr);
+	for (ikey = 0; ikey < num_committed; ++ikey)
+		EXPECT_TRUE(hashindex_set(index, hashindex_test_key(ikey), ikey));
+	EXPECT_TRUE(hashindex_commit(index));
+
+	//Limit the file size to make growing the file fail, as with a full disk
+	getrlimit(RLIMIT_FSIZE, &prev_limit);
+	limit = prev_limit;
+	limit.rlim_cur = (rlim_t)index->map.size + (64 * 4096);
+	signal(SIGXFSZ, SIG_IGN);
+	setrlimit(RLIMIT_FSIZE, &limit);
+	log_enable_stdout(false);
+	for (ikey = num_committed; !failed && (ikey < 1000000); ++ikey) {
+		if (hashindex_set(index, hashindex_test_key(ikey), ikey))
+			num_keys = ikey + 1;
+		else
+			failed = true;
+	}
+	log_enable_stdout(true);
+	setrlimit(RLIMIT_FSIZE, &prev_limit);
+	signal(SIGXFSZ, SIG_DFL);
+	EXPECT_TRUE(failed);
+
+	//A failed insert or bucket split leaves all stored keys reachable
+	EXPECT_SIZEEQ(hashindex_size(index), num_keys);
+	EXPECT_FALSE(hashindex_lookup(index, hashindex_test_key(num_keys), &value));
+	for (ikey = 0; ikey < num_keys; ++ikey) {
+		EXPECT_TRUE(hashindex_lookup(index, hashindex_test_key(ikey), &value));
+		EXPECT_UINTEQ(value, ikey);
+	}
+	EXPECT_TRUE(hashindex_commit(index));
+	hashindex_close(index);
+
+	index = hashindex_open(STRING_ARGS(path), STREAM_IN);
+	EXPECT_NE(index, nullptr);
+	EXPECT_SIZEEQ(hashindex_size(index), num_keys);
+	for (ikey = 0; ikey < num_keys; ++ikey) {
+		EXPECT_TRUE(hashindex_lookup(index, hashindex_test_key(ikey), &value));
+		EXPECT_UINTEQ(value, ikey);
+	}
+	hashindex_close(index);
+
+	fs_remove_file(STRING_ARGS(path));
+#endif
+	return 0;
+}
+
+DECLARE_TEST(hashindex, performance) {
+	char buffer[BUILD_MAX_PATHLEN];
+	string_t path = hashindex_test_path(buffer, sizeof(buffer));
+	size_t num_keys = 500000;
+	size_t num_lookups = 1000000;
+	hashindex_t* index;
+	uint64_t value = 0;
+	uint64_t sum = 0;
+	tick_t start, insert_time, commit_time, open_time, lookup_time;
+	size_t ikey;
+
+	index = hashindex_open(STRING_ARGS(path), STREAM_IN | STREAM_OUT | STREAM_CREATE);
+	EXPECT_NE(index, nullptr);
+	start = time_current();
+	for (ikey = 0; ikey < num_keys; ++ikey)
+		hashindex_set(index, hashindex_test_key(ikey), ikey);
+	insert_time = time_diff(start, time_current());
+	start = time_current();
+	EXPECT_TRUE(hashindex_commit(index));
+	commit_time = time_diff(start, time_current());
+	hashindex_close(index);
+
+	//Opening does not read the index
+	start = time_current();
+	index = hashindex_open(STRING_ARGS(path), STREAM_IN);
+	open_time = time_diff(start, time_current());
+	EXPECT_NE(index, nullptr);
+	EXPECT_SIZEEQ(hashindex_size(index), num_keys);
+
+	start = time_current();
+	for (ikey = 0; ikey < num_lookups; ++ikey) {
+		size_t ientry = (size_t)((ikey * 7919) % num_keys);
+		if (hashindex_lookup(index, hashindex_test_key(ientry), &value))
+			sum += value;
+	}
+	lookup_time = time_diff(start, time_current());
+	EXPECT_GT(sum, 0);
+	hashindex_close(index);
+
+	log_infof(HASH_TEST, STRING_CONST("Hash index insert: %.3f us/key, commit: %.3f ms"),
+	          (time_ticks_to_seconds(insert_time) * 1000000.0) / (double)num_keys,
+	          time_ticks_to_seconds(commit_time) * 1000.0);
+	log_infof(HASH_TEST, STRING_CONST("Hash index open: %.3f us, lookup: %.3f ns/key"),
+	          time_ticks_to_seconds(open_time) * 1000000.0,
+	          (time_ticks_to_seconds(lookup_time) * 1000000000.0) / (double)num_lookups);
+
+	fs_remove_file(STRING_ARGS(path));
+	return 0;
+}
+
+static void
+test_hashindex_declare(void) {
+	ADD_TEST(hashindex, basic);
+	ADD_TEST(hashindex, growth);
+	ADD_TEST(hashindex, crash);
+	ADD_TEST(hashindex, full);
+	ADD_TEST(hashindex, performance);
+}
+
+static test_suite_t test_hashindex_suite = {
+	test_hashindex_application,
+	test_hashindex_memory_system,
+	test_hashindex_config,
+	test_hashindex_declare,
+	test_hashindex_initialize,
+	test_hashindex_finalize,
+	0
+};
+
+#if BUILD_MONOLITHIC
+
+int
+test_hashindex_run(void);
+
+int
+test_hashindex_run(void) {
+	test_suite = test_hashindex_suite;
+	return test_run_all();
+}
+
+#else
+
+test_suite_t
+test_suite_define(void);
+
+test_suite_t
+test_suite_define(void) {
+	return test_hashindex_suite;
+}
+
+#endif
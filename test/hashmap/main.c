@@ -161,12 +161,214 @@ DECLARE_TEST(hashmap, lookup) {
 	return 0;
 }
 
+DECLARE_TEST(hashmap, concurrent) {
+	hashmap_concurrent_t* map = hashmap_concurrent_allocate(0, 0);
+	char* value = (void*)(uintptr_t)1234;
+	hash_t key;
+	unsigned int ikey;
+
+	EXPECT_SIZEEQ(hashmap_concurrent_size(map), 0);
+	EXPECT_EQ(hashmap_concurrent_lookup(map, 0), 0);
+
+	EXPECT_EQ(hashmap_concurrent_insert(map, 0, map), 0);
+	EXPECT_EQ(hashmap_concurrent_insert(map, 0, map), map);
+	EXPECT_EQ(hashmap_concurrent_lookup(map, 0), map);
+	EXPECT_SIZEEQ(hashmap_concurrent_size(map), 1);
+	EXPECT_EQ(hashmap_concurrent_insert(map, 0, 0), map);
+	EXPECT_FALSE(hashmap_concurrent_has_key(map, 0));
+	EXPECT_SIZEEQ(hashmap_concurrent_size(map), 0);
+
+	//Sequential keys force growth of all shards
+	for (ikey = 0, key = 4321; ikey < 16 * 1024; ++ikey, ++key)
+		EXPECT_EQ(hashmap_concurrent_insert(map, key, value + ikey), 0);
+	EXPECT_SIZEEQ(hashmap_concurrent_size(map), 16 * 1024);
+
+	//Erase every other key, remaining keys must still be found across shifted probe chains
+	for (ikey = 0, key = 4321; ikey < 16 * 1024; ikey += 2, key += 2)
+		EXPECT_EQ(hashmap_concurrent_erase(map, key), value + ikey);
+	EXPECT_SIZEEQ(hashmap_concurrent_size(map), 8 * 1024);
+	for (ikey = 0, key = 4321; ikey < 16 * 1024; ++ikey, ++key) {
+		if (ikey % 2)
+			EXPECT_EQ(hashmap_concurrent_lookup(map, key), value + ikey);
+		else
+			EXPECT_FALSE(hashmap_concurrent_has_key(map, key));
+	}
+	EXPECT_EQ(hashmap_concurrent_erase(map, 4321), 0);
+
+	hashmap_concurrent_clear(map);
+	EXPECT_SIZEEQ(hashmap_concurrent_size(map), 0);
+	EXPECT_EQ(hashmap_concurrent_lookup(map, 4322), 0);
+
+	hashmap_concurrent_deallocate(map);
+
+	return 0;
+}
+
+typedef struct {
+	hashmap_concurrent_t* concurrent;
+	hashmap_t* map;
+	mutex_t* lock;
+	hash_t key_base;
+	size_t num_keys;
+	size_t num_ops;
+	unsigned int write_percent;
+} hashmap_thread_arg_t;
+
+static void*
+hashmap_concurrent_thread(void* arg) {
+	hashmap_thread_arg_t* thread_arg = arg;
+	hashmap_concurrent_t* map = thread_arg->concurrent;
+	size_t ikey, iloop;
+
+	for (iloop = 0; iloop < 16; ++iloop) {
+		for (ikey = 0; ikey < thread_arg->num_keys; ++ikey) {
+			hash_t key = thread_arg->key_base + ikey;
+			EXPECT_EQ(hashmap_concurrent_insert(map, key, (void*)(uintptr_t)(key + iloop)), 0);
+		}
+		for (ikey = 0; ikey < thread_arg->num_keys; ++ikey) {
+			hash_t key = thread_arg->key_base + ikey;
+			//Shared read-only keys must always be found while other keys are inserted and erased
+			EXPECT_EQ(hashmap_concurrent_lookup(map, ikey + 1), (void*)(uintptr_t)(ikey + 1));
+			EXPECT_EQ(hashmap_concurrent_lookup(map, key), (void*)(uintptr_t)(key + iloop));
+		}
+		for (ikey = 0; ikey < thread_arg->num_keys; ++ikey) {
+			hash_t key = thread_arg->key_base + ikey;
+			EXPECT_EQ(hashmap_concurrent_erase(map, key), (void*)(uintptr_t)(key + iloop));
+			EXPECT_EQ(hashmap_concurrent_lookup(map, key), 0);
+		}
+	}
+	return 0;
+}
+
+DECLARE_TEST(hashmap, concurrent_thread) {
+	hashmap_concurrent_t* map = hashmap_concurrent_allocate(4, 0);
+	hashmap_thread_arg_t arg[32];
+	thread_t thread[32];
+	size_t ith, ikey;
+	size_t num_threads = math_clamp(system_hardware_threads() * 2, 4, 32);
+
+	for (ikey = 0; ikey < 1024; ++ikey)
+		hashmap_concurrent_insert(map, ikey + 1, (void*)(uintptr_t)(ikey + 1));
+
+	for (ith = 0; ith < num_threads; ++ith) {
+		arg[ith].concurrent = map;
+		arg[ith].key_base = (hash_t)(ith + 1) << 32;
+		arg[ith].num_keys = 1024;
+		thread_initialize(&thread[ith], hashmap_concurrent_thread, arg + ith,
+		                  STRING_CONST("hashmap_thread"), THREAD_PRIORITY_NORMAL, 0);
+	}
+	for (ith = 0; ith < num_threads; ++ith)
+		thread_start(&thread[ith]);
+
+	test_wait_for_threads_startup(thread, num_threads);
+	test_wait_for_threads_finish(thread, num_threads);
+
+	for (ith = 0; ith < num_threads; ++ith)
+		thread_finalize(&thread[ith]);
+
+	EXPECT_SIZEEQ(hashmap_concurrent_size(map), 1024);
+
+	hashmap_concurrent_deallocate(map);
+
+	return 0;
+}
+
+static void*
+hashmap_benchmark_thread(void* arg) {
+	hashmap_thread_arg_t* thread_arg = arg;
+	size_t iop;
+	hash_t key = thread_arg->key_base;
+	for (iop = 0; iop < thread_arg->num_ops; ++iop) {
+		bool write;
+		key = key * 6364136223846793005ULL + 1442695040888963407ULL;
+		write = ((key >> 33) % 100) < thread_arg->write_percent;
+		if (thread_arg->concurrent) {
+			if (write)
+				hashmap_concurrent_insert(thread_arg->concurrent, (key >> 40) % thread_arg->num_keys + 1,
+				                          (void*)(uintptr_t)key);
+			else
+				hashmap_concurrent_lookup(thread_arg->concurrent, (key >> 40) % thread_arg->num_keys + 1);
+		}
+		else {
+			mutex_lock(thread_arg->lock);
+			if (write)
+				hashmap_insert(thread_arg->map, (key >> 40) % thread_arg->num_keys + 1, (void*)(uintptr_t)key);
+			else
+				hashmap_lookup(thread_arg->map, (key >> 40) % thread_arg->num_keys + 1);
+			mutex_unlock(thread_arg->lock);
+		}
+	}
+	return 0;
+}
+
+DECLARE_TEST(hashmap, concurrent_scaling) {
+	hashmap_concurrent_t* concurrent = hashmap_concurrent_allocate(0, 0);
+	hashmap_t* map = hashmap_allocate(1021, 0);
+	mutex_t* lock = mutex_allocate(STRING_CONST("hashmap"));
+	hashmap_thread_arg_t arg[16];
+	thread_t thread[16];
+	size_t num_keys = 64 * 1024;
+	size_t num_ops = 200000;
+	size_t max_threads = math_clamp(system_hardware_threads(), 2, 16);
+	size_t num_threads, ith, ikey;
+	unsigned int write_percent[] = { 1, 10, 50 };
+	size_t imix, itype;
+
+	for (ikey = 0; ikey < num_keys; ++ikey) {
+		hashmap_concurrent_insert(concurrent, ikey + 1, (void*)(uintptr_t)ikey + 1);
+		hashmap_insert(map, ikey + 1, (void*)(uintptr_t)ikey + 1);
+	}
+
+	for (imix = 0; imix < sizeof(write_percent) / sizeof(write_percent[0]); ++imix) {
+		for (num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+			double mops[2];
+			for (itype = 0; itype < 2; ++itype) {
+				tick_t start, elapsed;
+				for (ith = 0; ith < num_threads; ++ith) {
+					arg[ith].concurrent = itype ? concurrent : 0;
+					arg[ith].map = map;
+					arg[ith].lock = lock;
+					arg[ith].key_base = ith + 1;
+					arg[ith].num_keys = num_keys;
+					arg[ith].num_ops = num_ops;
+					arg[ith].write_percent = write_percent[imix];
+					thread_initialize(&thread[ith], hashmap_benchmark_thread, arg + ith,
+					                  STRING_CONST("hashmap_bench"), THREAD_PRIORITY_NORMAL, 0);
+				}
+				start = time_current();
+				for (ith = 0; ith < num_threads; ++ith)
+					thread_start(&thread[ith]);
+				for (ith = 0; ith < num_threads; ++ith)
+					thread_join(&thread[ith]);
+				elapsed = time_diff(start, time_current());
+				for (ith = 0; ith < num_threads; ++ith)
+					thread_finalize(&thread[ith]);
+				mops[itype] = (double)(num_ops * num_threads) / time_ticks_to_seconds(elapsed) / 1000000.0;
+			}
+			log_infof(HASH_TEST,
+			          STRING_CONST("Hashmap %u%% writes, %" PRIsize " threads: mutex %.2f Mops/s, concurrent %.2f Mops/s"),
+			          write_percent[imix], num_threads, mops[0], mops[1]);
+		}
+	}
+
+	EXPECT_SIZEEQ(hashmap_concurrent_size(concurrent), num_keys);
+
+	mutex_deallocate(lock);
+	hashmap_deallocate(map);
+	hashmap_concurrent_deallocate(concurrent);
+
+	return 0;
+}
+
 static void
 test_hashmap_declare(void) {
 	ADD_TEST(hashmap, allocation);
 	ADD_TEST(hashmap, insert);
 	ADD_TEST(hashmap, erase);
 	ADD_TEST(hashmap, lookup);
+	ADD_TEST(hashmap, concurrent);
+	ADD_TEST(hashmap, concurrent_thread);
+	ADD_TEST(hashmap, concurrent_scaling);
 }
 
 
@@ -66,6 +66,19 @@ typedef struct {
 	uint64_t             key_num;
 } producer64_arg_t;
 
+typedef struct {
+	hashtable64_t*       table;
+	hashtable64_topk_t*  topk;
+	uint64_t             key_num;
+	uint64_t             seed;
+} counter64_arg_t;
+
+typedef struct {
+	hashtable128_t*      table;
+	uint64_t             key_offset;
+	uint64_t             key_num;
+} producer128_arg_t;
+
 static void*
 producer32_thread(void* arg) {
 	producer32_arg_t* parg = arg;
@@ -112,6 +125,67 @@ producer64_thread(void* arg) {
 	return 0;
 }
 
+static void*
+counter64_thread(void* arg) {
+	counter64_arg_t* parg = arg;
+	uint64_t key, iter;
+
+	for (iter = 0; iter < 64; ++iter) {
+		for (key = 1; key <= parg->key_num; ++key) {
+			hashtable64_add(parg->table, key, 1);
+			hashtable64_max(parg->table, key + parg->key_num, iter + parg->seed);
+		}
+		thread_yield();
+	}
+
+	return 0;
+}
+
+static void*
+topk64_thread(void* arg) {
+	counter64_arg_t* parg = arg;
+	uint64_t key, hit;
+
+	//Key n is hit n times, visited in an order depending on the thread seed
+	for (key = 1; key <= parg->key_num; ++key) {
+		uint64_t mixed = 1 + ((key * 7919 + parg->seed) % parg->key_num);
+		for (hit = 0; hit < mixed; ++hit)
+			hashtable64_topk_add(parg->topk, mixed, 1);
+		if (!(key % 64))
+			thread_yield();
+	}
+
+	return 0;
+}
+
+static void*
+producer128_thread(void* arg) {
+	producer128_arg_t* parg = arg;
+	hashtable128_t* table = parg->table;
+	uint64_t key_offset = parg->key_offset;
+	uint64_t key;
+
+	//Keys share one of the words with keys of the other half, so a torn key read shows up
+	for (key = 0; key < parg->key_num; ++key) {
+		hashtable128_set(table, uint128_make(1 + key + key_offset, 0), 1);
+		hashtable128_set(table, uint128_make(0, 1 + key + key_offset), 1);
+	}
+
+	thread_yield();
+
+	for (key = 0; key < parg->key_num / 2; ++key)
+		hashtable128_erase(table, uint128_make(1 + key + key_offset, 0));
+
+	thread_yield();
+
+	for (key = 0; key < parg->key_num; ++key) {
+		hashtable128_set(table, uint128_make(1 + key + key_offset, 0), 1 + ((key + key_offset) % 17));
+		hashtable128_set(table, uint128_make(0, 1 + key + key_offset), 2 + ((key + key_offset) % 13));
+	}
+
+	return 0;
+}
+
 DECLARE_TEST(hashtable, 32bit_basic) {
 	hashtable32_t* table = hashtable32_allocate(3);
 
@@ -329,12 +403,308 @@ DECLARE_TEST(hashtable, 64bit_threaded) {
 	return 0;
 }
 
+DECLARE_TEST(hashtable, 64bit_atomic) {
+	hashtable64_t* table = hashtable64_allocate(3);
+
+	EXPECT_EQ(hashtable64_add(table, 1, 2), 2);
+	EXPECT_EQ(hashtable64_add(table, 1, 3), 5);
+	EXPECT_EQ(hashtable64_add(table, 1, -1), 4);
+	EXPECT_EQ(hashtable64_get(table, 1), 4);
+
+	EXPECT_FALSE(hashtable64_cas(table, 1, 10, 5));
+	EXPECT_TRUE(hashtable64_cas(table, 1, 10, 4));
+	EXPECT_EQ(hashtable64_get(table, 1), 10);
+
+	//Insert if absent
+	EXPECT_FALSE(hashtable64_cas(table, 2, 20, 1));
+	EXPECT_EQ(hashtable64_get(table, 2), 0);
+	EXPECT_TRUE(hashtable64_cas(table, 2, 20, 0));
+	EXPECT_FALSE(hashtable64_cas(table, 2, 21, 0));
+	EXPECT_EQ(hashtable64_get(table, 2), 20);
+	hashtable64_erase(table, 2);
+	EXPECT_TRUE(hashtable64_cas(table, 2, 22, 0));
+	EXPECT_EQ(hashtable64_get(table, 2), 22);
+
+	EXPECT_EQ(hashtable64_max(table, 3, 7), 7);
+	EXPECT_EQ(hashtable64_max(table, 3, 5), 7);
+	EXPECT_EQ(hashtable64_max(table, 3, 9), 9);
+	EXPECT_EQ(hashtable64_get(table, 3), 9);
+	EXPECT_SIZEEQ(hashtable64_size(table), 3);
+
+	//Table full
+	EXPECT_EQ(hashtable64_add(table, 4, 1), 0);
+	EXPECT_FALSE(hashtable64_cas(table, 4, 1, 0));
+	EXPECT_EQ(hashtable64_max(table, 4, 1), 0);
+	EXPECT_EQ(hashtable64_get(table, 4), 0);
+
+	hashtable64_deallocate(table);
+
+	return 0;
+}
+
+DECLARE_TEST(hashtable, 64bit_counting) {
+	thread_t thread[32];
+	counter64_arg_t args[32];
+	size_t i, num_threads;
+	uint64_t key;
+	const uint64_t key_num = 4096;
+
+	hashtable64_t* table = hashtable64_allocate(key_num * 4);
+
+	num_threads = math_clamp(system_hardware_threads() * 2U, 4U, 32U);
+	for (i = 0; i < num_threads; ++i) {
+		args[i].table = table;
+		args[i].topk = 0;
+		args[i].key_num = key_num;
+		args[i].seed = i;
+		thread_initialize(&thread[i], counter64_thread, args + i, STRING_CONST("table_counter"),
+		                  THREAD_PRIORITY_NORMAL, 0);
+	}
+	for (i = 0; i < num_threads; ++i)
+		thread_start(&thread[i]);
+
+	test_wait_for_threads_startup(thread, num_threads);
+	test_wait_for_threads_finish(thread, num_threads);
+
+	for (i = 0; i < num_threads; ++i)
+		thread_finalize(&thread[i]);
+
+	//No increments lost and no duplicate slots for a key claimed concurrently
+	for (key = 1; key <= key_num; ++key) {
+		EXPECT_EQ(hashtable64_get(table, key), 64 * num_threads);
+		EXPECT_EQ(hashtable64_get(table, key + key_num), 63 + (num_threads - 1));
+	}
+	EXPECT_SIZEEQ(hashtable64_size(table), key_num * 2);
+
+	hashtable64_deallocate(table);
+
+	return 0;
+}
+
+DECLARE_TEST(hashtable, 64bit_topk) {
+	thread_t thread[32];
+	counter64_arg_t args[32];
+	uint64_t keys[16];
+	uint64_t counts[16];
+	size_t i, num_threads;
+	const uint64_t key_num = 1024;
+
+	hashtable64_topk_t* topk = hashtable64_topk_allocate(key_num * 2, 10);
+
+	EXPECT_SIZEEQ(hashtable64_topk_get(topk, keys, counts, 16), 0);
+
+	num_threads = math_clamp(system_hardware_threads() * 2U, 4U, 32U);
+	for (i = 0; i < num_threads; ++i) {
+		args[i].table = 0;
+		args[i].topk = topk;
+		args[i].key_num = key_num;
+		args[i].seed = i * 131;
+		thread_initialize(&thread[i], topk64_thread, args + i, STRING_CONST("table_topk"),
+		                  THREAD_PRIORITY_NORMAL, 0);
+	}
+	for (i = 0; i < num_threads; ++i)
+		thread_start(&thread[i]);
+
+	test_wait_for_threads_startup(thread, num_threads);
+	test_wait_for_threads_finish(thread, num_threads);
+
+	for (i = 0; i < num_threads; ++i)
+		thread_finalize(&thread[i]);
+
+	EXPECT_EQ(hashtable64_topk_count(topk, key_num), key_num * num_threads);
+	EXPECT_SIZEEQ(hashtable64_topk_get(topk, keys, counts, 16), 10);
+	for (i = 0; i < 10; ++i) {
+		EXPECT_EQ(keys[i], key_num - i);
+		EXPECT_EQ(counts[i], (key_num - i) * num_threads);
+	}
+
+	EXPECT_SIZEEQ(hashtable64_topk_get(topk, keys, counts, 3), 3);
+	EXPECT_EQ(keys[0], key_num);
+	EXPECT_EQ(keys[2], key_num - 2);
+
+	hashtable64_topk_clear(topk);
+	EXPECT_SIZEEQ(hashtable64_topk_get(topk, keys, counts, 16), 0);
+	EXPECT_EQ(hashtable64_topk_add(topk, 5, 3), 3);
+	EXPECT_SIZEEQ(hashtable64_topk_get(topk, keys, counts, 16), 1);
+	EXPECT_EQ(keys[0], 5);
+	EXPECT_EQ(counts[0], 3);
+
+	hashtable64_topk_deallocate(topk);
+
+	return 0;
+}
+
+DECLARE_TEST(hashtable, 128bit_basic) {
+	hashtable128_t* table = hashtable128_allocate(3);
+	uint128_t key1 = uint128_make(1, 0);
+	uint128_t key2 = uint128_make(0, 1);
+	uint128_t key3 = uint128_make(1, 1);
+	uint128_t key4 = uint128_make(0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL);
+	uint128_t keys[5];
+	uint64_t values[5];
+
+	EXPECT_SIZEEQ(hashtable128_size(table), 0);
+
+	hashtable128_set(table, key1, 1);
+	EXPECT_EQ(hashtable128_get(table, key1), 1);
+	EXPECT_EQ(hashtable128_get(table, key2), 0);
+	EXPECT_EQ(hashtable128_get(table, key3), 0);
+
+	hashtable128_erase(table, key1);
+	EXPECT_EQ(hashtable128_get(table, key1), 0);
+
+	hashtable128_set(table, key1, 2);
+	EXPECT_EQ(hashtable128_get(table, key1), 2);
+
+	hashtable128_set(table, key2, 3);
+	hashtable128_set(table, key3, 4);
+	EXPECT_EQ(hashtable128_get(table, key1), 2);
+	EXPECT_EQ(hashtable128_get(table, key2), 3);
+	EXPECT_EQ(hashtable128_get(table, key3), 4);
+	EXPECT_SIZEEQ(hashtable128_size(table), 3);
+
+	EXPECT_FALSE(hashtable128_set(table, key4, 5));
+	EXPECT_EQ(hashtable128_get(table, key4), 0);
+	hashtable128_erase(table, key4);
+	EXPECT_SIZEEQ(hashtable128_size(table), 3);
+
+	keys[0] = key3;
+	keys[1] = key4;
+	keys[2] = key1;
+	keys[3] = key2;
+	keys[4] = key3;
+	hashtable128_get_batch(table, keys, values, 5);
+	EXPECT_EQ(values[0], 4);
+	EXPECT_EQ(values[1], 0);
+	EXPECT_EQ(values[2], 2);
+	EXPECT_EQ(values[3], 3);
+	EXPECT_EQ(values[4], 4);
+
+	hashtable128_erase(table, key2);
+	EXPECT_EQ(hashtable128_get(table, key2), 0);
+	EXPECT_SIZEEQ(hashtable128_size(table), 2);
+
+	hashtable128_clear(table);
+	EXPECT_SIZEEQ(hashtable128_size(table), 0);
+	EXPECT_EQ(hashtable128_get(table, key1), 0);
+
+	hashtable128_deallocate(table);
+
+	return 0;
+}
+
+DECLARE_TEST(hashtable, 128bit_threaded) {
+	thread_t thread[32];
+	producer128_arg_t args[32];
+	unsigned int i, j;
+	size_t num_threads = 0;
+
+	hashtable128_t* table = hashtable128_allocate(2 * (32 * 16789 + 65536));
+
+	EXPECT_EQ(hashtable128_size(table), 0);
+
+	num_threads = math_clamp(system_hardware_threads() * 2U, 4U, 32U);
+	for (i = 0; i < num_threads; ++i) {
+		args[i].table = table;
+		args[i].key_offset = (i * 16789);
+		args[i].key_num = 65535;
+
+		thread_initialize(&thread[i], producer128_thread, args + i, STRING_CONST("table_producer"),
+		                  THREAD_PRIORITY_NORMAL, 0);
+	}
+	for (i = 0; i < num_threads; ++i)
+		thread_start(&thread[i]);
+
+	test_wait_for_threads_startup(thread, num_threads);
+	test_wait_for_threads_finish(thread, num_threads);
+
+	for (i = 0; i < num_threads; ++i)
+		thread_finalize(&thread[i]);
+
+	for (i = 0; i < num_threads; ++i) {
+		for (j = 1; j < 65535; ++j) {
+			uint64_t key = (i * 16789) + j;
+			EXPECT_EQ(hashtable128_get(table, uint128_make(1 + key, 0)), 1 + (key % 17));
+			EXPECT_EQ(hashtable128_get(table, uint128_make(0, 1 + key)), 2 + (key % 13));
+			EXPECT_EQ(hashtable128_get(table, uint128_make(1 + key, 1 + key)), 0);
+		}
+	}
+
+	EXPECT_SIZEGE(hashtable128_size(table), 2 * ((num_threads - 1) * 16789 + 65535));
+	hashtable128_clear(table);
+	EXPECT_SIZEEQ(hashtable128_size(table), 0);
+
+	hashtable128_deallocate(table);
+
+	return 0;
+}
+
+DECLARE_TEST(hashtable, 128bit_performance) {
+	const size_t num_keys = 256 * 1024;
+	const size_t buckets = num_keys * 2;
+	hashtable128_t* table = hashtable128_allocate(buckets);
+	hashtable64_t* folded = hashtable64_allocate(buckets);
+	uint128_t* keys = memory_allocate(0, sizeof(uint128_t) * num_keys, 16, MEMORY_PERSISTENT);
+	uint64_t* values = memory_allocate(0, sizeof(uint64_t) * num_keys, 0, MEMORY_PERSISTENT);
+	uint64_t sum_get = 0, sum_batch = 0, sum_fold = 0;
+	tick_t start, time_get, time_batch, time_fold;
+	size_t ikey;
+
+	for (ikey = 0; ikey < num_keys; ++ikey) {
+		keys[ikey] = uuid_generate_random();
+		EXPECT_TRUE(hashtable128_set(table, keys[ikey], ikey + 1));
+		//Reference approach, fold the key to 64 bits and verify the full key in a side array
+		EXPECT_TRUE(hashtable64_set(folded, keys[ikey].word[0] ^ keys[ikey].word[1], ikey + 1));
+	}
+
+	start = time_current();
+	for (ikey = 0; ikey < num_keys; ++ikey)
+		sum_get += hashtable128_get(table, keys[ikey]);
+	time_get = time_diff(start, time_current());
+
+	start = time_current();
+	hashtable128_get_batch(table, keys, values, num_keys);
+	for (ikey = 0; ikey < num_keys; ++ikey)
+		sum_batch += values[ikey];
+	time_batch = time_diff(start, time_current());
+
+	start = time_current();
+	for (ikey = 0; ikey < num_keys; ++ikey) {
+		uint64_t value = hashtable64_get(folded, keys[ikey].word[0] ^ keys[ikey].word[1]);
+		if (value && uint128_equal(keys[value - 1], keys[ikey]))
+			sum_fold += value;
+	}
+	time_fold = time_diff(start, time_current());
+
+	EXPECT_EQ(sum_get, ((uint64_t)num_keys * (num_keys + 1)) / 2);
+	EXPECT_EQ(sum_batch, sum_get);
+	EXPECT_EQ(sum_fold, sum_get);
+
+	log_infof(HASH_TEST, STRING_CONST("hashtable128 lookup of %" PRIsize " keys: get %.2fms, batch %.2fms, "
+	                                  "hashtable64 fold and verify %.2fms"), num_keys,
+	          time_ticks_to_seconds(time_get) * 1000.0, time_ticks_to_seconds(time_batch) * 1000.0,
+	          time_ticks_to_seconds(time_fold) * 1000.0);
+
+	memory_deallocate(values);
+	memory_deallocate(keys);
+	hashtable64_deallocate(folded);
+	hashtable128_deallocate(table);
+
+	return 0;
+}
+
 static void
 test_hashtable_declare(void) {
 	ADD_TEST(hashtable, 32bit_basic);
 	ADD_TEST(hashtable, 32bit_threaded);
 	ADD_TEST(hashtable, 64bit_basic);
 	ADD_TEST(hashtable, 64bit_threaded);
+	ADD_TEST(hashtable, 64bit_atomic);
+	ADD_TEST(hashtable, 64bit_counting);
+	ADD_TEST(hashtable, 64bit_topk);
+	ADD_TEST(hashtable, 128bit_basic);
+	ADD_TEST(hashtable, 128bit_threaded);
+	ADD_TEST(hashtable, 128bit_performance);
 }
 
 static test_suite_t test_hashtable_suite = {
@@ -0,0 +1,465 @@
+/* main.c  -  Foundation heap test  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+#include <test/test.h>
+
+#include <stdlib.h>
+
+static application_t
+test_heap_application(void) {
+	application_t app;
+	memset(&app, 0, sizeof(app));
+	app.name = string_const(STRING_CONST("Foundation heap tests"));
+	app.short_name = string_const(STRING_CONST("test_heap"));
+	app.company = string_const(STRING_CONST("Rampant Pixels"));
+	app.flags = APPLICATION_UTILITY;
+	app.exception_handler = test_exception_handler;
+	return app;
+}
+
+static memory_system_t
+test_heap_memory_system(void) {
+	return memory_system_malloc();
+}
+
+static foundation_config_t
+test_heap_config(void) {
+	foundation_config_t config;
+	memset(&config, 0, sizeof(config));
+	return config;
+}
+
+static int
+test_heap_initialize(void) {
+	return 0;
+}
+
+static void
+test_heap_finalize(void) {
+}
+
+typedef int (*heap_compare_fn)(const void*, const void*);
+
+//Binary heap with function pointer comparisons, reference for the performance test
+typedef struct {
+	heap_entry_t* entry;
+	size_t size;
+	heap_compare_fn compare;
+} heap_binary_t;
+
+static int
+heap_compare_entry(const void* first, const void* second) {
+	uint64_t lhs = ((const heap_entry_t*)first)->key;
+	uint64_t rhs = ((const heap_entry_t*)second)->key;
+	return (lhs < rhs) ? -1 : ((lhs > rhs) ? 1 : 0);
+}
+
+static void
+heap_binary_push(heap_binary_t* heap, heap_entry_t item) {
+	size_t pos = heap->size++;
+	while (pos) {
+		size_t parent = (pos - 1) / 2;
+		if (heap->compare(&item, heap->entry + parent) >= 0)
+			break;
+		heap->entry[pos] = heap->entry[parent];
+		pos = parent;
+	}
+	heap->entry[pos] = item;
+}
+
+static heap_entry_t
+heap_binary_pop(heap_binary_t* heap) {
+	heap_entry_t top = heap->entry[0];
+	heap_entry_t item = heap->entry[--heap->size];
+	size_t pos = 0;
+	while (true) {
+		size_t child = (pos * 2) + 1;
+		if (child >= heap->size)
+			break;
+		if ((child + 1 < heap->size) && (heap->compare(heap->entry + child + 1, heap->entry + child) < 0))
+			++child;
+		if (heap->compare(heap->entry + child, &item) >= 0)
+			break;
+		heap->entry[pos] = heap->entry[child];
+		pos = child;
+	}
+	heap->entry[pos] = item;
+	return top;
+}
+
+static bool
+heap_verify(const heap_t* heap) {
+	size_t size = heap_size(heap);
+	size_t pos;
+	for (pos = 1; pos < size; ++pos) {
+		if (heap->entry[pos].key < heap->entry[(pos - 1) >> heap->shift].key)
+			return false;
+		if (heap->indexed && (heap->index[heap->entry[pos].id] != pos + 1))
+			return false;
+	}
+	return true;
+}
+
+DECLARE_TEST(heap, basic) {
+	unsigned int arity[] = {2, 4, 8, 16, 64};
+	size_t num_entries = 5000;
+	uint64_t* keys = memory_allocate(0, sizeof(uint64_t) * num_entries, 0, MEMORY_PERSISTENT);
+	size_t iarity, ientry;
+
+	for (iarity = 0; iarity < sizeof(arity) / sizeof(arity[0]); ++iarity) {
+		heap_t* heap = heap_allocate(arity[iarity], false);
+		heap_entry_t entry;
+
+		EXPECT_SIZEEQ(heap_size(heap), 0);
+		EXPECT_EQ(heap_top(heap), nullptr);
+		EXPECT_FALSE(heap_pop(heap, &entry));
+
+		for (ientry = 0; ientry < num_entries; ++ientry) {
+			//Small key range to get plenty of duplicate keys
+			keys[ientry] = random64_range(0, num_entries / 4);
+			EXPECT_TRUE(heap_push(heap, keys[ientry], (uint32_t)ientry));
+		}
+		EXPECT_SIZEEQ(heap_size(heap), num_entries);
+		EXPECT_TRUE(heap_verify(heap));
+
+		qsort(keys, num_entries, sizeof(uint64_t), heap_compare_entry);
+		for (ientry = 0; ientry < num_entries; ++ientry) {
+			EXPECT_EQ(heap_top(heap)->key, keys[ientry]);
+			EXPECT_TRUE(heap_pop(heap, &entry));
+			EXPECT_EQ(entry.key, keys[ientry]);
+		}
+		EXPECT_SIZEEQ(heap_size(heap), 0);
+		EXPECT_FALSE(heap_pop(heap, 0));
+
+		//Keep the largest keys in a heap of fixed size
+		for (ientry = 0; ientry < 100; ++ientry)
+			heap_push(heap, ientry, 0);
+		for (ientry = 100; ientry < num_entries; ++ientry) {
+			if (ientry > heap_top(heap)->key)
+				heap_replace_top(heap, ientry, 0);
+		}
+		EXPECT_SIZEEQ(heap_size(heap), 100);
+		EXPECT_EQ(heap_top(heap)->key, num_entries - 100);
+		EXPECT_TRUE(heap_verify(heap));
+		heap_clear(heap);
+		EXPECT_SIZEEQ(heap_size(heap), 0);
+
+		heap_deallocate(heap);
+	}
+
+	{
+		heap_t heap;
+		log_enable_stdout(false);
+		heap_initialize(&heap, 3, false);
+		log_enable_stdout(true);
+		EXPECT_EQ(error(), ERROR_INVALID_VALUE);
+		EXPECT_UINTEQ(1U << heap.shift, HEAP_DEFAULT_ARITY);
+		heap_finalize(&heap);
+	}
+
+	memory_deallocate(keys);
+
+	return 0;
+}
+
+DECLARE_TEST(heap, indexed) {
+	heap_t heap;
+	heap_entry_t entry;
+	uint32_t id;
+
+	heap_initialize(&heap, 0, true);
+	EXPECT_FALSE(heap_contains(&heap, 0));
+	EXPECT_FALSE(heap_update(&heap, 0, 1));
+	EXPECT_FALSE(heap_erase(&heap, 0));
+
+	for (id = 0; id < 1000; ++id)
+		EXPECT_TRUE(heap_push(&heap, 10000 + id, id));
+	EXPECT_FALSE(heap_push(&heap, 1, 500));
+	EXPECT_SIZEEQ(heap_size(&heap), 1000);
+	EXPECT_TRUE(heap_contains(&heap, 999));
+	EXPECT_FALSE(heap_contains(&heap, 1000));
+
+	//Decrease and increase keys
+	EXPECT_TRUE(heap_update(&heap, 500, 5));
+	EXPECT_EQ(heap_top(&heap)->id, 500);
+	EXPECT_TRUE(heap_update(&heap, 500, 20000));
+	EXPECT_EQ(heap_top(&heap)->id, 0);
+	EXPECT_TRUE(heap_verify(&heap));
+
+	for (id = 0; id < 1000; id += 2)
+		EXPECT_TRUE(heap_erase(&heap, id));
+	EXPECT_FALSE(heap_erase(&heap, 0));
+	EXPECT_SIZEEQ(heap_size(&heap), 500);
+	EXPECT_TRUE(heap_verify(&heap));
+
+	heap_replace_top(&heap, 30000, 1);
+	EXPECT_EQ(heap_top(&heap)->id, 3);
+	heap_replace_top(&heap, 1, 2000);
+	EXPECT_TRUE(heap_contains(&heap, 2000));
+	EXPECT_FALSE(heap_contains(&heap, 3));
+	EXPECT_TRUE(heap_verify(&heap));
+
+	for (id = 0; heap_pop(&heap, &entry); ++id) {
+		EXPECT_FALSE(heap_contains(&heap, entry.id));
+		if (id == 0)
+			EXPECT_EQ(entry.id, 2000);
+	}
+	EXPECT_UINTEQ(id, 500);
+
+	heap_finalize(&heap);
+
+	return 0;
+}
+
+DECLARE_TEST(heap, shortest_path) {
+	//Dijkstra with decrease-key on a random graph, checked against Bellman-Ford
+	size_t num_nodes = 2000;
+	size_t num_edges = 16000;
+	uint32_t* from = memory_allocate(0, sizeof(uint32_t) * num_edges, 0, MEMORY_PERSISTENT);
+	uint32_t* to = memory_allocate(0, sizeof(uint32_t) * num_edges, 0, MEMORY_PERSISTENT);
+	uint64_t* weight = memory_allocate(0, sizeof(uint64_t) * num_edges, 0, MEMORY_PERSISTENT);
+	uint64_t* dist = memory_allocate(0, sizeof(uint64_t) * num_nodes, 0, MEMORY_PERSISTENT);
+	uint64_t* reference = memory_allocate(0, sizeof(uint64_t) * num_nodes, 0, MEMORY_PERSISTENT);
+	size_t* first = memory_allocate(0, sizeof(size_t) * (num_nodes + 1), 0, MEMORY_ZERO_INITIALIZED);
+	size_t iedge, inode;
+	heap_entry_t entry;
+	heap_t* heap;
+	bool changed;
+
+	//Edges sorted by source node
+	for (iedge = 0; iedge < num_edges; ++iedge) {
+		from[iedge] = (uint32_t)((iedge * num_nodes) / num_edges);
+		to[iedge] = random32_range(0, (uint32_t)num_nodes);
+		weight[iedge] = random64_range(1, 1000);
+		++first[from[iedge] + 1];
+	}
+	for (inode = 0; inode < num_nodes; ++inode)
+		first[inode + 1] += first[inode];
+
+	for (inode = 0; inode < num_nodes; ++inode)
+		dist[inode] = reference[inode] = UINT64_MAX;
+
+	heap = heap_allocate(4, true);
+	dist[0] = 0;
+	heap_push(heap, 0, 0);
+	while (heap_pop(heap, &entry)) {
+		for (iedge = first[entry.id]; iedge < first[entry.id + 1]; ++iedge) {
+			uint64_t candidate = entry.key + weight[iedge];
+			if (candidate < dist[to[iedge]]) {
+				if (dist[to[iedge]] == UINT64_MAX)
+					EXPECT_TRUE(heap_push(heap, candidate, to[iedge]));
+				else
+					EXPECT_TRUE(heap_update(heap, to[iedge], candidate));
+				dist[to[iedge]] = candidate;
+			}
+		}
+	}
+	heap_deallocate(heap);
+
+	reference[0] = 0;
+	do {
+		changed = false;
+		for (iedge = 0; iedge < num_edges; ++iedge) {
+			if ((reference[from[iedge]] != UINT64_MAX) && (reference[from[iedge]] + weight[iedge] < reference[to[iedge]])) {
+				reference[to[iedge]] = reference[from[iedge]] + weight[iedge];
+				changed = true;
+			}
+		}
+	} while (changed);
+
+	for (inode = 0; inode < num_nodes; ++inode)
+		EXPECT_EQ(dist[inode], reference[inode]);
+
+	memory_deallocate(from);
+	memory_deallocate(to);
+	memory_deallocate(weight);
+	memory_deallocate(dist);
+	memory_deallocate(reference);
+	memory_deallocate(first);
+
+	return 0;
+}
+
+DECLARE_TEST(heap, load) {
+	size_t counts[] = {0, 1, 2, 3, 4, 5, 17, 1000, 4097};
+	size_t num_entries = 4097;
+	heap_entry_t* entries = memory_allocate(0, sizeof(heap_entry_t) * num_entries, 0, MEMORY_PERSISTENT);
+	unsigned int arity;
+	size_t icount, ientry;
+
+	for (arity = 2; arity <= 16; arity *= 2) {
+		for (icount = 0; icount < sizeof(counts) / sizeof(counts[0]); ++icount) {
+			size_t count = counts[icount];
+			heap_t heap;
+			heap_entry_t entry;
+			uint64_t last = 0;
+
+			heap_initialize(&heap, arity, true);
+			heap_push(&heap, 0, 0);
+			for (ientry = 0; ientry < count; ++ientry) {
+				entries[ientry].key = random64();
+				entries[ientry].id = (uint32_t)(count - ientry);
+			}
+			EXPECT_TRUE(heap_load(&heap, entries, count));
+			EXPECT_SIZEEQ(heap_size(&heap), count);
+			EXPECT_EQ(heap_contains(&heap, 0), false);
+			EXPECT_TRUE(heap_verify(&heap));
+			for (ientry = 0; ientry < count; ++ientry)
+				EXPECT_TRUE(heap_contains(&heap, (uint32_t)(ientry + 1)));
+			for (ientry = 0; heap_pop(&heap, &entry); ++ientry) {
+				EXPECT_GE(entry.key, last);
+				last = entry.key;
+			}
+			EXPECT_SIZEEQ(ientry, count);
+
+			heap_finalize(&heap);
+		}
+	}
+
+	//Duplicate identifiers are rejected by indexed heaps only
+	{
+		heap_t heap;
+		entries[0].key = 1;
+		entries[0].id = 7;
+		entries[1].key = 2;
+		entries[1].id = 8;
+		entries[2].key = 3;
+		entries[2].id = 7;
+
+		heap_initialize(&heap, 0, true);
+		log_enable_stdout(false);
+		EXPECT_FALSE(heap_load(&heap, entries, 3));
+		log_enable_stdout(true);
+		EXPECT_EQ(error(), ERROR_INVALID_VALUE);
+		EXPECT_SIZEEQ(heap_size(&heap), 0);
+		EXPECT_FALSE(heap_contains(&heap, 7));
+		EXPECT_FALSE(heap_contains(&heap, 8));
+		EXPECT_TRUE(heap_load(&heap, entries, 2));
+		EXPECT_TRUE(heap_contains(&heap, 8));
+		heap_finalize(&heap);
+
+		heap_initialize(&heap, 0, false);
+		EXPECT_TRUE(heap_load(&heap, entries, 3));
+		EXPECT_SIZEEQ(heap_size(&heap), 3);
+		heap_finalize(&heap);
+	}
+
+	memory_deallocate(entries);
+
+	return 0;
+}
+
+DECLARE_TEST(heap, performance) {
+	size_t num_entries = 1000000;
+	unsigned int arity[] = {2, 4, 8};
+	heap_entry_t* entries = memory_allocate(0, sizeof(heap_entry_t) * num_entries, 0, MEMORY_PERSISTENT);
+	heap_binary_t binary;
+	size_t ientry, iarity;
+	uint64_t checksum_binary = 0;
+	tick_t start, time_push, time_pop;
+
+	for (ientry = 0; ientry < num_entries; ++ientry) {
+		entries[ientry].key = random64();
+		entries[ientry].id = (uint32_t)ientry;
+	}
+
+	binary.entry = memory_allocate(0, sizeof(heap_entry_t) * num_entries, 0, MEMORY_PERSISTENT);
+	binary.size = 0;
+	binary.compare = heap_compare_entry;
+	start = time_current();
+	for (ientry = 0; ientry < num_entries; ++ientry)
+		heap_binary_push(&binary, entries[ientry]);
+	time_push = time_diff(start, time_current());
+	start = time_current();
+	for (ientry = 0; ientry < num_entries; ++ientry)
+		checksum_binary = (checksum_binary * 31) + heap_binary_pop(&binary).key;
+	time_pop = time_diff(start, time_current());
+	memory_deallocate(binary.entry);
+	log_infof(HASH_TEST, STRING_CONST("Binary heap with compare function, %" PRIsize " entries: push %.2f ms, pop %.2f ms"),
+	          num_entries, time_ticks_to_seconds(time_push) * 1000.0, time_ticks_to_seconds(time_pop) * 1000.0);
+
+	for (iarity = 0; iarity < sizeof(arity) / sizeof(arity[0]); ++iarity) {
+		heap_t heap;
+		heap_entry_t entry;
+		uint64_t checksum = 0;
+
+		heap_initialize(&heap, arity[iarity], false);
+		start = time_current();
+		for (ientry = 0; ientry < num_entries; ++ientry)
+			heap_push(&heap, entries[ientry].key, entries[ientry].id);
+		time_push = time_diff(start, time_current());
+		start = time_current();
+		while (heap_pop(&heap, &entry))
+			checksum = (checksum * 31) + entry.key;
+		time_pop = time_diff(start, time_current());
+		EXPECT_EQ(checksum, checksum_binary);
+		log_infof(HASH_TEST, STRING_CONST("%u-ary heap, %" PRIsize " entries: push %.2f ms, pop %.2f ms"),
+		          arity[iarity], num_entries, time_ticks_to_seconds(time_push) * 1000.0,
+		          time_ticks_to_seconds(time_pop) * 1000.0);
+
+		start = time_current();
+		heap_load(&heap, entries, num_entries);
+		time_push = time_diff(start, time_current());
+		EXPECT_TRUE(heap_verify(&heap));
+		log_infof(HASH_TEST, STRING_CONST("%u-ary heap, %" PRIsize " entries: heapify %.2f ms"),
+		          arity[iarity], num_entries, time_ticks_to_seconds(time_push) * 1000.0);
+
+		heap_finalize(&heap);
+	}
+
+	memory_deallocate(entries);
+
+	return 0;
+}
+
+static void
+test_heap_declare(void) {
+	ADD_TEST(heap, basic);
+	ADD_TEST(heap, indexed);
+	ADD_TEST(heap, shortest_path);
+	ADD_TEST(heap, load);
+	ADD_TEST(heap, performance);
+}
+
+static test_suite_t test_heap_suite = {
+	test_heap_application,
+	test_heap_memory_system,
+	test_heap_config,
+	test_heap_declare,
+	test_heap_initialize,
+	test_heap_finalize,
+	0
+};
+
+#if BUILD_MONOLITHIC
+
+int
+test_heap_run(void);
+
+int
+test_heap_run(void) {
+	test_suite = test_heap_suite;
+	return test_run_all();
+}
+
+#else
+
+test_suite_t
+test_suite_define(void);
+
+test_suite_t
+test_suite_define(void) {
+	return test_heap_suite;
+}
+
+#endif
@@ -103,9 +103,89 @@ DECLARE_TEST(library, lookup) {
 	return 0;
 }
 
+DECLARE_TEST(library, symbols) {
+	object_t lib = 0;
+	string_const_t libraryname;
+	string_const_t symbolnames[4];
+	void* symbols[4];
+	size_t isym, iloop, num_loops = 10000;
+	tick_t start, elapsed;
+
+	if (system_platform() == PLATFORM_PNACL)
+		return 0;
+
+#if FOUNDATION_PLATFORM_WINDOWS
+	libraryname = string_const(STRING_CONST("kernel32"));
+	symbolnames[0] = string_const(STRING_CONST("ExitProcess"));
+	symbolnames[1] = string_const(STRING_CONST("GetProcAddress"));
+	symbolnames[2] = string_const(STRING_CONST("LoadLibraryA"));
+#elif FOUNDATION_PLATFORM_LINUX
+	libraryname = string_const(STRING_CONST("libm.so.6"));
+	symbolnames[0] = string_const(STRING_CONST("sin"));
+	symbolnames[1] = string_const(STRING_CONST("cos"));
+	symbolnames[2] = string_const(STRING_CONST("exp"));
+#elif FOUNDATION_PLATFORM_POSIX && !FOUNDATION_PLATFORM_BSD
+	libraryname = string_const(STRING_CONST("dl"));
+	symbolnames[0] = string_const(STRING_CONST("dlsym"));
+	symbolnames[1] = string_const(STRING_CONST("dlopen"));
+	symbolnames[2] = string_const(STRING_CONST("dlclose"));
+#else
+	return 0;
+#endif
+	symbolnames[3] = string_const(STRING_CONST("this_symbol_should_not_exist"));
+
+	lib = library_load(STRING_ARGS(libraryname));
+	EXPECT_NE(lib, 0);
+
+	EXPECT_SIZEEQ(library_symbols(lib, symbolnames, symbols, 4), 3);
+	for (isym = 0; isym < 3; ++isym) {
+		EXPECT_NE(symbols[isym], 0);
+		EXPECT_EQ(library_symbol(lib, STRING_ARGS(symbolnames[isym])), symbols[isym]);
+	}
+	EXPECT_EQ(symbols[3], 0);
+	EXPECT_EQ(library_symbol(lib, STRING_ARGS(symbolnames[3])), 0);
+
+	//Cached lookups must return the same addresses
+	EXPECT_SIZEEQ(library_symbols(lib, symbolnames, symbols, 3), 3);
+	for (isym = 0; isym < 3; ++isym)
+		EXPECT_EQ(library_symbol(lib, STRING_ARGS(symbolnames[isym])), symbols[isym]);
+
+	start = time_current();
+	for (iloop = 0; iloop < num_loops; ++iloop) {
+		object_t otherlib = library_load(STRING_ARGS(libraryname));
+		EXPECT_EQ(otherlib, lib);
+		library_unload(otherlib);
+	}
+	elapsed = time_diff(start, time_current());
+	log_infof(HASH_TEST, STRING_CONST("Library load of loaded library: %.3f us"),
+	          time_ticks_to_seconds(elapsed) * 1000000.0 / (double)num_loops);
+
+	start = time_current();
+	for (iloop = 0; iloop < num_loops; ++iloop)
+		library_symbols(lib, symbolnames, symbols, 3);
+	elapsed = time_diff(start, time_current());
+	log_infof(HASH_TEST, STRING_CONST("Library symbol binding: %.3f us per symbol"),
+	          time_ticks_to_seconds(elapsed) * 1000000.0 / (double)(num_loops * 3));
+
+	library_unload(lib);
+	EXPECT_FALSE(library_valid(lib));
+	EXPECT_SIZEEQ(library_symbols(lib, symbolnames, symbols, 3), 0);
+	EXPECT_EQ(symbols[0], 0);
+
+	//Reload after unload must produce a new valid library through the index
+	lib = library_load(STRING_ARGS(libraryname));
+	EXPECT_NE(lib, 0);
+	EXPECT_TRUE(library_valid(lib));
+	EXPECT_NE(library_symbol(lib, STRING_ARGS(symbolnames[0])), 0);
+	library_unload(lib);
+
+	return 0;
+}
+
 static void
 test_library_declare(void) {
 	ADD_TEST(library, lookup);
+	ADD_TEST(library, symbols);
 }
 
 static test_suite_t test_library_suite = {
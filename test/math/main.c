@@ -512,6 +512,201 @@ DECLARE_TEST(math, wrap) {
 	return 0;
 }
 
+//Reference functions are called through pointers, fast math flags may otherwise expand
+//them inline to x87 instructions with poor accuracy for large arguments
+static long double (* volatile test_math_sinl)(long double) = sinl;
+static long double (* volatile test_math_cosl)(long double) = cosl;
+static long double (* volatile test_math_expl)(long double) = expl;
+static long double (* volatile test_math_logl)(long double) = logl;
+static long double (* volatile test_math_powl)(long double, long double) = powl;
+static long double (* volatile test_math_sqrtl)(long double) = sqrtl;
+
+static double
+test_math_ulp32(float32_t value, double reference) {
+	float32_t refval = (float32_t)reference;
+	float32_t next = nextafterf(refval, FLT_MAX);
+	double ulp = (double)next - (double)refval;
+	return math_abs(((double)value - reference) / ulp);
+}
+
+static double
+test_math_ulp64(float64_t value, long double reference) {
+	float64_t refval = (float64_t)reference;
+	float64_t next = nextafter(refval, DBL_MAX);
+	long double ulp = (long double)next - (long double)refval;
+	return (double)fabsl(((long double)value - reference) / ulp);
+}
+
+#define TEST_MATH_ARRAY_SIZE 4099
+
+DECLARE_TEST(math, array) {
+	float32_t* src32 = memory_allocate(0, sizeof(float32_t) * TEST_MATH_ARRAY_SIZE, 0, MEMORY_PERSISTENT);
+	float32_t* dst32 = memory_allocate(0, sizeof(float32_t) * TEST_MATH_ARRAY_SIZE, 0, MEMORY_PERSISTENT);
+	float64_t* src64 = memory_allocate(0, sizeof(float64_t) * TEST_MATH_ARRAY_SIZE, 0, MEMORY_PERSISTENT);
+	float64_t* dst64 = memory_allocate(0, sizeof(float64_t) * TEST_MATH_ARRAY_SIZE, 0, MEMORY_PERSISTENT);
+	double maxulp, maxabs;
+	size_t i;
+
+	//Sine and cosine, relative error in ulp away from zero crossings, absolute error close to them
+	for (i = 0; i < TEST_MATH_ARRAY_SIZE; ++i)
+		src32[i] = -8192.0f + (16384.0f * (float32_t)i) / (float32_t)(TEST_MATH_ARRAY_SIZE - 1);
+	math_sin_array32(dst32, src32, TEST_MATH_ARRAY_SIZE);
+	for (i = 0, maxulp = 0, maxabs = 0; i < TEST_MATH_ARRAY_SIZE; ++i) {
+		double ref = sin((double)src32[i]);
+		maxabs = math_max(maxabs, math_abs((double)dst32[i] - ref));
+		if (math_abs(ref) > 0.01) maxulp = math_max(maxulp, test_math_ulp32(dst32[i], ref));
+	}
+	EXPECT_LE(maxulp, 2.0);
+	EXPECT_LE(maxabs, 1.2e-7);
+	math_cos_array32(dst32, src32, TEST_MATH_ARRAY_SIZE);
+	for (i = 0, maxulp = 0, maxabs = 0; i < TEST_MATH_ARRAY_SIZE; ++i) {
+		double ref = cos((double)src32[i]);
+		maxabs = math_max(maxabs, math_abs((double)dst32[i] - ref));
+		if (math_abs(ref) > 0.01) maxulp = math_max(maxulp, test_math_ulp32(dst32[i], ref));
+	}
+	EXPECT_LE(maxulp, 2.0);
+	EXPECT_LE(maxabs, 1.2e-7);
+
+	for (i = 0; i < TEST_MATH_ARRAY_SIZE; ++i)
+		src32[i] = -87.0f + (175.0f * (float32_t)i) / (float32_t)(TEST_MATH_ARRAY_SIZE - 1);
+	math_exp_array32(dst32, src32, TEST_MATH_ARRAY_SIZE);
+	for (i = 0, maxulp = 0; i < TEST_MATH_ARRAY_SIZE; ++i)
+		maxulp = math_max(maxulp, test_math_ulp32(dst32[i], exp((double)src32[i])));
+	EXPECT_LE(maxulp, 2.0);
+
+	for (i = 0; i < TEST_MATH_ARRAY_SIZE; ++i)
+		src32[i] = math_exp((real)(-80.0 + (160.0 * (double)i) / (double)(TEST_MATH_ARRAY_SIZE - 1)));
+	math_logn_array32(dst32, src32, TEST_MATH_ARRAY_SIZE);
+	for (i = 0, maxulp = 0; i < TEST_MATH_ARRAY_SIZE; ++i) {
+		double ref = log((double)src32[i]);
+		if (math_abs(ref) > 0.01) maxulp = math_max(maxulp, test_math_ulp32(dst32[i], ref));
+	}
+	EXPECT_LE(maxulp, 1.0);
+
+	for (i = 0; i < TEST_MATH_ARRAY_SIZE; ++i)
+		src32[i] = 0.01f + (100.0f * (float32_t)i) / (float32_t)(TEST_MATH_ARRAY_SIZE - 1);
+	math_pow_array32(dst32, src32, 2.5f, TEST_MATH_ARRAY_SIZE);
+	for (i = 0, maxulp = 0; i < TEST_MATH_ARRAY_SIZE; ++i)
+		maxulp = math_max(maxulp, test_math_ulp32(dst32[i], pow((double)src32[i], 2.5)));
+	EXPECT_LE(maxulp, 32.0);
+	math_sqrt_array32(dst32, src32, TEST_MATH_ARRAY_SIZE);
+	for (i = 0, maxulp = 0; i < TEST_MATH_ARRAY_SIZE; ++i)
+		maxulp = math_max(maxulp, test_math_ulp32(dst32[i], sqrt((double)src32[i])));
+	EXPECT_LE(maxulp, 1.0);
+	math_rsqrt_array32(dst32, src32, TEST_MATH_ARRAY_SIZE);
+	for (i = 0, maxulp = 0; i < TEST_MATH_ARRAY_SIZE; ++i)
+		maxulp = math_max(maxulp, test_math_ulp32(dst32[i], 1.0 / sqrt((double)src32[i])));
+	EXPECT_LE(maxulp, 3.0);
+
+	for (i = 0; i < TEST_MATH_ARRAY_SIZE; ++i)
+		src64[i] = -1e7 + (2e7 * (float64_t)i) / (float64_t)(TEST_MATH_ARRAY_SIZE - 1);
+	math_sin_array64(dst64, src64, TEST_MATH_ARRAY_SIZE);
+	for (i = 0, maxulp = 0, maxabs = 0; i < TEST_MATH_ARRAY_SIZE; ++i) {
+		long double ref = test_math_sinl((long double)src64[i]);
+		maxabs = math_max(maxabs, (double)fabsl((long double)dst64[i] - ref));
+		if (fabsl(ref) > 0.01) maxulp = math_max(maxulp, test_math_ulp64(dst64[i], ref));
+	}
+	EXPECT_LE(maxulp, 2.0);
+	EXPECT_LE(maxabs, 2.2e-16);
+	math_cos_array64(dst64, src64, TEST_MATH_ARRAY_SIZE);
+	for (i = 0, maxulp = 0, maxabs = 0; i < TEST_MATH_ARRAY_SIZE; ++i) {
+		long double ref = test_math_cosl((long double)src64[i]);
+		maxabs = math_max(maxabs, (double)fabsl((long double)dst64[i] - ref));
+		if (fabsl(ref) > 0.01) maxulp = math_max(maxulp, test_math_ulp64(dst64[i], ref));
+	}
+	EXPECT_LE(maxulp, 2.0);
+	EXPECT_LE(maxabs, 2.2e-16);
+
+	for (i = 0; i < TEST_MATH_ARRAY_SIZE; ++i)
+		src64[i] = -708.0 + (1416.0 * (float64_t)i) / (float64_t)(TEST_MATH_ARRAY_SIZE - 1);
+	math_exp_array64(dst64, src64, TEST_MATH_ARRAY_SIZE);
+	for (i = 0, maxulp = 0; i < TEST_MATH_ARRAY_SIZE; ++i)
+		maxulp = math_max(maxulp, test_math_ulp64(dst64[i], test_math_expl((long double)src64[i])));
+	EXPECT_LE(maxulp, 1.0);
+
+	for (i = 0; i < TEST_MATH_ARRAY_SIZE; ++i)
+		src64[i] = exp(-700.0 + (1400.0 * (double)i) / (double)(TEST_MATH_ARRAY_SIZE - 1));
+	math_logn_array64(dst64, src64, TEST_MATH_ARRAY_SIZE);
+	for (i = 0, maxulp = 0; i < TEST_MATH_ARRAY_SIZE; ++i) {
+		long double ref = test_math_logl((long double)src64[i]);
+		if (fabsl(ref) > 0.01) maxulp = math_max(maxulp, test_math_ulp64(dst64[i], ref));
+	}
+	EXPECT_LE(maxulp, 1.0);
+
+	for (i = 0; i < TEST_MATH_ARRAY_SIZE; ++i)
+		src64[i] = 0.01 + (100.0 * (float64_t)i) / (float64_t)(TEST_MATH_ARRAY_SIZE - 1);
+	math_pow_array64(dst64, src64, 2.5, TEST_MATH_ARRAY_SIZE);
+	for (i = 0, maxulp = 0; i < TEST_MATH_ARRAY_SIZE; ++i)
+		maxulp = math_max(maxulp, test_math_ulp64(dst64[i], test_math_powl((long double)src64[i], 2.5L)));
+	EXPECT_LE(maxulp, 32.0);
+	math_sqrt_array64(dst64, src64, TEST_MATH_ARRAY_SIZE);
+	for (i = 0, maxulp = 0; i < TEST_MATH_ARRAY_SIZE; ++i)
+		maxulp = math_max(maxulp, test_math_ulp64(dst64[i], test_math_sqrtl((long double)src64[i])));
+	EXPECT_LE(maxulp, 1.0);
+	math_rsqrt_array64(dst64, src64, TEST_MATH_ARRAY_SIZE);
+	for (i = 0, maxulp = 0; i < TEST_MATH_ARRAY_SIZE; ++i)
+		maxulp = math_max(maxulp, test_math_ulp64(dst64[i], 1.0L / test_math_sqrtl((long double)src64[i])));
+	EXPECT_LE(maxulp, 2.0);
+
+	memory_deallocate(src32);
+	memory_deallocate(dst32);
+	memory_deallocate(src64);
+	memory_deallocate(dst64);
+
+	return 0;
+}
+
+#define TEST_MATH_PERFORMANCE_SIZE (1024 * 1024)
+
+DECLARE_TEST(math, array_performance) {
+	float32_t* src32 = memory_allocate(0, sizeof(float32_t) * TEST_MATH_PERFORMANCE_SIZE, 16, MEMORY_PERSISTENT);
+	float32_t* dst32 = memory_allocate(0, sizeof(float32_t) * TEST_MATH_PERFORMANCE_SIZE, 16, MEMORY_PERSISTENT);
+	float64_t* src64 = memory_allocate(0, sizeof(float64_t) * TEST_MATH_PERFORMANCE_SIZE, 16, MEMORY_PERSISTENT);
+	float64_t* dst64 = memory_allocate(0, sizeof(float64_t) * TEST_MATH_PERFORMANCE_SIZE, 16, MEMORY_PERSISTENT);
+	tick_t scalar32, scalar64, array32, array64;
+	tick_t start;
+	size_t i;
+
+	for (i = 0; i < TEST_MATH_PERFORMANCE_SIZE; ++i) {
+		src32[i] = 0.5f + (float32_t)(i & 0xFFFF) * 0.001f;
+		src64[i] = (float64_t)src32[i];
+	}
+
+	start = time_current();
+	for (i = 0; i < TEST_MATH_PERFORMANCE_SIZE; ++i)
+		dst32[i] = sinf(src32[i]) + expf(src32[i]) + logf(src32[i]);
+	scalar32 = time_diff(start, time_current());
+
+	start = time_current();
+	math_sin_array32(dst32, src32, TEST_MATH_PERFORMANCE_SIZE);
+	math_exp_array32(dst32, src32, TEST_MATH_PERFORMANCE_SIZE);
+	math_logn_array32(dst32, src32, TEST_MATH_PERFORMANCE_SIZE);
+	array32 = time_diff(start, time_current());
+
+	start = time_current();
+	for (i = 0; i < TEST_MATH_PERFORMANCE_SIZE; ++i)
+		dst64[i] = sin(src64[i]) + exp(src64[i]) + log(src64[i]);
+	scalar64 = time_diff(start, time_current());
+
+	start = time_current();
+	math_sin_array64(dst64, src64, TEST_MATH_PERFORMANCE_SIZE);
+	math_exp_array64(dst64, src64, TEST_MATH_PERFORMANCE_SIZE);
+	math_logn_array64(dst64, src64, TEST_MATH_PERFORMANCE_SIZE);
+	array64 = time_diff(start, time_current());
+
+	log_infof(HASH_TEST, STRING_CONST("sin+exp+log over %d elements: 32-bit scalar %.3fms array %.3fms, 64-bit scalar %.3fms array %.3fms"),
+	          TEST_MATH_PERFORMANCE_SIZE,
+	          time_ticks_to_seconds(scalar32) * 1000.0, time_ticks_to_seconds(array32) * 1000.0,
+	          time_ticks_to_seconds(scalar64) * 1000.0, time_ticks_to_seconds(array64) * 1000.0);
+
+	memory_deallocate(src32);
+	memory_deallocate(dst32);
+	memory_deallocate(src64);
+	memory_deallocate(dst64);
+
+	return 0;
+}
+
 static void
 test_math_declare(void) {
 	ADD_TEST(math, constants);
@@ -521,6 +716,8 @@ test_math_declare(void) {
 	ADD_TEST(math, utility);
 	ADD_TEST(math, exponentials);
 	ADD_TEST(math, wrap);
+	ADD_TEST(math, array);
+	ADD_TEST(math, array_performance);
 }
 
 static test_suite_t test_math_suite = {
@@ -0,0 +1,439 @@
+/* main.c  -  Foundation msgpack test  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+#include <test/test.h>
+
+static application_t
+test_msgpack_application(void) {
+	application_t app;
+	memset(&app, 0, sizeof(app));
+	app.name = string_const(STRING_CONST("Foundation msgpack tests"));
+	app.short_name = string_const(STRING_CONST("test_msgpack"));
+	app.company = string_const(STRING_CONST("Rampant Pixels"));
+	app.flags = APPLICATION_UTILITY;
+	app.exception_handler = test_exception_handler;
+	return app;
+}
+
+static memory_system_t
+test_msgpack_memory_system(void) {
+	return memory_system_malloc();
+}
+
+static foundation_config_t
+test_msgpack_config(void) {
+	foundation_config_t config;
+	memset(&config, 0, sizeof(config));
+	return config;
+}
+
+static int
+test_msgpack_initialize(void) {
+	return 0;
+}
+
+static void
+test_msgpack_finalize(void) {
+}
+
+DECLARE_TEST(msgpack, types) {
+	static char buffer[256 * 1024];
+	static char text[128 * 1024];
+	json_token_t tokens[64];
+	size_t capacity = sizeof(tokens) / sizeof(tokens[0]);
+	stream_t* stream;
+	size_t size, ival, length;
+	int64_t ints[] = {0, 1, 127, 128, 255, 256, 65535, 65536, 0xFFFFFFFFLL, 0x100000000LL, INT64_MAX,
+	                  -1, -32, -33, -128, -129, -32768, -32769, INT32_MIN, (int64_t)INT32_MIN - 1, INT64_MIN};
+	size_t sizes[] = {1, 1, 1, 2, 2, 3, 3, 5, 5, 9, 9, 1, 1, 2, 2, 3, 3, 5, 5, 9, 9};
+	size_t lengths[] = {0, 31, 32, 255, 256, 65535, 65536};
+
+	stream = buffer_stream_allocate(buffer, STREAM_IN | STREAM_OUT | STREAM_BINARY, 0,
+	                                sizeof(buffer), false, false);
+
+	//Integers use smallest encoding and decode to same value
+	for (ival = 0; ival < sizeof(ints) / sizeof(ints[0]); ++ival) {
+		stream_seek(stream, 0, STREAM_SEEK_BEGIN);
+		msgpack_write_int(stream, ints[ival]);
+		size = (size_t)stream_tell(stream);
+		EXPECT_SIZEEQ(size, sizes[ival]);
+		EXPECT_SIZEEQ(msgpack_parse(buffer, size, tokens, capacity), 1);
+		EXPECT_INTEQ(tokens[0].type, JSON_PRIMITIVE);
+		EXPECT_UINTEQ(tokens[0].value, 0);
+		EXPECT_UINTEQ(tokens[0].value_length, size);
+		EXPECT_TRUE(msgpack_token_int(buffer, tokens) == ints[ival]);
+		EXPECT_REALEQ((real)msgpack_token_float(buffer, tokens), (real)ints[ival]);
+	}
+	stream_seek(stream, 0, STREAM_SEEK_BEGIN);
+	msgpack_write_uint(stream, UINT64_MAX);
+	EXPECT_SIZEEQ(msgpack_parse(buffer, (size_t)stream_tell(stream), tokens, capacity), 1);
+	EXPECT_TRUE(msgpack_token_uint(buffer, tokens) == UINT64_MAX);
+
+	//Floating point, booleans and nil
+	stream_seek(stream, 0, STREAM_SEEK_BEGIN);
+	msgpack_write_array(stream, 5);
+	msgpack_write_float32(stream, 1.5f);
+	msgpack_write_float64(stream, -1.2345e45);
+	msgpack_write_bool(stream, true);
+	msgpack_write_bool(stream, false);
+	msgpack_write_nil(stream);
+	size = (size_t)stream_tell(stream);
+	EXPECT_SIZEEQ(size, 1 + 5 + 9 + 1 + 1 + 1);
+	EXPECT_SIZEEQ(msgpack_parse(buffer, size, tokens, capacity), 6);
+	EXPECT_INTEQ(tokens[0].type, JSON_ARRAY);
+	EXPECT_UINTEQ(tokens[0].child, 1);
+	EXPECT_TRUE(msgpack_token_float(buffer, tokens + 1) == 1.5);
+	EXPECT_INTEQ(msgpack_token_int(buffer, tokens + 1), 1);
+	EXPECT_TRUE(msgpack_token_float(buffer, tokens + 2) == -1.2345e45);
+	EXPECT_TRUE(msgpack_token_bool(buffer, tokens + 3));
+	EXPECT_FALSE(msgpack_token_bool(buffer, tokens + 4));
+	EXPECT_FALSE(msgpack_token_is_nil(buffer, tokens + 4));
+	EXPECT_TRUE(msgpack_token_is_nil(buffer, tokens + 5));
+	EXPECT_UINTEQ(tokens[1].sibling, 2);
+	EXPECT_UINTEQ(tokens[4].sibling, 5);
+	EXPECT_UINTEQ(tokens[5].sibling, 0);
+
+	//Strings and binary data point into buffer
+	for (ival = 0; ival < sizeof(text); ++ival)
+		text[ival] = (char)('a' + (ival % 26));
+	for (ival = 0; ival < sizeof(lengths) / sizeof(lengths[0]); ++ival) {
+		length = lengths[ival];
+		stream_seek(stream, 0, STREAM_SEEK_BEGIN);
+		msgpack_write_array(stream, 2);
+		msgpack_write_string(stream, text, length);
+		msgpack_write_binary(stream, text, length);
+		size = (size_t)stream_tell(stream);
+		EXPECT_SIZEEQ(msgpack_parse(buffer, size, tokens, capacity), 3);
+		EXPECT_INTEQ(tokens[1].type, JSON_STRING);
+		EXPECT_INTEQ(tokens[2].type, JSON_STRING);
+		EXPECT_CONSTSTRINGEQ(msgpack_token_string(buffer, tokens + 1), string_const(text, length));
+		EXPECT_CONSTSTRINGEQ(msgpack_token_string(buffer, tokens + 2), string_const(text, length));
+		EXPECT_UINTEQ(tokens[2].value + tokens[2].value_length, size);
+	}
+
+	//Large containers
+	stream_seek(stream, 0, STREAM_SEEK_BEGIN);
+	msgpack_write_array(stream, 70000);
+	for (ival = 0; ival < 70000; ++ival)
+		msgpack_write_nil(stream);
+	size = (size_t)stream_tell(stream);
+	EXPECT_SIZEEQ(size, 5 + 70000);
+	EXPECT_SIZEEQ(msgpack_parse(buffer, size, tokens, capacity), 70001);
+	EXPECT_INTEQ(tokens[0].type, JSON_ARRAY);
+
+	stream_seek(stream, 0, STREAM_SEEK_BEGIN);
+	msgpack_write_map(stream, 20);
+	for (ival = 0; ival < 20; ++ival) {
+		msgpack_write_string(stream, text + ival, 1);
+		msgpack_write_uint(stream, ival * 1000);
+	}
+	size = (size_t)stream_tell(stream);
+	EXPECT_SIZEEQ(msgpack_parse(buffer, size, tokens, capacity), 21);
+	EXPECT_INTEQ(tokens[0].type, JSON_OBJECT);
+	for (ival = 0; ival < 20; ++ival) {
+		EXPECT_CONSTSTRINGEQ(msgpack_token_identifier(buffer, tokens + ival + 1), string_const(text + ival, 1));
+		EXPECT_CONSTSTRINGEQ(json_token_identifier(buffer, tokens + ival + 1), string_const(text + ival, 1));
+		EXPECT_TRUE(msgpack_token_uint(buffer, tokens + ival + 1) == ival * 1000);
+		EXPECT_UINTEQ(tokens[ival + 1].sibling, (ival < 19) ? ival + 2 : 0);
+	}
+
+	stream_deallocate(stream);
+
+	return 0;
+}
+
+static void
+test_msgpack_write_compound(stream_t* stream) {
+	msgpack_write_map(stream, 2);
+	msgpack_write_string(stream, STRING_CONST("foo"));
+	msgpack_write_map(stream, 2);
+	msgpack_write_string(stream, STRING_CONST("subobj"));
+	msgpack_write_bool(stream, false);
+	msgpack_write_string(stream, STRING_CONST("val"));
+	msgpack_write_float64(stream, 1.2345e45);
+	msgpack_write_string(stream, STRING_CONST("arr"));
+	msgpack_write_array(stream, 7);
+	msgpack_write_string(stream, STRING_CONST("string"));
+	msgpack_write_float64(stream, 0.34523e-78);
+	msgpack_write_array(stream, 4);
+	msgpack_write_bool(stream, true);
+	msgpack_write_string(stream, STRING_CONST("subarr [] {} =:"));
+	msgpack_write_map(stream, 1);
+	msgpack_write_string(stream, STRING_CONST("key"));
+	msgpack_write_array(stream, 0);
+	msgpack_write_array(stream, 0);
+	msgpack_write_array(stream, 1);
+	msgpack_write_bool(stream, false);
+	msgpack_write_map(stream, 1);
+	msgpack_write_string(stream, STRING_CONST("final"));
+	msgpack_write_bool(stream, true);
+	msgpack_write_map(stream, 0);
+	msgpack_write_float64(stream, 1234.43E+123);
+}
+
+DECLARE_TEST(msgpack, tree) {
+	char buffer[1024];
+	json_token_t tokens[32];
+	json_token_t reference[32];
+	size_t capacity = sizeof(tokens) / sizeof(tokens[0]);
+	stream_t* stream;
+	size_t size, itok;
+
+	string_const_t compound = string_const(STRING_CONST("\
+	{\"foo\" :{\"subobj\": false ,\
+		\"val\" :1.2345e45 \
+	} ,\"arr\" :[ \
+		\"string\",\
+		0.34523e-78,[\
+			true, \
+			\"subarr [] {} =:\", { \"key\": []}, [] \
+		],[false],\
+		{ \t\
+			\"final\" : true \
+		}\
+		,{ }  \
+		, 1234.43E+123 \
+	]\
+	}"));
+
+	stream = buffer_stream_allocate(buffer, STREAM_IN | STREAM_OUT | STREAM_BINARY, 0,
+	                                sizeof(buffer), false, false);
+	test_msgpack_write_compound(stream);
+	size = (size_t)stream_tell(stream);
+	stream_deallocate(stream);
+
+	EXPECT_SIZEEQ(json_parse(STRING_ARGS(compound), reference, capacity), 19);
+	EXPECT_SIZEEQ(msgpack_parse(buffer, size, nullptr, 0), 19);
+	EXPECT_SIZEEQ(msgpack_parse(buffer, size, tokens, 7), 19);
+	EXPECT_SIZEEQ(msgpack_parse(buffer, size, tokens, capacity), 19);
+
+	//Same token tree as the JSON parser
+	for (itok = 0; itok < 19; ++itok) {
+		EXPECT_INTEQ(tokens[itok].type, reference[itok].type);
+		EXPECT_CONSTSTRINGEQ(json_token_identifier(buffer, tokens + itok),
+		                     json_token_identifier(compound.str, reference + itok));
+		EXPECT_UINTEQ(tokens[itok].sibling, reference[itok].sibling);
+		if (tokens[itok].type == JSON_STRING)
+			EXPECT_CONSTSTRINGEQ(json_token_value(buffer, tokens + itok),
+			                     json_token_value(compound.str, reference + itok));
+		if (tokens[itok].child)
+			EXPECT_UINTEQ(tokens[itok].child, reference[itok].child);
+	}
+	EXPECT_UINTEQ(tokens[12].child, 0);
+	EXPECT_UINTEQ(tokens[17].child, 0);
+	EXPECT_TRUE(msgpack_token_float(buffer, tokens + 3) == 1.2345e45);
+	EXPECT_TRUE(msgpack_token_float(buffer, tokens + 18) == 1234.43E+123);
+	EXPECT_TRUE(msgpack_token_bool(buffer, tokens + 16));
+
+	return 0;
+}
+
+DECLARE_TEST(msgpack, invalid) {
+	char buffer[1024];
+	char nested[1024];
+	json_token_t tokens[32];
+	size_t capacity = sizeof(tokens) / sizeof(tokens[0]);
+	stream_t* stream;
+	size_t size, cut;
+
+	stream = buffer_stream_allocate(buffer, STREAM_IN | STREAM_OUT | STREAM_BINARY, 0,
+	                                sizeof(buffer), false, false);
+	test_msgpack_write_compound(stream);
+	size = (size_t)stream_tell(stream);
+
+	//Any truncation is detected
+	EXPECT_SIZEEQ(msgpack_parse(0, 0, tokens, capacity), 0);
+	EXPECT_INTEQ(tokens[0].type, JSON_UNDEFINED);
+	for (cut = 0; cut < size; ++cut)
+		EXPECT_SIZEEQ(msgpack_parse(buffer, cut, tokens, capacity), 0);
+	EXPECT_SIZEEQ(msgpack_parse(buffer, size, tokens, capacity), 19);
+
+	//Map keys must be strings
+	stream_seek(stream, 0, STREAM_SEEK_BEGIN);
+	msgpack_write_map(stream, 1);
+	msgpack_write_int(stream, 1);
+	msgpack_write_int(stream, 2);
+	EXPECT_SIZEEQ(msgpack_parse(buffer, (size_t)stream_tell(stream), tokens, capacity), 0);
+	stream_seek(stream, 0, STREAM_SEEK_BEGIN);
+	msgpack_write_map(stream, 1);
+	msgpack_write_binary(stream, STRING_CONST("key"));
+	msgpack_write_int(stream, 2);
+	EXPECT_SIZEEQ(msgpack_parse(buffer, (size_t)stream_tell(stream), tokens, capacity), 0);
+
+	//Unused tag and extension types
+	buffer[0] = (char)0xC1;
+	EXPECT_SIZEEQ(msgpack_parse(buffer, 1, tokens, capacity), 0);
+	buffer[0] = (char)0xD4;
+	buffer[1] = 1;
+	buffer[2] = 2;
+	EXPECT_SIZEEQ(msgpack_parse(buffer, 3, tokens, capacity), 0);
+
+	//Length claims beyond buffer
+	stream_seek(stream, 0, STREAM_SEEK_BEGIN);
+	msgpack_write_array(stream, 0xFFFFFFFF);
+	msgpack_write_nil(stream);
+	EXPECT_SIZEEQ(msgpack_parse(buffer, (size_t)stream_tell(stream), tokens, capacity), 0);
+	buffer[0] = (char)0xDB;
+	buffer[1] = buffer[2] = buffer[3] = buffer[4] = (char)0xFF;
+	EXPECT_SIZEEQ(msgpack_parse(buffer, 16, tokens, capacity), 0);
+
+	stream_deallocate(stream);
+
+	//Nesting depth is bounded
+	memset(nested, 0x91, sizeof(nested));
+	nested[sizeof(nested) - 1] = (char)0xC0;
+	EXPECT_SIZEEQ(msgpack_parse(nested, sizeof(nested), nullptr, 0), 0);
+	EXPECT_SIZEEQ(msgpack_parse(nested + sizeof(nested) - 100, 100, nullptr, 0), 100);
+
+	return 0;
+}
+
+static void
+test_msgpack_write_document(stream_t* stream, size_t count, bool binary) {
+	size_t iobj;
+	if (binary)
+		msgpack_write_array(stream, count);
+	else
+		stream_write(stream, "[", 1);
+	for (iobj = 0; iobj < count; ++iobj) {
+		float32_t x = (float32_t)iobj * 0.25f;
+		if (binary) {
+			msgpack_write_map(stream, 5);
+			msgpack_write_string(stream, STRING_CONST("id"));
+			msgpack_write_uint(stream, iobj * 7919);
+			msgpack_write_string(stream, STRING_CONST("name"));
+			msgpack_write_string(stream, STRING_CONST("entity name string"));
+			msgpack_write_string(stream, STRING_CONST("position"));
+			msgpack_write_array(stream, 3);
+			msgpack_write_float32(stream, x);
+			msgpack_write_float32(stream, x + 1.0f);
+			msgpack_write_float32(stream, x * 2.0f);
+			msgpack_write_string(stream, STRING_CONST("active"));
+			msgpack_write_bool(stream, (iobj % 3) != 0);
+			msgpack_write_string(stream, STRING_CONST("parent"));
+			msgpack_write_int(stream, (int64_t)iobj / 2);
+		}
+		else {
+			stream_write_format(stream, STRING_CONST("%s{\"id\":%" PRIsize ",\"name\":\"entity name string\","
+			                    "\"position\":[%.9g,%.9g,%.9g],\"active\":%s,\"parent\":%d}"),
+			                    iobj ? "," : "", iobj * 7919, (double)x, (double)(x + 1.0f), (double)(x * 2.0f),
+			                    ((iobj % 3) != 0) ? "true" : "false", (int)iobj / 2);
+		}
+	}
+	if (!binary)
+		stream_write(stream, "]", 1);
+}
+
+DECLARE_TEST(msgpack, performance) {
+	size_t capacity = 8 * 1024 * 1024;
+	size_t count = 10000;
+	size_t tokencount = 1 + count * 9;
+	char* msgbuffer = memory_allocate(0, capacity, 0, MEMORY_PERSISTENT);
+	char* jsonbuffer = memory_allocate(0, capacity, 0, MEMORY_PERSISTENT);
+	json_token_t* tokens = memory_allocate(0, sizeof(json_token_t) * tokencount, 0, MEMORY_PERSISTENT);
+	stream_t* msgstream;
+	stream_t* jsonstream;
+	size_t msgsize, jsonsize, iloop, loops = 20;
+	tick_t msgencode = 0, jsonencode = 0, msgdecode = 0, jsondecode = 0;
+	tick_t start;
+	uint64_t checksum = 0;
+
+	msgstream = buffer_stream_allocate(msgbuffer, STREAM_IN | STREAM_OUT | STREAM_BINARY, 0, capacity, false, false);
+	jsonstream = buffer_stream_allocate(jsonbuffer, STREAM_IN | STREAM_OUT, 0, capacity, false, false);
+
+	for (iloop = 0; iloop < loops; ++iloop) {
+		stream_seek(msgstream, 0, STREAM_SEEK_BEGIN);
+		start = time_current();
+		test_msgpack_write_document(msgstream, count, true);
+		msgencode += time_diff(start, time_current());
+
+		stream_seek(jsonstream, 0, STREAM_SEEK_BEGIN);
+		start = time_current();
+		test_msgpack_write_document(jsonstream, count, false);
+		jsonencode += time_diff(start, time_current());
+	}
+	msgsize = (size_t)stream_tell(msgstream);
+	jsonsize = (size_t)stream_tell(jsonstream);
+
+	for (iloop = 0; iloop < loops; ++iloop) {
+		start = time_current();
+		EXPECT_SIZEEQ(msgpack_parse(msgbuffer, msgsize, tokens, tokencount), tokencount);
+		msgdecode += time_diff(start, time_current());
+		checksum += msgpack_token_uint(msgbuffer, tokens + 2 + 9 * (iloop % count));
+
+		start = time_current();
+		EXPECT_SIZEEQ(json_parse(jsonbuffer, jsonsize, tokens, tokencount), tokencount);
+		jsondecode += time_diff(start, time_current());
+		checksum += (uint64_t)string_to_uint64(STRING_ARGS(json_token_value(jsonbuffer, tokens + 2 + 9 * (iloop % count))), false);
+	}
+	EXPECT_TRUE(checksum == 2 * 7919 * ((loops * (loops - 1)) / 2));
+
+#define MSGPACK_MBPS(bytes, ticks) ((double)((bytes) * loops) / (1024.0 * 1024.0 * (double)time_ticks_to_seconds((ticks) ? (ticks) : 1)))
+	log_infof(HASH_TEST, STRING_CONST("MessagePack %" PRIsize " bytes, encode %.1f MB/s, decode %.1f MB/s"),
+	          msgsize, MSGPACK_MBPS(msgsize, msgencode), MSGPACK_MBPS(msgsize, msgdecode));
+	log_infof(HASH_TEST, STRING_CONST("JSON        %" PRIsize " bytes, encode %.1f MB/s, decode %.1f MB/s"),
+	          jsonsize, MSGPACK_MBPS(jsonsize, jsonencode), MSGPACK_MBPS(jsonsize, jsondecode));
+	log_infof(HASH_TEST, STRING_CONST("MessagePack encode %.2fx, decode %.2fx faster per document"),
+	          (double)jsonencode / (double)(msgencode ? msgencode : 1),
+	          (double)jsondecode / (double)(msgdecode ? msgdecode : 1));
+#undef MSGPACK_MBPS
+
+	stream_deallocate(msgstream);
+	stream_deallocate(jsonstream);
+	memory_deallocate(tokens);
+	memory_deallocate(jsonbuffer);
+	memory_deallocate(msgbuffer);
+
+	return 0;
+}
+
+static void
+test_msgpack_declare(void) {
+	ADD_TEST(msgpack, types);
+	ADD_TEST(msgpack, tree);
+	ADD_TEST(msgpack, invalid);
+	ADD_TEST(msgpack, performance);
+}
+
+static test_suite_t test_msgpack_suite = {
+	test_msgpack_application,
+	test_msgpack_memory_system,
+	test_msgpack_config,
+	test_msgpack_declare,
+	test_msgpack_initialize,
+	test_msgpack_finalize,
+	0
+};
+
+#if BUILD_MONOLITHIC
+
+int
+test_msgpack_run(void);
+
+int
+test_msgpack_run(void) {
+	test_suite = test_msgpack_suite;
+	return test_run_all();
+}
+
+#else
+
+test_suite_t
+test_suite_define(void);
+
+test_suite_t
+test_suite_define(void) {
+	return test_msgpack_suite;
+}
+
+#endif
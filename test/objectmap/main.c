@@ -262,11 +262,272 @@ DECLARE_TEST(objectmap, thread) {
 	return 0;
 }
 
+static int
+objectmap_count_object(void* object, void* data) {
+	size_t* count = data;
+	FOUNDATION_UNUSED(object);
+	++(*count);
+	return 0;
+}
+
+static int
+objectmap_stop_object(void* object, void* data) {
+	FOUNDATION_UNUSED(data);
+	return atomic_load32(&((object_base_t*)object)->ref) - 1;
+}
+
+DECLARE_TEST(objectmap, iterate) {
+	objectmap_t* map;
+	object_base_t* objects;
+	object_base_t* object;
+	size_t size = 64 * 1024;
+	size_t num_objects = 0;
+	size_t iobj, index, count, iloop;
+	tick_t start, elapsed_scan, elapsed_iterate;
+	thread_t thread[32];
+	size_t ith;
+	size_t num_threads = math_clamp(system_hardware_threads() * 2, 2, 32);
+
+	map = objectmap_allocate(size);
+	objects = memory_allocate(0, sizeof(object_base_t) * size, 16,
+	                          MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+
+	index = 0;
+	EXPECT_EQ(objectmap_iterate(map, &index), 0);
+	EXPECT_SIZEEQ(index, size);
+
+	//Fill the whole map, then free all but a sparse set of slots
+	for (iobj = 0; iobj < size; ++iobj) {
+		atomic_store32(&objects[iobj].ref, 1);
+		objects[iobj].id = objectmap_reserve(map);
+		EXPECT_TRUE(objectmap_set(map, objects[iobj].id, objects + iobj));
+	}
+	for (iobj = 0; iobj < size; ++iobj) {
+		if ((iobj % 67) && (iobj != 63) && (iobj != 64) && (iobj != size - 1))
+			EXPECT_TRUE(objectmap_free(map, objects[iobj].id));
+		else
+			++num_objects;
+	}
+
+	count = 0;
+	index = 0;
+	while ((object = objectmap_iterate(map, &index))) {
+		EXPECT_EQ(objectmap_lookup(map, object->id), object);
+		EXPECT_SIZEEQ(index, (object->id & map->mask_index) + 1);
+		++count;
+	}
+	EXPECT_SIZEEQ(count, num_objects);
+
+	count = 0;
+	EXPECT_INTEQ(objectmap_foreach(map, objectmap_count_object, &count), 0);
+	EXPECT_SIZEEQ(count, num_objects);
+
+	atomic_store32(&objects[67 * 3].ref, 2);
+	EXPECT_INTEQ(objectmap_foreach(map, objectmap_stop_object, 0), 1);
+	atomic_store32(&objects[67 * 3].ref, 1);
+
+	//Sparse map iteration compared to scanning every slot
+	start = time_current();
+	for (iloop = 0, count = 0; iloop < 100; ++iloop) {
+		for (iobj = 0; iobj < size; ++iobj) {
+			if (objectmap_raw_lookup(map, iobj))
+				++count;
+		}
+	}
+	elapsed_scan = time_diff(start, time_current());
+	EXPECT_SIZEEQ(count, num_objects * 100);
+
+	start = time_current();
+	for (iloop = 0, count = 0; iloop < 100; ++iloop) {
+		index = 0;
+		while (objectmap_iterate(map, &index))
+			++count;
+	}
+	elapsed_iterate = time_diff(start, time_current());
+	EXPECT_SIZEEQ(count, num_objects * 100);
+
+	log_infof(HASH_TEST, STRING_CONST("Objectmap %" PRIsize " of %" PRIsize " slots live: slot scan %.3f us, iterate %.3f us"),
+	          num_objects, size, time_ticks_to_seconds(elapsed_scan) * 10000.0,
+	          time_ticks_to_seconds(elapsed_iterate) * 10000.0);
+
+	for (iobj = 0; iobj < size; ++iobj) {
+		if (objectmap_lookup(map, objects[iobj].id) == objects + iobj)
+			EXPECT_TRUE(objectmap_free(map, objects[iobj].id));
+	}
+	index = 0;
+	EXPECT_EQ(objectmap_iterate(map, &index), 0);
+
+	//Iterate while other threads reserve, set and free
+	for (ith = 0; ith < num_threads; ++ith)
+		thread_initialize(&thread[ith], objectmap_thread, map, STRING_CONST("objectmap_thread"),
+		                  THREAD_PRIORITY_NORMAL, 0);
+	for (ith = 0; ith < num_threads; ++ith)
+		thread_start(&thread[ith]);
+
+	test_wait_for_threads_startup(thread, num_threads);
+
+	do {
+		index = 0;
+		while ((object = objectmap_iterate(map, &index)))
+			EXPECT_SIZEEQ(index, (object->id & map->mask_index) + 1);
+		thread_yield();
+	}
+	while (thread_is_running(&thread[0]) || thread_is_running(&thread[num_threads - 1]));
+
+	test_wait_for_threads_finish(thread, num_threads);
+
+	for (ith = 0; ith < num_threads; ++ith)
+		thread_finalize(&thread[ith]);
+
+	index = 0;
+	EXPECT_EQ(objectmap_iterate(map, &index), 0);
+
+	memory_deallocate(objects);
+	objectmap_deallocate(map);
+
+	return 0;
+}
+
+typedef struct {
+	FOUNDATION_DECLARE_OBJECT;
+	void* buffer;
+} test_deferred_object_t;
+
+#define DEFERRED_BUFFER_SIZE (64 * 1024)
+
+static objectmap_t* _deferred_map;
+static atomic32_t _deferred_destroyed;
+
+static void
+objectmap_deferred_destroy(object_t id, void* object) {
+	test_deferred_object_t* obj = object;
+	//Simulate teardown work
+	memset(obj->buffer, 0xFF, DEFERRED_BUFFER_SIZE);
+	memory_deallocate(obj->buffer);
+	objectmap_free(_deferred_map, id);
+	memory_deallocate(obj);
+	atomic_incr32(&_deferred_destroyed);
+}
+
+static object_t
+objectmap_deferred_create(void) {
+	test_deferred_object_t* obj = memory_allocate(0, sizeof(test_deferred_object_t), 0,
+	                                              MEMORY_PERSISTENT);
+	object_t id = objectmap_reserve(_deferred_map);
+	obj->id = id;
+	atomic_store32(&obj->ref, 1);
+	obj->buffer = memory_allocate(0, DEFERRED_BUFFER_SIZE, 0, MEMORY_PERSISTENT);
+	objectmap_set(_deferred_map, id, obj);
+	return id;
+}
+
+static tick_t
+objectmap_deferred_percentile(tick_t* ticks, size_t count, size_t percentile) {
+	size_t i, j;
+	for (i = 1; i < count; ++i) {
+		tick_t val = ticks[i];
+		for (j = i; (j > 0) && (ticks[j - 1] > val); --j)
+			ticks[j] = ticks[j - 1];
+		ticks[j] = val;
+	}
+	return ticks[((count - 1) * percentile) / 100];
+}
+
+static void*
+objectmap_deferred_thread(void* arg) {
+	object_t ids[256];
+	size_t iobj;
+	FOUNDATION_UNUSED(arg);
+	for (iobj = 0; iobj < 256; ++iobj)
+		ids[iobj] = objectmap_deferred_create();
+	for (iobj = 0; iobj < 256; ++iobj) {
+		EXPECT_NE(objectmap_lookup_ref(_deferred_map, ids[iobj]), 0);
+		EXPECT_TRUE(objectmap_lookup_unref_deferred(_deferred_map, ids[iobj], objectmap_deferred_destroy));
+		EXPECT_FALSE(objectmap_lookup_unref_deferred(_deferred_map, ids[iobj], objectmap_deferred_destroy));
+		EXPECT_EQ(objectmap_lookup_ref(_deferred_map, ids[iobj]), 0);
+	}
+	//Remaining partial batch is handed over on thread exit
+	return 0;
+}
+
+DECLARE_TEST(objectmap, deferred) {
+	object_t ids[1024];
+	tick_t ticks[1024];
+	size_t num_objects = 1024;
+	size_t iobj;
+	tick_t p99_immediate, p99_deferred, start;
+	thread_t thread[16];
+	size_t ith;
+	size_t num_threads = math_clamp(system_hardware_threads() * 2, 2, 16);
+
+	_deferred_map = objectmap_allocate(num_threads * 256 + num_objects);
+	atomic_store32(&_deferred_destroyed, 0);
+
+	EXPECT_SIZEEQ(objectmap_deferred_collect(), 0);
+
+	for (iobj = 0; iobj < num_objects; ++iobj)
+		ids[iobj] = objectmap_deferred_create();
+	for (iobj = 0; iobj < num_objects; ++iobj) {
+		start = time_current();
+		objectmap_lookup_unref(_deferred_map, ids[iobj], objectmap_deferred_destroy);
+		ticks[iobj] = time_diff(start, time_current());
+	}
+	EXPECT_INTEQ(atomic_load32(&_deferred_destroyed), (int32_t)num_objects);
+	p99_immediate = objectmap_deferred_percentile(ticks, num_objects, 99);
+
+	atomic_store32(&_deferred_destroyed, 0);
+	for (iobj = 0; iobj < num_objects; ++iobj)
+		ids[iobj] = objectmap_deferred_create();
+	for (iobj = 0; iobj < num_objects; ++iobj) {
+		start = time_current();
+		objectmap_lookup_unref_deferred(_deferred_map, ids[iobj], objectmap_deferred_destroy);
+		ticks[iobj] = time_diff(start, time_current());
+	}
+	EXPECT_INTEQ(atomic_load32(&_deferred_destroyed), 0);
+	for (iobj = 0; iobj < num_objects; ++iobj)
+		EXPECT_EQ(objectmap_lookup_ref(_deferred_map, ids[iobj]), 0);
+	p99_deferred = objectmap_deferred_percentile(ticks, num_objects, 99);
+
+	EXPECT_SIZEEQ(objectmap_deferred_collect(), num_objects);
+	EXPECT_INTEQ(atomic_load32(&_deferred_destroyed), (int32_t)num_objects);
+	EXPECT_SIZEEQ(objectmap_deferred_collect(), 0);
+
+	log_infof(HASH_TEST, STRING_CONST("Objectmap release p99 latency: immediate %.3f us, deferred %.3f us"),
+	          time_ticks_to_seconds(p99_immediate) * 1000000.0,
+	          time_ticks_to_seconds(p99_deferred) * 1000000.0);
+
+	//Release in other threads and collect in this thread
+	atomic_store32(&_deferred_destroyed, 0);
+	for (ith = 0; ith < num_threads; ++ith)
+		thread_initialize(&thread[ith], objectmap_deferred_thread, 0,
+		                  STRING_CONST("objectmap_deferred"), THREAD_PRIORITY_NORMAL, 0);
+	for (ith = 0; ith < num_threads; ++ith)
+		thread_start(&thread[ith]);
+
+	test_wait_for_threads_startup(thread, num_threads);
+	while (thread_is_running(&thread[0]))
+		objectmap_deferred_collect();
+	test_wait_for_threads_finish(thread, num_threads);
+
+	for (ith = 0; ith < num_threads; ++ith)
+		thread_finalize(&thread[ith]);
+
+	objectmap_deferred_collect();
+	EXPECT_INTEQ(atomic_load32(&_deferred_destroyed), (int32_t)(num_threads * 256));
+
+	objectmap_deallocate(_deferred_map);
+	_deferred_map = 0;
+
+	return 0;
+}
+
 static void
 test_objectmap_declare(void) {
 	ADD_TEST(objectmap, initialize);
 	ADD_TEST(objectmap, store);
 	ADD_TEST(objectmap, thread);
+	ADD_TEST(objectmap, iterate);
+	ADD_TEST(objectmap, deferred);
 }
 
 static test_suite_t test_objectmap_suite = {
@@ -0,0 +1,355 @@
+/* main.c  -  Foundation sketch test  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+#include <test/test.h>
+
+static application_t
+test_sketch_application(void) {
+	application_t app;
+	memset(&app, 0, sizeof(app));
+	app.name = string_const(STRING_CONST("Foundation sketch tests"));
+	app.short_name = string_const(STRING_CONST("test_sketch"));
+	app.company = string_const(STRING_CONST("Rampant Pixels"));
+	app.flags = APPLICATION_UTILITY;
+	app.exception_handler = test_exception_handler;
+	return app;
+}
+
+static memory_system_t
+test_sketch_memory_system(void) {
+	return memory_system_malloc();
+}
+
+static foundation_config_t
+test_sketch_config(void) {
+	foundation_config_t config;
+	memset(&config, 0, sizeof(config));
+	return config;
+}
+
+static int
+test_sketch_initialize(void) {
+	return 0;
+}
+
+static void
+test_sketch_finalize(void) {
+}
+
+static hash_t
+sketch_key(uint64_t value) {
+	return hash(&value, sizeof(value));
+}
+
+static bool
+sketch_within(uint64_t estimate, uint64_t expect, real tolerance) {
+	real error = ((real)estimate - (real)expect) / (real)expect;
+	return math_abs(error) <= tolerance;
+}
+
+typedef struct {
+	hyperloglog_t  hyperloglog;
+	countmin_t     countmin;
+	uint64_t       key_offset;
+	uint64_t       key_num;
+} sketch_arg_t;
+
+static void*
+sketch_thread(void* arg) {
+	sketch_arg_t* parg = arg;
+	uint64_t ikey;
+
+	for (ikey = 0; ikey < parg->key_num; ++ikey) {
+		hyperloglog_add_hash(&parg->hyperloglog, sketch_key(parg->key_offset + ikey));
+		countmin_add_hash(&parg->countmin, sketch_key((parg->key_offset + ikey) % 1000), 1);
+	}
+
+	return 0;
+}
+
+DECLARE_TEST(sketch, hyperloglog) {
+	hyperloglog_t* sketch = hyperloglog_allocate(14);
+	uint64_t ikey, count, checkpoint = 10;
+
+	EXPECT_EQ(hyperloglog_estimate(sketch), 0);
+	EXPECT_FALSE(hyperloglog_is_dense(sketch));
+
+	hyperloglog_add(sketch, STRING_CONST("key"));
+	hyperloglog_add(sketch, STRING_CONST("key"));
+	EXPECT_EQ(hyperloglog_estimate(sketch), 1);
+	hyperloglog_clear(sketch);
+
+	//Standard error at precision 14 is 0.8%
+	for (count = 0, ikey = 0; count < 1000000; ++ikey) {
+		hyperloglog_add_hash(sketch, sketch_key(ikey));
+		//Duplicates do not change the estimate
+		if (ikey & 1)
+			hyperloglog_add_hash(sketch, sketch_key(ikey - 1));
+		++count;
+		if (count == checkpoint) {
+			uint64_t estimate = hyperloglog_estimate(sketch);
+			EXPECT_TRUE(sketch_within(estimate, count, REAL_C(0.03)));
+			if (count == 1000)
+				EXPECT_FALSE(hyperloglog_is_dense(sketch));
+			checkpoint *= 10;
+		}
+	}
+	EXPECT_TRUE(hyperloglog_is_dense(sketch));
+
+	hyperloglog_clear(sketch);
+	EXPECT_FALSE(hyperloglog_is_dense(sketch));
+	EXPECT_EQ(hyperloglog_estimate(sketch), 0);
+	hyperloglog_deallocate(sketch);
+
+	//Low precision sketches are dense from the start
+	sketch = hyperloglog_allocate(6);
+	EXPECT_TRUE(hyperloglog_is_dense(sketch));
+	for (ikey = 0; ikey < 10000; ++ikey)
+		hyperloglog_add_hash(sketch, sketch_key(ikey));
+	EXPECT_TRUE(sketch_within(hyperloglog_estimate(sketch), 10000, REAL_C(0.5)));
+	hyperloglog_deallocate(sketch);
+
+	return 0;
+}
+
+DECLARE_TEST(sketch, countmin) {
+	countmin_t* sketch = countmin_allocate(2048, 4);
+	countmin_t* other = countmin_allocate(2048, 4);
+	countmin_t* mismatch = countmin_allocate(1024, 4);
+	uint64_t ikey, overestimated = 0;
+
+	EXPECT_EQ(countmin_estimate(sketch, STRING_CONST("key")), 0);
+	countmin_add(sketch, STRING_CONST("key"), 3);
+	countmin_add(sketch, STRING_CONST("key"), 2);
+	EXPECT_EQ(countmin_estimate(sketch, STRING_CONST("key")), 5);
+	EXPECT_EQ(countmin_total(sketch), 5);
+	countmin_clear(sketch);
+
+	//Key n has count n
+	for (ikey = 1; ikey <= 1000; ++ikey)
+		countmin_add_hash(sketch, sketch_key(ikey), ikey);
+	EXPECT_EQ(countmin_total(sketch), 500500);
+	for (ikey = 1; ikey <= 1000; ++ikey) {
+		uint64_t estimate = countmin_estimate_hash(sketch, sketch_key(ikey));
+		EXPECT_TRUE(estimate >= ikey);
+		//Error bound e/width of total count holds with high probability
+		if (estimate > ikey + (500500 * 272) / (2048 * 100))
+			++overestimated;
+	}
+	EXPECT_TRUE(overestimated < 20);
+
+	for (ikey = 1; ikey <= 1000; ++ikey)
+		countmin_add_hash(other, sketch_key(ikey), 1);
+	EXPECT_TRUE(countmin_merge(sketch, other));
+	EXPECT_FALSE(countmin_merge(sketch, mismatch));
+	EXPECT_EQ(countmin_total(sketch), 501500);
+	for (ikey = 1; ikey <= 1000; ++ikey)
+		EXPECT_TRUE(countmin_estimate_hash(sketch, sketch_key(ikey)) >= ikey + 1);
+
+	countmin_deallocate(mismatch);
+	countmin_deallocate(other);
+	countmin_deallocate(sketch);
+
+	return 0;
+}
+
+DECLARE_TEST(sketch, merge) {
+	thread_t thread[32];
+	sketch_arg_t args[32];
+	hyperloglog_t hyperloglog, sparse;
+	countmin_t countmin;
+	size_t i, num_threads;
+	uint64_t ikey;
+
+	num_threads = math_clamp(system_hardware_threads() * 2U, 4U, 32U);
+	for (i = 0; i < num_threads; ++i) {
+		//Overlapping key ranges, thread n covers [n * 50000, n * 50000 + 100000)
+		hyperloglog_initialize(&args[i].hyperloglog, 14);
+		countmin_initialize(&args[i].countmin, 4096, 4);
+		args[i].key_offset = i * 50000;
+		args[i].key_num = 100000;
+		thread_initialize(&thread[i], sketch_thread, args + i, STRING_CONST("sketch_thread"),
+		                  THREAD_PRIORITY_NORMAL, 0);
+	}
+	for (i = 0; i < num_threads; ++i)
+		thread_start(&thread[i]);
+
+	test_wait_for_threads_startup(thread, num_threads);
+	test_wait_for_threads_finish(thread, num_threads);
+
+	hyperloglog_initialize(&hyperloglog, 14);
+	countmin_initialize(&countmin, 4096, 4);
+	for (i = 0; i < num_threads; ++i) {
+		thread_finalize(&thread[i]);
+		EXPECT_TRUE(hyperloglog_merge(&hyperloglog, &args[i].hyperloglog));
+		EXPECT_TRUE(countmin_merge(&countmin, &args[i].countmin));
+		hyperloglog_finalize(&args[i].hyperloglog);
+		countmin_finalize(&args[i].countmin);
+	}
+
+	EXPECT_TRUE(sketch_within(hyperloglog_estimate(&hyperloglog), (num_threads + 1) * 50000, REAL_C(0.03)));
+	EXPECT_EQ(countmin_total(&countmin), num_threads * 100000);
+	for (ikey = 0; ikey < 1000; ++ikey)
+		EXPECT_TRUE(countmin_estimate_hash(&countmin, sketch_key(ikey)) >= num_threads * 100);
+
+	//Merging sparse into sparse and dense, mismatched precision is rejected
+	hyperloglog_initialize(&sparse, 14);
+	for (ikey = 0; ikey < 100; ++ikey)
+		hyperloglog_add_hash(&sparse, sketch_key(ikey + 10000000));
+	EXPECT_TRUE(hyperloglog_merge(&hyperloglog, &sparse));
+	EXPECT_TRUE(sketch_within(hyperloglog_estimate(&hyperloglog), (num_threads + 1) * 50000 + 100, REAL_C(0.03)));
+	hyperloglog_finalize(&hyperloglog);
+	hyperloglog_initialize(&hyperloglog, 14);
+	EXPECT_TRUE(hyperloglog_merge(&hyperloglog, &sparse));
+	EXPECT_FALSE(hyperloglog_is_dense(&hyperloglog));
+	EXPECT_EQ(hyperloglog_estimate(&hyperloglog), hyperloglog_estimate(&sparse));
+	hyperloglog_finalize(&hyperloglog);
+	hyperloglog_initialize(&hyperloglog, 12);
+	EXPECT_FALSE(hyperloglog_merge(&hyperloglog, &sparse));
+
+	hyperloglog_finalize(&sparse);
+	hyperloglog_finalize(&hyperloglog);
+	countmin_finalize(&countmin);
+
+	return 0;
+}
+
+DECLARE_TEST(sketch, stream) {
+	hyperloglog_t sparse, dense, read;
+	countmin_t countmin, countmin_copy;
+	stream_t* stream;
+	unsigned int imode;
+	uint64_t ikey;
+	uint8_t register_value;
+	uint32_t sparse_entry;
+
+	hyperloglog_initialize(&sparse, 12);
+	hyperloglog_initialize(&dense, 12);
+	countmin_initialize(&countmin, 256, 3);
+	for (ikey = 0; ikey < 100; ++ikey)
+		hyperloglog_add_hash(&sparse, sketch_key(ikey));
+	for (ikey = 0; ikey < 100000; ++ikey) {
+		hyperloglog_add_hash(&dense, sketch_key(ikey));
+		countmin_add_hash(&countmin, sketch_key(ikey % 500), 1);
+	}
+	EXPECT_FALSE(hyperloglog_is_dense(&sparse));
+	EXPECT_TRUE(hyperloglog_is_dense(&dense));
+
+	//Text, native binary and byte swapped binary
+	for (imode = 0; imode < 3; ++imode) {
+		stream = buffer_stream_allocate(0, STREAM_IN | STREAM_OUT | (imode ? STREAM_BINARY : 0),
+		                                0, 0, true, true);
+		if (imode == 2)
+			stream_set_byteorder(stream, (system_byteorder() == BYTEORDER_LITTLEENDIAN) ?
+			                     BYTEORDER_BIGENDIAN : BYTEORDER_LITTLEENDIAN);
+		hyperloglog_write(&sparse, stream);
+		hyperloglog_write(&dense, stream);
+		countmin_write(&countmin, stream);
+		stream_seek(stream, 0, STREAM_SEEK_BEGIN);
+
+		EXPECT_TRUE(hyperloglog_read(&read, stream));
+		EXPECT_FALSE(hyperloglog_is_dense(&read));
+		EXPECT_EQ(hyperloglog_estimate(&read), hyperloglog_estimate(&sparse));
+		hyperloglog_finalize(&read);
+
+		EXPECT_TRUE(hyperloglog_read(&read, stream));
+		EXPECT_TRUE(hyperloglog_is_dense(&read));
+		EXPECT_EQ(memcmp(read.dense, dense.dense, 4096), 0);
+		EXPECT_EQ(hyperloglog_estimate(&read), hyperloglog_estimate(&dense));
+		hyperloglog_finalize(&read);
+
+		EXPECT_TRUE(countmin_read(&countmin_copy, stream));
+		EXPECT_EQ(countmin_total(&countmin_copy), 100000);
+		EXPECT_EQ(memcmp(countmin_copy.counter, countmin.counter, 256 * 3 * sizeof(uint64_t)), 0);
+		countmin_finalize(&countmin_copy);
+
+		//Invalid and truncated data
+		log_enable_stdout(false);
+		stream_seek(stream, 0, STREAM_SEEK_BEGIN);
+		EXPECT_FALSE(countmin_read(&countmin_copy, stream));
+		stream_seek(stream, 0, STREAM_SEEK_BEGIN);
+		hyperloglog_write(&dense, stream);
+		stream_truncate(stream, 256);
+		stream_seek(stream, 0, STREAM_SEEK_BEGIN);
+		EXPECT_FALSE(hyperloglog_read(&read, stream));
+
+		//Corrupted registers with ranks above the maximum for the precision
+		stream_truncate(stream, 0);
+		register_value = dense.dense[100];
+		sparse_entry = sparse.sparse[10];
+		dense.dense[100] = 70;
+		hyperloglog_write(&dense, stream);
+		dense.dense[100] = 64 - 12 + 1;
+		hyperloglog_write(&dense, stream);
+		sparse.sparse[10] = (sparse.sparse[10] & ~0xFFU) | 54;
+		hyperloglog_write(&sparse, stream);
+		dense.dense[100] = register_value;
+		sparse.sparse[10] = sparse_entry;
+		stream_seek(stream, 0, STREAM_SEEK_BEGIN);
+		EXPECT_FALSE(hyperloglog_read(&read, stream));
+		EXPECT_TRUE(hyperloglog_read(&read, stream));
+		EXPECT_UINTGT(hyperloglog_estimate(&read), 0);
+		hyperloglog_finalize(&read);
+		EXPECT_FALSE(hyperloglog_read(&read, stream));
+		log_enable_stdout(true);
+
+		stream_deallocate(stream);
+	}
+
+	hyperloglog_finalize(&sparse);
+	hyperloglog_finalize(&dense);
+	countmin_finalize(&countmin);
+
+	return 0;
+}
+
+static void
+test_sketch_declare(void) {
+	ADD_TEST(sketch, hyperloglog);
+	ADD_TEST(sketch, countmin);
+	ADD_TEST(sketch, merge);
+	ADD_TEST(sketch, stream);
+}
+
+static test_suite_t test_sketch_suite = {
+	test_sketch_application,
+	test_sketch_memory_system,
+	test_sketch_config,
+	test_sketch_declare,
+	test_sketch_initialize,
+	test_sketch_finalize,
+	0
+};
+
+#if BUILD_MONOLITHIC
+
+int
+test_sketch_run(void);
+
+int
+test_sketch_run(void) {
+	test_suite = test_sketch_suite;
+	return test_run_all();
+}
+
+#else
+
+test_suite_t
+test_suite_define(void);
+
+test_suite_t
+test_suite_define(void) {
+	return test_sketch_suite;
+}
+
+#endif
@@ -0,0 +1,433 @@
+/* main.c  -  Foundation skiplist test  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+#include <test/test.h>
+
+#include <stdlib.h>
+
+static application_t
+test_skiplist_application(void) {
+	application_t app;
+	memset(&app, 0, sizeof(app));
+	app.name = string_const(STRING_CONST("Foundation skiplist tests"));
+	app.short_name = string_const(STRING_CONST("test_skiplist"));
+	app.company = string_const(STRING_CONST("Rampant Pixels"));
+	app.flags = APPLICATION_UTILITY;
+	app.exception_handler = test_exception_handler;
+	return app;
+}
+
+static memory_system_t
+test_skiplist_memory_system(void) {
+	return memory_system_malloc();
+}
+
+static foundation_config_t
+test_skiplist_config(void) {
+	foundation_config_t config;
+	memset(&config, 0, sizeof(config));
+	return config;
+}
+
+static int
+test_skiplist_initialize(void) {
+	return 0;
+}
+
+static void
+test_skiplist_finalize(void) {
+}
+
+typedef struct {
+	skiplist_t* list;
+	btree_t* tree;
+	mutex_t* mutex;
+	uint64_t key_offset;
+	size_t num_keys;
+	size_t num_ops;
+	unsigned int read_percent;
+	size_t failed;
+	size_t found;
+} skiplist_arg_t;
+
+//Keys shared by all threads in the threaded test, value always equals key
+#define SKIPLIST_SHARED_KEY  1000000000ULL
+#define SKIPLIST_SHARED_KEYS 64
+
+static int
+skiplist_compare_key(const void* first, const void* second) {
+	uint64_t lhs = *(const uint64_t*)first;
+	uint64_t rhs = *(const uint64_t*)second;
+	return (lhs < rhs) ? -1 : ((lhs > rhs) ? 1 : 0);
+}
+
+static void*
+skiplist_thread(void* arg) {
+	skiplist_arg_t* parg = arg;
+	uint64_t ikey, value;
+	size_t iop;
+
+	for (ikey = 0; ikey < parg->num_keys; ++ikey) {
+		if (!skiplist_insert(parg->list, parg->key_offset + ikey, (parg->key_offset + ikey) * 2))
+			++parg->failed;
+	}
+	for (iop = 0; iop < parg->num_ops; ++iop) {
+		uint64_t key = SKIPLIST_SHARED_KEY + random32_range(0, SKIPLIST_SHARED_KEYS);
+		unsigned int op = random32_range(0, 3);
+		if (op == 0)
+			skiplist_insert(parg->list, key, key);
+		else if (op == 1)
+			skiplist_erase(parg->list, key);
+		else if (skiplist_lookup(parg->list, key, &value) && (value != key))
+			++parg->failed;
+	}
+	for (ikey = 0; ikey < parg->num_keys; ++ikey) {
+		if (!skiplist_lookup(parg->list, parg->key_offset + ikey, &value) || (value != (parg->key_offset + ikey) * 2))
+			++parg->failed;
+		if ((ikey & 1) == 0) {
+			if (!skiplist_erase(parg->list, parg->key_offset + ikey))
+				++parg->failed;
+		}
+	}
+	for (ikey = 0; ikey < parg->num_keys; ++ikey) {
+		if (skiplist_lookup(parg->list, parg->key_offset + ikey, 0) != ((ikey & 1) != 0))
+			++parg->failed;
+	}
+
+	return 0;
+}
+
+static void*
+skiplist_mixed_thread(void* arg) {
+	skiplist_arg_t* parg = arg;
+	size_t iop, found = 0;
+	uint64_t value;
+
+	for (iop = 0; iop < parg->num_ops; ++iop) {
+		uint64_t key = random32_range(0, (uint32_t)parg->num_keys);
+		if (random32_range(0, 100) < parg->read_percent) {
+			if (skiplist_lookup(parg->list, key, &value))
+				++found;
+		} else if (iop & 1) {
+			skiplist_insert(parg->list, key, key);
+		} else {
+			skiplist_erase(parg->list, key);
+		}
+	}
+	parg->found = found;
+
+	return 0;
+}
+
+static void*
+skiplist_locked_thread(void* arg) {
+	skiplist_arg_t* parg = arg;
+	size_t iop, found = 0;
+
+	for (iop = 0; iop < parg->num_ops; ++iop) {
+		uint64_t key = random32_range(0, (uint32_t)parg->num_keys);
+		bool read = random32_range(0, 100) < parg->read_percent;
+		mutex_lock(parg->mutex);
+		if (read) {
+			if (btree_has_key(parg->tree, key))
+				++found;
+		} else if (iop & 1) {
+			btree_insert(parg->tree, key, (void*)(uintptr_t)(key + 1));
+		} else {
+			btree_erase(parg->tree, key);
+		}
+		mutex_unlock(parg->mutex);
+	}
+	parg->found = found;
+
+	return 0;
+}
+
+DECLARE_TEST(skiplist, basic) {
+	skiplist_t* list = skiplist_allocate();
+	uint64_t value = 0;
+	uint64_t ikey;
+
+	EXPECT_SIZEEQ(skiplist_size(list), 0);
+	EXPECT_FALSE(skiplist_lookup(list, 0, &value));
+	EXPECT_FALSE(skiplist_erase(list, 0));
+
+	EXPECT_TRUE(skiplist_insert(list, 0, 1));
+	EXPECT_TRUE(skiplist_insert(list, UINT64_MAX, 2));
+	EXPECT_TRUE(skiplist_insert(list, 42, 3));
+	EXPECT_FALSE(skiplist_insert(list, 42, 4));
+	EXPECT_SIZEEQ(skiplist_size(list), 3);
+	EXPECT_TRUE(skiplist_lookup(list, 0, &value));
+	EXPECT_EQ(value, 1);
+	EXPECT_TRUE(skiplist_lookup(list, UINT64_MAX, &value));
+	EXPECT_EQ(value, 2);
+	EXPECT_TRUE(skiplist_lookup(list, 42, &value));
+	EXPECT_EQ(value, 4);
+	EXPECT_TRUE(skiplist_lookup(list, 42, 0));
+	EXPECT_FALSE(skiplist_lookup(list, 41, &value));
+
+	EXPECT_TRUE(skiplist_erase(list, 42));
+	EXPECT_FALSE(skiplist_erase(list, 42));
+	EXPECT_FALSE(skiplist_lookup(list, 42, &value));
+	EXPECT_SIZEEQ(skiplist_size(list), 2);
+	EXPECT_TRUE(skiplist_insert(list, 42, 5));
+	EXPECT_TRUE(skiplist_lookup(list, 42, &value));
+	EXPECT_EQ(value, 5);
+
+	for (ikey = 1000; ikey < 11000; ++ikey)
+		EXPECT_TRUE(skiplist_insert(list, ikey * 3, ikey));
+	EXPECT_SIZEEQ(skiplist_size(list), 10003);
+	for (ikey = 1000; ikey < 11000; ++ikey) {
+		EXPECT_TRUE(skiplist_lookup(list, ikey * 3, &value));
+		EXPECT_EQ(value, ikey);
+		EXPECT_FALSE(skiplist_lookup(list, (ikey * 3) + 1, 0));
+	}
+	for (ikey = 1000; ikey < 11000; ikey += 2)
+		EXPECT_TRUE(skiplist_erase(list, ikey * 3));
+	EXPECT_SIZEEQ(skiplist_size(list), 5003);
+	for (ikey = 1000; ikey < 11000; ++ikey)
+		EXPECT_EQ(skiplist_lookup(list, ikey * 3, 0), (ikey & 1) != 0);
+
+	skiplist_reclaim(list);
+	EXPECT_EQ(atomic_load32(&list->num_retired), 0);
+
+	skiplist_deallocate(list);
+
+	return 0;
+}
+
+DECLARE_TEST(skiplist, range) {
+	skiplist_t list;
+	size_t num_keys = 20000;
+	uint64_t* keys = memory_allocate(0, sizeof(uint64_t) * num_keys, 0, MEMORY_PERSISTENT);
+	uint64_t* found = memory_allocate(0, sizeof(uint64_t) * num_keys, 0, MEMORY_PERSISTENT);
+	uint64_t* values = memory_allocate(0, sizeof(uint64_t) * num_keys, 0, MEMORY_PERSISTENT);
+	size_t ikey, count, first;
+
+	skiplist_initialize(&list);
+	for (ikey = 0; ikey < num_keys; ++ikey) {
+		do {
+			keys[ikey] = random64();
+		} while (!skiplist_insert(&list, keys[ikey], keys[ikey] ^ 0xFF));
+	}
+	qsort(keys, num_keys, sizeof(uint64_t), skiplist_compare_key);
+
+	count = skiplist_range(&list, 0, UINT64_MAX, found, values, num_keys);
+	EXPECT_SIZEEQ(count, num_keys);
+	for (ikey = 0; ikey < count; ++ikey) {
+		EXPECT_EQ(found[ikey], keys[ikey]);
+		EXPECT_EQ(values[ikey], keys[ikey] ^ 0xFF);
+	}
+
+	//Bounds are inclusive and capacity limits the result
+	first = num_keys / 4;
+	count = skiplist_range(&list, keys[first], keys[first + 100], found, 0, num_keys);
+	EXPECT_SIZEEQ(count, 101);
+	EXPECT_EQ(found[0], keys[first]);
+	EXPECT_EQ(found[100], keys[first + 100]);
+	count = skiplist_range(&list, keys[first] + 1, keys[first + 100] - 1, found, 0, num_keys);
+	EXPECT_SIZEEQ(count, 99);
+	count = skiplist_range(&list, keys[first], UINT64_MAX, 0, values, 10);
+	EXPECT_SIZEEQ(count, 10);
+	EXPECT_EQ(values[9], keys[first + 9] ^ 0xFF);
+	EXPECT_SIZEEQ(skiplist_range(&list, keys[first + 1], keys[first], found, 0, num_keys), 0);
+
+	//Erased keys are skipped
+	for (ikey = first; ikey <= first + 100; ikey += 2)
+		EXPECT_TRUE(skiplist_erase(&list, keys[ikey]));
+	count = skiplist_range(&list, keys[first], keys[first + 100], found, 0, num_keys);
+	EXPECT_SIZEEQ(count, 50);
+	for (ikey = 0; ikey < count; ++ikey)
+		EXPECT_EQ(found[ikey], keys[first + 1 + (ikey * 2)]);
+
+	skiplist_finalize(&list);
+	memory_deallocate(keys);
+	memory_deallocate(found);
+	memory_deallocate(values);
+
+	return 0;
+}
+
+DECLARE_TEST(skiplist, threaded) {
+	thread_t thread[32];
+	skiplist_arg_t args[32];
+	skiplist_t* list = skiplist_allocate();
+	size_t num_keys = 10000;
+	size_t i, count, num_threads, num_shared;
+	uint64_t* found;
+	uint64_t* values;
+
+	num_threads = math_clamp(system_hardware_threads() * 2U, 4U, 32U);
+	for (i = 0; i < num_threads; ++i) {
+		memset(args + i, 0, sizeof(skiplist_arg_t));
+		args[i].list = list;
+		args[i].key_offset = 1 + (i * num_keys);
+		args[i].num_keys = num_keys;
+		args[i].num_ops = 50000;
+		thread_initialize(&thread[i], skiplist_thread, args + i, STRING_CONST("skiplist_thread"),
+		                  THREAD_PRIORITY_NORMAL, 0);
+	}
+	for (i = 0; i < num_threads; ++i)
+		thread_start(&thread[i]);
+
+	test_wait_for_threads_startup(thread, num_threads);
+	test_wait_for_threads_finish(thread, num_threads);
+
+	for (i = 0; i < num_threads; ++i) {
+		thread_finalize(&thread[i]);
+		EXPECT_SIZEEQ(args[i].failed, 0);
+	}
+
+	num_shared = skiplist_range(list, SKIPLIST_SHARED_KEY, SKIPLIST_SHARED_KEY + SKIPLIST_SHARED_KEYS, 0, 0,
+	                            SKIPLIST_SHARED_KEYS);
+	EXPECT_SIZEEQ(skiplist_size(list), ((num_threads * num_keys) / 2) + num_shared);
+
+	found = memory_allocate(0, sizeof(uint64_t) * num_threads * num_keys, 0, MEMORY_PERSISTENT);
+	values = memory_allocate(0, sizeof(uint64_t) * num_threads * num_keys, 0, MEMORY_PERSISTENT);
+	count = skiplist_range(list, 0, UINT64_MAX, found, values, num_threads * num_keys);
+	EXPECT_SIZEEQ(count, skiplist_size(list));
+	for (i = 0; i < count; ++i) {
+		if (i)
+			EXPECT_GT(found[i], found[i - 1]);
+		if (found[i] < SKIPLIST_SHARED_KEY) {
+			EXPECT_EQ(found[i] & 1, 0);
+			EXPECT_EQ(values[i], found[i] * 2);
+		} else {
+			EXPECT_EQ(values[i], found[i]);
+		}
+	}
+
+	skiplist_reclaim(list);
+	EXPECT_EQ(atomic_load32(&list->num_retired), 0);
+
+	memory_deallocate(found);
+	memory_deallocate(values);
+	skiplist_deallocate(list);
+
+	return 0;
+}
+
+DECLARE_TEST(skiplist, performance) {
+	thread_t thread[16];
+	skiplist_arg_t args[16];
+	unsigned int read_percent[] = {100, 90, 50};
+	size_t num_keys = 65536;
+	size_t num_ops = 200000;
+	size_t max_threads = math_clamp(system_hardware_threads(), 4U, 16U);
+	size_t iratio, num_threads, i;
+	uint64_t ikey;
+	tick_t start, time_list, time_locked;
+
+	for (iratio = 0; iratio < sizeof(read_percent) / sizeof(read_percent[0]); ++iratio) {
+		for (num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+			skiplist_t list;
+			btree_t tree;
+			mutex_t* mutex = mutex_allocate(STRING_CONST("skiplist_btree"));
+
+			//Half of the key space populated
+			skiplist_initialize(&list);
+			btree_initialize(&tree);
+			for (ikey = 0; ikey < num_keys; ikey += 2) {
+				skiplist_insert(&list, ikey, ikey);
+				btree_insert(&tree, ikey, (void*)(uintptr_t)(ikey + 1));
+			}
+
+			for (i = 0; i < num_threads; ++i) {
+				memset(args + i, 0, sizeof(skiplist_arg_t));
+				args[i].list = &list;
+				args[i].tree = &tree;
+				args[i].mutex = mutex;
+				args[i].num_keys = num_keys;
+				args[i].num_ops = num_ops;
+				args[i].read_percent = read_percent[iratio];
+				thread_initialize(&thread[i], skiplist_mixed_thread, args + i, STRING_CONST("skiplist_mixed"),
+				                  THREAD_PRIORITY_NORMAL, 0);
+			}
+			start = time_current();
+			for (i = 0; i < num_threads; ++i)
+				thread_start(&thread[i]);
+			test_wait_for_threads_startup(thread, num_threads);
+			test_wait_for_threads_finish(thread, num_threads);
+			time_list = time_diff(start, time_current());
+			for (i = 0; i < num_threads; ++i)
+				thread_finalize(&thread[i]);
+
+			for (i = 0; i < num_threads; ++i)
+				thread_initialize(&thread[i], skiplist_locked_thread, args + i, STRING_CONST("skiplist_locked"),
+				                  THREAD_PRIORITY_NORMAL, 0);
+			start = time_current();
+			for (i = 0; i < num_threads; ++i)
+				thread_start(&thread[i]);
+			test_wait_for_threads_startup(thread, num_threads);
+			test_wait_for_threads_finish(thread, num_threads);
+			time_locked = time_diff(start, time_current());
+			for (i = 0; i < num_threads; ++i)
+				thread_finalize(&thread[i]);
+
+			log_infof(HASH_TEST, STRING_CONST("%u%% reads, %" PRIsize " threads, %" PRIsize " ops: skiplist %.2f ms, locked btree %.2f ms"),
+			          read_percent[iratio], num_threads, num_threads * num_ops,
+			          time_ticks_to_seconds(time_list) * 1000.0, time_ticks_to_seconds(time_locked) * 1000.0);
+
+			if (read_percent[iratio] == 100)
+				EXPECT_SIZEEQ(skiplist_size(&list), num_keys / 2);
+			EXPECT_SIZEEQ(skiplist_size(&list), skiplist_range(&list, 0, UINT64_MAX, 0, 0, num_keys));
+
+			skiplist_finalize(&list);
+			btree_finalize(&tree);
+			mutex_deallocate(mutex);
+		}
+	}
+
+	return 0;
+}
+
+static void
+test_skiplist_declare(void) {
+	ADD_TEST(skiplist, basic);
+	ADD_TEST(skiplist, range);
+	ADD_TEST(skiplist, threaded);
+	ADD_TEST(skiplist, performance);
+}
+
+static test_suite_t test_skiplist_suite = {
+	test_skiplist_application,
+	test_skiplist_memory_system,
+	test_skiplist_config,
+	test_skiplist_declare,
+	test_skiplist_initialize,
+	test_skiplist_finalize,
+	0
+};
+
+#if BUILD_MONOLITHIC
+
+int
+test_skiplist_run(void);
+
+int
+test_skiplist_run(void) {
+	test_suite = test_skiplist_suite;
+	return test_run_all();
+}
+
+#else
+
+test_suite_t
+test_suite_define(void);
+
+test_suite_t
+test_suite_define(void) {
+	return test_skiplist_suite;
+}
+
+#endif
@@ -0,0 +1,275 @@
+/* main.c  -  Foundation stringmap test  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+#include <test/test.h>
+
+static application_t
+test_stringmap_application(void) {
+	application_t app;
+	memset(&app, 0, sizeof(app));
+	app.name = string_const(STRING_CONST("Foundation stringmap tests"));
+	app.short_name = string_const(STRING_CONST("test_stringmap"));
+	app.company = string_const(STRING_CONST("Rampant Pixels"));
+	app.flags = APPLICATION_UTILITY;
+	app.exception_handler = test_exception_handler;
+	return app;
+}
+
+static memory_system_t
+test_stringmap_memory_system(void) {
+	return memory_system_malloc();
+}
+
+static foundation_config_t
+test_stringmap_config(void) {
+	foundation_config_t config;
+	memset(&config, 0, sizeof(config));
+	return config;
+}
+
+static int
+test_stringmap_initialize(void) {
+	return 0;
+}
+
+static void
+test_stringmap_finalize(void) {
+}
+
+DECLARE_TEST(stringmap, insert) {
+	stringmap_t* map = stringmap_allocate(0);
+	void* prev;
+
+	EXPECT_SIZEEQ(stringmap_size(map), 0);
+	EXPECT_EQ(stringmap_lookup(map, STRING_CONST("key")), 0);
+	EXPECT_EQ(stringmap_lookup(map, STRING_CONST("")), 0);
+
+	prev = stringmap_insert(map, STRING_CONST("key"), map);
+	EXPECT_EQ(prev, 0);
+	prev = stringmap_insert(map, STRING_CONST("key"), map + 1);
+	EXPECT_EQ(prev, map);
+	EXPECT_EQ(stringmap_lookup(map, STRING_CONST("key")), map + 1);
+	EXPECT_SIZEEQ(stringmap_size(map), 1);
+
+	//Prefixes and empty keys are distinct keys
+	EXPECT_EQ(stringmap_insert(map, STRING_CONST("ke"), map + 2), 0);
+	EXPECT_EQ(stringmap_insert(map, STRING_CONST(""), map + 3), 0);
+	EXPECT_EQ(stringmap_lookup(map, "keyboard", 3), map + 1);
+	EXPECT_EQ(stringmap_lookup(map, STRING_CONST("ke")), map + 2);
+	EXPECT_EQ(stringmap_lookup(map, STRING_CONST("")), map + 3);
+	EXPECT_SIZEEQ(stringmap_size(map), 3);
+
+	EXPECT_EQ(stringmap_erase(map, STRING_CONST("key")), map + 1);
+	EXPECT_EQ(stringmap_erase(map, STRING_CONST("key")), 0);
+	EXPECT_FALSE(stringmap_has_key(map, STRING_CONST("key")));
+	EXPECT_TRUE(stringmap_has_key(map, STRING_CONST("ke")));
+	EXPECT_SIZEEQ(stringmap_size(map), 2);
+
+	stringmap_clear(map);
+	EXPECT_SIZEEQ(stringmap_size(map), 0);
+	EXPECT_FALSE(stringmap_has_key(map, STRING_CONST("ke")));
+	EXPECT_FALSE(stringmap_has_key(map, STRING_CONST("")));
+
+	stringmap_deallocate(map);
+
+	return 0;
+}
+
+DECLARE_TEST(stringmap, grow) {
+	stringmap_t map;
+	char buffer[64];
+	size_t ikey, num_keys = 100000;
+
+	stringmap_initialize(&map, 0);
+
+	for (ikey = 0; ikey < num_keys; ++ikey) {
+		string_t key = string_format(buffer, sizeof(buffer), STRING_CONST("key_%" PRIsize), ikey);
+		EXPECT_EQ(stringmap_insert(&map, STRING_ARGS(key), (void*)(uintptr_t)(ikey + 1)), 0);
+	}
+	EXPECT_SIZEEQ(stringmap_size(&map), num_keys);
+
+	for (ikey = 0; ikey < num_keys; ikey += 3) {
+		string_t key = string_format(buffer, sizeof(buffer), STRING_CONST("key_%" PRIsize), ikey);
+		EXPECT_EQ(stringmap_erase(&map, STRING_ARGS(key)), (void*)(uintptr_t)(ikey + 1));
+	}
+
+	//Churn erased and reinserted keys to exercise reclaiming of erased slots
+	for (ikey = 0; ikey < num_keys; ikey += 3) {
+		string_t key = string_format(buffer, sizeof(buffer), STRING_CONST("other_%" PRIsize), ikey);
+		EXPECT_EQ(stringmap_insert(&map, STRING_ARGS(key), (void*)(uintptr_t)(ikey + 1)), 0);
+		EXPECT_EQ(stringmap_erase(&map, STRING_ARGS(key)), (void*)(uintptr_t)(ikey + 1));
+	}
+
+	for (ikey = 0; ikey < num_keys; ++ikey) {
+		string_t key = string_format(buffer, sizeof(buffer), STRING_CONST("key_%" PRIsize), ikey);
+		if (ikey % 3)
+			EXPECT_EQ(stringmap_lookup(&map, STRING_ARGS(key)), (void*)(uintptr_t)(ikey + 1));
+		else
+			EXPECT_FALSE(stringmap_has_key(&map, STRING_ARGS(key)));
+	}
+	EXPECT_SIZEEQ(stringmap_size(&map), num_keys - ((num_keys + 2) / 3));
+
+	stringmap_finalize(&map);
+
+	return 0;
+}
+
+DECLARE_TEST(stringmap, churn) {
+	stringmap_t map;
+	char buffer[64];
+	size_t ikey, num_keys = 64, num_cycles = 1000000;
+	size_t max_arena = 0;
+
+	stringmap_initialize(&map, 0);
+
+	//Keep a set of live keys while inserting and erasing unique keys
+	for (ikey = 0; ikey < num_keys; ++ikey) {
+		string_t key = string_format(buffer, sizeof(buffer), STRING_CONST("live_%" PRIsize), ikey);
+		stringmap_insert(&map, STRING_ARGS(key), (void*)(uintptr_t)(ikey + 1));
+	}
+
+	for (ikey = 0; ikey < num_cycles; ++ikey) {
+		string_t key = string_format(buffer, sizeof(buffer), STRING_CONST("churn_%" PRIsize), ikey);
+		EXPECT_EQ(stringmap_insert(&map, STRING_ARGS(key), (void*)(uintptr_t)(ikey + 1)), 0);
+		//Erase in a different order than inserted so keys are not last in the arena
+		if (ikey % 2) {
+			key = string_format(buffer, sizeof(buffer), STRING_CONST("churn_%" PRIsize), ikey - 1);
+			EXPECT_EQ(stringmap_erase(&map, STRING_ARGS(key)), (void*)(uintptr_t)ikey);
+			key = string_format(buffer, sizeof(buffer), STRING_CONST("churn_%" PRIsize), ikey);
+			EXPECT_EQ(stringmap_erase(&map, STRING_ARGS(key)), (void*)(uintptr_t)(ikey + 1));
+		}
+		if (map.arena_capacity > max_arena)
+			max_arena = map.arena_capacity;
+	}
+	EXPECT_SIZEEQ(stringmap_size(&map), num_keys);
+	EXPECT_SIZELE(max_arena, 16 * 1024);
+	EXPECT_SIZELE(map.arena_dead, map.arena_used);
+	EXPECT_SIZELE(map.num_groups, 16);
+
+	for (ikey = 0; ikey < num_keys; ++ikey) {
+		string_t key = string_format(buffer, sizeof(buffer), STRING_CONST("live_%" PRIsize), ikey);
+		EXPECT_EQ(stringmap_lookup(&map, STRING_ARGS(key)), (void*)(uintptr_t)(ikey + 1));
+	}
+
+	//Erasing all keys in turn leaves no key storage behind
+	for (ikey = 0; ikey < num_cycles; ++ikey) {
+		string_t key = string_format(buffer, sizeof(buffer), STRING_CONST("single_%" PRIsize), ikey);
+		stringmap_insert(&map, STRING_ARGS(key), &map);
+		stringmap_erase(&map, STRING_ARGS(key));
+	}
+	EXPECT_SIZELE(map.arena_capacity, 16 * 1024);
+
+	stringmap_finalize(&map);
+
+	return 0;
+}
+
+DECLARE_TEST(stringmap, performance) {
+	stringmap_t* map;
+	hashtable64_t* table;
+	char* paths;
+	string_const_t* path;
+	size_t ipath, num_paths = 1024 * 1024;
+	size_t found;
+	tick_t start, elapsed_insert, elapsed_lookup, elapsed_hashmap;
+
+	paths = memory_allocate(0, num_paths * 64, 0, MEMORY_PERSISTENT);
+	path = memory_allocate(0, sizeof(string_const_t) * num_paths, 0, MEMORY_PERSISTENT);
+	for (ipath = 0; ipath < num_paths; ++ipath) {
+		string_t str = string_format(paths + (ipath * 64), 64,
+		                             STRING_CONST("/data/assets/level%u/textures/tile_%" PRIsize ".png"),
+		                             (unsigned int)(ipath % 97), ipath);
+		path[ipath] = string_to_const(str);
+	}
+
+	map = stringmap_allocate(0);
+	start = time_current();
+	for (ipath = 0; ipath < num_paths; ++ipath)
+		stringmap_insert(map, STRING_ARGS(path[ipath]), (void*)(uintptr_t)(ipath + 1));
+	elapsed_insert = time_diff(start, time_current());
+	EXPECT_SIZEEQ(stringmap_size(map), num_paths);
+
+	start = time_current();
+	for (ipath = 0, found = 0; ipath < num_paths; ++ipath) {
+		if (stringmap_lookup(map, STRING_ARGS(path[ipath])) == (void*)(uintptr_t)(ipath + 1))
+			++found;
+	}
+	elapsed_lookup = time_diff(start, time_current());
+	EXPECT_SIZEEQ(found, num_paths);
+
+	//Hash-only table for reference, does not verify keys
+	table = hashtable64_allocate(num_paths * 2);
+	for (ipath = 0; ipath < num_paths; ++ipath)
+		hashtable64_set(table, string_hash(STRING_ARGS(path[ipath])), ipath + 1);
+	start = time_current();
+	for (ipath = 0, found = 0; ipath < num_paths; ++ipath) {
+		if (hashtable64_get(table, string_hash(STRING_ARGS(path[ipath]))) == ipath + 1)
+			++found;
+	}
+	elapsed_hashmap = time_diff(start, time_current());
+	EXPECT_SIZEEQ(found, num_paths);
+
+	log_infof(HASH_TEST,
+	          STRING_CONST("String map %" PRIsize " paths: insert %.2f ms, lookup %.2f ms (hashtable64 without key verification %.2f ms)"),
+	          num_paths, time_ticks_to_seconds(elapsed_insert) * 1000.0,
+	          time_ticks_to_seconds(elapsed_lookup) * 1000.0,
+	          time_ticks_to_seconds(elapsed_hashmap) * 1000.0);
+
+	hashtable64_deallocate(table);
+	stringmap_deallocate(map);
+	memory_deallocate(path);
+	memory_deallocate(paths);
+
+	return 0;
+}
+
+static void
+test_stringmap_declare(void) {
+	ADD_TEST(stringmap, insert);
+	ADD_TEST(stringmap, grow);
+	ADD_TEST(stringmap, churn);
+	ADD_TEST(stringmap, performance);
+}
+
+static test_suite_t test_stringmap_suite = {
+	test_stringmap_application,
+	test_stringmap_memory_system,
+	test_stringmap_config,
+	test_stringmap_declare,
+	test_stringmap_initialize,
+	test_stringmap_finalize,
+	0
+};
+
+#if BUILD_MONOLITHIC
+
+int
+test_stringmap_run(void);
+
+int
+test_stringmap_run(void) {
+	test_suite = test_stringmap_suite;
+	return test_run_all();
+}
+
+#else
+
+test_suite_t
+test_suite_define(void);
+
+test_suite_t
+test_suite_define(void) {
+	return test_stringmap_suite;
+}
+
+#endif
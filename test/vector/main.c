@@ -0,0 +1,358 @@
+/* main.c  -  Foundation vector test  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+#include <test/test.h>
+
+static application_t
+test_vector_application(void) {
+	application_t app;
+	memset(&app, 0, sizeof(app));
+	app.name = string_const(STRING_CONST("Foundation vector tests"));
+	app.short_name = string_const(STRING_CONST("test_vector"));
+	app.company = string_const(STRING_CONST("Rampant Pixels"));
+	app.flags = APPLICATION_UTILITY;
+	app.exception_handler = test_exception_handler;
+	return app;
+}
+
+static memory_system_t
+test_vector_memory_system(void) {
+	return memory_system_malloc();
+}
+
+static foundation_config_t
+test_vector_config(void) {
+	foundation_config_t config;
+	memset(&config, 0, sizeof(config));
+	return config;
+}
+
+static int
+test_vector_initialize(void) {
+	return 0;
+}
+
+static void
+test_vector_finalize(void) {
+}
+
+static bool
+test_vector_near(vector4_t v, float32_t x, float32_t y, float32_t z, float32_t w, float32_t eps) {
+	return (math_abs(vector4_x(v) - x) <= eps) && (math_abs(vector4_y(v) - y) <= eps) &&
+	       (math_abs(vector4_z(v) - z) <= eps) && (math_abs(vector4_w(v) - w) <= eps);
+}
+
+static bool
+test_vector_equal(vector4_t a, vector4_t b, float32_t eps) {
+	return test_vector_near(a, vector4_x(b), vector4_y(b), vector4_z(b), vector4_w(b), eps);
+}
+
+static void
+test_vector_transform_reference(const float32_t* mat, float32_t* dst, const float32_t* src) {
+	int col;
+	for (col = 0; col < 4; ++col)
+		dst[col] = src[0] * mat[col] + src[1] * mat[4 + col] + src[2] * mat[8 + col] +
+		           src[3] * mat[12 + col];
+}
+
+DECLARE_TEST(vector, construct) {
+	FOUNDATION_ALIGN(16) float32_t data[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+	float32_t unaligned[5] = {0.0f, 5.0f, 6.0f, 7.0f, 8.0f};
+	FOUNDATION_ALIGN(16) float32_t stored[4];
+	vector4_t v;
+
+	v = vector4(1.0f, 2.0f, 3.0f, 4.0f);
+	EXPECT_REALEQ(vector4_x(v), 1.0f);
+	EXPECT_REALEQ(vector4_y(v), 2.0f);
+	EXPECT_REALEQ(vector4_z(v), 3.0f);
+	EXPECT_REALEQ(vector4_w(v), 4.0f);
+
+	EXPECT_TRUE(test_vector_near(vector4_zero(), 0.0f, 0.0f, 0.0f, 0.0f, 0.0f));
+	EXPECT_TRUE(test_vector_near(vector4_splat(-2.5f), -2.5f, -2.5f, -2.5f, -2.5f, 0.0f));
+	EXPECT_TRUE(test_vector_near(vector4_load(data), 1.0f, 2.0f, 3.0f, 4.0f, 0.0f));
+	EXPECT_TRUE(test_vector_near(vector4_loadu(unaligned + 1), 5.0f, 6.0f, 7.0f, 8.0f, 0.0f));
+
+	vector4_store(stored, vector4(9.0f, 10.0f, 11.0f, 12.0f));
+	EXPECT_REALEQ(stored[0], 9.0f);
+	EXPECT_REALEQ(stored[3], 12.0f);
+	vector4_storeu(unaligned + 1, v);
+	EXPECT_REALEQ(unaligned[0], 0.0f);
+	EXPECT_REALEQ(unaligned[1], 1.0f);
+	EXPECT_REALEQ(unaligned[4], 4.0f);
+
+	return 0;
+}
+
+DECLARE_TEST(vector, arithmetic) {
+	vector4_t a = vector4(1.0f, -2.0f, 3.0f, -4.0f);
+	vector4_t b = vector4(2.0f, 4.0f, -8.0f, 16.0f);
+
+	EXPECT_TRUE(test_vector_near(vector4_add(a, b), 3.0f, 2.0f, -5.0f, 12.0f, 0.0f));
+	EXPECT_TRUE(test_vector_near(vector4_sub(a, b), -1.0f, -6.0f, 11.0f, -20.0f, 0.0f));
+	EXPECT_TRUE(test_vector_near(vector4_mul(a, b), 2.0f, -8.0f, -24.0f, -64.0f, 0.0f));
+	EXPECT_TRUE(test_vector_near(vector4_div(a, b), 0.5f, -0.5f, -0.375f, -0.25f, 1e-6f));
+	EXPECT_TRUE(test_vector_near(vector4_scale(a, 2.0f), 2.0f, -4.0f, 6.0f, -8.0f, 0.0f));
+	EXPECT_TRUE(test_vector_near(vector4_madd(a, b, a), 3.0f, -10.0f, -21.0f, -68.0f, 0.0f));
+	EXPECT_TRUE(test_vector_near(vector4_neg(a), -1.0f, 2.0f, -3.0f, 4.0f, 0.0f));
+	EXPECT_TRUE(test_vector_near(vector4_min(a, b), 1.0f, -2.0f, -8.0f, -4.0f, 0.0f));
+	EXPECT_TRUE(test_vector_near(vector4_max(a, b), 2.0f, 4.0f, 3.0f, 16.0f, 0.0f));
+
+	return 0;
+}
+
+DECLARE_TEST(vector, product) {
+	vector4_t a = vector4(1.0f, 2.0f, 3.0f, 4.0f);
+	vector4_t b = vector4(-5.0f, 6.0f, 7.0f, 8.0f);
+	vector4_t n;
+
+	EXPECT_REALEQ(vector4_dot(a, b), 60.0f);
+	EXPECT_REALEQ(vector4_dot3(a, b), 28.0f);
+	EXPECT_REALEQ(vector4_length_sqr(a), 30.0f);
+	EXPECT_REALONE(vector4_length(vector4(0.0f, 0.6f, 0.0f, 0.8f)));
+
+	EXPECT_TRUE(test_vector_near(vector4_cross3(vector4(1.0f, 0.0f, 0.0f, 1.0f),
+	                                            vector4(0.0f, 1.0f, 0.0f, 1.0f)),
+	                             0.0f, 0.0f, 1.0f, 0.0f, 0.0f));
+	EXPECT_TRUE(test_vector_near(vector4_cross3(a, b), -4.0f, -22.0f, 16.0f, 0.0f, 0.0f));
+	EXPECT_REALZERO(vector4_dot3(vector4_cross3(a, b), a));
+
+	n = vector4_normalize(a);
+	EXPECT_LE(math_abs(vector4_length(n) - 1.0f), 1e-6f);
+	EXPECT_LE(math_abs(vector4_x(n) * 4.0f - vector4_w(n)), 1e-6f);
+
+	n = vector4_normalize3(b);
+	EXPECT_LE(math_abs(vector4_length(n) - 1.0f), 1e-6f);
+	EXPECT_REALZERO(vector4_w(n));
+	EXPECT_TRUE(test_vector_near(vector4_normalize3(vector4(0.0f, 3.0f, 4.0f, 5.0f)),
+	                             0.0f, 0.6f, 0.8f, 0.0f, 1e-6f));
+
+	return 0;
+}
+
+DECLARE_TEST(vector, matrix) {
+	FOUNDATION_ALIGN(16) float32_t data[16];
+	FOUNDATION_ALIGN(16) float32_t stored[16];
+	FOUNDATION_ALIGN(16) float32_t reference[4];
+	matrix4_t a, b, m, t;
+	vector4_t v;
+	int i, j;
+
+	for (i = 0; i < 16; ++i)
+		data[i] = (float32_t)(i + 1) * ((i & 1) ? -0.5f : 0.25f);
+	a = matrix4_load(data);
+	matrix4_store(stored, &a);
+	for (i = 0; i < 16; ++i)
+		EXPECT_REALEQ(stored[i], data[i]);
+
+	m = matrix4_identity();
+	m = matrix4_mul(&a, &m);
+	matrix4_store(stored, &m);
+	for (i = 0; i < 16; ++i)
+		EXPECT_REALEQ(stored[i], data[i]);
+
+	t = matrix4_transpose(&a);
+	matrix4_store(stored, &t);
+	for (i = 0; i < 4; ++i) {
+		for (j = 0; j < 4; ++j)
+			EXPECT_REALEQ(stored[i * 4 + j], data[j * 4 + i]);
+	}
+
+	//(v * a) * b == v * (a * b)
+	b = matrix4_from_quaternion(quaternion_from_axis_angle(vector4_normalize3(vector4(1.0f, 2.0f, 3.0f, 0.0f)), 0.7f));
+	b.row[3] = vector4(4.0f, -5.0f, 6.0f, 1.0f);
+	m = matrix4_mul(&a, &b);
+	v = vector4(0.5f, -1.5f, 2.0f, 1.0f);
+	EXPECT_TRUE(test_vector_equal(vector4_transform(v, &m),
+	                              vector4_transform(vector4_transform(v, &a), &b), 1e-4f));
+
+	vector4_store(reference, v);
+	test_vector_transform_reference(data, stored, reference);
+	EXPECT_TRUE(test_vector_near(vector4_transform(v, &a), stored[0], stored[1], stored[2], stored[3], 1e-5f));
+
+	m = matrix4_translation(vector4(1.0f, 2.0f, 3.0f, 0.0f));
+	EXPECT_TRUE(test_vector_near(vector4_transform(vector4(1.0f, 1.0f, 1.0f, 1.0f), &m), 2.0f, 3.0f, 4.0f, 1.0f, 0.0f));
+	EXPECT_TRUE(test_vector_near(vector4_transform(vector4(1.0f, 1.0f, 1.0f, 0.0f), &m), 1.0f, 1.0f, 1.0f, 0.0f, 0.0f));
+
+	return 0;
+}
+
+DECLARE_TEST(vector, quaternion) {
+	vector4_t axis = vector4(0.0f, 0.0f, 1.0f, 0.0f);
+	quaternion_t q = quaternion_from_axis_angle(axis, REAL_HALFPI);
+	quaternion_t p, r;
+	matrix4_t m;
+	vector4_t v;
+
+	//Quarter turn around z maps x to y
+	EXPECT_TRUE(test_vector_near(quaternion_rotate(q, vector4(1.0f, 0.0f, 0.0f, 1.0f)),
+	                             0.0f, 1.0f, 0.0f, 1.0f, 1e-6f));
+	EXPECT_TRUE(test_vector_near(quaternion_rotate(quaternion_identity(), vector4(1.0f, 2.0f, 3.0f, 0.0f)),
+	                             1.0f, 2.0f, 3.0f, 0.0f, 0.0f));
+
+	//Rotation matrix agrees with quaternion rotation
+	q = quaternion_from_axis_angle(vector4_normalize3(vector4(1.0f, -2.0f, 0.5f, 0.0f)), 1.3f);
+	m = matrix4_from_quaternion(q);
+	v = vector4(0.3f, 1.7f, -2.2f, 0.0f);
+	EXPECT_TRUE(test_vector_equal(quaternion_rotate(q, v), vector4_transform(v, &m), 1e-5f));
+
+	//Product applies the right hand side first
+	p = quaternion_from_axis_angle(vector4_normalize3(vector4(0.0f, 1.0f, 1.0f, 0.0f)), -0.4f);
+	r = quaternion_mul(p, q);
+	EXPECT_TRUE(test_vector_equal(quaternion_rotate(r, v), quaternion_rotate(p, quaternion_rotate(q, v)), 1e-5f));
+
+	EXPECT_TRUE(test_vector_equal(quaternion_mul(q, quaternion_conjugate(q)), quaternion_identity(), 1e-6f));
+	p = vector4_scale(q, 3.0f);
+	EXPECT_TRUE(test_vector_equal(quaternion_mul(p, quaternion_inverse(p)), quaternion_identity(), 1e-5f));
+	EXPECT_TRUE(test_vector_equal(quaternion_normalize(p), q, 1e-6f));
+
+	return 0;
+}
+
+#define TEST_VECTOR_ARRAY_SIZE 1027
+
+DECLARE_TEST(vector, transform_array) {
+	vector4_t* src = memory_allocate(0, sizeof(vector4_t) * TEST_VECTOR_ARRAY_SIZE, 16, MEMORY_PERSISTENT);
+	vector4_t* dst = memory_allocate(0, sizeof(vector4_t) * TEST_VECTOR_ARRAY_SIZE, 16, MEMORY_PERSISTENT);
+	float32_t* points = memory_allocate(0, sizeof(float32_t) * 3 * TEST_VECTOR_ARRAY_SIZE, 0, MEMORY_PERSISTENT);
+	float32_t* transformed = memory_allocate(0, sizeof(float32_t) * 3 * TEST_VECTOR_ARRAY_SIZE, 0, MEMORY_PERSISTENT);
+	FOUNDATION_ALIGN(16) float32_t mat[16];
+	float32_t in[4], out[4];
+	matrix4_t m, rotation;
+	size_t i;
+
+	rotation = matrix4_from_quaternion(quaternion_from_axis_angle(vector4_normalize3(vector4(2.0f, 1.0f, -1.0f, 0.0f)), 2.1f));
+	m = matrix4_translation(vector4(10.0f, -20.0f, 30.0f, 0.0f));
+	m = matrix4_mul(&rotation, &m);
+	matrix4_store(mat, &m);
+
+	for (i = 0; i < TEST_VECTOR_ARRAY_SIZE; ++i) {
+		float32_t f = (float32_t)i;
+		src[i] = vector4(f, f * 0.5f, -f, (i & 1) ? 1.0f : 0.0f);
+		points[i * 3] = f;
+		points[i * 3 + 1] = f * 0.5f;
+		points[i * 3 + 2] = -f;
+	}
+
+	matrix4_transform_array(&m, dst, src, TEST_VECTOR_ARRAY_SIZE);
+	matrix4_transform_points(&m, transformed, points, TEST_VECTOR_ARRAY_SIZE);
+	for (i = 0; i < TEST_VECTOR_ARRAY_SIZE; ++i) {
+		vector4_storeu(in, src[i]);
+		test_vector_transform_reference(mat, out, in);
+		EXPECT_TRUE(test_vector_near(dst[i], out[0], out[1], out[2], out[3], 1e-3f));
+
+		in[3] = 1.0f;
+		test_vector_transform_reference(mat, out, in);
+		EXPECT_LE(math_abs(transformed[i * 3] - out[0]), 1e-3f);
+		EXPECT_LE(math_abs(transformed[i * 3 + 1] - out[1]), 1e-3f);
+		EXPECT_LE(math_abs(transformed[i * 3 + 2] - out[2]), 1e-3f);
+	}
+
+	//In place transform of a count not a multiple of the vector width
+	matrix4_transform_array(&m, src, src, TEST_VECTOR_ARRAY_SIZE);
+	matrix4_transform_points(&m, points, points, TEST_VECTOR_ARRAY_SIZE);
+	for (i = 0; i < TEST_VECTOR_ARRAY_SIZE; ++i) {
+		EXPECT_TRUE(test_vector_equal(src[i], dst[i], 0.0f));
+		EXPECT_REALEQ(points[i * 3], transformed[i * 3]);
+		EXPECT_REALEQ(points[i * 3 + 2], transformed[i * 3 + 2]);
+	}
+
+	memory_deallocate(src);
+	memory_deallocate(dst);
+	memory_deallocate(points);
+	memory_deallocate(transformed);
+
+	return 0;
+}
+
+#define TEST_VECTOR_PERFORMANCE_SIZE (4 * 1024 * 1024)
+
+DECLARE_TEST(vector, performance) {
+	float32_t* src = memory_allocate(0, sizeof(float32_t) * 4 * TEST_VECTOR_PERFORMANCE_SIZE, 16, MEMORY_PERSISTENT);
+	float32_t* dst = memory_allocate(0, sizeof(float32_t) * 4 * TEST_VECTOR_PERFORMANCE_SIZE, 16, MEMORY_PERSISTENT);
+	FOUNDATION_ALIGN(16) float32_t mat[16];
+	matrix4_t m;
+	tick_t start, scalar, simd, points;
+	size_t i;
+
+	m = matrix4_from_quaternion(quaternion_from_axis_angle(vector4_normalize3(vector4(1.0f, 1.0f, 0.0f, 0.0f)), 0.5f));
+	m.row[3] = vector4(1.0f, 2.0f, 3.0f, 1.0f);
+	matrix4_store(mat, &m);
+	for (i = 0; i < 4 * TEST_VECTOR_PERFORMANCE_SIZE; ++i)
+		src[i] = (float32_t)(i & 0xFFF) * 0.01f;
+
+	start = time_current();
+	for (i = 0; i < TEST_VECTOR_PERFORMANCE_SIZE; ++i)
+		test_vector_transform_reference(mat, dst + i * 4, src + i * 4);
+	scalar = time_diff(start, time_current());
+
+	start = time_current();
+	matrix4_transform_array(&m, (vector4_t*)dst, (const vector4_t*)src, TEST_VECTOR_PERFORMANCE_SIZE);
+	simd = time_diff(start, time_current());
+
+	start = time_current();
+	matrix4_transform_points(&m, dst, src, TEST_VECTOR_PERFORMANCE_SIZE);
+	points = time_diff(start, time_current());
+
+	log_infof(HASH_TEST, STRING_CONST("Transform %d points: scalar %.3fms, vector array %.3fms, packed points %.3fms"),
+	          TEST_VECTOR_PERFORMANCE_SIZE, time_ticks_to_seconds(scalar) * 1000.0,
+	          time_ticks_to_seconds(simd) * 1000.0, time_ticks_to_seconds(points) * 1000.0);
+
+	memory_deallocate(src);
+	memory_deallocate(dst);
+
+	return 0;
+}
+
+static void
+test_vector_declare(void) {
+	ADD_TEST(vector, construct);
+	ADD_TEST(vector, arithmetic);
+	ADD_TEST(vector, product);
+	ADD_TEST(vector, matrix);
+	ADD_TEST(vector, quaternion);
+	ADD_TEST(vector, transform_array);
+	ADD_TEST(vector, performance);
+}
+
+static test_suite_t test_vector_suite = {
+	test_vector_application,
+	test_vector_memory_system,
+	test_vector_config,
+	test_vector_declare,
+	test_vector_initialize,
+	test_vector_finalize,
+	0
+};
+
+#if BUILD_MONOLITHIC
+
+int
+test_vector_run(void);
+
+int
+test_vector_run(void) {
+	test_suite = test_vector_suite;
+	return test_run_all();
+}
+
+#else
+
+test_suite_t
+test_suite_define(void);
+
+test_suite_t
+test_suite_define(void) {
+	return test_vector_suite;
+}
+
+#endif
@@ -0,0 +1,539 @@
+/* main.c  -  Foundation wal test  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support
+ * data types and functions to write applications and games in a platform-independent fashion.
+ * The latest source code is always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without
+ * any restrictions.
+ */
+
+#include <foundation/foundation.h>
+#include <test/test.h>
+
+static application_t
+test_wal_application(void) {
+	application_t app;
+	memset(&app, 0, sizeof(app));
+	app.name = string_const(STRING_CONST("Foundation wal tests"));
+	app.short_name = string_const(STRING_CONST("test_wal"));
+	app.company = string_const(STRING_CONST("Rampant Pixels"));
+	app.flags = APPLICATION_UTILITY;
+	app.exception_handler = test_exception_handler;
+	return app;
+}
+
+static memory_system_t
+test_wal_memory_system(void) {
+	return memory_system_malloc();
+}
+
+static foundation_config_t
+test_wal_config(void) {
+	foundation_config_t config;
+	memset(&config, 0, sizeof(config));
+	return config;
+}
+
+static int
+test_wal_initialize(void) {
+	return 0;
+}
+
+static void
+test_wal_finalize(void) {
+}
+
+typedef struct {
+	uint64_t first;
+	uint64_t last;
+	size_t count;
+	size_t bytes;
+	size_t stop;
+	bool valid;
+} wal_test_context_t;
+
+static int
+wal_test_record(uint64_t sequence, const void* data, size_t size, void* context) {
+	wal_test_context_t* test = context;
+	const unsigned char* bytes = data;
+	size_t ibyte;
+	if (!test->count)
+		test->first = sequence;
+	else if (sequence != test->last + 1)
+		test->valid = false;
+	//Record data is the sequence number repeated, record size depends on sequence number
+	if (size != (size_t)(sequence % 97) * 3)
+		test->valid = false;
+	for (ibyte = 0; ibyte < size; ++ibyte) {
+		if (bytes[ibyte] != (unsigned char)sequence)
+			test->valid = false;
+	}
+	test->last = sequence;
+	test->bytes += size;
+	++test->count;
+	return (test->stop && (test->count == test->stop)) ? 1 : 0;
+}
+
+static uint64_t
+wal_test_append(wal_t* wal) {
+	unsigned char data[512];
+	uint64_t sequence = wal_sequence(wal) + 1;
+	size_t size = (size_t)(sequence % 97) * 3;
+	memset(data, (int)(unsigned char)sequence, size);
+	return wal_append(wal, data, size);
+}
+
+static wal_test_context_t
+wal_test_recover(string_t path, uint64_t sequence, size_t stop, uint64_t* last) {
+	wal_test_context_t context;
+	memset(&context, 0, sizeof(context));
+	context.valid = true;
+	context.stop = stop;
+	*last = wal_recover(STRING_ARGS(path), sequence, wal_test_record, &context);
+	return context;
+}
+
+static size_t
+wal_test_segments(string_t path) {
+	string_t* files = fs_matching_files(STRING_ARGS(path), STRING_CONST("^.*\\.wal$"), false);
+	size_t count = array_size(files);
+	string_array_deallocate(files);
+	return count;
+}
+
+DECLARE_TEST(wal, basic) {
+	char buffer[BUILD_MAX_PATHLEN];
+	string_t path = path_make_temporary(buffer, sizeof(buffer));
+	wal_test_context_t context;
+	wal_t* wal;
+	uint64_t sequence;
+	uint64_t last;
+	size_t irecord;
+
+	EXPECT_UINTEQ(wal_recover(STRING_ARGS(path), 0, wal_test_record, nullptr), 0);
+
+	wal = wal_allocate(STRING_ARGS(path), 0);
+	EXPECT_NE(wal, nullptr);
+	EXPECT_TRUE(fs_is_directory(STRING_ARGS(path)));
+	EXPECT_UINTEQ(wal_sequence(wal), 0);
+	EXPECT_UINTEQ(wal_durable(wal), 0);
+	EXPECT_TRUE(wal_sync(wal, 0));
+
+	for (irecord = 0; irecord < 100; ++irecord)
+		EXPECT_UINTEQ(wal_test_append(wal), irecord + 1);
+	EXPECT_UINTEQ(wal_sequence(wal), 100);
+	EXPECT_TRUE(wal_sync(wal, 50));
+	EXPECT_GE(wal_durable(wal), 50);
+	EXPECT_TRUE(wal_sync(wal, 100));
+	EXPECT_UINTEQ(wal_durable(wal), 100);
+	//Waiting for a record not yet appended waits for the last appended record
+	EXPECT_TRUE(wal_sync(wal, 1000));
+	wal_deallocate(wal);
+	EXPECT_SIZEEQ(wal_test_segments(path), 1);
+
+	context = wal_test_recover(path, 0, 0, &last);
+	EXPECT_TRUE(context.valid);
+	EXPECT_SIZEEQ(context.count, 100);
+	EXPECT_UINTEQ(context.first, 1);
+	EXPECT_UINTEQ(last, 100);
+
+	context = wal_test_recover(path, 60, 0, &last);
+	EXPECT_TRUE(context.valid);
+	EXPECT_SIZEEQ(context.count, 41);
+	EXPECT_UINTEQ(context.first, 60);
+
+	context = wal_test_recover(path, 0, 10, &last);
+	EXPECT_SIZEEQ(context.count, 10);
+	EXPECT_UINTEQ(last, 10);
+
+	//Reopen and continue appending
+	wal = wal_allocate(STRING_ARGS(path), 0);
+	EXPECT_NE(wal, nullptr);
+	EXPECT_UINTEQ(wal_sequence(wal), 100);
+	EXPECT_UINTEQ(wal_durable(wal), 100);
+	for (irecord = 0; irecord < 10; ++irecord)
+		sequence = wal_test_append(wal);
+	EXPECT_UINTEQ(sequence, 110);
+	EXPECT_UINTEQ(wal_append(wal, buffer, 65 * 1024 * 1024), 0);
+	EXPECT_UINTEQ(wal_sequence(wal), 110);
+	wal_deallocate(wal);
+
+	context = wal_test_recover(path, 0, 0, &last);
+	EXPECT_TRUE(context.valid);
+	EXPECT_SIZEEQ(context.count, 110);
+	EXPECT_UINTEQ(last, 110);
+
+	fs_remove_directory(STRING_ARGS(path));
+	return 0;
+}
+
+DECLARE_TEST(wal, segment) {
+	char buffer[BUILD_MAX_PATHLEN];
+	string_t path = path_make_temporary(buffer, sizeof(buffer));
+	wal_test_context_t context;
+	wal_t* wal;
+	uint64_t last;
+	size_t irecord;
+	size_t segments;
+
+	wal = wal_allocate(STRING_ARGS(path), 8192);
+	EXPECT_NE(wal, nullptr);
+	for (irecord = 0; irecord < 2000; ++irecord) {
+		EXPECT_UINTEQ(wal_test_append(wal), irecord + 1);
+		if (!(irecord % 100))
+			EXPECT_TRUE(wal_sync(wal, irecord + 1));
+	}
+	EXPECT_TRUE(wal_sync(wal, 2000));
+	segments = wal_test_segments(path);
+	EXPECT_GT(segments, 10);
+
+	context = wal_test_recover(path, 0, 0, &last);
+	EXPECT_TRUE(context.valid);
+	EXPECT_SIZEEQ(context.count, 2000);
+	EXPECT_UINTEQ(last, 2000);
+
+	//Truncate keeps the segment holding the requested record
+	EXPECT_GT(wal_truncate(wal, 1000), 0);
+	EXPECT_LT(wal_test_segments(path), segments);
+	context = wal_test_recover(path, 0, 0, &last);
+	EXPECT_TRUE(context.valid);
+	EXPECT_LE(context.first, 1000);
+	EXPECT_GT(context.first, 1);
+	EXPECT_UINTEQ(last, 2000);
+	EXPECT_SIZEEQ(wal_truncate(wal, 1000), 0);
+
+	//Records not yet durable are never truncated
+	EXPECT_GT(wal_truncate(wal, 100000), 0);
+	EXPECT_SIZEEQ(wal_test_segments(path), 1);
+	context = wal_test_recover(path, 0, 0, &last);
+	EXPECT_TRUE(context.valid);
+	EXPECT_GT(context.count, 0);
+	EXPECT_UINTEQ(last, 2000);
+	wal_deallocate(wal);
+
+	//Reopen with larger segments
+	wal = wal_allocate(STRING_ARGS(path), 1024 * 1024);
+	EXPECT_NE(wal, nullptr);
+	EXPECT_UINTEQ(wal_sequence(wal), 2000);
+	for (irecord = 0; irecord < 2000; ++irecord)
+		wal_test_append(wal);
+	wal_deallocate(wal);
+	EXPECT_SIZEEQ(wal_test_segments(path), 1);
+
+	context = wal_test_recover(path, 1500, 0, &last);
+	EXPECT_TRUE(context.valid);
+	EXPECT_LE(context.first, 2000);
+	EXPECT_SIZEEQ(context.count, (size_t)(4000 - context.first + 1));
+	EXPECT_UINTEQ(last, 4000);
+
+	fs_remove_directory(STRING_ARGS(path));
+	return 0;
+}
+
+DECLARE_TEST(wal, recovery) {
+	char buffer[BUILD_MAX_PATHLEN];
+	char segbuffer[BUILD_MAX_PATHLEN];
+	string_t path = path_make_temporary(buffer, sizeof(buffer));
+	string_t* files;
+	string_t segpath;
+	wal_test_context_t context;
+	fs_map_t map;
+	wal_t* wal;
+	uint64_t last;
+	size_t irecord;
+
+	wal = wal_allocate(STRING_ARGS(path), 0);
+	EXPECT_NE(wal, nullptr);
+	for (irecord = 0; irecord < 100; ++irecord)
+		wal_test_append(wal);
+	wal_deallocate(wal);
+
+	//Tear the last records by corrupting the record at the middle of the segment
+	files = fs_matching_files(STRING_ARGS(path), STRING_CONST("^.*\\.wal$"), false);
+	EXPECT_SIZEEQ(array_size(files), 1);
+	segpath = path_concat(segbuffer, sizeof(segbuffer), STRING_ARGS(path), STRING_ARGS(files[0]));
+	string_array_deallocate(files);
+	EXPECT_TRUE(fs_map_file(&map, STRING_ARGS(segpath), STREAM_IN | STREAM_OUT));
+	((char*)map.data)[map.size / 2] ^= 0x55;
+	fs_unmap_file(&map);
+
+	context = wal_test_recover(path, 0, 0, &last);
+	EXPECT_TRUE(context.valid);
+	EXPECT_GT(context.count, 10);
+	EXPECT_LT(context.count, 90);
+	EXPECT_UINTEQ(last, context.count);
+
+	//Records after the torn record are discarded when reopening
+	wal = wal_allocate(STRING_ARGS(path), 0);
+	EXPECT_NE(wal, nullptr);
+	EXPECT_UINTEQ(wal_sequence(wal), last);
+	for (irecord = 0; irecord < 100; ++irecord)
+		wal_test_append(wal);
+	EXPECT_TRUE(wal_sync(wal, wal_sequence(wal)));
+	EXPECT_UINTEQ(wal_durable(wal), last + 100);
+
+	//Simulate a crash where a new segment was started before all previous records
+	//were durable, leaving the previous segment unsealed
+	{
+		unsigned char header[24];
+		stream_t* stream;
+		uint64_t first = last + 150;
+		char namebuffer[32];
+		string_t name = string_format(namebuffer, sizeof(namebuffer), STRING_CONST("%016" PRIx64 ".wal"), first);
+		wal_deallocate(wal);
+		segpath = path_concat(segbuffer, sizeof(segbuffer), STRING_ARGS(path), STRING_ARGS(name));
+		stream = stream_open(STRING_ARGS(segpath), STREAM_OUT | STREAM_CREATE | STREAM_BINARY);
+		EXPECT_NE(stream, nullptr);
+		memset(header, 0, sizeof(header));
+		memcpy(header, "WEADRLOG", 8);
+		memcpy(header + 8, &first, sizeof(first));
+		stream_write(stream, header, sizeof(header));
+		stream_deallocate(stream);
+	}
+	EXPECT_SIZEEQ(wal_test_segments(path), 2);
+	context = wal_test_recover(path, 0, 0, &last);
+	EXPECT_TRUE(context.valid);
+	EXPECT_UINTEQ(last, context.count);
+
+	wal = wal_allocate(STRING_ARGS(path), 0);
+	EXPECT_NE(wal, nullptr);
+	EXPECT_SIZEEQ(wal_test_segments(path), 1);
+	EXPECT_UINTEQ(wal_sequence(wal), last);
+	wal_deallocate(wal);
+	fs_remove_directory(STRING_ARGS(path));
+
+	//Simulate a crash after rotating to a new segment holding records, before the previous
+	//segment was sealed, and recover from a sequence number in the new segment
+	{
+		uint64_t segfirst[2] = {0, 0};
+		size_t ifile, segments;
+		wal = wal_allocate(STRING_ARGS(path), 8192);
+		EXPECT_NE(wal, nullptr);
+		for (irecord = 0; irecord < 300; ++irecord)
+			wal_test_append(wal);
+		EXPECT_TRUE(wal_sync(wal, 300));
+		wal_deallocate(wal);
+		segments = wal_test_segments(path);
+		EXPECT_GT(segments, 2);
+
+		files = fs_matching_files(STRING_ARGS(path), STRING_CONST("^.*\\.wal$"), false);
+		for (ifile = 0; ifile < array_size(files); ++ifile) {
+			uint64_t first = string_to_uint64(files[ifile].str, 16, true);
+			if (first > segfirst[1]) {
+				segfirst[0] = segfirst[1];
+				segfirst[1] = first;
+			}
+			else if (first > segfirst[0]) {
+				segfirst[0] = first;
+			}
+		}
+		string_array_deallocate(files);
+		EXPECT_LT(segfirst[1], 300);
+
+		{
+			char namebuffer[32];
+			string_t name = string_format(namebuffer, sizeof(namebuffer), STRING_CONST("%016" PRIx64 ".wal"),
+			                              segfirst[0]);
+			segpath = path_concat(segbuffer, sizeof(segbuffer), STRING_ARGS(path), STRING_ARGS(name));
+			EXPECT_TRUE(fs_map_file(&map, STRING_ARGS(segpath), STREAM_IN | STREAM_OUT));
+			//Clear the last record sequence number in the header, marking it unsealed
+			((uint64_t*)map.data)[2] = 0;
+			EXPECT_TRUE(fs_map_flush(&map, 0, map.size));
+			fs_unmap_file(&map);
+		}
+
+		context = wal_test_recover(path, segfirst[1] + 1, 0, &last);
+		EXPECT_SIZEEQ(context.count, 0);
+		context = wal_test_recover(path, segfirst[0] + 1, 0, &last);
+		EXPECT_TRUE(context.valid);
+		EXPECT_UINTEQ(context.last, segfirst[1] - 1);
+		EXPECT_UINTEQ(last, segfirst[1] - 1);
+
+		//Reopening discards the same segment
+		wal = wal_allocate(STRING_ARGS(path), 8192);
+		EXPECT_NE(wal, nullptr);
+		EXPECT_SIZEEQ(wal_test_segments(path), segments - 1);
+		EXPECT_UINTEQ(wal_sequence(wal), segfirst[1] - 1);
+		wal_deallocate(wal);
+	}
+
+	fs_remove_directory(STRING_ARGS(path));
+	return 0;
+}
+
+typedef struct {
+	wal_t* wal;
+	size_t commits;
+	bool success;
+} wal_test_thread_t;
+
+static void*
+wal_test_commit_thread(void* arg) {
+	wal_test_thread_t* test = arg;
+	unsigned char data[64];
+	size_t icommit;
+	memset(data, 0x5A, sizeof(data));
+	test->success = true;
+	for (icommit = 0; icommit < test->commits; ++icommit) {
+		uint64_t sequence = wal_append(test->wal, data, sizeof(data));
+		if (!sequence || !wal_sync(test->wal, sequence) || (wal_durable(test->wal) < sequence))
+			test->success = false;
+	}
+	return 0;
+}
+
+static int
+wal_test_count(uint64_t sequence, const void* data, size_t size, void* context) {
+	FOUNDATION_UNUSED(sequence);
+	if ((size != 64) || (*(const unsigned char*)data != 0x5A))
+		return 1;
+	++(*(size_t*)context);
+	return 0;
+}
+
+DECLARE_TEST(wal, groupcommit) {
+	char buffer[BUILD_MAX_PATHLEN];
+	string_t path = path_make_temporary(buffer, sizeof(buffer));
+	wal_test_thread_t arg[16];
+	thread_t thread[16];
+	size_t num_threads = math_clamp(system_hardware_threads() * 2, 4, 16);
+	size_t commits = 100;
+	size_t ithread;
+	size_t count = 0;
+	uint64_t flushes;
+	wal_t* wal;
+	tick_t start, elapsed;
+
+	wal = wal_allocate(STRING_ARGS(path), 64 * 1024);
+	EXPECT_NE(wal, nullptr);
+
+	start = time_current();
+	for (ithread = 0; ithread < num_threads; ++ithread) {
+		arg[ithread].wal = wal;
+		arg[ithread].commits = commits;
+		thread_initialize(&thread[ithread], wal_test_commit_thread, &arg[ithread], STRING_CONST("wal_commit"),
+		                  THREAD_PRIORITY_NORMAL, 0);
+	}
+	for (ithread = 0; ithread < num_threads; ++ithread)
+		thread_start(&thread[ithread]);
+	test_wait_for_threads_startup(thread, num_threads);
+	test_wait_for_threads_finish(thread, num_threads);
+	elapsed = time_diff(start, time_current());
+	for (ithread = 0; ithread < num_threads; ++ithread) {
+		EXPECT_TRUE(arg[ithread].success);
+		thread_finalize(&thread[ithread]);
+	}
+
+	EXPECT_UINTEQ(wal_sequence(wal), num_threads * commits);
+	EXPECT_UINTEQ(wal_durable(wal), num_threads * commits);
+	flushes = wal->flushes;
+	//Concurrent commits share flushes
+	EXPECT_LT(flushes, num_threads * commits);
+
+	//Notify through beacon
+	{
+		beacon_t beacon;
+		uint64_t sequence = wal_append(wal, buffer, 64);
+		beacon_initialize(&beacon);
+		wal_notify(wal, sequence, &beacon);
+		EXPECT_GE(beacon_try_wait(&beacon, 10000), 0);
+		EXPECT_UINTEQ(wal_durable(wal), sequence);
+		//Already durable, fired immediately
+		wal_notify(wal, sequence, &beacon);
+		EXPECT_GE(beacon_try_wait(&beacon, 0), 0);
+		beacon_finalize(&beacon);
+	}
+	wal_deallocate(wal);
+
+	EXPECT_UINTEQ(wal_recover(STRING_ARGS(path), 0, wal_test_count, &count), num_threads * commits + 1);
+	EXPECT_SIZEEQ(count, num_threads * commits);
+
+	log_infof(HASH_TEST, STRING_CONST("Write-ahead log: %" PRIsize " threads, %.0f commits/s, %" PRIu64
+	                                  " flushes for %" PRIsize " commits"),
+	          num_threads, (double)(num_threads * commits) / time_ticks_to_seconds(elapsed), flushes,
+	          num_threads * commits);
+
+	fs_remove_directory(STRING_ARGS(path));
+	return 0;
+}
+
+DECLARE_TEST(wal, performance) {
+	char buffer[BUILD_MAX_PATHLEN];
+	string_t path = path_make_temporary(buffer, sizeof(buffer));
+	unsigned char data[128];
+	size_t num_records = 200000;
+	size_t irecord;
+	size_t count = 0;
+	wal_t* wal;
+	tick_t start, append_time, sync_time, recover_time;
+
+	memset(data, 0x5A, sizeof(data));
+	wal = wal_allocate(STRING_ARGS(path), 4 * 1024 * 1024);
+	EXPECT_NE(wal, nullptr);
+	start = time_current();
+	for (irecord = 0; irecord < num_records; ++irecord)
+		wal_append(wal, data, 64);
+	append_time = time_diff(start, time_current());
+	start = time_current();
+	EXPECT_TRUE(wal_sync(wal, num_records));
+	sync_time = time_diff(start, time_current());
+	wal_deallocate(wal);
+
+	start = time_current();
+	EXPECT_UINTEQ(wal_recover(STRING_ARGS(path), 0, wal_test_count, &count), num_records);
+	recover_time = time_diff(start, time_current());
+	EXPECT_SIZEEQ(count, num_records);
+
+	log_infof(HASH_TEST, STRING_CONST("Write-ahead log append: %.3f us/record, sync: %.3f ms, recover: %.3f us/record"),
+	          (time_ticks_to_seconds(append_time) * 1000000.0) / (double)num_records,
+	          time_ticks_to_seconds(sync_time) * 1000.0,
+	          (time_ticks_to_seconds(recover_time) * 1000000.0) / (double)num_records);
+
+	fs_remove_directory(STRING_ARGS(path));
+	return 0;
+}
+
+static void
+test_wal_declare(void) {
+	ADD_TEST(wal, basic);
+	ADD_TEST(wal, segment);
+	ADD_TEST(wal, recovery);
+	ADD_TEST(wal, groupcommit);
+	ADD_TEST(wal, performance);
+}
+
+static test_suite_t test_wal_suite = {
+	test_wal_application,
+	test_wal_memory_system,
+	test_wal_config,
+	test_wal_declare,
+	test_wal_initialize,
+	test_wal_finalize,
+	0
+};
+
+#if BUILD_MONOLITHIC
+
+int
+test_wal_run(void);
+
+int
+test_wal_run(void) {
+	test_suite = test_wal_suite;
+	return test_run_all();
+}
+
+#else
+
+test_suite_t
+test_suite_define(void);
+
+test_suite_t
+test_suite_define(void) {
+	return test_wal_suite;
+}
+
+#endif